@@ -62,6 +62,25 @@ typedef struct _CoglBezCubic
   floatVec2 p4;
 } CoglBezCubic;
 
+/* State used to incrementally work out whether the last sub path is
+   convex as the nodes are added. The contour is convex if every turn
+   is in the same direction and it is monotone in both x and y, ie,
+   the sign of the edge directions only changes twice in each axis as
+   you go around it. The second part rules out contours such as a
+   pentagram that turn consistently but wind around more than once */
+typedef struct _CoglPathConvexity
+{
+  floatVec2 first_edge;
+  floatVec2 last_edge;
+  floatVec2 last_point;
+  int turn_sign;
+  int last_dx_sign, last_dy_sign;
+  int n_x_changes, n_y_changes;
+  /* FALSE once the contour has made a turn in the wrong direction or
+     doubled back on itself */
+  CoglBool turns_consistent;
+} CoglPathConvexity;
+
 typedef struct _CoglPathData CoglPathData;
 
 struct _CoglPath
@@ -80,6 +99,11 @@ struct _CoglPathData
   CoglContext         *context;
 
   CoglPathFillRule     fill_rule;
+  CoglPathFillStrategy fill_strategy;
+
+  /* Maximum distance in path units between a curve and the line
+     segments it is flattened into */
+  float                tolerance;
 
   GArray              *path_nodes;
 
@@ -89,16 +113,42 @@ struct _CoglPathData
   floatVec2            path_nodes_min;
   floatVec2            path_nodes_max;
 
+  /* Convexity of the last sub path and whether all of the sub paths
+     before it are too small to cover any area. If both are true then
+     the fill can be built as a triangle fan without using the
+     tesselator */
+  CoglPathConvexity    convexity;
+  CoglBool             earlier_sub_paths_empty;
+
   CoglAttributeBuffer *fill_attribute_buffer;
   CoglIndices         *fill_vbo_indices;
   unsigned int         fill_vbo_n_indices;
   CoglAttribute       *fill_attributes[COGL_PATH_N_ATTRIBUTES + 1];
   CoglPrimitive       *fill_primitive;
 
+  /* Untesselated triangle fans of the sub paths for filling the path
+     with the stencil buffer. This is only built when
+     stencil_then_cover decides to use it */
+  CoglPrimitive       *stencil_primitive;
+  /* Set once the path has been filled using the stencil buffer with
+     the automatic strategy. If the same path is filled again it will
+     be tesselated instead */
+  CoglBool             filled_with_stencil;
+
   CoglAttributeBuffer *stroke_attribute_buffer;
   CoglAttribute      **stroke_attributes;
   unsigned int         stroke_n_attributes;
 
+  float                stroke_width;
+  CoglPathLineJoin     line_join;
+  CoglPathLineCap      line_cap;
+  /* Triangles for a stroke with a width. The anti-aliased edges are
+     built to be stroke_feather units wide which is meant to be one
+     pixel after transformation. The primitive is rebuilt if the
+     transformation changes the size of a pixel too much */
+  CoglPrimitive       *wide_stroke_primitive;
+  float                stroke_feather;
+
   /* This is used as an optimisation for when the path contains a
      single contour specified using cogl2_path_rectangle. Cogl is more
      optimised to handle rectangles than paths so we can detect this
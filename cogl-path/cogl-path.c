@@ -53,12 +53,25 @@
 #include <math.h>
 
 #define _COGL_MAX_BEZ_RECURSE_DEPTH 16
+/* The most line segments that a single curve will be split into */
+#define _COGL_PATH_MAX_CURVE_SEGMENTS 1024
+/* Number of flattened points that are added to the path at once */
+#define _COGL_PATH_FLATTEN_BATCH_SIZE 64
+/* Default maximum distance between a curve and its flattened line */
+#define _COGL_PATH_DEFAULT_TOLERANCE 0.25f
 
 static void _cogl_path_free (CoglPath *path);
 
 static void _cogl_path_build_fill_attribute_buffer (CoglPath *path);
 static CoglPrimitive *_cogl_path_get_fill_primitive (CoglPath *path);
+static CoglPrimitive *_cogl_path_get_stencil_primitive (CoglPath *path);
 static void _cogl_path_build_stroke_attribute_buffer (CoglPath *path);
+static void _cogl_path_stroke_wide (CoglPath *path,
+                                    CoglFramebuffer *framebuffer,
+                                    CoglPipeline *pipeline);
+static float _cogl_path_get_pixel_size_at (CoglFramebuffer *framebuffer,
+                                           float x,
+                                           float y);
 
 COGL_OBJECT_DEFINE (Path, path);
 
@@ -84,6 +97,14 @@ _cogl_path_data_clear_vbos (CoglPathData *data)
       data->fill_primitive = NULL;
     }
 
+  if (data->stencil_primitive)
+    {
+      cogl_object_unref (data->stencil_primitive);
+      data->stencil_primitive = NULL;
+    }
+
+  data->filled_with_stencil = FALSE;
+
   if (data->stroke_attribute_buffer)
     {
       cogl_object_unref (data->stroke_attribute_buffer);
@@ -95,6 +116,12 @@ _cogl_path_data_clear_vbos (CoglPathData *data)
 
       data->stroke_attribute_buffer = NULL;
     }
+
+  if (data->wide_stroke_primitive)
+    {
+      cogl_object_unref (data->wide_stroke_primitive);
+      data->wide_stroke_primitive = NULL;
+    }
 }
 
 static void
@@ -131,7 +158,10 @@ _cogl_path_modify (CoglPath *path)
 
       path->data->fill_attribute_buffer = NULL;
       path->data->fill_primitive = NULL;
+      path->data->stencil_primitive = NULL;
+      path->data->filled_with_stencil = FALSE;
       path->data->stroke_attribute_buffer = NULL;
+      path->data->wide_stroke_primitive = NULL;
       path->data->ref_count = 1;
 
       _cogl_path_data_unref (old_data);
@@ -163,37 +193,264 @@ cogl_path_get_fill_rule (CoglPath *path)
   return path->data->fill_rule;
 }
 
+void
+cogl_path_set_fill_strategy (CoglPath *path,
+                             CoglPathFillStrategy strategy)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+
+  if (path->data->fill_strategy != strategy)
+    {
+      _cogl_path_modify (path);
+
+      path->data->fill_strategy = strategy;
+    }
+}
+
+CoglPathFillStrategy
+cogl_path_get_fill_strategy (CoglPath *path)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_path (path),
+                            COGL_PATH_FILL_STRATEGY_AUTOMATIC);
+
+  return path->data->fill_strategy;
+}
+
+void
+cogl_path_set_stroke_width (CoglPath *path,
+                            float width)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+  _COGL_RETURN_IF_FAIL (width >= 0.0f);
+
+  if (path->data->stroke_width != width)
+    {
+      _cogl_path_modify (path);
+
+      path->data->stroke_width = width;
+    }
+}
+
+float
+cogl_path_get_stroke_width (CoglPath *path)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_path (path), 0.0f);
+
+  return path->data->stroke_width;
+}
+
+void
+cogl_path_set_line_join (CoglPath *path,
+                         CoglPathLineJoin line_join)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+
+  if (path->data->line_join != line_join)
+    {
+      _cogl_path_modify (path);
+
+      path->data->line_join = line_join;
+    }
+}
+
+CoglPathLineJoin
+cogl_path_get_line_join (CoglPath *path)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_path (path), COGL_PATH_LINE_JOIN_MITER);
+
+  return path->data->line_join;
+}
+
+void
+cogl_path_set_line_cap (CoglPath *path,
+                        CoglPathLineCap line_cap)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+
+  if (path->data->line_cap != line_cap)
+    {
+      _cogl_path_modify (path);
+
+      path->data->line_cap = line_cap;
+    }
+}
+
+CoglPathLineCap
+cogl_path_get_line_cap (CoglPath *path)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_path (path), COGL_PATH_LINE_CAP_BUTT);
+
+  return path->data->line_cap;
+}
+
+static int
+_cogl_path_sign (float value)
+{
+  return value > 0.0f ? 1 : value < 0.0f ? -1 : 0;
+}
+
 static void
-_cogl_path_add_node (CoglPath *path,
-                     CoglBool new_sub_path,
-		     float x,
-		     float y)
+_cogl_path_convexity_add_edge (CoglPathConvexity *convexity,
+                               float dx,
+                               float dy)
+{
+  int dx_sign = _cogl_path_sign (dx);
+  int dy_sign = _cogl_path_sign (dy);
+
+  /* Ignore zero length edges such as the one created by closing a
+     path that already ends at its start */
+  if (dx_sign == 0 && dy_sign == 0)
+    return;
+
+  if (convexity->last_dx_sign == 0 && convexity->last_dy_sign == 0)
+    {
+      convexity->first_edge.x = dx;
+      convexity->first_edge.y = dy;
+    }
+  else
+    {
+      float cross = (convexity->last_edge.x * dy -
+                     convexity->last_edge.y * dx);
+      int turn_sign = _cogl_path_sign (cross);
+
+      if (turn_sign == 0)
+        {
+          /* A collinear edge is fine unless it doubles back */
+          if (convexity->last_edge.x * dx + convexity->last_edge.y * dy < 0.0f)
+            convexity->turns_consistent = FALSE;
+        }
+      else if (convexity->turn_sign == 0)
+        convexity->turn_sign = turn_sign;
+      else if (convexity->turn_sign != turn_sign)
+        convexity->turns_consistent = FALSE;
+
+      if (dx_sign && convexity->last_dx_sign &&
+          dx_sign != convexity->last_dx_sign)
+        convexity->n_x_changes++;
+      if (dy_sign && convexity->last_dy_sign &&
+          dy_sign != convexity->last_dy_sign)
+        convexity->n_y_changes++;
+    }
+
+  if (dx_sign)
+    convexity->last_dx_sign = dx_sign;
+  if (dy_sign)
+    convexity->last_dy_sign = dy_sign;
+
+  convexity->last_edge.x = dx;
+  convexity->last_edge.y = dy;
+}
+
+static void
+_cogl_path_convexity_add_point (CoglPathConvexity *convexity,
+                                float x,
+                                float y)
+{
+  _cogl_path_convexity_add_edge (convexity,
+                                 x - convexity->last_point.x,
+                                 y - convexity->last_point.y);
+  convexity->last_point.x = x;
+  convexity->last_point.y = y;
+}
+
+static void
+_cogl_path_convexity_init (CoglPathConvexity *convexity,
+                           float x,
+                           float y)
+{
+  memset (convexity, 0, sizeof (CoglPathConvexity));
+  convexity->last_point.x = x;
+  convexity->last_point.y = y;
+  convexity->turns_consistent = TRUE;
+}
+
+static CoglBool
+_cogl_path_is_convex (CoglPath *path)
 {
-  CoglPathNode new_node;
+  CoglPathData *data = path->data;
+  CoglPathConvexity convexity;
+  CoglPathNode *start;
+
+  if (!data->earlier_sub_paths_empty || data->path_nodes->len == 0)
+    return FALSE;
+
+  start = &g_array_index (data->path_nodes, CoglPathNode, data->last_path);
+
+  if (start->path_size < 3)
+    return FALSE;
+
+  /* Close the contour on a copy of the state so that the path can
+     still be extended afterwards. Adding the first edge again takes
+     into account the turn at the first vertex */
+  convexity = data->convexity;
+  _cogl_path_convexity_add_point (&convexity, start->x, start->y);
+  _cogl_path_convexity_add_edge (&convexity,
+                                 convexity.first_edge.x,
+                                 convexity.first_edge.y);
+
+  return (convexity.turns_consistent &&
+          convexity.turn_sign != 0 &&
+          convexity.n_x_changes <= 2 &&
+          convexity.n_y_changes <= 2);
+}
+
+static void
+_cogl_path_add_nodes (CoglPath *path,
+                      CoglBool new_sub_path,
+                      const floatVec2 *points,
+                      int n_points)
+{
+  CoglPathNode *nodes;
   CoglPathData *data;
+  unsigned int old_len;
+  int i;
 
   _cogl_path_modify (path);
 
   data = path->data;
+  old_len = data->path_nodes->len;
 
-  new_node.x = x;
-  new_node.y = y;
-  new_node.path_size = 0;
-
-  if (new_sub_path || data->path_nodes->len == 0)
-    data->last_path = data->path_nodes->len;
+  if (new_sub_path || old_len == 0)
+    {
+      /* A sub path with less than three nodes can't cover any area so
+         it won't stop the next one being filled as a fan */
+      if (old_len == 0)
+        data->earlier_sub_paths_empty = TRUE;
+      else if (g_array_index (data->path_nodes,
+                              CoglPathNode,
+                              data->last_path).path_size >= 3)
+        data->earlier_sub_paths_empty = FALSE;
+
+      data->last_path = old_len;
+
+      _cogl_path_convexity_init (&data->convexity,
+                                 points[0].x, points[0].y);
+    }
+  else
+    _cogl_path_convexity_add_point (&data->convexity,
+                                    points[0].x, points[0].y);
 
-  g_array_append_val (data->path_nodes, new_node);
+  for (i = 1; i < n_points; i++)
+    _cogl_path_convexity_add_point (&data->convexity,
+                                    points[i].x, points[i].y);
 
-  g_array_index (data->path_nodes, CoglPathNode, data->last_path).path_size++;
+  g_array_set_size (data->path_nodes, old_len + n_points);
+  nodes = &g_array_index (data->path_nodes, CoglPathNode, old_len);
 
-  if (data->path_nodes->len == 1)
+  if (old_len == 0)
     {
-      data->path_nodes_min.x = data->path_nodes_max.x = x;
-      data->path_nodes_min.y = data->path_nodes_max.y = y;
+      data->path_nodes_min = points[0];
+      data->path_nodes_max = points[0];
     }
-  else
+
+  for (i = 0; i < n_points; i++)
     {
+      float x = points[i].x, y = points[i].y;
+
+      nodes[i].x = x;
+      nodes[i].y = y;
+      nodes[i].path_size = 0;
+
       if (x < data->path_nodes_min.x)
         data->path_nodes_min.x = x;
       if (x > data->path_nodes_max.x)
@@ -204,12 +461,29 @@ _cogl_path_add_node (CoglPath *path,
         data->path_nodes_max.y = y;
     }
 
+  g_array_index (data->path_nodes, CoglPathNode, data->last_path).path_size +=
+    n_points;
+
   /* Once the path nodes have been modified then we'll assume it's no
      longer a rectangle. cogl_path_rectangle will set this back to
      TRUE if this has been called from there */
   data->is_rectangle = FALSE;
 }
 
+static void
+_cogl_path_add_node (CoglPath *path,
+                     CoglBool new_sub_path,
+		     float x,
+		     float y)
+{
+  floatVec2 point;
+
+  point.x = x;
+  point.y = y;
+
+  _cogl_path_add_nodes (path, new_sub_path, &point, 1);
+}
+
 void
 cogl_path_stroke (CoglPath *path,
                   CoglFramebuffer *framebuffer,
@@ -230,6 +504,12 @@ cogl_path_stroke (CoglPath *path,
   if (data->path_nodes->len == 0)
     return;
 
+  if (data->stroke_width > 0.0f)
+    {
+      _cogl_path_stroke_wide (path, framebuffer, pipeline);
+      return;
+    }
+
   if (cogl_pipeline_get_n_layers (pipeline) != 0)
     {
       copy = cogl_pipeline_copy (pipeline);
@@ -336,6 +616,81 @@ validate_layer_cb (CoglPipelineLayer *layer, void *user_data)
   return !*needs_fallback;
 }
 
+/* With the automatic strategy, paths with fewer nodes than this are
+   always tesselated because the tesselator is cheap for them and
+   filling with the stencil buffer breaks up the journal */
+#define COGL_PATH_STENCIL_MIN_NODES 64
+
+/* Filling with the stencil buffer pushes a primitive clip which needs
+   enough stencil bits to be combined with any clip that is already
+   set on the framebuffer */
+#define COGL_PATH_STENCIL_MIN_BITS 2
+
+static CoglBool
+_cogl_path_should_fill_with_stencil (CoglPath *path,
+                                     CoglFramebuffer *framebuffer)
+{
+  CoglPathData *data = path->data;
+
+  /* Inverting the stencil can only implement the even-odd rule */
+  if (data->fill_rule != COGL_PATH_FILL_RULE_EVEN_ODD)
+    return FALSE;
+
+  /* Even if the stencil strategy was explicitly requested it can't
+     work without a stencil buffer */
+  if (_cogl_framebuffer_get_stencil_bits (framebuffer) <
+      COGL_PATH_STENCIL_MIN_BITS)
+    return FALSE;
+
+  switch (data->fill_strategy)
+    {
+    case COGL_PATH_FILL_STRATEGY_TESSELATE:
+      return FALSE;
+
+    case COGL_PATH_FILL_STRATEGY_STENCIL:
+      return TRUE;
+
+    case COGL_PATH_FILL_STRATEGY_AUTOMATIC:
+      break;
+    }
+
+  /* If the path has already been tesselated, or it is being filled a
+     second time without changing, then the tesselation is worth
+     caching */
+  if (data->fill_primitive || data->filled_with_stencil)
+    return FALSE;
+
+  return (data->path_nodes->len >= COGL_PATH_STENCIL_MIN_NODES &&
+          !_cogl_path_is_convex (path));
+}
+
+static void
+_cogl_path_fill_nodes_with_stencil (CoglPath *path,
+                                    CoglFramebuffer *framebuffer,
+                                    CoglPipeline *pipeline)
+{
+  CoglPathData *data = path->data;
+
+  /* This works the same way as filling with sliced textures except
+     that the clip is the untesselated fans of the sub paths so the
+     tesselator is never used */
+  cogl_framebuffer_push_primitive_clip (framebuffer,
+                                        _cogl_path_get_stencil_primitive (path),
+                                        data->path_nodes_min.x,
+                                        data->path_nodes_min.y,
+                                        data->path_nodes_max.x,
+                                        data->path_nodes_max.y);
+  cogl_framebuffer_draw_rectangle (framebuffer,
+                                   pipeline,
+                                   data->path_nodes_min.x,
+                                   data->path_nodes_min.y,
+                                   data->path_nodes_max.x,
+                                   data->path_nodes_max.y);
+  cogl_framebuffer_pop_clip (framebuffer);
+
+  data->filled_with_stencil = TRUE;
+}
+
 void
 _cogl_path_fill_nodes (CoglPath *path,
                        CoglFramebuffer *framebuffer,
@@ -375,6 +730,15 @@ _cogl_path_fill_nodes (CoglPath *path,
           return;
         }
 
+      /* The stencil strategy uses the clip stack so it can't be used
+         when being called to draw the silhouette of a clip */
+      if (flags == 0 &&
+          _cogl_path_should_fill_with_stencil (path, framebuffer))
+        {
+          _cogl_path_fill_nodes_with_stencil (path, framebuffer, pipeline);
+          return;
+        }
+
       primitive = _cogl_path_get_fill_primitive (path);
 
       _cogl_primitive_draw (primitive,
@@ -736,96 +1100,71 @@ static void
 _cogl_path_bezier3_sub (CoglPath *path,
                         CoglBezCubic *cubic)
 {
-  CoglBezCubic cubics[_COGL_MAX_BEZ_RECURSE_DEPTH];
-  CoglBezCubic *cleft;
-  CoglBezCubic *cright;
-  CoglBezCubic *c;
-  floatVec2 dif1;
-  floatVec2 dif2;
-  floatVec2 mm;
-  floatVec2 c1;
-  floatVec2 c2;
-  floatVec2 c3;
-  floatVec2 c4;
-  floatVec2 c5;
-  int cindex;
-
-  /* Put first curve on stack */
-  cubics[0] = *cubic;
-  cindex =  0;
-
-  while (cindex >= 0)
+  floatVec2 points[_COGL_PATH_FLATTEN_BATCH_SIZE];
+  double ax, ay, bx, by, cx, cy;
+  double fx, fy, dfx, dfy, ddfx, ddfy, dddfx, dddfy;
+  float dd1, dd2, max_dd;
+  double h;
+  int n_segments, n_points = 0, i;
+
+  /* The distance between the curve and a line through n evenly spaced
+     points on it is at most 1/8 of the maximum second derivative
+     divided by n². The second derivative is bounded by 6 times the
+     largest second difference of the control points so the number of
+     segments can be picked up front to meet the tolerance */
+  dd1 = (fabsf (cubic->p1.x - 2 * cubic->p2.x + cubic->p3.x) +
+         fabsf (cubic->p1.y - 2 * cubic->p2.y + cubic->p3.y));
+  dd2 = (fabsf (cubic->p2.x - 2 * cubic->p3.x + cubic->p4.x) +
+         fabsf (cubic->p2.y - 2 * cubic->p3.y + cubic->p4.y));
+  max_dd = MAX (dd1, dd2);
+
+  n_segments = ceilf (sqrtf (0.75f * max_dd / path->data->tolerance));
+  n_segments = CLAMP (n_segments, 1, _COGL_PATH_MAX_CURVE_SEGMENTS);
+
+  /* Expand the curve into the polynomial a·t³ + b·t² + c·t + p1 */
+  ax = -cubic->p1.x + 3.0 * (cubic->p2.x - cubic->p3.x) + cubic->p4.x;
+  ay = -cubic->p1.y + 3.0 * (cubic->p2.y - cubic->p3.y) + cubic->p4.y;
+  bx = 3.0 * (cubic->p1.x - 2.0 * cubic->p2.x + cubic->p3.x);
+  by = 3.0 * (cubic->p1.y - 2.0 * cubic->p2.y + cubic->p3.y);
+  cx = 3.0 * (cubic->p2.x - cubic->p1.x);
+  cy = 3.0 * (cubic->p2.y - cubic->p1.y);
+
+  /* Evaluate it with forward differences so that each point only
+     needs three additions per coordinate */
+  h = 1.0 / n_segments;
+  fx = cubic->p1.x;
+  fy = cubic->p1.y;
+  dfx = ax * h * h * h + bx * h * h + cx * h;
+  dfy = ay * h * h * h + by * h * h + cy * h;
+  ddfx = 6.0 * ax * h * h * h + 2.0 * bx * h * h;
+  ddfy = 6.0 * ay * h * h * h + 2.0 * by * h * h;
+  dddfx = 6.0 * ax * h * h * h;
+  dddfy = 6.0 * ay * h * h * h;
+
+  /* The points are added in batches to avoid the overhead of
+     appending each node separately. The last point is left for the
+     caller to add exactly */
+  for (i = 1; i < n_segments; i++)
     {
-      c = &cubics[cindex];
-
-
-      /* Calculate distance of control points from their
-       * counterparts on the line between end points */
-      dif1.x = (c->p2.x * 3) - (c->p1.x * 2) - c->p4.x;
-      dif1.y = (c->p2.y * 3) - (c->p1.y * 2) - c->p4.y;
-      dif2.x = (c->p3.x * 3) - (c->p4.x * 2) - c->p1.x;
-      dif2.y = (c->p3.y * 3) - (c->p4.y * 2) - c->p1.y;
-
-      if (dif1.x < 0)
-        dif1.x = -dif1.x;
-      if (dif1.y < 0)
-        dif1.y = -dif1.y;
-      if (dif2.x < 0)
-        dif2.x = -dif2.x;
-      if (dif2.y < 0)
-        dif2.y = -dif2.y;
-
-
-      /* Pick the greatest of two distances */
-      if (dif1.x < dif2.x) dif1.x = dif2.x;
-      if (dif1.y < dif2.y) dif1.y = dif2.y;
+      fx += dfx;
+      fy += dfy;
+      dfx += ddfx;
+      dfy += ddfy;
+      ddfx += dddfx;
+      ddfy += dddfy;
 
-      /* Cancel if the curve is flat enough */
-      if (dif1.x + dif1.y <= 1.0 ||
-	  cindex == _COGL_MAX_BEZ_RECURSE_DEPTH-1)
-	{
-	  /* Add subdivision point (skip last) */
-	  if (cindex == 0)
-            return;
-
-	  _cogl_path_add_node (path, FALSE, c->p4.x, c->p4.y);
-
-	  --cindex;
-
-          continue;
-	}
+      points[n_points].x = fx;
+      points[n_points].y = fy;
 
-      /* Left recursion goes on top of stack! */
-      cright = c; cleft = &cubics[++cindex];
-
-      /* Subdivide into 2 sub-curves */
-      c1.x = ((c->p1.x + c->p2.x) / 2);
-      c1.y = ((c->p1.y + c->p2.y) / 2);
-      mm.x = ((c->p2.x + c->p3.x) / 2);
-      mm.y = ((c->p2.y + c->p3.y) / 2);
-      c5.x = ((c->p3.x + c->p4.x) / 2);
-      c5.y = ((c->p3.y + c->p4.y) / 2);
-
-      c2.x = ((c1.x + mm.x) / 2);
-      c2.y = ((c1.y + mm.y) / 2);
-      c4.x = ((mm.x + c5.x) / 2);
-      c4.y = ((mm.y + c5.y) / 2);
-
-      c3.x = ((c2.x + c4.x) / 2);
-      c3.y = ((c2.y + c4.y) / 2);
-
-      /* Add left recursion to stack */
-      cleft->p1 = c->p1;
-      cleft->p2 = c1;
-      cleft->p3 = c2;
-      cleft->p4 = c3;
-
-      /* Add right recursion to stack */
-      cright->p1 = c3;
-      cright->p2 = c4;
-      cright->p3 = c5;
-      cright->p4 = c->p4;
+      if (++n_points == _COGL_PATH_FLATTEN_BATCH_SIZE)
+        {
+          _cogl_path_add_nodes (path, FALSE, points, n_points);
+          n_points = 0;
+        }
     }
+
+  if (n_points > 0)
+    _cogl_path_add_nodes (path, FALSE, points, n_points);
 }
 
 void
@@ -850,7 +1189,7 @@ cogl_path_curve_to (CoglPath *path,
   cubic.p4.x = x_3;
   cubic.p4.y = y_3;
 
-  /* Run subdivision */
+  /* Flatten the curve into line segments */
   _cogl_path_bezier3_sub (path, &cubic);
 
   /* Add last point */
@@ -882,6 +1221,46 @@ cogl_path_rel_curve_to (CoglPath *path,
                       data->path_pen.y + y_3);
 }
 
+void
+cogl_path_set_tolerance (CoglPath *path,
+                         float tolerance)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+  _COGL_RETURN_IF_FAIL (tolerance > 0.0f);
+
+  if (path->data->tolerance != tolerance)
+    {
+      _cogl_path_modify (path);
+
+      path->data->tolerance = tolerance;
+    }
+}
+
+float
+cogl_path_get_tolerance (CoglPath *path)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_path (path),
+                            _COGL_PATH_DEFAULT_TOLERANCE);
+
+  return path->data->tolerance;
+}
+
+void
+cogl_path_set_tolerance_for_framebuffer (CoglPath *path,
+                                         CoglFramebuffer *framebuffer)
+{
+  float pixel_size;
+
+  _COGL_RETURN_IF_FAIL (cogl_is_path (path));
+
+  /* The size of a pixel is measured at the origin of the path because
+     the nodes of the curves aren't known yet */
+  pixel_size = _cogl_path_get_pixel_size_at (framebuffer, 0.0f, 0.0f);
+
+  cogl_path_set_tolerance (path,
+                           _COGL_PATH_DEFAULT_TOLERANCE * pixel_size);
+}
+
 CoglPath *
 cogl_path_new (CoglContext *context)
 {
@@ -894,11 +1273,20 @@ cogl_path_new (CoglContext *context)
   data->ref_count = 1;
   data->context = context;
   data->fill_rule = COGL_PATH_FILL_RULE_EVEN_ODD;
+  data->fill_strategy = COGL_PATH_FILL_STRATEGY_AUTOMATIC;
+  data->tolerance = _COGL_PATH_DEFAULT_TOLERANCE;
   data->path_nodes = g_array_new (FALSE, FALSE, sizeof (CoglPathNode));
   data->last_path = 0;
+  data->earlier_sub_paths_empty = TRUE;
   data->fill_attribute_buffer = NULL;
   data->stroke_attribute_buffer = NULL;
   data->fill_primitive = NULL;
+  data->stencil_primitive = NULL;
+  data->filled_with_stencil = FALSE;
+  data->stroke_width = 0.0f;
+  data->line_join = COGL_PATH_LINE_JOIN_MITER;
+  data->line_cap = COGL_PATH_LINE_CAP_BUTT;
+  data->wide_stroke_primitive = NULL;
   data->is_rectangle = FALSE;
 
   return _cogl_path_object_new (path);
@@ -1276,11 +1664,89 @@ _cogl_path_tesselator_combine (double coords[3],
     }
 }
 
+static void
+_cogl_path_build_convex_fill_indices (CoglPathData *data,
+                                      CoglPathTesselator *tess)
+{
+  CoglPathNode *node =
+    &g_array_index (data->path_nodes, CoglPathNode, data->last_path);
+  int i;
+
+  /* The last sub path is convex and nothing before it covers any
+     area so the fill is just a fan around its first vertex. This
+     gives the same result for either fill rule */
+  for (i = 2; i < node->path_size; i++)
+    {
+      _cogl_path_tesselator_add_index (tess, data->last_path);
+      _cogl_path_tesselator_add_index (tess, data->last_path + i - 1);
+      _cogl_path_tesselator_add_index (tess, data->last_path + i);
+    }
+}
+
+static void
+_cogl_path_tesselate_nodes (CoglPathData *data,
+                            CoglPathTesselator *tess)
+{
+  unsigned int path_start = 0;
+  int i;
+
+  /* All of the tesselator's internal allocations are released
+     together once the fill has been built */
+  _cogl_tess_arena_begin ();
+
+  tess->glu_tess = gluNewTess ();
+
+  if (data->fill_rule == COGL_PATH_FILL_RULE_EVEN_ODD)
+    gluTessProperty (tess->glu_tess, GLU_TESS_WINDING_RULE,
+                     GLU_TESS_WINDING_ODD);
+  else
+    gluTessProperty (tess->glu_tess, GLU_TESS_WINDING_RULE,
+                     GLU_TESS_WINDING_NONZERO);
+
+  /* All vertices are on the xy-plane */
+  gluTessNormal (tess->glu_tess, 0.0, 0.0, 1.0);
+
+  gluTessCallback (tess->glu_tess, GLU_TESS_BEGIN_DATA,
+                   _cogl_path_tesselator_begin);
+  gluTessCallback (tess->glu_tess, GLU_TESS_VERTEX_DATA,
+                   _cogl_path_tesselator_vertex);
+  gluTessCallback (tess->glu_tess, GLU_TESS_END_DATA,
+                   _cogl_path_tesselator_end);
+  gluTessCallback (tess->glu_tess, GLU_TESS_COMBINE_DATA,
+                   _cogl_path_tesselator_combine);
+
+  gluTessBeginPolygon (tess->glu_tess, tess);
+
+  while (path_start < data->path_nodes->len)
+    {
+      CoglPathNode *node =
+        &g_array_index (data->path_nodes, CoglPathNode, path_start);
+
+      gluTessBeginContour (tess->glu_tess);
+
+      for (i = 0; i < node->path_size; i++)
+        {
+          double vertex[3] = { node[i].x, node[i].y, 0.0 };
+          gluTessVertex (tess->glu_tess, vertex,
+                         GINT_TO_POINTER (i + path_start));
+        }
+
+      gluTessEndContour (tess->glu_tess);
+
+      path_start += node->path_size;
+    }
+
+  gluTessEndPolygon (tess->glu_tess);
+
+  gluDeleteTess (tess->glu_tess);
+
+  _cogl_tess_arena_end ();
+}
+
 static void
 _cogl_path_build_fill_attribute_buffer (CoglPath *path)
 {
   CoglPathTesselator tess;
-  unsigned int path_start = 0;
   CoglPathData *data = path->data;
   int i;
 
@@ -1322,51 +1788,10 @@ _cogl_path_build_fill_attribute_buffer (CoglPath *path)
     _cogl_path_tesselator_get_indices_type_for_size (data->path_nodes->len);
   _cogl_path_tesselator_allocate_indices_array (&tess);
 
-  tess.glu_tess = gluNewTess ();
-
-  if (data->fill_rule == COGL_PATH_FILL_RULE_EVEN_ODD)
-    gluTessProperty (tess.glu_tess, GLU_TESS_WINDING_RULE,
-                     GLU_TESS_WINDING_ODD);
+  if (_cogl_path_is_convex (path))
+    _cogl_path_build_convex_fill_indices (data, &tess);
   else
-    gluTessProperty (tess.glu_tess, GLU_TESS_WINDING_RULE,
-                     GLU_TESS_WINDING_NONZERO);
-
-  /* All vertices are on the xy-plane */
-  gluTessNormal (tess.glu_tess, 0.0, 0.0, 1.0);
-
-  gluTessCallback (tess.glu_tess, GLU_TESS_BEGIN_DATA,
-                   _cogl_path_tesselator_begin);
-  gluTessCallback (tess.glu_tess, GLU_TESS_VERTEX_DATA,
-                   _cogl_path_tesselator_vertex);
-  gluTessCallback (tess.glu_tess, GLU_TESS_END_DATA,
-                   _cogl_path_tesselator_end);
-  gluTessCallback (tess.glu_tess, GLU_TESS_COMBINE_DATA,
-                   _cogl_path_tesselator_combine);
-
-  gluTessBeginPolygon (tess.glu_tess, &tess);
-
-  while (path_start < data->path_nodes->len)
-    {
-      CoglPathNode *node =
-        &g_array_index (data->path_nodes, CoglPathNode, path_start);
-
-      gluTessBeginContour (tess.glu_tess);
-
-      for (i = 0; i < node->path_size; i++)
-        {
-          double vertex[3] = { node[i].x, node[i].y, 0.0 };
-          gluTessVertex (tess.glu_tess, vertex,
-                         GINT_TO_POINTER (i + path_start));
-        }
-
-      gluTessEndContour (tess.glu_tess);
-
-      path_start += node->path_size;
-    }
-
-  gluTessEndPolygon (tess.glu_tess);
-
-  gluDeleteTess (tess.glu_tess);
+    _cogl_path_tesselate_nodes (data, &tess);
 
   data->fill_attribute_buffer =
     cogl_attribute_buffer_new (data->context,
@@ -1418,6 +1843,79 @@ _cogl_path_get_fill_primitive (CoglPath *path)
   return path->data->fill_primitive;
 }
 
+static CoglPrimitive *
+_cogl_path_get_stencil_primitive (CoglPath *path)
+{
+  CoglPathData *data = path->data;
+  CoglPathTesselator tess;
+  CoglAttributeBuffer *attribute_buffer;
+  CoglAttribute *attribute;
+  CoglIndices *indices;
+  unsigned int path_start;
+  CoglPathNode *node;
+  int i;
+
+  if (data->stencil_primitive)
+    return data->stencil_primitive;
+
+  /* The nodes can be used directly as the vertices because the
+     position is at the start of each node */
+  attribute_buffer =
+    cogl_attribute_buffer_new (data->context,
+                               sizeof (CoglPathNode) * data->path_nodes->len,
+                               data->path_nodes->data);
+  attribute = cogl_attribute_new (attribute_buffer,
+                                  "cogl_position_in",
+                                  sizeof (CoglPathNode),
+                                  G_STRUCT_OFFSET (CoglPathNode, x),
+                                  2, /* n_components */
+                                  COGL_ATTRIBUTE_TYPE_FLOAT);
+
+  /* Each sub path is drawn as a fan around its first node without
+     caring whether the triangles overlap. When they are drawn with
+     the stencil inverted each time a pixel is touched, the pixels
+     that are left set are exactly the ones inside the path according
+     to the even-odd rule */
+  tess.indices_type =
+    _cogl_path_tesselator_get_indices_type_for_size (data->path_nodes->len);
+  _cogl_path_tesselator_allocate_indices_array (&tess);
+
+  for (path_start = 0;
+       path_start < data->path_nodes->len;
+       path_start += node->path_size)
+    {
+      node = &g_array_index (data->path_nodes, CoglPathNode, path_start);
+
+      for (i = 2; i < node->path_size; i++)
+        {
+          _cogl_path_tesselator_add_index (&tess, path_start);
+          _cogl_path_tesselator_add_index (&tess, path_start + i - 1);
+          _cogl_path_tesselator_add_index (&tess, path_start + i);
+        }
+    }
+
+  indices = cogl_indices_new (data->context,
+                              tess.indices_type,
+                              tess.indices->data,
+                              tess.indices->len);
+
+  data->stencil_primitive =
+    cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
+                                        tess.indices->len,
+                                        &attribute,
+                                        1);
+  cogl_primitive_set_indices (data->stencil_primitive,
+                              indices,
+                              tess.indices->len);
+
+  g_array_free (tess.indices, TRUE);
+  cogl_object_unref (indices);
+  cogl_object_unref (attribute);
+  cogl_object_unref (attribute_buffer);
+
+  return data->stencil_primitive;
+}
+
 static CoglClipStack *
 _cogl_clip_stack_push_from_path (CoglClipStack *stack,
                                  CoglPath *path,
@@ -1544,3 +2042,664 @@ _cogl_path_build_stroke_attribute_buffer (CoglPath *path)
 
   data->stroke_n_attributes = n_attributes;
 }
+
+/* Miter joins are converted to bevel joins when the length of the
+   miter would be more than this times the stroke width */
+#define COGL_PATH_MITER_LIMIT 4.0f
+/* The maximum distance in pixels between the edge of a round join or
+   cap and the true arc */
+#define COGL_PATH_ROUND_TOLERANCE 0.25f
+#define COGL_PATH_MAX_ARC_STEPS 64
+
+typedef struct _CoglPathStrokeVertex
+{
+  float x, y;
+  /* This is used as the primary color so that the pipeline color can
+     be modulated by how much of the pixel the stroke covers */
+  uint8_t coverage[4];
+} CoglPathStrokeVertex;
+
+typedef struct _CoglPathStroker
+{
+  /* Array of CoglPathStrokeVertex */
+  GArray *vertices;
+  /* Array of uint32_t */
+  GArray *indices;
+  /* Temporary array of floatVec2 for the positions of a sub path
+     with the zero length segments removed */
+  GArray *points;
+
+  float half_width;
+  /* Distances from the middle of the line to the end of the solid
+     part and to the outside of the anti-aliased edge */
+  float inner, outer;
+  /* The width of the anti-aliased edge. This is one pixel */
+  float feather;
+  /* Coverage of the solid part. This is less than 255 when the line
+     is thinner than a pixel */
+  uint8_t coverage;
+  float round_tolerance;
+} CoglPathStroker;
+
+static uint32_t
+_cogl_path_stroker_add_vertex (CoglPathStroker *stroker,
+                               float x,
+                               float y,
+                               uint8_t coverage)
+{
+  CoglPathStrokeVertex *vertex;
+
+  g_array_set_size (stroker->vertices, stroker->vertices->len + 1);
+  vertex = &g_array_index (stroker->vertices,
+                           CoglPathStrokeVertex,
+                           stroker->vertices->len - 1);
+  vertex->x = x;
+  vertex->y = y;
+  memset (vertex->coverage, coverage, sizeof (vertex->coverage));
+
+  return stroker->vertices->len - 1;
+}
+
+static void
+_cogl_path_stroker_add_quad (CoglPathStroker *stroker,
+                             uint32_t a,
+                             uint32_t b,
+                             uint32_t c,
+                             uint32_t d)
+{
+  uint32_t indices[6] = { a, b, c, a, c, d };
+
+  g_array_append_vals (stroker->indices, indices, G_N_ELEMENTS (indices));
+}
+
+/* Adds four vertices across the line at (x, y). They go from the
+   outside of the anti-aliased edge on one side through the solid part
+   to the outside of the edge on the other side. If @solid is FALSE
+   then all of the vertices have zero coverage so that the line can
+   fade out towards the section */
+static void
+_cogl_path_stroker_add_section (CoglPathStroker *stroker,
+                                float x,
+                                float y,
+                                const floatVec2 *normal,
+                                CoglBool solid,
+                                uint32_t *section)
+{
+  uint8_t coverage = solid ? stroker->coverage : 0;
+
+  section[0] = _cogl_path_stroker_add_vertex (stroker,
+                                              x - normal->x * stroker->outer,
+                                              y - normal->y * stroker->outer,
+                                              0);
+  section[1] = _cogl_path_stroker_add_vertex (stroker,
+                                              x - normal->x * stroker->inner,
+                                              y - normal->y * stroker->inner,
+                                              coverage);
+  section[2] = _cogl_path_stroker_add_vertex (stroker,
+                                              x + normal->x * stroker->inner,
+                                              y + normal->y * stroker->inner,
+                                              coverage);
+  section[3] = _cogl_path_stroker_add_vertex (stroker,
+                                              x + normal->x * stroker->outer,
+                                              y + normal->y * stroker->outer,
+                                              0);
+}
+
+static void
+_cogl_path_stroker_connect_sections (CoglPathStroker *stroker,
+                                     const uint32_t *section_a,
+                                     const uint32_t *section_b)
+{
+  int i;
+
+  for (i = 0; i < 3; i++)
+    _cogl_path_stroker_add_quad (stroker,
+                                 section_a[i], section_a[i + 1],
+                                 section_b[i + 1], section_b[i]);
+}
+
+/* Fills the area around (x, y) swept between a list of directions.
+   The solid part is a fan around the center and the anti-aliased
+   edge is a band around the outside of it. Each direction is
+   multiplied by its scale so that a miter join can reach its point */
+static void
+_cogl_path_stroker_add_wedge (CoglPathStroker *stroker,
+                              float x,
+                              float y,
+                              const floatVec2 *spokes,
+                              const float *scales,
+                              int n_spokes)
+{
+  uint32_t center, inner, outer;
+  uint32_t last_inner = 0, last_outer = 0;
+  int i;
+
+  center = _cogl_path_stroker_add_vertex (stroker, x, y, stroker->coverage);
+
+  for (i = 0; i < n_spokes; i++)
+    {
+      float inner_distance = stroker->inner * scales[i];
+      float outer_distance = stroker->outer * scales[i];
+
+      inner = _cogl_path_stroker_add_vertex (stroker,
+                                             x + spokes[i].x * inner_distance,
+                                             y + spokes[i].y * inner_distance,
+                                             stroker->coverage);
+      outer = _cogl_path_stroker_add_vertex (stroker,
+                                             x + spokes[i].x * outer_distance,
+                                             y + spokes[i].y * outer_distance,
+                                             0);
+
+      if (i > 0)
+        {
+          uint32_t triangle[3] = { center, last_inner, inner };
+
+          g_array_append_vals (stroker->indices, triangle, 3);
+          _cogl_path_stroker_add_quad (stroker,
+                                       last_inner, last_outer,
+                                       outer, inner);
+        }
+
+      last_inner = inner;
+      last_outer = outer;
+    }
+}
+
+/* Adds a wedge for a circular arc starting at the direction @from
+   and rotating by @angle radians */
+static void
+_cogl_path_stroker_add_arc (CoglPathStroker *stroker,
+                            float x,
+                            float y,
+                            const floatVec2 *from,
+                            float angle)
+{
+  floatVec2 spokes[COGL_PATH_MAX_ARC_STEPS + 1];
+  float scales[COGL_PATH_MAX_ARC_STEPS + 1];
+  float max_step;
+  int n_steps, i;
+
+  /* Pick a step so that the chord between each spoke isn't too far
+     from the arc */
+  if (stroker->outer > stroker->round_tolerance)
+    max_step = 2.0f * acosf (1.0f - stroker->round_tolerance / stroker->outer);
+  else
+    max_step = G_PI;
+
+  n_steps = ceilf (fabsf (angle) / max_step);
+  n_steps = CLAMP (n_steps, 1, COGL_PATH_MAX_ARC_STEPS);
+
+  for (i = 0; i <= n_steps; i++)
+    {
+      float a = angle * i / n_steps;
+      float c = cosf (a), s = sinf (a);
+
+      spokes[i].x = from->x * c - from->y * s;
+      spokes[i].y = from->x * s + from->y * c;
+      scales[i] = 1.0f;
+    }
+
+  _cogl_path_stroker_add_wedge (stroker, x, y, spokes, scales, n_steps + 1);
+}
+
+static void
+_cogl_path_stroker_add_join (CoglPathStroker *stroker,
+                             const floatVec2 *point,
+                             const floatVec2 *dir_a,
+                             const floatVec2 *dir_b,
+                             CoglPathLineJoin line_join)
+{
+  float cross = dir_a->x * dir_b->y - dir_a->y * dir_b->x;
+  float dot = dir_a->x * dir_b->x + dir_a->y * dir_b->y;
+  floatVec2 spokes[3];
+  float scales[3] = { 1.0f, 1.0f, 1.0f };
+  float side;
+
+  /* Segments carrying on in the same direction already meet */
+  if (fabsf (cross) < 1e-6f && dot > 0.0f)
+    return;
+
+  /* The segments overlap on the inside of the turn so only the gap
+     on the outside needs to be filled */
+  side = cross > 0.0f ? -1.0f : 1.0f;
+  spokes[0].x = -dir_a->y * side;
+  spokes[0].y = dir_a->x * side;
+  spokes[2].x = -dir_b->y * side;
+  spokes[2].y = dir_b->x * side;
+
+  switch (line_join)
+    {
+    case COGL_PATH_LINE_JOIN_ROUND:
+      _cogl_path_stroker_add_arc (stroker,
+                                  point->x, point->y,
+                                  spokes,
+                                  atan2f (cross, dot));
+      return;
+
+    case COGL_PATH_LINE_JOIN_MITER:
+      {
+        float length;
+
+        spokes[1].x = spokes[0].x + spokes[2].x;
+        spokes[1].y = spokes[0].y + spokes[2].y;
+        length = sqrtf (spokes[1].x * spokes[1].x +
+                        spokes[1].y * spokes[1].y);
+
+        /* Half of the length of the bisector is the cosine of half of
+           the angle between the spokes. The miter point is the
+           inverse of that along the bisector */
+        if (length * 0.5f * COGL_PATH_MITER_LIMIT > 1.0f)
+          {
+            spokes[1].x /= length;
+            spokes[1].y /= length;
+            scales[1] = 2.0f / length;
+
+            _cogl_path_stroker_add_wedge (stroker,
+                                          point->x, point->y,
+                                          spokes, scales, 3);
+            return;
+          }
+      }
+      /* flow through */
+
+    case COGL_PATH_LINE_JOIN_BEVEL:
+      spokes[1] = spokes[2];
+      _cogl_path_stroker_add_wedge (stroker,
+                                    point->x, point->y,
+                                    spokes, scales, 2);
+      return;
+    }
+}
+
+/* Adds a cap to the end of a line at @point. @dir points away from
+   the line and @section is the last section of the line which was
+   built using @section_normal */
+static void
+_cogl_path_stroker_add_cap (CoglPathStroker *stroker,
+                            const floatVec2 *point,
+                            const floatVec2 *dir,
+                            const uint32_t *section,
+                            const floatVec2 *section_normal,
+                            CoglPathLineCap line_cap)
+{
+  floatVec2 normal;
+  uint32_t extension[4], fade[4];
+  float length, fade_distance;
+
+  normal.x = -dir->y;
+  normal.y = dir->x;
+
+  if (line_cap == COGL_PATH_LINE_CAP_ROUND)
+    {
+      /* Sweep from one side of the line around the end to the other */
+      _cogl_path_stroker_add_arc (stroker,
+                                  point->x, point->y,
+                                  &normal,
+                                  -G_PI);
+      return;
+    }
+
+  length = line_cap == COGL_PATH_LINE_CAP_SQUARE ? stroker->half_width : 0.0f;
+
+  if (length > stroker->feather * 0.5f)
+    {
+      fade_distance = length - stroker->feather * 0.5f;
+      _cogl_path_stroker_add_section (stroker,
+                                      point->x + dir->x * fade_distance,
+                                      point->y + dir->y * fade_distance,
+                                      section_normal,
+                                      TRUE, /* solid */
+                                      extension);
+      _cogl_path_stroker_connect_sections (stroker, section, extension);
+      section = extension;
+    }
+
+  fade_distance = length + stroker->feather * 0.5f;
+  _cogl_path_stroker_add_section (stroker,
+                                  point->x + dir->x * fade_distance,
+                                  point->y + dir->y * fade_distance,
+                                  section_normal,
+                                  FALSE, /* solid */
+                                  fade);
+  _cogl_path_stroker_connect_sections (stroker, section, fade);
+}
+
+static void
+_cogl_path_stroker_get_direction (const floatVec2 *from,
+                                  const floatVec2 *to,
+                                  floatVec2 *dir,
+                                  floatVec2 *normal)
+{
+  float dx = to->x - from->x;
+  float dy = to->y - from->y;
+  float length = sqrtf (dx * dx + dy * dy);
+
+  dir->x = dx / length;
+  dir->y = dy / length;
+  normal->x = -dir->y;
+  normal->y = dir->x;
+}
+
+static void
+_cogl_path_stroker_add_sub_path (CoglPathStroker *stroker,
+                                 const CoglPathNode *nodes,
+                                 CoglPathLineJoin line_join,
+                                 CoglPathLineCap line_cap)
+{
+  floatVec2 *points;
+  floatVec2 first_dir, first_normal, dir, normal, last_dir;
+  uint32_t first_section[4], start_section[4], end_section[4];
+  CoglBool closed;
+  int n_points, n_segments, i;
+
+  /* Remove zero length segments because they have no direction */
+  g_array_set_size (stroker->points, 0);
+  for (i = 0; i < nodes->path_size; i++)
+    {
+      floatVec2 point;
+
+      point.x = nodes[i].x;
+      point.y = nodes[i].y;
+
+      if (stroker->points->len > 0)
+        {
+          floatVec2 *last = &g_array_index (stroker->points,
+                                            floatVec2,
+                                            stroker->points->len - 1);
+          if (last->x == point.x && last->y == point.y)
+            continue;
+        }
+
+      g_array_append_val (stroker->points, point);
+    }
+
+  points = (floatVec2 *) stroker->points->data;
+  n_points = stroker->points->len;
+
+  /* Nothing is drawn for a sub path that is only a single point */
+  if (n_points < 2)
+    return;
+
+  /* If the sub path ends where it started then it is closed so the
+     last point is dropped and the ends are joined instead of
+     capped */
+  closed = (n_points >= 3 &&
+            points[0].x == points[n_points - 1].x &&
+            points[0].y == points[n_points - 1].y);
+  if (closed)
+    {
+      n_points--;
+      n_segments = n_points;
+    }
+  else
+    n_segments = n_points - 1;
+
+  _cogl_path_stroker_get_direction (points + 0, points + 1,
+                                    &first_dir, &first_normal);
+  last_dir = first_dir;
+
+  for (i = 0; i < n_segments; i++)
+    {
+      const floatVec2 *start = points + i;
+      const floatVec2 *end = points + (i + 1) % n_points;
+
+      _cogl_path_stroker_get_direction (start, end, &dir, &normal);
+
+      if (i > 0)
+        _cogl_path_stroker_add_join (stroker, start, &last_dir, &dir,
+                                     line_join);
+
+      _cogl_path_stroker_add_section (stroker,
+                                      start->x, start->y,
+                                      &normal,
+                                      TRUE, /* solid */
+                                      start_section);
+      _cogl_path_stroker_add_section (stroker,
+                                      end->x, end->y,
+                                      &normal,
+                                      TRUE, /* solid */
+                                      end_section);
+      _cogl_path_stroker_connect_sections (stroker,
+                                           start_section,
+                                           end_section);
+
+      if (i == 0)
+        memcpy (first_section, start_section, sizeof (first_section));
+
+      last_dir = dir;
+    }
+
+  if (closed)
+    _cogl_path_stroker_add_join (stroker, points, &last_dir, &first_dir,
+                                 line_join);
+  else
+    {
+      floatVec2 start_dir;
+
+      start_dir.x = -first_dir.x;
+      start_dir.y = -first_dir.y;
+
+      _cogl_path_stroker_add_cap (stroker,
+                                  points,
+                                  &start_dir,
+                                  first_section,
+                                  &first_normal,
+                                  line_cap);
+      _cogl_path_stroker_add_cap (stroker,
+                                  points + n_points - 1,
+                                  &last_dir,
+                                  end_section,
+                                  &normal,
+                                  line_cap);
+    }
+}
+
+static CoglPrimitive *
+_cogl_path_get_wide_stroke_primitive (CoglPath *path,
+                                      float feather)
+{
+  CoglPathData *data = path->data;
+  CoglPathStroker stroker;
+  CoglAttributeBuffer *attribute_buffer;
+  CoglAttribute *attributes[2];
+  CoglIndices *indices;
+  unsigned int path_start;
+  CoglPathNode *node;
+
+  if (data->wide_stroke_primitive)
+    {
+      /* The cached geometry can be reused as long as the size of a
+         pixel hasn't changed enough to make the anti-aliasing look
+         noticeably different */
+      if (feather > data->stroke_feather * 0.8f &&
+          feather < data->stroke_feather * 1.25f)
+        return data->wide_stroke_primitive;
+
+      cogl_object_unref (data->wide_stroke_primitive);
+      data->wide_stroke_primitive = NULL;
+    }
+
+  stroker.vertices = g_array_new (FALSE, FALSE, sizeof (CoglPathStrokeVertex));
+  stroker.indices = g_array_new (FALSE, FALSE, sizeof (uint32_t));
+  stroker.points = g_array_new (FALSE, FALSE, sizeof (floatVec2));
+  stroker.half_width = data->stroke_width * 0.5f;
+  stroker.inner = MAX (stroker.half_width - feather * 0.5f, 0.0f);
+  stroker.outer = stroker.half_width + feather * 0.5f;
+  stroker.feather = feather;
+  stroker.coverage = 255 * MIN (data->stroke_width / feather, 1.0f);
+  stroker.round_tolerance = feather * COGL_PATH_ROUND_TOLERANCE;
+
+  for (path_start = 0;
+       path_start < data->path_nodes->len;
+       path_start += node->path_size)
+    {
+      node = &g_array_index (data->path_nodes, CoglPathNode, path_start);
+
+      _cogl_path_stroker_add_sub_path (&stroker,
+                                       node,
+                                       data->line_join,
+                                       data->line_cap);
+    }
+
+  if (stroker.indices->len > 0)
+    {
+      attribute_buffer =
+        cogl_attribute_buffer_new (data->context,
+                                   sizeof (CoglPathStrokeVertex) *
+                                   stroker.vertices->len,
+                                   stroker.vertices->data);
+      attributes[0] =
+        cogl_attribute_new (attribute_buffer,
+                            "cogl_position_in",
+                            sizeof (CoglPathStrokeVertex),
+                            G_STRUCT_OFFSET (CoglPathStrokeVertex, x),
+                            2, /* n_components */
+                            COGL_ATTRIBUTE_TYPE_FLOAT);
+      attributes[1] =
+        cogl_attribute_new (attribute_buffer,
+                            "cogl_color_in",
+                            sizeof (CoglPathStrokeVertex),
+                            G_STRUCT_OFFSET (CoglPathStrokeVertex, coverage),
+                            4, /* n_components */
+                            COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+
+      /* Use 16-bit indices when possible because they are more widely
+         supported */
+      if (stroker.vertices->len <= 65536)
+        {
+          uint16_t *short_indices = g_new (uint16_t, stroker.indices->len);
+          int i;
+
+          for (i = 0; i < stroker.indices->len; i++)
+            short_indices[i] = g_array_index (stroker.indices, uint32_t, i);
+
+          indices = cogl_indices_new (data->context,
+                                      COGL_INDICES_TYPE_UNSIGNED_SHORT,
+                                      short_indices,
+                                      stroker.indices->len);
+          g_free (short_indices);
+        }
+      else
+        indices = cogl_indices_new (data->context,
+                                    COGL_INDICES_TYPE_UNSIGNED_INT,
+                                    stroker.indices->data,
+                                    stroker.indices->len);
+
+      data->wide_stroke_primitive =
+        cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
+                                            stroker.indices->len,
+                                            attributes,
+                                            2);
+      cogl_primitive_set_indices (data->wide_stroke_primitive,
+                                  indices,
+                                  stroker.indices->len);
+      data->stroke_feather = feather;
+
+      cogl_object_unref (indices);
+      cogl_object_unref (attributes[0]);
+      cogl_object_unref (attributes[1]);
+      cogl_object_unref (attribute_buffer);
+    }
+
+  g_array_free (stroker.vertices, TRUE);
+  g_array_free (stroker.indices, TRUE);
+  g_array_free (stroker.points, TRUE);
+
+  return data->wide_stroke_primitive;
+}
+
+/* Works out roughly how big a pixel is in the coordinate space of the
+   path by transforming a unit square at the given point */
+static float
+_cogl_path_get_pixel_size_at (CoglFramebuffer *framebuffer,
+                              float x,
+                              float y)
+{
+  CoglMatrix modelview, projection, transform;
+  float points[3][4];
+  float half_width = cogl_framebuffer_get_viewport_width (framebuffer) * 0.5f;
+  float half_height = cogl_framebuffer_get_viewport_height (framebuffer) * 0.5f;
+  float area;
+  int i;
+
+  cogl_framebuffer_get_modelview_matrix (framebuffer, &modelview);
+  cogl_framebuffer_get_projection_matrix (framebuffer, &projection);
+  cogl_matrix_multiply (&transform, &projection, &modelview);
+
+  for (i = 0; i < 3; i++)
+    {
+      points[i][0] = x;
+      points[i][1] = y;
+      points[i][2] = 0.0f;
+      points[i][3] = 1.0f;
+    }
+  points[1][0] += 1.0f;
+  points[2][1] += 1.0f;
+
+  for (i = 0; i < 3; i++)
+    {
+      cogl_matrix_transform_point (&transform,
+                                   &points[i][0], &points[i][1],
+                                   &points[i][2], &points[i][3]);
+
+      if (points[i][3] <= 0.0f)
+        return 1.0f;
+
+      points[i][0] = points[i][0] / points[i][3] * half_width;
+      points[i][1] = points[i][1] / points[i][3] * half_height;
+    }
+
+  /* The area in pixels of the transformed unit square */
+  area = fabsf ((points[1][0] - points[0][0]) * (points[2][1] - points[0][1]) -
+                (points[1][1] - points[0][1]) * (points[2][0] - points[0][0]));
+
+  if (area < 1e-8f)
+    return 1.0f;
+
+  return 1.0f / sqrtf (area);
+}
+
+/* Size of a pixel in the middle of the path */
+static float
+_cogl_path_get_pixel_size (CoglPath *path,
+                           CoglFramebuffer *framebuffer)
+{
+  CoglPathData *data = path->data;
+
+  return _cogl_path_get_pixel_size_at (framebuffer,
+                                       (data->path_nodes_min.x +
+                                        data->path_nodes_max.x) * 0.5f,
+                                       (data->path_nodes_min.y +
+                                        data->path_nodes_max.y) * 0.5f);
+}
+
+static void
+_cogl_path_stroke_wide (CoglPath *path,
+                        CoglFramebuffer *framebuffer,
+                        CoglPipeline *pipeline)
+{
+  CoglPrimitive *primitive;
+  CoglPipeline *copy;
+  CoglColor color;
+
+  primitive =
+    _cogl_path_get_wide_stroke_primitive (path,
+                                          _cogl_path_get_pixel_size
+                                          (path, framebuffer));
+  if (primitive == NULL)
+    return;
+
+  /* The vertex colors replace the primary color with the coverage so
+     the pipeline color is put back with a layer that modulates it */
+  copy = cogl_pipeline_copy (pipeline);
+  _cogl_pipeline_prune_to_n_layers (copy, 0);
+  cogl_pipeline_get_color (pipeline, &color);
+  cogl_pipeline_set_layer_combine (copy, 0,
+                                   "RGBA = MODULATE (PRIMARY, CONSTANT)",
+                                   NULL);
+  cogl_pipeline_set_layer_combine_constant (copy, 0, &color);
+
+  cogl_primitive_draw (primitive, framebuffer, copy);
+
+  cogl_object_unref (copy);
+}
@@ -254,6 +254,57 @@ cogl_path_rel_curve_to (CoglPath *path,
                         float x_3,
                         float y_3);
 
+/**
+ * cogl_path_set_tolerance:
+ * @path: A #CoglPath
+ * @tolerance: The maximum distance in path units between a curve and
+ *   the straight lines used to approximate it
+ *
+ * Sets how closely curves added with cogl_path_curve_to() and
+ * cogl_path_rel_curve_to() are approximated. Curves are split into
+ * straight line segments when they are added so the tolerance only
+ * affects curves added after it is set. A smaller tolerance gives
+ * smoother curves but more nodes. The default is 0.25.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_path_set_tolerance (CoglPath *path,
+                         float tolerance);
+
+/**
+ * cogl_path_get_tolerance:
+ * @path: A #CoglPath
+ *
+ * Retrieves the tolerance set using cogl_path_set_tolerance().
+ *
+ * Return value: the tolerance of @path in path units.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+float
+cogl_path_get_tolerance (CoglPath *path);
+
+/**
+ * cogl_path_set_tolerance_for_framebuffer:
+ * @path: A #CoglPath
+ * @framebuffer: The #CoglFramebuffer that the path will be drawn to
+ *
+ * Sets the tolerance of @path so that curves added afterwards are
+ * approximated to within a quarter of a pixel when drawn to
+ * @framebuffer with its current modelview and projection matrices.
+ * This avoids generating more nodes than are visible when the path is
+ * scaled down and keeps curves smooth when it is scaled up.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_path_set_tolerance_for_framebuffer (CoglPath *path,
+                                         CoglFramebuffer *framebuffer);
+
 /**
  * cogl_path_close:
  * @path: A #CoglPath
@@ -466,6 +517,75 @@ cogl_path_set_fill_rule (CoglPath *path, CoglPathFillRule fill_rule);
 CoglPathFillRule
 cogl_path_get_fill_rule (CoglPath *path);
 
+/**
+ * CoglPathFillStrategy:
+ * @COGL_PATH_FILL_STRATEGY_AUTOMATIC: Cogl picks a strategy each time
+ *   the path is filled. Large complex paths that have not been
+ *   filled before are drawn using the stencil buffer and the path is
+ *   only tesselated once it has been filled a second time without
+ *   being modified.
+ * @COGL_PATH_FILL_STRATEGY_TESSELATE: The path is always tesselated
+ *   into triangles on the CPU. The triangles are cached until the
+ *   path is modified.
+ * @COGL_PATH_FILL_STRATEGY_STENCIL: The path is not tesselated.
+ *   Instead a triangle fan of each sub path is drawn into the stencil
+ *   buffer so that each pixel is inverted every time it is covered
+ *   and then the bounding box of the path is drawn masked by the
+ *   stencil buffer. This only works with
+ *   %COGL_PATH_FILL_RULE_EVEN_ODD and it needs a framebuffer with a
+ *   stencil buffer of at least two bits. Paths using the non-zero
+ *   rule or drawn to a framebuffer without enough stencil bits are
+ *   tesselated instead.
+ *
+ * #CoglPathFillStrategy is used to specify how a path is converted
+ * into something the GPU can draw when it is filled.
+ *
+ * Tesselating a path with lots of nodes can be expensive so for
+ * paths that change every frame it can be faster to let the GPU
+ * work out the interior using the stencil buffer. However this costs
+ * more fill rate and it causes the journal to be flushed for every
+ * path so for paths that are drawn many times it is better to
+ * tesselate them once.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef enum {
+  COGL_PATH_FILL_STRATEGY_AUTOMATIC,
+  COGL_PATH_FILL_STRATEGY_TESSELATE,
+  COGL_PATH_FILL_STRATEGY_STENCIL
+} CoglPathFillStrategy;
+
+/**
+ * cogl_path_set_fill_strategy:
+ * @path: A #CoglPath
+ * @strategy: The new fill strategy
+ *
+ * Sets the strategy used to fill @path when cogl_path_fill() is
+ * called. The default is %COGL_PATH_FILL_STRATEGY_AUTOMATIC. See
+ * #CoglPathFillStrategy for details.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_path_set_fill_strategy (CoglPath *path,
+                             CoglPathFillStrategy strategy);
+
+/**
+ * cogl_path_get_fill_strategy:
+ * @path: A #CoglPath
+ *
+ * Retrieves the fill strategy set using cogl_path_set_fill_strategy().
+ *
+ * Return value: the fill strategy that is used for @path.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglPathFillStrategy
+cogl_path_get_fill_strategy (CoglPath *path);
+
 /**
  * cogl_framebuffer_fill_path:
  * @path: The #CoglPath to fill
@@ -500,10 +620,15 @@ cogl_path_fill (CoglPath *path,
  * given @path using the specified GPU @pipeline to the given
  * @framebuffer.
  *
- * <note>Cogl does not provide any sophisticated path stroking
- * features for things like stroke width, dashes or caps. The stroke
- * line will have a width of 1 pixel regardless of the current
- * transformation matrix.</note>
+ * By default the stroke line will have a width of 1 pixel regardless
+ * of the current transformation matrix. If a stroke width has been
+ * set with cogl_path_set_stroke_width() then the line is instead
+ * drawn as anti-aliased triangles using the line join and line cap
+ * styles of the path. All of the sub paths are drawn together with a
+ * single draw call and the geometry is cached until the path is
+ * modified.
+ *
+ * <note>Cogl does not support dashed strokes.</note>
  *
  * Since: 2.0
  */
@@ -512,6 +637,144 @@ cogl_path_stroke (CoglPath *path,
                   CoglFramebuffer *framebuffer,
                   CoglPipeline *pipeline);
 
+/**
+ * CoglPathLineJoin:
+ * @COGL_PATH_LINE_JOIN_MITER: The outer edges of the two lines are
+ *   extended until they meet. If the point where they meet is too far
+ *   away from the node because the angle is very sharp then a bevel
+ *   join is used instead.
+ * @COGL_PATH_LINE_JOIN_ROUND: The lines are joined with a circular
+ *   arc centered on the node.
+ * @COGL_PATH_LINE_JOIN_BEVEL: The outer corners of the two lines are
+ *   joined with a straight edge.
+ *
+ * #CoglPathLineJoin specifies how two connected segments of a wide
+ * stroke are joined together.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef enum {
+  COGL_PATH_LINE_JOIN_MITER,
+  COGL_PATH_LINE_JOIN_ROUND,
+  COGL_PATH_LINE_JOIN_BEVEL
+} CoglPathLineJoin;
+
+/**
+ * CoglPathLineCap:
+ * @COGL_PATH_LINE_CAP_BUTT: The line stops exactly at the end point.
+ * @COGL_PATH_LINE_CAP_ROUND: The line is ended with a semicircle
+ *   centered on the end point.
+ * @COGL_PATH_LINE_CAP_SQUARE: The line is extended past the end point
+ *   by half of the stroke width.
+ *
+ * #CoglPathLineCap specifies how the ends of sub paths that aren't
+ * closed are drawn in a wide stroke. A sub path is considered closed
+ * if its last node is at the same position as its first node, such
+ * as after calling cogl_path_close().
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef enum {
+  COGL_PATH_LINE_CAP_BUTT,
+  COGL_PATH_LINE_CAP_ROUND,
+  COGL_PATH_LINE_CAP_SQUARE
+} CoglPathLineCap;
+
+/**
+ * cogl_path_set_stroke_width:
+ * @path: A #CoglPath
+ * @width: The width of the stroke in the same units as the path
+ *
+ * Sets the width used when @path is stroked with cogl_path_stroke().
+ * The width is transformed by the current modelview matrix in the
+ * same way as the path. A width of 0, which is the default, means the
+ * path is stroked with 1 pixel wide lines.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_path_set_stroke_width (CoglPath *path,
+                            float width);
+
+/**
+ * cogl_path_get_stroke_width:
+ * @path: A #CoglPath
+ *
+ * Retrieves the stroke width set using cogl_path_set_stroke_width().
+ *
+ * Return value: the stroke width of @path.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+float
+cogl_path_get_stroke_width (CoglPath *path);
+
+/**
+ * cogl_path_set_line_join:
+ * @path: A #CoglPath
+ * @line_join: The new line join style
+ *
+ * Sets how the segments of wide strokes are joined when @path is
+ * stroked. The default is %COGL_PATH_LINE_JOIN_MITER. This has no
+ * effect unless a stroke width has been set with
+ * cogl_path_set_stroke_width().
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_path_set_line_join (CoglPath *path,
+                         CoglPathLineJoin line_join);
+
+/**
+ * cogl_path_get_line_join:
+ * @path: A #CoglPath
+ *
+ * Retrieves the line join style set using cogl_path_set_line_join().
+ *
+ * Return value: the line join style of @path.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglPathLineJoin
+cogl_path_get_line_join (CoglPath *path);
+
+/**
+ * cogl_path_set_line_cap:
+ * @path: A #CoglPath
+ * @line_cap: The new line cap style
+ *
+ * Sets how the ends of open sub paths are drawn when @path is
+ * stroked. The default is %COGL_PATH_LINE_CAP_BUTT. This has no
+ * effect unless a stroke width has been set with
+ * cogl_path_set_stroke_width().
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_path_set_line_cap (CoglPath *path,
+                        CoglPathLineCap line_cap);
+
+/**
+ * cogl_path_get_line_cap:
+ * @path: A #CoglPath
+ *
+ * Retrieves the line cap style set using cogl_path_set_line_cap().
+ *
+ * Return value: the line cap style of @path.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglPathLineCap
+cogl_path_get_line_cap (CoglPath *path);
+
 /**
  * cogl_framebuffer_push_path_clip:
  * @framebuffer: A #CoglFramebuffer pointer
@@ -0,0 +1,192 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "cogl-util.h"
+#include "cogl-memory-stack-private.h"
+#include "tesselator.h"
+#include "memalloc.h"
+
+/* Every allocation is preceded by a header recording its size so
+   that the block can be put on the right free list or copied when it
+   is reallocated. The union makes sure that the memory after the
+   header is suitably aligned for any of the tesselator's structs */
+typedef union
+{
+  size_t size;
+  double d;
+  void *p;
+} CoglTessBlockHeader;
+
+#define BLOCK_ALIGNMENT sizeof (CoglTessBlockHeader)
+
+/* Blocks up to this size are kept on a free list when they are freed.
+   This covers all of the mesh, dictionary and region structs which
+   are the ones allocated and freed repeatedly during the sweep */
+#define MAX_FREE_LIST_SIZE 256
+#define N_FREE_LISTS (MAX_FREE_LIST_SIZE / BLOCK_ALIGNMENT + 1)
+
+#define INITIAL_ARENA_SIZE (16 * 1024)
+
+typedef struct _CoglTessFreeBlock
+{
+  struct _CoglTessFreeBlock *next;
+} CoglTessFreeBlock;
+
+typedef struct
+{
+  CoglMemoryStack *stack;
+  CoglTessFreeBlock *free_lists[N_FREE_LISTS];
+} CoglTessArena;
+
+/* The tesselator doesn't have any way to pass a context to its
+   allocation functions so the current arena is global. Cogl isn't
+   used from multiple threads at the same time so this is fine */
+static CoglTessArena *current_arena = NULL;
+
+void
+_cogl_tess_arena_begin (void)
+{
+  _COGL_RETURN_IF_FAIL (current_arena == NULL);
+
+  current_arena = g_slice_new0 (CoglTessArena);
+  current_arena->stack = _cogl_memory_stack_new (INITIAL_ARENA_SIZE);
+}
+
+void
+_cogl_tess_arena_end (void)
+{
+  _COGL_RETURN_IF_FAIL (current_arena != NULL);
+
+  _cogl_memory_stack_free (current_arena->stack);
+  g_slice_free (CoglTessArena, current_arena);
+  current_arena = NULL;
+}
+
+static size_t
+align_size (size_t size)
+{
+  return (size + BLOCK_ALIGNMENT - 1) & ~(BLOCK_ALIGNMENT - 1);
+}
+
+void *
+_cogl_tess_alloc (size_t size)
+{
+  CoglTessBlockHeader *header;
+
+  size = align_size (size);
+
+  if (current_arena == NULL)
+    header = g_malloc (sizeof (CoglTessBlockHeader) + size);
+  else
+    {
+      if (size <= MAX_FREE_LIST_SIZE)
+        {
+          CoglTessFreeBlock **free_list =
+            current_arena->free_lists + size / BLOCK_ALIGNMENT;
+
+          if (*free_list)
+            {
+              CoglTessFreeBlock *block = *free_list;
+              *free_list = block->next;
+              return block;
+            }
+        }
+
+      header = _cogl_memory_stack_alloc (current_arena->stack,
+                                         sizeof (CoglTessBlockHeader) + size);
+    }
+
+  header->size = size;
+
+  return header + 1;
+}
+
+void
+_cogl_tess_free (void *ptr)
+{
+  CoglTessBlockHeader *header;
+
+  if (ptr == NULL)
+    return;
+
+  header = (CoglTessBlockHeader *) ptr - 1;
+
+  if (current_arena == NULL)
+    g_free (header);
+  else if (header->size <= MAX_FREE_LIST_SIZE)
+    {
+      CoglTessFreeBlock **free_list =
+        current_arena->free_lists + header->size / BLOCK_ALIGNMENT;
+      CoglTessFreeBlock *block = ptr;
+
+      block->next = *free_list;
+      *free_list = block;
+    }
+
+  /* Larger blocks are just left in the memory stack until the arena
+     is ended */
+}
+
+void *
+_cogl_tess_realloc (void *ptr, size_t size)
+{
+  CoglTessBlockHeader *header;
+  void *new_ptr;
+
+  if (ptr == NULL)
+    return _cogl_tess_alloc (size);
+
+  header = (CoglTessBlockHeader *) ptr - 1;
+
+  if (current_arena == NULL)
+    {
+      size = align_size (size);
+      header = g_realloc (header, sizeof (CoglTessBlockHeader) + size);
+      header->size = size;
+      return header + 1;
+    }
+
+  if (size <= header->size)
+    return ptr;
+
+  /* The priority queues grow by doubling so copying the old contents
+     into a new block doesn't waste too much of the arena */
+  new_ptr = _cogl_tess_alloc (size);
+  memcpy (new_ptr, ptr, header->size);
+  _cogl_tess_free (ptr);
+
+  return new_ptr;
+}
@@ -29,16 +29,29 @@
  */
 
 /* This is a simple replacement for memalloc from the SGI tesselator
-   code to force it to use glib's allocation instead */
+   code. Outside of an arena it uses glib's allocation. While an arena
+   is active (see _cogl_tess_arena_begin() in tesselator.h) everything
+   comes from a single memory stack instead so that tesselating a
+   large path doesn't make a separate malloc call for every vertex,
+   edge and region */
 
 #ifndef __MEMALLOC_H__
 #define __MEMALLOC_H__
 
 #include <glib.h>
 
-#define memRealloc g_realloc
-#define memAlloc   g_malloc
-#define memFree    g_free
+void *
+_cogl_tess_alloc (size_t size);
+
+void *
+_cogl_tess_realloc (void *ptr, size_t size);
+
+void
+_cogl_tess_free (void *ptr);
+
+#define memRealloc _cogl_tess_realloc
+#define memAlloc   _cogl_tess_alloc
+#define memFree    _cogl_tess_free
 #define memInit(x) 1
 
 /* tess.c defines TRUE and FALSE itself unconditionally so we need to
@@ -61,6 +61,14 @@ void gluTessNormal (GLUtesselator* tess, double valueX, double valueY, double va
 void gluTessProperty (GLUtesselator* tess, GLenum which, double data);
 void gluTessVertex (GLUtesselator* tess, double *location, GLvoid* data);
 
+/* While an arena is active all of the tesselator's allocations come
+   from a single memory stack and freeing them only puts them on a
+   free list to be reused. Everything is released at once when the
+   arena is ended so all tesselator objects created within the arena
+   must be deleted before then. Arenas can not be nested. */
+void _cogl_tess_arena_begin (void);
+void _cogl_tess_arena_end (void);
+
 /* ErrorCode */
 #define GLU_INVALID_ENUM                   100900
 #define GLU_INVALID_VALUE                  100901
@@ -47,7 +47,8 @@ struct _CoglAtlasTexture
   CoglPixelFormat       internal_format;
 
   /* The rectangle that was used to add this texture to the
-     atlas. This includes the 1-pixel border */
+     atlas. This includes the 1-pixel border and any padding added
+     by a mipmapped atlas to align it */
   CoglRectangleMapEntry rectangle;
 
   /* The atlas that this texture is in. If the texture is no longer in
@@ -59,8 +60,26 @@ struct _CoglAtlasTexture
    * rendering or if the texture has been migrated out of the atlas it
    * may be some other texture type such as CoglTexture2D */
   CoglTexture          *sub_texture;
+
+  /* Whether the texture should be put in an atlas that keeps
+     separate mipmap levels for each of its images */
+  CoglBool              mipmapped;
 };
 
+/*
+ * _cogl_atlas_texture_new_mipmapped_from_bitmap:
+ * @bmp: A #CoglBitmap
+ *
+ * Creates an atlas texture that is put in one of the mipmapped
+ * atlases. The mipmap levels of the image are built on the CPU with
+ * a box filter when it is allocated and they are clamped to the edges
+ * of the image so they don't need to be regenerated when the texture
+ * is drawn with a mipmap filter. Allocation fails if the driver can't
+ * limit the number of levels of the atlas texture.
+ */
+CoglAtlasTexture *
+_cogl_atlas_texture_new_mipmapped_from_bitmap (CoglBitmap *bmp);
+
 void
 _cogl_atlas_texture_add_reorganize_callback (CoglContext *ctx,
                                              GHookFunc callback,
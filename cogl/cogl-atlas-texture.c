@@ -54,6 +54,7 @@
 #include "cogl-private.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 static void _cogl_atlas_texture_free (CoglAtlasTexture *sub_tex);
 
@@ -62,18 +63,20 @@ COGL_TEXTURE_DEFINE (AtlasTexture, atlas_texture);
 static const CoglTextureVtable cogl_atlas_texture_vtable;
 
 static CoglSubTexture *
-_cogl_atlas_texture_create_sub_texture (CoglTexture *full_texture,
+_cogl_atlas_texture_create_sub_texture (CoglAtlasTexture *atlas_tex,
+                                        CoglTexture *full_texture,
                                         const CoglRectangleMapEntry *rectangle)
 {
   CoglContext *ctx = full_texture->context;
   /* Create a subtexture for the given rectangle not including the
-     1-pixel border */
+     1-pixel border. The rectangle can be bigger than the texture plus
+     the border if the atlas aligns its rectangles */
   return cogl_sub_texture_new (ctx,
                                full_texture,
                                rectangle->x + 1,
                                rectangle->y + 1,
-                               rectangle->width - 2,
-                               rectangle->height - 2);
+                               COGL_TEXTURE (atlas_tex)->width,
+                               COGL_TEXTURE (atlas_tex)->height);
 }
 
 static void
@@ -87,7 +90,9 @@ _cogl_atlas_texture_update_position_cb (void *user_data,
   if (atlas_tex->sub_texture)
     cogl_object_unref (atlas_tex->sub_texture);
   atlas_tex->sub_texture = COGL_TEXTURE (
-    _cogl_atlas_texture_create_sub_texture (new_texture, rectangle));
+    _cogl_atlas_texture_create_sub_texture (atlas_tex,
+                                            new_texture,
+                                            rectangle));
 
   /* Update the position */
   atlas_tex->rectangle = *rectangle;
@@ -201,12 +206,13 @@ _cogl_atlas_texture_atlas_destroyed_cb (void *user_data)
 }
 
 static CoglAtlas *
-_cogl_atlas_texture_create_atlas (CoglContext *ctx)
+_cogl_atlas_texture_create_atlas (CoglContext *ctx,
+                                  CoglAtlasFlags flags)
 {
   static CoglUserDataKey atlas_private_key;
 
   CoglAtlas *atlas = _cogl_atlas_new (COGL_PIXEL_FORMAT_RGBA_8888,
-                                      0,
+                                      flags,
                                       _cogl_atlas_texture_update_position_cb);
 
   _cogl_atlas_add_reorganize_callback (atlas,
@@ -385,8 +391,8 @@ _cogl_atlas_texture_migrate_out_of_atlas (CoglAtlasTexture *atlas_tex)
     _cogl_atlas_copy_rectangle (atlas_tex->atlas,
                                 atlas_tex->rectangle.x + 1,
                                 atlas_tex->rectangle.y + 1,
-                                atlas_tex->rectangle.width - 2,
-                                atlas_tex->rectangle.height - 2,
+                                COGL_TEXTURE (atlas_tex)->width,
+                                COGL_TEXTURE (atlas_tex)->height,
                                 atlas_tex->internal_format);
   /* Note: we simply silently ignore failures to migrate a texture
    * out (most likely due to lack of memory) and hope for the
@@ -418,9 +424,12 @@ _cogl_atlas_texture_pre_paint (CoglTexture *tex, CoglTexturePrePaintFlags flags)
 {
   CoglAtlasTexture *atlas_tex = COGL_ATLAS_TEXTURE (tex);
 
-  if ((flags & COGL_TEXTURE_NEEDS_MIPMAP))
-    /* Mipmaps do not work well with the current atlas so instead
-       we'll just migrate the texture out and use a regular texture */
+  if ((flags & COGL_TEXTURE_NEEDS_MIPMAP) &&
+      atlas_tex->atlas &&
+      !(atlas_tex->atlas->flags & COGL_ATLAS_MIPMAPPED))
+    /* Mipmaps do not work well with the regular atlas because the
+       images would bleed into each other so instead we'll just
+       migrate the texture out and use a regular texture */
     _cogl_atlas_texture_migrate_out_of_atlas (atlas_tex);
 
   /* Forward on to the sub texture */
@@ -477,13 +486,13 @@ _cogl_atlas_texture_set_region_with_border (CoglAtlasTexture *atlas_tex,
                                             error))
     return FALSE;
   /* Update the right edge pixels */
-  if (dst_x + dst_width == atlas_tex->rectangle.width - 2 &&
+  if (dst_x + dst_width == COGL_TEXTURE (atlas_tex)->width &&
       !cogl_texture_set_region_from_bitmap (atlas->texture,
                                             src_x + dst_width - 1, src_y,
                                             1, dst_height,
                                             bmp,
                                             atlas_tex->rectangle.x +
-                                            atlas_tex->rectangle.width - 1,
+                                            COGL_TEXTURE (atlas_tex)->width + 1,
                                             dst_y + atlas_tex->rectangle.y + 1,
                                             0, /* level 0 */
                                             error))
@@ -500,14 +509,14 @@ _cogl_atlas_texture_set_region_with_border (CoglAtlasTexture *atlas_tex,
                                             error))
     return FALSE;
   /* Update the bottom edge pixels */
-  if (dst_y + dst_height == atlas_tex->rectangle.height - 2 &&
+  if (dst_y + dst_height == COGL_TEXTURE (atlas_tex)->height &&
       !cogl_texture_set_region_from_bitmap (atlas->texture,
                                             src_x, src_y + dst_height - 1,
                                             dst_width, 1,
                                             bmp,
                                             dst_x + atlas_tex->rectangle.x + 1,
                                             atlas_tex->rectangle.y +
-                                            atlas_tex->rectangle.height - 1,
+                                            COGL_TEXTURE (atlas_tex)->height + 1,
                                             0, /* level 0 */
                                             error))
     return FALSE;
@@ -515,6 +524,75 @@ _cogl_atlas_texture_set_region_with_border (CoglAtlasTexture *atlas_tex,
   return TRUE;
 }
 
+/* Uploads the whole rectangle of a texture in a mipmapped atlas. The
+   edge pixels of the image are repeated over the border and the
+   padding so that the smaller levels act as if the image was clamped
+   to its edges */
+static CoglBool
+_cogl_atlas_texture_upload_mipmapped (CoglAtlasTexture *atlas_tex,
+                                      CoglBitmap *bmp,
+                                      CoglError **error)
+{
+  CoglContext *ctx = COGL_TEXTURE (atlas_tex)->context;
+  CoglAtlas *atlas = atlas_tex->atlas;
+  const CoglRectangleMapEntry *rect = &atlas_tex->rectangle;
+  int width = cogl_bitmap_get_width (bmp);
+  int height = cogl_bitmap_get_height (bmp);
+  int src_rowstride = cogl_bitmap_get_rowstride (bmp);
+  int rowstride = rect->width * 4;
+  CoglBitmap *rect_bmp;
+  const uint8_t *src;
+  uint8_t *data;
+  CoglBool ret;
+  int x, y;
+
+  src = _cogl_bitmap_map (bmp, COGL_BUFFER_ACCESS_READ, 0, error);
+  if (src == NULL)
+    return FALSE;
+
+  data = g_malloc (rowstride * rect->height);
+
+  for (y = 0; y < rect->height; y++)
+    {
+      const uint8_t *src_row =
+        src + CLAMP (y - 1, 0, height - 1) * src_rowstride;
+      uint8_t *dst_row = data + y * rowstride;
+
+      for (x = 0; x < rect->width; x++)
+        memcpy (dst_row + x * 4,
+                src_row + CLAMP (x - 1, 0, width - 1) * 4,
+                4);
+    }
+
+  _cogl_bitmap_unmap (bmp);
+
+  rect_bmp = cogl_bitmap_new_for_data (ctx,
+                                       rect->width,
+                                       rect->height,
+                                       atlas->texture_format,
+                                       rowstride,
+                                       data);
+
+  ret = cogl_texture_set_region_from_bitmap (atlas->texture,
+                                             0, 0, /* src_x/y */
+                                             rect->width,
+                                             rect->height,
+                                             rect_bmp,
+                                             rect->x,
+                                             rect->y,
+                                             0, /* level 0 */
+                                             error);
+
+  cogl_object_unref (rect_bmp);
+
+  if (ret)
+    _cogl_atlas_update_mipmaps (atlas, rect, data, rowstride);
+
+  g_free (data);
+
+  return ret;
+}
+
 static CoglBitmap *
 _cogl_atlas_texture_convert_bitmap_for_upload (CoglAtlasTexture *atlas_tex,
                                                CoglBitmap *bmp,
@@ -574,7 +652,10 @@ _cogl_atlas_texture_set_region (CoglTexture *tex,
 {
   CoglAtlasTexture  *atlas_tex = COGL_ATLAS_TEXTURE (tex);
 
-  if (level != 0 && atlas_tex->atlas)
+  /* The levels of a mipmapped atlas are only built when the whole
+     image is uploaded so any later changes migrate the texture out */
+  if (atlas_tex->atlas &&
+      (level != 0 || (atlas_tex->atlas->flags & COGL_ATLAS_MIPMAPPED)))
     _cogl_atlas_texture_migrate_out_of_atlas (atlas_tex);
 
   /* If the texture is in the atlas then we need to copy the edge
@@ -678,6 +759,8 @@ _cogl_atlas_texture_create_base (CoglContext *ctx,
 
   atlas_tex->atlas = NULL;
 
+  atlas_tex->mipmapped = FALSE;
+
   return _cogl_atlas_texture_object_new (atlas_tex);
 }
 
@@ -711,6 +794,7 @@ allocate_space (CoglAtlasTexture *atlas_tex,
 {
   CoglTexture *tex = COGL_TEXTURE (atlas_tex);
   CoglContext *ctx = tex->context;
+  CoglAtlasFlags flags = atlas_tex->mipmapped ? COGL_ATLAS_MIPMAPPED : 0;
   CoglAtlas *atlas;
   GSList *l;
 
@@ -738,9 +822,41 @@ allocate_space (CoglAtlasTexture *atlas_tex,
       return FALSE;
     }
 
+  if (atlas_tex->mipmapped)
+    {
+      /* The levels of the atlas texture can only be limited to the
+         ones that don't overlap with GL_TEXTURE_MAX_LEVEL */
+      if (!_cogl_has_private_feature (ctx,
+                                      COGL_PRIVATE_FEATURE_TEXTURE_MAX_LEVEL))
+        {
+          _cogl_set_error (error,
+                           COGL_SYSTEM_ERROR,
+                           COGL_SYSTEM_ERROR_UNSUPPORTED,
+                           "Mipmapped atlasing needs "
+                           "GL_TEXTURE_MAX_LEVEL");
+          return FALSE;
+        }
+
+      /* The levels are built by averaging the stored values so this
+         would only be right for premultiplied or opaque images */
+      if ((internal_format & COGL_A_BIT) &&
+          !(internal_format & COGL_PREMULT_BIT))
+        {
+          _cogl_set_error (error,
+                           COGL_TEXTURE_ERROR,
+                           COGL_TEXTURE_ERROR_FORMAT,
+                           "Mipmapped atlas textures must be "
+                           "premultiplied");
+          return FALSE;
+        }
+    }
+
   /* Look for an existing atlas that can hold the texture */
   for (l = ctx->atlases; l; l = l->next)
     {
+      if ((COGL_ATLAS (l->data)->flags & COGL_ATLAS_MIPMAPPED) != flags)
+        continue;
+
       /* We need to take a reference on the atlas before trying to
        * reserve space because in some circumstances atlas migration
        * can cause the atlas to be freed */
@@ -763,7 +879,7 @@ allocate_space (CoglAtlasTexture *atlas_tex,
   /* If we couldn't find a suitable atlas then start another */
   if (l == NULL)
     {
-      atlas = _cogl_atlas_texture_create_atlas (ctx);
+      atlas = _cogl_atlas_texture_create_atlas (ctx, flags);
       COGL_NOTE (ATLAS, "Created new atlas for textures: %p", atlas);
       if (!_cogl_atlas_reserve_space (atlas,
                                       /* Add two pixels for the border */
@@ -852,7 +968,9 @@ allocate_from_bitmap (CoglAtlasTexture *atlas_tex,
 
   /* Defer to set_region so that we can share the code for copying the
      edge pixels to the border. */
-  if (!_cogl_atlas_texture_set_region_with_border (atlas_tex,
+  if (atlas_tex->mipmapped ?
+      !_cogl_atlas_texture_upload_mipmapped (atlas_tex, upload_bmp, error) :
+      !_cogl_atlas_texture_set_region_with_border (atlas_tex,
                                                    0, /* src_x */
                                                    0, /* src_y */
                                                    0, /* dst_x */
@@ -922,6 +1040,18 @@ cogl_atlas_texture_new_from_bitmap (CoglBitmap *bmp)
   return _cogl_atlas_texture_new_from_bitmap (bmp, FALSE);
 }
 
+CoglAtlasTexture *
+_cogl_atlas_texture_new_mipmapped_from_bitmap (CoglBitmap *bmp)
+{
+  CoglAtlasTexture *atlas_tex = _cogl_atlas_texture_new_from_bitmap (bmp,
+                                                                     FALSE);
+
+  if (atlas_tex)
+    atlas_tex->mipmapped = TRUE;
+
+  return atlas_tex;
+}
+
 CoglAtlasTexture *
 cogl_atlas_texture_new_from_data (CoglContext *ctx,
                                   int width,
@@ -1036,5 +1166,7 @@ cogl_atlas_texture_vtable =
     _cogl_atlas_texture_get_gl_format,
     _cogl_atlas_texture_get_type,
     NULL, /* is_foreign */
-    NULL /* set_auto_mipmap */
+    NULL, /* set_auto_mipmap */
+    NULL, /* get_gpu_bytes */
+    NULL /* discard_storage */
   };
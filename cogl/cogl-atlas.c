@@ -45,6 +45,8 @@
 #include "cogl-framebuffer-private.h"
 #include "cogl-blit.h"
 #include "cogl-private.h"
+#include "cogl-primitive-texture.h"
+#include "cogl-mipmap-private.h"
 
 #include <stdlib.h>
 
@@ -95,6 +97,72 @@ typedef struct _CoglAtlasRepositionData
   CoglRectangleMapEntry new_position;
 } CoglAtlasRepositionData;
 
+static void
+upload_mipmaps (CoglAtlas *atlas,
+                CoglTexture *texture,
+                const CoglRectangleMapEntry *rectangle,
+                const uint8_t *data,
+                int rowstride)
+{
+  CoglMipmapLevel *levels;
+  int n_levels, n_uploaded_levels;
+  int i;
+
+  _COGL_GET_CONTEXT (ctx, NO_RETVAL);
+
+  _COGL_RETURN_IF_FAIL ((atlas->flags & COGL_ATLAS_MIPMAPPED));
+  _COGL_RETURN_IF_FAIL (_cogl_pixel_format_get_bytes_per_pixel
+                        (atlas->texture_format) == 4);
+
+  /* The atlas texture doesn't have the premult bit so the data is
+     just averaged as stored, the same as glGenerateMipmap would */
+  levels = _cogl_mipmap_build (_cogl_context_get_worker_pool (ctx),
+                               data,
+                               rectangle->width,
+                               rectangle->height,
+                               rowstride,
+                               COGL_MIPMAP_FILTER_BOX,
+                               COGL_MIPMAP_FLAG_NONE,
+                               &n_levels);
+
+  /* Below this level the rectangle would start sharing texels with
+     its neighbours */
+  n_uploaded_levels = MIN (n_levels, COGL_ATLAS_MIPMAP_LEVELS);
+
+  for (i = 0; i < n_uploaded_levels; i++)
+    {
+      const CoglMipmapLevel *level = levels + i;
+      CoglError *ignore_error = NULL;
+      CoglBitmap *bitmap = cogl_bitmap_new_for_data (ctx,
+                                                     level->width,
+                                                     level->height,
+                                                     atlas->texture_format,
+                                                     level->rowstride,
+                                                     level->data);
+
+      if (!cogl_texture_set_region_from_bitmap (texture,
+                                                0, 0, /* src_x/y */
+                                                level->width,
+                                                level->height,
+                                                bitmap,
+                                                rectangle->x >> (i + 1),
+                                                rectangle->y >> (i + 1),
+                                                i + 1, /* level */
+                                                &ignore_error))
+        {
+          COGL_NOTE (ATLAS, "%p: Failed to upload mipmap level %i: %s",
+                     atlas, i + 1, ignore_error->message);
+          cogl_error_free (ignore_error);
+          cogl_object_unref (bitmap);
+          break;
+        }
+
+      cogl_object_unref (bitmap);
+    }
+
+  _cogl_mipmap_free_levels (levels, n_levels);
+}
+
 static void
 _cogl_atlas_migrate (CoglAtlas               *atlas,
                      unsigned int             n_textures,
@@ -139,6 +207,35 @@ _cogl_atlas_migrate (CoglAtlas               *atlas,
         }
 
       _cogl_blit_end (&blit_data);
+
+      /* The blit only copies the base level so the other levels need
+         to be built again from what ended up in the new texture */
+      if ((atlas->flags & COGL_ATLAS_MIPMAPPED))
+        {
+          int width = cogl_texture_get_width (new_texture);
+          int rowstride = width * 4;
+          uint8_t *data =
+            g_malloc (rowstride * cogl_texture_get_height (new_texture));
+
+          cogl_texture_get_data (new_texture,
+                                 atlas->texture_format,
+                                 rowstride,
+                                 data);
+
+          for (i = 0; i < n_textures; i++)
+            {
+              const CoglRectangleMapEntry *rect = &textures[i].new_position;
+
+              if (textures[i].user_data != skip_user_data)
+                upload_mipmaps (atlas,
+                                new_texture,
+                                rect,
+                                data + rect->y * rowstride + rect->x * 4,
+                                rowstride);
+            }
+
+          g_free (data);
+        }
     }
 }
 
@@ -335,6 +432,12 @@ _cogl_atlas_create_texture (CoglAtlas *atlas,
         }
     }
 
+  /* The levels of each rectangle are uploaded separately so the
+     texture must never regenerate them from the whole base level */
+  if (tex && (atlas->flags & COGL_ATLAS_MIPMAPPED))
+    cogl_primitive_texture_set_auto_mipmap (COGL_PRIMITIVE_TEXTURE (tex),
+                                            FALSE);
+
   return tex;
 }
 
@@ -377,6 +480,16 @@ _cogl_atlas_reserve_space (CoglAtlas             *atlas,
   CoglBool ret;
   CoglRectangleMapEntry new_position;
 
+  /* If every size is a multiple of the alignment then the rectangle
+     map will only ever place rectangles at aligned positions */
+  if ((atlas->flags & COGL_ATLAS_MIPMAPPED))
+    {
+      width = ((width + COGL_ATLAS_MIPMAP_ALIGNMENT - 1) &
+               ~(COGL_ATLAS_MIPMAP_ALIGNMENT - 1));
+      height = ((height + COGL_ATLAS_MIPMAP_ALIGNMENT - 1) &
+                ~(COGL_ATLAS_MIPMAP_ALIGNMENT - 1));
+    }
+
   /* Check if we can fit the rectangle into the existing map */
   if (atlas->map &&
       _cogl_rectangle_map_add (atlas->map, width, height,
@@ -605,6 +718,15 @@ create_migration_texture (CoglContext *ctx,
   return tex;
 }
 
+void
+_cogl_atlas_update_mipmaps (CoglAtlas *atlas,
+                            const CoglRectangleMapEntry *rectangle,
+                            const uint8_t *data,
+                            int rowstride)
+{
+  upload_mipmaps (atlas, atlas->texture, rectangle, data, rowstride);
+}
+
 CoglTexture *
 _cogl_atlas_copy_rectangle (CoglAtlas *atlas,
                             int x,
@@ -41,9 +41,16 @@ typedef void
 typedef enum
 {
   COGL_ATLAS_CLEAR_TEXTURE     = (1 << 0),
-  COGL_ATLAS_DISABLE_MIGRATION = (1 << 1)
+  COGL_ATLAS_DISABLE_MIGRATION = (1 << 1),
+  /* Each rectangle keeps its own mipmap levels. The rectangles are
+     aligned so that the first COGL_ATLAS_MIPMAP_LEVELS levels of a
+     rectangle never share a texel with its neighbours */
+  COGL_ATLAS_MIPMAPPED         = (1 << 2)
 } CoglAtlasFlags;
 
+#define COGL_ATLAS_MIPMAP_LEVELS 4
+#define COGL_ATLAS_MIPMAP_ALIGNMENT (1 << COGL_ATLAS_MIPMAP_LEVELS)
+
 typedef struct _CoglAtlas CoglAtlas;
 
 #define COGL_ATLAS(object) ((CoglAtlas *) object)
@@ -79,6 +86,24 @@ void
 _cogl_atlas_remove (CoglAtlas *atlas,
                     const CoglRectangleMapEntry *rectangle);
 
+/*
+ * _cogl_atlas_update_mipmaps:
+ * @atlas: A #CoglAtlas created with %COGL_ATLAS_MIPMAPPED
+ * @rectangle: The position of a rectangle in the atlas
+ * @data: The pixels of the whole rectangle in the format of the atlas
+ *   texture, including the border
+ * @rowstride: The rowstride of @data
+ *
+ * Builds the mipmap levels of one rectangle from @data with a box
+ * filter and uploads them to the atlas texture. Only the texels of
+ * the rectangle are read so the levels are clamped to its edges.
+ */
+void
+_cogl_atlas_update_mipmaps (CoglAtlas *atlas,
+                            const CoglRectangleMapEntry *rectangle,
+                            const uint8_t *data,
+                            int rowstride);
+
 CoglTexture *
 _cogl_atlas_copy_rectangle (CoglAtlas *atlas,
                             int x,
@@ -75,6 +75,9 @@ struct _CoglAttribute
       size_t offset;
       int n_components;
       CoglAttributeType type;
+      /* Zero for per-vertex attributes. Otherwise the number of
+         instances drawn per element of the buffer */
+      int instance_divisor;
     } buffered;
     struct {
       CoglContext *context;
@@ -246,6 +246,7 @@ cogl_attribute_new (CoglAttributeBuffer *attribute_buffer,
   attribute->d.buffered.offset = offset;
   attribute->d.buffered.n_components = n_components;
   attribute->d.buffered.type = type;
+  attribute->d.buffered.instance_divisor = 0;
 
   attribute->immutable_ref = 0;
 
@@ -486,6 +487,16 @@ warn_about_midscene_changes (void)
     }
 }
 
+/* Batched primitives in the journal reference the attribute so any
+ * changes need to wait until they are drawn */
+static void
+attribute_pre_change_notify (CoglAttribute *attribute)
+{
+  if (attribute->is_buffered)
+    _cogl_buffer_pre_change_notify
+      (COGL_BUFFER (attribute->d.buffered.attribute_buffer));
+}
+
 void
 cogl_attribute_set_normalized (CoglAttribute *attribute,
                                       CoglBool normalized)
@@ -495,9 +506,38 @@ cogl_attribute_set_normalized (CoglAttribute *attribute,
   if (G_UNLIKELY (attribute->immutable_ref))
     warn_about_midscene_changes ();
 
+  attribute_pre_change_notify (attribute);
+
   attribute->normalized = normalized;
 }
 
+int
+cogl_attribute_get_instance_divisor (CoglAttribute *attribute)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_attribute (attribute), 0);
+
+  if (!attribute->is_buffered)
+    return 0;
+
+  return attribute->d.buffered.instance_divisor;
+}
+
+void
+cogl_attribute_set_instance_divisor (CoglAttribute *attribute,
+                                     int divisor)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_attribute (attribute));
+  _COGL_RETURN_IF_FAIL (attribute->is_buffered);
+  _COGL_RETURN_IF_FAIL (divisor >= 0);
+
+  if (G_UNLIKELY (attribute->immutable_ref))
+    warn_about_midscene_changes ();
+
+  attribute_pre_change_notify (attribute);
+
+  attribute->d.buffered.instance_divisor = divisor;
+}
+
 CoglAttributeBuffer *
 cogl_attribute_get_buffer (CoglAttribute *attribute)
 {
@@ -517,6 +557,8 @@ cogl_attribute_set_buffer (CoglAttribute *attribute,
   if (G_UNLIKELY (attribute->immutable_ref))
     warn_about_midscene_changes ();
 
+  attribute_pre_change_notify (attribute);
+
   cogl_object_ref (attribute_buffer);
 
   cogl_object_unref (attribute->d.buffered.attribute_buffer);
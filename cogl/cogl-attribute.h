@@ -500,6 +500,44 @@ cogl_attribute_set_normalized (CoglAttribute *attribute,
 CoglBool
 cogl_attribute_get_normalized (CoglAttribute *attribute);
 
+/**
+ * cogl_attribute_set_instance_divisor:
+ * @attribute: A #CoglAttribute
+ * @divisor: The number of instances drawn before advancing to the
+ *   next element of the attribute or 0
+ *
+ * Sets how the attribute advances when a primitive is drawn with
+ * cogl_primitive_draw_instanced(). If @divisor is 0, which is the
+ * default, then the attribute is a regular per-vertex attribute and
+ * the same values are used for every instance. Otherwise the
+ * attribute is a per-instance attribute and each vertex of an
+ * instance gets the same value. The value only advances to the next
+ * element of the buffer after @divisor instances have been drawn.
+ *
+ * This can only be used on attributes that have a
+ * #CoglAttributeBuffer and it requires the
+ * %COGL_FEATURE_ID_INSTANCED_DRAWING feature.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_attribute_set_instance_divisor (CoglAttribute *attribute,
+                                     int divisor);
+
+/**
+ * cogl_attribute_get_instance_divisor:
+ * @attribute: A #CoglAttribute
+ *
+ * Return value: the value set with
+ * cogl_attribute_set_instance_divisor().
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+int
+cogl_attribute_get_instance_divisor (CoglAttribute *attribute);
+
 /**
  * cogl_attribute_get_buffer:
  * @attribute: A #CoglAttribute
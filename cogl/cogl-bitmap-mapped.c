@@ -0,0 +1,608 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+
+#include <test-fixtures/test-unit.h>
+
+#include "cogl-util.h"
+#include "cogl-private.h"
+#include "cogl-bitmap-private.h"
+#include "cogl-mapped-file-private.h"
+#include "cogl-error-private.h"
+
+/*
+ * Netpbm
+ */
+
+typedef struct
+{
+  const uint8_t *data;
+  size_t size;
+  size_t pos;
+} CoglHeaderReader;
+
+typedef enum
+{
+  COGL_NETPBM_HEADER_OK,
+  /* The header couldn't be parsed or describes an image that needs
+     converting. Another loader might still be able to handle it */
+  COGL_NETPBM_HEADER_UNSUPPORTED,
+  /* The header is fine but the file is too short for the pixels */
+  COGL_NETPBM_HEADER_TRUNCATED
+} CoglNetpbmHeaderResult;
+
+static void
+skip_space_and_comments (CoglHeaderReader *reader)
+{
+  while (reader->pos < reader->size)
+    {
+      uint8_t c = reader->data[reader->pos];
+
+      if (c == '#')
+        {
+          while (reader->pos < reader->size &&
+                 reader->data[reader->pos] != '\n')
+            reader->pos++;
+        }
+      else if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+        reader->pos++;
+      else
+        break;
+    }
+}
+
+static CoglBool
+read_number (CoglHeaderReader *reader,
+             int *value_out)
+{
+  int value = 0;
+  size_t start;
+
+  skip_space_and_comments (reader);
+
+  start = reader->pos;
+
+  while (reader->pos < reader->size &&
+         g_ascii_isdigit (reader->data[reader->pos]))
+    {
+      int digit = reader->data[reader->pos++] - '0';
+
+      if (value > (INT_MAX - digit) / 10)
+        return FALSE;
+
+      value = value * 10 + digit;
+    }
+
+  *value_out = value;
+
+  return reader->pos > start;
+}
+
+static CoglBool
+read_word (CoglHeaderReader *reader,
+           char *buf,
+           int buf_size)
+{
+  int len = 0;
+
+  skip_space_and_comments (reader);
+
+  while (reader->pos < reader->size &&
+         !g_ascii_isspace (reader->data[reader->pos]))
+    {
+      if (len + 1 >= buf_size)
+        return FALSE;
+      buf[len++] = reader->data[reader->pos++];
+    }
+
+  buf[len] = '\0';
+
+  return len > 0;
+}
+
+static CoglBool
+parse_pam_header (CoglHeaderReader *reader,
+                  int *width,
+                  int *height,
+                  int *depth,
+                  int *maxval)
+{
+  *width = *height = *depth = *maxval = -1;
+
+  while (TRUE)
+    {
+      char word[16];
+
+      if (!read_word (reader, word, sizeof (word)))
+        return FALSE;
+
+      if (!strcmp (word, "ENDHDR"))
+        break;
+      else if (!strcmp (word, "WIDTH"))
+        {
+          if (!read_number (reader, width))
+            return FALSE;
+        }
+      else if (!strcmp (word, "HEIGHT"))
+        {
+          if (!read_number (reader, height))
+            return FALSE;
+        }
+      else if (!strcmp (word, "DEPTH"))
+        {
+          if (!read_number (reader, depth))
+            return FALSE;
+        }
+      else if (!strcmp (word, "MAXVAL"))
+        {
+          if (!read_number (reader, maxval))
+            return FALSE;
+        }
+      else if (!strcmp (word, "TUPLTYPE"))
+        {
+          /* The depth is enough to determine the format */
+          while (reader->pos < reader->size &&
+                 reader->data[reader->pos] != '\n')
+            reader->pos++;
+        }
+      else
+        return FALSE;
+    }
+
+  return *width >= 0 && *height >= 0 && *depth >= 0 && *maxval >= 0;
+}
+
+/* Parses the header of a binary PGM (P5), PPM (P6) or PAM (P7)
+ * file. Only 8-bit RGB and RGBA images can be used straight from the
+ * mapping. Grayscale images need expanding to RGB so they are left
+ * for the regular image loader */
+static CoglNetpbmHeaderResult
+parse_netpbm_header (const uint8_t *data,
+                     size_t size,
+                     int *width_out,
+                     int *height_out,
+                     CoglPixelFormat *format_out,
+                     size_t *data_offset_out)
+{
+  CoglHeaderReader reader;
+  int width, height, depth, maxval;
+
+  if (size < 2 || data[0] != 'P')
+    return COGL_NETPBM_HEADER_UNSUPPORTED;
+
+  reader.data = data;
+  reader.size = size;
+  reader.pos = 2;
+
+  switch (data[1])
+    {
+    case '5':
+    case '6':
+      depth = data[1] == '5' ? 1 : 3;
+
+      if (!read_number (&reader, &width) ||
+          !read_number (&reader, &height) ||
+          !read_number (&reader, &maxval))
+        return COGL_NETPBM_HEADER_UNSUPPORTED;
+
+      /* Exactly one whitespace character separates the header from
+         the pixels */
+      if (reader.pos >= size || !g_ascii_isspace (data[reader.pos]))
+        return COGL_NETPBM_HEADER_UNSUPPORTED;
+      reader.pos++;
+      break;
+
+    case '7':
+      if (!parse_pam_header (&reader, &width, &height, &depth, &maxval))
+        return COGL_NETPBM_HEADER_UNSUPPORTED;
+
+      if (reader.pos >= size || data[reader.pos] != '\n')
+        return COGL_NETPBM_HEADER_UNSUPPORTED;
+      reader.pos++;
+      break;
+
+    default:
+      return COGL_NETPBM_HEADER_UNSUPPORTED;
+    }
+
+  if (maxval != 255 || width <= 0 || height <= 0)
+    return COGL_NETPBM_HEADER_UNSUPPORTED;
+
+  switch (depth)
+    {
+    case 3:
+      *format_out = COGL_PIXEL_FORMAT_RGB_888;
+      break;
+    case 4:
+      *format_out = COGL_PIXEL_FORMAT_RGBA_8888;
+      break;
+    default:
+      return COGL_NETPBM_HEADER_UNSUPPORTED;
+    }
+
+  if ((size - reader.pos) / height / depth < width)
+    return COGL_NETPBM_HEADER_TRUNCATED;
+
+  *width_out = width;
+  *height_out = height;
+  *data_offset_out = reader.pos;
+
+  return COGL_NETPBM_HEADER_OK;
+}
+
+static CoglBool
+file_is_netpbm (const char *filename)
+{
+  char magic[2];
+  CoglBool ret = FALSE;
+  FILE *file;
+
+  file = fopen (filename, "rb");
+  if (file == NULL)
+    return FALSE;
+
+  if (fread (magic, 1, sizeof (magic), file) == sizeof (magic) &&
+      magic[0] == 'P' && magic[1] >= '5' && magic[1] <= '7')
+    ret = TRUE;
+
+  fclose (file);
+
+  return ret;
+}
+
+CoglBool
+_cogl_bitmap_map_netpbm_file (const char *filename,
+                              CoglDecodedImage *image,
+                              CoglError **error)
+{
+  CoglMappedFile *file;
+  CoglPixelFormat format;
+  size_t data_offset;
+  int width, height;
+
+  if (!file_is_netpbm (filename))
+    return FALSE;
+
+  file = _cogl_mapped_file_new (filename, error);
+  if (file == NULL)
+    return FALSE;
+
+  switch (parse_netpbm_header (file->data, file->size,
+                               &width, &height,
+                               &format,
+                               &data_offset))
+    {
+    case COGL_NETPBM_HEADER_OK:
+      break;
+
+    case COGL_NETPBM_HEADER_UNSUPPORTED:
+      /* Let the regular image loader try it. It might be able to
+         convert formats such as 16-bit images that can't be used
+         straight from the mapping */
+      _cogl_mapped_file_free (file);
+      return FALSE;
+
+    case COGL_NETPBM_HEADER_TRUNCATED:
+      _cogl_mapped_file_free (file);
+      _cogl_set_error (error,
+                       COGL_BITMAP_ERROR,
+                       COGL_BITMAP_ERROR_CORRUPT_IMAGE,
+                       "%s is too short for the image size in its header",
+                       filename);
+      return FALSE;
+    }
+
+  /* The pixels are used straight out of the mapping. The pages
+   * won't be read from disk until something touches them */
+  image->width = width;
+  image->height = height;
+  image->format = format;
+  image->rowstride = width * _cogl_pixel_format_get_bytes_per_pixel (format);
+  image->data = file->data + data_offset;
+  image->destroy = (GDestroyNotify) _cogl_mapped_file_free;
+  image->destroy_data = file;
+
+  return TRUE;
+}
+
+/*
+ * PNG and JPEG headers
+ */
+
+static uint32_t
+read_uint32_be (const uint8_t *p)
+{
+  return (((uint32_t) p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3]);
+}
+
+/* Looks for a tRNS chunk. It has to come before the image data so
+ * only the chunk headers up to the first IDAT need to be read */
+static CoglBool
+png_has_transparency_chunk (const uint8_t *data,
+                            size_t size)
+{
+  size_t pos = 8;
+
+  while (size - pos >= 8)
+    {
+      uint32_t length = read_uint32_be (data + pos);
+      const uint8_t *type = data + pos + 4;
+
+      if (!memcmp (type, "tRNS", 4))
+        return TRUE;
+      else if (!memcmp (type, "IDAT", 4) || !memcmp (type, "IEND", 4))
+        return FALSE;
+
+      /* Skip the length, type, data and crc */
+      if (size - pos < 12 || length > size - pos - 12)
+        return FALSE;
+      pos += length + 12;
+    }
+
+  return FALSE;
+}
+
+static CoglBool
+get_png_info (const uint8_t *data,
+              size_t size,
+              int *width,
+              int *height,
+              int *n_components)
+{
+  static const uint8_t png_signature[8] =
+    { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+  uint32_t png_width, png_height;
+
+  /* The IHDR chunk is always first */
+  if (size < 33 ||
+      memcmp (data, png_signature, sizeof (png_signature)) ||
+      memcmp (data + 12, "IHDR", 4))
+    return FALSE;
+
+  png_width = read_uint32_be (data + 16);
+  png_height = read_uint32_be (data + 20);
+
+  if (png_width == 0 || png_height == 0 ||
+      png_width > (1 << 24) || png_height > (1 << 24))
+    return FALSE;
+
+  switch (data[25])
+    {
+    case 0: /* grayscale */
+      /* A tRNS chunk gives a grayscale image an alpha channel. There
+         is no luminance-alpha format so it is expanded to RGBA the
+         same way as grayscale with alpha */
+      *n_components = png_has_transparency_chunk (data, size) ? 4 : 1;
+      break;
+    case 2: /* truecolor */
+      *n_components = png_has_transparency_chunk (data, size) ? 4 : 3;
+      break;
+    case 3: /* palette, which might have a tRNS chunk later */
+    case 4: /* grayscale with alpha */
+    case 6: /* truecolor with alpha */
+      *n_components = 4;
+      break;
+    default:
+      return FALSE;
+    }
+
+  *width = png_width;
+  *height = png_height;
+
+  return TRUE;
+}
+
+static CoglBool
+get_jpeg_info (const uint8_t *data,
+               size_t size,
+               int *width,
+               int *height,
+               int *n_components)
+{
+  size_t pos = 2;
+
+  if (size < 4 || data[0] != 0xff || data[1] != 0xd8)
+    return FALSE;
+
+  /* Walk the markers until we find the start of frame */
+  while (pos + 4 <= size)
+    {
+      uint8_t marker;
+      size_t length;
+
+      if (data[pos] != 0xff)
+        return FALSE;
+
+      marker = data[pos + 1];
+
+      /* Fill bytes */
+      if (marker == 0xff)
+        {
+          pos++;
+          continue;
+        }
+
+      length = (data[pos + 2] << 8) | data[pos + 3];
+
+      /* Baseline, extended and progressive huffman frames are the
+         only ones that stb_image can decode */
+      if (marker == 0xc0 || marker == 0xc1 || marker == 0xc2)
+        {
+          if (length < 8 || pos + 2 + length > size)
+            return FALSE;
+
+          *height = (data[pos + 5] << 8) | data[pos + 6];
+          *width = (data[pos + 7] << 8) | data[pos + 8];
+          *n_components = data[pos + 9];
+
+          return (*width > 0 && *height > 0 &&
+                  (*n_components == 1 || *n_components == 3));
+        }
+      else if (marker == 0xd9 || marker == 0xda)
+        /* End of image or start of scan before any frame header */
+        return FALSE;
+
+      pos += 2 + length;
+    }
+
+  return FALSE;
+}
+
+CoglBool
+_cogl_bitmap_get_encoded_image_info (const uint8_t *data,
+                                     size_t size,
+                                     int *width,
+                                     int *height,
+                                     int *n_components)
+{
+  return (get_png_info (data, size, width, height, n_components) ||
+          get_jpeg_info (data, size, width, height, n_components));
+}
+
+UNIT_TEST (check_netpbm_header_parsing,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  static const char ppm[] = "P6\n# a comment\n2 1\n255\nabcdef";
+  static const char ppm16[] = "P6\n1 1\n65535\nabcdef";
+  static const char pgm[] = "P5\n2 1\n255\nab";
+  static const char pam[] =
+    "P7\nWIDTH 1\nHEIGHT 2\nDEPTH 4\nMAXVAL 255\n"
+    "TUPLTYPE RGB_ALPHA\nENDHDR\nabcdefgh";
+  CoglPixelFormat format;
+  size_t offset;
+  int width, height;
+
+  g_assert_cmpint (parse_netpbm_header ((const uint8_t *) ppm,
+                                        sizeof (ppm) - 1,
+                                        &width, &height, &format, &offset),
+                   ==,
+                   COGL_NETPBM_HEADER_OK);
+  g_assert_cmpint (width, ==, 2);
+  g_assert_cmpint (height, ==, 1);
+  g_assert_cmpint (format, ==, COGL_PIXEL_FORMAT_RGB_888);
+  g_assert_cmpint (ppm[offset], ==, 'a');
+
+  /* Not enough data for the pixels */
+  g_assert_cmpint (parse_netpbm_header ((const uint8_t *) ppm,
+                                        sizeof (ppm) - 2,
+                                        &width, &height, &format, &offset),
+                   ==,
+                   COGL_NETPBM_HEADER_TRUNCATED);
+
+  /* 16-bit images are left for the regular image loader */
+  g_assert_cmpint (parse_netpbm_header ((const uint8_t *) ppm16,
+                                        sizeof (ppm16) - 1,
+                                        &width, &height, &format, &offset),
+                   ==,
+                   COGL_NETPBM_HEADER_UNSUPPORTED);
+
+  /* Grayscale images would need expanding to RGB */
+  g_assert_cmpint (parse_netpbm_header ((const uint8_t *) pgm,
+                                        sizeof (pgm) - 1,
+                                        &width, &height, &format, &offset),
+                   ==,
+                   COGL_NETPBM_HEADER_UNSUPPORTED);
+
+  g_assert_cmpint (parse_netpbm_header ((const uint8_t *) pam,
+                                        sizeof (pam) - 1,
+                                        &width, &height, &format, &offset),
+                   ==,
+                   COGL_NETPBM_HEADER_OK);
+  g_assert_cmpint (width, ==, 1);
+  g_assert_cmpint (height, ==, 2);
+  g_assert_cmpint (format, ==, COGL_PIXEL_FORMAT_RGBA_8888);
+  g_assert_cmpint (pam[offset], ==, 'a');
+}
+
+UNIT_TEST (check_encoded_image_info,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  static const uint8_t png[33] =
+    {
+      0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n',
+      0, 0, 0, 13, 'I', 'H', 'D', 'R',
+      0, 0, 1, 0, /* width */
+      0, 0, 0, 64, /* height */
+      8, 2, 0, 0, 0, /* depth, color type, compression, filter, interlace */
+      0, 0, 0, 0 /* crc */
+    };
+  static const uint8_t png_trns[51] =
+    {
+      0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n',
+      0, 0, 0, 13, 'I', 'H', 'D', 'R',
+      0, 0, 0, 16, /* width */
+      0, 0, 0, 16, /* height */
+      8, 2, 0, 0, 0, /* depth, color type, compression, filter, interlace */
+      0, 0, 0, 0, /* crc */
+      0, 0, 0, 6, 't', 'R', 'N', 'S',
+      0, 0, 0, 0, 0, 0, /* transparent color */
+      0, 0, 0, 0 /* crc */
+    };
+  static const uint8_t jpeg[] =
+    {
+      0xff, 0xd8,
+      0xff, 0xe0, 0, 4, 0, 0, /* APP0 */
+      0xff, 0xc0, 0, 11, 8, 0, 32, 0, 48, 1, 1, 0x11, 0 /* SOF0 */
+    };
+  int width, height, n_components;
+
+  g_assert (_cogl_bitmap_get_encoded_image_info (png, sizeof (png),
+                                                 &width, &height,
+                                                 &n_components));
+  g_assert_cmpint (width, ==, 256);
+  g_assert_cmpint (height, ==, 64);
+  g_assert_cmpint (n_components, ==, 3);
+
+  /* A transparent color key adds an alpha channel */
+  g_assert (_cogl_bitmap_get_encoded_image_info (png_trns, sizeof (png_trns),
+                                                 &width, &height,
+                                                 &n_components));
+  g_assert_cmpint (n_components, ==, 4);
+
+  g_assert (_cogl_bitmap_get_encoded_image_info (jpeg, sizeof (jpeg),
+                                                 &width, &height,
+                                                 &n_components));
+  g_assert_cmpint (width, ==, 48);
+  g_assert_cmpint (height, ==, 32);
+  g_assert_cmpint (n_components, ==, 1);
+
+  g_assert (!_cogl_bitmap_get_encoded_image_info (png, 20,
+                                                  &width, &height,
+                                                  &n_components));
+}
@@ -63,10 +63,10 @@ _cogl_bitmap_get_size_from_file (const char *filename,
 }
 
 /* the error does not contain the filename as the caller already has it */
-CoglBitmap *
-_cogl_bitmap_from_file (CoglContext *ctx,
-                        const char *filename,
-			CoglError **error)
+CoglBool
+_cogl_bitmap_decode_image_file (const char *filename,
+                                CoglDecodedImage *decoded,
+                                CoglError **error)
 {
   CFURLRef url;
   CGImageSourceRef image_source;
@@ -77,7 +77,6 @@ _cogl_bitmap_from_file (CoglContext *ctx,
   uint8_t *out_data;
   CGColorSpaceRef color_space;
   CGContextRef bitmap_context;
-  CoglBitmap *bmp;
 
   url = CFURLCreateFromFileSystemRepresentation (NULL,
                                                  (guchar *) filename,
@@ -94,7 +93,7 @@ _cogl_bitmap_from_file (CoglContext *ctx,
                                COGL_BITMAP_ERROR,
                                COGL_BITMAP_ERROR_FAILED,
                                g_strerror (save_errno));
-      return NULL;
+      return FALSE;
     }
 
   /* Unknown images would be cleanly caught as zero width/height below, but try
@@ -108,7 +107,7 @@ _cogl_bitmap_from_file (CoglContext *ctx,
                                COGL_BITMAP_ERROR,
                                COGL_BITMAP_ERROR_UNKNOWN_TYPE,
                                "Unknown image type");
-      return NULL;
+      return FALSE;
     }
 
   CFRelease (type);
@@ -126,29 +125,20 @@ _cogl_bitmap_from_file (CoglContext *ctx,
                                COGL_BITMAP_ERROR,
                                COGL_BITMAP_ERROR_CORRUPT_IMAGE,
                                "Image has zero width or height");
-      return NULL;
+      return FALSE;
     }
 
   /* allocate buffer big enough to hold pixel data */
-  bmp = _cogl_bitmap_new_with_malloc_buffer (ctx,
-                                             width, height,
-                                             COGL_PIXEL_FORMAT_ARGB_8888,
-                                             error);
-  if (bmp == NULL)
-    {
-      CFRelease (image);
-      return NULL;
-    }
-  rowstride = cogl_bitmap_get_rowstride (bmp);
-  out_data = _cogl_bitmap_map (bmp,
-                               COGL_BUFFER_ACCESS_WRITE,
-                               COGL_BUFFER_MAP_HINT_DISCARD,
-                               error);
+  rowstride = width * 4;
+  out_data = g_try_malloc (rowstride * height);
   if (out_data == NULL)
     {
-      cogl_object_unref (bmp);
       CFRelease (image);
-      return NULL;
+      _cogl_set_error_literal (error,
+                               COGL_BITMAP_ERROR,
+                               COGL_BITMAP_ERROR_FAILED,
+                               "Failed to allocate memory for the image");
+      return FALSE;
     }
 
   /* render to buffer */
@@ -170,10 +160,28 @@ _cogl_bitmap_from_file (CoglContext *ctx,
   CGImageRelease (image);
   CGContextRelease (bitmap_context);
 
-  _cogl_bitmap_unmap (bmp);
+  decoded->width = width;
+  decoded->height = height;
+  decoded->format = COGL_PIXEL_FORMAT_ARGB_8888;
+  decoded->rowstride = rowstride;
+  decoded->data = out_data;
+  decoded->destroy = g_free;
+  decoded->destroy_data = out_data;
 
-  /* store bitmap info */
-  return bmp;
+  return TRUE;
+}
+
+CoglBitmap *
+_cogl_bitmap_from_file (CoglContext *ctx,
+                        const char *filename,
+			CoglError **error)
+{
+  CoglDecodedImage decoded;
+
+  if (!_cogl_bitmap_decode_image_file (filename, &decoded, error))
+    return NULL;
+
+  return _cogl_bitmap_new_from_decoded_image (ctx, &decoded);
 }
 
 #elif defined(USE_GDKPIXBUF)
@@ -191,12 +199,11 @@ _cogl_bitmap_get_size_from_file (const char *filename,
   return FALSE;
 }
 
-CoglBitmap *
-_cogl_bitmap_from_file (CoglContext *ctx,
-                        const char *filename,
-			CoglError **error)
+CoglBool
+_cogl_bitmap_decode_image_file (const char *filename,
+                                CoglDecodedImage *decoded,
+                                CoglError **error)
 {
-  static CoglUserDataKey pixbuf_key;
   GdkPixbuf *pixbuf;
   CoglBool has_alpha;
   GdkColorspace color_space;
@@ -206,7 +213,6 @@ _cogl_bitmap_from_file (CoglContext *ctx,
   int rowstride;
   int bits_per_sample;
   int n_channels;
-  CoglBitmap *bmp;
   GError *glib_error = NULL;
 
   /* Load from file using GdkPixbuf */
@@ -256,35 +262,71 @@ _cogl_bitmap_from_file (CoglContext *ctx,
      to read past the end of bpp*width on the last row even if the
      rowstride is much larger so we don't need to worry about
      GdkPixbuf's semantics that it may under-allocate the buffer. */
-  bmp = cogl_bitmap_new_for_data (ctx,
-                                  width,
-                                  height,
-                                  pixel_format,
-                                  rowstride,
-                                  gdk_pixbuf_get_pixels (pixbuf));
-
-  cogl_object_set_user_data (COGL_OBJECT (bmp),
-                             &pixbuf_key,
-                             pixbuf,
-                             g_object_unref);
+  decoded->width = width;
+  decoded->height = height;
+  decoded->format = pixel_format;
+  decoded->rowstride = rowstride;
+  decoded->data = gdk_pixbuf_get_pixels (pixbuf);
+  decoded->destroy = g_object_unref;
+  decoded->destroy_data = pixbuf;
 
-  return bmp;
+  return TRUE;
+}
+
+CoglBitmap *
+_cogl_bitmap_from_file (CoglContext *ctx,
+                        const char *filename,
+			CoglError **error)
+{
+  CoglDecodedImage decoded;
+
+  if (!_cogl_bitmap_decode_image_file (filename, &decoded, error))
+    return NULL;
+
+  return _cogl_bitmap_new_from_decoded_image (ctx, &decoded);
 }
 
 #else
 
 #include "stb_image.c"
+#include "cogl-mapped-file-private.h"
+
+/* State for a bitmap whose file is kept mapped until the first time
+ * the pixels are needed */
+typedef struct
+{
+  CoglMappedFile *file;
+  int n_components;
+} CoglLazyImage;
 
 CoglBool
 _cogl_bitmap_get_size_from_file (const char *filename,
                                  int        *width,
                                  int        *height)
 {
+  CoglMappedFile *file;
+  int file_width = 0, file_height = 0, n_components;
+
+  /* Only the header needs to be read so the rest of the mapping is
+   * never touched */
+  file = _cogl_mapped_file_new (filename, NULL);
+  if (file)
+    {
+      if (!_cogl_bitmap_get_encoded_image_info (file->data,
+                                                file->size,
+                                                &file_width,
+                                                &file_height,
+                                                &n_components))
+        file_width = file_height = 0;
+
+      _cogl_mapped_file_free (file);
+    }
+
   if (width)
-    *width = 0;
+    *width = file_width;
 
   if (height)
-    *height = 0;
+    *height = file_height;
 
   return TRUE;
 }
@@ -308,7 +350,7 @@ convert_ra_88_to_rgba_8888 (uint8_t *pixels,
   size_t out_stride = width * 4;
 
   buf = malloc (width * height * 4);
-  if (buf)
+  if (buf == NULL)
     return NULL;
 
   for (y = 0; y < height; y++)
@@ -326,18 +368,15 @@ convert_ra_88_to_rgba_8888 (uint8_t *pixels,
   return buf;
 }
 
-static CoglBitmap *
-_cogl_bitmap_new_from_stb_pixels (CoglContext *ctx,
-                                  uint8_t *pixels,
-                                  int stb_pixel_format,
-                                  int width,
-                                  int height,
-                                  CoglError **error)
+static CoglBool
+decode_stb_pixels (uint8_t *pixels,
+                   int stb_pixel_format,
+                   int width,
+                   int height,
+                   CoglDecodedImage *decoded,
+                   CoglError **error)
 {
-  static CoglUserDataKey bitmap_data_key;
-  CoglBitmap *bmp;
   CoglPixelFormat cogl_format;
-  size_t stride;
 
   if (pixels == NULL)
     {
@@ -345,7 +384,7 @@ _cogl_bitmap_new_from_stb_pixels (CoglContext *ctx,
                                COGL_BITMAP_ERROR,
                                COGL_BITMAP_ERROR_FAILED,
                                "Failed to load image with stb image library");
-      return NULL;
+      return FALSE;
     }
 
   switch (stb_pixel_format)
@@ -367,7 +406,7 @@ _cogl_bitmap_new_from_stb_pixels (CoglContext *ctx,
                                      COGL_BITMAP_ERROR_FAILED,
                                      "Failed to alloc memory to convert "
                                      "gray_alpha to rgba8888");
-            return NULL;
+            return FALSE;
           }
 
         cogl_format = COGL_PIXEL_FORMAT_RGBA_8888;
@@ -382,23 +421,153 @@ _cogl_bitmap_new_from_stb_pixels (CoglContext *ctx,
 
     default:
       g_warn_if_reached ();
+      free (pixels);
+      return FALSE;
+    }
+
+  decoded->width = width;
+  decoded->height = height;
+  decoded->format = cogl_format;
+  decoded->rowstride =
+    width * _cogl_pixel_format_get_bytes_per_pixel (cogl_format);
+  decoded->data = pixels;
+  decoded->destroy = free;
+  decoded->destroy_data = pixels;
+
+  return TRUE;
+}
+
+static CoglBitmap *
+_cogl_bitmap_new_from_stb_pixels (CoglContext *ctx,
+                                  uint8_t *pixels,
+                                  int stb_pixel_format,
+                                  int width,
+                                  int height,
+                                  CoglError **error)
+{
+  CoglDecodedImage decoded;
+
+  if (!decode_stb_pixels (pixels, stb_pixel_format,
+                          width, height,
+                          &decoded,
+                          error))
+    return NULL;
+
+  return _cogl_bitmap_new_from_decoded_image (ctx, &decoded);
+}
+
+static void
+lazy_image_free (void *user_data)
+{
+  CoglLazyImage *image = user_data;
+
+  _cogl_mapped_file_free (image->file);
+  g_slice_free (CoglLazyImage, image);
+}
+
+static uint8_t *
+decode_lazy_image_cb (CoglBitmap *bitmap,
+                      void *user_data,
+                      GDestroyNotify *data_destroy,
+                      CoglError **error)
+{
+  CoglLazyImage *image = user_data;
+  int stb_pixel_format;
+  int width;
+  int height;
+  uint8_t *pixels;
+
+  pixels = stbi_load_from_memory (image->file->data,
+                                  image->file->size,
+                                  &width, &height, &stb_pixel_format,
+                                  image->n_components);
+
+  if (pixels == NULL)
+    {
+      _cogl_set_error_literal (error,
+                               COGL_BITMAP_ERROR,
+                               COGL_BITMAP_ERROR_FAILED,
+                               "Failed to load image with stb image library");
       return NULL;
     }
 
-  stride = width * _cogl_pixel_format_get_bytes_per_pixel (cogl_format);
+  if (width != cogl_bitmap_get_width (bitmap) ||
+      height != cogl_bitmap_get_height (bitmap))
+    {
+      free (pixels);
+      _cogl_set_error_literal (error,
+                               COGL_BITMAP_ERROR,
+                               COGL_BITMAP_ERROR_CORRUPT_IMAGE,
+                               "The image size doesn't match the header");
+      return NULL;
+    }
 
-  /* Store bitmap info */
-  bmp = cogl_bitmap_new_for_data (ctx,
-                                  width, height,
-                                  cogl_format,
-                                  stride,
-                                  pixels);
+  *data_destroy = free;
 
-  /* Register a destroy function so the pixel data will be freed
-     automatically when the bitmap object is destroyed */
-  cogl_object_set_user_data (COGL_OBJECT (bmp), &bitmap_data_key, pixels, free);
+  return pixels;
+}
 
-  return bmp;
+static CoglMappedFile *
+map_image_file (const char *filename,
+                CoglError **error)
+{
+  CoglMappedFile *file;
+
+  file = _cogl_mapped_file_new (filename, error);
+  if (file == NULL)
+    return NULL;
+
+  if (file->size > G_MAXINT32)
+    {
+      _cogl_mapped_file_free (file);
+      _cogl_set_error_literal (error,
+                               COGL_BITMAP_ERROR,
+                               COGL_BITMAP_ERROR_FAILED,
+                               "The image file is too large");
+      return NULL;
+    }
+
+  return file;
+}
+
+CoglBool
+_cogl_bitmap_decode_image_file (const char *filename,
+                                CoglDecodedImage *decoded,
+                                CoglError **error)
+{
+  CoglMappedFile *file;
+  int stb_pixel_format;
+  int width;
+  int height;
+  int n_components;
+  int req_comp = STBI_default;
+  uint8_t *pixels;
+
+  file = map_image_file (filename, error);
+  if (file == NULL)
+    return FALSE;
+
+  /* stb_image reports the wrong number of components for images
+   * with a tRNS chunk unless a specific number is requested so this
+   * uses the same number that a lazily decoded bitmap would */
+  if (_cogl_bitmap_get_encoded_image_info (file->data, file->size,
+                                           &width, &height,
+                                           &n_components))
+    req_comp = n_components;
+
+  pixels = stbi_load_from_memory (file->data, file->size,
+                                  &width, &height, &stb_pixel_format,
+                                  req_comp);
+
+  if (req_comp != STBI_default)
+    stb_pixel_format = req_comp;
+
+  _cogl_mapped_file_free (file);
+
+  return decode_stb_pixels (pixels, stb_pixel_format,
+                            width, height,
+                            decoded,
+                            error);
 }
 
 CoglBitmap *
@@ -406,14 +575,57 @@ _cogl_bitmap_from_file (CoglContext *ctx,
                         const char *filename,
 			CoglError **error)
 {
+  CoglMappedFile *file;
   int stb_pixel_format;
   int width;
   int height;
+  int n_components;
   uint8_t *pixels;
 
-  pixels = stbi_load (filename,
-                      &width, &height, &stb_pixel_format,
-                      STBI_default);
+  file = map_image_file (filename, error);
+  if (file == NULL)
+    return NULL;
+
+  /* If the size and format can be determined from the header then
+   * decoding is deferred until the pixels are first needed. Until
+   * then the file is only kept mapped. */
+  if (_cogl_bitmap_get_encoded_image_info (file->data, file->size,
+                                           &width, &height,
+                                           &n_components))
+    {
+      CoglLazyImage *image = g_slice_new (CoglLazyImage);
+      CoglPixelFormat format;
+
+      image->file = file;
+      image->n_components = n_components;
+
+      switch (n_components)
+        {
+        case 1:
+          format = COGL_PIXEL_FORMAT_A_8;
+          break;
+        case 3:
+          format = COGL_PIXEL_FORMAT_RGB_888;
+          break;
+        default:
+          format = COGL_PIXEL_FORMAT_RGBA_8888;
+          break;
+        }
+
+      return _cogl_bitmap_new_lazy (ctx,
+                                    width, height,
+                                    format,
+                                    width * n_components,
+                                    decode_lazy_image_cb,
+                                    image,
+                                    lazy_image_free);
+    }
+
+  pixels = stbi_load_from_memory (file->data, file->size,
+                                  &width, &height, &stb_pixel_format,
+                                  STBI_default);
+
+  _cogl_mapped_file_free (file);
 
   return _cogl_bitmap_new_from_stb_pixels (ctx, pixels, stb_pixel_format,
                                            width, height,
@@ -41,6 +41,31 @@
 #include <android/asset_manager.h>
 #endif
 
+/* Called the first time a lazily loaded bitmap is mapped. This may
+ * happen in a worker thread so it must not touch any Cogl objects. It
+ * should return the decoded pixels and set @data_destroy to a
+ * function that the bitmap will use to free them */
+typedef uint8_t *
+(* CoglBitmapLoadCallback) (CoglBitmap *bitmap,
+                            void *user_data,
+                            GDestroyNotify *data_destroy,
+                            CoglError **error);
+
+/* The pixels of an image file that has been decoded without creating
+ * a CoglBitmap so that it can be done in a worker thread */
+typedef struct
+{
+  int width;
+  int height;
+  CoglPixelFormat format;
+  int rowstride;
+  uint8_t *data;
+
+  /* Called with destroy_data to free the pixels */
+  GDestroyNotify destroy;
+  void *destroy_data;
+} CoglDecodedImage;
+
 struct _CoglBitmap
 {
   CoglObject _parent;
@@ -65,6 +90,16 @@ struct _CoglBitmap
   /* If this is non-null then 'data' is treated as an offset into the
      buffer and map will divert to mapping the buffer */
   CoglBuffer *buffer;
+
+  /* If this is non-null then the pixels haven't been decoded yet and
+     'data' will be filled in by calling this when the bitmap is first
+     mapped */
+  CoglBitmapLoadCallback load_callback;
+  void *load_data;
+  GDestroyNotify load_data_destroy;
+
+  /* Frees 'data' once a lazily loaded bitmap has been decoded */
+  GDestroyNotify loaded_data_destroy;
 };
 
 
@@ -105,6 +140,117 @@ _cogl_bitmap_new_shared (CoglBitmap      *shared_bmp,
                          int              height,
                          int              rowstride);
 
+/*
+ * _cogl_bitmap_new_lazy:
+ * @context: A #CoglContext
+ * @width: width of the bitmap in pixels
+ * @height: height of the bitmap in pixels
+ * @format: the format that @callback will return the pixels in
+ * @rowstride: the rowstride of the pixels returned by @callback
+ * @callback: A #CoglBitmapLoadCallback to decode the pixels
+ * @user_data: Data to pass to @callback
+ * @destroy: A function to free @user_data or %NULL
+ *
+ * Creates a bitmap whose pixels are only decoded the first time it
+ * is mapped. This lets the image loaders return a bitmap for a file
+ * without decoding it if the size and format can be determined from
+ * the header. @user_data is destroyed as soon as the bitmap is
+ * loaded.
+ */
+CoglBitmap *
+_cogl_bitmap_new_lazy (CoglContext *context,
+                       int width,
+                       int height,
+                       CoglPixelFormat format,
+                       int rowstride,
+                       CoglBitmapLoadCallback callback,
+                       void *user_data,
+                       GDestroyNotify destroy);
+
+/* Makes sure the pixels of a lazily loaded bitmap have been
+ * decoded. This happens automatically when the bitmap is mapped */
+CoglBool
+_cogl_bitmap_ensure_loaded (CoglBitmap *bitmap,
+                            CoglError **error);
+
+/*
+ * _cogl_bitmap_map_netpbm_file:
+ * @filename: The file to load
+ * @image: A #CoglDecodedImage to fill in
+ * @error: A #CoglError return location
+ *
+ * Loads a binary PGM, PPM or PAM file by mapping it into memory.
+ * These formats store the raw pixels after a short header so the
+ * bitmap can use the mapping directly without copying it. If the file
+ * isn't in one of these formats, or it is a variant that would need
+ * converting such as a 16-bit image, then %NULL is returned without
+ * setting @error so that the caller can fall back to a regular image
+ * loader. @error is only set if the file can't be read or is too
+ * short for its header. This doesn't create any Cogl objects so it
+ * can be called from a worker thread.
+ *
+ * Return value: %TRUE if @image was filled in
+ */
+CoglBool
+_cogl_bitmap_map_netpbm_file (const char *filename,
+                              CoglDecodedImage *image,
+                              CoglError **error);
+
+/*
+ * _cogl_bitmap_decode_file:
+ * @filename: The file to load
+ * @image: A #CoglDecodedImage to fill in
+ * @error: A #CoglError return location
+ *
+ * Decodes all of the pixels of an image file straight away. This is
+ * the same as cogl_bitmap_new_from_file() except that nothing is left
+ * to be decoded lazily and no Cogl objects are created so it can be
+ * called from a worker thread. The result can be turned into a bitmap
+ * with _cogl_bitmap_new_from_decoded_image().
+ *
+ * Return value: %TRUE if @image was filled in
+ */
+CoglBool
+_cogl_bitmap_decode_file (const char *filename,
+                          CoglDecodedImage *image,
+                          CoglError **error);
+
+/*
+ * _cogl_bitmap_new_from_decoded_image:
+ * @context: A #CoglContext
+ * @image: A #CoglDecodedImage filled in by one of the decoders
+ *
+ * Creates a bitmap for the pixels of @image. The bitmap takes
+ * ownership of the pixels and will free them when it is destroyed.
+ */
+CoglBitmap *
+_cogl_bitmap_new_from_decoded_image (CoglContext *context,
+                                     CoglDecodedImage *image);
+
+/*
+ * _cogl_bitmap_get_encoded_image_info:
+ * @data: The contents of an image file
+ * @size: The size of @data in bytes
+ * @width: Return location for the width
+ * @height: Return location for the height
+ * @n_components: Return location for the number of components that
+ *   the decoded image will have
+ *
+ * Reads the header of a PNG or JPEG file without decoding the
+ * image. Palette PNGs are reported as having four components because
+ * whether they have alpha can't be known without reading the rest of
+ * the file. Grayscale and truecolor PNGs with a tRNS chunk are also
+ * reported as having four components.
+ *
+ * Return value: %TRUE if the header was understood
+ */
+CoglBool
+_cogl_bitmap_get_encoded_image_info (const uint8_t *data,
+                                     size_t size,
+                                     int *width,
+                                     int *height,
+                                     int *n_components);
+
 CoglBitmap *
 _cogl_bitmap_convert (CoglBitmap *bmp,
 		      CoglPixelFormat dst_format,
@@ -126,6 +272,13 @@ _cogl_bitmap_from_file (CoglContext *ctx,
                         const char *filename,
 			CoglError **error);
 
+/* Decodes a file with the image library that Cogl was built with. See
+   _cogl_bitmap_decode_file() */
+CoglBool
+_cogl_bitmap_decode_image_file (const char *filename,
+                                CoglDecodedImage *image,
+                                CoglError **error);
+
 #ifdef COGL_HAS_ANDROID_SUPPORT
 CoglBitmap *
 _cogl_android_bitmap_new_from_asset (CoglContext *ctx,
@@ -60,6 +60,12 @@ _cogl_bitmap_free (CoglBitmap *bmp)
   if (bmp->buffer)
     cogl_object_unref (bmp->buffer);
 
+  if (bmp->load_data_destroy)
+    bmp->load_data_destroy (bmp->load_data);
+
+  if (bmp->loaded_data_destroy)
+    bmp->loaded_data_destroy (bmp->data);
+
   g_slice_free (CoglBitmap, bmp);
 }
 
@@ -200,6 +206,10 @@ cogl_bitmap_new_for_data (CoglContext *context,
   bmp->bound = FALSE;
   bmp->shared_bmp = NULL;
   bmp->buffer = NULL;
+  bmp->load_callback = NULL;
+  bmp->load_data = NULL;
+  bmp->load_data_destroy = NULL;
+  bmp->loaded_data_destroy = NULL;
 
   return _cogl_bitmap_object_new (bmp);
 }
@@ -239,6 +249,65 @@ _cogl_bitmap_new_with_malloc_buffer (CoglContext *context,
   return bitmap;
 }
 
+CoglBitmap *
+_cogl_bitmap_new_lazy (CoglContext *context,
+                       int width,
+                       int height,
+                       CoglPixelFormat format,
+                       int rowstride,
+                       CoglBitmapLoadCallback callback,
+                       void *user_data,
+                       GDestroyNotify destroy)
+{
+  CoglBitmap *bmp;
+
+  bmp = cogl_bitmap_new_for_data (context,
+                                  width, height,
+                                  format,
+                                  rowstride,
+                                  NULL /* data */);
+
+  bmp->load_callback = callback;
+  bmp->load_data = user_data;
+  bmp->load_data_destroy = destroy;
+
+  return bmp;
+}
+
+CoglBool
+_cogl_bitmap_ensure_loaded (CoglBitmap *bitmap,
+                            CoglError **error)
+{
+  while (bitmap->shared_bmp)
+    bitmap = bitmap->shared_bmp;
+
+  if (bitmap->load_callback)
+    {
+      GDestroyNotify data_destroy = NULL;
+      uint8_t *data = bitmap->load_callback (bitmap,
+                                             bitmap->load_data,
+                                             &data_destroy,
+                                             error);
+
+      if (data == NULL)
+        return FALSE;
+
+      COGL_NOTE (BITMAP, "Decoded a lazily loaded %ix%i bitmap",
+                 bitmap->width, bitmap->height);
+
+      bitmap->data = data;
+      bitmap->loaded_data_destroy = data_destroy;
+
+      if (bitmap->load_data_destroy)
+        bitmap->load_data_destroy (bitmap->load_data);
+      bitmap->load_callback = NULL;
+      bitmap->load_data = NULL;
+      bitmap->load_data_destroy = NULL;
+    }
+
+  return TRUE;
+}
+
 CoglBitmap *
 _cogl_bitmap_new_shared (CoglBitmap              *shared_bmp,
                          CoglPixelFormat          format,
@@ -259,14 +328,67 @@ _cogl_bitmap_new_shared (CoglBitmap              *shared_bmp,
   return bmp;
 }
 
+CoglBitmap *
+_cogl_bitmap_new_from_decoded_image (CoglContext *context,
+                                     CoglDecodedImage *image)
+{
+  static CoglUserDataKey decoded_image_key;
+  CoglBitmap *bmp;
+
+  bmp = cogl_bitmap_new_for_data (context,
+                                  image->width,
+                                  image->height,
+                                  image->format,
+                                  image->rowstride,
+                                  image->data);
+
+  if (image->destroy)
+    cogl_object_set_user_data (COGL_OBJECT (bmp),
+                               &decoded_image_key,
+                               image->destroy_data,
+                               image->destroy);
+
+  return bmp;
+}
+
+CoglBool
+_cogl_bitmap_decode_file (const char *filename,
+                          CoglDecodedImage *image,
+                          CoglError **error)
+{
+  CoglError *netpbm_error = NULL;
+
+  if (_cogl_bitmap_map_netpbm_file (filename, image, &netpbm_error))
+    return TRUE;
+  else if (netpbm_error)
+    {
+      _cogl_propagate_error (error, netpbm_error);
+      return FALSE;
+    }
+
+  return _cogl_bitmap_decode_image_file (filename, image, error);
+}
+
 CoglBitmap *
 cogl_bitmap_new_from_file (CoglContext *ctx,
                            const char *filename,
                            CoglError **error)
 {
+  CoglDecodedImage image;
+  CoglError *netpbm_error = NULL;
+
   _COGL_RETURN_VAL_IF_FAIL (filename != NULL, NULL);
   _COGL_RETURN_VAL_IF_FAIL (error == NULL || *error == NULL, NULL);
 
+  /* Raw images can be used directly from a mapping of the file */
+  if (_cogl_bitmap_map_netpbm_file (filename, &image, &netpbm_error))
+    return _cogl_bitmap_new_from_decoded_image (ctx, &image);
+  else if (netpbm_error)
+    {
+      _cogl_propagate_error (error, netpbm_error);
+      return NULL;
+    }
+
   return _cogl_bitmap_from_file (ctx, filename, error);
 }
 
@@ -426,6 +548,9 @@ _cogl_bitmap_map (CoglBitmap *bitmap,
     }
   else
     {
+      if (!_cogl_bitmap_ensure_loaded (bitmap, error))
+        return NULL;
+
       bitmap->mapped = TRUE;
 
       return bitmap->data;
@@ -70,6 +70,11 @@ COGL_BEGIN_DECLS
  * Loads an image file from disk. This function can be safely called from
  * within a thread.
  *
+ * Binary PGM, PPM and PAM files with 8-bit components are mapped into
+ * memory and used directly without copying. Where possible other
+ * formats are only decoded the first time the pixels are needed, so
+ * errors in the image data may not be reported until then.
+ *
  * Return value: (transfer full): a #CoglBitmap to the new loaded
  *               image data, or %NULL if loading the image failed.
  *
@@ -45,6 +45,10 @@
 #include "cogl-blend-string.h"
 #include "cogl-error-private.h"
 
+/* The maximum number of strings to remember for each
+   CoglBlendStringContext */
+#define COGL_BLEND_STRING_CACHE_SIZE 64
+
 typedef enum _ParserState
 {
   PARSER_STATE_EXPECT_DEST_CHANNELS,
@@ -932,6 +936,58 @@ error:
     }
 }
 
+typedef struct
+{
+  int count;
+  CoglBlendStringStatement statements[2];
+} CoglBlendStringCacheEntry;
+
+int
+_cogl_blend_string_compile_cached (CoglContext *ctx,
+                                   const char *string,
+                                   CoglBlendStringContext context,
+                                   CoglBlendStringStatement *statements,
+                                   CoglError **error)
+{
+  GHashTable *cache = ctx->blend_string_cache[context];
+  CoglBlendStringCacheEntry *entry;
+  int count;
+
+  entry = g_hash_table_lookup (cache, string);
+
+  if (entry)
+    {
+      /* The statements only point to static data so they can be
+         copied as is */
+      memcpy (statements,
+              entry->statements,
+              sizeof (CoglBlendStringStatement) * entry->count);
+      return entry->count;
+    }
+
+  count = _cogl_blend_string_compile (string, context, statements, error);
+
+  /* Invalid strings aren't cached so that the error is reported
+     every time */
+  if (count == 0)
+    return 0;
+
+  /* An application that generates lots of different strings
+     shouldn't be able to make the cache grow forever */
+  if (g_hash_table_size (cache) >= COGL_BLEND_STRING_CACHE_SIZE)
+    g_hash_table_remove_all (cache);
+
+  entry = g_new (CoglBlendStringCacheEntry, 1);
+  entry->count = count;
+  memcpy (entry->statements,
+          statements,
+          sizeof (CoglBlendStringStatement) * count);
+
+  g_hash_table_insert (cache, g_strdup (string), entry);
+
+  return count;
+}
+
 /*
  * INTERNAL TESTING CODE ...
  */
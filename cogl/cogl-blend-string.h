@@ -37,6 +37,8 @@
 #include <stdlib.h>
 #include <glib.h>
 
+#include "cogl-context.h"
+
 typedef enum _CoglBlendStringContext
 {
   COGL_BLEND_STRING_CONTEXT_BLENDING,
@@ -135,6 +137,22 @@ _cogl_blend_string_compile (const char *string,
                             CoglBlendStringStatement *statements,
                             CoglError **error);
 
+/*
+ * _cogl_blend_string_compile_cached:
+ * @ctx: A #CoglContext
+ *
+ * This is the same as _cogl_blend_string_compile() except that the
+ * parsed statements for each string are remembered in @ctx. Pipelines
+ * tend to be given the same few strings over and over again so this
+ * means that most calls only need a hash table lookup.
+ */
+int
+_cogl_blend_string_compile_cached (CoglContext *ctx,
+                                   const char *string,
+                                   CoglBlendStringContext context,
+                                   CoglBlendStringStatement *statements,
+                                   CoglError **error);
+
 void
 _cogl_blend_string_split_rgba_statement (CoglBlendStringStatement *statement,
                                          CoglBlendStringStatement *rgb,
@@ -40,6 +40,7 @@
 #include "cogl-object-private.h"
 #include "cogl-buffer.h"
 #include "cogl-context.h"
+#include "cogl-framebuffer.h"
 #include "cogl-gl-header.h"
 
 COGL_BEGIN_DECLS
@@ -87,6 +88,14 @@ typedef enum {
   COGL_BUFFER_BIND_TARGET_COUNT
 } CoglBufferBindTarget;
 
+typedef struct _CoglBufferJournalRef
+{
+  CoglFramebuffer *framebuffer;
+  /* The number of references from primitives in the framebuffer's
+   * journal */
+  int ref_count;
+} CoglBufferJournalRef;
+
 struct _CoglBuffer
 {
   CoglObject _parent;
@@ -110,6 +119,17 @@ struct _CoglBuffer
 
   int immutable_ref;
 
+  /* A CoglBufferJournalRef for each framebuffer whose journal has
+   * primitives waiting to be drawn that reference this buffer. Those
+   * journals need to be flushed before the buffer can be modified */
+  GList *journal_refs;
+
+  /* This is changed to a new value whenever the contents of the
+   * buffer may have been modified. The values are unique across all
+   * buffers so it can be used to detect when cached information
+   * derived from the contents of a buffer becomes stale */
+  unsigned int age;
+
   unsigned int store_created:1;
 };
 
@@ -146,6 +166,18 @@ _cogl_buffer_immutable_ref (CoglBuffer *buffer);
 void
 _cogl_buffer_immutable_unref (CoglBuffer *buffer);
 
+CoglBuffer *
+_cogl_buffer_journal_ref (CoglBuffer *buffer,
+                          CoglFramebuffer *framebuffer);
+
+void
+_cogl_buffer_journal_unref (CoglBuffer *buffer,
+                            CoglFramebuffer *framebuffer);
+
+/* Flushes the journals that still reference the buffer */
+void
+_cogl_buffer_pre_change_notify (CoglBuffer *buffer);
+
 /* This is a wrapper around cogl_buffer_map_range for internal use
    when we want to map the buffer for write only to replace the entire
    contents. If the map fails then it will fallback to writing to a
@@ -49,6 +49,14 @@
 #include "cogl-context-private.h"
 #include "cogl-object-private.h"
 #include "cogl-pixel-buffer-private.h"
+#include "cogl-private.h"
+#include "cogl-framebuffer-private.h"
+#include "cogl-journal-private.h"
+#include "cogl-texture-2d.h"
+#include "cogl-offscreen.h"
+#include "cogl-primitive.h"
+
+#include <test-fixtures/test-unit.h>
 
 /* XXX:
  * The CoglObject macros don't support any form of inheritance, so for
@@ -113,6 +121,14 @@ malloc_set_data (CoglBuffer *buffer,
   return TRUE;
 }
 
+static void
+_cogl_buffer_update_age (CoglBuffer *buffer)
+{
+  static unsigned int next_age = 1;
+
+  buffer->age = next_age++;
+}
+
 void
 _cogl_buffer_initialize (CoglBuffer *buffer,
                          CoglContext *ctx,
@@ -132,6 +148,8 @@ _cogl_buffer_initialize (CoglBuffer *buffer,
   buffer->update_hint = update_hint;
   buffer->data = NULL;
   buffer->immutable_ref = 0;
+  buffer->journal_refs = NULL;
+  _cogl_buffer_update_age (buffer);
 
   if (default_target == COGL_BUFFER_BIND_TARGET_PIXEL_PACK ||
       default_target == COGL_BUFFER_BIND_TARGET_PIXEL_UNPACK)
@@ -246,6 +264,12 @@ cogl_buffer_map_range (CoglBuffer *buffer,
   if (G_UNLIKELY (buffer->immutable_ref))
     warn_about_midscene_changes ();
 
+  if (access & COGL_BUFFER_ACCESS_WRITE)
+    {
+      _cogl_buffer_pre_change_notify (buffer);
+      _cogl_buffer_update_age (buffer);
+    }
+
   buffer->data = buffer->vtable.map_range (buffer,
                                            offset,
                                            size,
@@ -360,6 +384,9 @@ cogl_buffer_set_data (CoglBuffer *buffer,
   if (G_UNLIKELY (buffer->immutable_ref))
     warn_about_midscene_changes ();
 
+  _cogl_buffer_pre_change_notify (buffer);
+  _cogl_buffer_update_age (buffer);
+
   return buffer->vtable.set_data (buffer, offset, data, size, error);
 }
 
@@ -381,3 +408,166 @@ _cogl_buffer_immutable_unref (CoglBuffer *buffer)
   buffer->immutable_ref--;
 }
 
+/* While primitives using a buffer are batched in a journal the buffer
+ * can't be modified so this tracks the journal references separately
+ * in the same way as _cogl_pipeline_journal_ref(). The references are
+ * counted per framebuffer so that only the journals that use the
+ * buffer need to be flushed when it changes */
+static CoglBufferJournalRef *
+find_journal_ref (CoglBuffer *buffer,
+                  CoglFramebuffer *framebuffer,
+                  GList **link_out)
+{
+  GList *l;
+
+  for (l = buffer->journal_refs; l; l = l->next)
+    {
+      CoglBufferJournalRef *journal_ref = l->data;
+
+      if (journal_ref->framebuffer == framebuffer)
+        {
+          if (link_out)
+            *link_out = l;
+          return journal_ref;
+        }
+    }
+
+  return NULL;
+}
+
+CoglBuffer *
+_cogl_buffer_journal_ref (CoglBuffer *buffer,
+                          CoglFramebuffer *framebuffer)
+{
+  CoglBufferJournalRef *journal_ref =
+    find_journal_ref (buffer, framebuffer, NULL);
+
+  /* The journal holds a reference to the framebuffer while it has
+   * any primitives so it doesn't need another one here */
+  if (journal_ref == NULL)
+    {
+      journal_ref = g_slice_new (CoglBufferJournalRef);
+      journal_ref->framebuffer = framebuffer;
+      journal_ref->ref_count = 0;
+      buffer->journal_refs = g_list_prepend (buffer->journal_refs,
+                                             journal_ref);
+    }
+
+  journal_ref->ref_count++;
+
+  return cogl_object_ref (buffer);
+}
+
+void
+_cogl_buffer_journal_unref (CoglBuffer *buffer,
+                            CoglFramebuffer *framebuffer)
+{
+  GList *link;
+  CoglBufferJournalRef *journal_ref =
+    find_journal_ref (buffer, framebuffer, &link);
+
+  _COGL_RETURN_IF_FAIL (journal_ref != NULL);
+
+  if (--journal_ref->ref_count == 0)
+    {
+      buffer->journal_refs = g_list_delete_link (buffer->journal_refs, link);
+      g_slice_free (CoglBufferJournalRef, journal_ref);
+    }
+
+  cogl_object_unref (buffer);
+}
+
+void
+_cogl_buffer_pre_change_notify (CoglBuffer *buffer)
+{
+  /* Flushing a journal drops all of its references to the buffer
+   * which removes the framebuffer from the list */
+  while (G_UNLIKELY (buffer->journal_refs))
+    {
+      CoglBufferJournalRef *journal_ref = buffer->journal_refs->data;
+
+      _cogl_framebuffer_flush_journal (journal_ref->framebuffer);
+    }
+}
+
+static CoglFramebuffer *
+create_test_offscreen (void)
+{
+  CoglTexture2D *tex = cogl_texture_2d_new_with_size (test_ctx, 16, 16);
+  CoglOffscreen *offscreen =
+    cogl_offscreen_new_with_texture (COGL_TEXTURE (tex));
+
+  cogl_object_unref (tex);
+
+  return COGL_FRAMEBUFFER (offscreen);
+}
+
+static CoglPrimitive *
+create_test_primitive (CoglAttributeBuffer *buffer)
+{
+  CoglAttribute *attribute = cogl_attribute_new (buffer,
+                                                 "cogl_position_in",
+                                                 sizeof (CoglVertexP2),
+                                                 0, /* offset */
+                                                 2, /* n_components */
+                                                 COGL_ATTRIBUTE_TYPE_FLOAT);
+  CoglPrimitive *primitive =
+    cogl_primitive_new (COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                        4, /* n_vertices */
+                        attribute,
+                        NULL);
+
+  cogl_object_unref (attribute);
+
+  return primitive;
+}
+
+UNIT_TEST (check_buffer_change_flushes_referencing_journals,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  static const CoglVertexP2 verts[] =
+    {
+      { 0, 0 }, { 0, 10 }, { 10, 0 }, { 10, 10 }
+    };
+  CoglFramebuffer *fb_a = create_test_offscreen ();
+  CoglFramebuffer *fb_b = create_test_offscreen ();
+  CoglAttributeBuffer *buffer_a =
+    cogl_attribute_buffer_new (test_ctx, sizeof (verts), verts);
+  CoglAttributeBuffer *buffer_b =
+    cogl_attribute_buffer_new (test_ctx, sizeof (verts), verts);
+  CoglPrimitive *primitive_a = create_test_primitive (buffer_a);
+  CoglPrimitive *primitive_b = create_test_primitive (buffer_b);
+  CoglPipeline *pipeline = cogl_pipeline_new (test_ctx);
+
+  /* Each framebuffer batches a primitive using a different buffer */
+  cogl_primitive_draw (primitive_a, fb_a, pipeline);
+  cogl_primitive_draw (primitive_b, fb_b, pipeline);
+  g_assert_cmpint (fb_a->journal->primitives.n_draws, ==, 1);
+  g_assert_cmpint (fb_b->journal->primitives.n_draws, ==, 1);
+
+  /* Changing a buffer only flushes the journal that uses it */
+  cogl_buffer_set_data (COGL_BUFFER (buffer_a),
+                        0, verts, sizeof (verts),
+                        NULL);
+  g_assert_cmpint (fb_a->journal->primitives.n_draws, ==, 0);
+  g_assert_cmpint (fb_b->journal->primitives.n_draws, ==, 1);
+  g_assert (COGL_BUFFER (buffer_a)->journal_refs == NULL);
+
+  /* When both framebuffers use the buffer both are flushed */
+  cogl_primitive_draw (primitive_b, fb_a, pipeline);
+  cogl_buffer_set_data (COGL_BUFFER (buffer_b),
+                        0, verts, sizeof (verts),
+                        NULL);
+  g_assert_cmpint (fb_a->journal->primitives.n_draws, ==, 0);
+  g_assert_cmpint (fb_b->journal->primitives.n_draws, ==, 0);
+  g_assert (COGL_BUFFER (buffer_b)->journal_refs == NULL);
+
+  cogl_object_unref (pipeline);
+  cogl_object_unref (primitive_a);
+  cogl_object_unref (primitive_b);
+  cogl_object_unref (buffer_a);
+  cogl_object_unref (buffer_b);
+  cogl_object_unref (fb_a);
+  cogl_object_unref (fb_b);
+}
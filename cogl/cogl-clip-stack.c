@@ -48,9 +48,13 @@
 #include "cogl-pipeline-opengl-private.h"
 #include "cogl-attribute-private.h"
 #include "cogl-primitive-private.h"
+#include "cogl-indices-private.h"
+#include "cogl-buffer-private.h"
 #include "cogl-offscreen.h"
 #include "cogl-matrix-stack.h"
 
+#include <test-fixtures/test-unit.h>
+
 
 
 static void *
@@ -267,6 +271,7 @@ _cogl_clip_stack_push_primitive (CoglClipStack *stack,
   CoglMatrix modelview;
   CoglMatrix projection;
   float transformed_corners[8];
+  int i;
 
   entry = _cogl_clip_stack_push_entry (stack,
                                        sizeof (CoglClipStackPrimitive),
@@ -276,6 +281,28 @@ _cogl_clip_stack_push_primitive (CoglClipStack *stack,
 
   entry->matrix_entry = cogl_matrix_entry_ref (modelview_entry);
 
+  entry->mode = primitive->mode;
+  entry->first_vertex = primitive->first_vertex;
+  entry->n_vertices = primitive->n_vertices;
+  entry->n_buffer_ages = primitive->n_attributes + 1;
+  entry->buffer_ages = g_new (unsigned int, entry->n_buffer_ages);
+
+  for (i = 0; i < primitive->n_attributes; i++)
+    {
+      CoglAttribute *attribute = primitive->attributes[i];
+
+      if (attribute->is_buffered)
+        entry->buffer_ages[i] =
+          COGL_BUFFER (attribute->d.buffered.attribute_buffer)->age;
+      else
+        entry->buffer_ages[i] = 0;
+    }
+
+  if (primitive->indices)
+    entry->buffer_ages[i] = COGL_BUFFER (primitive->indices->buffer)->age;
+  else
+    entry->buffer_ages[i] = 0;
+
   entry->bounds_x1 = bounds_x1;
   entry->bounds_y1 = bounds_y1;
   entry->bounds_x2 = bounds_x2;
@@ -336,6 +363,7 @@ _cogl_clip_stack_unref (CoglClipStack *entry)
               (CoglClipStackPrimitive *) entry;
             cogl_matrix_entry_unref (primitive_entry->matrix_entry);
             cogl_object_unref (primitive_entry->primitive);
+            g_free (primitive_entry->buffer_ages);
             g_slice_free1 (sizeof (CoglClipStackPrimitive), entry);
             break;
           }
@@ -400,6 +428,146 @@ _cogl_clip_stack_get_bounds (CoglClipStack *stack,
     }
 }
 
+static unsigned int
+hash_matrix_entry (unsigned int hash,
+                   CoglMatrixEntry *entry)
+{
+  CoglMatrix matrix;
+
+  cogl_matrix_entry_get (entry, &matrix);
+
+  return _cogl_util_one_at_a_time_hash (hash, &matrix, sizeof (float) * 16);
+}
+
+unsigned int
+_cogl_clip_stack_hash (CoglClipStack *stack)
+{
+  unsigned int hash = 0;
+  CoglClipStack *entry;
+
+  for (entry = stack; entry; entry = entry->parent)
+    {
+      hash = _cogl_util_one_at_a_time_hash (hash, &entry->type,
+                                            sizeof (entry->type));
+      hash = _cogl_util_one_at_a_time_hash (hash, &entry->bounds_x0,
+                                            sizeof (int) * 4);
+
+      switch (entry->type)
+        {
+        case COGL_CLIP_STACK_RECT:
+          {
+            CoglClipStackRect *rect = (CoglClipStackRect *) entry;
+
+            hash = _cogl_util_one_at_a_time_hash (hash, &rect->x0,
+                                                  sizeof (float) * 4);
+            hash = hash_matrix_entry (hash, rect->matrix_entry);
+            break;
+          }
+        case COGL_CLIP_STACK_WINDOW_RECT:
+          break;
+        case COGL_CLIP_STACK_PRIMITIVE:
+          {
+            CoglClipStackPrimitive *primitive_entry =
+              (CoglClipStackPrimitive *) entry;
+
+            hash = _cogl_util_one_at_a_time_hash (hash,
+                                                  &primitive_entry->primitive,
+                                                  sizeof (CoglPrimitive *));
+            hash = _cogl_util_one_at_a_time_hash (hash,
+                                                  &primitive_entry->mode,
+                                                  sizeof (CoglVerticesMode));
+            hash = _cogl_util_one_at_a_time_hash (hash,
+                                                  &primitive_entry->
+                                                  first_vertex,
+                                                  sizeof (int));
+            hash = _cogl_util_one_at_a_time_hash (hash,
+                                                  &primitive_entry->
+                                                  n_vertices,
+                                                  sizeof (int));
+            hash = _cogl_util_one_at_a_time_hash (hash,
+                                                  primitive_entry->buffer_ages,
+                                                  sizeof (unsigned int) *
+                                                  primitive_entry->
+                                                  n_buffer_ages);
+            hash = hash_matrix_entry (hash, primitive_entry->matrix_entry);
+            break;
+          }
+        }
+    }
+
+  return _cogl_util_one_at_a_time_mix (hash);
+}
+
+CoglBool
+_cogl_clip_stack_equal (CoglClipStack *stack0,
+                        CoglClipStack *stack1)
+{
+  for (;
+       stack0 && stack1;
+       stack0 = stack0->parent, stack1 = stack1->parent)
+    {
+      /* Stacks that share the rest of their entries must be the same
+       * from here on */
+      if (stack0 == stack1)
+        return TRUE;
+
+      if (stack0->type != stack1->type ||
+          stack0->bounds_x0 != stack1->bounds_x0 ||
+          stack0->bounds_y0 != stack1->bounds_y0 ||
+          stack0->bounds_x1 != stack1->bounds_x1 ||
+          stack0->bounds_y1 != stack1->bounds_y1)
+        return FALSE;
+
+      switch (stack0->type)
+        {
+        case COGL_CLIP_STACK_RECT:
+          {
+            CoglClipStackRect *rect0 = (CoglClipStackRect *) stack0;
+            CoglClipStackRect *rect1 = (CoglClipStackRect *) stack1;
+
+            if (rect0->x0 != rect1->x0 ||
+                rect0->y0 != rect1->y0 ||
+                rect0->x1 != rect1->x1 ||
+                rect0->y1 != rect1->y1 ||
+                rect0->can_be_scissor != rect1->can_be_scissor ||
+                !cogl_matrix_entry_equal (rect0->matrix_entry,
+                                          rect1->matrix_entry))
+              return FALSE;
+            break;
+          }
+        case COGL_CLIP_STACK_WINDOW_RECT:
+          break;
+        case COGL_CLIP_STACK_PRIMITIVE:
+          {
+            CoglClipStackPrimitive *primitive0 =
+              (CoglClipStackPrimitive *) stack0;
+            CoglClipStackPrimitive *primitive1 =
+              (CoglClipStackPrimitive *) stack1;
+
+            if (primitive0->primitive != primitive1->primitive ||
+                primitive0->mode != primitive1->mode ||
+                primitive0->first_vertex != primitive1->first_vertex ||
+                primitive0->n_vertices != primitive1->n_vertices ||
+                primitive0->n_buffer_ages != primitive1->n_buffer_ages ||
+                memcmp (primitive0->buffer_ages,
+                        primitive1->buffer_ages,
+                        sizeof (unsigned int) *
+                        primitive0->n_buffer_ages) ||
+                primitive0->bounds_x1 != primitive1->bounds_x1 ||
+                primitive0->bounds_y1 != primitive1->bounds_y1 ||
+                primitive0->bounds_x2 != primitive1->bounds_x2 ||
+                primitive0->bounds_y2 != primitive1->bounds_y2 ||
+                !cogl_matrix_entry_equal (primitive0->matrix_entry,
+                                          primitive1->matrix_entry))
+              return FALSE;
+            break;
+          }
+        }
+    }
+
+  return stack0 == stack1;
+}
+
 void
 _cogl_clip_stack_flush (CoglClipStack *stack,
                         CoglFramebuffer *framebuffer)
@@ -408,3 +576,82 @@ _cogl_clip_stack_flush (CoglClipStack *stack,
 
   ctx->driver_vtable->clip_stack_flush (stack, framebuffer);
 }
+
+static CoglClipStack *
+push_test_primitive_clip (CoglPrimitive *primitive)
+{
+  CoglMatrixStack *modelview_stack =
+    _cogl_framebuffer_get_modelview_stack (test_fb);
+  CoglMatrixStack *projection_stack =
+    _cogl_framebuffer_get_projection_stack (test_fb);
+  float viewport[4] = { 0, 0, 100, 100 };
+
+  return _cogl_clip_stack_push_primitive (NULL,
+                                          primitive,
+                                          0, 0, 10, 10,
+                                          modelview_stack->last_entry,
+                                          projection_stack->last_entry,
+                                          viewport);
+}
+
+UNIT_TEST (check_clip_stack_primitive_state,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  CoglVertexP2 verts[] =
+    {
+      { 0, 0 }, { 0, 10 }, { 10, 0 }, { 10, 10 }
+    };
+  CoglAttributeBuffer *buffer;
+  CoglAttribute *attribute;
+  CoglPrimitive *primitive;
+  CoglClipStack *stack0, *stack1;
+
+  buffer = cogl_attribute_buffer_new (test_ctx, sizeof (verts), verts);
+  attribute = cogl_attribute_new (buffer,
+                                  "cogl_position_in",
+                                  sizeof (CoglVertexP2),
+                                  0, /* offset */
+                                  2, /* n_components */
+                                  COGL_ATTRIBUTE_TYPE_FLOAT);
+  primitive = cogl_primitive_new (COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                  G_N_ELEMENTS (verts),
+                                  attribute,
+                                  NULL);
+
+  /* The same unmodified primitive gives the same clip */
+  stack0 = push_test_primitive_clip (primitive);
+  stack1 = push_test_primitive_clip (primitive);
+  g_assert (_cogl_clip_stack_equal (stack0, stack1));
+  g_assert_cmpuint (_cogl_clip_stack_hash (stack0),
+                    ==,
+                    _cogl_clip_stack_hash (stack1));
+  _cogl_clip_stack_unref (stack1);
+
+  /* Modifying the vertices changes it */
+  verts[0].x = verts[1].x = 5;
+  cogl_buffer_set_data (COGL_BUFFER (buffer),
+                        0, verts, sizeof (verts),
+                        NULL);
+  stack1 = push_test_primitive_clip (primitive);
+  g_assert (!_cogl_clip_stack_equal (stack0, stack1));
+  _cogl_clip_stack_unref (stack0);
+
+  /* So does drawing a different range of the vertices */
+  cogl_primitive_set_first_vertex (primitive, 1);
+  cogl_primitive_set_n_vertices (primitive, 3);
+  stack0 = push_test_primitive_clip (primitive);
+  g_assert (!_cogl_clip_stack_equal (stack0, stack1));
+  _cogl_clip_stack_unref (stack1);
+
+  /* And a different mode */
+  cogl_primitive_set_mode (primitive, COGL_VERTICES_MODE_TRIANGLES);
+  stack1 = push_test_primitive_clip (primitive);
+  g_assert (!_cogl_clip_stack_equal (stack0, stack1));
+
+  _cogl_clip_stack_unref (stack0);
+  _cogl_clip_stack_unref (stack1);
+  cogl_object_unref (primitive);
+  cogl_object_unref (attribute);
+  cogl_object_unref (buffer);
+}
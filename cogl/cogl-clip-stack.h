@@ -49,6 +49,11 @@ typedef struct _CoglClipStackRect CoglClipStackRect;
 typedef struct _CoglClipStackWindowRect CoglClipStackWindowRect;
 typedef struct _CoglClipStackPrimitive CoglClipStackPrimitive;
 
+/* The maximum number of rectangles that can't be implemented with the
+   scissor that the GL driver will try to clip to in the fragment
+   shader instead of using the stencil buffer */
+#define COGL_MAX_SHADER_CLIP_RECTS 4
+
 typedef enum
   {
     COGL_CLIP_STACK_RECT,
@@ -160,6 +165,17 @@ struct _CoglClipStackPrimitive
   float bounds_y1;
   float bounds_x2;
   float bounds_y2;
+
+  /* The state of the primitive when the clip was set. The primitive
+     can be modified afterwards so this is used to check whether two
+     clip stacks will generate the same stencil buffer. There is one
+     buffer age for each attribute followed by one for the indices.
+     Constant attributes and missing indices have an age of 0 */
+  CoglVerticesMode mode;
+  int first_vertex;
+  int n_vertices;
+  int n_buffer_ages;
+  unsigned int *buffer_ages;
 };
 
 CoglClipStack *
@@ -200,6 +216,28 @@ _cogl_clip_stack_get_bounds (CoglClipStack *stack,
                              int *scissor_x1,
                              int *scissor_y1);
 
+/*
+ * _cogl_clip_stack_hash:
+ * @stack: A #CoglClipStack
+ *
+ * Calculates a hash of the contents of @stack. Stacks that are
+ * considered equal by _cogl_clip_stack_equal() will have the same
+ * hash even if they are built from different entries.
+ */
+unsigned int
+_cogl_clip_stack_hash (CoglClipStack *stack);
+
+/*
+ * _cogl_clip_stack_equal:
+ *
+ * Compares the contents of two clip stacks. This can be used to
+ * detect when a stack that has been rebuilt describes the same clip
+ * as a stack that was flushed before.
+ */
+CoglBool
+_cogl_clip_stack_equal (CoglClipStack *stack0,
+                        CoglClipStack *stack1);
+
 void
 _cogl_clip_stack_flush (CoglClipStack *stack,
                         CoglFramebuffer *framebuffer);
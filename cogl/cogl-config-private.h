@@ -41,5 +41,6 @@ extern char *_cogl_config_driver;
 extern char *_cogl_config_renderer;
 extern char *_cogl_config_disable_gl_extensions;
 extern char *_cogl_config_override_gl_version;
+extern char *_cogl_config_texture_memory_budget;
 
 #endif /* __COGL_CONFIG_PRIVATE_H */
@@ -43,6 +43,7 @@ char *_cogl_config_driver;
 char *_cogl_config_renderer;
 char *_cogl_config_disable_gl_extensions;
 char *_cogl_config_override_gl_version;
+char *_cogl_config_texture_memory_budget;
 
 #ifndef COGL_HAS_GLIB_SUPPORT
 
@@ -64,7 +65,8 @@ static const struct
     { "COGL_DRIVER", &_cogl_config_driver },
     { "COGL_RENDERER", &_cogl_config_renderer },
     { "COGL_DISABLE_GL_EXTENSIONS", &_cogl_config_disable_gl_extensions },
-    { "COGL_OVERRIDE_GL_VERSION", &_cogl_config_override_gl_version }
+    { "COGL_OVERRIDE_GL_VERSION", &_cogl_config_override_gl_version },
+    { "COGL_TEXTURE_MEMORY_BUDGET", &_cogl_config_texture_memory_budget }
   };
 
 static void
@@ -59,7 +59,9 @@
 #include "cogl-onscreen-private.h"
 #include "cogl-fence-private.h"
 #include "cogl-poll-private.h"
+#include "cogl-worker-pool-private.h"
 #include "cogl-private.h"
+#include "cogl-primitives-private.h"
 
 typedef struct
 {
@@ -124,6 +126,14 @@ struct _CoglContext
   CoglBitmask       enable_custom_attributes_tmp;
   CoglBitmask       changed_bits_tmp;
 
+  /* The generic attribute locations that currently have a non-zero
+   * instance divisor */
+  CoglBitmask       instanced_attributes;
+  CoglBitmask       instanced_attributes_tmp;
+  /* An empty vertex snippet used to force the GLSL progend when a
+   * builtin attribute has an instance divisor, created lazily */
+  CoglSnippet      *instanced_attributes_snippet;
+
   /* A few handy matrix constants */
   CoglMatrix        identity_matrix;
   CoglMatrix        y_flip_matrix;
@@ -144,6 +154,14 @@ struct _CoglContext
   CoglMatrixEntryCache builtin_flushed_projection;
   CoglMatrixEntryCache builtin_flushed_modelview;
 
+  /* Uniform buffers containing the builtin matrices that are shared
+   * between all GLSL programs along with caches of the matrix entries
+   * that were last uploaded to them. These are managed by the GLSL
+   * progend */
+  GLuint matrix_uniform_buffers[2];
+  CoglMatrixEntryCache matrix_block_projection[2];
+  CoglMatrixEntryCache matrix_block_modelview[2];
+
   GArray           *texture_units;
   int               active_texture_unit;
 
@@ -255,6 +273,22 @@ struct _CoglContext
      same state multiple times. When the clip state is flushed this
      will hold a reference */
   CoglClipStack    *current_clip_stack;
+  /* If the flushed clip stack is implemented in the fragment shader
+     then this is the number of rectangles and the edges of each
+     rectangle as a plane equation in GL window coordinates. Otherwise
+     n_shader_clip_rects is zero. */
+  int               n_shader_clip_rects;
+  float             shader_clip_planes[COGL_MAX_SHADER_CLIP_RECTS * 4 * 3];
+  /* A snippet for each number of rectangles, created lazily */
+  CoglSnippet      *shader_clip_snippets[COGL_MAX_SHADER_CLIP_RECTS];
+  int               shader_clip_uniform_location;
+
+  /* Snippets to emulate texture repeating in the fragment shader for
+     textures that are a sub-region of a larger texture. There is one
+     for each layer position and they are created lazily */
+  CoglSnippet      *shader_repeat_snippets[COGL_MAX_SHADER_REPEAT_LAYERS];
+  int               shader_repeat_uniform_locations
+                                          [COGL_MAX_SHADER_REPEAT_LAYERS];
 
   /* This is used as a temporary buffer to fill a CoglBuffer when
      cogl_buffer_map fails and we only want to map to fill it with new
@@ -267,6 +301,25 @@ struct _CoglContext
 
   CoglSamplerCache *sampler_cache;
 
+  /* Threads for CPU-only work. This is created lazily by
+     _cogl_context_get_worker_pool() */
+  CoglWorkerPool *worker_pool;
+
+  /* Texture memory accounting. See cogl-texture-residency.c */
+  size_t texture_memory[COGL_TEXTURE_TYPE_2D_ARRAY + 1];
+  size_t texture_memory_budget;
+  /* Purgeable textures sorted from the least to the most recently
+     used */
+  CoglList purgeable_textures;
+  unsigned int texture_residency_frame;
+  CoglBool texture_residency_evicting;
+
+  /* Statistics for the frame in progress and the last complete
+     frame. See cogl-profile.c */
+  CoglFrameStats frame_stats;
+  CoglFrameStats last_frame_stats;
+  int64_t frame_start_time;
+
   /* FIXME: remove these when we remove the last xlib based clutter
    * backend. they should be tracked as part of the renderer but e.g.
    * the eglx backend doesn't yet have a corresponding Cogl winsys
@@ -296,6 +349,10 @@ struct _CoglContext
   GHashTable *uniform_name_hash;
   int n_uniform_names;
 
+  /* Parsed blend strings indexed by CoglBlendStringContext. See
+     _cogl_blend_string_compile_cached() */
+  GHashTable *blend_string_cache[2];
+
   CoglPollSource *fences_poll_source;
   CoglList fences;
 
@@ -366,4 +423,16 @@ _cogl_context_get_gl_extensions (CoglContext *context);
 const char *
 _cogl_context_get_gl_version (CoglContext *context);
 
+CoglWorkerPool *
+_cogl_context_get_worker_pool (CoglContext *context);
+
+void
+_cogl_profile_init (CoglContext *context);
+
+/* Saves the statistics for the current frame so that they can be
+ * retrieved with cogl_context_get_frame_stats() and starts a new
+ * frame */
+void
+_cogl_profile_end_frame (CoglContext *context);
+
 #endif /* __COGL_CONTEXT_PRIVATE_H */
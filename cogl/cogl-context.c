@@ -47,6 +47,7 @@
 #include "cogl-texture-2d-private.h"
 #include "cogl-texture-3d-private.h"
 #include "cogl-texture-rectangle-private.h"
+#include "cogl-texture-residency-private.h"
 #include "cogl-pipeline-private.h"
 #include "cogl-pipeline-opengl-private.h"
 #include "cogl-framebuffer-private.h"
@@ -141,22 +142,6 @@ cogl_context_new (CoglDisplay *display,
 
   _cogl_init ();
 
-#ifdef COGL_ENABLE_PROFILE
-  /* We need to be absolutely sure that uprof has been initialized
-   * before calling _cogl_uprof_init. uprof_init (NULL, NULL)
-   * will be a NOP if it has been initialized but it will also
-   * mean subsequent parsing of the UProf GOptionGroup will have no
-   * affect.
-   *
-   * Sadly GOptionGroup based library initialization is extremely
-   * fragile by design because GOptionGroups have no notion of
-   * dependencies and so the order things are initialized isn't
-   * currently under tight control.
-   */
-  uprof_init (NULL, NULL);
-  _cogl_uprof_init ();
-#endif
-
   /* Allocate context memory */
   context = g_malloc0 (sizeof (CoglContext));
 
@@ -242,6 +227,10 @@ cogl_context_new (CoglDisplay *display,
   context->uniform_name_hash = g_hash_table_new (g_str_hash, g_str_equal);
   context->n_uniform_names = 0;
 
+  for (i = 0; i < G_N_ELEMENTS (context->blend_string_cache); i++)
+    context->blend_string_cache[i] =
+      g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
   /* Initialise the driver specific state */
   _cogl_init_feature_overrides (context);
 
@@ -270,6 +259,14 @@ cogl_context_new (CoglDisplay *display,
 
   context->current_clip_stack_valid = FALSE;
   context->current_clip_stack = NULL;
+  context->n_shader_clip_rects = 0;
+  memset (context->shader_clip_snippets, 0,
+          sizeof (context->shader_clip_snippets));
+  context->shader_clip_uniform_location = -1;
+  memset (context->shader_repeat_snippets, 0,
+          sizeof (context->shader_repeat_snippets));
+  for (i = 0; i < COGL_MAX_SHADER_REPEAT_LAYERS; i++)
+    context->shader_repeat_uniform_locations[i] = -1;
 
   cogl_matrix_init_identity (&context->identity_matrix);
   cogl_matrix_init_identity (&context->y_flip_matrix);
@@ -277,6 +274,9 @@ cogl_context_new (CoglDisplay *display,
 
   context->flushed_matrix_mode = COGL_MATRIX_MODELVIEW;
 
+  _cogl_texture_residency_init (context);
+  _cogl_profile_init (context);
+
   context->texture_units =
     g_array_new (FALSE, FALSE, sizeof (CoglTextureUnit));
 
@@ -322,6 +322,9 @@ cogl_context_new (CoglDisplay *display,
   _cogl_bitmask_init (&context->enabled_custom_attributes);
   _cogl_bitmask_init (&context->enable_custom_attributes_tmp);
   _cogl_bitmask_init (&context->changed_bits_tmp);
+  _cogl_bitmask_init (&context->instanced_attributes);
+  _cogl_bitmask_init (&context->instanced_attributes_tmp);
+  context->instanced_attributes_snippet = NULL;
 
   context->max_texture_units = -1;
   context->max_activateable_texture_units = -1;
@@ -388,6 +391,13 @@ cogl_context_new (CoglDisplay *display,
   _cogl_matrix_entry_cache_init (&context->builtin_flushed_projection);
   _cogl_matrix_entry_cache_init (&context->builtin_flushed_modelview);
 
+  for (i = 0; i < G_N_ELEMENTS (context->matrix_uniform_buffers); i++)
+    {
+      context->matrix_uniform_buffers[i] = 0;
+      _cogl_matrix_entry_cache_init (&context->matrix_block_projection[i]);
+      _cogl_matrix_entry_cache_init (&context->matrix_block_modelview[i]);
+    }
+
   /* Create default textures used for fall backs */
   context->default_gl_texture_2d_tex =
     cogl_texture_2d_new_from_data (context,
@@ -438,6 +448,8 @@ cogl_context_new (CoglDisplay *display,
   context->buffer_map_fallback_array = g_byte_array_new ();
   context->buffer_map_fallback_in_use = FALSE;
 
+  context->worker_pool = NULL;
+
   /* As far as I can tell, GL_POINT_SPRITE doesn't have any effect
      unless GL_COORD_REPLACE is enabled for an individual layer.
      Therefore it seems like it should be ok to just leave it enabled
@@ -458,6 +470,19 @@ static void
 _cogl_context_free (CoglContext *context)
 {
   const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
+  const char *trace_filename = g_getenv ("COGL_TRACE_OUTPUT");
+  int i;
+
+  if (trace_filename)
+    {
+      CoglError *error = NULL;
+
+      if (!cogl_context_write_trace (context, trace_filename, &error))
+        {
+          g_warning ("%s", error->message);
+          cogl_error_free (error);
+        }
+    }
 
   winsys->context_deinit (context);
 
@@ -499,6 +524,14 @@ _cogl_context_free (CoglContext *context)
   if (context->current_clip_stack_valid)
     _cogl_clip_stack_unref (context->current_clip_stack);
 
+  for (i = 0; i < COGL_MAX_SHADER_CLIP_RECTS; i++)
+    if (context->shader_clip_snippets[i])
+      cogl_object_unref (context->shader_clip_snippets[i]);
+
+  for (i = 0; i < COGL_MAX_SHADER_REPEAT_LAYERS; i++)
+    if (context->shader_repeat_snippets[i])
+      cogl_object_unref (context->shader_repeat_snippets[i]);
+
   g_slist_free (context->atlases);
   g_hook_list_clear (&context->atlas_reorganize_callbacks);
 
@@ -509,6 +542,11 @@ _cogl_context_free (CoglContext *context)
   _cogl_bitmask_destroy (&context->enabled_custom_attributes);
   _cogl_bitmask_destroy (&context->enable_custom_attributes_tmp);
   _cogl_bitmask_destroy (&context->changed_bits_tmp);
+  _cogl_bitmask_destroy (&context->instanced_attributes);
+  _cogl_bitmask_destroy (&context->instanced_attributes_tmp);
+
+  if (context->instanced_attributes_snippet)
+    cogl_object_unref (context->instanced_attributes_snippet);
 
   if (context->current_modelview_entry)
     cogl_matrix_entry_unref (context->current_modelview_entry);
@@ -517,15 +555,29 @@ _cogl_context_free (CoglContext *context)
   _cogl_matrix_entry_cache_destroy (&context->builtin_flushed_projection);
   _cogl_matrix_entry_cache_destroy (&context->builtin_flushed_modelview);
 
+  for (i = 0; i < G_N_ELEMENTS (context->matrix_uniform_buffers); i++)
+    {
+      if (context->matrix_uniform_buffers[i])
+        GE( context, glDeleteBuffers (1, &context->matrix_uniform_buffers[i]) );
+      _cogl_matrix_entry_cache_destroy (&context->matrix_block_projection[i]);
+      _cogl_matrix_entry_cache_destroy (&context->matrix_block_modelview[i]);
+    }
+
   _cogl_pipeline_cache_free (context->pipeline_cache);
 
   _cogl_sampler_cache_free (context->sampler_cache);
 
+  if (context->worker_pool)
+    _cogl_worker_pool_free (context->worker_pool);
+
   _cogl_destroy_texture_units ();
 
   g_ptr_array_free (context->uniform_names, TRUE);
   g_hash_table_destroy (context->uniform_name_hash);
 
+  for (i = 0; i < G_N_ELEMENTS (context->blend_string_cache); i++)
+    g_hash_table_destroy (context->blend_string_cache[i]);
+
   g_hash_table_destroy (context->attribute_name_states_hash);
   g_array_free (context->attribute_name_index_map, TRUE);
 
@@ -701,6 +753,15 @@ _cogl_context_get_gl_version (CoglContext *context)
 
 }
 
+CoglWorkerPool *
+_cogl_context_get_worker_pool (CoglContext *context)
+{
+  if (context->worker_pool == NULL)
+    context->worker_pool = _cogl_worker_pool_new ();
+
+  return context->worker_pool;
+}
+
 int64_t
 cogl_get_clock_time (CoglContext *context)
 {
@@ -711,3 +772,10 @@ cogl_get_clock_time (CoglContext *context)
   else
     return 0;
 }
+
+void
+cogl_context_end_frame (CoglContext *context)
+{
+  _cogl_texture_residency_end_frame (context);
+  _cogl_profile_end_frame (context);
+}
@@ -232,6 +232,15 @@ cogl_is_context (void *object);
  *     the depth buffer to a texture.
  * @COGL_FEATURE_ID_PRESENTATION_TIME: Whether frame presentation
  *    time stamps will be recorded in #CoglFrameInfo objects.
+ * @COGL_FEATURE_ID_INSTANCED_DRAWING: Whether primitives can be drawn
+ *    multiple times in a single call with
+ *    cogl_primitive_draw_instanced() and whether attributes can be
+ *    made per-instance with cogl_attribute_set_instance_divisor(). If
+ *    %COGL_FEATURE_ID_GLSL is also available then vertex snippets can
+ *    read the index of the instance from the cogl_instance_id builtin.
+ * @COGL_FEATURE_ID_TEXTURE_TILED: Whether #CoglTextureTiled textures
+ *    can be created. These store images that are larger than the
+ *    maximum texture size in a single array texture.
  *
  * All the capabilities that can vary between different GPUs supported
  * by Cogl. Applications that depend on any of these features should explicitly
@@ -263,6 +272,8 @@ typedef enum _CoglFeatureID
   COGL_FEATURE_ID_FENCE,
   COGL_FEATURE_ID_PER_VERTEX_POINT_SIZE,
   COGL_FEATURE_ID_TEXTURE_RG,
+  COGL_FEATURE_ID_INSTANCED_DRAWING,
+  COGL_FEATURE_ID_TEXTURE_TILED,
 
   /*< private >*/
   _COGL_N_FEATURE_IDS   /*< skip >*/
@@ -364,6 +375,102 @@ cogl_foreach_feature (CoglContext *context,
 int64_t
 cogl_get_clock_time (CoglContext *context);
 
+/**
+ * cogl_context_end_frame:
+ * @context: A #CoglContext pointer
+ *
+ * Marks the end of a frame. This happens automatically each time a
+ * #CoglOnscreen is swapped so it only needs to be called by
+ * applications that render exclusively to offscreen framebuffers.
+ * Ending a frame updates the statistics returned by
+ * cogl_context_get_frame_stats() and lets Cogl evict purgeable
+ * textures that weren't painted during the frame to stay under the
+ * budget set with cogl_context_set_texture_memory_budget().
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_context_end_frame (CoglContext *context);
+
+/**
+ * CoglFrameStats:
+ * @frame_time: The CPU time in nanoseconds between the end of the
+ *   previous frame and the end of this one
+ * @n_draw_calls: The number of draw calls submitted to the driver
+ * @n_state_changes: The number of times the GPU pipeline state had
+ *   to be changed between draw calls
+ * @n_bytes_uploaded: The number of bytes of texture and buffer data
+ *   uploaded to the GPU
+ * @n_pipeline_cache_hits: The number of times a generated shader or
+ *   program could be reused from the pipeline cache
+ * @n_pipeline_cache_misses: The number of times a new shader or
+ *   program had to be generated
+ * @n_program_links: The number of GLSL programs that were linked
+ *
+ * Statistics about the work that Cogl did to render a frame. A frame
+ * ends each time a #CoglOnscreen is swapped or
+ * cogl_context_end_frame() is called.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+typedef struct _CoglFrameStats
+{
+  int64_t frame_time;
+  unsigned int n_draw_calls;
+  unsigned int n_state_changes;
+  uint64_t n_bytes_uploaded;
+  unsigned int n_pipeline_cache_hits;
+  unsigned int n_pipeline_cache_misses;
+  unsigned int n_program_links;
+} CoglFrameStats;
+
+/**
+ * cogl_context_get_frame_stats:
+ * @context: A #CoglContext pointer
+ * @stats: (out): A #CoglFrameStats to fill in
+ *
+ * Retrieves statistics about the last complete frame. The statistics
+ * are always gathered so this can be called at any time without
+ * enabling anything first. If no frame has been completed yet then
+ * all of the values will be zero.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_context_get_frame_stats (CoglContext *context,
+                              CoglFrameStats *stats);
+
+/**
+ * cogl_context_write_trace:
+ * @context: A #CoglContext pointer
+ * @filename: The name of the file to write
+ * @error: A #CoglError to return exceptional errors
+ *
+ * Writes the most recent timing events that Cogl recorded to
+ * @filename in the Chrome trace event format. The file can be loaded
+ * into chrome://tracing or any other viewer that understands the
+ * format. The trace includes the time spent in Cogl's internal timers
+ * such as journal flushing and a counter track for each of the values
+ * in #CoglFrameStats.
+ *
+ * Events are only recorded while the trace debug option is enabled,
+ * for example by setting the environment variable COGL_DEBUG=trace.
+ * Each thread keeps a fixed number of its most recent events. If the
+ * environment variable COGL_TRACE_OUTPUT is set then the trace is
+ * also written to that file when the context is destroyed.
+ *
+ * Return value: %TRUE if the file was written or %FALSE otherwise.
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglBool
+cogl_context_write_trace (CoglContext *context,
+                          const char *filename,
+                          CoglError **error);
+
 COGL_END_DECLS
 
 #endif /* __COGL_CONTEXT_H__ */
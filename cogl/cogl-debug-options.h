@@ -79,6 +79,11 @@ OPT (TEXTURE_PIXMAP,
      "texture-pixmap",
      N_("Trace CoglTexturePixmap backend"),
      N_("Trace the Cogl texture pixmap backend"))
+OPT (TEXTURE_RESIDENCY,
+     N_("Cogl Tracing"),
+     "texture-residency",
+     N_("Trace Texture Residency"),
+     N_("Debug texture memory accounting and eviction"))
 OPT (RECTANGLES,
      N_("Visualize"),
      "rectangles",
@@ -161,6 +166,13 @@ OPT (DISABLE_SOFTWARE_CLIP,
      "disable-software-clip",
      N_("Disable software clipping"),
      N_("Disables Cogl's attempts to clip some rectangles in software."))
+OPT (DISABLE_SHADER_CLIP,
+     N_("Root Cause"),
+     "disable-shader-clip",
+     N_("Disable shader clipping"),
+     N_("Always use the stencil buffer or clip planes to clip to "
+        "rectangles that can't be described by the scissor instead of "
+        "clipping in the fragment shader."))
 OPT (SHOW_SOURCE,
      N_("Cogl Tracing"),
      "show-source",
@@ -197,3 +209,9 @@ OPT (PERFORMANCE,
      "performance",
      N_("Trace performance concerns"),
      N_("Tries to highlight sub-optimal Cogl usage."))
+OPT (TRACE,
+     N_("Cogl Specialist"),
+     "trace",
+     N_("Record a timing trace"),
+     N_("Record timing events that can be written out in the Chrome trace "
+        "format with cogl_context_write_trace()"))
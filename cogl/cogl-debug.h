@@ -70,11 +70,14 @@ typedef enum {
   COGL_DEBUG_DISABLE_NPOT_TEXTURES,
   COGL_DEBUG_WIREFRAME,
   COGL_DEBUG_DISABLE_SOFTWARE_CLIP,
+  COGL_DEBUG_DISABLE_SHADER_CLIP,
   COGL_DEBUG_DISABLE_PROGRAM_CACHES,
   COGL_DEBUG_DISABLE_FAST_READ_PIXEL,
   COGL_DEBUG_CLIPPING,
   COGL_DEBUG_WINSYS,
   COGL_DEBUG_PERFORMANCE,
+  COGL_DEBUG_TEXTURE_RESIDENCY,
+  COGL_DEBUG_TRACE,
 
   COGL_DEBUG_N_FLAGS
 } CoglDebugFlags;
@@ -97,6 +97,7 @@ struct _CoglDriverVtable
                                    CoglVerticesMode mode,
                                    int first_vertex,
                                    int n_vertices,
+                                   int n_instances,
                                    CoglAttribute **attributes,
                                    int n_attributes,
                                    CoglDrawFlags flags);
@@ -107,11 +108,26 @@ struct _CoglDriverVtable
                                            CoglVerticesMode mode,
                                            int first_vertex,
                                            int n_vertices,
+                                           int n_instances,
                                            CoglIndices *indices,
                                            CoglAttribute **attributes,
                                            int n_attributes,
                                            CoglDrawFlags flags);
 
+  /* Draws several ranges of the same attributes. If indices is not
+   * NULL then each first vertex is an index into the indices */
+  void
+  (* framebuffer_multi_draw_attributes) (CoglFramebuffer *framebuffer,
+                                         CoglPipeline *pipeline,
+                                         CoglVerticesMode mode,
+                                         const int *first_vertices,
+                                         const int *n_vertices,
+                                         int n_draws,
+                                         CoglIndices *indices,
+                                         CoglAttribute **attributes,
+                                         int n_attributes,
+                                         CoglDrawFlags flags);
+
   CoglBool
   (* framebuffer_read_pixels_into_bitmap) (CoglFramebuffer *framebuffer,
                                            int x,
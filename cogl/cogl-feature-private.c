@@ -73,6 +73,7 @@ _cogl_feature_check (CoglRenderer *renderer,
       /* FIXME: WebGL should probably have its own COGL_EXT_IN_WEBGL flag */
       break;
     case COGL_DRIVER_NOP:
+    case COGL_DRIVER_SW:
     case COGL_DRIVER_GL:
     case COGL_DRIVER_GL3:
       break;
@@ -53,6 +53,12 @@ struct _CoglFenceClosure
   CoglFenceType type;
   void *fence_obj;
 
+  /* File descriptor exported by the winsys that becomes readable
+   * when the fence is signaled or -1 */
+  int fd;
+  /* Set once the fd has been seen to be readable */
+  CoglBool fd_signaled;
+
   CoglFenceCallback callback;
   void *user_data;
 };
@@ -35,6 +35,7 @@
 #include "cogl-fence-private.h"
 #include "cogl-context-private.h"
 #include "cogl-winsys-private.h"
+#include "cogl-poll-private.h"
 
 #define FENCE_CHECK_TIMEOUT 5000 /* microseconds */
 
@@ -44,19 +45,24 @@ cogl_fence_closure_get_user_data (CoglFenceClosure *closure)
   return closure->user_data;
 }
 
-static void
-_cogl_fence_check (CoglFenceClosure *fence)
+static CoglBool
+_cogl_fence_is_complete (CoglFenceClosure *fence)
 {
   CoglContext *context = fence->framebuffer->context;
 
+  if (fence->fd_signaled)
+    return TRUE;
+
+  /* If the fence has a file descriptor then there is no point in
+   * asking the driver until the main loop reports it as readable */
+  if (fence->fd != -1)
+    return FALSE;
+
   if (fence->type == FENCE_TYPE_WINSYS)
     {
       const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
-      CoglBool ret;
 
-      ret = winsys->fence_is_complete (context, fence->fence_obj);
-      if (!ret)
-        return;
+      return winsys->fence_is_complete (context, fence->fence_obj);
     }
 #ifdef GL_ARB_sync
   else if (fence->type == FENCE_TYPE_GL_ARB)
@@ -66,11 +72,16 @@ _cogl_fence_check (CoglFenceClosure *fence)
       arb = context->glClientWaitSync (fence->fence_obj,
                                        GL_SYNC_FLUSH_COMMANDS_BIT,
                                        0);
-      if (arb != GL_ALREADY_SIGNALED && arb != GL_CONDITION_SATISFIED)
-        return;
+      return arb == GL_ALREADY_SIGNALED || arb == GL_CONDITION_SATISFIED;
     }
 #endif
 
+  return TRUE;
+}
+
+static void
+_cogl_fence_complete (CoglFenceClosure *fence)
+{
   fence->callback (NULL, /* dummy CoglFence object */
                    fence->user_data);
   cogl_framebuffer_cancel_fence_callback (fence->framebuffer, fence);
@@ -81,15 +92,51 @@ _cogl_fence_poll_dispatch (void *source, int revents)
 {
   CoglContext *context = source;
   CoglFenceClosure *fence, *tmp;
+  int n_signaled = 0, i = 0;
+
+  /* The fences are kept in the order they were submitted to the GPU
+   * and all of the commands for a context are executed in order so
+   * if a fence is signaled then all of the fences before it must be
+   * too. That means we can complete everything up to the newest fence
+   * whose fd has fired without asking the driver */
+  _cogl_list_for_each (fence, &context->fences, link)
+    {
+      i++;
+      if (fence->fd_signaled)
+        n_signaled = i;
+    }
 
   _cogl_list_for_each_safe (fence, tmp, &context->fences, link)
-    _cogl_fence_check (fence);
+    {
+      if (n_signaled > 0)
+        n_signaled--;
+      else if (!_cogl_fence_is_complete (fence))
+        /* None of the later fences can be complete either */
+        break;
+
+      _cogl_fence_complete (fence);
+    }
+}
+
+static void
+_cogl_fence_fd_dispatch (void *user_data, int revents)
+{
+  CoglFenceClosure *fence = user_data;
+
+  /* The fences are actually completed from the context's poll
+   * source so that they are always handled in order. This just
+   * records that the fd has fired */
+  if (revents & (COGL_POLL_FD_EVENT_IN |
+                 COGL_POLL_FD_EVENT_ERR |
+                 COGL_POLL_FD_EVENT_HUP))
+    fence->fd_signaled = TRUE;
 }
 
 static int64_t
 _cogl_fence_poll_prepare (void *source)
 {
   CoglContext *context = source;
+  CoglFenceClosure *oldest;
   GList *l;
 
   /* If there are any pending fences in any of the journals then we
@@ -103,10 +150,20 @@ _cogl_fence_poll_prepare (void *source)
         _cogl_framebuffer_flush_journal (fb);
     }
 
-  if (!_cogl_list_empty (&context->fences))
-    return FENCE_CHECK_TIMEOUT;
-  else
+  if (_cogl_list_empty (&context->fences))
+    return -1;
+
+  /* Only the oldest fence matters because none of the others can
+   * complete before it */
+  oldest = _cogl_container_of (context->fences.next, CoglFenceClosure, link);
+
+  if (oldest->fd_signaled)
+    return 0;
+  else if (oldest->fd != -1)
+    /* The main loop will wake up when the fd becomes readable */
     return -1;
+  else
+    return FENCE_CHECK_TIMEOUT;
 }
 
 void
@@ -116,6 +173,8 @@ _cogl_fence_submit (CoglFenceClosure *fence)
   const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
 
   fence->type = FENCE_TYPE_ERROR;
+  fence->fd = -1;
+  fence->fd_signaled = FALSE;
 
   if (winsys->fence_add)
     {
@@ -123,6 +182,10 @@ _cogl_fence_submit (CoglFenceClosure *fence)
       if (fence->fence_obj)
         {
           fence->type = FENCE_TYPE_WINSYS;
+
+          if (winsys->fence_get_fd)
+            fence->fd = winsys->fence_get_fd (context, fence->fence_obj);
+
           goto done;
         }
     }
@@ -151,6 +214,17 @@ _cogl_fence_submit (CoglFenceClosure *fence)
                                         _cogl_fence_poll_dispatch,
                                         context);
     }
+
+  /* The fd source is added after the context's source so that it
+   * will be prepended before it in the renderer's list. That way the
+   * context's dispatch can remove it without breaking the iteration */
+  if (fence->fd != -1)
+    _cogl_poll_renderer_add_fd (context->display->renderer,
+                                fence->fd,
+                                COGL_POLL_FD_EVENT_IN,
+                                NULL, /* prepare */
+                                _cogl_fence_fd_dispatch,
+                                fence);
 }
 
 CoglFenceClosure *
@@ -170,8 +244,10 @@ cogl_framebuffer_add_fence_callback (CoglFramebuffer *framebuffer,
   fence->callback = callback;
   fence->user_data = user_data;
   fence->fence_obj = NULL;
+  fence->fd = -1;
+  fence->fd_signaled = FALSE;
 
-  if (journal->entries->len)
+  if (!_cogl_journal_is_empty (journal))
     {
       _cogl_list_insert (journal->pending_fences.prev, &fence->link);
       fence->type = FENCE_TYPE_PENDING;
@@ -200,6 +276,10 @@ cogl_framebuffer_cancel_fence_callback (CoglFramebuffer *framebuffer,
         {
           const CoglWinsysVtable *winsys = _cogl_context_get_winsys (context);
 
+          if (fence->fd != -1)
+            _cogl_poll_renderer_remove_fd (context->display->renderer,
+                                           fence->fd);
+
           winsys->fence_destroy (context, fence->fence_obj);
         }
 #ifdef GL_ARB_sync
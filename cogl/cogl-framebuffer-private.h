@@ -154,6 +154,15 @@ struct _CoglFramebuffer
 
   CoglClipStack      *clip_stack;
 
+  /* The clip stack that was last drawn into the stencil buffer along
+   * with the projection and viewport that were used to draw it. If a
+   * clip stack with the same contents is flushed again then the
+   * stencil buffer can be reused instead of being redrawn */
+  CoglClipStack      *stencil_clip_stack;
+  unsigned int        stencil_clip_hash;
+  CoglMatrixEntry    *stencil_clip_projection;
+  float               stencil_clip_viewport[4];
+
   CoglBool            dither_enabled;
   CoglBool            depth_writing_enabled;
   CoglColorMask       color_mask;
@@ -415,6 +424,18 @@ _cogl_framebuffer_push_projection (CoglFramebuffer *framebuffer);
 void
 _cogl_framebuffer_pop_projection (CoglFramebuffer *framebuffer);
 
+/*
+ * _cogl_framebuffer_forget_stencil_clip:
+ * @framebuffer: A #CoglFramebuffer
+ *
+ * Marks the contents of the stencil buffer as unknown so that the
+ * next clip flush won't try to reuse a previously drawn stencil
+ * clip. This needs to be called whenever something other than the
+ * clip stack code may have modified the stencil buffer.
+ */
+void
+_cogl_framebuffer_forget_stencil_clip (CoglFramebuffer *framebuffer);
+
 void
 _cogl_framebuffer_save_clip_stack (CoglFramebuffer *framebuffer);
 
@@ -433,6 +454,7 @@ _cogl_framebuffer_draw_attributes (CoglFramebuffer *framebuffer,
                                    CoglVerticesMode mode,
                                    int first_vertex,
                                    int n_vertices,
+                                   int n_instances,
                                    CoglAttribute **attributes,
                                    int n_attributes,
                                    CoglDrawFlags flags);
@@ -443,6 +465,7 @@ _cogl_framebuffer_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                            CoglVerticesMode mode,
                                            int first_vertex,
                                            int n_vertices,
+                                           int n_instances,
                                            CoglIndices *indices,
                                            CoglAttribute **attributes,
                                            int n_attributes,
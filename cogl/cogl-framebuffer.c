@@ -178,6 +178,8 @@ _cogl_framebuffer_free (CoglFramebuffer *framebuffer)
 
   _cogl_clip_stack_unref (framebuffer->clip_stack);
 
+  _cogl_framebuffer_forget_stencil_clip (framebuffer);
+
   cogl_object_unref (framebuffer->modelview_stack);
   framebuffer->modelview_stack = NULL;
 
@@ -230,11 +232,27 @@ _cogl_framebuffer_clear_without_flush4f (CoglFramebuffer *framebuffer,
       return;
     }
 
+  if (buffers & COGL_BUFFER_BIT_STENCIL)
+    _cogl_framebuffer_forget_stencil_clip (framebuffer);
+
   ctx->driver_vtable->framebuffer_clear (framebuffer,
                                          buffers,
                                          red, green, blue, alpha);
 }
 
+void
+_cogl_framebuffer_forget_stencil_clip (CoglFramebuffer *framebuffer)
+{
+  if (framebuffer->stencil_clip_stack == NULL)
+    return;
+
+  _cogl_clip_stack_unref (framebuffer->stencil_clip_stack);
+  framebuffer->stencil_clip_stack = NULL;
+
+  cogl_matrix_entry_unref (framebuffer->stencil_clip_projection);
+  framebuffer->stencil_clip_projection = NULL;
+}
+
 void
 _cogl_framebuffer_mark_clear_clip_dirty (CoglFramebuffer *framebuffer)
 {
@@ -1421,6 +1439,9 @@ cogl_framebuffer_discard_buffers (CoglFramebuffer *framebuffer,
 
   _COGL_RETURN_IF_FAIL (buffers & COGL_BUFFER_BIT_COLOR);
 
+  if (buffers & COGL_BUFFER_BIT_STENCIL)
+    _cogl_framebuffer_forget_stencil_clip (framebuffer);
+
   ctx->driver_vtable->framebuffer_discard_buffers (framebuffer, buffers);
 }
 
@@ -1816,7 +1837,7 @@ _cogl_framebuffer_unref (CoglFramebuffer *framebuffer)
      journal and let the framebuffer die. It is fine at this point if
      flushing the journal causes something else to take a reference to
      it and it comes back to life */
-  if (framebuffer->journal->entries->len > 0)
+  if (!_cogl_journal_is_empty (framebuffer->journal))
     {
       unsigned int ref_count = ((CoglObject *) framebuffer)->ref_count;
 
@@ -2051,6 +2072,7 @@ draw_wireframe (CoglContext *ctx,
                 CoglVerticesMode mode,
                 int first_vertex,
                 int n_vertices,
+                int n_instances,
                 CoglAttribute **attributes,
                 int n_attributes,
                 CoglIndices *indices,
@@ -2116,6 +2138,7 @@ draw_wireframe (CoglContext *ctx,
                                            COGL_VERTICES_MODE_LINES,
                                            0,
                                            n_indices,
+                                           n_instances,
                                            wire_indices,
                                            attributes,
                                            n_attributes,
@@ -2134,6 +2157,7 @@ _cogl_framebuffer_draw_attributes (CoglFramebuffer *framebuffer,
                                    CoglVerticesMode mode,
                                    int first_vertex,
                                    int n_vertices,
+                                   int n_instances,
                                    CoglAttribute **attributes,
                                    int n_attributes,
                                    CoglDrawFlags flags)
@@ -2146,7 +2170,7 @@ _cogl_framebuffer_draw_attributes (CoglFramebuffer *framebuffer,
       mode != COGL_VERTICES_MODE_LINE_STRIP)
     draw_wireframe (framebuffer->context,
                     framebuffer, pipeline,
-                    mode, first_vertex, n_vertices,
+                    mode, first_vertex, n_vertices, n_instances,
                     attributes, n_attributes, NULL,
                     flags);
   else
@@ -2159,6 +2183,7 @@ _cogl_framebuffer_draw_attributes (CoglFramebuffer *framebuffer,
                                                        mode,
                                                        first_vertex,
                                                        n_vertices,
+                                                       n_instances,
                                                        attributes,
                                                        n_attributes,
                                                        flags);
@@ -2171,6 +2196,7 @@ _cogl_framebuffer_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                            CoglVerticesMode mode,
                                            int first_vertex,
                                            int n_vertices,
+                                           int n_instances,
                                            CoglIndices *indices,
                                            CoglAttribute **attributes,
                                            int n_attributes,
@@ -2184,7 +2210,7 @@ _cogl_framebuffer_draw_indexed_attributes (CoglFramebuffer *framebuffer,
       mode != COGL_VERTICES_MODE_LINE_STRIP)
     draw_wireframe (framebuffer->context,
                     framebuffer, pipeline,
-                    mode, first_vertex, n_vertices,
+                    mode, first_vertex, n_vertices, n_instances,
                     attributes, n_attributes, indices,
                     flags);
   else
@@ -2197,6 +2223,7 @@ _cogl_framebuffer_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                                                mode,
                                                                first_vertex,
                                                                n_vertices,
+                                                               n_instances,
                                                                indices,
                                                                attributes,
                                                                n_attributes,
@@ -1803,6 +1803,10 @@ cogl_push_gles2_context (CoglContext *ctx,
   else
     gles2_ctx->vtable->glFlush ();
 
+  /* The GLES2 context is free to scribble over the stencil buffer so
+   * any stencil clip that was drawn there can't be reused */
+  _cogl_framebuffer_forget_stencil_clip (write_buffer);
+
   if (gles2_ctx->read_buffer != read_buffer)
     {
       if (cogl_is_offscreen (read_buffer))
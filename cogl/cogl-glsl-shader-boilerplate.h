@@ -35,11 +35,26 @@
 
 #define _COGL_COMMON_SHADER_BOILERPLATE \
   "#define COGL_VERSION 100\n" \
-  "\n" \
+  "\n"
+
+/* The builtin matrices are appended after the boilerplate for the
+ * shader stage. They are either plain uniforms or, when uniform
+ * buffers are available, members of a block that is shared between
+ * all of the programs. The order of the block members must match
+ * CoglMatrixUniformBlock in cogl-pipeline-progend-glsl.c */
+#define _COGL_MATRIX_UNIFORMS_BOILERPLATE \
   "uniform mat4 cogl_modelview_matrix;\n" \
   "uniform mat4 cogl_modelview_projection_matrix;\n"  \
   "uniform mat4 cogl_projection_matrix;\n"
 
+#define _COGL_MATRIX_BLOCK_BOILERPLATE \
+  "layout(std140) uniform _cogl_matrices\n" \
+  "{\n" \
+  "  mat4 cogl_modelview_matrix;\n" \
+  "  mat4 cogl_modelview_projection_matrix;\n"  \
+  "  mat4 cogl_projection_matrix;\n" \
+  "};\n"
+
 /* This declares all of the variables that we might need. This is
  * working on the assumption that the compiler will optimise them out
  * if they are not actually used. The GLSL spec at least implies that
@@ -55,15 +55,24 @@ _cogl_glsl_shader_set_source_with_boilerplate (CoglContext *ctx,
 {
   const char *vertex_boilerplate;
   const char *fragment_boilerplate;
+  const char *matrix_boilerplate;
+  CoglBool use_matrix_block;
 
-  const char **strings = g_alloca (sizeof (char *) * (count_in + 4));
-  GLint *lengths = g_alloca (sizeof (GLint) * (count_in + 4));
+  const char **strings = g_alloca (sizeof (char *) * (count_in + 7));
+  GLint *lengths = g_alloca (sizeof (GLint) * (count_in + 7));
   char *version_string;
   int count = 0;
 
   vertex_boilerplate = _COGL_VERTEX_SHADER_BOILERPLATE;
   fragment_boilerplate = _COGL_FRAGMENT_SHADER_BOILERPLATE;
 
+  use_matrix_block =
+    _cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_UNIFORM_BUFFERS);
+  if (use_matrix_block)
+    matrix_boilerplate = _COGL_MATRIX_BLOCK_BOILERPLATE;
+  else
+    matrix_boilerplate = _COGL_MATRIX_UNIFORMS_BOILERPLATE;
+
   version_string = g_strdup_printf ("#version %i\n\n",
                                     ctx->glsl_version_to_use);
   strings[count] = version_string;
@@ -78,6 +87,46 @@ _cogl_glsl_shader_set_source_with_boilerplate (CoglContext *ctx,
       lengths[count++] = sizeof (texture_3d_extension) - 1;
     }
 
+  if (shader_gl_type == GL_VERTEX_SHADER &&
+      cogl_has_feature (ctx, COGL_FEATURE_ID_INSTANCED_DRAWING))
+    {
+      static const char gl_instance_id_extension[] =
+        "#extension GL_ARB_draw_instanced : enable\n"
+        "#define cogl_instance_id gl_InstanceIDARB\n";
+      static const char gles_instance_id_extension[] =
+        "#extension GL_EXT_draw_instanced : enable\n"
+        "#define cogl_instance_id gl_InstanceIDEXT\n";
+
+      if (_cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_GL_EMBEDDED))
+        {
+          strings[count] = gles_instance_id_extension;
+          lengths[count++] = sizeof (gles_instance_id_extension) - 1;
+        }
+      else
+        {
+          strings[count] = gl_instance_id_extension;
+          lengths[count++] = sizeof (gl_instance_id_extension) - 1;
+        }
+    }
+
+  /* The vertend declares the samplers for all of the layers as well
+   * so the extension is needed in both shaders */
+  if (cogl_has_feature (ctx, COGL_FEATURE_ID_TEXTURE_TILED))
+    {
+      static const char texture_array_extension[] =
+        "#extension GL_EXT_texture_array : enable\n";
+      strings[count] = texture_array_extension;
+      lengths[count++] = sizeof (texture_array_extension) - 1;
+    }
+
+  if (use_matrix_block)
+    {
+      static const char uniform_buffer_extension[] =
+        "#extension GL_ARB_uniform_buffer_object : enable\n";
+      strings[count] = uniform_buffer_extension;
+      lengths[count++] = sizeof (uniform_buffer_extension) - 1;
+    }
+
   if (shader_gl_type == GL_VERTEX_SHADER)
     {
       strings[count] = vertex_boilerplate;
@@ -89,6 +138,9 @@ _cogl_glsl_shader_set_source_with_boilerplate (CoglContext *ctx,
       lengths[count++] = strlen (fragment_boilerplate);
     }
 
+  strings[count] = matrix_boilerplate;
+  lengths[count++] = strlen (matrix_boilerplate);
+
   memcpy (strings + count, strings_in, sizeof (char *) * count_in);
   if (lengths_in)
     memcpy (lengths + count, lengths_in, sizeof (GLint) * count_in);
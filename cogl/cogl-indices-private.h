@@ -56,5 +56,8 @@ _cogl_indices_immutable_ref (CoglIndices *indices);
 void
 _cogl_indices_immutable_unref (CoglIndices *indices);
 
+size_t
+_cogl_indices_type_get_size (CoglIndicesType type);
+
 #endif /* __COGL_INDICES_PRIVATE_H */
 
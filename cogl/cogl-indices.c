@@ -49,8 +49,8 @@ static void _cogl_indices_free (CoglIndices *indices);
 
 COGL_OBJECT_DEFINE (Indices, indices);
 
-static size_t
-sizeof_indices_type (CoglIndicesType type)
+size_t
+_cogl_indices_type_get_size (CoglIndicesType type)
 {
   switch (type)
     {
@@ -87,7 +87,7 @@ cogl_indices_new (CoglContext *context,
                   const void *indices_data,
                   int n_indices)
 {
-  size_t buffer_bytes = sizeof_indices_type (type) * n_indices;
+  size_t buffer_bytes = _cogl_indices_type_get_size (type) * n_indices;
   CoglIndexBuffer *index_buffer = cogl_index_buffer_new (context, buffer_bytes);
   CoglBuffer *buffer = COGL_BUFFER (index_buffer);
   CoglIndices *indices;
@@ -154,6 +154,9 @@ cogl_indices_set_offset (CoglIndices *indices,
   if (G_UNLIKELY (indices->immutable_ref))
     warn_about_midscene_changes ();
 
+  /* Batched primitives in the journal may be using the offset */
+  _cogl_buffer_pre_change_notify (COGL_BUFFER (indices->buffer));
+
   indices->offset = offset;
 }
 
@@ -35,9 +35,42 @@
 #include "cogl-object-private.h"
 #include "cogl-clip-stack.h"
 #include "cogl-fence-private.h"
+#include "cogl-matrix-stack.h"
+#include "cogl-pipeline.h"
+#include "cogl-primitive.h"
 
 #define COGL_JOURNAL_VBO_POOL_SIZE 8
 
+/* The maximum number of primitives that will be submitted with a
+   single multi-draw call */
+#define COGL_JOURNAL_MAX_BATCHED_PRIMITIVES 256
+
+/* Consecutive primitives drawn with cogl_primitive_draw() that use
+   the same pipeline, matrices, clip state and attribute layout are
+   recorded here instead of being drawn straight away so that they can
+   be submitted together when the journal is flushed */
+typedef struct _CoglJournalPrimitives
+{
+  int n_draws;
+  int first_vertices[COGL_JOURNAL_MAX_BATCHED_PRIMITIVES];
+  int n_vertices[COGL_JOURNAL_MAX_BATCHED_PRIMITIVES];
+
+  CoglPipeline *pipeline;
+  /* The age and color of the pipeline when the batch was started */
+  unsigned int pipeline_age;
+  CoglColor pipeline_color;
+
+  CoglMatrixEntry *modelview_entry;
+  CoglClipStack *clip_stack;
+  CoglVerticesMode mode;
+
+  /* These are taken from the first primitive. The first vertices of
+     indexed primitives are relative to the offset of these indices */
+  CoglIndices *indices;
+  CoglAttribute **attributes;
+  int n_attributes;
+} CoglJournalPrimitives;
+
 typedef struct _CoglJournal
 {
   CoglObject _parent;
@@ -68,6 +101,10 @@ typedef struct _CoglJournal
 
   CoglList pending_fences;
 
+  /* The journal can either have entries or batched primitives but
+     never both at the same time so that they are drawn in order */
+  CoglJournalPrimitives primitives;
+
 } CoglJournal;
 
 /* To improve batching of geometry when submitting vertices to OpenGL we
@@ -95,9 +132,26 @@ _cogl_journal_log_quad (CoglJournal  *journal,
                         const float  *tex_coords,
                         unsigned int  tex_coords_len);
 
+/*
+ * _cogl_journal_log_primitive:
+ *
+ * Tries to add the primitive to the batch of primitives in the
+ * journal. Returns %FALSE if the primitive can't be batched in which
+ * case the caller should draw it directly.
+ */
+CoglBool
+_cogl_journal_log_primitive (CoglJournal *journal,
+                             CoglPrimitive *primitive,
+                             CoglPipeline *pipeline);
+
 void
 _cogl_journal_flush (CoglJournal *journal);
 
+/* Returns TRUE if nothing has been logged in the journal. While the
+ * journal isn't empty it holds a reference to the framebuffer */
+CoglBool
+_cogl_journal_is_empty (CoglJournal *journal);
+
 void
 _cogl_journal_discard (CoglJournal *journal);
 
@@ -42,6 +42,8 @@
 #include "cogl-framebuffer-private.h"
 #include "cogl-profile.h"
 #include "cogl-attribute-private.h"
+#include "cogl-primitive-private.h"
+#include "cogl-indices-private.h"
 #include "cogl-point-in-poly-private.h"
 #include "cogl-private.h"
 
@@ -291,7 +293,7 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
                      "The time spent flushing modelview + entries",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, time_flush_modelview_and_entries);
+  COGL_TIMER_START (time_flush_modelview_and_entries);
 
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
     g_print ("BATCHING:     modelview batch len = %d\n", batch_len);
@@ -313,6 +315,7 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
                                          state->pipeline,
                                          GL_QUADS,
                                          state->current_vertex, batch_len * 4,
+                                         1, /* n_instances */
                                          attributes,
                                          state->attributes->len,
                                          draw_flags);
@@ -329,6 +332,7 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
                                                      mode,
                                                      first_vertex,
                                                      batch_len * 6,
+                                                     1, /* n_instances */
                                                      state->indices,
                                                      attributes,
                                                      state->attributes->len,
@@ -340,6 +344,7 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
                                              state->pipeline,
                                              COGL_VERTICES_MODE_TRIANGLE_FAN,
                                              state->current_vertex, 4,
+                                             1, /* n_instances */
                                              attributes,
                                              state->attributes->len,
                                              draw_flags);
@@ -385,6 +390,7 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
                                            outline,
                                            COGL_VERTICES_MODE_LINE_LOOP,
                                            4 * i + state->current_vertex, 4,
+                                           1, /* n_instances */
                                            loop_attributes,
                                            1,
                                            draw_flags);
@@ -400,7 +406,7 @@ _cogl_journal_flush_modelview_and_entries (CoglJournalEntry *batch_start,
 
   state->current_vertex += (4 * batch_len);
 
-  COGL_TIMER_STOP (_cogl_uprof_context, time_flush_modelview_and_entries);
+  COGL_TIMER_STOP (time_flush_modelview_and_entries);
 }
 
 static CoglBool
@@ -425,7 +431,7 @@ _cogl_journal_flush_pipeline_and_entries (CoglJournalEntry *batch_start,
                      "The time spent flushing pipeline + entries",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, time_flush_pipeline_entries);
+  COGL_TIMER_START (time_flush_pipeline_entries);
 
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
     g_print ("BATCHING:    pipeline batch len = %d\n", batch_len);
@@ -445,7 +451,7 @@ _cogl_journal_flush_pipeline_and_entries (CoglJournalEntry *batch_start,
   else
     _cogl_journal_flush_modelview_and_entries (batch_start, batch_len, data);
 
-  COGL_TIMER_STOP (_cogl_uprof_context, time_flush_pipeline_entries);
+  COGL_TIMER_STOP (time_flush_pipeline_entries);
 }
 
 static CoglBool
@@ -544,7 +550,7 @@ _cogl_journal_flush_texcoord_vbo_offsets_and_entries (
                      "+ entries",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, time_flush_texcoord_pipeline_entries);
+  COGL_TIMER_START (time_flush_texcoord_pipeline_entries);
 
   /* NB: attributes 0 and 1 are position and color */
 
@@ -565,7 +571,7 @@ _cogl_journal_flush_texcoord_vbo_offsets_and_entries (
                   compare_entry_pipelines,
                   _cogl_journal_flush_pipeline_and_entries,
                   data);
-  COGL_TIMER_STOP (_cogl_uprof_context, time_flush_texcoord_pipeline_entries);
+  COGL_TIMER_STOP (time_flush_texcoord_pipeline_entries);
 }
 
 static CoglBool
@@ -596,8 +602,7 @@ _cogl_journal_flush_vbo_offsets_and_entries (CoglJournalEntry *batch_start,
                      "pipeline + entries",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context,
-                    time_flush_vbo_texcoord_pipeline_entries);
+  COGL_TIMER_START (time_flush_vbo_texcoord_pipeline_entries);
 
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
     g_print ("BATCHING:   vbo offset batch len = %d\n", batch_len);
@@ -678,8 +683,7 @@ _cogl_journal_flush_vbo_offsets_and_entries (CoglJournalEntry *batch_start,
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_JOURNAL)))
     g_print ("new vbo offset = %lu\n", (unsigned long)state->array_offset);
 
-  COGL_TIMER_STOP (_cogl_uprof_context,
-                   time_flush_vbo_texcoord_pipeline_entries);
+  COGL_TIMER_STOP (time_flush_vbo_texcoord_pipeline_entries);
 }
 
 static CoglBool
@@ -716,8 +720,7 @@ _cogl_journal_flush_clip_stacks_and_entries (CoglJournalEntry *batch_start,
                      "pipeline + entries",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context,
-                    time_flush_clip_stack_pipeline_entries);
+  COGL_TIMER_START (time_flush_clip_stack_pipeline_entries);
 
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
     g_print ("BATCHING:  clip stack batch len = %d\n", batch_len);
@@ -752,8 +755,7 @@ _cogl_journal_flush_clip_stacks_and_entries (CoglJournalEntry *batch_start,
                   _cogl_journal_flush_vbo_offsets_and_entries, /* callback */
                   data);
 
-  COGL_TIMER_STOP (_cogl_uprof_context,
-                   time_flush_clip_stack_pipeline_entries);
+  COGL_TIMER_STOP (time_flush_clip_stack_pipeline_entries);
 }
 
 typedef struct
@@ -1020,13 +1022,11 @@ _cogl_journal_maybe_software_clip_entries (CoglJournalEntry *batch_start,
                      "Time spent software clipping",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context,
-                    time_check_software_clip);
+  COGL_TIMER_START (time_check_software_clip);
 
   maybe_software_clip_entries (batch_start, batch_len, state);
 
-  COGL_TIMER_STOP (_cogl_uprof_context,
-                   time_check_software_clip);
+  COGL_TIMER_STOP (time_check_software_clip);
 }
 
 static CoglBool
@@ -1171,11 +1171,56 @@ upload_vertices (CoglJournal *journal,
   return attribute_buffer;
 }
 
+static void
+unref_primitives (CoglJournalPrimitives *primitives,
+                  CoglFramebuffer *framebuffer)
+{
+  int i;
+
+  _cogl_pipeline_journal_unref (primitives->pipeline);
+  cogl_matrix_entry_unref (primitives->modelview_entry);
+  _cogl_clip_stack_unref (primitives->clip_stack);
+
+  for (i = 0; i < primitives->n_attributes; i++)
+    {
+      CoglAttribute *attribute = primitives->attributes[i];
+
+      _cogl_buffer_journal_unref
+        (COGL_BUFFER (attribute->d.buffered.attribute_buffer), framebuffer);
+      cogl_object_unref (attribute);
+    }
+  g_free (primitives->attributes);
+
+  if (primitives->indices)
+    {
+      _cogl_buffer_journal_unref (COGL_BUFFER (primitives->indices->buffer),
+                                  framebuffer);
+      cogl_object_unref (primitives->indices);
+    }
+
+  primitives->n_draws = 0;
+}
+
+static void
+_cogl_journal_discard_primitives (CoglJournal *journal)
+{
+  if (journal->primitives.n_draws == 0)
+    return;
+
+  unref_primitives (&journal->primitives, journal->framebuffer);
+
+  /* The journal only holds a reference to the framebuffer while the
+     journal is not empty */
+  cogl_object_unref (journal->framebuffer);
+}
+
 void
 _cogl_journal_discard (CoglJournal *journal)
 {
   int i;
 
+  _cogl_journal_discard_primitives (journal);
+
   if (journal->entries->len <= 0)
     return;
 
@@ -1216,6 +1261,10 @@ _cogl_journal_all_entries_within_bounds (CoglJournal *journal,
   int bounds_y1;
   int i;
 
+  /* We don't know the bounds of batched primitives */
+  if (journal->primitives.n_draws > 0)
+    return FALSE;
+
   if (journal->entries->len == 0)
     return TRUE;
 
@@ -1278,6 +1327,92 @@ post_fences (CoglJournal *journal)
     }
 }
 
+static void
+_cogl_journal_flush_primitives (CoglJournal *journal)
+{
+  CoglJournalPrimitives batch;
+  CoglJournalPrimitives *primitives = &batch;
+  CoglFramebuffer *framebuffer = journal->framebuffer;
+  CoglContext *ctx = framebuffer->context;
+  CoglPipeline *pipeline;
+  CoglMatrixStack *projection_stack;
+  COGL_STATIC_TIMER (flush_primitives_timer,
+                     "Mainloop", /* parent */
+                     "Journal Flush Primitives",
+                     "The time spent drawing batched primitives",
+                     0 /* no application private data */);
+
+  _cogl_framebuffer_flush_dependency_journals (framebuffer);
+
+  COGL_TIMER_START (flush_primitives_timer);
+
+  /* Take the batch out of the journal before drawing it so that the
+   * journal is empty if anything below ends up flushing it again */
+  batch = journal->primitives;
+  journal->primitives.n_draws = 0;
+
+  pipeline = primitives->pipeline;
+
+  if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
+    g_print ("BATCHING: primitive batch len = %d\n", primitives->n_draws);
+
+  /* The modelview and clip state are flushed manually in the same way
+   * as for the journal entries */
+  _cogl_framebuffer_flush_state (framebuffer,
+                                 framebuffer,
+                                 COGL_FRAMEBUFFER_STATE_ALL &
+                                 ~(COGL_FRAMEBUFFER_STATE_MODELVIEW |
+                                   COGL_FRAMEBUFFER_STATE_CLIP));
+
+  _cogl_clip_stack_flush (primitives->clip_stack, framebuffer);
+
+  ctx->current_draw_buffer_changes |= (COGL_FRAMEBUFFER_STATE_MODELVIEW |
+                                       COGL_FRAMEBUFFER_STATE_CLIP);
+
+  /* Flushing the clip stack can modify the current matrix entries */
+  _cogl_context_set_current_modelview_entry (ctx,
+                                             primitives->modelview_entry);
+  projection_stack = _cogl_framebuffer_get_projection_stack (framebuffer);
+  _cogl_context_set_current_projection_entry (ctx,
+                                              projection_stack->last_entry);
+
+  /* Changing only the color of a pipeline doesn't flush the journal
+   * because the color of rectangles is logged in the vertices. The
+   * primitives use the color of the pipeline so in that case they
+   * need to be drawn with a copy that has the old color */
+  if (G_UNLIKELY (_cogl_pipeline_get_age (pipeline) !=
+                  primitives->pipeline_age))
+    {
+      pipeline = cogl_pipeline_copy (pipeline);
+      cogl_pipeline_set_color (pipeline, &primitives->pipeline_color);
+    }
+
+  ctx->driver_vtable->framebuffer_multi_draw_attributes
+    (framebuffer,
+     pipeline,
+     primitives->mode,
+     primitives->first_vertices,
+     primitives->n_vertices,
+     primitives->n_draws,
+     primitives->indices,
+     primitives->attributes,
+     primitives->n_attributes,
+     /* The layers were validated when the primitives were logged */
+     COGL_DRAW_SKIP_JOURNAL_FLUSH |
+     COGL_DRAW_SKIP_PIPELINE_VALIDATION |
+     COGL_DRAW_SKIP_FRAMEBUFFER_FLUSH);
+
+  if (pipeline != primitives->pipeline)
+    cogl_object_unref (pipeline);
+
+  unref_primitives (primitives, framebuffer);
+
+  /* The batch held a reference to the framebuffer */
+  cogl_object_unref (framebuffer);
+
+  COGL_TIMER_STOP (flush_primitives_timer);
+}
+
 /* XXX NB: When _cogl_journal_flush() returns all state relating
  * to pipelines, all glEnable flags and current matrix state
  * is undefined.
@@ -1302,6 +1437,11 @@ _cogl_journal_flush (CoglJournal *journal)
 
   if (journal->entries->len == 0)
     {
+      /* There can only be batched primitives when there are no
+         entries */
+      if (journal->primitives.n_draws > 0)
+        _cogl_journal_flush_primitives (journal);
+
       post_fences (journal);
       return;
     }
@@ -1317,7 +1457,7 @@ _cogl_journal_flush (CoglJournal *journal)
 
   /* Note: we start the timer after flushing dependency journals so
    * that the timer isn't started recursively. */
-  COGL_TIMER_START (_cogl_uprof_context, flush_timer);
+  COGL_TIMER_START (flush_timer);
 
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_BATCHING)))
     g_print ("BATCHING: journal len = %d\n", journal->entries->len);
@@ -1398,13 +1538,13 @@ _cogl_journal_flush (CoglJournal *journal)
 
   cogl_object_unref (state.attribute_buffer);
 
-  COGL_TIMER_START (_cogl_uprof_context, discard_timer);
+  COGL_TIMER_START (discard_timer);
   _cogl_journal_discard (journal);
-  COGL_TIMER_STOP (_cogl_uprof_context, discard_timer);
+  COGL_TIMER_STOP (discard_timer);
 
   post_fences (journal);
 
-  COGL_TIMER_STOP (_cogl_uprof_context, flush_timer);
+  COGL_TIMER_STOP (flush_timer);
 }
 
 static CoglBool
@@ -1450,7 +1590,12 @@ _cogl_journal_log_quad (CoglJournal  *journal,
                      "The time spent logging in the Cogl journal",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, log_timer);
+  COGL_TIMER_START (log_timer);
+
+  /* Draw any batched primitives first so that they stay in order with
+   * the rectangles */
+  if (journal->primitives.n_draws > 0)
+    _cogl_journal_flush (journal);
 
   /* Adding something to the journal should mean that we are in the
    * middle of the scene. Although this will also end up being set
@@ -1558,7 +1703,7 @@ _cogl_journal_log_quad (CoglJournal  *journal,
   if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_BATCHING)))
     _cogl_journal_flush (journal);
 
-  COGL_TIMER_STOP (_cogl_uprof_context, log_timer);
+  COGL_TIMER_STOP (log_timer);
 }
 
 static void
@@ -1750,6 +1895,11 @@ _cogl_journal_try_read_pixel (CoglJournal *journal,
   if (journal->fast_read_pixel_count > 50)
     return FALSE;
 
+  /* The batched primitives would have to be rasterized to find out
+   * which pixels they touch */
+  if (journal->primitives.n_draws > 0)
+    return FALSE;
+
   format = cogl_bitmap_get_format (bitmap);
 
   if (format != COGL_PIXEL_FORMAT_RGBA_8888_PRE &&
@@ -1840,3 +1990,230 @@ success:
   journal->fast_read_pixel_count++;
   return TRUE;
 }
+
+static CoglBool
+attributes_equal (CoglAttribute *a,
+                  CoglAttribute *b)
+{
+  return (a == b ||
+          (a->name_state == b->name_state &&
+           a->normalized == b->normalized &&
+           a->d.buffered.attribute_buffer == b->d.buffered.attribute_buffer &&
+           a->d.buffered.stride == b->d.buffered.stride &&
+           a->d.buffered.offset == b->d.buffered.offset &&
+           a->d.buffered.n_components == b->d.buffered.n_components &&
+           a->d.buffered.type == b->d.buffered.type));
+}
+
+static CoglBool
+can_batch_primitive (CoglJournalPrimitives *primitives,
+                     CoglPrimitive *primitive,
+                     CoglPipeline *pipeline,
+                     CoglMatrixEntry *modelview_entry,
+                     CoglClipStack *clip_stack)
+{
+  int i;
+
+  if (primitives->n_draws >= COGL_JOURNAL_MAX_BATCHED_PRIMITIVES ||
+      pipeline != primitives->pipeline ||
+      _cogl_pipeline_get_age (pipeline) != primitives->pipeline_age ||
+      clip_stack != primitives->clip_stack ||
+      primitive->mode != primitives->mode ||
+      primitive->n_attributes != primitives->n_attributes)
+    return FALSE;
+
+  if (modelview_entry != primitives->modelview_entry &&
+      !cogl_matrix_entry_equal (modelview_entry,
+                                primitives->modelview_entry))
+    return FALSE;
+
+  if (primitive->indices || primitives->indices)
+    {
+      size_t index_size;
+
+      if (primitive->indices == NULL ||
+          primitives->indices == NULL ||
+          primitive->indices->buffer != primitives->indices->buffer ||
+          primitive->indices->type != primitives->indices->type)
+        return FALSE;
+
+      /* The indices are drawn relative to the offset of the first
+       * primitive's indices so the offsets need to be aligned */
+      index_size = _cogl_indices_type_get_size (primitive->indices->type);
+      if ((primitive->indices->offset - primitives->indices->offset) %
+          index_size)
+        return FALSE;
+    }
+
+  for (i = 0; i < primitive->n_attributes; i++)
+    if (!attributes_equal (primitive->attributes[i],
+                           primitives->attributes[i]))
+      return FALSE;
+
+  return TRUE;
+}
+
+static void
+start_primitives (CoglJournal *journal,
+                  CoglPrimitive *primitive,
+                  CoglPipeline *pipeline,
+                  CoglMatrixEntry *modelview_entry,
+                  CoglClipStack *clip_stack)
+{
+  CoglJournalPrimitives *primitives = &journal->primitives;
+  int i;
+
+  cogl_object_ref (journal->framebuffer);
+
+  primitives->pipeline = _cogl_pipeline_journal_ref (pipeline);
+  primitives->pipeline_age = _cogl_pipeline_get_age (pipeline);
+  cogl_pipeline_get_color (pipeline, &primitives->pipeline_color);
+
+  primitives->modelview_entry = cogl_matrix_entry_ref (modelview_entry);
+  primitives->clip_stack = _cogl_clip_stack_ref (clip_stack);
+  primitives->mode = primitive->mode;
+
+  primitives->n_attributes = primitive->n_attributes;
+  primitives->attributes = g_new (CoglAttribute *, primitive->n_attributes);
+  for (i = 0; i < primitive->n_attributes; i++)
+    {
+      CoglAttribute *attribute = primitive->attributes[i];
+
+      primitives->attributes[i] = cogl_object_ref (attribute);
+      _cogl_buffer_journal_ref
+        (COGL_BUFFER (attribute->d.buffered.attribute_buffer),
+         journal->framebuffer);
+    }
+
+  if (primitive->indices)
+    {
+      primitives->indices = cogl_object_ref (primitive->indices);
+      _cogl_buffer_journal_ref (COGL_BUFFER (primitive->indices->buffer),
+                                journal->framebuffer);
+    }
+  else
+    primitives->indices = NULL;
+
+  _cogl_pipeline_foreach_layer_internal (pipeline,
+                                         add_framebuffer_deps_cb,
+                                         journal->framebuffer);
+}
+
+static CoglBool
+validate_primitive_layer_cb (CoglPipeline *pipeline,
+                             int layer_index,
+                             void *user_data)
+{
+  CoglTexture *texture =
+    cogl_pipeline_get_layer_texture (pipeline, layer_index);
+  CoglBool *can_batch = user_data;
+
+  if (texture == NULL)
+    return TRUE;
+
+  /* This does the same validation as drawing the primitive directly.
+   * It has to be done now rather than when the journal is flushed
+   * because migrating a texture out of an atlas flushes the journals
+   * and that can't happen in the middle of a flush */
+  _cogl_texture_flush_journal_rendering (texture);
+  _cogl_texture_ensure_non_quad_rendering (texture);
+  _cogl_pipeline_pre_paint_for_layer (pipeline, layer_index);
+
+  /* Sliced textures have to be disabled with a warning which is
+   * left to the direct drawing path */
+  if (!_cogl_texture_can_hardware_repeat (texture))
+    {
+      *can_batch = FALSE;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+CoglBool
+_cogl_journal_log_primitive (CoglJournal *journal,
+                             CoglPrimitive *primitive,
+                             CoglPipeline *pipeline)
+{
+  CoglFramebuffer *framebuffer = journal->framebuffer;
+  CoglJournalPrimitives *primitives = &journal->primitives;
+  CoglMatrixEntry *modelview_entry;
+  CoglClipStack *clip_stack;
+  CoglBool can_batch = TRUE;
+  int first_vertex;
+  int i;
+
+  if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_BATCHING) ||
+                  COGL_DEBUG_ENABLED (COGL_DEBUG_WIREFRAME)))
+    return FALSE;
+
+  /* Constant and per-instance attributes aren't worth handling */
+  for (i = 0; i < primitive->n_attributes; i++)
+    {
+      CoglAttribute *attribute = primitive->attributes[i];
+
+      if (!attribute->is_buffered ||
+          attribute->d.buffered.instance_divisor != 0)
+        return FALSE;
+    }
+
+  /* This may flush the journal */
+  cogl_pipeline_foreach_layer (pipeline,
+                               validate_primitive_layer_cb,
+                               &can_batch);
+  if (!can_batch)
+    return FALSE;
+
+  modelview_entry =
+    _cogl_framebuffer_get_modelview_stack (framebuffer)->last_entry;
+  clip_stack = _cogl_framebuffer_get_clip_stack (framebuffer);
+
+  if (primitives->n_draws > 0 &&
+      !can_batch_primitive (primitives,
+                            primitive,
+                            pipeline,
+                            modelview_entry,
+                            clip_stack))
+    _cogl_journal_flush (journal);
+
+  first_vertex = primitive->first_vertex;
+
+  if (primitives->n_draws == 0)
+    {
+      /* Draw any rectangles that were logged before the primitive */
+      _cogl_journal_flush (journal);
+
+      start_primitives (journal,
+                        primitive,
+                        pipeline,
+                        modelview_entry,
+                        clip_stack);
+    }
+  else if (primitive->indices)
+    {
+      int index_size = _cogl_indices_type_get_size (primitive->indices->type);
+
+      /* The first vertex is relative to the offset of the indices of
+       * the first primitive in the batch */
+      first_vertex += (((int) primitive->indices->offset -
+                        (int) primitives->indices->offset) /
+                       index_size);
+    }
+
+  primitives->first_vertices[primitives->n_draws] = first_vertex;
+  primitives->n_vertices[primitives->n_draws] = primitive->n_vertices;
+  primitives->n_draws++;
+
+  /* Adding something to the journal should mean that we are in the
+   * middle of the scene */
+  _cogl_framebuffer_mark_mid_scene (framebuffer);
+
+  return TRUE;
+}
+
+CoglBool
+_cogl_journal_is_empty (CoglJournal *journal)
+{
+  return (journal->entries->len == 0 &&
+          journal->primitives.n_draws == 0);
+}
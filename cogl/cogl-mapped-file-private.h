@@ -0,0 +1,75 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifndef __COGL_MAPPED_FILE_PRIVATE_H
+#define __COGL_MAPPED_FILE_PRIVATE_H
+
+#include "cogl-types.h"
+#include "cogl-error.h"
+
+/* A private copy of the contents of a file. Where mmap is available
+ * the file is mapped copy-on-write so that pages are only read from
+ * disk when they are touched. Otherwise the whole file is read into
+ * memory. Either way the data can be written to without affecting
+ * the file. */
+typedef struct _CoglMappedFile
+{
+  uint8_t *data;
+  size_t size;
+  CoglBool is_mapped;
+} CoglMappedFile;
+
+/*
+ * _cogl_mapped_file_new:
+ * @filename: The file to open
+ * @error: A #CoglError return location
+ *
+ * Maps the file into memory. The mapping is private to the process so
+ * the data can be modified in place without affecting the file. This
+ * is used to premultiply decoded images in place.
+ *
+ * Pages that haven't been touched yet are still read from the file.
+ * If another process truncates the file while it is mapped then
+ * touching the pages past the new end of the file will raise SIGBUS.
+ * This is the same trade-off that any mmap based loader makes so
+ * callers that can't trust their files not to change should load
+ * them some other way.
+ *
+ * Return value: a new #CoglMappedFile or %NULL if the file couldn't
+ *   be opened.
+ */
+CoglMappedFile *
+_cogl_mapped_file_new (const char *filename,
+                       CoglError **error);
+
+void
+_cogl_mapped_file_free (CoglMappedFile *file);
+
+#endif /* __COGL_MAPPED_FILE_PRIVATE_H */
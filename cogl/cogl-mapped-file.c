@@ -0,0 +1,199 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+
+#if defined (HAVE_SYS_MMAN_H) && defined (HAVE_MMAP)
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define COGL_MAPPED_FILE_USE_MMAP
+#endif
+
+#include "cogl-util.h"
+#include "cogl-mapped-file-private.h"
+#include "cogl-bitmap.h"
+#include "cogl-error-private.h"
+
+static void
+set_open_error (CoglError **error,
+                const char *filename,
+                int errnum)
+{
+  _cogl_set_error (error,
+                   COGL_BITMAP_ERROR,
+                   COGL_BITMAP_ERROR_FAILED,
+                   "Failed to open %s: %s",
+                   filename,
+                   strerror (errnum));
+}
+
+#ifdef COGL_MAPPED_FILE_USE_MMAP
+
+static CoglBool
+map_file (CoglMappedFile *file,
+          const char *filename,
+          CoglError **error)
+{
+  struct stat buf;
+  void *data;
+  int fd;
+
+  fd = open (filename, O_RDONLY);
+  if (fd == -1)
+    {
+      set_open_error (error, filename, errno);
+      return FALSE;
+    }
+
+  if (fstat (fd, &buf) == -1)
+    {
+      set_open_error (error, filename, errno);
+      close (fd);
+      return FALSE;
+    }
+
+  file->size = buf.st_size;
+
+  /* mmap doesn't accept an empty mapping so we'll just use a NULL
+     pointer for empty files */
+  if (file->size == 0)
+    {
+      file->data = NULL;
+      file->is_mapped = FALSE;
+      close (fd);
+      return TRUE;
+    }
+
+  /* The mapping is writable so that images can be converted in
+     place. MAP_PRIVATE makes the writes copy the pages instead of
+     changing the file */
+  data = mmap (NULL,
+               file->size,
+               PROT_READ | PROT_WRITE,
+               MAP_PRIVATE,
+               fd,
+               0);
+
+  /* The mapping keeps its own reference to the file */
+  close (fd);
+
+  if (data == MAP_FAILED)
+    {
+      set_open_error (error, filename, errno);
+      return FALSE;
+    }
+
+  file->data = data;
+  file->is_mapped = TRUE;
+
+  return TRUE;
+}
+
+#else /* COGL_MAPPED_FILE_USE_MMAP */
+
+static CoglBool
+map_file (CoglMappedFile *file,
+          const char *filename,
+          CoglError **error)
+{
+  FILE *stream;
+  long size;
+
+  stream = fopen (filename, "rb");
+  if (stream == NULL)
+    {
+      set_open_error (error, filename, errno);
+      return FALSE;
+    }
+
+  if (fseek (stream, 0, SEEK_END) != 0 ||
+      (size = ftell (stream)) < 0 ||
+      fseek (stream, 0, SEEK_SET) != 0)
+    {
+      set_open_error (error, filename, errno);
+      fclose (stream);
+      return FALSE;
+    }
+
+  file->size = size;
+  file->data = g_malloc (MAX (size, 1));
+  file->is_mapped = FALSE;
+
+  if (fread (file->data, 1, size, stream) != size)
+    {
+      set_open_error (error, filename, errno);
+      g_free (file->data);
+      fclose (stream);
+      return FALSE;
+    }
+
+  fclose (stream);
+
+  return TRUE;
+}
+
+#endif /* COGL_MAPPED_FILE_USE_MMAP */
+
+CoglMappedFile *
+_cogl_mapped_file_new (const char *filename,
+                       CoglError **error)
+{
+  CoglMappedFile *file = g_slice_new (CoglMappedFile);
+
+  if (!map_file (file, filename, error))
+    {
+      g_slice_free (CoglMappedFile, file);
+      return NULL;
+    }
+
+  return file;
+}
+
+void
+_cogl_mapped_file_free (CoglMappedFile *file)
+{
+#ifdef COGL_MAPPED_FILE_USE_MMAP
+  if (file->is_mapped)
+    munmap (file->data, file->size);
+#else
+  g_free (file->data);
+#endif
+
+  g_slice_free (CoglMappedFile, file);
+}
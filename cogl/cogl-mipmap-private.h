@@ -0,0 +1,130 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifndef __COGL_MIPMAP_PRIVATE_H
+#define __COGL_MIPMAP_PRIVATE_H
+
+#include "cogl-types.h"
+#include "cogl-texture.h"
+#include "cogl-worker-pool-private.h"
+
+/*
+ * A CPU implementation of mipmap generation. This can be used when
+ * the pixel data is already on the CPU so that the levels can be
+ * built in the background instead of stalling the first paint with
+ * glGenerateMipmap. The filters never read outside of the given
+ * rectangle so it can also be used on one image of an atlas without
+ * its neighbours bleeding in.
+ */
+
+typedef enum
+{
+  /* Average of each 2×2 block of texels. This matches what
+     glGenerateMipmap usually does */
+  COGL_MIPMAP_FILTER_BOX,
+  /* A 4×4 Kaiser-windowed sinc filter. This keeps more detail in the
+     smaller levels */
+  COGL_MIPMAP_FILTER_KAISER
+} CoglMipmapFilter;
+
+typedef enum
+{
+  COGL_MIPMAP_FLAG_NONE = 0,
+  /* The colour components are sRGB encoded so they are converted to
+     linear light before being averaged */
+  COGL_MIPMAP_FLAG_SRGB = 1 << 0
+} CoglMipmapFlags;
+
+typedef struct
+{
+  int width;
+  int height;
+  int rowstride;
+  uint8_t *data;
+} CoglMipmapLevel;
+
+/*
+ * _cogl_mipmap_build:
+ * @pool: A #CoglWorkerPool to split the work over or %NULL to do
+ *   everything in the calling thread
+ * @data: The top-left pixel of the base level. This must be in a
+ *   premultiplied 32-bit format with alpha in the last byte such as
+ *   %COGL_PIXEL_FORMAT_RGBA_8888_PRE.
+ * @width: The width of the base level
+ * @height: The height of the base level
+ * @rowstride: The rowstride of @data
+ * @filter: The #CoglMipmapFilter to use
+ * @flags: #CoglMipmapFlags
+ * @n_levels: Return location for the number of levels that were
+ *   built
+ *
+ * Builds every level below the base level down to 1×1. Each level
+ * is built from the previous one. The rows of each level are split
+ * into bands that are filtered on the worker pool. The worker
+ * threads only touch the pixel data so this can be called for data
+ * that is about to be uploaded in the same format.
+ *
+ * Returns: A newly allocated array of levels where the first entry
+ *   is level 1. Free with _cogl_mipmap_free_levels().
+ */
+CoglMipmapLevel *
+_cogl_mipmap_build (CoglWorkerPool *pool,
+                    const uint8_t *data,
+                    int width,
+                    int height,
+                    int rowstride,
+                    CoglMipmapFilter filter,
+                    CoglMipmapFlags flags,
+                    int *n_levels);
+
+void
+_cogl_mipmap_free_levels (CoglMipmapLevel *levels,
+                          int n_levels);
+
+/*
+ * _cogl_mipmap_upload:
+ * @texture: A #CoglTexture whose base level has already been set
+ * @format: The format of the data in @levels
+ * @levels: Levels returned by _cogl_mipmap_build()
+ * @n_levels: The number of entries in @levels
+ * @error: A #CoglError to return exceptional errors or %NULL
+ *
+ * Uploads each level in turn. If @texture is a #CoglTexture2D its
+ * mipmaps are then considered up to date so they won't be
+ * regenerated on the GPU until the texture is next modified.
+ */
+CoglBool
+_cogl_mipmap_upload (CoglTexture *texture,
+                     CoglPixelFormat format,
+                     const CoglMipmapLevel *levels,
+                     int n_levels,
+                     CoglError **error);
+
+#endif /* __COGL_MIPMAP_PRIVATE_H */
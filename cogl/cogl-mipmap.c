@@ -0,0 +1,452 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include <test-fixtures/test-unit.h>
+
+#include "cogl-util.h"
+#include "cogl-mipmap-private.h"
+#include "cogl-texture-2d-private.h"
+#include "cogl-bitmap.h"
+
+/* The number of destination rows that are given to a worker at a
+   time */
+#define ROWS_PER_BAND 32
+
+#define MAX_TAPS 4
+
+typedef struct
+{
+  int n_taps;
+  /* Offset of the first tap from twice the destination position */
+  int first_tap;
+  /* Weights out of 256 */
+  int weights[MAX_TAPS];
+} CoglMipmapKernel;
+
+static const CoglMipmapKernel
+kernels[] =
+  {
+    /* COGL_MIPMAP_FILTER_BOX */
+    { 2, 0, { 128, 128 } },
+    /* COGL_MIPMAP_FILTER_KAISER. This is sinc (x / 2) windowed by a
+       Kaiser window with a width of 2 and β = 4, sampled at the
+       centres of the four nearest source texels */
+    { 4, -1, { 14, 114, 114, 14 } }
+  };
+
+typedef struct
+{
+  const CoglMipmapKernel *kernel;
+  CoglMipmapFlags flags;
+
+  const uint8_t *src;
+  int src_width;
+  int src_height;
+  int src_rowstride;
+
+  uint8_t *dst;
+  int dst_width;
+  int dst_height;
+  int dst_rowstride;
+} CoglMipmapDownsampleState;
+
+static float srgb_to_linear_table[256];
+static CoglBool srgb_to_linear_table_initialized = FALSE;
+
+static void
+init_srgb_to_linear_table (void)
+{
+  int i;
+
+  if (srgb_to_linear_table_initialized)
+    return;
+
+  for (i = 0; i < 256; i++)
+    {
+      float v = i / 255.0f;
+
+      if (v <= 0.04045f)
+        srgb_to_linear_table[i] = v / 12.92f;
+      else
+        srgb_to_linear_table[i] = powf ((v + 0.055f) / 1.055f, 2.4f);
+    }
+
+  srgb_to_linear_table_initialized = TRUE;
+}
+
+static float
+linear_to_srgb (float v)
+{
+  if (v <= 0.0031308f)
+    return v * 12.92f;
+  else
+    return 1.055f * powf (v, 1.0f / 2.4f) - 0.055f;
+}
+
+static void
+get_taps (const CoglMipmapKernel *kernel,
+          int dst_pos,
+          int src_size,
+          int *taps)
+{
+  int i;
+
+  /* Clamping to the edge means that nothing outside of the source
+     rectangle is ever read */
+  for (i = 0; i < kernel->n_taps; i++)
+    taps[i] = CLAMP (dst_pos * 2 + kernel->first_tap + i, 0, src_size - 1);
+}
+
+static void
+downsample_row (const CoglMipmapDownsampleState *state,
+                int y)
+{
+  const CoglMipmapKernel *kernel = state->kernel;
+  uint8_t *dst = state->dst + y * state->dst_rowstride;
+  int rows[MAX_TAPS], columns[MAX_TAPS];
+  int x, tx, ty;
+
+  get_taps (kernel, y, state->src_height, rows);
+
+  for (x = 0; x < state->dst_width; x++)
+    {
+      /* The data is premultiplied so the colour components can be
+         averaged directly without semi-transparent texels having
+         too much influence */
+      uint32_t sum[4] = { 0, 0, 0, 0 };
+
+      get_taps (kernel, x, state->src_width, columns);
+
+      for (ty = 0; ty < kernel->n_taps; ty++)
+        {
+          const uint8_t *src_row = (state->src +
+                                    rows[ty] * state->src_rowstride);
+
+          for (tx = 0; tx < kernel->n_taps; tx++)
+            {
+              const uint8_t *p = src_row + columns[tx] * 4;
+              uint32_t weight = kernel->weights[ty] * kernel->weights[tx];
+
+              sum[0] += p[0] * weight;
+              sum[1] += p[1] * weight;
+              sum[2] += p[2] * weight;
+              sum[3] += p[3] * weight;
+            }
+        }
+
+      dst[x * 4 + 0] = (sum[0] + 32768) >> 16;
+      dst[x * 4 + 1] = (sum[1] + 32768) >> 16;
+      dst[x * 4 + 2] = (sum[2] + 32768) >> 16;
+      dst[x * 4 + 3] = (sum[3] + 32768) >> 16;
+    }
+}
+
+static void
+downsample_row_srgb (const CoglMipmapDownsampleState *state,
+                     int y)
+{
+  const CoglMipmapKernel *kernel = state->kernel;
+  uint8_t *dst = state->dst + y * state->dst_rowstride;
+  int rows[MAX_TAPS], columns[MAX_TAPS];
+  int x, tx, ty, i;
+
+  get_taps (kernel, y, state->src_height, rows);
+
+  for (x = 0; x < state->dst_width; x++)
+    {
+      float sum[3] = { 0.0f, 0.0f, 0.0f };
+      float alpha = 0.0f;
+
+      get_taps (kernel, x, state->src_width, columns);
+
+      for (ty = 0; ty < kernel->n_taps; ty++)
+        {
+          const uint8_t *src_row = (state->src +
+                                    rows[ty] * state->src_rowstride);
+
+          for (tx = 0; tx < kernel->n_taps; tx++)
+            {
+              const uint8_t *p = src_row + columns[tx] * 4;
+              float weight = (kernel->weights[ty] * kernel->weights[tx] /
+                              65536.0f);
+              float texel_alpha = p[3] / 255.0f;
+
+              if (p[3] == 0)
+                continue;
+
+              /* The sRGB curve applies to the unpremultiplied
+                 colour. The linear values are premultiplied again
+                 before they are summed */
+              for (i = 0; i < 3; i++)
+                {
+                  int v = MIN ((p[i] * 255 + p[3] / 2) / p[3], 255);
+
+                  sum[i] += (srgb_to_linear_table[v] *
+                             texel_alpha * weight);
+                }
+
+              alpha += texel_alpha * weight;
+            }
+        }
+
+      for (i = 0; i < 3; i++)
+        {
+          float v = alpha > 0.0f ? CLAMP (sum[i] / alpha, 0.0f, 1.0f) : 0.0f;
+
+          dst[x * 4 + i] = linear_to_srgb (v) * alpha * 255.0f + 0.5f;
+        }
+
+      dst[x * 4 + 3] = alpha * 255.0f + 0.5f;
+    }
+}
+
+static void
+downsample_band_cb (int index,
+                    void *user_data)
+{
+  const CoglMipmapDownsampleState *state = user_data;
+  int first_row = index * ROWS_PER_BAND;
+  int end_row = MIN (first_row + ROWS_PER_BAND, state->dst_height);
+  int y;
+
+  for (y = first_row; y < end_row; y++)
+    {
+      if ((state->flags & COGL_MIPMAP_FLAG_SRGB))
+        downsample_row_srgb (state, y);
+      else
+        downsample_row (state, y);
+    }
+}
+
+CoglMipmapLevel *
+_cogl_mipmap_build (CoglWorkerPool *pool,
+                    const uint8_t *data,
+                    int width,
+                    int height,
+                    int rowstride,
+                    CoglMipmapFilter filter,
+                    CoglMipmapFlags flags,
+                    int *n_levels)
+{
+  CoglMipmapDownsampleState state;
+  CoglMipmapLevel *levels;
+  int level_num;
+
+  _COGL_RETURN_VAL_IF_FAIL (filter >= 0 && filter < G_N_ELEMENTS (kernels),
+                            NULL);
+
+  *n_levels = _cogl_util_fls (MAX (width, height)) - 1;
+
+  if (*n_levels == 0)
+    return NULL;
+
+  if ((flags & COGL_MIPMAP_FLAG_SRGB))
+    init_srgb_to_linear_table ();
+
+  levels = g_new (CoglMipmapLevel, *n_levels);
+
+  state.kernel = kernels + filter;
+  state.flags = flags;
+  state.src = data;
+  state.src_width = width;
+  state.src_height = height;
+  state.src_rowstride = rowstride;
+
+  for (level_num = 0; level_num < *n_levels; level_num++)
+    {
+      CoglMipmapLevel *level = levels + level_num;
+      int n_bands;
+      int i;
+
+      level->width = MAX (state.src_width / 2, 1);
+      level->height = MAX (state.src_height / 2, 1);
+      level->rowstride = level->width * 4;
+      level->data = g_malloc (level->rowstride * level->height);
+
+      state.dst = level->data;
+      state.dst_width = level->width;
+      state.dst_height = level->height;
+      state.dst_rowstride = level->rowstride;
+
+      n_bands = (level->height + ROWS_PER_BAND - 1) / ROWS_PER_BAND;
+
+      /* Each level depends on the previous one so only the bands
+         within a level are run in parallel */
+      if (pool)
+        _cogl_worker_pool_run (pool, n_bands, downsample_band_cb, &state);
+      else
+        for (i = 0; i < n_bands; i++)
+          downsample_band_cb (i, &state);
+
+      state.src = level->data;
+      state.src_width = level->width;
+      state.src_height = level->height;
+      state.src_rowstride = level->rowstride;
+    }
+
+  return levels;
+}
+
+void
+_cogl_mipmap_free_levels (CoglMipmapLevel *levels,
+                          int n_levels)
+{
+  int i;
+
+  for (i = 0; i < n_levels; i++)
+    g_free (levels[i].data);
+
+  g_free (levels);
+}
+
+CoglBool
+_cogl_mipmap_upload (CoglTexture *texture,
+                     CoglPixelFormat format,
+                     const CoglMipmapLevel *levels,
+                     int n_levels,
+                     CoglError **error)
+{
+  CoglContext *ctx = texture->context;
+  int i;
+
+  for (i = 0; i < n_levels; i++)
+    {
+      const CoglMipmapLevel *level = levels + i;
+      CoglBitmap *bitmap;
+      CoglBool status;
+
+      bitmap = cogl_bitmap_new_for_data (ctx,
+                                         level->width,
+                                         level->height,
+                                         format,
+                                         level->rowstride,
+                                         level->data);
+
+      status = cogl_texture_set_region_from_bitmap (texture,
+                                                    0, 0, /* src_x/y */
+                                                    level->width,
+                                                    level->height,
+                                                    bitmap,
+                                                    0, 0, /* dst_x/y */
+                                                    i + 1, /* level */
+                                                    error);
+
+      cogl_object_unref (bitmap);
+
+      if (!status)
+        return FALSE;
+    }
+
+  /* Uploading the levels will have marked the mipmaps as dirty but
+     they are now actually complete */
+  if (cogl_is_texture_2d (texture))
+    COGL_TEXTURE_2D (texture)->mipmaps_dirty = FALSE;
+
+  return TRUE;
+}
+
+UNIT_TEST (check_mipmap_filters,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  /* A 3×2 image. The third column should only affect the Kaiser
+     filter */
+  static const uint8_t image[] =
+    {
+      0xff, 0x00, 0x00, 0xff,  0x00, 0x00, 0x00, 0x00,  0x00, 0xff, 0x00, 0xff,
+      0x00, 0x00, 0x00, 0x00,  0x80, 0x80, 0x80, 0x80,  0x00, 0xff, 0x00, 0xff
+    };
+  CoglMipmapLevel *levels;
+  int n_levels;
+
+  levels = _cogl_mipmap_build (NULL, image, 3, 2, 3 * 4,
+                               COGL_MIPMAP_FILTER_BOX,
+                               COGL_MIPMAP_FLAG_NONE,
+                               &n_levels);
+  g_assert_cmpint (n_levels, ==, 1);
+  g_assert_cmpint (levels[0].width, ==, 1);
+  g_assert_cmpint (levels[0].height, ==, 1);
+  /* The data is premultiplied so the transparent texels don't pull
+     the colour towards black any more than they reduce the alpha */
+  g_assert_cmpint (levels[0].data[0], ==, 0x60);
+  g_assert_cmpint (levels[0].data[1], ==, 0x20);
+  g_assert_cmpint (levels[0].data[2], ==, 0x20);
+  g_assert_cmpint (levels[0].data[3], ==, 0x60);
+  _cogl_mipmap_free_levels (levels, n_levels);
+
+  /* With the Kaiser filter the taps outside of the image are clamped
+     so the first column gets extra weight and the third column
+     contributes a little */
+  levels = _cogl_mipmap_build (NULL, image, 3, 2, 3 * 4,
+                               COGL_MIPMAP_FILTER_KAISER,
+                               COGL_MIPMAP_FLAG_NONE,
+                               &n_levels);
+  g_assert_cmpint (n_levels, ==, 1);
+  g_assert_cmpint (levels[0].data[0], ==, 0x5c);
+  g_assert_cmpint (levels[0].data[1], ==, 0x2a);
+  g_assert_cmpint (levels[0].data[2], ==, 0x1d);
+  g_assert_cmpint (levels[0].data[3], ==, 0x6a);
+  _cogl_mipmap_free_levels (levels, n_levels);
+}
+
+UNIT_TEST (check_mipmap_srgb,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  /* Black and white texels in a 2×1 image */
+  static const uint8_t image[] =
+    {
+      0x00, 0x00, 0x00, 0xff,  0xff, 0xff, 0xff, 0xff
+    };
+  CoglMipmapLevel *levels;
+  int n_levels;
+
+  levels = _cogl_mipmap_build (NULL, image, 2, 1, 2 * 4,
+                               COGL_MIPMAP_FILTER_BOX,
+                               COGL_MIPMAP_FLAG_NONE,
+                               &n_levels);
+  g_assert_cmpint (levels[0].data[0], ==, 0x80);
+  _cogl_mipmap_free_levels (levels, n_levels);
+
+  /* Half of the light of white is 0xbc in sRGB */
+  levels = _cogl_mipmap_build (NULL, image, 2, 1, 2 * 4,
+                               COGL_MIPMAP_FILTER_BOX,
+                               COGL_MIPMAP_FLAG_SRGB,
+                               &n_levels);
+  g_assert_cmpint (levels[0].data[0], ==, 0xbc);
+  g_assert_cmpint (levels[0].data[3], ==, 0xff);
+  _cogl_mipmap_free_levels (levels, n_levels);
+}
@@ -41,6 +41,7 @@
 #include "cogl-object-private.h"
 #include "cogl-closure-list-private.h"
 #include "cogl-poll-private.h"
+#include "cogl-texture-residency-private.h"
 
 static void _cogl_onscreen_free (CoglOnscreen *onscreen);
 
@@ -255,6 +256,11 @@ cogl_onscreen_swap_buffers_with_damage (CoglOnscreen *onscreen,
   winsys = _cogl_framebuffer_get_winsys (framebuffer);
   winsys->onscreen_swap_buffers_with_damage (onscreen,
                                              rectangles, n_rectangles);
+
+  /* The contents of the stencil buffer are undefined after a swap so
+     a clip stack can't be reused in the next frame even if it is the
+     same */
+  _cogl_framebuffer_forget_stencil_clip (framebuffer);
   cogl_framebuffer_discard_buffers (framebuffer,
                                     COGL_BUFFER_BIT_COLOR |
                                     COGL_BUFFER_BIT_DEPTH |
@@ -276,6 +282,9 @@ cogl_onscreen_swap_buffers_with_damage (CoglOnscreen *onscreen,
 
   onscreen->frame_counter++;
   framebuffer->mid_scene = FALSE;
+
+  _cogl_texture_residency_end_frame (framebuffer->context);
+  _cogl_profile_end_frame (framebuffer->context);
 }
 
 void
@@ -311,6 +320,8 @@ cogl_onscreen_swap_region (CoglOnscreen *onscreen,
                                 rectangles,
                                 n_rectangles);
 
+  _cogl_framebuffer_forget_stencil_clip (framebuffer);
+
   cogl_framebuffer_discard_buffers (framebuffer,
                                     COGL_BUFFER_BIT_COLOR |
                                     COGL_BUFFER_BIT_DEPTH |
@@ -332,6 +343,9 @@ cogl_onscreen_swap_region (CoglOnscreen *onscreen,
 
   onscreen->frame_counter++;
   framebuffer->mid_scene = FALSE;
+
+  _cogl_texture_residency_end_frame (framebuffer->context);
+  _cogl_profile_end_frame (framebuffer->context);
 }
 
 int
@@ -532,6 +546,9 @@ _cogl_framebuffer_winsys_update_size (CoglFramebuffer *framebuffer,
   framebuffer->width = width;
   framebuffer->height = height;
 
+  /* The ancillary buffers may have been reallocated with the window */
+  _cogl_framebuffer_forget_stencil_clip (framebuffer);
+
   cogl_framebuffer_set_viewport (framebuffer, 0, 0, width, height);
 
   if (!_cogl_has_private_feature (framebuffer->context,
@@ -94,28 +94,46 @@ _cogl_pipeline_cache_free (CoglPipelineCache *cache)
   g_free (cache);
 }
 
+static CoglPipelineCacheEntry *
+get_template (CoglPipelineHashTable *hash,
+              CoglPipeline *key_pipeline)
+{
+  int n_unique_pipelines = hash->n_unique_pipelines;
+  CoglPipelineCacheEntry *entry;
+
+  _COGL_GET_CONTEXT (ctx, NULL);
+
+  entry = _cogl_pipeline_hash_table_get (hash, key_pipeline);
+
+  /* The hash table only creates a new pipeline when there was no
+   * matching entry */
+  if (hash->n_unique_pipelines == n_unique_pipelines)
+    ctx->frame_stats.n_pipeline_cache_hits++;
+  else
+    ctx->frame_stats.n_pipeline_cache_misses++;
+
+  return entry;
+}
+
 CoglPipelineCacheEntry *
 _cogl_pipeline_cache_get_fragment_template (CoglPipelineCache *cache,
                                             CoglPipeline *key_pipeline)
 {
-  return _cogl_pipeline_hash_table_get (&cache->fragment_hash,
-                                        key_pipeline);
+  return get_template (&cache->fragment_hash, key_pipeline);
 }
 
 CoglPipelineCacheEntry *
 _cogl_pipeline_cache_get_vertex_template (CoglPipelineCache *cache,
                                           CoglPipeline *key_pipeline)
 {
-  return _cogl_pipeline_hash_table_get (&cache->vertex_hash,
-                                        key_pipeline);
+  return get_template (&cache->vertex_hash, key_pipeline);
 }
 
 CoglPipelineCacheEntry *
 _cogl_pipeline_cache_get_combined_template (CoglPipelineCache *cache,
                                             CoglPipeline *key_pipeline)
 {
-  return _cogl_pipeline_hash_table_get (&cache->combined_hash,
-                                        key_pipeline);
+  return get_template (&cache->combined_hash, key_pipeline);
 }
 
 #ifdef ENABLE_UNIT_TESTS
@@ -363,6 +363,14 @@ cogl_pipeline_set_layer_null_texture (CoglPipeline *pipeline,
           texture_type = COGL_TEXTURE_TYPE_2D;
         }
       break;
+
+    case COGL_TEXTURE_TYPE_2D_ARRAY:
+      /* There is no default tiled texture because the tile lookup
+         needs to know the layout of a real texture */
+      g_warning ("A null tiled texture was set on a pipeline but this is "
+                 "not supported");
+      texture_type = COGL_TEXTURE_TYPE_2D;
+      break;
     }
 
   _cogl_pipeline_set_layer_texture_type (pipeline, layer_index, texture_type);
@@ -986,12 +994,10 @@ _cogl_pipeline_layer_texture_data_equal (CoglPipelineLayer *authority0,
     }
 }
 
-CoglBool
-_cogl_pipeline_layer_combine_state_equal (CoglPipelineLayer *authority0,
-                                          CoglPipelineLayer *authority1)
+static CoglBool
+combine_state_equal (const CoglPipelineLayerBigState *big_state0,
+                     const CoglPipelineLayerBigState *big_state1)
 {
-  CoglPipelineLayerBigState *big_state0 = authority0->big_state;
-  CoglPipelineLayerBigState *big_state1 = authority1->big_state;
   int n_args;
   int i;
 
@@ -1028,6 +1034,13 @@ _cogl_pipeline_layer_combine_state_equal (CoglPipelineLayer *authority0,
   return TRUE;
 }
 
+CoglBool
+_cogl_pipeline_layer_combine_state_equal (CoglPipelineLayer *authority0,
+                                          CoglPipelineLayer *authority1)
+{
+  return combine_state_equal (authority0->big_state, authority1->big_state);
+}
+
 CoglBool
 _cogl_pipeline_layer_combine_constant_equal (CoglPipelineLayer *authority0,
                                              CoglPipelineLayer *authority1)
@@ -1173,8 +1186,12 @@ cogl_pipeline_set_layer_combine (CoglPipeline *pipeline,
   CoglBlendStringStatement split[2];
   CoglBlendStringStatement *rgb;
   CoglBlendStringStatement *a;
+  CoglPipelineLayerBigState new_state;
+  CoglPipelineLayerBigState *big_state;
   int count;
 
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
   _COGL_RETURN_VAL_IF_FAIL (cogl_is_pipeline (pipeline), FALSE);
 
   /* Note: this will ensure that the layer exists, creating one if it
@@ -1190,10 +1207,11 @@ cogl_pipeline_set_layer_combine (CoglPipeline *pipeline,
   authority = _cogl_pipeline_layer_get_authority (layer, state);
 
   count =
-    _cogl_blend_string_compile (combine_description,
-                                COGL_BLEND_STRING_CONTEXT_TEXTURE_COMBINE,
-                                statements,
-                                error);
+    _cogl_blend_string_compile_cached (ctx,
+                                       combine_description,
+                                       COGL_BLEND_STRING_CONTEXT_TEXTURE_COMBINE,
+                                       statements,
+                                       error);
   if (!count)
     return FALSE;
 
@@ -1210,20 +1228,43 @@ cogl_pipeline_set_layer_combine (CoglPipeline *pipeline,
       a = &statements[1];
     }
 
-  /* FIXME: compare the new state with the current state! */
-
-  /* possibly flush primitives referencing the current state... */
-  layer = _cogl_pipeline_layer_pre_change_notify (pipeline, layer, state);
+  /* The unused arguments are left as zero so that copying the state
+   * doesn't leave uninitialised values in the layer */
+  memset (&new_state, 0, sizeof (new_state));
 
   setup_texture_combine_state (rgb,
-                               &layer->big_state->texture_combine_rgb_func,
-                               layer->big_state->texture_combine_rgb_src,
-                               layer->big_state->texture_combine_rgb_op);
+                               &new_state.texture_combine_rgb_func,
+                               new_state.texture_combine_rgb_src,
+                               new_state.texture_combine_rgb_op);
 
   setup_texture_combine_state (a,
-                               &layer->big_state->texture_combine_alpha_func,
-                               layer->big_state->texture_combine_alpha_src,
-                               layer->big_state->texture_combine_alpha_op);
+                               &new_state.texture_combine_alpha_func,
+                               new_state.texture_combine_alpha_src,
+                               new_state.texture_combine_alpha_op);
+
+  if (combine_state_equal (authority->big_state, &new_state))
+    return TRUE;
+
+  /* possibly flush primitives referencing the current state... */
+  layer = _cogl_pipeline_layer_pre_change_notify (pipeline, layer, state);
+
+  big_state = layer->big_state;
+
+  big_state->texture_combine_rgb_func = new_state.texture_combine_rgb_func;
+  memcpy (big_state->texture_combine_rgb_src,
+          new_state.texture_combine_rgb_src,
+          sizeof (new_state.texture_combine_rgb_src));
+  memcpy (big_state->texture_combine_rgb_op,
+          new_state.texture_combine_rgb_op,
+          sizeof (new_state.texture_combine_rgb_op));
+
+  big_state->texture_combine_alpha_func = new_state.texture_combine_alpha_func;
+  memcpy (big_state->texture_combine_alpha_src,
+          new_state.texture_combine_alpha_src,
+          sizeof (new_state.texture_combine_alpha_src));
+  memcpy (big_state->texture_combine_alpha_op,
+          new_state.texture_combine_alpha_op,
+          sizeof (new_state.texture_combine_alpha_op));
 
   /* If the original layer we found is currently the authority on
    * the state we are changing see if we can revert to one of our
@@ -57,6 +57,11 @@ _cogl_pipeline_has_vertex_snippets (CoglPipeline *pipeline);
 CoglBool
 _cogl_pipeline_has_fragment_snippets (CoglPipeline *pipeline);
 
+/* Tiled textures can only be sampled with the tile lookup generated
+ * by the GLSL fragend */
+CoglBool
+_cogl_pipeline_has_tiled_textures (CoglPipeline *pipeline);
+
 CoglBool
 _cogl_pipeline_has_non_layer_vertex_snippets (CoglPipeline *pipeline);
 
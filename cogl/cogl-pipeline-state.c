@@ -84,15 +84,12 @@ _cogl_pipeline_alpha_func_reference_state_equal (CoglPipeline *authority0,
           alpha_state1->alpha_func_reference);
 }
 
-CoglBool
-_cogl_pipeline_blend_state_equal (CoglPipeline *authority0,
-                                  CoglPipeline *authority1)
+/* Compares the parts of the blend state that are set by a blend
+   string */
+static CoglBool
+blend_functions_equal (const CoglPipelineBlendState *blend_state0,
+                       const CoglPipelineBlendState *blend_state1)
 {
-  CoglPipelineBlendState *blend_state0 = &authority0->big_state->blend_state;
-  CoglPipelineBlendState *blend_state1 = &authority1->big_state->blend_state;
-
-  _COGL_GET_CONTEXT (ctx, FALSE);
-
   if (blend_state0->blend_equation_rgb != blend_state1->blend_equation_rgb)
     return FALSE;
 
@@ -113,6 +110,21 @@ _cogl_pipeline_blend_state_equal (CoglPipeline *authority0,
       blend_state1->blend_dst_factor_rgb)
     return FALSE;
 
+  return TRUE;
+}
+
+CoglBool
+_cogl_pipeline_blend_state_equal (CoglPipeline *authority0,
+                                  CoglPipeline *authority1)
+{
+  CoglPipelineBlendState *blend_state0 = &authority0->big_state->blend_state;
+  CoglPipelineBlendState *blend_state1 = &authority1->big_state->blend_state;
+
+  _COGL_GET_CONTEXT (ctx, FALSE);
+
+  if (!blend_functions_equal (blend_state0, blend_state1))
+    return FALSE;
+
   if (blend_state0->blend_src_factor_rgb == GL_ONE_MINUS_CONSTANT_COLOR ||
       blend_state0->blend_src_factor_rgb == GL_CONSTANT_COLOR ||
       blend_state0->blend_dst_factor_rgb == GL_ONE_MINUS_CONSTANT_COLOR ||
@@ -637,6 +649,7 @@ cogl_pipeline_set_blend (CoglPipeline *pipeline,
   CoglBlendStringStatement *rgb;
   CoglBlendStringStatement *a;
   int count;
+  CoglPipelineBlendState new_state;
   CoglPipelineBlendState *blend_state;
 
   _COGL_GET_CONTEXT (ctx, FALSE);
@@ -644,10 +657,11 @@ cogl_pipeline_set_blend (CoglPipeline *pipeline,
   _COGL_RETURN_VAL_IF_FAIL (cogl_is_pipeline (pipeline), FALSE);
 
   count =
-    _cogl_blend_string_compile (blend_description,
-                                COGL_BLEND_STRING_CONTEXT_BLENDING,
-                                statements,
-                                error);
+    _cogl_blend_string_compile_cached (ctx,
+                                       blend_description,
+                                       COGL_BLEND_STRING_CONTEXT_BLENDING,
+                                       statements,
+                                       error);
   if (!count)
     return FALSE;
 
@@ -659,9 +673,23 @@ cogl_pipeline_set_blend (CoglPipeline *pipeline,
       a = &statements[1];
     }
 
+  setup_blend_state (rgb,
+                     &new_state.blend_equation_rgb,
+                     &new_state.blend_src_factor_rgb,
+                     &new_state.blend_dst_factor_rgb);
+  setup_blend_state (a,
+                     &new_state.blend_equation_alpha,
+                     &new_state.blend_src_factor_alpha,
+                     &new_state.blend_dst_factor_alpha);
+
   authority =
     _cogl_pipeline_get_authority (pipeline, state);
 
+  /* Setting the same blend string again is common so we avoid
+   * flushing the journal or copying any state in that case */
+  if (blend_functions_equal (&authority->big_state->blend_state, &new_state))
+    return TRUE;
+
   /* - Flush journal primitives referencing the current state.
    * - Make sure the pipeline has no dependants so it may be modified.
    * - If the pipeline isn't currently an authority for the state being
@@ -671,14 +699,12 @@ cogl_pipeline_set_blend (CoglPipeline *pipeline,
 
   blend_state = &pipeline->big_state->blend_state;
 
-  setup_blend_state (rgb,
-                     &blend_state->blend_equation_rgb,
-                     &blend_state->blend_src_factor_rgb,
-                     &blend_state->blend_dst_factor_rgb);
-  setup_blend_state (a,
-                     &blend_state->blend_equation_alpha,
-                     &blend_state->blend_src_factor_alpha,
-                     &blend_state->blend_dst_factor_alpha);
+  blend_state->blend_equation_rgb = new_state.blend_equation_rgb;
+  blend_state->blend_src_factor_rgb = new_state.blend_src_factor_rgb;
+  blend_state->blend_dst_factor_rgb = new_state.blend_dst_factor_rgb;
+  blend_state->blend_equation_alpha = new_state.blend_equation_alpha;
+  blend_state->blend_src_factor_alpha = new_state.blend_src_factor_alpha;
+  blend_state->blend_dst_factor_alpha = new_state.blend_dst_factor_alpha;
 
   /* If we are the current authority see if we can revert to one of our
    * ancestors being the authority */
@@ -1347,6 +1373,34 @@ _cogl_pipeline_has_fragment_snippets (CoglPipeline *pipeline)
   return found_fragment_snippet;
 }
 
+static CoglBool
+check_layer_has_tiled_texture (CoglPipelineLayer *layer,
+                               void *user_data)
+{
+  CoglBool *found_tiled_texture = user_data;
+
+  if (_cogl_pipeline_layer_get_texture_type (layer) ==
+      COGL_TEXTURE_TYPE_2D_ARRAY)
+    {
+      *found_tiled_texture = TRUE;
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+CoglBool
+_cogl_pipeline_has_tiled_textures (CoglPipeline *pipeline)
+{
+  CoglBool found_tiled_texture = FALSE;
+
+  _cogl_pipeline_foreach_layer_internal (pipeline,
+                                         check_layer_has_tiled_texture,
+                                         &found_tiled_texture);
+
+  return found_tiled_texture;
+}
+
 void
 _cogl_pipeline_hash_color_state (CoglPipeline *authority,
                                  CoglPipelineHashState *state)
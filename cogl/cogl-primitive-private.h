@@ -53,6 +53,19 @@ struct _CoglPrimitive
   CoglAttribute **attributes;
   int n_attributes;
 
+  /* If the primitive was created with one of the convenience
+   * constructors from four vertices that exactly cover an axis
+   * aligned rectangle then the rectangle is stored here. This lets
+   * cogl_primitive_draw() log it in the journal instead so that it
+   * can be clipped in software and batched with other rectangles.
+   * The age of the attribute buffer is stored to detect when the
+   * vertices have been modified. */
+  CoglBool is_rectangle;
+  CoglBool rectangle_has_tex_coords;
+  unsigned int rectangle_buffer_age;
+  float rectangle_position[4];
+  float rectangle_tex_coords[4];
+
   int n_embedded_attributes;
   CoglAttribute *embedded_attribute;
 };
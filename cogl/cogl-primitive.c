@@ -41,6 +41,9 @@
 #include "cogl-primitive-private.h"
 #include "cogl-attribute-private.h"
 #include "cogl-framebuffer-private.h"
+#include "cogl-journal-private.h"
+#include "cogl-pipeline-state-private.h"
+#include "cogl-clip-stack.h"
 
 #include <stdarg.h>
 #include <string.h>
@@ -65,6 +68,7 @@ cogl_primitive_new_with_attributes (CoglVerticesMode mode,
   primitive->n_vertices = n_vertices;
   primitive->indices = NULL;
   primitive->immutable_ref = 0;
+  primitive->is_rectangle = FALSE;
 
   primitive->n_attributes = n_attributes;
   primitive->n_embedded_attributes = n_attributes;
@@ -105,6 +109,119 @@ _cogl_primitive_new_with_attributes_unref (CoglVerticesMode mode,
   return primitive;
 }
 
+/* This is used by the builtin struct constructors to check whether
+   the vertices exactly cover an axis aligned rectangle. The position
+   and texture coordinates must be floats within the vertex struct */
+static void
+detect_rectangle (CoglPrimitive *primitive,
+                  const float *data,
+                  int stride,
+                  int n_position_components,
+                  int tex_coord_offset)
+{
+  CoglAttribute *attribute = primitive->attributes[0];
+  float x_1, y_1, x_2, y_2;
+  float s[2], t[2];
+  int corners[4];
+  int seen_corners = 0;
+  int seen_s = 0, seen_t = 0;
+  int opposite_vertex;
+  int i;
+
+  if (primitive->n_vertices != 4)
+    return;
+
+  /* The two triangles only cover the whole rectangle if the given
+     vertex is at the opposite corner to the first vertex */
+  if (primitive->mode == COGL_VERTICES_MODE_TRIANGLE_STRIP)
+    opposite_vertex = 3;
+  else if (primitive->mode == COGL_VERTICES_MODE_TRIANGLE_FAN)
+    opposite_vertex = 2;
+  else
+    return;
+
+  x_1 = x_2 = data[0];
+  y_1 = y_2 = data[1];
+
+  for (i = 1; i < 4; i++)
+    {
+      const float *v = data + i * stride;
+
+      x_1 = MIN (x_1, v[0]);
+      y_1 = MIN (y_1, v[1]);
+      x_2 = MAX (x_2, v[0]);
+      y_2 = MAX (y_2, v[1]);
+    }
+
+  if (x_1 == x_2 || y_1 == y_2)
+    return;
+
+  for (i = 0; i < 4; i++)
+    {
+      const float *v = data + i * stride;
+      int x_side, y_side;
+
+      /* The journal only draws rectangles at z=0 */
+      if (n_position_components > 2 && v[2] != 0.0f)
+        return;
+
+      if (v[0] == x_1)
+        x_side = 0;
+      else if (v[0] == x_2)
+        x_side = 1;
+      else
+        return;
+
+      if (v[1] == y_1)
+        y_side = 0;
+      else if (v[1] == y_2)
+        y_side = 1;
+      else
+        return;
+
+      corners[i] = x_side | (y_side << 1);
+      seen_corners |= 1 << corners[i];
+
+      /* The texture coordinates must be mapped onto the rectangle
+         without any rotation so s can only depend on x and t can only
+         depend on y */
+      if (tex_coord_offset >= 0)
+        {
+          const float *tex_coord = v + tex_coord_offset;
+
+          if ((seen_s & (1 << x_side)) && s[x_side] != tex_coord[0])
+            return;
+          if ((seen_t & (1 << y_side)) && t[y_side] != tex_coord[1])
+            return;
+
+          s[x_side] = tex_coord[0];
+          t[y_side] = tex_coord[1];
+          seen_s |= 1 << x_side;
+          seen_t |= 1 << y_side;
+        }
+    }
+
+  if (seen_corners != 0xf || (corners[0] ^ corners[opposite_vertex]) != 3)
+    return;
+
+  primitive->is_rectangle = TRUE;
+  primitive->rectangle_buffer_age =
+    COGL_BUFFER (attribute->d.buffered.attribute_buffer)->age;
+  primitive->rectangle_position[0] = x_1;
+  primitive->rectangle_position[1] = y_1;
+  primitive->rectangle_position[2] = x_2;
+  primitive->rectangle_position[3] = y_2;
+
+  primitive->rectangle_has_tex_coords = tex_coord_offset >= 0;
+  if (primitive->rectangle_has_tex_coords)
+    {
+      primitive->rectangle_tex_coords[0] = s[0];
+      primitive->rectangle_tex_coords[1] = t[0];
+      primitive->rectangle_tex_coords[2] = s[1];
+      primitive->rectangle_tex_coords[3] = t[1];
+    }
+}
+
 CoglPrimitive *
 cogl_primitive_new (CoglVerticesMode mode,
                     int n_vertices,
@@ -142,6 +259,7 @@ cogl_primitive_new_p2 (CoglContext *ctx,
   CoglAttributeBuffer *attribute_buffer =
     cogl_attribute_buffer_new (ctx, n_vertices * sizeof (CoglVertexP2), data);
   CoglAttribute *attributes[1];
+  CoglPrimitive *primitive;
 
   attributes[0] = cogl_attribute_new (attribute_buffer,
                                       "cogl_position_in",
@@ -152,9 +270,17 @@ cogl_primitive_new_p2 (CoglContext *ctx,
 
   cogl_object_unref (attribute_buffer);
 
-  return _cogl_primitive_new_with_attributes_unref (mode, n_vertices,
-                                                    attributes,
-                                                    1);
+  primitive = _cogl_primitive_new_with_attributes_unref (mode, n_vertices,
+                                                         attributes,
+                                                         1);
+
+  detect_rectangle (primitive,
+                    &data->x,
+                    sizeof (CoglVertexP2) / sizeof (float),
+                    2, /* n_position_components */
+                    -1);
+
+  return primitive;
 }
 
 CoglPrimitive *
@@ -166,6 +292,7 @@ cogl_primitive_new_p3 (CoglContext *ctx,
   CoglAttributeBuffer *attribute_buffer =
     cogl_attribute_buffer_new (ctx, n_vertices * sizeof (CoglVertexP3), data);
   CoglAttribute *attributes[1];
+  CoglPrimitive *primitive;
 
   attributes[0] = cogl_attribute_new (attribute_buffer,
                                       "cogl_position_in",
@@ -176,9 +303,17 @@ cogl_primitive_new_p3 (CoglContext *ctx,
 
   cogl_object_unref (attribute_buffer);
 
-  return _cogl_primitive_new_with_attributes_unref (mode, n_vertices,
-                                                    attributes,
-                                                    1);
+  primitive = _cogl_primitive_new_with_attributes_unref (mode, n_vertices,
+                                                         attributes,
+                                                         1);
+
+  detect_rectangle (primitive,
+                    &data->x,
+                    sizeof (CoglVertexP3) / sizeof (float),
+                    3, /* n_position_components */
+                    -1);
+
+  return primitive;
 }
 
 CoglPrimitive *
@@ -250,6 +385,7 @@ cogl_primitive_new_p2t2 (CoglContext *ctx,
   CoglAttributeBuffer *attribute_buffer =
     cogl_attribute_buffer_new (ctx, n_vertices * sizeof (CoglVertexP2T2), data);
   CoglAttribute *attributes[2];
+  CoglPrimitive *primitive;
 
   attributes[0] = cogl_attribute_new (attribute_buffer,
                                       "cogl_position_in",
@@ -266,9 +402,17 @@ cogl_primitive_new_p2t2 (CoglContext *ctx,
 
   cogl_object_unref (attribute_buffer);
 
-  return _cogl_primitive_new_with_attributes_unref (mode, n_vertices,
-                                                    attributes,
-                                                    2);
+  primitive = _cogl_primitive_new_with_attributes_unref (mode, n_vertices,
+                                                         attributes,
+                                                         2);
+
+  detect_rectangle (primitive,
+                    &data->x,
+                    sizeof (CoglVertexP2T2) / sizeof (float),
+                    2, /* n_position_components */
+                    (offsetof (CoglVertexP2T2, s) / sizeof (float)));
+
+  return primitive;
 }
 
 CoglPrimitive *
@@ -280,6 +424,7 @@ cogl_primitive_new_p3t2 (CoglContext *ctx,
   CoglAttributeBuffer *attribute_buffer =
     cogl_attribute_buffer_new (ctx, n_vertices * sizeof (CoglVertexP3T2), data);
   CoglAttribute *attributes[2];
+  CoglPrimitive *primitive;
 
   attributes[0] = cogl_attribute_new (attribute_buffer,
                                       "cogl_position_in",
@@ -296,9 +441,17 @@ cogl_primitive_new_p3t2 (CoglContext *ctx,
 
   cogl_object_unref (attribute_buffer);
 
-  return _cogl_primitive_new_with_attributes_unref (mode, n_vertices,
-                                                    attributes,
-                                                    2);
+  primitive = _cogl_primitive_new_with_attributes_unref (mode, n_vertices,
+                                                         attributes,
+                                                         2);
+
+  detect_rectangle (primitive,
+                    &data->x,
+                    sizeof (CoglVertexP3T2) / sizeof (float),
+                    3, /* n_position_components */
+                    (offsetof (CoglVertexP3T2, s) / sizeof (float)));
+
+  return primitive;
 }
 
 CoglPrimitive *
@@ -458,6 +611,7 @@ cogl_primitive_set_attributes (CoglPrimitive *primitive,
           sizeof (CoglAttribute *) * n_attributes);
 
   primitive->n_attributes = n_attributes;
+  primitive->is_rectangle = FALSE;
 }
 
 int
@@ -481,6 +635,7 @@ cogl_primitive_set_first_vertex (CoglPrimitive *primitive,
     }
 
   primitive->first_vertex = first_vertex;
+  primitive->is_rectangle = FALSE;
 }
 
 int
@@ -498,6 +653,7 @@ cogl_primitive_set_n_vertices (CoglPrimitive *primitive,
   _COGL_RETURN_IF_FAIL (cogl_is_primitive (primitive));
 
   primitive->n_vertices = n_vertices;
+  primitive->is_rectangle = FALSE;
 }
 
 CoglVerticesMode
@@ -521,6 +677,7 @@ cogl_primitive_set_mode (CoglPrimitive *primitive,
     }
 
   primitive->mode = mode;
+  primitive->is_rectangle = FALSE;
 }
 
 void
@@ -542,6 +699,7 @@ cogl_primitive_set_indices (CoglPrimitive *primitive,
     cogl_object_unref (primitive->indices);
   primitive->indices = indices;
   primitive->n_vertices = n_indices;
+  primitive->is_rectangle = FALSE;
 }
 
 CoglIndices *
@@ -607,11 +765,12 @@ cogl_primitive_foreach_attribute (CoglPrimitive *primitive,
       break;
 }
 
-void
-_cogl_primitive_draw (CoglPrimitive *primitive,
-                      CoglFramebuffer *framebuffer,
-                      CoglPipeline *pipeline,
-                      CoglDrawFlags flags)
+static void
+draw_instances (CoglPrimitive *primitive,
+                CoglFramebuffer *framebuffer,
+                CoglPipeline *pipeline,
+                int n_instances,
+                CoglDrawFlags flags)
 {
   if (primitive->indices)
     _cogl_framebuffer_draw_indexed_attributes (framebuffer,
@@ -619,6 +778,7 @@ _cogl_primitive_draw (CoglPrimitive *primitive,
                                                primitive->mode,
                                                primitive->first_vertex,
                                                primitive->n_vertices,
+                                               n_instances,
                                                primitive->indices,
                                                primitive->attributes,
                                                primitive->n_attributes,
@@ -629,15 +789,140 @@ _cogl_primitive_draw (CoglPrimitive *primitive,
                                        primitive->mode,
                                        primitive->first_vertex,
                                        primitive->n_vertices,
+                                       n_instances,
                                        primitive->attributes,
                                        primitive->n_attributes,
                                        flags);
 }
 
+void
+_cogl_primitive_draw (CoglPrimitive *primitive,
+                      CoglFramebuffer *framebuffer,
+                      CoglPipeline *pipeline,
+                      CoglDrawFlags flags)
+{
+  draw_instances (primitive, framebuffer, pipeline, 1, flags);
+}
+
+/* Checks whether a primitive describing a rectangle can be logged in
+   the journal instead of being drawn directly. This is only worth
+   doing if the rectangle would otherwise need a clip that can't be
+   implemented with the scissor because then the journal has a chance
+   to clip it in software */
+static CoglBool
+can_draw_as_rectangle (CoglPrimitive *primitive,
+                       CoglFramebuffer *framebuffer,
+                       CoglPipeline *pipeline)
+{
+  CoglClipStack *clip_stack = _cogl_framebuffer_get_clip_stack (framebuffer);
+  CoglBool needs_clip = FALSE;
+  CoglClipStack *entry;
+  int n_layers;
+  int i;
+
+  if (clip_stack == NULL)
+    return FALSE;
+
+  /* The journal can only clip in software if every entry is a
+     rectangle */
+  for (entry = clip_stack; entry; entry = entry->parent)
+    {
+      if (entry->type != COGL_CLIP_STACK_RECT)
+        return FALSE;
+      if (!((CoglClipStackRect *) entry)->can_be_scissor)
+        needs_clip = TRUE;
+    }
+
+  if (!needs_clip)
+    return FALSE;
+
+  /* Make sure the vertices haven't been modified since the rectangle
+     was detected */
+  for (i = 0; i < primitive->n_attributes; i++)
+    {
+      CoglAttribute *attribute = primitive->attributes[i];
+
+      if (!attribute->is_buffered ||
+          COGL_BUFFER (attribute->d.buffered.attribute_buffer)->age !=
+          primitive->rectangle_buffer_age ||
+          /* A per-instance attribute doesn't vary across the
+             vertices of the rectangle */
+          attribute->d.buffered.instance_divisor != 0)
+        return FALSE;
+    }
+
+  /* The journal would use different texture coordinates for layers
+     that the primitive doesn't have an attribute for */
+  n_layers = cogl_pipeline_get_n_layers (pipeline);
+  if (n_layers > (primitive->rectangle_has_tex_coords ? 1 : 0))
+    return FALSE;
+
+  /* The journal doesn't preserve the winding of the vertices */
+  if (cogl_pipeline_get_cull_face_mode (pipeline) !=
+      COGL_PIPELINE_CULL_FACE_MODE_NONE)
+    return FALSE;
+
+  if (_cogl_pipeline_has_vertex_snippets (pipeline))
+    return FALSE;
+
+  return TRUE;
+}
+
 void
 cogl_primitive_draw (CoglPrimitive *primitive,
                      CoglFramebuffer *framebuffer,
                      CoglPipeline *pipeline)
 {
+  if (primitive->is_rectangle &&
+      can_draw_as_rectangle (primitive, framebuffer, pipeline))
+    {
+      const float *position = primitive->rectangle_position;
+      const float *tex_coords = primitive->rectangle_tex_coords;
+
+      if (primitive->rectangle_has_tex_coords)
+        cogl_framebuffer_draw_textured_rectangle (framebuffer,
+                                                  pipeline,
+                                                  position[0],
+                                                  position[1],
+                                                  position[2],
+                                                  position[3],
+                                                  tex_coords[0],
+                                                  tex_coords[1],
+                                                  tex_coords[2],
+                                                  tex_coords[3]);
+      else
+        cogl_framebuffer_draw_rectangle (framebuffer,
+                                         pipeline,
+                                         position[0],
+                                         position[1],
+                                         position[2],
+                                         position[3]);
+      return;
+    }
+
+  /* Try to batch the primitive with the previous one so that they can
+   * be drawn together */
+  if (_cogl_journal_log_primitive (framebuffer->journal, primitive, pipeline))
+    return;
+
   _cogl_primitive_draw (primitive, framebuffer, pipeline, 0 /* flags */);
 }
+
+void
+cogl_primitive_draw_instanced (CoglPrimitive *primitive,
+                               CoglFramebuffer *framebuffer,
+                               CoglPipeline *pipeline,
+                               int n_instances)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_primitive (primitive));
+  _COGL_RETURN_IF_FAIL (n_instances >= 0);
+
+  if (n_instances == 0)
+    return;
+
+  _COGL_RETURN_IF_FAIL (n_instances == 1 ||
+                        cogl_has_feature (framebuffer->context,
+                                          COGL_FEATURE_ID_INSTANCED_DRAWING));
+
+  draw_instances (primitive, framebuffer, pipeline, n_instances, 0 /* flags */);
+}
@@ -915,6 +915,32 @@ cogl_primitive_draw (CoglPrimitive *primitive,
                      CoglFramebuffer *framebuffer,
                      CoglPipeline *pipeline);
 
+/**
+ * cogl_primitive_draw_instanced:
+ * @primitive: A #CoglPrimitive geometry object
+ * @framebuffer: A destination #CoglFramebuffer
+ * @pipeline: A #CoglPipeline state object
+ * @n_instances: The number of times to draw the primitive
+ *
+ * Draws @n_instances copies of the given @primitive with a single
+ * draw call. This is the same as calling cogl_primitive_draw()
+ * @n_instances times except that attributes that have an instance
+ * divisor set with cogl_attribute_set_instance_divisor() advance
+ * once per instance instead of once per vertex. With GLSL, vertex
+ * snippets can also use the cogl_instance_id builtin to find out
+ * which instance is being drawn.
+ *
+ * This requires the %COGL_FEATURE_ID_INSTANCED_DRAWING feature.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_primitive_draw_instanced (CoglPrimitive *primitive,
+                               CoglFramebuffer *framebuffer,
+                               CoglPipeline *pipeline,
+                               int n_instances);
+
 
 COGL_END_DECLS
 
@@ -35,6 +35,10 @@
 
 COGL_BEGIN_DECLS
 
+/* The number of layers that can emulate texture repeating in the
+   fragment shader when the texture can't be repeated by the GPU */
+#define COGL_MAX_SHADER_REPEAT_LAYERS 4
+
 /* Draws a rectangle without going through the journal so that it will
    be flushed immediately. This should only be used in situations
    where the code may be called while the journal is already being
@@ -183,6 +183,10 @@ validate_first_layer_cb (CoglPipeline *pipeline,
  *   repeating,
  * - CoglTexturePixmap: if the users given texture coordinates require
  *   repeating
+ *
+ * Repeating is only done here for the textures that aren't sliced if
+ * it can't be emulated in the fragment shader (see
+ * setup_shader_repeat()).
  */
 /* TODO: support multitexturing */
 static void
@@ -290,6 +294,145 @@ typedef struct _ValidateTexCoordsState
   CoglBool needs_multiple_primitives;
 } ValidateTexCoordsState;
 
+static CoglSnippet *
+get_shader_repeat_snippet (CoglContext *ctx,
+                           int layer_num)
+{
+  CoglSnippet **snippet = ctx->shader_repeat_snippets + layer_num;
+
+  if (*snippet == NULL)
+    {
+      /* The uniform is named after the layer number so that the
+         snippets for different layers can be used in the same
+         program */
+      char *declarations =
+        g_strdup_printf ("uniform vec4 _cogl_repeat_region%i;\n",
+                         layer_num);
+      char *pre =
+        g_strdup_printf ("cogl_tex_coord.st =\n"
+                         "  fract (cogl_tex_coord.st) *\n"
+                         "  _cogl_repeat_region%i.xy +\n"
+                         "  _cogl_repeat_region%i.zw;\n",
+                         layer_num,
+                         layer_num);
+
+      *snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_TEXTURE_LOOKUP,
+                                   declarations,
+                                   NULL);
+      cogl_snippet_set_pre (*snippet, pre);
+
+      g_free (declarations);
+      g_free (pre);
+    }
+
+  return *snippet;
+}
+
+static CoglBool
+can_shader_repeat_wrap_mode (CoglPipelineWrapMode wrap_mode)
+{
+  /* For backwards compatibility the automatic wrap mode repeats when
+     the coordinates are outside the range [0,1] */
+  return (wrap_mode == COGL_PIPELINE_WRAP_MODE_REPEAT ||
+          wrap_mode == COGL_PIPELINE_WRAP_MODE_AUTOMATIC);
+}
+
+static CoglBool
+can_shader_repeat_min_filter (CoglPipelineFilter min_filter)
+{
+  /* fract() makes the texture coordinates jump at each repeat so the
+     derivatives used to pick the mipmap level are wrong along the
+     seams */
+  switch (min_filter)
+    {
+    case COGL_PIPELINE_FILTER_NEAREST_MIPMAP_NEAREST:
+    case COGL_PIPELINE_FILTER_LINEAR_MIPMAP_NEAREST:
+    case COGL_PIPELINE_FILTER_NEAREST_MIPMAP_LINEAR:
+    case COGL_PIPELINE_FILTER_LINEAR_MIPMAP_LINEAR:
+      return FALSE;
+
+    default:
+      return TRUE;
+    }
+}
+
+/* Textures such as atlas textures and sub textures are a single
+ * region of a larger GL texture so they can't use the GPU to repeat.
+ * Instead of splitting the quad up, the repeating can be emulated by
+ * adding a snippet to the layer which wraps the coordinates with
+ * fract() and then maps them into the region. Returns FALSE if this
+ * isn't possible for the layer in which case the caller should fall
+ * back to drawing multiple primitives.
+ */
+static CoglBool
+setup_shader_repeat (ValidateTexCoordsState *state,
+                     CoglPipeline *pipeline,
+                     int layer_index,
+                     CoglTexture *texture,
+                     const float *in_tex_coords,
+                     float *out_tex_coords)
+{
+  CoglContext *ctx = texture->context;
+  float region[4] = { 0.0f, 0.0f, 1.0f, 1.0f };
+  float uniform_value[4];
+  CoglSnippet *snippet;
+  int *location;
+
+  if (state->i >= COGL_MAX_SHADER_REPEAT_LAYERS ||
+      !cogl_has_feature (ctx, COGL_FEATURE_ID_GLSL))
+    return FALSE;
+
+  if (!can_shader_repeat_wrap_mode
+      (cogl_pipeline_get_layer_wrap_mode_s (pipeline, layer_index)) ||
+      !can_shader_repeat_wrap_mode
+      (cogl_pipeline_get_layer_wrap_mode_t (pipeline, layer_index)) ||
+      !can_shader_repeat_min_filter
+      (cogl_pipeline_get_layer_min_filter (pipeline, layer_index)))
+    return FALSE;
+
+  /* Find the region that the whole texture covers in the GL
+     texture. This will fail if the texture is made of multiple GL
+     textures */
+  if (_cogl_texture_transform_quad_coords_to_gl (texture, region) ==
+      COGL_TRANSFORM_SOFTWARE_REPEAT)
+    return FALSE;
+
+  uniform_value[0] = region[2] - region[0];
+  uniform_value[1] = region[3] - region[1];
+  uniform_value[2] = region[0];
+  uniform_value[3] = region[1];
+
+  snippet = get_shader_repeat_snippet (ctx, state->i);
+
+  if (!state->override_pipeline)
+    state->override_pipeline = cogl_pipeline_copy (pipeline);
+  cogl_pipeline_add_layer_snippet (state->override_pipeline,
+                                   layer_index,
+                                   snippet);
+
+  location = ctx->shader_repeat_uniform_locations + state->i;
+  if (*location == -1)
+    {
+      char *uniform_name = g_strdup_printf ("_cogl_repeat_region%i",
+                                            state->i);
+      *location = cogl_pipeline_get_uniform_location (pipeline,
+                                                      uniform_name);
+      g_free (uniform_name);
+    }
+
+  cogl_pipeline_set_uniform_float (state->override_pipeline,
+                                   *location,
+                                   4, /* n_components */
+                                   1, /* count */
+                                   uniform_value);
+
+  /* The snippet does the mapping so the vertices get the original
+     coordinates */
+  memcpy (out_tex_coords, in_tex_coords, sizeof (float) * 4);
+
+  return TRUE;
+}
+
 /*
  * Validate the texture coordinates for this rectangle.
  */
@@ -341,6 +484,15 @@ validate_tex_coords_cb (CoglPipeline *pipeline,
    * NB: We already know that no texture matrix is being used if the
    * texture doesn't support hardware repeat.
    */
+  if (transform_result == COGL_TRANSFORM_SOFTWARE_REPEAT &&
+      setup_shader_repeat (state,
+                           pipeline,
+                           layer_index,
+                           texture,
+                           in_tex_coords,
+                           out_tex_coords))
+    return TRUE;
+
   if (transform_result == COGL_TRANSFORM_SOFTWARE_REPEAT)
     {
       if (state->i == 0)
@@ -413,7 +565,8 @@ validate_tex_coords_cb (CoglPipeline *pipeline,
 
 /* This path supports multitexturing but only when each of the layers is
  * handled with a single GL texture. Also if repeating is necessary then
- * _cogl_texture_can_hardware_repeat() must return TRUE.
+ * _cogl_texture_can_hardware_repeat() must return TRUE or GLSL must be
+ * available so that the repeating can be emulated in the shader.
  * This includes layers made from:
  *
  * - CoglTexture2DSliced: if only comprised of a single slice with optional
@@ -421,7 +574,7 @@ validate_tex_coords_cb (CoglPipeline *pipeline,
  *   repeating.
  * - CoglTexture{1D,2D,3D}: always.
  * - CoglTexture2DAtlas: assuming the users given texture coordinates don't
- *   require repeating.
+ *   require repeating or GLSL is available.
  * - CoglTextureRectangle: assuming the users given texture coordinates don't
  *   require repeating.
  * - CoglTexturePixmap: assuming the users given texture coordinates don't
@@ -717,6 +870,7 @@ _cogl_rectangle_immediate (CoglFramebuffer *framebuffer,
                                      COGL_VERTICES_MODE_TRIANGLE_STRIP,
                                      0, /* first_index */
                                      4, /* n_vertices */
+                                     1, /* n_instances */
                                      attributes,
                                      1,
                                      COGL_DRAW_SKIP_JOURNAL_FLUSH |
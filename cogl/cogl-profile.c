@@ -1,126 +1,509 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
 #ifdef HAVE_CONFIG_H
 #include "config.h"
 #endif
 
-#ifdef COGL_ENABLE_PROFILE
-
 #include "cogl-profile.h"
 #include "cogl-debug.h"
-#include "cogl-i18n-private.h"
+#include "cogl-context-private.h"
+#include "cogl-error-private.h"
+#include "cogl-framebuffer.h"
+#include "cogl-pipeline.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
 
-#include <stdlib.h>
+#include <test-fixtures/test-unit.h>
 
-UProfContext *_cogl_uprof_context;
+/* The number of events each thread can keep. Once the ring is full
+ * the oldest events are overwritten. This must be a power of two */
+#define COGL_PROFILE_RING_SIZE 16384
+/* The maximum nesting of timers that will be tracked */
+#define COGL_PROFILE_MAX_DEPTH 32
 
-static CoglBool
-debug_option_getter (void *user_data)
+typedef enum
 {
-  unsigned int shift = GPOINTER_TO_UINT (user_data);
-  return COGL_DEBUG_ENABLED (shift);
-}
+  COGL_PROFILE_EVENT_COMPLETE,
+  COGL_PROFILE_EVENT_COUNTER
+} CoglProfileEventType;
+
+typedef struct
+{
+  const char *name;
+  CoglProfileEventType type;
+  int64_t timestamp;
+  /* The duration for complete events or the value for counters */
+  int64_t value;
+} CoglProfileEvent;
+
+typedef struct
+{
+  const CoglProfileTimer *timer;
+  int64_t start;
+} CoglProfileTimerFrame;
+
+typedef struct
+{
+  int thread_index;
+
+  CoglProfileTimerFrame timer_stack[COGL_PROFILE_MAX_DEPTH];
+  int depth;
+
+  /* The total number of events that have been recorded. The next
+   * event is written at n_events % COGL_PROFILE_RING_SIZE */
+  unsigned int n_events;
+  CoglProfileEvent events[COGL_PROFILE_RING_SIZE];
+} CoglProfileThread;
+
+static GList *profile_threads;
+static int next_thread_index = 1;
+
+#ifdef COGL_HAS_GLIB_SUPPORT
+
+static GMutex profile_threads_lock;
 
 static void
-debug_option_setter (CoglBool value, void *user_data)
+thread_destroy_cb (void *data)
 {
-  unsigned int shift = GPOINTER_TO_UINT (user_data);
+  CoglProfileThread *thread = data;
+
+  g_mutex_lock (&profile_threads_lock);
+  profile_threads = g_list_remove (profile_threads, thread);
+  g_mutex_unlock (&profile_threads_lock);
 
-  if (value)
-    COGL_DEBUG_SET_FLAG (shift);
-  else
-    COGL_DEBUG_CLEAR_FLAG (shift);
+  g_free (thread);
+}
+
+static GPrivate profile_thread_key = G_PRIVATE_INIT (thread_destroy_cb);
+
+#define LOCK_THREADS() g_mutex_lock (&profile_threads_lock)
+#define UNLOCK_THREADS() g_mutex_unlock (&profile_threads_lock)
+
+#else /* COGL_HAS_GLIB_SUPPORT */
+
+/* Without GLib Cogl doesn't create any threads of its own */
+static CoglProfileThread *profile_thread;
+
+#define LOCK_THREADS() G_STMT_START { } G_STMT_END
+#define UNLOCK_THREADS() G_STMT_START { } G_STMT_END
+
+#endif /* COGL_HAS_GLIB_SUPPORT */
+
+int64_t
+_cogl_profile_get_time (void)
+{
+#ifdef COGL_HAS_GLIB_SUPPORT
+  return g_get_monotonic_time () * 1000;
+#else
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+#endif
+}
+
+static CoglProfileThread *
+get_thread (void)
+{
+  CoglProfileThread *thread;
+
+#ifdef COGL_HAS_GLIB_SUPPORT
+  thread = g_private_get (&profile_thread_key);
+#else
+  thread = profile_thread;
+#endif
+
+  if (G_LIKELY (thread))
+    return thread;
+
+  /* The ring buffer is quite large so it is only allocated the first
+   * time a thread records something */
+  thread = g_malloc (sizeof (CoglProfileThread));
+  thread->depth = 0;
+  thread->n_events = 0;
+
+  LOCK_THREADS ();
+  thread->thread_index = next_thread_index++;
+  profile_threads = g_list_prepend (profile_threads, thread);
+  UNLOCK_THREADS ();
+
+#ifdef COGL_HAS_GLIB_SUPPORT
+  g_private_set (&profile_thread_key, thread);
+#else
+  profile_thread = thread;
+#endif
+
+  return thread;
 }
 
 static void
-print_exit_report (void)
+add_event (CoglProfileThread *thread,
+           const char *name,
+           CoglProfileEventType type,
+           int64_t timestamp,
+           int64_t value)
+{
+  CoglProfileEvent *event =
+    thread->events + (thread->n_events & (COGL_PROFILE_RING_SIZE - 1));
+
+  event->name = name;
+  event->type = type;
+  event->timestamp = timestamp;
+  event->value = value;
+
+  thread->n_events++;
+}
+
+void
+_cogl_profile_timer_start (CoglProfileTimer *timer)
+{
+  CoglProfileThread *thread = get_thread ();
+
+  /* Timers nested too deeply are silently ignored */
+  if (thread->depth < COGL_PROFILE_MAX_DEPTH)
+    {
+      CoglProfileTimerFrame *frame = thread->timer_stack + thread->depth;
+
+      frame->timer = timer;
+      frame->start = _cogl_profile_get_time ();
+    }
+
+  thread->depth++;
+}
+
+void
+_cogl_profile_timer_stop (CoglProfileTimer *timer)
 {
-  if (getenv ("COGL_PROFILE_OUTPUT_REPORT"))
+  CoglProfileThread *thread = get_thread ();
+  int64_t now = _cogl_profile_get_time ();
+  int i;
+
+  /* The timers beyond the maximum depth weren't recorded so we can
+   * only assume that this stops the innermost one */
+  if (thread->depth > COGL_PROFILE_MAX_DEPTH)
     {
-      UProfContext *mainloop_context;
-      UProfTimerResult *mainloop_timer;
-      UProfReport *report;
-
-      /* NB: uprof provides a shared context for mainloop statistics
-       * which needs to be setup by the application which controls the
-       * mainloop.
-       *
-       * If no "Mainloop" timer has been setup then we print a warning
-       * since we can't provide a meaningful Cogl report without one.
-       */
-      mainloop_context = uprof_get_mainloop_context ();
-      mainloop_timer = uprof_context_get_timer_result (mainloop_context,
-                                                       "Mainloop");
-      /* just bail out if the mainloop timer wasn't hit */
-      if (!mainloop_timer)
+      thread->depth--;
+      return;
+    }
+
+  /* Normally the timer is at the top of the stack. If an inner timer
+   * was never stopped then it is dropped along with this one */
+  for (i = thread->depth - 1; i >= 0; i--)
+    {
+      CoglProfileTimerFrame *frame = thread->timer_stack + i;
+
+      if (frame->timer == timer)
         {
-          g_warning ("\n\n"
-                     "No UProf \"Mainloop\" timer was setup by the "
-                     "application therefore we\ncan't provide a meaningful "
-                     "profile report.\n"
-                     "\n"
-                     "This should be done automatically if you are using Clutter "
-                     "(if\nbuilt with --enable-profile)\n"
-                     "\n"
-                     "If you aren't using Clutter then you can declare a "
-                     "\"Mainloop\" UProf\ntimer in your application like this:\n\n"
-                     "  UPROF_STATIC_TIMER (mainloop_timer, \n"
-                     "                      NULL,\n"
-                     "                      \"Mainloop\",\n"
-                     "                      \"Time in glib mainloop\",\n"
-                     "                      0);\n"
-                     "\n"
-                     "And start/stop it around your mainloop like this:\n"
-                     "\n"
-                     "  UPROF_TIMER_START (uprof_get_mainloop_context (), mainloop_timer);\n"
-                     "  g_main_loop_run (loop);\n"
-                     "  UPROF_TIMER_STOP (uprof_get_mainloop_context (), mainloop_timer);\n");
+          add_event (thread,
+                     timer->name,
+                     COGL_PROFILE_EVENT_COMPLETE,
+                     frame->start,
+                     now - frame->start);
+          thread->depth = i;
           return;
         }
-
-      report = uprof_report_new ("Cogl report");
-      uprof_report_add_context (report, _cogl_uprof_context);
-      uprof_report_print (report);
-      uprof_report_unref (report);
     }
-  uprof_context_unref (_cogl_uprof_context);
+
+  /* This is expected if tracing was enabled in between starting and
+   * stopping the timer so it is silently ignored. The stack is left
+   * alone so that the timers that are still running can be matched
+   * up */
+}
+
+static void
+record_counter (const char *name,
+                int64_t value)
+{
+  add_event (get_thread (),
+             name,
+             COGL_PROFILE_EVENT_COUNTER,
+             _cogl_profile_get_time (),
+             value);
+}
+
+void
+_cogl_profile_counter_changed (CoglProfileCounter *counter,
+                               int value)
+{
+  /* The value is passed in because another thread may have changed
+   * the counter again since */
+  record_counter (counter->name, value);
 }
 
 void
-_cogl_uprof_init (void)
-{
-  _cogl_uprof_context = uprof_context_new ("Cogl");
-  uprof_context_link (_cogl_uprof_context, uprof_get_mainloop_context ());
-#define OPT(MASK_NAME, GROUP, NAME, NAME_FORMATTED, DESCRIPTION) \
-  G_STMT_START { \
-    int shift = COGL_DEBUG_ ## MASK_NAME; \
-    uprof_context_add_boolean_option (_cogl_uprof_context, \
-                                      g_dgettext (GETTEXT_PACKAGE, GROUP), \
-                                      NAME, \
-                                      g_dgettext (GETTEXT_PACKAGE, \
-                                                  NAME_FORMATTED), \
-                                      g_dgettext (GETTEXT_PACKAGE, \
-                                                  DESCRIPTION),    \
-                                      debug_option_getter, \
-                                      debug_option_setter, \
-                                      GUINT_TO_POINTER (shift)); \
-  } G_STMT_END;
-
-#include "cogl-debug-options.h"
-#undef OPT
-
-  atexit (print_exit_report);
+_cogl_profile_init (CoglContext *context)
+{
+  context->frame_start_time = _cogl_profile_get_time ();
 }
 
 void
-_cogl_profile_trace_message (const char *format, ...)
+_cogl_profile_end_frame (CoglContext *context)
 {
-  va_list ap;
+  CoglFrameStats *stats = &context->frame_stats;
+  int64_t now = _cogl_profile_get_time ();
+
+  stats->frame_time = now - context->frame_start_time;
 
-  va_start (ap, format);
-  g_logv (G_LOG_DOMAIN, G_LOG_LEVEL_MESSAGE, format, ap);
-  va_end (ap);
+  if (_COGL_PROFILE_ENABLED ())
+    {
+      CoglProfileThread *thread = get_thread ();
 
-  if (_cogl_uprof_context)
-    uprof_context_vtrace_message (_cogl_uprof_context, format, ap);
+      add_event (thread,
+                 "Frame",
+                 COGL_PROFILE_EVENT_COMPLETE,
+                 context->frame_start_time,
+                 stats->frame_time);
+
+      record_counter ("Draw calls", stats->n_draw_calls);
+      record_counter ("State changes", stats->n_state_changes);
+      record_counter ("Bytes uploaded", stats->n_bytes_uploaded);
+      record_counter ("Pipeline cache hits", stats->n_pipeline_cache_hits);
+      record_counter ("Pipeline cache misses",
+                      stats->n_pipeline_cache_misses);
+      record_counter ("Program links", stats->n_program_links);
+    }
+
+  context->last_frame_stats = *stats;
+  memset (stats, 0, sizeof (CoglFrameStats));
+  context->frame_start_time = now;
 }
 
-#endif
+void
+cogl_context_get_frame_stats (CoglContext *context,
+                              CoglFrameStats *stats)
+{
+  *stats = context->last_frame_stats;
+}
+
+static void
+write_json_string (FILE *file,
+                   const char *str)
+{
+  fputc ('"', file);
+
+  for (; *str; str++)
+    {
+      if (*str == '"' || *str == '\\')
+        fprintf (file, "\\%c", *str);
+      else if ((unsigned char) *str < 0x20)
+        fprintf (file, "\\u%04x", *str);
+      else
+        fputc (*str, file);
+    }
+
+  fputc ('"', file);
+}
+
+static void
+write_thread_events (FILE *file,
+                     CoglProfileThread *thread,
+                     CoglBool *first)
+{
+  unsigned int i, n_events, start;
+
+  n_events = MIN (thread->n_events, COGL_PROFILE_RING_SIZE);
+  start = thread->n_events - n_events;
+
+  for (i = 0; i < n_events; i++)
+    {
+      const CoglProfileEvent *event =
+        thread->events + ((start + i) & (COGL_PROFILE_RING_SIZE - 1));
+
+      fputs (*first ? "\n" : ",\n", file);
+      *first = FALSE;
+
+      fputs ("{\"name\":", file);
+      write_json_string (file, event->name);
+
+      /* The trace format uses microseconds */
+      fprintf (file,
+               ",\"cat\":\"cogl\",\"pid\":1,\"tid\":%i,\"ts\":%.3f",
+               thread->thread_index,
+               event->timestamp / 1000.0);
+
+      switch (event->type)
+        {
+        case COGL_PROFILE_EVENT_COMPLETE:
+          fprintf (file, ",\"ph\":\"X\",\"dur\":%.3f}", event->value / 1000.0);
+          break;
+
+        case COGL_PROFILE_EVENT_COUNTER:
+          fprintf (file,
+                   ",\"ph\":\"C\",\"args\":{\"value\":%" G_GINT64_FORMAT "}}",
+                   event->value);
+          break;
+        }
+    }
+}
+
+CoglBool
+cogl_context_write_trace (CoglContext *context,
+                          const char *filename,
+                          CoglError **error)
+{
+  CoglBool first = TRUE;
+  FILE *file;
+  GList *l;
+
+  file = fopen (filename, "w");
+  if (file == NULL)
+    goto error;
+
+  fputs ("{\"traceEvents\":[", file);
+
+  /* Other threads may still be adding events while this runs. That
+   * can only corrupt their oldest events, which is acceptable for a
+   * profiling aid */
+  LOCK_THREADS ();
+  for (l = profile_threads; l; l = l->next)
+    write_thread_events (file, l->data, &first);
+  UNLOCK_THREADS ();
+
+  fputs ("\n],\"displayTimeUnit\":\"ns\"}\n", file);
+
+  if (ferror (file))
+    {
+      fclose (file);
+      goto error;
+    }
+
+  if (fclose (file) != 0)
+    goto error;
+
+  return TRUE;
+
+ error:
+  _cogl_set_error (error,
+                   COGL_SYSTEM_ERROR,
+                   COGL_SYSTEM_ERROR_UNSUPPORTED,
+                   "Failed to write trace to %s: %s",
+                   filename,
+                   strerror (errno));
+  return FALSE;
+}
+
+UNIT_TEST (check_profile_frame_stats_and_trace,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  COGL_STATIC_TIMER (frame_timer,
+                     NULL, /* parent */
+                     "Unit test frame",
+                     "Time spent drawing a frame in the unit test",
+                     0 /* no application private data */);
+  COGL_STATIC_TIMER (unused_timer,
+                     NULL, /* parent */
+                     "Unit test unused timer",
+                     "A timer that is never started",
+                     0 /* no application private data */);
+  CoglBool was_tracing = COGL_DEBUG_ENABLED (COGL_DEBUG_TRACE);
+  CoglPipeline *pipeline = cogl_pipeline_new (test_ctx);
+  CoglProfileThread *thread;
+  CoglFrameStats stats;
+  CoglError *error = NULL;
+  char *filename, *contents;
+  int depth;
+  int frame;
+
+  COGL_DEBUG_SET_FLAG (COGL_DEBUG_TRACE);
+
+  /* Don't count anything that happened before the test */
+  _cogl_profile_end_frame (test_ctx);
+
+  for (frame = 1; frame <= 3; frame++)
+    {
+      int i;
+
+      COGL_TIMER_START (frame_timer);
+
+      /* Finishing after each rectangle stops the journal from
+       * batching them so each one is a separate draw call */
+      for (i = 0; i < frame; i++)
+        {
+          cogl_framebuffer_draw_rectangle (test_fb, pipeline, 0, 0, 1, 1);
+          cogl_framebuffer_finish (test_fb);
+        }
+
+      COGL_TIMER_STOP (frame_timer);
+
+      _cogl_profile_end_frame (test_ctx);
+
+      cogl_context_get_frame_stats (test_ctx, &stats);
+      g_assert_cmpint (stats.n_draw_calls, ==, frame);
+      g_assert_cmpint (stats.frame_time, >=, 0);
+    }
+
+  /* The counters for the next frame start from zero */
+  _cogl_profile_end_frame (test_ctx);
+  cogl_context_get_frame_stats (test_ctx, &stats);
+  g_assert_cmpint (stats.n_draw_calls, ==, 0);
+
+  /* Stopping a timer that isn't running should be ignored without
+   * disturbing the running timers. The tests are run with fatal
+   * warnings so this would also fail if it warned */
+  thread = get_thread ();
+  depth = thread->depth;
+  COGL_TIMER_START (frame_timer);
+  COGL_TIMER_STOP (unused_timer);
+  g_assert_cmpint (thread->depth, ==, depth + 1);
+  COGL_TIMER_STOP (frame_timer);
+  g_assert_cmpint (thread->depth, ==, depth);
+
+  filename = g_build_filename (g_get_tmp_dir (),
+                               "cogl-unit-test-trace.json",
+                               NULL);
+
+  if (!cogl_context_write_trace (test_ctx, filename, &error))
+    g_error ("Failed to write trace: %s", error->message);
+
+  g_assert (g_file_get_contents (filename, &contents, NULL, NULL));
+  g_assert (g_str_has_prefix (contents, "{\"traceEvents\":["));
+  g_assert (strstr (contents,
+                    "{\"name\":\"Unit test frame\",\"cat\":\"cogl\""));
+  g_assert (strstr (contents, "{\"name\":\"Frame\""));
+  g_assert (strstr (contents, "{\"name\":\"Draw calls\""));
+  g_assert (strstr (contents, "\"args\":{\"value\":3}"));
+  g_assert (strstr (contents, "\"ph\":\"X\""));
+  g_assert (strstr (contents, "\"ph\":\"C\""));
+
+  g_free (contents);
+  remove (filename);
+  g_free (filename);
+
+  cogl_object_unref (pipeline);
+
+  if (!was_tracing)
+    COGL_DEBUG_CLEAR_FLAG (COGL_DEBUG_TRACE);
+}
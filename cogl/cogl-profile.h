@@ -31,38 +31,78 @@
 #ifndef __COGL_PROFILE_H__
 #define __COGL_PROFILE_H__
 
+#include "cogl-types.h"
+#include "cogl-debug.h"
 
-#ifdef COGL_ENABLE_PROFILE
+#include <glib.h>
 
-#include <uprof.h>
+/*
+ * Cogl has a small built-in profiler. Timers and counters are
+ * declared statically next to the code they measure. When the "trace"
+ * debug option is enabled the timers record their start and end times
+ * into a ring buffer owned by the calling thread. The buffers can be
+ * written out in the Chrome trace event format with
+ * cogl_context_write_trace(). When tracing is disabled a timer only
+ * costs a flag check.
+ */
+
+typedef struct _CoglProfileTimer
+{
+  const char *parent;
+  const char *name;
+  const char *description;
+} CoglProfileTimer;
+
+/* The value of a counter is updated atomically because counters can
+ * be changed from the worker threads */
+typedef struct _CoglProfileCounter
+{
+  const char *name;
+  const char *description;
+  volatile int value;
+} CoglProfileCounter;
+
+#define COGL_STATIC_TIMER(VAR, PARENT, NAME, DESCRIPTION, PRIV) \
+  static CoglProfileTimer VAR = { PARENT, NAME, DESCRIPTION }
+#define COGL_STATIC_COUNTER(VAR, NAME, DESCRIPTION, PRIV) \
+  static CoglProfileCounter VAR = { NAME, DESCRIPTION, 0 }
 
-extern UProfContext *_cogl_uprof_context;
+#define _COGL_PROFILE_ENABLED() \
+  G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_TRACE))
 
-#define COGL_STATIC_TIMER    UPROF_STATIC_TIMER
-#define COGL_STATIC_COUNTER  UPROF_STATIC_COUNTER
-#define COGL_COUNTER_INC     UPROF_COUNTER_INC
-#define COGL_COUNTER_DEC     UPROF_COUNTER_DEC
-#define COGL_TIMER_START     UPROF_TIMER_START
-#define COGL_TIMER_STOP      UPROF_TIMER_STOP
+#define COGL_TIMER_START(VAR) G_STMT_START {                    \
+    if (_COGL_PROFILE_ENABLED ())                               \
+      _cogl_profile_timer_start (&(VAR));                       \
+  } G_STMT_END
+#define COGL_TIMER_STOP(VAR) G_STMT_START {                     \
+    if (_COGL_PROFILE_ENABLED ())                               \
+      _cogl_profile_timer_stop (&(VAR));                        \
+  } G_STMT_END
+
+#define _COGL_COUNTER_ADD(VAR, DELTA) G_STMT_START {            \
+    int _cogl_counter_value =                                   \
+      g_atomic_int_add (&(VAR).value, (DELTA)) + (DELTA);       \
+    if (_COGL_PROFILE_ENABLED ())                               \
+      _cogl_profile_counter_changed (&(VAR),                    \
+                                     _cogl_counter_value);      \
+  } G_STMT_END
+#define COGL_COUNTER_INC(VAR) _COGL_COUNTER_ADD (VAR, 1)
+#define COGL_COUNTER_DEC(VAR) _COGL_COUNTER_ADD (VAR, -1)
 
 void
-_cogl_uprof_init (void);
+_cogl_profile_timer_start (CoglProfileTimer *timer);
 
 void
-_cogl_profile_trace_message (const char *format, ...);
+_cogl_profile_timer_stop (CoglProfileTimer *timer);
 
-#else
+void
+_cogl_profile_counter_changed (CoglProfileCounter *counter,
+                               int value);
 
-#define COGL_STATIC_TIMER(A,B,C,D,E) extern void _cogl_dummy_decl (void)
-#define COGL_STATIC_COUNTER(A,B,C,D) extern void _cogl_dummy_decl (void)
-#define COGL_COUNTER_INC(A,B) G_STMT_START{ (void)0; }G_STMT_END
-#define COGL_COUNTER_DEC(A,B) G_STMT_START{ (void)0; }G_STMT_END
-#define COGL_TIMER_START(A,B) G_STMT_START{ (void)0; }G_STMT_END
-#define COGL_TIMER_STOP(A,B) G_STMT_START{ (void)0; }G_STMT_END
+/* Returns a monotonic timestamp in nanoseconds */
+int64_t
+_cogl_profile_get_time (void);
 
 #define _cogl_profile_trace_message g_message
 
-#endif
-
 #endif /* __COGL_PROFILE_H__ */
-
@@ -93,7 +93,9 @@ extern const CoglTextureDriver _cogl_texture_driver_gles;
 extern const CoglDriverVtable _cogl_driver_gles;
 #endif
 
+extern const CoglTextureDriver _cogl_texture_driver_nop;
 extern const CoglDriverVtable _cogl_driver_nop;
+extern const CoglDriverVtable _cogl_driver_sw;
 
 typedef struct _CoglDriverDescription
 {
@@ -187,7 +189,16 @@ static CoglDriverDescription _cogl_drivers[] =
     0, /* constraints satisfied */
     { -1 },
     &_cogl_driver_nop,
-    NULL, /* texture driver */
+    &_cogl_texture_driver_nop,
+    NULL /* libgl_name */
+  },
+  {
+    COGL_DRIVER_SW,
+    "sw",
+    0, /* constraints satisfied */
+    { -1 },
+    &_cogl_driver_sw,
+    &_cogl_texture_driver_nop,
     NULL /* libgl_name */
   }
 };
@@ -458,6 +469,8 @@ driver_id_to_name (CoglDriver id)
         return "webgl";
       case COGL_DRIVER_NOP:
         return "nop";
+      case COGL_DRIVER_SW:
+        return "sw";
       case COGL_DRIVER_ANY:
         g_warn_if_reached ();
         return "any";
@@ -340,6 +340,8 @@ cogl_renderer_remove_constraint (CoglRenderer *renderer,
  * @COGL_DRIVER_GLES1: An OpenGL ES 1.1 driver.
  * @COGL_DRIVER_GLES2: An OpenGL ES 2.0 driver.
  * @COGL_DRIVER_WEBGL: A WebGL driver.
+ * @COGL_DRIVER_SW: A driver that renders on the CPU without using
+ *   OpenGL. Since: 2.0
  *
  * Identifiers for underlying hardware drivers that may be used by
  * Cogl for rendering.
@@ -355,7 +357,8 @@ typedef enum
   COGL_DRIVER_GL3,
   COGL_DRIVER_GLES1,
   COGL_DRIVER_GLES2,
-  COGL_DRIVER_WEBGL
+  COGL_DRIVER_WEBGL,
+  COGL_DRIVER_SW
 } CoglDriver;
 
 /**
@@ -217,6 +217,17 @@ COGL_BEGIN_DECLS
  *   </para></glossdef>
  *  </glossentry>
  *  <glossentry>
+ *   <glossterm>int
+ *         <emphasis>cogl_instance_id</emphasis></glossterm>
+ *   <glossdef><para>
+ *    The index of the instance being drawn by
+ *    cogl_primitive_draw_instanced(). This is zero for all other
+ *    drawing functions. It is only available if the
+ *    %COGL_FEATURE_ID_INSTANCED_DRAWING feature is advertised. This
+ *    is equivalent to #gl_InstanceID.
+ *   </para></glossdef>
+ *  </glossentry>
+ *  <glossentry>
  *   <glossterm>varying vec4
  *         <emphasis>cogl_color_out</emphasis></glossterm>
  *   <glossdef><para>
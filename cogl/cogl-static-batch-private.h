@@ -0,0 +1,85 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifndef __COGL_STATIC_BATCH_PRIVATE_H
+#define __COGL_STATIC_BATCH_PRIVATE_H
+
+#include "cogl-object-private.h"
+#include "cogl-static-batch.h"
+#include "cogl-attribute-buffer.h"
+#include "cogl-primitive.h"
+
+typedef struct _CoglStaticBatchVertex
+{
+  float position[4];
+  float tex_coord[2];
+  uint8_t color[4];
+} CoglStaticBatchVertex;
+
+typedef struct _CoglStaticBatchEntry
+{
+  float position[4];
+  float tex_coords[4];
+  /* The premultiplied color of the pipeline when the rectangle was
+     added */
+  uint8_t color[4];
+  CoglMatrix transform;
+} CoglStaticBatchEntry;
+
+/* A run of consecutive rectangles that can be drawn with a single
+   draw call */
+typedef struct _CoglStaticBatchRun
+{
+  CoglPipeline *pipeline;
+  int first_rectangle;
+  int n_rectangles;
+
+  /* This is created lazily the next time the batch is drawn */
+  CoglPrimitive *primitive;
+} CoglStaticBatchRun;
+
+struct _CoglStaticBatch
+{
+  CoglObject _parent;
+
+  CoglContext *context;
+
+  /* Array of CoglStaticBatchEntries in the order they were added */
+  GArray *entries;
+  /* Array of CoglStaticBatchRuns covering all of the entries */
+  GArray *runs;
+
+  /* The vertices for all of the entries. This is thrown away
+     whenever a rectangle is added so that it will be recreated the
+     next time the batch is drawn */
+  CoglAttributeBuffer *buffer;
+};
+
+#endif /* __COGL_STATIC_BATCH_PRIVATE_H */
@@ -0,0 +1,440 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "cogl-util.h"
+#include "cogl-context-private.h"
+#include "cogl-static-batch-private.h"
+#include "cogl-pipeline-private.h"
+#include "cogl-pipeline-state-private.h"
+#include "cogl-buffer-private.h"
+#include "cogl-indices.h"
+
+/* The rectangle indices use 16-bit indices so a single draw can't
+   reference more than 65536 vertices */
+#define MAX_RECTANGLES_PER_RUN (65536 / 4)
+
+static void _cogl_static_batch_free (CoglStaticBatch *batch);
+
+COGL_OBJECT_DEFINE (StaticBatch, static_batch);
+
+static void
+discard_vertices (CoglStaticBatch *batch)
+{
+  int i;
+
+  for (i = 0; i < batch->runs->len; i++)
+    {
+      CoglStaticBatchRun *run =
+        &g_array_index (batch->runs, CoglStaticBatchRun, i);
+
+      if (run->primitive)
+        {
+          cogl_object_unref (run->primitive);
+          run->primitive = NULL;
+        }
+    }
+
+  if (batch->buffer)
+    {
+      cogl_object_unref (batch->buffer);
+      batch->buffer = NULL;
+    }
+}
+
+static void
+_cogl_static_batch_free (CoglStaticBatch *batch)
+{
+  int i;
+
+  discard_vertices (batch);
+
+  for (i = 0; i < batch->runs->len; i++)
+    {
+      CoglStaticBatchRun *run =
+        &g_array_index (batch->runs, CoglStaticBatchRun, i);
+
+      cogl_object_unref (run->pipeline);
+    }
+
+  g_array_free (batch->runs, TRUE);
+  g_array_free (batch->entries, TRUE);
+
+  g_slice_free (CoglStaticBatch, batch);
+}
+
+CoglStaticBatch *
+cogl_static_batch_new (CoglContext *context)
+{
+  CoglStaticBatch *batch = g_slice_new (CoglStaticBatch);
+
+  batch->context = context;
+  batch->entries = g_array_new (FALSE, FALSE, sizeof (CoglStaticBatchEntry));
+  batch->runs = g_array_new (FALSE, FALSE, sizeof (CoglStaticBatchRun));
+  batch->buffer = NULL;
+
+  return _cogl_static_batch_object_new (batch);
+}
+
+static void
+add_to_run (CoglStaticBatch *batch,
+            CoglPipeline *pipeline)
+{
+  CoglStaticBatchRun *run;
+
+  if (batch->runs->len > 0)
+    {
+      run = &g_array_index (batch->runs,
+                            CoglStaticBatchRun,
+                            batch->runs->len - 1);
+
+      /* The color is stored in the vertices so rectangles can share
+       * a run as long as the rest of the pipeline state matches. This
+       * is the same test that the journal uses to batch rectangles */
+      if (run->n_rectangles < MAX_RECTANGLES_PER_RUN &&
+          _cogl_pipeline_equal (run->pipeline,
+                                pipeline,
+                                (COGL_PIPELINE_STATE_ALL &
+                                 ~COGL_PIPELINE_STATE_COLOR),
+                                COGL_PIPELINE_LAYER_STATE_ALL,
+                                0))
+        {
+          run->n_rectangles++;
+          return;
+        }
+    }
+
+  g_array_set_size (batch->runs, batch->runs->len + 1);
+  run = &g_array_index (batch->runs, CoglStaticBatchRun, batch->runs->len - 1);
+
+  /* Take a copy so that the application can continue to modify its
+   * pipeline without affecting the batch */
+  run->pipeline = cogl_pipeline_copy (pipeline);
+  run->first_rectangle = batch->entries->len - 1;
+  run->n_rectangles = 1;
+  run->primitive = NULL;
+}
+
+int
+cogl_static_batch_add_textured_rectangle (CoglStaticBatch *batch,
+                                          CoglPipeline *pipeline,
+                                          float x_1,
+                                          float y_1,
+                                          float x_2,
+                                          float y_2,
+                                          float s_1,
+                                          float t_1,
+                                          float s_2,
+                                          float t_2)
+{
+  CoglStaticBatchEntry *entry;
+
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_static_batch (batch), -1);
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_pipeline (pipeline), -1);
+
+  /* The vertex buffer has to be recreated to make space for the new
+   * rectangle */
+  discard_vertices (batch);
+
+  g_array_set_size (batch->entries, batch->entries->len + 1);
+  entry = &g_array_index (batch->entries,
+                          CoglStaticBatchEntry,
+                          batch->entries->len - 1);
+
+  entry->position[0] = x_1;
+  entry->position[1] = y_1;
+  entry->position[2] = x_2;
+  entry->position[3] = y_2;
+  entry->tex_coords[0] = s_1;
+  entry->tex_coords[1] = t_1;
+  entry->tex_coords[2] = s_2;
+  entry->tex_coords[3] = t_2;
+  _cogl_pipeline_get_colorubv (pipeline, entry->color);
+  cogl_matrix_init_identity (&entry->transform);
+
+  add_to_run (batch, pipeline);
+
+  return batch->entries->len - 1;
+}
+
+int
+cogl_static_batch_add_rectangle (CoglStaticBatch *batch,
+                                 CoglPipeline *pipeline,
+                                 float x_1,
+                                 float y_1,
+                                 float x_2,
+                                 float y_2)
+{
+  return cogl_static_batch_add_textured_rectangle (batch,
+                                                   pipeline,
+                                                   x_1, y_1,
+                                                   x_2, y_2,
+                                                   0.0f, 0.0f,
+                                                   1.0f, 1.0f);
+}
+
+int
+cogl_static_batch_get_n_rectangles (CoglStaticBatch *batch)
+{
+  return batch->entries->len;
+}
+
+static void
+write_entry_vertices (const CoglStaticBatchEntry *entry,
+                      CoglStaticBatchVertex *vertices)
+{
+  /* The corners are in the same order as the journal uses so that
+   * they match the rectangle indices */
+  const float corners[] =
+    {
+      entry->position[0], entry->position[1],
+      entry->position[0], entry->position[3],
+      entry->position[2], entry->position[3],
+      entry->position[2], entry->position[1]
+    };
+  const float tex_coords[] =
+    {
+      entry->tex_coords[0], entry->tex_coords[1],
+      entry->tex_coords[0], entry->tex_coords[3],
+      entry->tex_coords[2], entry->tex_coords[3],
+      entry->tex_coords[2], entry->tex_coords[1]
+    };
+  int i;
+
+  /* This always writes all four components of the position so that
+   * the transform can contain a projection */
+  cogl_matrix_project_points (&entry->transform,
+                              2, /* n_components */
+                              sizeof (float) * 2,
+                              corners,
+                              sizeof (CoglStaticBatchVertex),
+                              vertices[0].position,
+                              4 /* n_points */);
+
+  for (i = 0; i < 4; i++)
+    {
+      memcpy (vertices[i].tex_coord, tex_coords + i * 2, sizeof (float) * 2);
+      memcpy (vertices[i].color, entry->color, 4);
+    }
+}
+
+typedef struct
+{
+  CoglStaticBatch *batch;
+  size_t offset;
+  CoglAttribute **attributes;
+  int n_attributes;
+} CreateAttributesState;
+
+static CoglBool
+create_tex_coord_attribute_cb (CoglPipeline *pipeline,
+                               int layer_number,
+                               void *user_data)
+{
+  CreateAttributesState *state = user_data;
+  char *name = g_strdup_printf ("cogl_tex_coord%d_in", layer_number);
+
+  /* Every layer uses the same texture coordinates */
+  state->attributes[state->n_attributes++] =
+    cogl_attribute_new (state->batch->buffer,
+                        name,
+                        sizeof (CoglStaticBatchVertex),
+                        state->offset +
+                        G_STRUCT_OFFSET (CoglStaticBatchVertex, tex_coord),
+                        2, /* n_components */
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+
+  g_free (name);
+
+  return TRUE;
+}
+
+static CoglPrimitive *
+create_run_primitive (CoglStaticBatch *batch,
+                      CoglStaticBatchRun *run)
+{
+  CreateAttributesState state;
+  CoglPrimitive *primitive;
+  int n_layers = cogl_pipeline_get_n_layers (run->pipeline);
+  int i;
+
+  state.batch = batch;
+  state.offset = (run->first_rectangle * 4 *
+                  sizeof (CoglStaticBatchVertex));
+  state.attributes = g_alloca (sizeof (CoglAttribute *) * (n_layers + 2));
+  state.n_attributes = 0;
+
+  state.attributes[state.n_attributes++] =
+    cogl_attribute_new (batch->buffer,
+                        "cogl_position_in",
+                        sizeof (CoglStaticBatchVertex),
+                        state.offset +
+                        G_STRUCT_OFFSET (CoglStaticBatchVertex, position),
+                        4, /* n_components */
+                        COGL_ATTRIBUTE_TYPE_FLOAT);
+  state.attributes[state.n_attributes++] =
+    cogl_attribute_new (batch->buffer,
+                        "cogl_color_in",
+                        sizeof (CoglStaticBatchVertex),
+                        state.offset +
+                        G_STRUCT_OFFSET (CoglStaticBatchVertex, color),
+                        4, /* n_components */
+                        COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+
+  cogl_pipeline_foreach_layer (run->pipeline,
+                               create_tex_coord_attribute_cb,
+                               &state);
+
+  primitive = cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLES,
+                                                  run->n_rectangles * 6,
+                                                  state.attributes,
+                                                  state.n_attributes);
+  cogl_primitive_set_indices (primitive,
+                              cogl_get_rectangle_indices (batch->context,
+                                                          run->n_rectangles),
+                              run->n_rectangles * 6);
+
+  for (i = 0; i < state.n_attributes; i++)
+    cogl_object_unref (state.attributes[i]);
+
+  return primitive;
+}
+
+static void
+ensure_vertices (CoglStaticBatch *batch)
+{
+  CoglStaticBatchVertex *vertices;
+  int i;
+
+  if (batch->buffer)
+    return;
+
+  batch->buffer =
+    cogl_attribute_buffer_new_with_size (batch->context,
+                                         batch->entries->len * 4 *
+                                         sizeof (CoglStaticBatchVertex));
+
+  vertices =
+    _cogl_buffer_map_for_fill_or_fallback (COGL_BUFFER (batch->buffer));
+
+  for (i = 0; i < batch->entries->len; i++)
+    write_entry_vertices (&g_array_index (batch->entries,
+                                          CoglStaticBatchEntry,
+                                          i),
+                          vertices + i * 4);
+
+  _cogl_buffer_unmap_for_fill_or_fallback (COGL_BUFFER (batch->buffer));
+
+  for (i = 0; i < batch->runs->len; i++)
+    {
+      CoglStaticBatchRun *run =
+        &g_array_index (batch->runs, CoglStaticBatchRun, i);
+
+      run->primitive = create_run_primitive (batch, run);
+    }
+}
+
+void
+cogl_static_batch_set_transform (CoglStaticBatch *batch,
+                                 int rectangle,
+                                 const CoglMatrix *transform)
+{
+  CoglStaticBatchEntry *entry;
+  CoglStaticBatchVertex *vertices;
+  CoglBuffer *buffer;
+  size_t offset;
+
+  _COGL_RETURN_IF_FAIL (cogl_is_static_batch (batch));
+  _COGL_RETURN_IF_FAIL (rectangle >= 0 && rectangle < batch->entries->len);
+
+  entry = &g_array_index (batch->entries, CoglStaticBatchEntry, rectangle);
+  entry->transform = *transform;
+
+  /* If the vertices haven't been uploaded yet then the transform
+   * will be used when they are */
+  if (batch->buffer == NULL)
+    return;
+
+  /* Otherwise only the four vertices for this rectangle need to be
+   * rewritten */
+  buffer = COGL_BUFFER (batch->buffer);
+  offset = rectangle * 4 * sizeof (CoglStaticBatchVertex);
+
+  vertices = cogl_buffer_map_range (buffer,
+                                    offset,
+                                    sizeof (CoglStaticBatchVertex) * 4,
+                                    COGL_BUFFER_ACCESS_WRITE,
+                                    COGL_BUFFER_MAP_HINT_DISCARD_RANGE,
+                                    NULL);
+
+  if (vertices)
+    {
+      write_entry_vertices (entry, vertices);
+      cogl_buffer_unmap (buffer);
+    }
+  else
+    {
+      CoglStaticBatchVertex tmp_vertices[4];
+
+      write_entry_vertices (entry, tmp_vertices);
+      cogl_buffer_set_data (buffer,
+                            offset,
+                            tmp_vertices,
+                            sizeof (tmp_vertices),
+                            NULL);
+    }
+}
+
+void
+cogl_static_batch_draw (CoglStaticBatch *batch,
+                        CoglFramebuffer *framebuffer)
+{
+  int i;
+
+  _COGL_RETURN_IF_FAIL (cogl_is_static_batch (batch));
+
+  if (batch->entries->len == 0)
+    return;
+
+  ensure_vertices (batch);
+
+  for (i = 0; i < batch->runs->len; i++)
+    {
+      CoglStaticBatchRun *run =
+        &g_array_index (batch->runs, CoglStaticBatchRun, i);
+
+      cogl_primitive_draw (run->primitive, framebuffer, run->pipeline);
+    }
+}
@@ -0,0 +1,219 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#if !defined(__COGL_H_INSIDE__) && !defined(COGL_COMPILATION)
+#error "Only <cogl/cogl.h> can be included directly."
+#endif
+
+#ifndef __COGL_STATIC_BATCH_H__
+#define __COGL_STATIC_BATCH_H__
+
+#include <cogl/cogl-types.h>
+#include <cogl/cogl-context.h>
+#include <cogl/cogl-pipeline.h>
+#include <cogl/cogl-framebuffer.h>
+#include <cogl/cogl-matrix.h>
+
+COGL_BEGIN_DECLS
+
+/**
+ * SECTION:cogl-static-batch
+ * @short_description: Functions for drawing a retained list of
+ *   rectangles
+ *
+ * Rectangles drawn with cogl_framebuffer_draw_rectangle() are logged
+ * in the framebuffer's journal and their vertices are uploaded again
+ * every time they are drawn. For scenes where most of the rectangles
+ * don't change from one frame to the next, a #CoglStaticBatch can be
+ * used instead. The rectangles are added to the batch once and their
+ * vertices are kept in a single attribute buffer on the GPU. Every
+ * time the batch is drawn, each run of consecutive rectangles that
+ * use compatible pipelines is drawn with a single draw call.
+ *
+ * Each rectangle has its own transformation which can be changed
+ * with cogl_static_batch_set_transform(). Only the vertices of that
+ * rectangle are rewritten in the buffer so the rest of the batch
+ * doesn't need to be touched.
+ */
+
+/**
+ * CoglStaticBatch:
+ *
+ * An opaque object representing a retained list of rectangles.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef struct _CoglStaticBatch CoglStaticBatch;
+
+/**
+ * cogl_static_batch_new:
+ * @context: A #CoglContext
+ *
+ * Creates a new, empty #CoglStaticBatch.
+ *
+ * Return value: (transfer full): A newly allocated #CoglStaticBatch
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglStaticBatch *
+cogl_static_batch_new (CoglContext *context);
+
+/**
+ * cogl_static_batch_add_rectangle:
+ * @batch: A #CoglStaticBatch
+ * @pipeline: A #CoglPipeline state object
+ * @x_1: X coordinate of the top-left corner
+ * @y_1: Y coordinate of the top-left corner
+ * @x_2: X coordinate of the bottom-right corner
+ * @y_2: Y coordinate of the bottom-right corner
+ *
+ * Adds a rectangle to the end of @batch. The state of @pipeline is
+ * captured when the rectangle is added so later changes to
+ * @pipeline will not affect the batch. If any of the pipeline's
+ * layers have a texture then the whole texture is mapped onto the
+ * rectangle.
+ *
+ * Return value: The index of the new rectangle, which can be passed
+ *   to cogl_static_batch_set_transform()
+ * Since: 2.0
+ * Stability: Unstable
+ */
+int
+cogl_static_batch_add_rectangle (CoglStaticBatch *batch,
+                                 CoglPipeline *pipeline,
+                                 float x_1,
+                                 float y_1,
+                                 float x_2,
+                                 float y_2);
+
+/**
+ * cogl_static_batch_add_textured_rectangle:
+ * @batch: A #CoglStaticBatch
+ * @pipeline: A #CoglPipeline state object
+ * @x_1: X coordinate of the top-left corner
+ * @y_1: Y coordinate of the top-left corner
+ * @x_2: X coordinate of the bottom-right corner
+ * @y_2: Y coordinate of the bottom-right corner
+ * @s_1: S texture coordinate of the top-left corner
+ * @t_1: T texture coordinate of the top-left corner
+ * @s_2: S texture coordinate of the bottom-right corner
+ * @t_2: T texture coordinate of the bottom-right corner
+ *
+ * Adds a rectangle to the end of @batch with the given texture
+ * coordinates. The same texture coordinates are used for every layer
+ * of @pipeline. The texture coordinates are interpreted in the same
+ * way as for a #CoglPrimitive so unlike
+ * cogl_framebuffer_draw_textured_rectangle() sliced textures can't be
+ * used.
+ *
+ * Return value: The index of the new rectangle, which can be passed
+ *   to cogl_static_batch_set_transform()
+ * Since: 2.0
+ * Stability: Unstable
+ */
+int
+cogl_static_batch_add_textured_rectangle (CoglStaticBatch *batch,
+                                          CoglPipeline *pipeline,
+                                          float x_1,
+                                          float y_1,
+                                          float x_2,
+                                          float y_2,
+                                          float s_1,
+                                          float t_1,
+                                          float s_2,
+                                          float t_2);
+
+/**
+ * cogl_static_batch_get_n_rectangles:
+ * @batch: A #CoglStaticBatch
+ *
+ * Return value: The number of rectangles that have been added to
+ *   @batch.
+ * Since: 2.0
+ * Stability: Unstable
+ */
+int
+cogl_static_batch_get_n_rectangles (CoglStaticBatch *batch);
+
+/**
+ * cogl_static_batch_set_transform:
+ * @batch: A #CoglStaticBatch
+ * @rectangle: The index of a rectangle in @batch
+ * @transform: A #CoglMatrix to transform the rectangle with
+ *
+ * Sets a transformation that will be applied to the corners of the
+ * given rectangle before the framebuffer's modelview matrix. The
+ * default transformation is the identity matrix. If the batch has
+ * already been drawn then only the part of the vertex buffer
+ * containing this rectangle is updated.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_static_batch_set_transform (CoglStaticBatch *batch,
+                                 int rectangle,
+                                 const CoglMatrix *transform);
+
+/**
+ * cogl_static_batch_draw:
+ * @batch: A #CoglStaticBatch
+ * @framebuffer: A destination #CoglFramebuffer
+ *
+ * Draws all of the rectangles in @batch to @framebuffer in the order
+ * they were added, using the framebuffer's current modelview matrix
+ * and clip state. The vertices are only uploaded the first time the
+ * batch is drawn after rectangles have been added to it.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_static_batch_draw (CoglStaticBatch *batch,
+                        CoglFramebuffer *framebuffer);
+
+/**
+ * cogl_is_static_batch:
+ * @object: A #CoglObject pointer
+ *
+ * Gets whether the given object references a #CoglStaticBatch.
+ *
+ * Return value: %TRUE if the object references a #CoglStaticBatch
+ *   and %FALSE otherwise.
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglBool
+cogl_is_static_batch (void *object);
+
+COGL_END_DECLS
+
+#endif /* __COGL_STATIC_BATCH_H__ */
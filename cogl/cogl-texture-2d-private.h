@@ -51,6 +51,9 @@ struct _CoglTexture2D
   CoglBool auto_mipmap;
   CoglBool mipmaps_dirty;
   CoglBool is_foreign;
+  /* Whether the GL texture is stored in a block compressed format */
+  CoglBool is_compressed;
+  CoglCompressedFormat compressed_format;
 
   /* TODO: factor out these OpenGL specific members into some form
    * of driver private state. */
@@ -1396,6 +1396,17 @@ _cogl_texture_2d_sliced_get_type (CoglTexture *tex)
   return COGL_TEXTURE_TYPE_2D;
 }
 
+static void
+_cogl_texture_2d_sliced_discard_storage (CoglTexture *tex)
+{
+  CoglTexture2DSliced *tex_2ds = COGL_TEXTURE_2D_SLICED (tex);
+
+  /* The slices will be recreated from the loader when the texture is
+     next allocated */
+  free_slices (tex_2ds);
+  tex_2ds->slice_textures = NULL;
+}
+
 static const CoglTextureVtable
 cogl_texture_2d_sliced_vtable =
   {
@@ -1417,5 +1428,7 @@ cogl_texture_2d_sliced_vtable =
     _cogl_texture_2d_sliced_get_gl_format,
     _cogl_texture_2d_sliced_get_type,
     _cogl_texture_2d_sliced_is_foreign,
-    NULL /* set_auto_mipmap */
+    NULL, /* set_auto_mipmap */
+    NULL, /* get_gpu_bytes */
+    _cogl_texture_2d_sliced_discard_storage
   };
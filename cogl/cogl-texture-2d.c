@@ -47,6 +47,7 @@
 #include "cogl-pipeline-opengl-private.h"
 #include "cogl-framebuffer-private.h"
 #include "cogl-error-private.h"
+#include "cogl-texture-residency-private.h"
 #ifdef COGL_HAS_EGL_SUPPORT
 #include "cogl-winsys-egl-private.h"
 #endif
@@ -108,6 +109,7 @@ _cogl_texture_2d_create_base (CoglContext *ctx,
   tex_2d->auto_mipmap = TRUE;
 
   tex_2d->is_foreign = FALSE;
+  tex_2d->is_compressed = FALSE;
 
   ctx->driver_vtable->texture_2d_init (tex_2d);
 
@@ -166,6 +168,34 @@ cogl_texture_2d_new_from_bitmap (CoglBitmap *bmp)
                                            FALSE); /* can't convert in place */
 }
 
+static CoglTexture2D *
+_cogl_texture_2d_new_from_compressed_image (CoglContext *ctx,
+                                            CoglCompressedImage *image)
+{
+  CoglTextureLoader *loader;
+  CoglTexture2D *tex_2d;
+
+  loader = _cogl_texture_create_loader ();
+  loader->src_type = COGL_TEXTURE_SOURCE_TYPE_COMPRESSED;
+  loader->src.compressed.image = image;
+
+  tex_2d = _cogl_texture_2d_create_base (ctx,
+                                         image->width,
+                                         image->height,
+                                         _cogl_compressed_format_has_alpha
+                                         (image->format) ?
+                                         COGL_PIXEL_FORMAT_RGBA_8888 :
+                                         COGL_PIXEL_FORMAT_RGB_888,
+                                         loader);
+
+  /* The components of the compressed data can't be converted so the
+   * texture has to match them */
+  cogl_texture_set_premultiplied (COGL_TEXTURE (tex_2d),
+                                  image->premultiplied);
+
+  return tex_2d;
+}
+
 CoglTexture2D *
 cogl_texture_2d_new_from_file (CoglContext *ctx,
                                const char *filename,
@@ -173,9 +203,22 @@ cogl_texture_2d_new_from_file (CoglContext *ctx,
 {
   CoglBitmap *bmp;
   CoglTexture2D *tex_2d = NULL;
+  CoglCompressedImage *image;
+  CoglError *compressed_error = NULL;
 
   _COGL_RETURN_VAL_IF_FAIL (error == NULL || *error == NULL, NULL);
 
+  /* KTX and DDS files are loaded without decompressing them so that
+   * the blocks can be uploaded directly */
+  image = _cogl_compressed_image_new_from_file (filename, &compressed_error);
+  if (image)
+    return _cogl_texture_2d_new_from_compressed_image (ctx, image);
+  else if (compressed_error)
+    {
+      _cogl_propagate_error (error, compressed_error);
+      return NULL;
+    }
+
   bmp = cogl_bitmap_new_from_file (ctx, filename, error);
   if (bmp == NULL)
     return NULL;
@@ -472,6 +515,8 @@ _cogl_texture_2d_copy_from_framebuffer (CoglTexture2D *tex_2d,
   /* Assert that the storage for this texture has been allocated */
   cogl_texture_allocate (tex, NULL); /* (abort on error) */
 
+  _cogl_texture_residency_make_permanent (tex);
+
   ctx->driver_vtable->texture_2d_copy_from_framebuffer (tex_2d,
                                                         src_x,
                                                         src_y,
@@ -599,6 +644,16 @@ _cogl_texture_2d_set_region (CoglTexture *tex,
   CoglContext *ctx = tex->context;
   CoglTexture2D *tex_2d = COGL_TEXTURE_2D (tex);
 
+  if (tex_2d->is_compressed)
+    {
+      _cogl_set_error (error,
+                       COGL_TEXTURE_ERROR,
+                       COGL_TEXTURE_ERROR_FORMAT,
+                       "The region of a compressed texture can't be "
+                       "modified");
+      return FALSE;
+    }
+
   if (!ctx->driver_vtable->texture_2d_copy_from_bitmap (tex_2d,
                                                         src_x,
                                                         src_y,
@@ -660,6 +715,44 @@ _cogl_texture_2d_get_type (CoglTexture *tex)
   return COGL_TEXTURE_TYPE_2D;
 }
 
+static size_t
+_cogl_texture_2d_get_gpu_bytes (CoglTexture *tex)
+{
+  CoglTexture2D *tex_2d = COGL_TEXTURE_2D (tex);
+  size_t bytes = 0;
+  int block_size;
+  int level;
+
+  if (!tex_2d->is_compressed)
+    return _cogl_texture_residency_estimate_bytes (tex);
+
+  block_size = _cogl_compressed_format_get_block_size (tex_2d->compressed_format);
+
+  for (level = 0; level <= tex->max_level; level++)
+    {
+      int width, height;
+
+      _cogl_texture_get_level_size (tex, level, &width, &height, NULL);
+
+      bytes += (size_t) ((width + 3) / 4) * ((height + 3) / 4) * block_size;
+    }
+
+  return bytes;
+}
+
+static void
+_cogl_texture_2d_discard_storage (CoglTexture *tex)
+{
+  CoglTexture2D *tex_2d = COGL_TEXTURE_2D (tex);
+  CoglContext *ctx = tex->context;
+
+  ctx->driver_vtable->texture_2d_free (tex_2d);
+  ctx->driver_vtable->texture_2d_init (tex_2d);
+
+  tex_2d->mipmaps_dirty = TRUE;
+  tex_2d->is_compressed = FALSE;
+}
+
 static const CoglTextureVtable
 cogl_texture_2d_vtable =
   {
@@ -681,5 +774,7 @@ cogl_texture_2d_vtable =
     _cogl_texture_2d_get_gl_format,
     _cogl_texture_2d_get_type,
     _cogl_texture_2d_is_foreign,
-    _cogl_texture_2d_set_auto_mipmap
+    _cogl_texture_2d_set_auto_mipmap,
+    _cogl_texture_2d_get_gpu_bytes,
+    _cogl_texture_2d_discard_storage
   };
@@ -127,6 +127,11 @@ cogl_texture_2d_new_with_size (CoglContext *ctx,
  * using cogl_texture_set_components() and
  * cogl_texture_set_premultiplied().
  *
+ * KTX and DDS files containing S3TC, ETC2 or BPTC compressed data are
+ * uploaded without being decompressed when the driver supports the
+ * format. Otherwise S3TC and ETC2 data is decompressed on the CPU.
+ * The components of these files are assumed not to be premultiplied.
+ *
  * <note>Many GPUs only support power of two sizes for #CoglTexture2D
  * textures. You can check support for non power of two textures by
  * checking for the %COGL_FEATURE_ID_TEXTURE_NPOT feature via
@@ -0,0 +1,70 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifndef __COGL_TEXTURE_BATCH_PRIVATE_H
+#define __COGL_TEXTURE_BATCH_PRIVATE_H
+
+#include "cogl-object-private.h"
+#include "cogl-texture-batch.h"
+#include "cogl-bitmap-private.h"
+#include "cogl-mipmap-private.h"
+
+typedef struct _CoglTextureBatchEntry
+{
+  char *filename;
+  CoglTextureBatchFlags flags;
+  CoglTextureBatchCallback callback;
+  void *user_data;
+
+  /* These are filled in while the batch is being loaded. The worker
+     threads decode the file into 'decoded' and then the bitmap is
+     created for it in the calling thread */
+  CoglDecodedImage decoded;
+  CoglBool is_decoded;
+  CoglBitmap *bitmap;
+  CoglError *error;
+
+  /* Levels 1 and above when COGL_TEXTURE_BATCH_FLAG_MIPMAP is used */
+  CoglMipmapLevel *mipmap_levels;
+  int n_mipmap_levels;
+  CoglPixelFormat mipmap_format;
+} CoglTextureBatchEntry;
+
+struct _CoglTextureBatch
+{
+  CoglObject _parent;
+
+  CoglContext *context;
+
+  /* Array of CoglTextureBatchEntries in the order they were added */
+  GArray *entries;
+};
+
+#endif /* __COGL_TEXTURE_BATCH_PRIVATE_H */
@@ -0,0 +1,408 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include "cogl-util.h"
+#include "cogl-context-private.h"
+#include "cogl-bitmap-private.h"
+#include "cogl-error-private.h"
+#include "cogl-texture-batch-private.h"
+#include "cogl-texture-2d.h"
+#include "cogl-atlas-texture-private.h"
+#include "cogl-worker-pool-private.h"
+
+static void _cogl_texture_batch_free (CoglTextureBatch *batch);
+
+COGL_OBJECT_DEFINE (TextureBatch, texture_batch);
+
+static void
+clear_entry (CoglTextureBatchEntry *entry)
+{
+  g_free (entry->filename);
+
+  if (entry->bitmap)
+    cogl_object_unref (entry->bitmap);
+  if (entry->error)
+    cogl_error_free (entry->error);
+  if (entry->mipmap_levels)
+    _cogl_mipmap_free_levels (entry->mipmap_levels, entry->n_mipmap_levels);
+}
+
+static void
+free_entries (GArray *entries)
+{
+  int i;
+
+  for (i = 0; i < entries->len; i++)
+    clear_entry (&g_array_index (entries, CoglTextureBatchEntry, i));
+
+  g_array_free (entries, TRUE);
+}
+
+static void
+_cogl_texture_batch_free (CoglTextureBatch *batch)
+{
+  free_entries (batch->entries);
+
+  g_slice_free (CoglTextureBatch, batch);
+}
+
+CoglTextureBatch *
+cogl_texture_batch_new (CoglContext *context)
+{
+  CoglTextureBatch *batch = g_slice_new (CoglTextureBatch);
+
+  batch->context = context;
+  batch->entries = g_array_new (FALSE, FALSE, sizeof (CoglTextureBatchEntry));
+
+  return _cogl_texture_batch_object_new (batch);
+}
+
+void
+cogl_texture_batch_add_file (CoglTextureBatch *batch,
+                             const char *filename,
+                             CoglTextureBatchFlags flags,
+                             CoglTextureBatchCallback callback,
+                             void *user_data)
+{
+  CoglTextureBatchEntry *entry;
+
+  _COGL_RETURN_IF_FAIL (cogl_is_texture_batch (batch));
+  _COGL_RETURN_IF_FAIL (filename != NULL);
+  _COGL_RETURN_IF_FAIL (callback != NULL);
+
+  g_array_set_size (batch->entries, batch->entries->len + 1);
+  entry = &g_array_index (batch->entries,
+                          CoglTextureBatchEntry,
+                          batch->entries->len - 1);
+
+  entry->filename = g_strdup (filename);
+  entry->flags = flags;
+  entry->callback = callback;
+  entry->user_data = user_data;
+  entry->is_decoded = FALSE;
+  entry->bitmap = NULL;
+  entry->error = NULL;
+  entry->mipmap_levels = NULL;
+  entry->n_mipmap_levels = 0;
+}
+
+int
+cogl_texture_batch_get_n_files (CoglTextureBatch *batch)
+{
+  return batch->entries->len;
+}
+
+/* Runs in a worker thread. This must not create or destroy any Cogl
+   objects or touch the GL context so the file is only decoded into
+   plain memory. The bitmap is created for it in the calling thread
+   afterwards. */
+static void
+decode_entry_cb (int index,
+                 void *user_data)
+{
+  GArray *entries = user_data;
+  CoglTextureBatchEntry *entry =
+    &g_array_index (entries, CoglTextureBatchEntry, index);
+
+  entry->is_decoded = _cogl_bitmap_decode_file (entry->filename,
+                                                &entry->decoded,
+                                                &entry->error);
+}
+
+/* Runs in a worker thread. This only works on the pixel data of a
+   bitmap that was created in the calling thread. */
+static void
+premultiply_entry_cb (int index,
+                      void *user_data)
+{
+  GArray *entries = user_data;
+  CoglTextureBatchEntry *entry =
+    &g_array_index (entries, CoglTextureBatchEntry, index);
+  CoglPixelFormat format;
+
+  if (entry->bitmap == NULL)
+    return;
+
+  /* Textures are premultiplied by default so we can save the context
+     thread from having to do the conversion while uploading by doing
+     it here in place */
+  format = cogl_bitmap_get_format (entry->bitmap);
+
+  if ((format & COGL_A_BIT) &&
+      format != COGL_PIXEL_FORMAT_A_8 &&
+      COGL_PIXEL_FORMAT_CAN_HAVE_PREMULT (format) &&
+      !(format & COGL_PREMULT_BIT))
+    _cogl_bitmap_convert_premult_status (entry->bitmap,
+                                         format | COGL_PREMULT_BIT,
+                                         &entry->error);
+}
+
+static CoglBool
+build_mipmaps (CoglTextureBatchEntry *entry,
+               CoglWorkerPool *pool,
+               CoglError **error)
+{
+  CoglBitmap *source = entry->bitmap;
+  CoglPixelFormat format = cogl_bitmap_get_format (source);
+  CoglMipmapFlags flags = COGL_MIPMAP_FLAG_NONE;
+  uint8_t *data;
+
+  /* The filters need premultiplied data with the alpha in the last
+     byte. The image will usually already be in one of these formats
+     after decoding */
+  if (format == COGL_PIXEL_FORMAT_RGBA_8888_PRE ||
+      format == COGL_PIXEL_FORMAT_BGRA_8888_PRE)
+    cogl_object_ref (source);
+  else
+    {
+      format = COGL_PIXEL_FORMAT_RGBA_8888_PRE;
+      source = _cogl_bitmap_convert (source, format, error);
+
+      if (source == NULL)
+        return FALSE;
+    }
+
+  if ((entry->flags & COGL_TEXTURE_BATCH_FLAG_SRGB))
+    flags |= COGL_MIPMAP_FLAG_SRGB;
+
+  data = _cogl_bitmap_map (source,
+                           COGL_BUFFER_ACCESS_READ,
+                           0, /* hints */
+                           error);
+
+  if (data)
+    {
+      entry->mipmap_levels =
+        _cogl_mipmap_build (pool,
+                            data,
+                            cogl_bitmap_get_width (source),
+                            cogl_bitmap_get_height (source),
+                            cogl_bitmap_get_rowstride (source),
+                            COGL_MIPMAP_FILTER_KAISER,
+                            flags,
+                            &entry->n_mipmap_levels);
+      entry->mipmap_format = format;
+
+      _cogl_bitmap_unmap (source);
+    }
+
+  cogl_object_unref (source);
+
+  return data != NULL;
+}
+
+static int
+compare_entry_size (const void *a,
+                    const void *b)
+{
+  const CoglTextureBatchEntry *entry_a = *(const CoglTextureBatchEntry **) a;
+  const CoglTextureBatchEntry *entry_b = *(const CoglTextureBatchEntry **) b;
+  int area_a = 0, area_b = 0;
+
+  if (entry_a->bitmap)
+    area_a = (cogl_bitmap_get_width (entry_a->bitmap) *
+              cogl_bitmap_get_height (entry_a->bitmap));
+  if (entry_b->bitmap)
+    area_b = (cogl_bitmap_get_width (entry_b->bitmap) *
+              cogl_bitmap_get_height (entry_b->bitmap));
+
+  /* Largest first. Entries of the same size keep the order they were
+     added in */
+  if (area_a != area_b)
+    return area_a > area_b ? -1 : 1;
+  else
+    return entry_a < entry_b ? -1 : entry_a > entry_b ? 1 : 0;
+}
+
+/* The mipmapped atlases build their own levels for each image with a
+   box filter that doesn't know about sRGB so those images always get
+   a texture of their own */
+static CoglBool
+use_mipmapped_atlas (CoglTextureBatchEntry *entry)
+{
+  return ((entry->flags & COGL_TEXTURE_BATCH_FLAG_ATLAS) &&
+          (entry->flags & COGL_TEXTURE_BATCH_FLAG_MIPMAP) &&
+          !(entry->flags & COGL_TEXTURE_BATCH_FLAG_SRGB));
+}
+
+static CoglTexture *
+create_texture (CoglTextureBatchEntry *entry,
+                CoglWorkerPool *pool,
+                CoglError **error)
+{
+  CoglTexture *tex;
+
+  if ((entry->flags & COGL_TEXTURE_BATCH_FLAG_ATLAS) &&
+      (!(entry->flags & COGL_TEXTURE_BATCH_FLAG_MIPMAP) ||
+       use_mipmapped_atlas (entry)))
+    {
+      CoglError *atlas_error = NULL;
+
+      if ((entry->flags & COGL_TEXTURE_BATCH_FLAG_MIPMAP))
+        tex = COGL_TEXTURE (_cogl_atlas_texture_new_mipmapped_from_bitmap
+                            (entry->bitmap));
+      else
+        tex = COGL_TEXTURE (cogl_atlas_texture_new_from_bitmap
+                            (entry->bitmap));
+
+      if (cogl_texture_allocate (tex, &atlas_error))
+        return tex;
+
+      COGL_NOTE (ATLAS, "Batch image %s couldn't be atlased: %s",
+                 entry->filename, atlas_error->message);
+
+      cogl_error_free (atlas_error);
+      cogl_object_unref (tex);
+    }
+
+  /* The levels weren't built up front if the image was expected to
+     go in a mipmapped atlas */
+  if ((entry->flags & COGL_TEXTURE_BATCH_FLAG_MIPMAP) &&
+      entry->mipmap_levels == NULL &&
+      !build_mipmaps (entry, pool, error))
+    return NULL;
+
+  tex = COGL_TEXTURE (cogl_texture_2d_new_from_bitmap (entry->bitmap));
+
+  if (!cogl_texture_allocate (tex, error) ||
+      ((entry->flags & COGL_TEXTURE_BATCH_FLAG_MIPMAP) &&
+       !_cogl_mipmap_upload (tex,
+                             entry->mipmap_format,
+                             entry->mipmap_levels,
+                             entry->n_mipmap_levels,
+                             error)))
+    {
+      cogl_object_unref (tex);
+      return NULL;
+    }
+
+  return tex;
+}
+
+void
+cogl_texture_batch_load (CoglTextureBatch *batch)
+{
+  CoglContext *ctx = batch->context;
+  CoglTextureBatchEntry **sorted;
+  GArray *entries;
+  int n_entries;
+  int i;
+
+  _COGL_RETURN_IF_FAIL (cogl_is_texture_batch (batch));
+
+  /* Steal the list of entries so that the callbacks are free to add
+     more files to the batch for the next load */
+  entries = batch->entries;
+  n_entries = entries->len;
+
+  if (n_entries == 0)
+    return;
+
+  batch->entries = g_array_new (FALSE, FALSE, sizeof (CoglTextureBatchEntry));
+
+  /* The files are read and decoded entirely in the worker threads */
+  _cogl_worker_pool_run (_cogl_context_get_worker_pool (ctx),
+                         n_entries,
+                         decode_entry_cb,
+                         entries);
+
+  /* Wrapping the pixels in a bitmap doesn't copy them so this is
+     cheap */
+  for (i = 0; i < n_entries; i++)
+    {
+      CoglTextureBatchEntry *entry =
+        &g_array_index (entries, CoglTextureBatchEntry, i);
+
+      if (entry->is_decoded)
+        entry->bitmap = _cogl_bitmap_new_from_decoded_image (ctx,
+                                                             &entry->decoded);
+    }
+
+  _cogl_worker_pool_run (_cogl_context_get_worker_pool (ctx),
+                         n_entries,
+                         premultiply_entry_cb,
+                         entries);
+
+  sorted = g_new (CoglTextureBatchEntry *, n_entries);
+
+  for (i = 0; i < n_entries; i++)
+    {
+      CoglTextureBatchEntry *entry =
+        &g_array_index (entries, CoglTextureBatchEntry, i);
+
+      /* Each mipmap level depends on the previous one so the images
+         are done one at a time with the rows of each level split
+         over the workers instead */
+      if ((entry->flags & COGL_TEXTURE_BATCH_FLAG_MIPMAP) &&
+          !use_mipmapped_atlas (entry) &&
+          entry->bitmap &&
+          entry->error == NULL)
+        build_mipmaps (entry,
+                       _cogl_context_get_worker_pool (ctx),
+                       &entry->error);
+
+      if (entry->error && entry->bitmap)
+        {
+          cogl_object_unref (entry->bitmap);
+          entry->bitmap = NULL;
+        }
+
+      sorted[i] = entry;
+    }
+
+  qsort (sorted, n_entries, sizeof (CoglTextureBatchEntry *),
+         compare_entry_size);
+
+  for (i = 0; i < n_entries; i++)
+    {
+      CoglTextureBatchEntry *entry = sorted[i];
+      CoglTexture *tex = NULL;
+
+      if (entry->bitmap)
+        tex = create_texture (entry,
+                              _cogl_context_get_worker_pool (ctx),
+                              &entry->error);
+
+      entry->callback (tex, entry->filename, entry->error, entry->user_data);
+
+      if (tex)
+        cogl_object_unref (tex);
+    }
+
+  g_free (sorted);
+
+  free_entries (entries);
+}
@@ -0,0 +1,216 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#if !defined(__COGL_H_INSIDE__) && !defined(COGL_COMPILATION)
+#error "Only <cogl/cogl.h> can be included directly."
+#endif
+
+#ifndef __COGL_TEXTURE_BATCH_H__
+#define __COGL_TEXTURE_BATCH_H__
+
+#include <cogl/cogl-types.h>
+#include <cogl/cogl-context.h>
+#include <cogl/cogl-texture.h>
+
+COGL_BEGIN_DECLS
+
+/**
+ * SECTION:cogl-texture-batch
+ * @short_description: Functions for loading many image files at once
+ *
+ * A #CoglTextureBatch collects a list of image files that should be
+ * turned into textures and then loads them all in one go. Decoding
+ * the files and converting the pixels into the format that will be
+ * uploaded is done on a pool of worker threads so that the work is
+ * spread over all of the available cores. Only the final step of
+ * creating the textures is done in the thread that called
+ * cogl_texture_batch_load().
+ *
+ * The textures are created in order of decreasing size. When the
+ * images are being placed in Cogl's shared texture atlases this tends
+ * to pack them much more tightly than adding them in an arbitrary
+ * order.
+ */
+
+/**
+ * CoglTextureBatch:
+ *
+ * An opaque object representing a list of image files waiting to be
+ * loaded.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef struct _CoglTextureBatch CoglTextureBatch;
+
+/**
+ * CoglTextureBatchFlags:
+ * @COGL_TEXTURE_BATCH_FLAG_NONE: No flags
+ * @COGL_TEXTURE_BATCH_FLAG_ATLAS: Try to put the image in one of
+ *   Cogl's shared texture atlases. If the image can't be atlased a
+ *   #CoglTexture2D will be created instead.
+ * @COGL_TEXTURE_BATCH_FLAG_MIPMAP: Build all of the mipmap levels on
+ *   the worker threads and upload them along with the image. The
+ *   texture won't then need to generate its mipmaps the first time
+ *   it is drawn with a mipmap filter. If
+ *   %COGL_TEXTURE_BATCH_FLAG_ATLAS is also given the image is tried
+ *   in a mipmapped atlas instead. The levels of atlased images are
+ *   built with a simple box filter when they are added and only the
+ *   first few levels are kept separate from the neighbouring images.
+ *   Images that are also %COGL_TEXTURE_BATCH_FLAG_SRGB are never
+ *   atlased.
+ * @COGL_TEXTURE_BATCH_FLAG_SRGB: The colours of the image are sRGB
+ *   encoded so the mipmap levels built for
+ *   %COGL_TEXTURE_BATCH_FLAG_MIPMAP are averaged in linear light.
+ *   This has no effect without %COGL_TEXTURE_BATCH_FLAG_MIPMAP.
+ *
+ * Flags that control what kind of texture is created for a file added
+ * with cogl_texture_batch_add_file().
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef enum _CoglTextureBatchFlags
+{
+  COGL_TEXTURE_BATCH_FLAG_NONE = 0,
+  COGL_TEXTURE_BATCH_FLAG_ATLAS = 1 << 0,
+  COGL_TEXTURE_BATCH_FLAG_MIPMAP = 1 << 1,
+  COGL_TEXTURE_BATCH_FLAG_SRGB = 1 << 2
+} CoglTextureBatchFlags;
+
+/**
+ * CoglTextureBatchCallback:
+ * @texture: The newly created texture or %NULL if the file couldn't
+ *   be loaded
+ * @filename: The name of the file that was loaded
+ * @error: A #CoglError describing why the file couldn't be loaded or
+ *   %NULL if loading succeeded
+ * @user_data: The private data passed to cogl_texture_batch_add_file()
+ *
+ * The callback prototype used with cogl_texture_batch_add_file() to
+ * be notified when a file has been loaded. The batch keeps its own
+ * reference on @texture only for the duration of the callback so if
+ * the application wants to keep the texture it must take a reference
+ * with cogl_object_ref().
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef void (* CoglTextureBatchCallback) (CoglTexture *texture,
+                                           const char *filename,
+                                           const CoglError *error,
+                                           void *user_data);
+
+/**
+ * cogl_texture_batch_new:
+ * @context: A #CoglContext
+ *
+ * Creates a new, empty #CoglTextureBatch.
+ *
+ * Return value: (transfer full): A newly allocated #CoglTextureBatch
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglTextureBatch *
+cogl_texture_batch_new (CoglContext *context);
+
+/**
+ * cogl_texture_batch_add_file:
+ * @batch: A #CoglTextureBatch
+ * @filename: The image file to load
+ * @flags: #CoglTextureBatchFlags to control the type of texture
+ * @callback: (scope call): A #CoglTextureBatchCallback to call once
+ *   the file has been loaded
+ * @user_data: (closure): Private data to pass to @callback
+ *
+ * Adds an image file to the list of files that will be loaded the
+ * next time cogl_texture_batch_load() is called. Nothing is read from
+ * the file until then.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_texture_batch_add_file (CoglTextureBatch *batch,
+                             const char *filename,
+                             CoglTextureBatchFlags flags,
+                             CoglTextureBatchCallback callback,
+                             void *user_data);
+
+/**
+ * cogl_texture_batch_get_n_files:
+ * @batch: A #CoglTextureBatch
+ *
+ * Return value: The number of files that will be loaded by the next
+ *   call to cogl_texture_batch_load().
+ * Since: 2.0
+ * Stability: Unstable
+ */
+int
+cogl_texture_batch_get_n_files (CoglTextureBatch *batch);
+
+/**
+ * cogl_texture_batch_load:
+ * @batch: A #CoglTextureBatch
+ *
+ * Loads all of the files that have been added to @batch. The images
+ * are decoded and converted in parallel and then a texture is created
+ * for each one in the calling thread. The callback for each file is
+ * invoked as soon as its texture has been created. If a file can't be
+ * loaded its callback is still invoked with a %NULL texture and an
+ * error.
+ *
+ * The function doesn't return until every callback has been invoked.
+ * Afterwards the batch is empty again and can be reused to load more
+ * files.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_texture_batch_load (CoglTextureBatch *batch);
+
+/**
+ * cogl_is_texture_batch:
+ * @object: A #CoglObject pointer
+ *
+ * Gets whether the given object references a #CoglTextureBatch.
+ *
+ * Return value: %TRUE if the object references a #CoglTextureBatch
+ *   and %FALSE otherwise.
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglBool
+cogl_is_texture_batch (void *object);
+
+COGL_END_DECLS
+
+#endif /* __COGL_TEXTURE_BATCH_H__ */
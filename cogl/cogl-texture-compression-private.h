@@ -0,0 +1,173 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifndef __COGL_TEXTURE_COMPRESSION_PRIVATE_H
+#define __COGL_TEXTURE_COMPRESSION_PRIVATE_H
+
+#include "cogl-context.h"
+#include "cogl-bitmap.h"
+#include "cogl-gl-header.h"
+
+/* Block compressed formats that Cogl knows how to upload. All of
+ * these formats store 4x4 blocks of texels. */
+typedef enum
+{
+  COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1,
+  COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5,
+  COGL_COMPRESSED_FORMAT_RGB8_ETC2,
+  COGL_COMPRESSED_FORMAT_RGBA8_ETC2_EAC,
+  /* There is no CPU codec for BPTC so these images can only be
+     uploaded directly when the driver supports the format */
+  COGL_COMPRESSED_FORMAT_RGBA_BPTC_UNORM
+} CoglCompressedFormat;
+
+#define COGL_COMPRESSED_IMAGE_MAX_LEVELS 16
+
+typedef struct _CoglCompressedImage
+{
+  CoglCompressedFormat format;
+  int width;
+  int height;
+
+  /* Whether the color components in the blocks have already been
+     multiplied by the alpha component. This can't be changed once
+     the data is compressed so the texture has to match it */
+  CoglBool premultiplied;
+
+  int n_levels;
+  size_t level_offsets[COGL_COMPRESSED_IMAGE_MAX_LEVELS];
+  size_t level_sizes[COGL_COMPRESSED_IMAGE_MAX_LEVELS];
+
+  /* All of the levels are stored one after another in this buffer */
+  uint8_t *data;
+  size_t data_size;
+} CoglCompressedImage;
+
+int
+_cogl_compressed_format_get_block_size (CoglCompressedFormat format);
+
+CoglBool
+_cogl_compressed_format_has_alpha (CoglCompressedFormat format);
+
+/* Whether Cogl has a CPU decoder for the format so that it can be
+ * used even if the driver doesn't support it */
+CoglBool
+_cogl_compressed_format_can_decode (CoglCompressedFormat format);
+
+GLenum
+_cogl_compressed_format_to_gl (CoglCompressedFormat format);
+
+CoglBool
+_cogl_compressed_format_is_supported (CoglContext *ctx,
+                                      CoglCompressedFormat format);
+
+/*
+ * _cogl_compressed_format_choose_for_encoding:
+ * @ctx: A #CoglContext
+ * @has_alpha: Whether the alpha component needs to be stored
+ * @format_out: Return location for the chosen format
+ *
+ * Picks a format that the driver supports and that Cogl can encode
+ * on the CPU.
+ *
+ * Return value: %FALSE if there is no suitable format
+ */
+CoglBool
+_cogl_compressed_format_choose_for_encoding (CoglContext *ctx,
+                                             CoglBool has_alpha,
+                                             CoglCompressedFormat *format_out);
+
+CoglCompressedImage *
+_cogl_compressed_image_new (CoglCompressedFormat format,
+                            int width,
+                            int height,
+                            int n_levels);
+
+void
+_cogl_compressed_image_free (CoglCompressedImage *image);
+
+void
+_cogl_compressed_image_get_level_size (CoglCompressedImage *image,
+                                       int level,
+                                       int *width_out,
+                                       int *height_out);
+
+/*
+ * _cogl_compressed_image_new_from_data:
+ * @data: The contents of a KTX or DDS file
+ * @size: The size of @data in bytes
+ * @error: A #CoglError return location
+ *
+ * Parses a KTX or DDS container. If the data isn't in either of
+ * these containers then %NULL is returned without setting @error so
+ * that the caller can fall back to a regular image loader.
+ */
+CoglCompressedImage *
+_cogl_compressed_image_new_from_data (const uint8_t *data,
+                                      size_t size,
+                                      CoglError **error);
+
+CoglCompressedImage *
+_cogl_compressed_image_new_from_file (const char *filename,
+                                      CoglError **error);
+
+/*
+ * _cogl_compressed_image_new_from_bitmap:
+ * @bitmap: The source bitmap
+ * @format: The compressed format to encode to
+ * @premultiplied: Whether to store premultiplied components
+ * @with_mipmaps: Whether to generate and encode a full mipmap chain
+ * @error: A #CoglError return location
+ *
+ * Encodes the bitmap on the CPU. The blocks are spread over the
+ * context's worker threads.
+ */
+CoglCompressedImage *
+_cogl_compressed_image_new_from_bitmap (CoglBitmap *bitmap,
+                                        CoglCompressedFormat format,
+                                        CoglBool premultiplied,
+                                        CoglBool with_mipmaps,
+                                        CoglError **error);
+
+/*
+ * _cogl_compressed_image_decode:
+ * @ctx: A #CoglContext
+ * @image: The compressed image
+ * @error: A #CoglError return location
+ *
+ * Decodes the first level of the image into a new RGBA bitmap. This
+ * is used when the driver doesn't support the format.
+ */
+CoglBitmap *
+_cogl_compressed_image_decode (CoglContext *ctx,
+                               CoglCompressedImage *image,
+                               CoglError **error);
+
+#endif /* __COGL_TEXTURE_COMPRESSION_PRIVATE_H */
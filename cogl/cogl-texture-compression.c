@@ -0,0 +1,1912 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <limits.h>
+#include <float.h>
+#include <math.h>
+
+#include <test-fixtures/test-unit.h>
+
+#include "cogl-util.h"
+#include "cogl-private.h"
+#include "cogl-context-private.h"
+#include "cogl-bitmap-private.h"
+#include "cogl-error-private.h"
+#include "cogl-texture-compression-private.h"
+#include "cogl-worker-pool-private.h"
+#include "cogl-mapped-file-private.h"
+
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+#ifndef GL_COMPRESSED_RGB8_ETC2
+#define GL_COMPRESSED_RGB8_ETC2 0x9274
+#endif
+#ifndef GL_COMPRESSED_RGBA8_ETC2_EAC
+#define GL_COMPRESSED_RGBA8_ETC2_EAC 0x9278
+#endif
+#ifndef GL_COMPRESSED_RGBA_BPTC_UNORM
+#define GL_COMPRESSED_RGBA_BPTC_UNORM 0x8E8C
+#endif
+
+/* Each work item given to the worker pool encodes this many rows of
+   blocks */
+#define BLOCK_ROWS_PER_WORK_ITEM 4
+
+int
+_cogl_compressed_format_get_block_size (CoglCompressedFormat format)
+{
+  switch (format)
+    {
+    case COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1:
+    case COGL_COMPRESSED_FORMAT_RGB8_ETC2:
+      return 8;
+    case COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5:
+    case COGL_COMPRESSED_FORMAT_RGBA8_ETC2_EAC:
+    case COGL_COMPRESSED_FORMAT_RGBA_BPTC_UNORM:
+      return 16;
+    }
+
+  g_return_val_if_reached (16);
+}
+
+CoglBool
+_cogl_compressed_format_has_alpha (CoglCompressedFormat format)
+{
+  switch (format)
+    {
+    case COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1:
+    case COGL_COMPRESSED_FORMAT_RGB8_ETC2:
+      return FALSE;
+    case COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5:
+    case COGL_COMPRESSED_FORMAT_RGBA8_ETC2_EAC:
+    case COGL_COMPRESSED_FORMAT_RGBA_BPTC_UNORM:
+      return TRUE;
+    }
+
+  g_return_val_if_reached (TRUE);
+}
+
+CoglBool
+_cogl_compressed_format_can_decode (CoglCompressedFormat format)
+{
+  return format != COGL_COMPRESSED_FORMAT_RGBA_BPTC_UNORM;
+}
+
+GLenum
+_cogl_compressed_format_to_gl (CoglCompressedFormat format)
+{
+  switch (format)
+    {
+    case COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1:
+      return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5:
+      return GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+    case COGL_COMPRESSED_FORMAT_RGB8_ETC2:
+      return GL_COMPRESSED_RGB8_ETC2;
+    case COGL_COMPRESSED_FORMAT_RGBA8_ETC2_EAC:
+      return GL_COMPRESSED_RGBA8_ETC2_EAC;
+    case COGL_COMPRESSED_FORMAT_RGBA_BPTC_UNORM:
+      return GL_COMPRESSED_RGBA_BPTC_UNORM;
+    }
+
+  g_return_val_if_reached (0);
+}
+
+CoglBool
+_cogl_compressed_format_is_supported (CoglContext *ctx,
+                                      CoglCompressedFormat format)
+{
+  CoglPrivateFeature feature;
+
+  switch (format)
+    {
+    case COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1:
+    case COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5:
+      feature = COGL_PRIVATE_FEATURE_TEXTURE_COMPRESSION_S3TC;
+      break;
+    case COGL_COMPRESSED_FORMAT_RGB8_ETC2:
+    case COGL_COMPRESSED_FORMAT_RGBA8_ETC2_EAC:
+      feature = COGL_PRIVATE_FEATURE_TEXTURE_COMPRESSION_ETC2;
+      break;
+    case COGL_COMPRESSED_FORMAT_RGBA_BPTC_UNORM:
+      feature = COGL_PRIVATE_FEATURE_TEXTURE_COMPRESSION_BPTC;
+      break;
+    default:
+      g_return_val_if_reached (FALSE);
+    }
+
+  return (ctx->glCompressedTexImage2D != NULL &&
+          _cogl_has_private_feature (ctx, feature));
+}
+
+CoglBool
+_cogl_compressed_format_choose_for_encoding (CoglContext *ctx,
+                                             CoglBool has_alpha,
+                                             CoglCompressedFormat *format_out)
+{
+  static const CoglCompressedFormat alpha_formats[] =
+    {
+      COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5,
+      COGL_COMPRESSED_FORMAT_RGBA8_ETC2_EAC
+    };
+  static const CoglCompressedFormat opaque_formats[] =
+    {
+      COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1,
+      COGL_COMPRESSED_FORMAT_RGB8_ETC2
+    };
+  const CoglCompressedFormat *formats;
+  int n_formats;
+  int i;
+
+  if (has_alpha)
+    {
+      formats = alpha_formats;
+      n_formats = G_N_ELEMENTS (alpha_formats);
+    }
+  else
+    {
+      formats = opaque_formats;
+      n_formats = G_N_ELEMENTS (opaque_formats);
+    }
+
+  for (i = 0; i < n_formats; i++)
+    if (_cogl_compressed_format_is_supported (ctx, formats[i]))
+      {
+        *format_out = formats[i];
+        return TRUE;
+      }
+
+  return FALSE;
+}
+
+static size_t
+get_level_size (CoglCompressedFormat format,
+                int width,
+                int height)
+{
+  return ((size_t) ((width + 3) / 4) * ((height + 3) / 4) *
+          _cogl_compressed_format_get_block_size (format));
+}
+
+CoglCompressedImage *
+_cogl_compressed_image_new (CoglCompressedFormat format,
+                            int width,
+                            int height,
+                            int n_levels)
+{
+  CoglCompressedImage *image = g_slice_new (CoglCompressedImage);
+  size_t offset = 0;
+  int level;
+
+  _COGL_RETURN_VAL_IF_FAIL (n_levels >= 1 &&
+                            n_levels <= COGL_COMPRESSED_IMAGE_MAX_LEVELS,
+                            NULL);
+
+  image->format = format;
+  image->width = width;
+  image->height = height;
+  image->premultiplied = FALSE;
+  image->n_levels = n_levels;
+
+  for (level = 0; level < n_levels; level++)
+    {
+      int level_width, level_height;
+
+      _cogl_compressed_image_get_level_size (image,
+                                             level,
+                                             &level_width,
+                                             &level_height);
+
+      image->level_offsets[level] = offset;
+      image->level_sizes[level] = get_level_size (format,
+                                                  level_width,
+                                                  level_height);
+      offset += image->level_sizes[level];
+    }
+
+  image->data = g_malloc (offset);
+  image->data_size = offset;
+
+  return image;
+}
+
+void
+_cogl_compressed_image_free (CoglCompressedImage *image)
+{
+  g_free (image->data);
+  g_slice_free (CoglCompressedImage, image);
+}
+
+void
+_cogl_compressed_image_get_level_size (CoglCompressedImage *image,
+                                       int level,
+                                       int *width_out,
+                                       int *height_out)
+{
+  *width_out = MAX (image->width >> level, 1);
+  *height_out = MAX (image->height >> level, 1);
+}
+
+static int
+get_n_mipmap_levels (int width,
+                     int height)
+{
+  int n_levels = 1;
+  int size = MAX (width, height);
+
+  while (size > 1 && n_levels < COGL_COMPRESSED_IMAGE_MAX_LEVELS)
+    {
+      size >>= 1;
+      n_levels++;
+    }
+
+  return n_levels;
+}
+
+/*
+ * S3TC (DXT1 / DXT5)
+ */
+
+static uint16_t
+pack_565 (const uint8_t *color)
+{
+  return (((color[0] * 31 + 127) / 255) << 11 |
+          ((color[1] * 63 + 127) / 255) << 5 |
+          ((color[2] * 31 + 127) / 255));
+}
+
+static void
+unpack_565 (uint16_t value,
+            uint8_t *color)
+{
+  int r = (value >> 11) & 0x1f;
+  int g = (value >> 5) & 0x3f;
+  int b = value & 0x1f;
+
+  color[0] = (r << 3) | (r >> 2);
+  color[1] = (g << 2) | (g >> 4);
+  color[2] = (b << 3) | (b >> 2);
+  color[3] = 255;
+}
+
+static void
+get_s3tc_palette (uint16_t c0,
+                  uint16_t c1,
+                  CoglBool allow_three_color,
+                  uint8_t palette[4][4])
+{
+  int i;
+
+  unpack_565 (c0, palette[0]);
+  unpack_565 (c1, palette[1]);
+
+  if (c0 > c1 || !allow_three_color)
+    {
+      for (i = 0; i < 3; i++)
+        {
+          palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+          palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+        }
+      palette[2][3] = palette[3][3] = 255;
+    }
+  else
+    {
+      for (i = 0; i < 3; i++)
+        palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+      palette[2][3] = 255;
+      memset (palette[3], 0, 4);
+    }
+}
+
+static int
+color_distance (const uint8_t *a,
+                const uint8_t *b)
+{
+  int dr = a[0] - b[0];
+  int dg = a[1] - b[1];
+  int db = a[2] - b[2];
+
+  return dr * dr + dg * dg + db * db;
+}
+
+static void
+get_principal_axis (const uint8_t *pixels,
+                    float *mean,
+                    float *axis)
+{
+  float cov[6] = { 0 };
+  int i, j;
+
+  mean[0] = mean[1] = mean[2] = 0.0f;
+  for (i = 0; i < 16; i++)
+    for (j = 0; j < 3; j++)
+      mean[j] += pixels[i * 4 + j] / 16.0f;
+
+  for (i = 0; i < 16; i++)
+    {
+      float r = pixels[i * 4 + 0] - mean[0];
+      float g = pixels[i * 4 + 1] - mean[1];
+      float b = pixels[i * 4 + 2] - mean[2];
+
+      cov[0] += r * r;
+      cov[1] += r * g;
+      cov[2] += r * b;
+      cov[3] += g * g;
+      cov[4] += g * b;
+      cov[5] += b * b;
+    }
+
+  /* A few rounds of power iteration is enough to find the dominant
+     eigenvector of the covariance matrix */
+  axis[0] = axis[1] = axis[2] = 1.0f;
+  for (i = 0; i < 4; i++)
+    {
+      float x = cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2];
+      float y = cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2];
+      float z = cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2];
+      float len = MAX (MAX (fabsf (x), fabsf (y)), fabsf (z));
+
+      if (len < 1e-6f)
+        break;
+
+      axis[0] = x / len;
+      axis[1] = y / len;
+      axis[2] = z / len;
+    }
+}
+
+static void
+encode_s3tc_color_block (const uint8_t *pixels,
+                         uint8_t *dst)
+{
+  float mean[3], axis[3];
+  float min_proj = FLT_MAX, max_proj = -FLT_MAX;
+  int min_pixel = 0, max_pixel = 0;
+  uint8_t palette[4][4];
+  uint16_t c0, c1;
+  uint32_t indices = 0;
+  int i;
+
+  get_principal_axis (pixels, mean, axis);
+
+  /* Use the two pixels at the extremes of the principal axis as the
+     end points */
+  for (i = 0; i < 16; i++)
+    {
+      float proj = ((pixels[i * 4 + 0] - mean[0]) * axis[0] +
+                    (pixels[i * 4 + 1] - mean[1]) * axis[1] +
+                    (pixels[i * 4 + 2] - mean[2]) * axis[2]);
+
+      if (proj < min_proj)
+        {
+          min_proj = proj;
+          min_pixel = i;
+        }
+      if (proj > max_proj)
+        {
+          max_proj = proj;
+          max_pixel = i;
+        }
+    }
+
+  c0 = pack_565 (pixels + max_pixel * 4);
+  c1 = pack_565 (pixels + min_pixel * 4);
+
+  /* Always use the four color mode so that the block decodes the same
+     way for DXT1 and DXT5 */
+  if (c0 < c1)
+    {
+      uint16_t tmp = c0;
+      c0 = c1;
+      c1 = tmp;
+    }
+
+  if (c0 != c1)
+    {
+      get_s3tc_palette (c0, c1, FALSE, palette);
+
+      for (i = 0; i < 16; i++)
+        {
+          int best_index = 0;
+          int best_distance = INT_MAX;
+          int j;
+
+          for (j = 0; j < 4; j++)
+            {
+              int distance = color_distance (pixels + i * 4, palette[j]);
+
+              if (distance < best_distance)
+                {
+                  best_distance = distance;
+                  best_index = j;
+                }
+            }
+
+          indices |= best_index << (i * 2);
+        }
+    }
+
+  dst[0] = c0 & 0xff;
+  dst[1] = c0 >> 8;
+  dst[2] = c1 & 0xff;
+  dst[3] = c1 >> 8;
+  dst[4] = indices & 0xff;
+  dst[5] = (indices >> 8) & 0xff;
+  dst[6] = (indices >> 16) & 0xff;
+  dst[7] = indices >> 24;
+}
+
+static void
+decode_s3tc_color_block (const uint8_t *src,
+                         CoglBool allow_three_color,
+                         uint8_t *pixels)
+{
+  uint16_t c0 = src[0] | (src[1] << 8);
+  uint16_t c1 = src[2] | (src[3] << 8);
+  uint32_t indices = (src[4] | (src[5] << 8) | (src[6] << 16) |
+                      ((uint32_t) src[7] << 24));
+  uint8_t palette[4][4];
+  int i;
+
+  get_s3tc_palette (c0, c1, allow_three_color, palette);
+
+  for (i = 0; i < 16; i++)
+    memcpy (pixels + i * 4, palette[(indices >> (i * 2)) & 3], 4);
+}
+
+static void
+get_dxt5_alpha_palette (int a0,
+                        int a1,
+                        int *palette)
+{
+  int i;
+
+  palette[0] = a0;
+  palette[1] = a1;
+
+  if (a0 > a1)
+    {
+      for (i = 2; i < 8; i++)
+        palette[i] = ((8 - i) * a0 + (i - 1) * a1) / 7;
+    }
+  else
+    {
+      for (i = 2; i < 6; i++)
+        palette[i] = ((6 - i) * a0 + (i - 1) * a1) / 5;
+      palette[6] = 0;
+      palette[7] = 255;
+    }
+}
+
+static void
+encode_dxt5_alpha_block (const uint8_t *pixels,
+                         uint8_t *dst)
+{
+  int min_alpha = 255, max_alpha = 0;
+  int palette[8];
+  uint64_t indices = 0;
+  int i;
+
+  for (i = 0; i < 16; i++)
+    {
+      min_alpha = MIN (min_alpha, pixels[i * 4 + 3]);
+      max_alpha = MAX (max_alpha, pixels[i * 4 + 3]);
+    }
+
+  dst[0] = max_alpha;
+  dst[1] = min_alpha;
+
+  if (max_alpha != min_alpha)
+    {
+      get_dxt5_alpha_palette (max_alpha, min_alpha, palette);
+
+      for (i = 0; i < 16; i++)
+        {
+          int best_index = 0, best_distance = INT_MAX;
+          int j;
+
+          for (j = 0; j < 8; j++)
+            {
+              int distance = ABS (pixels[i * 4 + 3] - palette[j]);
+
+              if (distance < best_distance)
+                {
+                  best_distance = distance;
+                  best_index = j;
+                }
+            }
+
+          indices |= (uint64_t) best_index << (i * 3);
+        }
+    }
+
+  for (i = 0; i < 6; i++)
+    dst[i + 2] = (indices >> (i * 8)) & 0xff;
+}
+
+static void
+decode_dxt5_alpha_block (const uint8_t *src,
+                         uint8_t *pixels)
+{
+  uint64_t indices = 0;
+  int palette[8];
+  int i;
+
+  get_dxt5_alpha_palette (src[0], src[1], palette);
+
+  for (i = 0; i < 6; i++)
+    indices |= (uint64_t) src[i + 2] << (i * 8);
+
+  for (i = 0; i < 16; i++)
+    pixels[i * 4 + 3] = palette[(indices >> (i * 3)) & 7];
+}
+
+/*
+ * ETC2 / EAC
+ *
+ * The encoder only ever produces blocks in the individual and
+ * differential modes of ETC1 which are also valid ETC2 blocks. The
+ * decoder handles the extra T, H and planar modes of ETC2 too so
+ * that it can be used as a fallback for pre-compressed images.
+ */
+
+static const int etc1_modifier_table[8][2] =
+  {
+    { 2, 8 },
+    { 5, 17 },
+    { 9, 29 },
+    { 13, 42 },
+    { 18, 60 },
+    { 24, 80 },
+    { 33, 106 },
+    { 47, 183 }
+  };
+
+static const int etc2_distance_table[8] =
+  { 3, 6, 11, 16, 23, 32, 41, 64 };
+
+static const int eac_modifier_table[16][8] =
+  {
+    { -3, -6, -9, -15, 2, 5, 8, 14 },
+    { -3, -7, -10, -13, 2, 6, 9, 12 },
+    { -2, -5, -8, -13, 1, 4, 7, 12 },
+    { -2, -4, -6, -13, 1, 3, 5, 12 },
+    { -3, -6, -8, -12, 2, 5, 7, 11 },
+    { -3, -7, -9, -11, 2, 6, 8, 10 },
+    { -4, -7, -8, -11, 3, 6, 7, 10 },
+    { -3, -5, -8, -11, 2, 4, 7, 10 },
+    { -2, -6, -8, -10, 1, 5, 7, 9 },
+    { -2, -5, -8, -10, 1, 4, 7, 9 },
+    { -2, -4, -8, -10, 1, 3, 7, 9 },
+    { -2, -5, -7, -10, 1, 4, 6, 9 },
+    { -3, -4, -7, -10, 2, 3, 6, 9 },
+    { -1, -2, -3, -10, 0, 1, 2, 9 },
+    { -4, -6, -8, -9, 3, 5, 7, 8 },
+    { -3, -5, -7, -9, 2, 4, 6, 8 }
+  };
+
+static int
+etc_modifier (int table,
+              int index)
+{
+  int value = etc1_modifier_table[table][index & 1];
+
+  return (index & 2) ? -value : value;
+}
+
+static int
+extend_4 (int value)
+{
+  return (value << 4) | value;
+}
+
+static int
+extend_5 (int value)
+{
+  return (value << 3) | (value >> 2);
+}
+
+/* ETC stores the pixels in column-major order */
+#define ETC_PIXEL(x, y) ((x) * 4 + (y))
+
+static CoglBool
+etc_pixel_in_subblock (int x,
+                       int y,
+                       CoglBool flip,
+                       int subblock)
+{
+  return (flip ? (y >= 2) : (x >= 2)) == subblock;
+}
+
+static void
+decode_etc2_paint_block (const int base_colors[2][3],
+                         int distance,
+                         CoglBool h_mode,
+                         uint32_t msb,
+                         uint32_t lsb,
+                         uint8_t *pixels)
+{
+  int paint[4][3];
+  int i, x, y;
+
+  for (i = 0; i < 3; i++)
+    {
+      if (h_mode)
+        {
+          paint[0][i] = base_colors[0][i] + distance;
+          paint[1][i] = base_colors[0][i] - distance;
+        }
+      else
+        {
+          paint[0][i] = base_colors[0][i];
+          paint[1][i] = base_colors[1][i] + distance;
+        }
+      paint[2][i] = base_colors[1][i] + (h_mode ? distance : 0);
+      paint[3][i] = base_colors[1][i] - distance;
+    }
+
+  for (y = 0; y < 4; y++)
+    for (x = 0; x < 4; x++)
+      {
+        int bit = ETC_PIXEL (x, y);
+        int index = (((msb >> bit) & 1) << 1) | ((lsb >> bit) & 1);
+        uint8_t *p = pixels + (y * 4 + x) * 4;
+
+        for (i = 0; i < 3; i++)
+          p[i] = CLAMP (paint[index][i], 0, 255);
+        p[3] = 255;
+      }
+}
+
+static void
+decode_etc2_planar_block (const uint8_t *src,
+                          uint8_t *pixels)
+{
+  int ro, go, bo, rh, gh, bh, rv, gv, bv;
+  int o[3], h[3], v[3];
+  int i, x, y;
+
+  ro = (src[0] >> 1) & 0x3f;
+  go = ((src[0] & 0x1) << 6) | ((src[1] >> 1) & 0x3f);
+  bo = (((src[1] & 0x1) << 5) | (src[2] & 0x18) |
+        ((src[2] << 1) & 0x6) | ((src[3] >> 7) & 0x1));
+  rh = ((src[3] >> 1) & 0x3e) | (src[3] & 0x1);
+  gh = (src[4] >> 1) & 0x7f;
+  bh = ((src[4] << 5) & 0x20) | ((src[5] >> 3) & 0x1f);
+  rv = ((src[5] << 3) & 0x38) | ((src[6] >> 5) & 0x7);
+  gv = ((src[6] << 2) & 0x7c) | ((src[7] >> 6) & 0x3);
+  bv = src[7] & 0x3f;
+
+  o[0] = (ro << 2) | (ro >> 4);
+  o[1] = (go << 1) | (go >> 6);
+  o[2] = (bo << 2) | (bo >> 4);
+  h[0] = (rh << 2) | (rh >> 4);
+  h[1] = (gh << 1) | (gh >> 6);
+  h[2] = (bh << 2) | (bh >> 4);
+  v[0] = (rv << 2) | (rv >> 4);
+  v[1] = (gv << 1) | (gv >> 6);
+  v[2] = (bv << 2) | (bv >> 4);
+
+  for (y = 0; y < 4; y++)
+    for (x = 0; x < 4; x++)
+      {
+        uint8_t *p = pixels + (y * 4 + x) * 4;
+
+        for (i = 0; i < 3; i++)
+          {
+            int value = (x * (h[i] - o[i]) + y * (v[i] - o[i]) +
+                         4 * o[i] + 2) >> 2;
+            p[i] = CLAMP (value, 0, 255);
+          }
+        p[3] = 255;
+      }
+}
+
+static void
+decode_etc2_rgb_block (const uint8_t *src,
+                       uint8_t *pixels)
+{
+  CoglBool diff = (src[3] & 0x2) != 0;
+  CoglBool flip = (src[3] & 0x1) != 0;
+  uint32_t msb = (src[4] << 8) | src[5];
+  uint32_t lsb = (src[6] << 8) | src[7];
+  int base_colors[2][3];
+  int tables[2];
+  int i, x, y;
+
+  if (diff)
+    {
+      int base[3], delta[3], sum[3];
+
+      for (i = 0; i < 3; i++)
+        {
+          base[i] = src[i] >> 3;
+          /* Sign extend the 3-bit delta */
+          delta[i] = ((int) (src[i] & 0x7) ^ 0x4) - 0x4;
+          sum[i] = base[i] + delta[i];
+        }
+
+      if (sum[0] < 0 || sum[0] > 31)
+        {
+          /* T mode */
+          int r1 = (((src[0] >> 3) & 0x3) << 2) | (src[0] & 0x3);
+
+          base_colors[0][0] = extend_4 (r1);
+          base_colors[0][1] = extend_4 (src[1] >> 4);
+          base_colors[0][2] = extend_4 (src[1] & 0xf);
+          base_colors[1][0] = extend_4 (src[2] >> 4);
+          base_colors[1][1] = extend_4 (src[2] & 0xf);
+          base_colors[1][2] = extend_4 (src[3] >> 4);
+
+          decode_etc2_paint_block (base_colors,
+                                   etc2_distance_table
+                                   [(((src[3] >> 2) & 0x3) << 1) |
+                                    (src[3] & 0x1)],
+                                   FALSE, /* T mode */
+                                   msb, lsb,
+                                   pixels);
+          return;
+        }
+      else if (sum[1] < 0 || sum[1] > 31)
+        {
+          /* H mode */
+          int r1, g1, b1, r2, g2, b2;
+          int distance_index;
+
+          r1 = (src[0] >> 3) & 0xf;
+          g1 = ((src[0] << 1) & 0xe) | ((src[1] >> 4) & 0x1);
+          b1 = ((src[1] & 0x8) | ((src[1] << 1) & 0x6) | (src[2] >> 7));
+          r2 = (src[2] >> 3) & 0xf;
+          g2 = ((src[2] << 1) & 0xe) | (src[3] >> 7);
+          b2 = (src[3] >> 3) & 0xf;
+
+          distance_index = (src[3] & 0x4) | ((src[3] & 0x1) << 1);
+          if (((r1 << 8) | (g1 << 4) | b1) >= ((r2 << 8) | (g2 << 4) | b2))
+            distance_index++;
+
+          base_colors[0][0] = extend_4 (r1);
+          base_colors[0][1] = extend_4 (g1);
+          base_colors[0][2] = extend_4 (b1);
+          base_colors[1][0] = extend_4 (r2);
+          base_colors[1][1] = extend_4 (g2);
+          base_colors[1][2] = extend_4 (b2);
+
+          decode_etc2_paint_block (base_colors,
+                                   etc2_distance_table[distance_index],
+                                   TRUE, /* H mode */
+                                   msb, lsb,
+                                   pixels);
+          return;
+        }
+      else if (sum[2] < 0 || sum[2] > 31)
+        {
+          decode_etc2_planar_block (src, pixels);
+          return;
+        }
+
+      for (i = 0; i < 3; i++)
+        {
+          base_colors[0][i] = extend_5 (base[i]);
+          base_colors[1][i] = extend_5 (sum[i]);
+        }
+    }
+  else
+    {
+      for (i = 0; i < 3; i++)
+        {
+          base_colors[0][i] = extend_4 (src[i] >> 4);
+          base_colors[1][i] = extend_4 (src[i] & 0xf);
+        }
+    }
+
+  tables[0] = src[3] >> 5;
+  tables[1] = (src[3] >> 2) & 0x7;
+
+  for (y = 0; y < 4; y++)
+    for (x = 0; x < 4; x++)
+      {
+        int subblock = etc_pixel_in_subblock (x, y, flip, 1);
+        int bit = ETC_PIXEL (x, y);
+        int index = (((msb >> bit) & 1) << 1) | ((lsb >> bit) & 1);
+        int modifier = etc_modifier (tables[subblock], index);
+        uint8_t *p = pixels + (y * 4 + x) * 4;
+
+        for (i = 0; i < 3; i++)
+          p[i] = CLAMP (base_colors[subblock][i] + modifier, 0, 255);
+        p[3] = 255;
+      }
+}
+
+/* Picks the best table and modifier indices for one subblock given
+   its base color. Returns the total squared error */
+static int
+encode_etc_subblock (const uint8_t *pixels,
+                     CoglBool flip,
+                     int subblock,
+                     const int *base_color,
+                     int *table_out,
+                     uint32_t *msb,
+                     uint32_t *lsb)
+{
+  int best_error = INT_MAX;
+  int best_table = 0;
+  uint32_t best_msb = 0, best_lsb = 0;
+  int table;
+
+  for (table = 0; table < 8; table++)
+    {
+      uint32_t table_msb = 0, table_lsb = 0;
+      int table_error = 0;
+      int x, y;
+
+      for (y = 0; y < 4; y++)
+        for (x = 0; x < 4; x++)
+          {
+            const uint8_t *p = pixels + (y * 4 + x) * 4;
+            int best_index = 0, best_pixel_error = INT_MAX;
+            int index;
+
+            if (!etc_pixel_in_subblock (x, y, flip, subblock))
+              continue;
+
+            for (index = 0; index < 4; index++)
+              {
+                int modifier = etc_modifier (table, index);
+                int error = 0;
+                int i;
+
+                for (i = 0; i < 3; i++)
+                  {
+                    int value = CLAMP (base_color[i] + modifier, 0, 255);
+                    error += (value - p[i]) * (value - p[i]);
+                  }
+
+                if (error < best_pixel_error)
+                  {
+                    best_pixel_error = error;
+                    best_index = index;
+                  }
+              }
+
+            table_error += best_pixel_error;
+            table_msb |= (best_index >> 1) << ETC_PIXEL (x, y);
+            table_lsb |= (best_index & 1) << ETC_PIXEL (x, y);
+          }
+
+      if (table_error < best_error)
+        {
+          best_error = table_error;
+          best_table = table;
+          best_msb = table_msb;
+          best_lsb = table_lsb;
+        }
+    }
+
+  *table_out = best_table;
+  *msb |= best_msb;
+  *lsb |= best_lsb;
+
+  return best_error;
+}
+
+static int
+encode_etc_block_with_flip (const uint8_t *pixels,
+                            CoglBool flip,
+                            uint8_t *dst)
+{
+  int average[2][3];
+  int quantized[2][3];
+  int base_colors[2][3];
+  CoglBool diff = TRUE;
+  uint32_t msb = 0, lsb = 0;
+  int tables[2];
+  int error = 0;
+  int subblock, i, x, y;
+
+  for (subblock = 0; subblock < 2; subblock++)
+    {
+      int sum[3] = { 0, 0, 0 };
+
+      for (y = 0; y < 4; y++)
+        for (x = 0; x < 4; x++)
+          if (etc_pixel_in_subblock (x, y, flip, subblock))
+            for (i = 0; i < 3; i++)
+              sum[i] += pixels[(y * 4 + x) * 4 + i];
+
+      for (i = 0; i < 3; i++)
+        average[subblock][i] = (sum[i] + 4) / 8;
+    }
+
+  /* Try the differential mode first because it has more precision for
+     the base colors. It can only be used if the second color is close
+     enough to the first */
+  for (i = 0; i < 3; i++)
+    {
+      int delta;
+
+      quantized[0][i] = (average[0][i] * 31 + 127) / 255;
+      quantized[1][i] = (average[1][i] * 31 + 127) / 255;
+      delta = quantized[1][i] - quantized[0][i];
+
+      if (delta < -4 || delta > 3)
+        diff = FALSE;
+    }
+
+  if (diff)
+    {
+      for (i = 0; i < 3; i++)
+        {
+          int delta = quantized[1][i] - quantized[0][i];
+
+          dst[i] = (quantized[0][i] << 3) | (delta & 0x7);
+          base_colors[0][i] = extend_5 (quantized[0][i]);
+          base_colors[1][i] = extend_5 (quantized[1][i]);
+        }
+    }
+  else
+    {
+      for (i = 0; i < 3; i++)
+        {
+          quantized[0][i] = (average[0][i] * 15 + 127) / 255;
+          quantized[1][i] = (average[1][i] * 15 + 127) / 255;
+
+          dst[i] = (quantized[0][i] << 4) | quantized[1][i];
+          base_colors[0][i] = extend_4 (quantized[0][i]);
+          base_colors[1][i] = extend_4 (quantized[1][i]);
+        }
+    }
+
+  for (subblock = 0; subblock < 2; subblock++)
+    error += encode_etc_subblock (pixels,
+                                  flip,
+                                  subblock,
+                                  base_colors[subblock],
+                                  tables + subblock,
+                                  &msb, &lsb);
+
+  dst[3] = ((tables[0] << 5) | (tables[1] << 2) |
+            (diff ? 0x2 : 0) | (flip ? 0x1 : 0));
+  dst[4] = msb >> 8;
+  dst[5] = msb & 0xff;
+  dst[6] = lsb >> 8;
+  dst[7] = lsb & 0xff;
+
+  return error;
+}
+
+static void
+encode_etc2_rgb_block (const uint8_t *pixels,
+                       uint8_t *dst)
+{
+  uint8_t flipped[8];
+  int error, flipped_error;
+
+  error = encode_etc_block_with_flip (pixels, FALSE, dst);
+  flipped_error = encode_etc_block_with_flip (pixels, TRUE, flipped);
+
+  if (flipped_error < error)
+    memcpy (dst, flipped, 8);
+}
+
+static void
+encode_eac_alpha_block (const uint8_t *pixels,
+                        uint8_t *dst)
+{
+  int min_alpha = 255, max_alpha = 0;
+  int best_error = INT_MAX;
+  int best_base = 0, best_multiplier = 1, best_table = 0;
+  uint64_t best_indices = 0;
+  int table, i;
+
+  for (i = 0; i < 16; i++)
+    {
+      min_alpha = MIN (min_alpha, pixels[i * 4 + 3]);
+      max_alpha = MAX (max_alpha, pixels[i * 4 + 3]);
+    }
+
+  for (table = 0; table < 16 && best_error > 0; table++)
+    {
+      const int *modifiers = eac_modifier_table[table];
+      int range = modifiers[7] - modifiers[3];
+      int estimate = (max_alpha - min_alpha + range / 2) / range;
+      int multiplier;
+
+      /* Try the multipliers either side of the estimate as well
+         because of the rounding of the table values */
+      for (multiplier = MAX (estimate - 1, 1);
+           multiplier <= MIN (estimate + 1, 15);
+           multiplier++)
+        {
+          int base = CLAMP (min_alpha - modifiers[3] * multiplier, 0, 255);
+          uint64_t indices = 0;
+          int error = 0;
+
+          for (i = 0; i < 16 && error < best_error; i++)
+            {
+              int x = i % 4, y = i / 4;
+              int alpha = pixels[i * 4 + 3];
+              int best_index = 0, best_pixel_error = INT_MAX;
+              int index;
+
+              for (index = 0; index < 8; index++)
+                {
+                  int value = CLAMP (base + modifiers[index] * multiplier,
+                                     0, 255);
+                  int pixel_error = (value - alpha) * (value - alpha);
+
+                  if (pixel_error < best_pixel_error)
+                    {
+                      best_pixel_error = pixel_error;
+                      best_index = index;
+                    }
+                }
+
+              error += best_pixel_error;
+              indices |= ((uint64_t) best_index <<
+                          ((15 - ETC_PIXEL (x, y)) * 3));
+            }
+
+          if (error < best_error)
+            {
+              best_error = error;
+              best_base = base;
+              best_multiplier = multiplier;
+              best_table = table;
+              best_indices = indices;
+            }
+        }
+    }
+
+  dst[0] = best_base;
+  dst[1] = (best_multiplier << 4) | best_table;
+  for (i = 0; i < 6; i++)
+    dst[i + 2] = (best_indices >> ((5 - i) * 8)) & 0xff;
+}
+
+static void
+decode_eac_alpha_block (const uint8_t *src,
+                        uint8_t *pixels)
+{
+  int base = src[0];
+  int multiplier = src[1] >> 4;
+  const int *modifiers = eac_modifier_table[src[1] & 0xf];
+  uint64_t indices = 0;
+  int i;
+
+  for (i = 0; i < 6; i++)
+    indices = (indices << 8) | src[i + 2];
+
+  for (i = 0; i < 16; i++)
+    {
+      int x = i % 4, y = i / 4;
+      int index = (indices >> ((15 - ETC_PIXEL (x, y)) * 3)) & 0x7;
+
+      pixels[i * 4 + 3] = CLAMP (base + modifiers[index] * multiplier,
+                                 0, 255);
+    }
+}
+
+/* Encodes a block of 4x4 RGBA pixels stored in row-major order */
+static void
+encode_block (CoglCompressedFormat format,
+              const uint8_t *pixels,
+              uint8_t *dst)
+{
+  switch (format)
+    {
+    case COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1:
+      encode_s3tc_color_block (pixels, dst);
+      break;
+    case COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5:
+      encode_dxt5_alpha_block (pixels, dst);
+      encode_s3tc_color_block (pixels, dst + 8);
+      break;
+    case COGL_COMPRESSED_FORMAT_RGB8_ETC2:
+      encode_etc2_rgb_block (pixels, dst);
+      break;
+    case COGL_COMPRESSED_FORMAT_RGBA8_ETC2_EAC:
+      encode_eac_alpha_block (pixels, dst);
+      encode_etc2_rgb_block (pixels, dst + 8);
+      break;
+    case COGL_COMPRESSED_FORMAT_RGBA_BPTC_UNORM:
+      g_assert_not_reached ();
+    }
+}
+
+static void
+decode_block (CoglCompressedFormat format,
+              const uint8_t *src,
+              uint8_t *pixels)
+{
+  switch (format)
+    {
+    case COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1:
+      decode_s3tc_color_block (src, TRUE, pixels);
+      break;
+    case COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5:
+      decode_s3tc_color_block (src + 8, FALSE, pixels);
+      decode_dxt5_alpha_block (src, pixels);
+      break;
+    case COGL_COMPRESSED_FORMAT_RGB8_ETC2:
+      decode_etc2_rgb_block (src, pixels);
+      break;
+    case COGL_COMPRESSED_FORMAT_RGBA8_ETC2_EAC:
+      decode_etc2_rgb_block (src + 8, pixels);
+      decode_eac_alpha_block (src, pixels);
+      break;
+    case COGL_COMPRESSED_FORMAT_RGBA_BPTC_UNORM:
+      g_assert_not_reached ();
+    }
+}
+
+typedef struct
+{
+  CoglCompressedFormat format;
+  int width;
+  int height;
+  int rowstride;
+  uint8_t *pixels;
+  uint8_t *blocks;
+} CoglCompressionJob;
+
+static void
+encode_block_rows_cb (int item,
+                      void *user_data)
+{
+  CoglCompressionJob *job = user_data;
+  int block_size = _cogl_compressed_format_get_block_size (job->format);
+  int blocks_wide = (job->width + 3) / 4;
+  int blocks_high = (job->height + 3) / 4;
+  int first_row = item * BLOCK_ROWS_PER_WORK_ITEM;
+  int last_row = MIN (first_row + BLOCK_ROWS_PER_WORK_ITEM, blocks_high);
+  uint8_t block_pixels[16 * 4];
+  int bx, by, x, y;
+
+  for (by = first_row; by < last_row; by++)
+    for (bx = 0; bx < blocks_wide; bx++)
+      {
+        /* Blocks that hang over the edge of the image repeat the last
+           row and column */
+        for (y = 0; y < 4; y++)
+          for (x = 0; x < 4; x++)
+            {
+              int src_x = MIN (bx * 4 + x, job->width - 1);
+              int src_y = MIN (by * 4 + y, job->height - 1);
+
+              memcpy (block_pixels + (y * 4 + x) * 4,
+                      job->pixels + src_y * job->rowstride + src_x * 4,
+                      4);
+            }
+
+        encode_block (job->format,
+                      block_pixels,
+                      job->blocks + (by * blocks_wide + bx) * block_size);
+      }
+}
+
+static void
+decode_block_rows_cb (int item,
+                      void *user_data)
+{
+  CoglCompressionJob *job = user_data;
+  int block_size = _cogl_compressed_format_get_block_size (job->format);
+  int blocks_wide = (job->width + 3) / 4;
+  int blocks_high = (job->height + 3) / 4;
+  int first_row = item * BLOCK_ROWS_PER_WORK_ITEM;
+  int last_row = MIN (first_row + BLOCK_ROWS_PER_WORK_ITEM, blocks_high);
+  uint8_t block_pixels[16 * 4];
+  int bx, by, x, y;
+
+  for (by = first_row; by < last_row; by++)
+    for (bx = 0; bx < blocks_wide; bx++)
+      {
+        decode_block (job->format,
+                      job->blocks + (by * blocks_wide + bx) * block_size,
+                      block_pixels);
+
+        for (y = 0; y < 4 && by * 4 + y < job->height; y++)
+          for (x = 0; x < 4 && bx * 4 + x < job->width; x++)
+            memcpy (job->pixels + ((by * 4 + y) * job->rowstride +
+                                   (bx * 4 + x) * 4),
+                    block_pixels + (y * 4 + x) * 4,
+                    4);
+      }
+}
+
+static void
+run_compression_job (CoglContext *ctx,
+                     CoglCompressionJob *job,
+                     CoglWorkerFunc func)
+{
+  int blocks_high = (job->height + 3) / 4;
+  int n_items = ((blocks_high + BLOCK_ROWS_PER_WORK_ITEM - 1) /
+                 BLOCK_ROWS_PER_WORK_ITEM);
+
+  if (ctx)
+    _cogl_worker_pool_run (_cogl_context_get_worker_pool (ctx),
+                           n_items,
+                           func,
+                           job);
+  else
+    {
+      int i;
+
+      for (i = 0; i < n_items; i++)
+        func (i, job);
+    }
+}
+
+/* Halves the size of an RGBA image with a box filter. An odd pixel at
+   the end of a row or column is just dropped */
+static void
+downsample_rgba (const uint8_t *src,
+                 int src_width,
+                 int src_height,
+                 int src_rowstride,
+                 uint8_t *dst,
+                 int dst_width,
+                 int dst_height)
+{
+  int x, y, i;
+
+  for (y = 0; y < dst_height; y++)
+    for (x = 0; x < dst_width; x++)
+      {
+        int x0 = MIN (x * 2, src_width - 1);
+        int x1 = MIN (x * 2 + 1, src_width - 1);
+        int y0 = MIN (y * 2, src_height - 1);
+        int y1 = MIN (y * 2 + 1, src_height - 1);
+
+        for (i = 0; i < 4; i++)
+          dst[(y * dst_width + x) * 4 + i] =
+            (src[y0 * src_rowstride + x0 * 4 + i] +
+             src[y0 * src_rowstride + x1 * 4 + i] +
+             src[y1 * src_rowstride + x0 * 4 + i] +
+             src[y1 * src_rowstride + x1 * 4 + i] + 2) / 4;
+      }
+}
+
+static void
+encode_rgba (CoglContext *ctx,
+             CoglCompressedFormat format,
+             int width,
+             int height,
+             int rowstride,
+             const uint8_t *pixels,
+             uint8_t *dst)
+{
+  CoglCompressionJob job;
+
+  job.format = format;
+  job.width = width;
+  job.height = height;
+  job.rowstride = rowstride;
+  job.pixels = (uint8_t *) pixels;
+  job.blocks = dst;
+
+  run_compression_job (ctx, &job, encode_block_rows_cb);
+}
+
+CoglCompressedImage *
+_cogl_compressed_image_new_from_bitmap (CoglBitmap *bitmap,
+                                        CoglCompressedFormat format,
+                                        CoglBool premultiplied,
+                                        CoglBool with_mipmaps,
+                                        CoglError **error)
+{
+  CoglContext *ctx = _cogl_bitmap_get_context (bitmap);
+  int width = cogl_bitmap_get_width (bitmap);
+  int height = cogl_bitmap_get_height (bitmap);
+  CoglCompressedImage *image;
+  CoglBitmap *rgba_bmp;
+  uint8_t *pixels;
+  uint8_t *level_pixels = NULL, *next_level_pixels = NULL;
+  int level;
+
+  _COGL_RETURN_VAL_IF_FAIL (_cogl_compressed_format_can_decode (format),
+                            NULL);
+
+  rgba_bmp = _cogl_bitmap_convert (bitmap,
+                                   premultiplied ?
+                                   COGL_PIXEL_FORMAT_RGBA_8888_PRE :
+                                   COGL_PIXEL_FORMAT_RGBA_8888,
+                                   error);
+  if (rgba_bmp == NULL)
+    return NULL;
+
+  pixels = _cogl_bitmap_map (rgba_bmp, COGL_BUFFER_ACCESS_READ, 0, error);
+  if (pixels == NULL)
+    {
+      cogl_object_unref (rgba_bmp);
+      return NULL;
+    }
+
+  image = _cogl_compressed_image_new (format,
+                                      width, height,
+                                      with_mipmaps ?
+                                      get_n_mipmap_levels (width, height) :
+                                      1);
+  image->premultiplied = premultiplied;
+
+  encode_rgba (ctx,
+               format,
+               width, height,
+               cogl_bitmap_get_rowstride (rgba_bmp),
+               pixels,
+               image->data);
+
+  if (image->n_levels > 1)
+    {
+      int level_width, level_height;
+
+      _cogl_compressed_image_get_level_size (image, 1,
+                                             &level_width, &level_height);
+      level_pixels = g_malloc (level_width * level_height * 4);
+      next_level_pixels = g_malloc (level_width * level_height * 4);
+
+      downsample_rgba (pixels,
+                       width, height,
+                       cogl_bitmap_get_rowstride (rgba_bmp),
+                       level_pixels,
+                       level_width, level_height);
+    }
+
+  _cogl_bitmap_unmap (rgba_bmp);
+  cogl_object_unref (rgba_bmp);
+
+  for (level = 1; level < image->n_levels; level++)
+    {
+      int level_width, level_height;
+      uint8_t *tmp;
+
+      _cogl_compressed_image_get_level_size (image, level,
+                                             &level_width, &level_height);
+
+      encode_rgba (ctx,
+                   format,
+                   level_width, level_height,
+                   level_width * 4,
+                   level_pixels,
+                   image->data + image->level_offsets[level]);
+
+      if (level + 1 < image->n_levels)
+        {
+          int next_width, next_height;
+
+          _cogl_compressed_image_get_level_size (image, level + 1,
+                                                 &next_width, &next_height);
+          downsample_rgba (level_pixels,
+                           level_width, level_height,
+                           level_width * 4,
+                           next_level_pixels,
+                           next_width, next_height);
+
+          tmp = level_pixels;
+          level_pixels = next_level_pixels;
+          next_level_pixels = tmp;
+        }
+    }
+
+  g_free (level_pixels);
+  g_free (next_level_pixels);
+
+  return image;
+}
+
+CoglBitmap *
+_cogl_compressed_image_decode (CoglContext *ctx,
+                               CoglCompressedImage *image,
+                               CoglError **error)
+{
+  CoglCompressionJob job;
+  CoglBitmap *bmp;
+  uint8_t *pixels;
+
+  if (!_cogl_compressed_format_can_decode (image->format))
+    {
+      _cogl_set_error (error,
+                       COGL_TEXTURE_ERROR,
+                       COGL_TEXTURE_ERROR_FORMAT,
+                       "The compressed texture format isn't supported "
+                       "by the driver");
+      return NULL;
+    }
+
+  bmp = _cogl_bitmap_new_with_malloc_buffer (ctx,
+                                             image->width,
+                                             image->height,
+                                             image->premultiplied ?
+                                             COGL_PIXEL_FORMAT_RGBA_8888_PRE :
+                                             COGL_PIXEL_FORMAT_RGBA_8888,
+                                             error);
+  if (bmp == NULL)
+    return NULL;
+
+  pixels = _cogl_bitmap_map (bmp,
+                             COGL_BUFFER_ACCESS_WRITE,
+                             COGL_BUFFER_MAP_HINT_DISCARD,
+                             error);
+  if (pixels == NULL)
+    {
+      cogl_object_unref (bmp);
+      return NULL;
+    }
+
+  job.format = image->format;
+  job.width = image->width;
+  job.height = image->height;
+  job.rowstride = cogl_bitmap_get_rowstride (bmp);
+  job.pixels = pixels;
+  job.blocks = image->data;
+
+  run_compression_job (ctx, &job, decode_block_rows_cb);
+
+  _cogl_bitmap_unmap (bmp);
+
+  return bmp;
+}
+
+/*
+ * Container parsing
+ */
+
+static const uint8_t ktx_identifier[12] =
+  { 0xab, 'K', 'T', 'X', ' ', '1', '1', 0xbb, '\r', '\n', 0x1a, '\n' };
+
+#define KTX_ENDIANNESS 0x04030201
+#define KTX_HEADER_SIZE (12 + 13 * 4)
+
+#define DDS_HEADER_SIZE (4 + 124)
+#define DDS_DX10_HEADER_SIZE 20
+#define DDS_FOURCC(a, b, c, d) \
+  ((uint32_t) (a) | ((uint32_t) (b) << 8) | \
+   ((uint32_t) (c) << 16) | ((uint32_t) (d) << 24))
+
+/* Values of the DXGI_FORMAT enum */
+#define DXGI_FORMAT_BC1_UNORM 71
+#define DXGI_FORMAT_BC3_UNORM 77
+#define DXGI_FORMAT_BC7_UNORM 98
+
+static uint32_t
+read_uint32_le (const uint8_t *p)
+{
+  return (p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24));
+}
+
+static uint32_t
+read_uint32 (const uint8_t *p,
+             CoglBool swap)
+{
+  uint32_t value = read_uint32_le (p);
+
+  return swap ? GUINT32_SWAP_LE_BE (value) : value;
+}
+
+static CoglBool
+get_format_from_gl (GLenum gl_format,
+                    CoglCompressedFormat *format_out)
+{
+  CoglCompressedFormat format;
+
+  for (format = COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1;
+       format <= COGL_COMPRESSED_FORMAT_RGBA_BPTC_UNORM;
+       format++)
+    if (_cogl_compressed_format_to_gl (format) == gl_format)
+      {
+        *format_out = format;
+        return TRUE;
+      }
+
+  return FALSE;
+}
+
+static void
+set_corrupt_error (CoglError **error,
+                   const char *container)
+{
+  _cogl_set_error (error,
+                   COGL_BITMAP_ERROR,
+                   COGL_BITMAP_ERROR_CORRUPT_IMAGE,
+                   "Invalid %s file",
+                   container);
+}
+
+static void
+set_unsupported_error (CoglError **error,
+                       const char *container)
+{
+  _cogl_set_error (error,
+                   COGL_BITMAP_ERROR,
+                   COGL_BITMAP_ERROR_UNKNOWN_TYPE,
+                   "Unsupported %s texture format",
+                   container);
+}
+
+static CoglCompressedImage *
+load_ktx (const uint8_t *data,
+          size_t size,
+          CoglError **error)
+{
+  CoglCompressedImage *image;
+  CoglCompressedFormat format;
+  CoglBool swap;
+  uint32_t gl_type, gl_internal_format;
+  uint32_t width, height, depth, n_array_elements, n_faces, n_levels;
+  uint32_t key_value_size;
+  size_t offset;
+  int level;
+
+  if (size < KTX_HEADER_SIZE)
+    {
+      set_corrupt_error (error, "KTX");
+      return NULL;
+    }
+
+  swap = read_uint32_le (data + 12) != KTX_ENDIANNESS;
+  gl_type = read_uint32 (data + 16, swap);
+  gl_internal_format = read_uint32 (data + 28, swap);
+  width = read_uint32 (data + 36, swap);
+  height = read_uint32 (data + 40, swap);
+  depth = read_uint32 (data + 44, swap);
+  n_array_elements = read_uint32 (data + 48, swap);
+  n_faces = read_uint32 (data + 52, swap);
+  n_levels = MAX (read_uint32 (data + 56, swap), 1);
+  key_value_size = read_uint32 (data + 60, swap);
+
+  if (gl_type != 0 /* compressed */ ||
+      depth > 1 || n_array_elements > 0 || n_faces != 1 ||
+      !get_format_from_gl (gl_internal_format, &format))
+    {
+      set_unsupported_error (error, "KTX");
+      return NULL;
+    }
+
+  if (width == 0 || height == 0 ||
+      width > INT_MAX / 2 || height > INT_MAX / 2 ||
+      n_levels > get_n_mipmap_levels (width, height) ||
+      key_value_size > size - KTX_HEADER_SIZE)
+    {
+      set_corrupt_error (error, "KTX");
+      return NULL;
+    }
+
+  image = _cogl_compressed_image_new (format, width, height, n_levels);
+
+  offset = KTX_HEADER_SIZE + key_value_size;
+
+  for (level = 0; level < n_levels; level++)
+    {
+      uint32_t image_size;
+
+      if (size - offset < 4)
+        goto corrupt;
+
+      image_size = read_uint32 (data + offset, swap);
+      offset += 4;
+
+      if (image_size != image->level_sizes[level] ||
+          size - offset < image_size)
+        goto corrupt;
+
+      memcpy (image->data + image->level_offsets[level],
+              data + offset,
+              image_size);
+
+      /* Each level is padded to a multiple of 4 bytes */
+      offset += (image_size + 3) & ~3;
+      if (offset > size)
+        offset = size;
+    }
+
+  return image;
+
+ corrupt:
+  _cogl_compressed_image_free (image);
+  set_corrupt_error (error, "KTX");
+  return NULL;
+}
+
+static CoglCompressedImage *
+load_dds (const uint8_t *data,
+          size_t size,
+          CoglError **error)
+{
+  CoglCompressedImage *image;
+  CoglCompressedFormat format;
+  uint32_t width, height, n_levels, four_cc;
+  size_t offset = DDS_HEADER_SIZE;
+
+  if (size < DDS_HEADER_SIZE || read_uint32_le (data + 4) != 124)
+    {
+      set_corrupt_error (error, "DDS");
+      return NULL;
+    }
+
+  height = read_uint32_le (data + 4 + 8);
+  width = read_uint32_le (data + 4 + 12);
+  n_levels = MAX (read_uint32_le (data + 4 + 24), 1);
+  four_cc = read_uint32_le (data + 4 + 80);
+
+  if (four_cc == DDS_FOURCC ('D', 'X', 'T', '1'))
+    format = COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1;
+  else if (four_cc == DDS_FOURCC ('D', 'X', 'T', '5'))
+    format = COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5;
+  else if (four_cc == DDS_FOURCC ('D', 'X', '1', '0'))
+    {
+      uint32_t dxgi_format;
+
+      if (size < DDS_HEADER_SIZE + DDS_DX10_HEADER_SIZE)
+        {
+          set_corrupt_error (error, "DDS");
+          return NULL;
+        }
+
+      dxgi_format = read_uint32_le (data + DDS_HEADER_SIZE);
+      offset += DDS_DX10_HEADER_SIZE;
+
+      switch (dxgi_format)
+        {
+        case DXGI_FORMAT_BC1_UNORM:
+          format = COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1;
+          break;
+        case DXGI_FORMAT_BC3_UNORM:
+          format = COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5;
+          break;
+        case DXGI_FORMAT_BC7_UNORM:
+          format = COGL_COMPRESSED_FORMAT_RGBA_BPTC_UNORM;
+          break;
+        default:
+          set_unsupported_error (error, "DDS");
+          return NULL;
+        }
+    }
+  else
+    {
+      set_unsupported_error (error, "DDS");
+      return NULL;
+    }
+
+  if (width == 0 || height == 0 ||
+      width > INT_MAX / 2 || height > INT_MAX / 2 ||
+      n_levels > get_n_mipmap_levels (width, height))
+    {
+      set_corrupt_error (error, "DDS");
+      return NULL;
+    }
+
+  image = _cogl_compressed_image_new (format, width, height, n_levels);
+
+  /* All of the levels are stored contiguously in the same layout
+     that we use */
+  if (size - offset < image->data_size)
+    {
+      _cogl_compressed_image_free (image);
+      set_corrupt_error (error, "DDS");
+      return NULL;
+    }
+
+  memcpy (image->data, data + offset, image->data_size);
+
+  return image;
+}
+
+CoglCompressedImage *
+_cogl_compressed_image_new_from_data (const uint8_t *data,
+                                      size_t size,
+                                      CoglError **error)
+{
+  if (size >= sizeof (ktx_identifier) &&
+      !memcmp (data, ktx_identifier, sizeof (ktx_identifier)))
+    return load_ktx (data, size, error);
+  else if (size >= 4 && !memcmp (data, "DDS ", 4))
+    return load_dds (data, size, error);
+  else
+    return NULL;
+}
+
+CoglCompressedImage *
+_cogl_compressed_image_new_from_file (const char *filename,
+                                      CoglError **error)
+{
+  CoglCompressedImage *image;
+  CoglMappedFile *file;
+
+  /* If the file can't be opened then the regular image loader will
+     report the error */
+  file = _cogl_mapped_file_new (filename, NULL);
+  if (file == NULL)
+    return NULL;
+
+  /* Only the pages containing the header are read if this turns out
+     not to be a compressed image */
+  image = _cogl_compressed_image_new_from_data (file->data,
+                                                file->size,
+                                                error);
+
+  _cogl_mapped_file_free (file);
+
+  return image;
+}
+
+UNIT_TEST (check_compressed_format_roundtrip,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  static const CoglCompressedFormat formats[] =
+    {
+      COGL_COMPRESSED_FORMAT_RGB_S3TC_DXT1,
+      COGL_COMPRESSED_FORMAT_RGBA_S3TC_DXT5,
+      COGL_COMPRESSED_FORMAT_RGB8_ETC2,
+      COGL_COMPRESSED_FORMAT_RGBA8_ETC2_EAC
+    };
+  /* Use a size that isn't a multiple of the block size to test the
+     partial blocks */
+  const int width = 18, height = 13;
+  uint8_t src[18 * 13 * 4];
+  uint8_t dst[18 * 13 * 4];
+  uint8_t blocks[5 * 4 * 16];
+  int i, x, y;
+
+  /* Smooth gradients should survive the compression fairly well */
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        uint8_t *p = src + (y * width + x) * 4;
+
+        p[0] = x * 255 / (width - 1);
+        p[1] = y * 255 / (height - 1);
+        p[2] = 128;
+        p[3] = 255 - (x + y) * 255 / (width + height - 2);
+      }
+
+  for (i = 0; i < G_N_ELEMENTS (formats); i++)
+    {
+      CoglCompressionJob job;
+      int total_error = 0;
+      CoglBool has_alpha = _cogl_compressed_format_has_alpha (formats[i]);
+
+      g_assert_cmpint (get_level_size (formats[i], width, height),
+                       <=,
+                       sizeof (blocks));
+
+      job.format = formats[i];
+      job.width = width;
+      job.height = height;
+      job.rowstride = width * 4;
+      job.pixels = src;
+      job.blocks = blocks;
+      run_compression_job (NULL, &job, encode_block_rows_cb);
+
+      memset (dst, 0, sizeof (dst));
+      job.pixels = dst;
+      run_compression_job (NULL, &job, decode_block_rows_cb);
+
+      for (y = 0; y < height; y++)
+        for (x = 0; x < width; x++)
+          {
+            const uint8_t *a = src + (y * width + x) * 4;
+            const uint8_t *b = dst + (y * width + x) * 4;
+
+            total_error += color_distance (a, b);
+
+            if (has_alpha)
+              g_assert_cmpint (ABS (a[3] - b[3]), <=, 16);
+            else
+              g_assert_cmpint (b[3], ==, 255);
+          }
+
+      /* The mean squared error per pixel should be small */
+      g_assert_cmpint (total_error / (width * height), <, 512);
+    }
+}
+
+UNIT_TEST (check_ktx_parsing,
+           0 /* no requirements */,
+           0 /* no failure cases */)
+{
+  uint8_t data[KTX_HEADER_SIZE + 4 + 8 + 4 + 8];
+  CoglCompressedImage *image;
+  CoglError *error = NULL;
+  static const uint32_t header[] =
+    {
+      KTX_ENDIANNESS,
+      0, /* glType */
+      1, /* glTypeSize */
+      0, /* glFormat */
+      GL_COMPRESSED_RGB8_ETC2,
+      0x1907, /* glBaseInternalFormat */
+      2, /* pixelWidth */
+      1, /* pixelHeight */
+      0, /* pixelDepth */
+      0, /* numberOfArrayElements */
+      1, /* numberOfFaces */
+      2, /* numberOfMipmapLevels */
+      0 /* bytesOfKeyValueData */
+    };
+  int i;
+
+  memcpy (data, ktx_identifier, sizeof (ktx_identifier));
+  for (i = 0; i < G_N_ELEMENTS (header); i++)
+    {
+      uint8_t *p = data + sizeof (ktx_identifier) + i * 4;
+
+      p[0] = header[i] & 0xff;
+      p[1] = (header[i] >> 8) & 0xff;
+      p[2] = (header[i] >> 16) & 0xff;
+      p[3] = header[i] >> 24;
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      uint8_t *p = data + KTX_HEADER_SIZE + i * 12;
+
+      p[0] = 8;
+      p[1] = p[2] = p[3] = 0;
+      memset (p + 4, i + 1, 8);
+    }
+
+  image = _cogl_compressed_image_new_from_data (data, sizeof (data), &error);
+  g_assert (error == NULL);
+  g_assert (image != NULL);
+  g_assert_cmpint (image->format, ==, COGL_COMPRESSED_FORMAT_RGB8_ETC2);
+  g_assert_cmpint (image->width, ==, 2);
+  g_assert_cmpint (image->height, ==, 1);
+  g_assert_cmpint (image->n_levels, ==, 2);
+  g_assert_cmpint (image->data_size, ==, 16);
+  g_assert_cmpint (image->data[0], ==, 1);
+  g_assert_cmpint (image->data[8], ==, 2);
+  _cogl_compressed_image_free (image);
+
+  /* A truncated file should be reported as corrupt */
+  image = _cogl_compressed_image_new_from_data (data,
+                                                sizeof (data) - 1,
+                                                &error);
+  g_assert (image == NULL);
+  g_assert (error != NULL);
+  g_assert_cmpint (error->code, ==, COGL_BITMAP_ERROR_CORRUPT_IMAGE);
+  cogl_error_free (error);
+  error = NULL;
+
+  /* Other data should just be ignored */
+  image = _cogl_compressed_image_new_from_data ((const uint8_t *) "\x89PNG",
+                                                4,
+                                                &error);
+  g_assert (image == NULL);
+  g_assert (error == NULL);
+}
@@ -37,6 +37,8 @@
 #include "cogl-spans.h"
 #include "cogl-meta-texture.h"
 #include "cogl-framebuffer.h"
+#include "cogl-list.h"
+#include "cogl-texture-compression-private.h"
 
 #ifdef COGL_HAS_EGL_SUPPORT
 #include "cogl-egl-defines.h"
@@ -146,13 +148,24 @@ struct _CoglTextureVtable
   /* Only needs to be implemented if is_primitive == TRUE */
   void (* set_auto_mipmap) (CoglTexture *texture,
                             CoglBool value);
+
+  /* Optional. Returns the number of bytes of GPU memory used by a
+     primitive texture. If this isn't implemented the size is
+     estimated from the internal format and the number of levels */
+  size_t (* get_gpu_bytes) (CoglTexture *texture);
+
+  /* Optional. Frees the storage of an allocated texture so that it
+     can later be recreated from its loader by allocating it again.
+     Only textures that implement this can be purgeable */
+  void (* discard_storage) (CoglTexture *texture);
 };
 
 typedef enum _CoglTextureSoureType {
   COGL_TEXTURE_SOURCE_TYPE_SIZED = 1,
   COGL_TEXTURE_SOURCE_TYPE_BITMAP,
   COGL_TEXTURE_SOURCE_TYPE_EGL_IMAGE,
-  COGL_TEXTURE_SOURCE_TYPE_GL_FOREIGN
+  COGL_TEXTURE_SOURCE_TYPE_GL_FOREIGN,
+  COGL_TEXTURE_SOURCE_TYPE_COMPRESSED
 } CoglTextureSourceType;
 
 typedef struct _CoglTextureLoader
@@ -184,6 +197,9 @@ typedef struct _CoglTextureLoader
       unsigned int gl_handle;
       CoglPixelFormat format;
     } gl_foreign;
+    struct {
+      CoglCompressedImage *image;
+    } compressed;
   } src;
 } CoglTextureLoader;
 
@@ -204,6 +220,17 @@ struct _CoglTexture
   CoglTextureComponents components;
   unsigned int premultiplied:1;
 
+  /* Whether the user would like the data to be stored in a block
+   * compressed format if the driver supports one */
+  unsigned int compressed:1;
+
+  /* Residency state. See cogl-texture-residency.c */
+  unsigned int purgeable:1;
+  unsigned int in_purgeable_list:1;
+  unsigned int last_used_frame;
+  size_t gpu_bytes;
+  CoglList purgeable_link;
+
   const CoglTextureVtable *vtable;
 };
 
@@ -376,6 +403,9 @@ _cogl_texture_get_format (CoglTexture *texture);
 CoglTextureLoader *
 _cogl_texture_create_loader (void);
 
+void
+_cogl_texture_free_loader (CoglTexture *texture);
+
 void
 _cogl_texture_copy_internal_format (CoglTexture *src,
                                     CoglTexture *dest);
@@ -0,0 +1,91 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifndef __COGL_TEXTURE_RESIDENCY_PRIVATE_H
+#define __COGL_TEXTURE_RESIDENCY_PRIVATE_H
+
+#include "cogl-context.h"
+#include "cogl-texture.h"
+
+/*
+ * The residency manager keeps track of how much GPU memory is used by
+ * the textures of each context. If the application sets a budget then
+ * textures marked as purgeable are evicted in least recently used
+ * order to stay under it. An evicted texture keeps its loader so it
+ * can be transparently reallocated the next time it is painted.
+ */
+
+void
+_cogl_texture_residency_init (CoglContext *context);
+
+/* Called by _cogl_texture_set_allocated. Returns TRUE if the texture
+ * is purgeable and so the loader must be kept in order to be able to
+ * recreate it */
+CoglBool
+_cogl_texture_residency_allocated (CoglTexture *texture);
+
+/* Estimates the memory used by a primitive texture from its internal
+ * format and the number of mipmap levels */
+size_t
+_cogl_texture_residency_estimate_bytes (CoglTexture *texture);
+
+/* Recalculates the memory used by a texture, for example after more
+ * mipmap levels have been allocated */
+void
+_cogl_texture_residency_update (CoglTexture *texture);
+
+void
+_cogl_texture_residency_free (CoglTexture *texture);
+
+/* Marks the texture as being used in the current frame and moves it
+ * to the end of the LRU list. Textures used in the current frame are
+ * never evicted */
+void
+_cogl_texture_residency_touch (CoglTexture *texture);
+
+/* Stops a texture from being evicted. This is used when the contents
+ * of the texture are modified so they can no longer be recreated
+ * from the loader */
+void
+_cogl_texture_residency_make_permanent (CoglTexture *texture);
+
+/* Evicts purgeable textures until the memory used is under the
+ * budget. This flushes all of the journals so it must not be called
+ * while a journal is being flushed, for example from a texture's
+ * pre_paint */
+void
+_cogl_texture_residency_enforce_budget (CoglContext *context);
+
+/* Called when an onscreen framebuffer is swapped or when the
+ * application calls cogl_context_end_frame() */
+void
+_cogl_texture_residency_end_frame (CoglContext *context);
+
+#endif /* __COGL_TEXTURE_RESIDENCY_PRIVATE_H */
@@ -0,0 +1,320 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#include "cogl-util.h"
+#include "cogl-private.h"
+#include "cogl-context-private.h"
+#include "cogl-config-private.h"
+#include "cogl-texture-private.h"
+#include "cogl-texture-residency-private.h"
+#include "cogl-pipeline-private.h"
+
+void
+_cogl_texture_residency_init (CoglContext *context)
+{
+  const char *budget;
+
+  _cogl_list_init (&context->purgeable_textures);
+
+  budget = g_getenv ("COGL_TEXTURE_MEMORY_BUDGET");
+  if (budget == NULL)
+    budget = _cogl_config_texture_memory_budget;
+
+  /* The budget is given in megabytes */
+  if (budget)
+    context->texture_memory_budget =
+      (size_t) strtoul (budget, NULL, 10) * 1024 * 1024;
+}
+
+size_t
+_cogl_texture_residency_estimate_bytes (CoglTexture *texture)
+{
+  CoglPixelFormat format = texture->vtable->get_format (texture);
+  int bpp = _cogl_pixel_format_get_bytes_per_pixel (format);
+  size_t bytes = 0;
+  int level;
+
+  for (level = 0; level <= texture->max_level; level++)
+    {
+      int width, height, depth;
+
+      _cogl_texture_get_level_size (texture, level, &width, &height, &depth);
+
+      bytes += (size_t) width * height * MAX (depth, 1) * bpp;
+    }
+
+  return bytes;
+}
+
+static size_t
+calculate_gpu_bytes (CoglTexture *texture)
+{
+  /* Meta textures don't own any GPU storage themselves. Their
+   * primitive textures are accounted for separately. Foreign textures
+   * belong to someone else */
+  if (!texture->vtable->is_primitive || _cogl_texture_is_foreign (texture))
+    return 0;
+
+  if (texture->vtable->get_gpu_bytes)
+    return texture->vtable->get_gpu_bytes (texture);
+  else
+    return _cogl_texture_residency_estimate_bytes (texture);
+}
+
+static void
+set_gpu_bytes (CoglTexture *texture,
+               size_t bytes)
+{
+  CoglContext *ctx = texture->context;
+  CoglTextureType type;
+
+  if (bytes == texture->gpu_bytes)
+    return;
+
+  type = _cogl_texture_get_type (texture);
+
+  ctx->texture_memory[type] -= texture->gpu_bytes;
+  ctx->texture_memory[type] += bytes;
+  texture->gpu_bytes = bytes;
+}
+
+static size_t
+get_total_memory (CoglContext *ctx)
+{
+  size_t total = 0;
+  int i;
+
+  for (i = 0; i < G_N_ELEMENTS (ctx->texture_memory); i++)
+    total += ctx->texture_memory[i];
+
+  return total;
+}
+
+CoglBool
+_cogl_texture_residency_allocated (CoglTexture *texture)
+{
+  CoglContext *ctx = texture->context;
+  CoglTextureLoader *loader = texture->loader;
+
+  set_gpu_bytes (texture, calculate_gpu_bytes (texture));
+
+  if (!texture->purgeable ||
+      texture->vtable->discard_storage == NULL ||
+      loader == NULL)
+    return FALSE;
+
+  /* We can only recreate the texture if the source data is still
+   * available */
+  if (loader->src_type != COGL_TEXTURE_SOURCE_TYPE_BITMAP &&
+      loader->src_type != COGL_TEXTURE_SOURCE_TYPE_COMPRESSED)
+    return FALSE;
+
+  if (!texture->in_purgeable_list)
+    {
+      _cogl_list_insert (ctx->purgeable_textures.prev,
+                         &texture->purgeable_link);
+      texture->in_purgeable_list = TRUE;
+    }
+
+  return TRUE;
+}
+
+void
+_cogl_texture_residency_update (CoglTexture *texture)
+{
+  if (texture->allocated)
+    set_gpu_bytes (texture, calculate_gpu_bytes (texture));
+}
+
+static void
+remove_from_purgeable_list (CoglTexture *texture)
+{
+  if (texture->in_purgeable_list)
+    {
+      _cogl_list_remove (&texture->purgeable_link);
+      texture->in_purgeable_list = FALSE;
+    }
+}
+
+void
+_cogl_texture_residency_free (CoglTexture *texture)
+{
+  set_gpu_bytes (texture, 0);
+  remove_from_purgeable_list (texture);
+}
+
+void
+_cogl_texture_residency_touch (CoglTexture *texture)
+{
+  CoglContext *ctx = texture->context;
+
+  texture->last_used_frame = ctx->texture_residency_frame;
+
+  /* Move the texture to the end of the list so that the list stays
+   * sorted from the least to the most recently used */
+  if (texture->in_purgeable_list)
+    {
+      _cogl_list_remove (&texture->purgeable_link);
+      _cogl_list_insert (ctx->purgeable_textures.prev,
+                         &texture->purgeable_link);
+    }
+}
+
+void
+_cogl_texture_residency_make_permanent (CoglTexture *texture)
+{
+  if (texture->in_purgeable_list)
+    {
+      remove_from_purgeable_list (texture);
+      _cogl_texture_free_loader (texture);
+    }
+
+  texture->purgeable = FALSE;
+}
+
+static void
+evict_texture (CoglTexture *texture)
+{
+  COGL_NOTE (TEXTURE_RESIDENCY,
+             "Evicting %ix%i texture %p using %lu bytes",
+             texture->width, texture->height, texture,
+             (unsigned long) texture->gpu_bytes);
+
+  remove_from_purgeable_list (texture);
+
+  texture->vtable->discard_storage (texture);
+
+  set_gpu_bytes (texture, 0);
+  texture->allocated = FALSE;
+  texture->max_level = 0;
+
+  /* The texture will be recreated with a different GL object so any
+   * texture units that have it bound need to be flushed again */
+  _cogl_pipeline_texture_storage_change_notify (texture);
+}
+
+void
+_cogl_texture_residency_enforce_budget (CoglContext *ctx)
+{
+  CoglTexture *texture, *tmp;
+  size_t total;
+
+  if (ctx->texture_memory_budget == 0 ||
+      ctx->texture_residency_evicting ||
+      _cogl_list_empty (&ctx->purgeable_textures))
+    return;
+
+  total = get_total_memory (ctx);
+  if (total <= ctx->texture_memory_budget)
+    return;
+
+  ctx->texture_residency_evicting = TRUE;
+
+  /* Make sure none of the textures are still referenced by an
+   * unflushed journal before we delete their storage */
+  _cogl_flush (ctx);
+
+  _cogl_list_for_each_safe (texture, tmp,
+                            &ctx->purgeable_textures,
+                            purgeable_link)
+    {
+      /* The list is sorted by age so once we reach a texture that is
+       * used in the current frame there is nothing else to evict */
+      if (texture->last_used_frame == ctx->texture_residency_frame)
+        break;
+
+      evict_texture (texture);
+
+      total = get_total_memory (ctx);
+      if (total <= ctx->texture_memory_budget)
+        break;
+    }
+
+  ctx->texture_residency_evicting = FALSE;
+}
+
+void
+_cogl_texture_residency_end_frame (CoglContext *ctx)
+{
+  _cogl_texture_residency_enforce_budget (ctx);
+
+  ctx->texture_residency_frame++;
+}
+
+void
+cogl_texture_set_purgeable (CoglTexture *texture,
+                            CoglBool purgeable)
+{
+  _COGL_RETURN_IF_FAIL (!texture->allocated);
+
+  texture->purgeable = !!purgeable;
+}
+
+CoglBool
+cogl_texture_get_purgeable (CoglTexture *texture)
+{
+  return texture->purgeable;
+}
+
+void
+cogl_context_set_texture_memory_budget (CoglContext *context,
+                                        size_t budget)
+{
+  context->texture_memory_budget = budget;
+
+  _cogl_texture_residency_enforce_budget (context);
+}
+
+size_t
+cogl_context_get_texture_memory_budget (CoglContext *context)
+{
+  return context->texture_memory_budget;
+}
+
+size_t
+cogl_context_get_texture_memory_usage (CoglContext *context)
+{
+  return get_total_memory (context);
+}
+
+size_t
+cogl_context_get_texture_memory_usage_for_type (CoglContext *context,
+                                                CoglTextureType type)
+{
+  _COGL_RETURN_VAL_IF_FAIL (type < G_N_ELEMENTS (context->texture_memory), 0);
+
+  return context->texture_memory[type];
+}
@@ -0,0 +1,89 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifndef __COGL_TEXTURE_TILED_PRIVATE_H
+#define __COGL_TEXTURE_TILED_PRIVATE_H
+
+#include "cogl-object-private.h"
+#include "cogl-texture-private.h"
+#include "cogl-texture-tiled.h"
+
+struct _CoglTextureTiled
+{
+  CoglTexture _parent;
+
+  /* The internal format of the texture represented as a
+     CoglPixelFormat */
+  CoglPixelFormat internal_format;
+
+  /* The maximum size of a tile requested by the application or 0 */
+  int max_tile_size;
+
+  /* Each tile covers inner_width×inner_height pixels of the image
+     and has a one texel border on each side so the layers of the
+     array texture are tile_width×tile_height */
+  int inner_width;
+  int inner_height;
+  int tile_width;
+  int tile_height;
+  int n_tiles_x;
+  int n_tiles_y;
+
+  CoglBool auto_mipmap;
+  CoglBool mipmaps_dirty;
+
+  /* The internal format of the GL texture represented as a GL enum */
+  GLenum gl_format;
+  /* The texture object number */
+  GLuint gl_texture;
+  GLenum gl_legacy_texobj_min_filter;
+  GLenum gl_legacy_texobj_mag_filter;
+  GLint gl_legacy_texobj_wrap_mode_s;
+  GLint gl_legacy_texobj_wrap_mode_t;
+};
+
+/*
+ * _cogl_texture_tiled_get_layout:
+ * @texture: A #CoglTextureTiled or a sub texture of one
+ * @tiles: Return location for the number of tiles covered by the
+ *   image as (width, height) in tile units followed by the number of
+ *   tiles in each direction.
+ * @tile_scale: Return location for the scale from a position within
+ *   a tile to a layer texture coordinate followed by the offset of
+ *   the border.
+ *
+ * Gets the values that the GLSL fragend needs to look up a texel in
+ * a tiled texture. Returns %FALSE if @texture isn't tiled.
+ */
+CoglBool
+_cogl_texture_tiled_get_layout (CoglTexture *texture,
+                                float tiles[4],
+                                float tile_scale[4]);
+
+#endif /* __COGL_TEXTURE_TILED_PRIVATE_H */
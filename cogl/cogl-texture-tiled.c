@@ -0,0 +1,917 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-private.h"
+#include "cogl-util.h"
+#include "cogl-texture-private.h"
+#include "cogl-texture-tiled-private.h"
+#include "cogl-texture-tiled.h"
+#include "cogl-sub-texture-private.h"
+#include "cogl-sub-texture.h"
+#include "cogl-texture-gl-private.h"
+#include "cogl-texture-driver.h"
+#include "cogl-context-private.h"
+#include "cogl-object-private.h"
+#include "cogl-pipeline-opengl-private.h"
+#include "cogl-error-private.h"
+#include "cogl-util-gl-private.h"
+
+#include <string.h>
+
+/* These might not be defined on GLES */
+#ifndef GL_TEXTURE_2D_ARRAY
+#define GL_TEXTURE_2D_ARRAY                     0x8C1A
+#endif
+#ifndef GL_MAX_ARRAY_TEXTURE_LAYERS
+#define GL_MAX_ARRAY_TEXTURE_LAYERS             0x88FF
+#endif
+
+static void _cogl_texture_tiled_free (CoglTextureTiled *tex_tiled);
+
+COGL_TEXTURE_DEFINE (TextureTiled, texture_tiled);
+
+static const CoglTextureVtable cogl_texture_tiled_vtable;
+
+static void
+_cogl_texture_tiled_gl_flush_legacy_texobj_wrap_modes (CoglTexture *tex,
+                                                       GLenum wrap_mode_s,
+                                                       GLenum wrap_mode_t,
+                                                       GLenum wrap_mode_p)
+{
+  CoglTextureTiled *tex_tiled = COGL_TEXTURE_TILED (tex);
+  CoglContext *ctx = tex->context;
+
+  /* The texture coordinates are always clamped to a single tile in
+     the shader so the wrap mode only affects texels in the border
+     which are never sampled. It is still set so that the GL state
+     matches what the application asked for */
+  if (tex_tiled->gl_legacy_texobj_wrap_mode_s != wrap_mode_s ||
+      tex_tiled->gl_legacy_texobj_wrap_mode_t != wrap_mode_t)
+    {
+      _cogl_bind_gl_texture_transient (GL_TEXTURE_2D_ARRAY,
+                                       tex_tiled->gl_texture,
+                                       FALSE);
+      GE( ctx, glTexParameteri (GL_TEXTURE_2D_ARRAY,
+                                GL_TEXTURE_WRAP_S,
+                                wrap_mode_s) );
+      GE( ctx, glTexParameteri (GL_TEXTURE_2D_ARRAY,
+                                GL_TEXTURE_WRAP_T,
+                                wrap_mode_t) );
+
+      tex_tiled->gl_legacy_texobj_wrap_mode_s = wrap_mode_s;
+      tex_tiled->gl_legacy_texobj_wrap_mode_t = wrap_mode_t;
+    }
+}
+
+static void
+_cogl_texture_tiled_free (CoglTextureTiled *tex_tiled)
+{
+  if (tex_tiled->gl_texture)
+    _cogl_delete_gl_texture (tex_tiled->gl_texture);
+
+  /* Chain up */
+  _cogl_texture_free (COGL_TEXTURE (tex_tiled));
+}
+
+static void
+_cogl_texture_tiled_set_auto_mipmap (CoglTexture *tex,
+                                     CoglBool value)
+{
+  CoglTextureTiled *tex_tiled = COGL_TEXTURE_TILED (tex);
+
+  tex_tiled->auto_mipmap = value;
+}
+
+static CoglTextureTiled *
+_cogl_texture_tiled_create_base (CoglContext *ctx,
+                                 int width,
+                                 int height,
+                                 CoglPixelFormat internal_format,
+                                 CoglTextureLoader *loader)
+{
+  CoglTextureTiled *tex_tiled = g_new (CoglTextureTiled, 1);
+  CoglTexture *tex = COGL_TEXTURE (tex_tiled);
+
+  _cogl_texture_init (tex, ctx, width, height,
+                      internal_format, loader, &cogl_texture_tiled_vtable);
+
+  tex_tiled->gl_texture = 0;
+
+  tex_tiled->max_tile_size = 0;
+  tex_tiled->inner_width = 0;
+  tex_tiled->inner_height = 0;
+  tex_tiled->tile_width = 0;
+  tex_tiled->tile_height = 0;
+  tex_tiled->n_tiles_x = 0;
+  tex_tiled->n_tiles_y = 0;
+
+  tex_tiled->mipmaps_dirty = TRUE;
+  tex_tiled->auto_mipmap = TRUE;
+
+  /* We default to GL_LINEAR for both filters */
+  tex_tiled->gl_legacy_texobj_min_filter = GL_LINEAR;
+  tex_tiled->gl_legacy_texobj_mag_filter = GL_LINEAR;
+
+  /* Wrap mode not yet set */
+  tex_tiled->gl_legacy_texobj_wrap_mode_s = GL_FALSE;
+  tex_tiled->gl_legacy_texobj_wrap_mode_t = GL_FALSE;
+
+  return _cogl_texture_tiled_object_new (tex_tiled);
+}
+
+CoglTextureTiled *
+cogl_texture_tiled_new_with_size (CoglContext *ctx,
+                                  int width,
+                                  int height)
+{
+  CoglTextureLoader *loader = _cogl_texture_create_loader ();
+  loader->src_type = COGL_TEXTURE_SOURCE_TYPE_SIZED;
+  loader->src.sized.width = width;
+  loader->src.sized.height = height;
+
+  return _cogl_texture_tiled_create_base (ctx, width, height,
+                                          COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                          loader);
+}
+
+CoglTextureTiled *
+cogl_texture_tiled_new_from_bitmap (CoglBitmap *bmp)
+{
+  CoglTextureLoader *loader;
+
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_bitmap (bmp), NULL);
+
+  loader = _cogl_texture_create_loader ();
+  loader->src_type = COGL_TEXTURE_SOURCE_TYPE_BITMAP;
+  loader->src.bitmap.bitmap = cogl_object_ref (bmp);
+  loader->src.bitmap.can_convert_in_place = FALSE;
+
+  return _cogl_texture_tiled_create_base (_cogl_bitmap_get_context (bmp),
+                                          cogl_bitmap_get_width (bmp),
+                                          cogl_bitmap_get_height (bmp),
+                                          cogl_bitmap_get_format (bmp),
+                                          loader);
+}
+
+void
+cogl_texture_tiled_set_max_tile_size (CoglTextureTiled *tex_tiled,
+                                      int max_tile_size)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_texture_tiled (tex_tiled));
+  _COGL_RETURN_IF_FAIL (!COGL_TEXTURE (tex_tiled)->allocated);
+  _COGL_RETURN_IF_FAIL (max_tile_size == 0 || max_tile_size >= 3);
+
+  tex_tiled->max_tile_size = max_tile_size;
+}
+
+int
+cogl_texture_tiled_get_n_tiles (CoglTextureTiled *tex_tiled)
+{
+  _COGL_RETURN_VAL_IF_FAIL (cogl_is_texture_tiled (tex_tiled), 0);
+
+  if (!cogl_texture_allocate (COGL_TEXTURE (tex_tiled), NULL))
+    return 0;
+
+  return tex_tiled->n_tiles_x * tex_tiled->n_tiles_y;
+}
+
+/* Picks the smallest number of tiles that fit within the maximum
+ * size and then spreads the image evenly across them so that the
+ * last tile isn't mostly empty */
+static void
+calculate_tiles (int size,
+                 int max_tile_size,
+                 int *n_tiles,
+                 int *inner_size)
+{
+  int max_inner_size = max_tile_size - 2;
+
+  *n_tiles = (size + max_inner_size - 1) / max_inner_size;
+  *inner_size = (size + *n_tiles - 1) / *n_tiles;
+}
+
+static CoglBool
+_cogl_texture_tiled_can_create (CoglTextureTiled *tex_tiled,
+                                int width,
+                                int height,
+                                CoglPixelFormat internal_format,
+                                CoglError **error)
+{
+  CoglContext *ctx = COGL_TEXTURE (tex_tiled)->context;
+  GLenum gl_intformat;
+  GLenum gl_type;
+  GLint max_texture_size;
+  GLint max_layers;
+  int max_tile_size;
+  int n_tiles_x, n_tiles_y;
+  int inner_width, inner_height;
+
+  if (!cogl_has_feature (ctx, COGL_FEATURE_ID_TEXTURE_TILED))
+    {
+      _cogl_set_error (error,
+                       COGL_SYSTEM_ERROR,
+                       COGL_SYSTEM_ERROR_UNSUPPORTED,
+                       "Tiled textures are not supported by the GPU");
+      return FALSE;
+    }
+
+  GE( ctx, glGetIntegerv (GL_MAX_TEXTURE_SIZE, &max_texture_size) );
+  GE( ctx, glGetIntegerv (GL_MAX_ARRAY_TEXTURE_LAYERS, &max_layers) );
+
+  max_tile_size = max_texture_size;
+  if (tex_tiled->max_tile_size > 0)
+    max_tile_size = MIN (max_tile_size, tex_tiled->max_tile_size);
+
+  calculate_tiles (width, max_tile_size, &n_tiles_x, &inner_width);
+  calculate_tiles (height, max_tile_size, &n_tiles_y, &inner_height);
+
+  if (n_tiles_x * n_tiles_y > max_layers)
+    {
+      _cogl_set_error (error,
+                       COGL_SYSTEM_ERROR,
+                       COGL_SYSTEM_ERROR_UNSUPPORTED,
+                       "The texture would need %i tiles but the GPU only "
+                       "supports %i layers in an array texture",
+                       n_tiles_x * n_tiles_y,
+                       max_layers);
+      return FALSE;
+    }
+
+  ctx->driver_vtable->pixel_format_to_gl (ctx,
+                                          internal_format,
+                                          &gl_intformat,
+                                          NULL,
+                                          &gl_type);
+
+  /* Check that the driver can create a texture with that size */
+  if (!ctx->texture_driver->size_supported_3d (ctx,
+                                               GL_TEXTURE_2D_ARRAY,
+                                               gl_intformat,
+                                               gl_type,
+                                               inner_width + 2,
+                                               inner_height + 2,
+                                               n_tiles_x * n_tiles_y))
+    {
+      _cogl_set_error (error,
+                       COGL_SYSTEM_ERROR,
+                       COGL_SYSTEM_ERROR_UNSUPPORTED,
+                       "The requested dimensions are not supported by the GPU");
+      return FALSE;
+    }
+
+  tex_tiled->n_tiles_x = n_tiles_x;
+  tex_tiled->n_tiles_y = n_tiles_y;
+  tex_tiled->inner_width = inner_width;
+  tex_tiled->inner_height = inner_height;
+  tex_tiled->tile_width = inner_width + 2;
+  tex_tiled->tile_height = inner_height + 2;
+
+  return TRUE;
+}
+
+static CoglBool
+allocate_storage (CoglTextureTiled *tex_tiled,
+                  CoglPixelFormat internal_format,
+                  CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_tiled);
+  CoglContext *ctx = tex->context;
+  GLenum gl_intformat;
+  GLenum gl_format;
+  GLenum gl_type;
+  GLenum gl_error;
+  GLuint gl_texture;
+
+  ctx->driver_vtable->pixel_format_to_gl (ctx,
+                                          internal_format,
+                                          &gl_intformat,
+                                          &gl_format,
+                                          &gl_type);
+
+  gl_texture =
+    ctx->texture_driver->gen (ctx, GL_TEXTURE_2D_ARRAY, internal_format);
+  _cogl_bind_gl_texture_transient (GL_TEXTURE_2D_ARRAY,
+                                   gl_texture,
+                                   FALSE);
+  /* Clear any GL errors */
+  while ((gl_error = ctx->glGetError ()) != GL_NO_ERROR)
+    ;
+
+  ctx->glTexImage3D (GL_TEXTURE_2D_ARRAY, 0, gl_intformat,
+                     tex_tiled->tile_width,
+                     tex_tiled->tile_height,
+                     tex_tiled->n_tiles_x * tex_tiled->n_tiles_y,
+                     0, gl_format, gl_type, NULL);
+
+  if (_cogl_gl_util_catch_out_of_memory (ctx, error))
+    {
+      GE( ctx, glDeleteTextures (1, &gl_texture) );
+      return FALSE;
+    }
+
+  tex_tiled->gl_texture = gl_texture;
+  tex_tiled->gl_format = gl_intformat;
+  tex_tiled->internal_format = internal_format;
+
+  return TRUE;
+}
+
+/* Works out which texels of one axis of a tile need to be updated
+ * when the given span of the image changes. Texel n of the tile
+ * corresponds to pixel (tile_start - 1 + n) of the image clamped to
+ * the image size so the texels in the border replicate the
+ * neighbouring tile or the edge of the image */
+static CoglBool
+get_tile_span (int tile_start,
+               int tile_size,
+               int image_size,
+               int span_start,
+               int span_size,
+               int *first_texel,
+               int *end_texel)
+{
+  int first, end;
+
+  if (span_start == 0)
+    first = 0;
+  else
+    first = MAX (0, span_start - tile_start + 1);
+
+  if (span_start + span_size >= image_size)
+    end = tile_size;
+  else
+    end = MIN (tile_size, span_start + span_size - tile_start + 1);
+
+  *first_texel = first;
+  *end_texel = end;
+
+  return first < end;
+}
+
+/* Copies the pixels for one row of a tile into @dst. Pixels outside
+ * of the image are replicated from the nearest edge */
+static void
+copy_tile_row (uint8_t *dst,
+               const uint8_t *src_row,
+               int image_x,
+               int width,
+               int image_width,
+               int bpp)
+{
+  while (width > 0 && image_x < 0)
+    {
+      memcpy (dst, src_row, bpp);
+      dst += bpp;
+      image_x++;
+      width--;
+    }
+
+  if (width > 0 && image_x < image_width)
+    {
+      int run = MIN (width, image_width - image_x);
+
+      memcpy (dst, src_row + image_x * bpp, run * bpp);
+      dst += run * bpp;
+      image_x += run;
+      width -= run;
+    }
+
+  while (width > 0)
+    {
+      memcpy (dst, src_row + (image_width - 1) * bpp, bpp);
+      dst += bpp;
+      width--;
+    }
+}
+
+/* Uploads a region of @upload_bmp to every tile that contains a copy
+ * of it, including the borders of the neighbouring tiles. The bitmap
+ * must already be in a format that can be uploaded directly */
+static CoglBool
+upload_region (CoglTextureTiled *tex_tiled,
+               CoglBitmap *upload_bmp,
+               int src_x,
+               int src_y,
+               int dst_x,
+               int dst_y,
+               int width,
+               int height,
+               CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_tiled);
+  CoglContext *ctx = tex->context;
+  CoglPixelFormat upload_format = cogl_bitmap_get_format (upload_bmp);
+  int bpp = _cogl_pixel_format_get_bytes_per_pixel (upload_format);
+  int src_rowstride = cogl_bitmap_get_rowstride (upload_bmp);
+  int image_width = tex->width;
+  int image_height = tex->height;
+  const uint8_t *src;
+  uint8_t *tile_data;
+  GLenum gl_format;
+  GLenum gl_type;
+  GLenum gl_error;
+  CoglBool status = TRUE;
+  int tx, ty;
+
+  src = _cogl_bitmap_map (upload_bmp, COGL_BUFFER_ACCESS_READ, 0, error);
+  if (src == NULL)
+    return FALSE;
+
+  /* Make the pointer refer to pixel (0,0) of the image so that the
+     tiles can be filled using image coordinates */
+  src += (src_y - dst_y) * src_rowstride + (src_x - dst_x) * bpp;
+
+  ctx->driver_vtable->pixel_format_to_gl (ctx,
+                                          upload_format,
+                                          NULL, /* internal format */
+                                          &gl_format,
+                                          &gl_type);
+
+  tile_data = g_malloc (tex_tiled->tile_width * tex_tiled->tile_height * bpp);
+
+  _cogl_bind_gl_texture_transient (GL_TEXTURE_2D_ARRAY,
+                                   tex_tiled->gl_texture,
+                                   FALSE);
+
+  ctx->texture_driver->prep_gl_for_pixels_upload (ctx,
+                                                  0, /* rowstride */
+                                                  bpp);
+
+  /* Clear any GL errors */
+  while ((gl_error = ctx->glGetError ()) != GL_NO_ERROR)
+    ;
+
+  for (ty = 0; ty < tex_tiled->n_tiles_y; ty++)
+    {
+      int tile_y = ty * tex_tiled->inner_height;
+      int first_row, end_row;
+
+      if (!get_tile_span (tile_y, tex_tiled->tile_height, image_height,
+                          dst_y, height,
+                          &first_row, &end_row))
+        continue;
+
+      for (tx = 0; tx < tex_tiled->n_tiles_x; tx++)
+        {
+          int tile_x = tx * tex_tiled->inner_width;
+          int first_col, end_col;
+          int n_cols;
+          uint8_t *p;
+          int row;
+
+          if (!get_tile_span (tile_x, tex_tiled->tile_width, image_width,
+                              dst_x, width,
+                              &first_col, &end_col))
+            continue;
+
+          n_cols = end_col - first_col;
+
+          for (row = first_row, p = tile_data;
+               row < end_row;
+               row++, p += n_cols * bpp)
+            {
+              int image_y = CLAMP (tile_y - 1 + row, 0, image_height - 1);
+
+              copy_tile_row (p,
+                             src + image_y * src_rowstride,
+                             tile_x - 1 + first_col,
+                             n_cols,
+                             image_width,
+                             bpp);
+            }
+
+          ctx->glTexSubImage3D (GL_TEXTURE_2D_ARRAY,
+                                0, /* level */
+                                first_col,
+                                first_row,
+                                ty * tex_tiled->n_tiles_x + tx,
+                                n_cols,
+                                end_row - first_row,
+                                1, /* depth */
+                                gl_format,
+                                gl_type,
+                                tile_data);
+
+          if (_cogl_gl_util_catch_out_of_memory (ctx, error))
+            {
+              status = FALSE;
+              goto done;
+            }
+        }
+    }
+
+ done:
+  g_free (tile_data);
+
+  _cogl_bitmap_unmap (upload_bmp);
+
+  tex_tiled->mipmaps_dirty = TRUE;
+
+  return status;
+}
+
+static CoglBool
+allocate_with_size (CoglTextureTiled *tex_tiled,
+                    CoglTextureLoader *loader,
+                    CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_tiled);
+  CoglPixelFormat internal_format;
+  int width = loader->src.sized.width;
+  int height = loader->src.sized.height;
+
+  internal_format =
+    _cogl_texture_determine_internal_format (tex, COGL_PIXEL_FORMAT_ANY);
+
+  if (!_cogl_texture_tiled_can_create (tex_tiled,
+                                       width,
+                                       height,
+                                       internal_format,
+                                       error))
+    return FALSE;
+
+  if (!allocate_storage (tex_tiled, internal_format, error))
+    return FALSE;
+
+  _cogl_texture_set_allocated (tex, internal_format, width, height);
+
+  return TRUE;
+}
+
+static CoglBool
+allocate_from_bitmap (CoglTextureTiled *tex_tiled,
+                      CoglTextureLoader *loader,
+                      CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_tiled);
+  CoglBitmap *bmp = loader->src.bitmap.bitmap;
+  int width = cogl_bitmap_get_width (bmp);
+  int height = cogl_bitmap_get_height (bmp);
+  CoglBool can_convert_in_place = loader->src.bitmap.can_convert_in_place;
+  CoglPixelFormat internal_format;
+  CoglBitmap *upload_bmp;
+
+  internal_format =
+    _cogl_texture_determine_internal_format (tex,
+                                             cogl_bitmap_get_format (bmp));
+
+  if (!_cogl_texture_tiled_can_create (tex_tiled,
+                                       width,
+                                       height,
+                                       internal_format,
+                                       error))
+    return FALSE;
+
+  upload_bmp = _cogl_bitmap_convert_for_upload (bmp,
+                                                internal_format,
+                                                can_convert_in_place,
+                                                error);
+  if (upload_bmp == NULL)
+    return FALSE;
+
+  if (!allocate_storage (tex_tiled, internal_format, error))
+    {
+      cogl_object_unref (upload_bmp);
+      return FALSE;
+    }
+
+  if (!upload_region (tex_tiled,
+                      upload_bmp,
+                      0, 0, /* src_x/y */
+                      0, 0, /* dst_x/y */
+                      width, height,
+                      error))
+    {
+      cogl_object_unref (upload_bmp);
+      _cogl_delete_gl_texture (tex_tiled->gl_texture);
+      tex_tiled->gl_texture = 0;
+      return FALSE;
+    }
+
+  cogl_object_unref (upload_bmp);
+
+  _cogl_texture_set_allocated (tex, internal_format, width, height);
+
+  return TRUE;
+}
+
+static CoglBool
+_cogl_texture_tiled_allocate (CoglTexture *tex,
+                              CoglError **error)
+{
+  CoglTextureTiled *tex_tiled = COGL_TEXTURE_TILED (tex);
+  CoglTextureLoader *loader = tex->loader;
+
+  _COGL_RETURN_VAL_IF_FAIL (loader, FALSE);
+
+  switch (loader->src_type)
+    {
+    case COGL_TEXTURE_SOURCE_TYPE_SIZED:
+      return allocate_with_size (tex_tiled, loader, error);
+    case COGL_TEXTURE_SOURCE_TYPE_BITMAP:
+      return allocate_from_bitmap (tex_tiled, loader, error);
+    default:
+      break;
+    }
+
+  g_return_val_if_reached (FALSE);
+}
+
+static CoglBool
+_cogl_texture_tiled_is_sliced (CoglTexture *tex)
+{
+  /* All of the tiles are in a single GL texture so as far as the
+     rest of Cogl is concerned the texture isn't sliced */
+  return FALSE;
+}
+
+static CoglBool
+_cogl_texture_tiled_can_hardware_repeat (CoglTexture *tex)
+{
+  return FALSE;
+}
+
+static void
+_cogl_texture_tiled_transform_coords_to_gl (CoglTexture *tex,
+                                            float *s,
+                                            float *t)
+{
+  /* The shader maps the coordinates to a tile so we don't need to
+     do anything */
+}
+
+static CoglTransformResult
+_cogl_texture_tiled_transform_quad_coords_to_gl (CoglTexture *tex,
+                                                 float *coords)
+{
+  CoglBool need_repeat = FALSE;
+  int i;
+
+  for (i = 0; i < 4; i++)
+    if (coords[i] < 0.0f || coords[i] > 1.0f)
+      need_repeat = TRUE;
+
+  /* The GPU can't repeat the texture because each layer only
+     contains one tile. Reporting a software repeat lets the
+     primitives code emulate it in the shader instead */
+  return (need_repeat ? COGL_TRANSFORM_SOFTWARE_REPEAT
+          : COGL_TRANSFORM_NO_REPEAT);
+}
+
+static CoglBool
+_cogl_texture_tiled_get_gl_texture (CoglTexture *tex,
+                                    GLuint *out_gl_handle,
+                                    GLenum *out_gl_target)
+{
+  CoglTextureTiled *tex_tiled = COGL_TEXTURE_TILED (tex);
+
+  if (out_gl_handle)
+    *out_gl_handle = tex_tiled->gl_texture;
+
+  if (out_gl_target)
+    *out_gl_target = GL_TEXTURE_2D_ARRAY;
+
+  return TRUE;
+}
+
+static void
+_cogl_texture_tiled_gl_flush_legacy_texobj_filters (CoglTexture *tex,
+                                                    GLenum min_filter,
+                                                    GLenum mag_filter)
+{
+  CoglTextureTiled *tex_tiled = COGL_TEXTURE_TILED (tex);
+  CoglContext *ctx = tex->context;
+
+  if (min_filter == tex_tiled->gl_legacy_texobj_min_filter
+      && mag_filter == tex_tiled->gl_legacy_texobj_mag_filter)
+    return;
+
+  /* Store new values */
+  tex_tiled->gl_legacy_texobj_min_filter = min_filter;
+  tex_tiled->gl_legacy_texobj_mag_filter = mag_filter;
+
+  /* Apply new filters to the texture */
+  _cogl_bind_gl_texture_transient (GL_TEXTURE_2D_ARRAY,
+                                   tex_tiled->gl_texture,
+                                   FALSE);
+  GE( ctx, glTexParameteri (GL_TEXTURE_2D_ARRAY,
+                            GL_TEXTURE_MAG_FILTER,
+                            mag_filter) );
+  GE( ctx, glTexParameteri (GL_TEXTURE_2D_ARRAY,
+                            GL_TEXTURE_MIN_FILTER,
+                            min_filter) );
+}
+
+static void
+_cogl_texture_tiled_pre_paint (CoglTexture *tex,
+                               CoglTexturePrePaintFlags flags)
+{
+  CoglTextureTiled *tex_tiled = COGL_TEXTURE_TILED (tex);
+
+  /* Only update if the mipmaps are dirty. glGenerateMipmap is always
+     available when tiled textures are supported */
+  if ((flags & COGL_TEXTURE_NEEDS_MIPMAP) &&
+      tex_tiled->auto_mipmap && tex_tiled->mipmaps_dirty)
+    {
+      _cogl_texture_gl_generate_mipmaps (tex);
+
+      tex_tiled->mipmaps_dirty = FALSE;
+    }
+}
+
+static void
+_cogl_texture_tiled_ensure_non_quad_rendering (CoglTexture *tex)
+{
+  /* Nothing needs to be done */
+}
+
+static CoglBool
+_cogl_texture_tiled_set_region (CoglTexture *tex,
+                                int src_x,
+                                int src_y,
+                                int dst_x,
+                                int dst_y,
+                                int dst_width,
+                                int dst_height,
+                                int level,
+                                CoglBitmap *bmp,
+                                CoglError **error)
+{
+  CoglTextureTiled *tex_tiled = COGL_TEXTURE_TILED (tex);
+  CoglBitmap *upload_bmp;
+  CoglBool status;
+
+  /* The mipmap levels of the layers don't correspond to the mipmap
+     levels of the whole image so only the base level can be set */
+  if (level != 0)
+    {
+      _cogl_set_error (error,
+                       COGL_SYSTEM_ERROR,
+                       COGL_SYSTEM_ERROR_UNSUPPORTED,
+                       "Setting a mipmap level of a tiled texture isn't "
+                       "supported");
+      return FALSE;
+    }
+
+  upload_bmp =
+    _cogl_bitmap_convert_for_upload (bmp,
+                                     _cogl_texture_get_format (tex),
+                                     FALSE, /* can't convert in place */
+                                     error);
+  if (upload_bmp == NULL)
+    return FALSE;
+
+  status = upload_region (tex_tiled,
+                          upload_bmp,
+                          src_x, src_y,
+                          dst_x, dst_y,
+                          dst_width, dst_height,
+                          error);
+
+  cogl_object_unref (upload_bmp);
+
+  return status;
+}
+
+static int
+_cogl_texture_tiled_get_data (CoglTexture *tex,
+                              CoglPixelFormat format,
+                              int rowstride,
+                              uint8_t *data)
+{
+  /* Reassembling the image from the layers isn't implemented so
+     report failure. cogl_texture_get_data() will fall back to
+     rendering the texture and reading it back instead */
+  return 0;
+}
+
+static CoglPixelFormat
+_cogl_texture_tiled_get_format (CoglTexture *tex)
+{
+  return COGL_TEXTURE_TILED (tex)->internal_format;
+}
+
+static GLenum
+_cogl_texture_tiled_get_gl_format (CoglTexture *tex)
+{
+  return COGL_TEXTURE_TILED (tex)->gl_format;
+}
+
+static CoglTextureType
+_cogl_texture_tiled_get_type (CoglTexture *tex)
+{
+  return COGL_TEXTURE_TYPE_2D_ARRAY;
+}
+
+static size_t
+_cogl_texture_tiled_get_gpu_bytes (CoglTexture *tex)
+{
+  CoglTextureTiled *tex_tiled = COGL_TEXTURE_TILED (tex);
+  int bpp = _cogl_pixel_format_get_bytes_per_pixel (tex_tiled->internal_format);
+  int n_layers = tex_tiled->n_tiles_x * tex_tiled->n_tiles_y;
+  int width = tex_tiled->tile_width;
+  int height = tex_tiled->tile_height;
+  size_t bytes = 0;
+  int level;
+
+  /* Unlike 3D textures the number of layers isn't reduced for each
+     mipmap level */
+  for (level = 0; level <= tex->max_level; level++)
+    {
+      bytes += (size_t) width * height * n_layers * bpp;
+
+      if (width == 1 && height == 1)
+        break;
+
+      width = MAX (1, width >> 1);
+      height = MAX (1, height >> 1);
+    }
+
+  return bytes;
+}
+
+CoglBool
+_cogl_texture_tiled_get_layout (CoglTexture *texture,
+                                float tiles[4],
+                                float tile_scale[4])
+{
+  CoglTextureTiled *tex_tiled;
+
+  /* Sub textures use the coordinates of the full texture so the
+     layout of the full texture can be used directly */
+  if (cogl_is_sub_texture (texture))
+    texture = COGL_SUB_TEXTURE (texture)->full_texture;
+
+  if (!cogl_is_texture_tiled (texture))
+    return FALSE;
+
+  tex_tiled = COGL_TEXTURE_TILED (texture);
+
+  tiles[0] = texture->width / (float) tex_tiled->inner_width;
+  tiles[1] = texture->height / (float) tex_tiled->inner_height;
+  tiles[2] = tex_tiled->n_tiles_x;
+  tiles[3] = tex_tiled->n_tiles_y;
+
+  tile_scale[0] = tex_tiled->inner_width / (float) tex_tiled->tile_width;
+  tile_scale[1] = tex_tiled->inner_height / (float) tex_tiled->tile_height;
+  tile_scale[2] = 1.0f / tex_tiled->tile_width;
+  tile_scale[3] = 1.0f / tex_tiled->tile_height;
+
+  return TRUE;
+}
+
+static const CoglTextureVtable
+cogl_texture_tiled_vtable =
+  {
+    TRUE, /* primitive */
+    _cogl_texture_tiled_allocate,
+    _cogl_texture_tiled_set_region,
+    _cogl_texture_tiled_get_data,
+    NULL, /* foreach_sub_texture_in_region */
+    _cogl_texture_tiled_is_sliced,
+    _cogl_texture_tiled_can_hardware_repeat,
+    _cogl_texture_tiled_transform_coords_to_gl,
+    _cogl_texture_tiled_transform_quad_coords_to_gl,
+    _cogl_texture_tiled_get_gl_texture,
+    _cogl_texture_tiled_gl_flush_legacy_texobj_filters,
+    _cogl_texture_tiled_pre_paint,
+    _cogl_texture_tiled_ensure_non_quad_rendering,
+    _cogl_texture_tiled_gl_flush_legacy_texobj_wrap_modes,
+    _cogl_texture_tiled_get_format,
+    _cogl_texture_tiled_get_gl_format,
+    _cogl_texture_tiled_get_type,
+    NULL, /* is_foreign */
+    _cogl_texture_tiled_set_auto_mipmap,
+    _cogl_texture_tiled_get_gpu_bytes,
+    NULL /* discard_storage */
+  };
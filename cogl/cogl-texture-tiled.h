@@ -0,0 +1,182 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ */
+
+#if !defined(__COGL_H_INSIDE__) && !defined(COGL_COMPILATION)
+#error "Only <cogl/cogl.h> can be included directly."
+#endif
+
+#ifndef __COGL_TEXTURE_TILED_H
+#define __COGL_TEXTURE_TILED_H
+
+COGL_BEGIN_DECLS
+
+/**
+ * SECTION:cogl-texture-tiled
+ * @short_description: Functions for creating and manipulating tiled
+ *                     textures
+ *
+ * A #CoglTextureTiled can represent an image that is larger than the
+ * maximum texture size supported by the GPU. Unlike a
+ * #CoglTexture2DSliced the image isn't split into separate GL
+ * textures. Instead all of the tiles are stored as the layers of a
+ * single array texture and the tile for each fragment is chosen in
+ * the fragment shader. This means a tiled texture is a primitive
+ * texture so it can be drawn with a single draw call, it can be
+ * combined with other layers and it can be used with primitives and
+ * paths.
+ *
+ * Each tile has a one texel border copied from its neighbours so
+ * that linear filtering doesn't show any seams between the tiles.
+ */
+
+typedef struct _CoglTextureTiled CoglTextureTiled;
+
+#define COGL_TEXTURE_TILED(X) ((CoglTextureTiled *)X)
+
+/**
+ * cogl_texture_tiled_new_with_size:
+ * @context: A #CoglContext
+ * @width: width of the texture in pixels.
+ * @height: height of the texture in pixels.
+ *
+ * Creates a #CoglTextureTiled with the given dimensions. The
+ * dimensions can be larger than the maximum texture size supported
+ * by the GPU.
+ *
+ * The storage for the texture is not allocated before this function
+ * returns. You can call cogl_texture_allocate() to explicitly
+ * allocate the underlying storage or preferably let Cogl
+ * automatically allocate storage lazily when it may know more about
+ * how the texture is going to be used and can optimize how it is
+ * allocated.
+ *
+ * The texture is still configurable until it has been allocated so
+ * for example you can influence the internal format of the texture
+ * using cogl_texture_set_components() and
+ * cogl_texture_set_premultiplied().
+ *
+ * <note>This texture will fail to allocate later if
+ * %COGL_FEATURE_ID_TEXTURE_TILED is not advertised. Allocation can
+ * also fail if the image needs more tiles than the GPU supports in
+ * an array texture.</note>
+ *
+ * Returns: (transfer full): A new #CoglTextureTiled object with no
+ *          storage allocated yet.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglTextureTiled *
+cogl_texture_tiled_new_with_size (CoglContext *context,
+                                  int width,
+                                  int height);
+
+/**
+ * cogl_texture_tiled_new_from_bitmap:
+ * @bitmap: A #CoglBitmap
+ *
+ * Creates a new #CoglTextureTiled texture based on data residing in
+ * a bitmap. The bitmap can be larger than the maximum texture size
+ * supported by the GPU.
+ *
+ * The storage for the texture is not allocated before this function
+ * returns. You can call cogl_texture_allocate() to explicitly
+ * allocate the underlying storage or let Cogl automatically allocate
+ * storage lazily.
+ *
+ * The texture is still configurable until it has been allocated so
+ * for example you can influence the internal format of the texture
+ * using cogl_texture_set_components() and
+ * cogl_texture_set_premultiplied().
+ *
+ * <note>This texture will fail to allocate later if
+ * %COGL_FEATURE_ID_TEXTURE_TILED is not advertised.</note>
+ *
+ * Returns: (transfer full): A new #CoglTextureTiled object with no
+ *          storage allocated yet.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglTextureTiled *
+cogl_texture_tiled_new_from_bitmap (CoglBitmap *bitmap);
+
+/**
+ * cogl_texture_tiled_set_max_tile_size:
+ * @tiled_texture: A #CoglTextureTiled
+ * @max_tile_size: The maximum width and height of each tile in
+ *   pixels including the border or 0 to use the maximum texture
+ *   size of the GPU.
+ *
+ * Limits the size of the tiles that the texture will be split
+ * into. By default the tiles are as large as the GPU allows. This can
+ * only be called before the texture is allocated and the size must be
+ * at least 3 pixels.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+void
+cogl_texture_tiled_set_max_tile_size (CoglTextureTiled *tiled_texture,
+                                      int max_tile_size);
+
+/**
+ * cogl_texture_tiled_get_n_tiles:
+ * @tiled_texture: A #CoglTextureTiled
+ *
+ * Queries how many tiles the texture was split into. This will
+ * allocate the texture if it isn't already allocated.
+ *
+ * Return value: The number of tiles in the texture or 0 if it could
+ *   not be allocated.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+int
+cogl_texture_tiled_get_n_tiles (CoglTextureTiled *tiled_texture);
+
+/**
+ * cogl_is_texture_tiled:
+ * @object: A #CoglObject
+ *
+ * Gets whether the given object references a #CoglTextureTiled.
+ *
+ * Return value: %TRUE if the object references a #CoglTextureTiled
+ *   and %FALSE otherwise.
+ *
+ * Since: 2.0
+ * Stability: unstable
+ */
+CoglBool
+cogl_is_texture_tiled (void *object);
+
+COGL_END_DECLS
+
+#endif /* __COGL_TEXTURE_TILED_H */
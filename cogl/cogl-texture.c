@@ -50,9 +50,11 @@
 #include "cogl-texture-2d-private.h"
 #include "cogl-texture-2d-gl.h"
 #include "cogl-texture-3d-private.h"
+#include "cogl-texture-tiled-private.h"
 #include "cogl-texture-rectangle-private.h"
 #include "cogl-sub-texture-private.h"
 #include "cogl-atlas-texture-private.h"
+#include "cogl-texture-residency-private.h"
 #include "cogl-pipeline.h"
 #include "cogl-context-private.h"
 #include "cogl-object-private.h"
@@ -123,6 +125,11 @@ _cogl_texture_init (CoglTexture *texture,
   texture->allocated = FALSE;
   texture->vtable = vtable;
   texture->framebuffers = NULL;
+  texture->compressed = FALSE;
+  texture->purgeable = FALSE;
+  texture->in_purgeable_list = FALSE;
+  texture->last_used_frame = 0;
+  texture->gpu_bytes = 0;
 
   texture->loader = loader;
 
@@ -144,7 +151,7 @@ _cogl_texture_init (CoglTexture *texture,
   texture->premultiplied = TRUE;
 }
 
-static void
+void
 _cogl_texture_free_loader (CoglTexture *texture)
 {
   if (texture->loader)
@@ -159,6 +166,9 @@ _cogl_texture_free_loader (CoglTexture *texture)
         case COGL_TEXTURE_SOURCE_TYPE_BITMAP:
           cogl_object_unref (loader->src.bitmap.bitmap);
           break;
+        case COGL_TEXTURE_SOURCE_TYPE_COMPRESSED:
+          _cogl_compressed_image_free (loader->src.compressed.image);
+          break;
         }
       g_slice_free (CoglTextureLoader, loader);
       texture->loader = NULL;
@@ -174,6 +184,7 @@ _cogl_texture_create_loader (void)
 void
 _cogl_texture_free (CoglTexture *texture)
 {
+  _cogl_texture_residency_free (texture);
   _cogl_texture_free_loader (texture);
 
   g_free (texture);
@@ -231,6 +242,12 @@ _cogl_texture_get_n_levels (CoglTexture *texture)
       CoglTexture3D *tex_3d = COGL_TEXTURE_3D (texture);
       max_dimension = MAX (max_dimension, tex_3d->depth);
     }
+  else if (cogl_is_texture_tiled (texture))
+    {
+      /* The mipmaps are generated separately for each tile */
+      CoglTextureTiled *tex_tiled = COGL_TEXTURE_TILED (texture);
+      max_dimension = MAX (tex_tiled->tile_width, tex_tiled->tile_height);
+    }
 
   return _cogl_util_fls (max_dimension);
 }
@@ -344,9 +361,17 @@ _cogl_texture_pre_paint (CoglTexture *texture, CoglTexturePrePaintFlags flags)
    * XXX: Maybe it could even be considered a programmer error if the
    * texture hasn't been allocated by this point since it implies we
    * are abount to paint with undefined texture contents?
+   *
+   * If the texture is purgeable and has been evicted then this will
+   * transparently recreate it from its loader.
    */
+  _cogl_texture_residency_touch (texture);
   cogl_texture_allocate (texture, NULL);
 
+  /* This can be called while a journal is being flushed so other
+   * textures aren't evicted here even if this takes us over the
+   * budget. That is left for the end of the frame. */
+
   texture->vtable->pre_paint (texture, flags);
 }
 
@@ -379,6 +404,10 @@ cogl_texture_set_region_from_bitmap (CoglTexture *texture,
   if (!cogl_texture_allocate (texture, error))
     return FALSE;
 
+  /* The loader no longer describes the contents of the texture so it
+   * can't be evicted anymore */
+  _cogl_texture_residency_make_permanent (texture);
+
   /* Note that we don't prepare the bitmap for upload here because
      some backends may be internally using a different format for the
      actual GL texture than that reported by
@@ -1125,6 +1154,10 @@ _cogl_texture_associate_framebuffer (CoglTexture *texture,
 {
   static CoglUserDataKey framebuffer_destroy_notify_key;
 
+  /* The contents of a texture that is rendered to can't be recreated
+   * so it must never be evicted */
+  _cogl_texture_residency_make_permanent (texture);
+
   /* Note: we don't take a reference on the framebuffer here because
    * that would introduce a circular reference. */
   texture->framebuffers = g_list_prepend (texture->framebuffers, framebuffer);
@@ -1281,7 +1314,10 @@ _cogl_texture_set_allocated (CoglTexture *texture,
   texture->height = height;
   texture->allocated = TRUE;
 
-  _cogl_texture_free_loader (texture);
+  /* Purgeable textures keep their loader so that they can be
+   * recreated after being evicted */
+  if (!_cogl_texture_residency_allocated (texture))
+    _cogl_texture_free_loader (texture);
 }
 
 CoglBool
@@ -1435,6 +1471,21 @@ cogl_texture_get_premultiplied (CoglTexture *texture)
   return texture->premultiplied;
 }
 
+void
+cogl_texture_set_compressed (CoglTexture *texture,
+                             CoglBool compressed)
+{
+  _COGL_RETURN_IF_FAIL (!texture->allocated);
+
+  texture->compressed = !!compressed;
+}
+
+CoglBool
+cogl_texture_get_compressed (CoglTexture *texture)
+{
+  return texture->compressed;
+}
+
 void
 _cogl_texture_copy_internal_format (CoglTexture *src,
                                     CoglTexture *dest)
@@ -106,6 +106,9 @@ typedef enum {
  * @COGL_TEXTURE_TYPE_2D: A #CoglTexture2D
  * @COGL_TEXTURE_TYPE_3D: A #CoglTexture3D
  * @COGL_TEXTURE_TYPE_RECTANGLE: A #CoglTextureRectangle
+ * @COGL_TEXTURE_TYPE_2D_ARRAY: A #CoglTextureTiled. The layers of
+ *   the array are only accessed through the tile lookup that Cogl
+ *   generates in the fragment shader. (Since: 2.0)
  *
  * Constants representing the underlying hardware texture type of a
  * #CoglTexture.
@@ -116,7 +119,8 @@ typedef enum {
 typedef enum {
   COGL_TEXTURE_TYPE_2D,
   COGL_TEXTURE_TYPE_3D,
-  COGL_TEXTURE_TYPE_RECTANGLE
+  COGL_TEXTURE_TYPE_RECTANGLE,
+  COGL_TEXTURE_TYPE_2D_ARRAY
 } CoglTextureType;
 
 uint32_t cogl_texture_error_domain (void);
@@ -256,6 +260,157 @@ cogl_texture_set_premultiplied (CoglTexture *texture,
 CoglBool
 cogl_texture_get_premultiplied (CoglTexture *texture);
 
+/**
+ * cogl_texture_set_compressed:
+ * @texture: a #CoglTexture pointer.
+ * @compressed: Whether the texture data should be stored in a block
+ *              compressed format.
+ *
+ * Hints that the texture data may be stored in a lossy block
+ * compressed format such as S3TC or ETC2 to reduce the amount of
+ * video memory it uses. If the driver supports a suitable format then
+ * Cogl will compress the source data on the CPU when the texture is
+ * allocated, including a full chain of mipmap levels. Otherwise the
+ * hint is ignored and the texture is stored uncompressed.
+ *
+ * Currently this hint is only honoured by #CoglTexture2D textures
+ * created from a #CoglBitmap, a file or a data pointer. Once the data
+ * is compressed, cogl_texture_set_region() can no longer be used on
+ * the texture.
+ *
+ * This must be called before the texture is allocated. By default the
+ * compressed state is %FALSE.
+ *
+ * Since: 2.0
+ */
+void
+cogl_texture_set_compressed (CoglTexture *texture,
+                             CoglBool compressed);
+
+/**
+ * cogl_texture_get_compressed:
+ * @texture: a #CoglTexture pointer.
+ *
+ * Queries whether the texture data may be stored in a block
+ * compressed format as set by cogl_texture_set_compressed().
+ *
+ * Return value: %TRUE if the texture was hinted to be compressed.
+ * Since: 2.0
+ */
+CoglBool
+cogl_texture_get_compressed (CoglTexture *texture);
+
+/**
+ * cogl_texture_set_purgeable:
+ * @texture: a #CoglTexture pointer.
+ * @purgeable: Whether Cogl may free the texture storage when it needs
+ *             to reclaim texture memory.
+ *
+ * Marks the texture as being safe to evict from GPU memory when the
+ * context goes over the budget set with
+ * cogl_context_set_texture_memory_budget(). Purgeable textures are
+ * evicted in least recently used order and are transparently
+ * recreated from their original source data the next time they are
+ * painted.
+ *
+ * Only #CoglTexture2D and #CoglTexture2DSliced textures created from a
+ * #CoglBitmap, a file or a data pointer can be evicted. To be able to
+ * recreate the texture Cogl keeps a reference to the source data for
+ * as long as the texture is purgeable. Modifying the texture with
+ * cogl_texture_set_region() or rendering to it with a
+ * #CoglOffscreen makes it permanently resident again.
+ *
+ * This must be called before the texture is allocated. By default the
+ * purgeable state is %FALSE.
+ *
+ * Since: 2.0
+ */
+void
+cogl_texture_set_purgeable (CoglTexture *texture,
+                            CoglBool purgeable);
+
+/**
+ * cogl_texture_get_purgeable:
+ * @texture: a #CoglTexture pointer.
+ *
+ * Queries whether the texture may be evicted from GPU memory as set
+ * by cogl_texture_set_purgeable().
+ *
+ * Return value: %TRUE if the texture is purgeable.
+ * Since: 2.0
+ */
+CoglBool
+cogl_texture_get_purgeable (CoglTexture *texture);
+
+/**
+ * cogl_context_set_texture_memory_budget:
+ * @context: A #CoglContext pointer
+ * @budget: The maximum number of bytes of texture memory to use or 0
+ *          for no limit
+ *
+ * Sets the amount of GPU memory that the textures of @context should
+ * try to stay under. When the budget is exceeded Cogl evicts
+ * textures that have been marked with cogl_texture_set_purgeable(),
+ * starting with the least recently used. Textures that have been
+ * painted during the current frame are never evicted so the budget
+ * may still be exceeded if not enough purgeable textures are idle.
+ *
+ * The budget is checked when it is set and at the end of each
+ * frame. A frame ends when an onscreen framebuffer is swapped or
+ * when cogl_context_end_frame() is called. Painting textures in the middle of a frame can take the
+ * usage over the budget until the end of the frame.
+ *
+ * The default budget can also be set in megabytes with the
+ * COGL_TEXTURE_MEMORY_BUDGET environment variable. By default there
+ * is no limit.
+ *
+ * Since: 2.0
+ */
+void
+cogl_context_set_texture_memory_budget (CoglContext *context,
+                                        size_t budget);
+
+/**
+ * cogl_context_get_texture_memory_budget:
+ * @context: A #CoglContext pointer
+ *
+ * Return value: The texture memory budget set with
+ *   cogl_context_set_texture_memory_budget() or 0 if there is no
+ *   limit.
+ * Since: 2.0
+ */
+size_t
+cogl_context_get_texture_memory_budget (CoglContext *context);
+
+/**
+ * cogl_context_get_texture_memory_usage:
+ * @context: A #CoglContext pointer
+ *
+ * Queries an estimate of the number of bytes of GPU memory currently
+ * used by all of the textures of @context, including the mipmap
+ * levels and the storage for textures in atlases.
+ *
+ * Return value: The number of bytes used.
+ * Since: 2.0
+ */
+size_t
+cogl_context_get_texture_memory_usage (CoglContext *context);
+
+/**
+ * cogl_context_get_texture_memory_usage_for_type:
+ * @context: A #CoglContext pointer
+ * @type: The #CoglTextureType to query
+ *
+ * Queries an estimate of the number of bytes of GPU memory currently
+ * used by the hardware textures of the given @type.
+ *
+ * Return value: The number of bytes used.
+ * Since: 2.0
+ */
+size_t
+cogl_context_get_texture_memory_usage_for_type (CoglContext *context,
+                                                CoglTextureType type);
+
 /**
  * cogl_texture_get_width:
  * @texture: a #CoglTexture pointer.
@@ -0,0 +1,150 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifndef __COGL_VIRTUAL_TEXTURE_PRIVATE_H
+#define __COGL_VIRTUAL_TEXTURE_PRIVATE_H
+
+#include "cogl-object-private.h"
+#include "cogl-virtual-texture.h"
+#include "cogl-pixel-buffer.h"
+#include "cogl-texture.h"
+#include "cogl-list.h"
+#include "cogl-worker-pool-private.h"
+
+typedef struct _CoglVirtualTextureLevel
+{
+  int width;
+  int height;
+  int n_tiles_x;
+  int n_tiles_y;
+
+  /* The index of the cache slot holding each tile of this level or
+     -1 if the tile isn't resident. Indexed by y * n_tiles_x + x */
+  int *page_table;
+} CoglVirtualTextureLevel;
+
+typedef struct _CoglVirtualTextureSlot
+{
+  /* Link in CoglVirtualTexture::lru_list. A slot that a tile is
+     being loaded into is taken out of the list until the load
+     finishes so that it can't be picked again */
+  CoglList link;
+
+  /* The tile stored in this slot or -1 for the level if it is free */
+  int level;
+  int tile_x;
+  int tile_y;
+
+  /* The value of CoglVirtualTexture::draw_count when the tile was
+     last drawn. A tile that was drawn in the current draw is never
+     evicted */
+  unsigned int last_used;
+} CoglVirtualTextureSlot;
+
+typedef struct _CoglVirtualTextureTile
+{
+  int level;
+  int tile_x;
+  int tile_y;
+} CoglVirtualTextureTile;
+
+typedef struct _CoglVirtualTextureRequest
+{
+  /* Link in CoglVirtualTexture::pending_loads */
+  CoglList link;
+
+  CoglVirtualTexture *virtual_texture;
+  CoglVirtualTextureTile tile;
+
+  /* The slot that the tile will be uploaded into */
+  CoglVirtualTextureSlot *slot;
+
+  /* The job running the loader in a worker thread. The fields below
+     are written by the worker thread and can only be read once the
+     job is done */
+  CoglWorkerJob *job;
+
+  /* The pixels of the tile including the border */
+  uint8_t *data;
+
+  /* Set if the loader filled in the tile */
+  CoglBool loaded;
+} CoglVirtualTextureRequest;
+
+struct _CoglVirtualTexture
+{
+  CoglObject _parent;
+
+  CoglContext *context;
+
+  int width;
+  int height;
+  int tile_size;
+  CoglPixelFormat format;
+
+  CoglVirtualTextureLoader loader;
+  void *user_data;
+
+  int n_levels;
+  CoglVirtualTextureLevel *levels;
+
+  int cache_size;
+  int max_loads_per_draw;
+
+  /* These are created when the virtual texture is allocated. Each
+     slot in the cache texture holds one tile surrounded by a one
+     pixel border copied from the tile's own edges so that linear
+     filtering doesn't bleed in texels from a neighbouring slot */
+  CoglTexture *cache_texture;
+  int slots_per_row;
+  CoglVirtualTextureSlot *slots;
+  CoglPixelBuffer *staging_buffer;
+
+  /* All of the slots with the most recently used first. Free slots
+     are kept at the end */
+  CoglList lru_list;
+  int n_resident_tiles;
+
+  /* The CoglVirtualTextureRequests for the tiles that are being
+     loaded. A draw doesn't wait for these. Instead the ones that
+     have finished are uploaded at the start of the next draw */
+  CoglList pending_loads;
+  int n_pending_loads;
+
+  unsigned int draw_count;
+
+  /* Scratch arrays that are reused for every draw. These hold the
+     CoglVirtualTextureTiles that are going to be loaded and the
+     coordinates of the rectangles to draw */
+  GArray *queued_tiles;
+  GArray *rectangles;
+};
+
+#endif /* __COGL_VIRTUAL_TEXTURE_PRIVATE_H */
@@ -0,0 +1,970 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include <math.h>
+
+#include "cogl-util.h"
+#include "cogl-private.h"
+#include "cogl-context-private.h"
+#include "cogl-buffer-private.h"
+#include "cogl-texture-private.h"
+#include "cogl-virtual-texture-private.h"
+#include "cogl-texture-2d.h"
+#include "cogl-worker-pool-private.h"
+
+#define DEFAULT_CACHE_SIZE 64
+#define DEFAULT_MAX_LOADS_PER_DRAW 8
+
+static void _cogl_virtual_texture_free (CoglVirtualTexture *virtual_texture);
+static void free_request (CoglVirtualTextureRequest *request);
+
+COGL_OBJECT_DEFINE (VirtualTexture, virtual_texture);
+
+static void
+_cogl_virtual_texture_free (CoglVirtualTexture *virtual_texture)
+{
+  CoglVirtualTextureRequest *request, *tmp;
+  int i;
+
+  /* The worker threads may still be writing to the requests */
+  _cogl_list_for_each_safe (request, tmp,
+                            &virtual_texture->pending_loads,
+                            link)
+    free_request (request);
+
+  for (i = 0; i < virtual_texture->n_levels; i++)
+    g_free (virtual_texture->levels[i].page_table);
+  g_free (virtual_texture->levels);
+
+  if (virtual_texture->cache_texture)
+    cogl_object_unref (virtual_texture->cache_texture);
+  if (virtual_texture->staging_buffer)
+    cogl_object_unref (virtual_texture->staging_buffer);
+
+  g_free (virtual_texture->slots);
+
+  g_array_free (virtual_texture->queued_tiles, TRUE);
+  g_array_free (virtual_texture->rectangles, TRUE);
+
+  g_slice_free (CoglVirtualTexture, virtual_texture);
+}
+
+CoglVirtualTexture *
+cogl_virtual_texture_new (CoglContext *context,
+                          int width,
+                          int height,
+                          int tile_size,
+                          CoglPixelFormat format,
+                          CoglVirtualTextureLoader loader,
+                          void *user_data)
+{
+  CoglVirtualTexture *virtual_texture;
+  int i;
+
+  _COGL_RETURN_VAL_IF_FAIL (width > 0 && height > 0, NULL);
+  _COGL_RETURN_VAL_IF_FAIL (tile_size > 0, NULL);
+  _COGL_RETURN_VAL_IF_FAIL (_cogl_pixel_format_get_bytes_per_pixel (format) > 0,
+                            NULL);
+  _COGL_RETURN_VAL_IF_FAIL (loader != NULL, NULL);
+
+  virtual_texture = g_slice_new0 (CoglVirtualTexture);
+
+  virtual_texture->context = context;
+  virtual_texture->width = width;
+  virtual_texture->height = height;
+  virtual_texture->tile_size = tile_size;
+  virtual_texture->format = format;
+  virtual_texture->loader = loader;
+  virtual_texture->user_data = user_data;
+  virtual_texture->cache_size = DEFAULT_CACHE_SIZE;
+  virtual_texture->max_loads_per_draw = DEFAULT_MAX_LOADS_PER_DRAW;
+
+  /* Keep adding levels until the whole image fits in a single tile */
+  virtual_texture->n_levels = 1;
+  while (MAX (width >> (virtual_texture->n_levels - 1),
+              height >> (virtual_texture->n_levels - 1)) > tile_size)
+    virtual_texture->n_levels++;
+
+  virtual_texture->levels = g_new (CoglVirtualTextureLevel,
+                                   virtual_texture->n_levels);
+
+  for (i = 0; i < virtual_texture->n_levels; i++)
+    {
+      CoglVirtualTextureLevel *level = virtual_texture->levels + i;
+      int n_tiles, j;
+
+      level->width = MAX (width >> i, 1);
+      level->height = MAX (height >> i, 1);
+      level->n_tiles_x = (level->width + tile_size - 1) / tile_size;
+      level->n_tiles_y = (level->height + tile_size - 1) / tile_size;
+
+      n_tiles = level->n_tiles_x * level->n_tiles_y;
+      level->page_table = g_new (int, n_tiles);
+      for (j = 0; j < n_tiles; j++)
+        level->page_table[j] = -1;
+    }
+
+  _cogl_list_init (&virtual_texture->lru_list);
+  _cogl_list_init (&virtual_texture->pending_loads);
+
+  virtual_texture->queued_tiles =
+    g_array_new (FALSE, FALSE, sizeof (CoglVirtualTextureTile));
+  virtual_texture->rectangles = g_array_new (FALSE, FALSE, sizeof (float));
+
+  return _cogl_virtual_texture_object_new (virtual_texture);
+}
+
+void
+cogl_virtual_texture_set_cache_size (CoglVirtualTexture *virtual_texture,
+                                     int n_tiles)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_virtual_texture (virtual_texture));
+  _COGL_RETURN_IF_FAIL (virtual_texture->cache_texture == NULL);
+  _COGL_RETURN_IF_FAIL (n_tiles > 0);
+
+  virtual_texture->cache_size = n_tiles;
+}
+
+int
+cogl_virtual_texture_get_cache_size (CoglVirtualTexture *virtual_texture)
+{
+  return virtual_texture->cache_size;
+}
+
+void
+cogl_virtual_texture_set_max_loads_per_draw (CoglVirtualTexture *virtual_texture,
+                                             int n_tiles)
+{
+  _COGL_RETURN_IF_FAIL (cogl_is_virtual_texture (virtual_texture));
+  _COGL_RETURN_IF_FAIL (n_tiles > 0);
+
+  virtual_texture->max_loads_per_draw = n_tiles;
+}
+
+int
+cogl_virtual_texture_get_max_loads_per_draw (CoglVirtualTexture *virtual_texture)
+{
+  return virtual_texture->max_loads_per_draw;
+}
+
+int
+cogl_virtual_texture_get_n_levels (CoglVirtualTexture *virtual_texture)
+{
+  return virtual_texture->n_levels;
+}
+
+int
+cogl_virtual_texture_get_n_resident_tiles (CoglVirtualTexture *virtual_texture)
+{
+  return virtual_texture->n_resident_tiles;
+}
+
+CoglBool
+cogl_virtual_texture_allocate (CoglVirtualTexture *virtual_texture,
+                               CoglError **error)
+{
+  int slot_size = virtual_texture->tile_size + 2;
+  int n_rows;
+  CoglTexture2D *tex;
+  int i;
+
+  if (virtual_texture->cache_texture)
+    return TRUE;
+
+  /* Arrange the slots in a roughly square grid */
+  virtual_texture->slots_per_row = 1;
+  while (virtual_texture->slots_per_row * virtual_texture->slots_per_row <
+         virtual_texture->cache_size)
+    virtual_texture->slots_per_row++;
+  n_rows = ((virtual_texture->cache_size + virtual_texture->slots_per_row - 1) /
+            virtual_texture->slots_per_row);
+
+  tex = cogl_texture_2d_new_with_size (virtual_texture->context,
+                                       virtual_texture->slots_per_row *
+                                       slot_size,
+                                       n_rows * slot_size);
+
+  _cogl_texture_set_internal_format (COGL_TEXTURE (tex),
+                                     virtual_texture->format);
+
+  if (!cogl_texture_allocate (COGL_TEXTURE (tex), error))
+    {
+      cogl_object_unref (tex);
+      return FALSE;
+    }
+
+  virtual_texture->cache_texture = COGL_TEXTURE (tex);
+
+  virtual_texture->slots = g_new (CoglVirtualTextureSlot,
+                                  virtual_texture->cache_size);
+
+  for (i = 0; i < virtual_texture->cache_size; i++)
+    {
+      CoglVirtualTextureSlot *slot = virtual_texture->slots + i;
+
+      slot->level = -1;
+      slot->last_used = 0;
+      _cogl_list_insert (virtual_texture->lru_list.prev, &slot->link);
+    }
+
+  return TRUE;
+}
+
+static void
+touch_slot (CoglVirtualTexture *virtual_texture,
+            CoglVirtualTextureSlot *slot)
+{
+  slot->last_used = virtual_texture->draw_count;
+
+  _cogl_list_remove (&slot->link);
+  _cogl_list_insert (&virtual_texture->lru_list, &slot->link);
+}
+
+static int *
+get_page_table_entry (CoglVirtualTexture *virtual_texture,
+                      int level_num,
+                      int tile_x,
+                      int tile_y)
+{
+  CoglVirtualTextureLevel *level = virtual_texture->levels + level_num;
+
+  return level->page_table + tile_y * level->n_tiles_x + tile_x;
+}
+
+/* Finds the slot containing the given tile or failing that the
+   closest coarser tile that covers the same area */
+static CoglVirtualTextureSlot *
+find_resident_tile (CoglVirtualTexture *virtual_texture,
+                    int level_num,
+                    int tile_x,
+                    int tile_y)
+{
+  for (; level_num < virtual_texture->n_levels; level_num++)
+    {
+      CoglVirtualTextureLevel *level = virtual_texture->levels + level_num;
+      int slot_num;
+
+      /* The sizes of the levels are rounded down so for images that
+         aren't a power of two the parent index can be past the
+         edge */
+      tile_x = MIN (tile_x, level->n_tiles_x - 1);
+      tile_y = MIN (tile_y, level->n_tiles_y - 1);
+
+      slot_num = *get_page_table_entry (virtual_texture,
+                                        level_num,
+                                        tile_x, tile_y);
+
+      if (slot_num != -1)
+        return virtual_texture->slots + slot_num;
+
+      tile_x /= 2;
+      tile_y /= 2;
+    }
+
+  return NULL;
+}
+
+static CoglBool
+is_loading (CoglVirtualTexture *virtual_texture,
+            int level_num,
+            int tile_x,
+            int tile_y)
+{
+  CoglVirtualTextureRequest *request;
+
+  _cogl_list_for_each (request, &virtual_texture->pending_loads, link)
+    if (request->tile.level == level_num &&
+        request->tile.tile_x == tile_x &&
+        request->tile.tile_y == tile_y)
+      return TRUE;
+
+  return FALSE;
+}
+
+static void
+queue_tile (CoglVirtualTexture *virtual_texture,
+            int level_num,
+            int tile_x,
+            int tile_y)
+{
+  GArray *tiles = virtual_texture->queued_tiles;
+  CoglVirtualTextureTile *tile;
+  int i;
+
+  if (tiles->len + virtual_texture->n_pending_loads >=
+      virtual_texture->max_loads_per_draw)
+    return;
+
+  for (i = 0; i < tiles->len; i++)
+    {
+      tile = &g_array_index (tiles, CoglVirtualTextureTile, i);
+
+      if (tile->level == level_num &&
+          tile->tile_x == tile_x &&
+          tile->tile_y == tile_y)
+        return;
+    }
+
+  if (is_loading (virtual_texture, level_num, tile_x, tile_y))
+    return;
+
+  g_array_set_size (tiles, tiles->len + 1);
+  tile = &g_array_index (tiles, CoglVirtualTextureTile, tiles->len - 1);
+  tile->level = level_num;
+  tile->tile_x = tile_x;
+  tile->tile_y = tile_y;
+}
+
+/* Picks a slot to load a new tile into, evicting the least recently
+   used tile if there are no free slots. Returns NULL if every slot
+   is needed for the current draw or is already being loaded into */
+static CoglVirtualTextureSlot *
+take_slot (CoglVirtualTexture *virtual_texture)
+{
+  CoglVirtualTextureSlot *slot;
+
+  _cogl_list_for_each_reverse (slot, &virtual_texture->lru_list, link)
+    {
+      /* The top of the pyramid is the fallback for every other tile
+         so it is never evicted */
+      if (slot->last_used == virtual_texture->draw_count ||
+          slot->level == virtual_texture->n_levels - 1)
+        continue;
+
+      if (slot->level != -1)
+        {
+          *get_page_table_entry (virtual_texture,
+                                 slot->level,
+                                 slot->tile_x,
+                                 slot->tile_y) = -1;
+          slot->level = -1;
+          virtual_texture->n_resident_tiles--;
+        }
+
+      /* Reserve the slot until the load has finished so that it
+         won't be picked again */
+      _cogl_list_remove (&slot->link);
+
+      return slot;
+    }
+
+  return NULL;
+}
+
+static void
+get_tile_size (CoglVirtualTexture *virtual_texture,
+               int level_num,
+               int tile_x,
+               int tile_y,
+               int *width,
+               int *height)
+{
+  CoglVirtualTextureLevel *level = virtual_texture->levels + level_num;
+  int tile_size = virtual_texture->tile_size;
+
+  *width = MIN (tile_size, level->width - tile_x * tile_size);
+  *height = MIN (tile_size, level->height - tile_y * tile_size);
+}
+
+/* Runs in a worker thread. This must not touch any Cogl state. Each
+   request has its own buffer so the tiles can be filled in
+   concurrently while the application carries on drawing */
+static void
+load_tile_cb (int index,
+              void *user_data)
+{
+  CoglVirtualTextureRequest *request = user_data;
+  CoglVirtualTexture *virtual_texture = request->virtual_texture;
+  int bpp = _cogl_pixel_format_get_bytes_per_pixel (virtual_texture->format);
+  int slot_size = virtual_texture->tile_size + 2;
+  int rowstride = slot_size * bpp;
+  uint8_t *data = request->data;
+  int width, height;
+  int y;
+
+  get_tile_size (virtual_texture,
+                 request->tile.level,
+                 request->tile.tile_x,
+                 request->tile.tile_y,
+                 &width, &height);
+
+  request->loaded = virtual_texture->loader (request->tile.level,
+                                             request->tile.tile_x,
+                                             request->tile.tile_y,
+                                             width, height,
+                                             data + rowstride + bpp,
+                                             rowstride,
+                                             virtual_texture->user_data);
+
+  if (!request->loaded)
+    return;
+
+  /* Extend the edges of the tile into the border */
+  for (y = 1; y <= height; y++)
+    {
+      uint8_t *row = data + y * rowstride;
+
+      memcpy (row, row + bpp, bpp);
+      memcpy (row + (width + 1) * bpp, row + width * bpp, bpp);
+    }
+
+  memcpy (data, data + rowstride, (width + 2) * bpp);
+  memcpy (data + (height + 1) * rowstride,
+          data + height * rowstride,
+          (width + 2) * bpp);
+}
+
+static void
+free_request (CoglVirtualTextureRequest *request)
+{
+  _cogl_worker_job_free (request->job);
+  g_free (request->data);
+  g_slice_free (CoglVirtualTextureRequest, request);
+}
+
+/* Hands the queued tiles over to the worker pool without waiting for
+   them to be loaded */
+static void
+start_loads (CoglVirtualTexture *virtual_texture)
+{
+  GArray *tiles = virtual_texture->queued_tiles;
+  CoglWorkerPool *pool =
+    _cogl_context_get_worker_pool (virtual_texture->context);
+  int bpp = _cogl_pixel_format_get_bytes_per_pixel (virtual_texture->format);
+  int slot_size = virtual_texture->tile_size + 2;
+  int i;
+
+  for (i = 0; i < tiles->len; i++)
+    {
+      CoglVirtualTextureSlot *slot = take_slot (virtual_texture);
+      CoglVirtualTextureRequest *request;
+
+      /* If the cache is full of tiles needed by this draw then the
+         rest will have to be drawn from a coarser level */
+      if (slot == NULL)
+        break;
+
+      request = g_slice_new (CoglVirtualTextureRequest);
+      request->virtual_texture = virtual_texture;
+      request->tile = g_array_index (tiles, CoglVirtualTextureTile, i);
+      request->slot = slot;
+      request->data = g_malloc (slot_size * slot_size * bpp);
+      request->loaded = FALSE;
+
+      _cogl_list_insert (virtual_texture->pending_loads.prev, &request->link);
+      virtual_texture->n_pending_loads++;
+
+      request->job = _cogl_worker_pool_push (pool, load_tile_cb, request);
+    }
+}
+
+/* Uploads the tiles whose loads have finished. The pixels are copied
+   into the staging buffer so that the driver can do the uploads from
+   there without stalling */
+static void
+upload_finished_loads (CoglVirtualTexture *virtual_texture)
+{
+  CoglVirtualTextureRequest *request, *tmp;
+  CoglList finished;
+  CoglBuffer *buffer;
+  int bpp = _cogl_pixel_format_get_bytes_per_pixel (virtual_texture->format);
+  int slot_size = virtual_texture->tile_size + 2;
+  int rowstride = slot_size * bpp;
+  size_t tile_bytes = rowstride * slot_size;
+  uint8_t *data;
+  int n_loaded = 0;
+  int i;
+
+  _cogl_list_init (&finished);
+
+  _cogl_list_for_each_safe (request, tmp,
+                            &virtual_texture->pending_loads,
+                            link)
+    {
+      if (!_cogl_worker_job_is_done (request->job))
+        continue;
+
+      _cogl_list_remove (&request->link);
+      virtual_texture->n_pending_loads--;
+
+      if (request->loaded)
+        {
+          _cogl_list_insert (finished.prev, &request->link);
+          n_loaded++;
+        }
+      else
+        {
+          /* Give the slot back. The tile will be requested again the
+             next time it is drawn */
+          _cogl_list_insert (virtual_texture->lru_list.prev,
+                             &request->slot->link);
+          free_request (request);
+        }
+    }
+
+  if (n_loaded == 0)
+    return;
+
+  if (virtual_texture->staging_buffer &&
+      cogl_buffer_get_size (COGL_BUFFER (virtual_texture->staging_buffer)) <
+      tile_bytes * n_loaded)
+    {
+      cogl_object_unref (virtual_texture->staging_buffer);
+      virtual_texture->staging_buffer = NULL;
+    }
+
+  if (virtual_texture->staging_buffer == NULL)
+    {
+      virtual_texture->staging_buffer =
+        cogl_pixel_buffer_new (virtual_texture->context,
+                               tile_bytes *
+                               MAX (n_loaded,
+                                    virtual_texture->max_loads_per_draw),
+                               NULL, /* data */
+                               NULL /* error */);
+      cogl_buffer_set_update_hint (COGL_BUFFER (virtual_texture->
+                                                staging_buffer),
+                                   COGL_BUFFER_UPDATE_HINT_STREAM);
+    }
+
+  buffer = COGL_BUFFER (virtual_texture->staging_buffer);
+
+  data = _cogl_buffer_map_range_for_fill_or_fallback (buffer,
+                                                      0,
+                                                      tile_bytes * n_loaded);
+  i = 0;
+  _cogl_list_for_each (request, &finished, link)
+    memcpy (data + i++ * tile_bytes, request->data, tile_bytes);
+
+  _cogl_buffer_unmap_for_fill_or_fallback (buffer);
+
+  i = 0;
+  _cogl_list_for_each_safe (request, tmp, &finished, link)
+    {
+      CoglVirtualTextureSlot *slot = request->slot;
+      int slot_num = slot - virtual_texture->slots;
+      CoglError *ignore_error = NULL;
+      CoglBitmap *bitmap;
+      int width, height;
+
+      get_tile_size (virtual_texture,
+                     request->tile.level,
+                     request->tile.tile_x,
+                     request->tile.tile_y,
+                     &width, &height);
+
+      bitmap = cogl_bitmap_new_from_buffer (buffer,
+                                            virtual_texture->format,
+                                            width + 2,
+                                            height + 2,
+                                            rowstride,
+                                            i++ * tile_bytes);
+
+      if (cogl_texture_set_region_from_bitmap (virtual_texture->
+                                               cache_texture,
+                                               0, 0, /* src_x/y */
+                                               width + 2,
+                                               height + 2,
+                                               bitmap,
+                                               (slot_num %
+                                                virtual_texture->
+                                                slots_per_row) *
+                                               slot_size,
+                                               (slot_num /
+                                                virtual_texture->
+                                                slots_per_row) *
+                                               slot_size,
+                                               0, /* level */
+                                               &ignore_error))
+        {
+          slot->level = request->tile.level;
+          slot->tile_x = request->tile.tile_x;
+          slot->tile_y = request->tile.tile_y;
+          *get_page_table_entry (virtual_texture,
+                                 slot->level,
+                                 slot->tile_x,
+                                 slot->tile_y) = slot_num;
+          virtual_texture->n_resident_tiles++;
+          _cogl_list_insert (&virtual_texture->lru_list, &slot->link);
+        }
+      else
+        {
+          cogl_error_free (ignore_error);
+          _cogl_list_insert (virtual_texture->lru_list.prev, &slot->link);
+        }
+
+      cogl_object_unref (bitmap);
+
+      free_request (request);
+    }
+}
+
+static void
+load_top_tile (CoglVirtualTexture *virtual_texture)
+{
+  int top_level = virtual_texture->n_levels - 1;
+  CoglVirtualTextureRequest *request;
+
+  if (!is_loading (virtual_texture, top_level, 0, 0))
+    {
+      CoglVirtualTextureTile *tile;
+
+      g_array_set_size (virtual_texture->queued_tiles, 1);
+      tile = &g_array_index (virtual_texture->queued_tiles,
+                             CoglVirtualTextureTile,
+                             0);
+      tile->level = top_level;
+      tile->tile_x = 0;
+      tile->tile_y = 0;
+
+      start_loads (virtual_texture);
+    }
+
+  _cogl_list_for_each (request, &virtual_texture->pending_loads, link)
+    if (request->tile.level == top_level)
+      {
+        _cogl_worker_job_wait (request->job);
+        break;
+      }
+
+  upload_finished_loads (virtual_texture);
+}
+
+void
+cogl_virtual_texture_wait_for_loads (CoglVirtualTexture *virtual_texture)
+{
+  CoglVirtualTextureRequest *request;
+
+  _COGL_RETURN_IF_FAIL (cogl_is_virtual_texture (virtual_texture));
+
+  _cogl_list_for_each (request, &virtual_texture->pending_loads, link)
+    _cogl_worker_job_wait (request->job);
+
+  upload_finished_loads (virtual_texture);
+}
+
+/* Picks the level whose texels best match the size of the pixels of
+   the rectangle on screen. The whole rectangle is drawn from the same
+   level so with a perspective projection this is only based on the
+   corner at (x_1, y_1) */
+static int
+choose_level (CoglVirtualTexture *virtual_texture,
+              CoglFramebuffer *framebuffer,
+              float x_1,
+              float y_1,
+              float x_2,
+              float y_2,
+              float s_1,
+              float t_1,
+              float s_2,
+              float t_2)
+{
+  float points[6] = { x_1, y_1, x_2, y_1, x_1, y_2 };
+  CoglMatrix modelview, projection;
+  float viewport[4];
+  float screen_width, screen_height;
+  float scale;
+  int level_num;
+  int i;
+
+  cogl_framebuffer_get_modelview_matrix (framebuffer, &modelview);
+  cogl_framebuffer_get_projection_matrix (framebuffer, &projection);
+  cogl_framebuffer_get_viewport4fv (framebuffer, viewport);
+
+  for (i = 0; i < G_N_ELEMENTS (points); i += 2)
+    _cogl_transform_point (&modelview,
+                           &projection,
+                           viewport,
+                           points + i,
+                           points + i + 1);
+
+  screen_width = sqrtf ((points[2] - points[0]) * (points[2] - points[0]) +
+                        (points[3] - points[1]) * (points[3] - points[1]));
+  screen_height = sqrtf ((points[4] - points[0]) * (points[4] - points[0]) +
+                         (points[5] - points[1]) * (points[5] - points[1]));
+
+  if (screen_width <= 0.0f || screen_height <= 0.0f)
+    return virtual_texture->n_levels - 1;
+
+  /* The number of texels of the full resolution image that land on
+     each pixel */
+  scale = MAX ((s_2 - s_1) * virtual_texture->width / screen_width,
+               (t_2 - t_1) * virtual_texture->height / screen_height);
+
+  for (level_num = 0;
+       level_num < virtual_texture->n_levels - 1 && scale >= 2.0f;
+       level_num++)
+    scale /= 2.0f;
+
+  return level_num;
+}
+
+static void
+add_rectangle (CoglVirtualTexture *virtual_texture,
+               CoglVirtualTextureSlot *slot,
+               float x_1,
+               float y_1,
+               float x_2,
+               float y_2,
+               float s_1,
+               float t_1,
+               float s_2,
+               float t_2)
+{
+  CoglVirtualTextureLevel *level = virtual_texture->levels + slot->level;
+  int slot_num = slot - virtual_texture->slots;
+  int slot_size = virtual_texture->tile_size + 2;
+  float cache_width = cogl_texture_get_width (virtual_texture->cache_texture);
+  float cache_height =
+    cogl_texture_get_height (virtual_texture->cache_texture);
+  /* Position of the slot in the cache texture including the border */
+  float slot_x = (slot_num % virtual_texture->slots_per_row) * slot_size;
+  float slot_y = (slot_num / virtual_texture->slots_per_row) * slot_size;
+  /* Position in the cache texture of the origin of the level */
+  float origin_x = slot_x + 1 - slot->tile_x * virtual_texture->tile_size;
+  float origin_y = slot_y + 1 - slot->tile_y * virtual_texture->tile_size;
+  int width, height;
+  float *coords;
+
+  get_tile_size (virtual_texture,
+                 slot->level,
+                 slot->tile_x,
+                 slot->tile_y,
+                 &width, &height);
+
+  g_array_set_size (virtual_texture->rectangles,
+                    virtual_texture->rectangles->len + 8);
+  coords = &g_array_index (virtual_texture->rectangles,
+                           float,
+                           virtual_texture->rectangles->len - 8);
+
+  coords[0] = x_1;
+  coords[1] = y_1;
+  coords[2] = x_2;
+  coords[3] = y_2;
+
+  /* When drawing from a coarser tile of an image that isn't a power
+     of two the tile doesn't exactly cover the area so the
+     coordinates are clamped to the slot */
+  coords[4] = CLAMP (origin_x + s_1 * level->width,
+                     slot_x, slot_x + width + 2) / cache_width;
+  coords[5] = CLAMP (origin_y + t_1 * level->height,
+                     slot_y, slot_y + height + 2) / cache_height;
+  coords[6] = CLAMP (origin_x + s_2 * level->width,
+                     slot_x, slot_x + width + 2) / cache_width;
+  coords[7] = CLAMP (origin_y + t_2 * level->height,
+                     slot_y, slot_y + height + 2) / cache_height;
+}
+
+static CoglPipelineFilter
+get_non_mipmap_filter (CoglPipelineFilter filter)
+{
+  switch (filter)
+    {
+    case COGL_PIPELINE_FILTER_NEAREST:
+    case COGL_PIPELINE_FILTER_NEAREST_MIPMAP_NEAREST:
+    case COGL_PIPELINE_FILTER_NEAREST_MIPMAP_LINEAR:
+      return COGL_PIPELINE_FILTER_NEAREST;
+
+    case COGL_PIPELINE_FILTER_LINEAR:
+    case COGL_PIPELINE_FILTER_LINEAR_MIPMAP_NEAREST:
+    case COGL_PIPELINE_FILTER_LINEAR_MIPMAP_LINEAR:
+      return COGL_PIPELINE_FILTER_LINEAR;
+    }
+
+  g_return_val_if_reached (COGL_PIPELINE_FILTER_LINEAR);
+}
+
+void
+cogl_virtual_texture_draw (CoglVirtualTexture *virtual_texture,
+                           CoglFramebuffer *framebuffer,
+                           CoglPipeline *pipeline,
+                           float x_1,
+                           float y_1,
+                           float x_2,
+                           float y_2,
+                           float s_1,
+                           float t_1,
+                           float s_2,
+                           float t_2)
+{
+  int tile_size = virtual_texture->tile_size;
+  CoglVirtualTextureLevel *level;
+  CoglPipeline *draw_pipeline;
+  int first_tile_x, first_tile_y;
+  int last_tile_x, last_tile_y;
+  int level_num;
+  int tile_x, tile_y;
+  float tmp;
+
+  _COGL_RETURN_IF_FAIL (cogl_is_virtual_texture (virtual_texture));
+
+  /* Make sure the coordinates are increasing so that the tiles can
+     be clipped against them */
+  if (s_1 > s_2)
+    {
+      tmp = s_1; s_1 = s_2; s_2 = tmp;
+      tmp = x_1; x_1 = x_2; x_2 = tmp;
+    }
+  if (t_1 > t_2)
+    {
+      tmp = t_1; t_1 = t_2; t_2 = tmp;
+      tmp = y_1; y_1 = y_2; y_2 = tmp;
+    }
+
+  _COGL_RETURN_IF_FAIL (s_1 >= 0.0f && s_2 <= 1.0f);
+  _COGL_RETURN_IF_FAIL (t_1 >= 0.0f && t_2 <= 1.0f);
+
+  if (s_1 == s_2 || t_1 == t_2)
+    return;
+
+  /* This will abort if the cache can't be allocated. The application
+     can call cogl_virtual_texture_allocate() itself to catch this */
+  cogl_virtual_texture_allocate (virtual_texture, NULL);
+
+  virtual_texture->draw_count++;
+
+  /* Tiles that were loaded since the last draw can be used straight
+     away */
+  upload_finished_loads (virtual_texture);
+
+  /* The top of the pyramid is the fallback for everything else so
+     until it is resident there is nothing to draw. This is the only
+     load that a draw waits for and it is done before starting any
+     others so that they can't hold it up */
+  if (*get_page_table_entry (virtual_texture,
+                             virtual_texture->n_levels - 1,
+                             0, 0) == -1)
+    load_top_tile (virtual_texture);
+
+  level_num = choose_level (virtual_texture,
+                            framebuffer,
+                            x_1, y_1, x_2, y_2,
+                            s_1, t_1, s_2, t_2);
+  level = virtual_texture->levels + level_num;
+
+  first_tile_x = s_1 * level->width / tile_size;
+  first_tile_y = t_1 * level->height / tile_size;
+  last_tile_x = ceilf (s_2 * level->width / tile_size) - 1;
+  last_tile_y = ceilf (t_2 * level->height / tile_size) - 1;
+  first_tile_x = CLAMP (first_tile_x, 0, level->n_tiles_x - 1);
+  first_tile_y = CLAMP (first_tile_y, 0, level->n_tiles_y - 1);
+  last_tile_x = CLAMP (last_tile_x, first_tile_x, level->n_tiles_x - 1);
+  last_tile_y = CLAMP (last_tile_y, first_tile_y, level->n_tiles_y - 1);
+
+  /* The texture coordinates of the draw are the feedback for which
+     tiles need to be resident. The tiles that are already resident
+     or that will be drawn in their place are marked as used so that
+     loading doesn't evict them */
+  g_array_set_size (virtual_texture->queued_tiles, 0);
+
+  for (tile_y = first_tile_y; tile_y <= last_tile_y; tile_y++)
+    for (tile_x = first_tile_x; tile_x <= last_tile_x; tile_x++)
+      {
+        CoglVirtualTextureSlot *slot =
+          find_resident_tile (virtual_texture, level_num, tile_x, tile_y);
+
+        if (slot == NULL ||
+            slot->level != level_num)
+          queue_tile (virtual_texture, level_num, tile_x, tile_y);
+
+        if (slot)
+          touch_slot (virtual_texture, slot);
+      }
+
+  start_loads (virtual_texture);
+
+  g_array_set_size (virtual_texture->rectangles, 0);
+
+  for (tile_y = first_tile_y; tile_y <= last_tile_y; tile_y++)
+    for (tile_x = first_tile_x; tile_x <= last_tile_x; tile_x++)
+      {
+        CoglVirtualTextureSlot *slot =
+          find_resident_tile (virtual_texture, level_num, tile_x, tile_y);
+        /* The part of the draw covered by this tile */
+        float tile_s_1 = MAX (s_1, tile_x * tile_size / (float) level->width);
+        float tile_t_1 = MAX (t_1,
+                              tile_y * tile_size / (float) level->height);
+        float tile_s_2 = MIN (s_2, ((tile_x + 1) * tile_size /
+                                    (float) level->width));
+        float tile_t_2 = MIN (t_2, ((tile_y + 1) * tile_size /
+                                    (float) level->height));
+
+        /* This can only happen if the loader didn't manage to provide
+           the top of the pyramid yet */
+        if (slot == NULL)
+          continue;
+
+        touch_slot (virtual_texture, slot);
+
+        add_rectangle (virtual_texture,
+                       slot,
+                       x_1 + (tile_s_1 - s_1) * (x_2 - x_1) / (s_2 - s_1),
+                       y_1 + (tile_t_1 - t_1) * (y_2 - y_1) / (t_2 - t_1),
+                       x_1 + (tile_s_2 - s_1) * (x_2 - x_1) / (s_2 - s_1),
+                       y_1 + (tile_t_2 - t_1) * (y_2 - y_1) / (t_2 - t_1),
+                       tile_s_1, tile_t_1,
+                       tile_s_2, tile_t_2);
+      }
+
+  if (virtual_texture->rectangles->len == 0)
+    return;
+
+  draw_pipeline = cogl_pipeline_copy (pipeline);
+
+  cogl_pipeline_set_layer_texture (draw_pipeline,
+                                   0,
+                                   virtual_texture->cache_texture);
+  cogl_pipeline_set_layer_wrap_mode (draw_pipeline,
+                                     0,
+                                     COGL_PIPELINE_WRAP_MODE_CLAMP_TO_EDGE);
+  /* The cache texture doesn't have any meaningful mipmaps */
+  cogl_pipeline_set_layer_filters
+    (draw_pipeline,
+     0,
+     get_non_mipmap_filter (cogl_pipeline_get_layer_min_filter (draw_pipeline,
+                                                                0)),
+     cogl_pipeline_get_layer_mag_filter (draw_pipeline, 0));
+
+  cogl_framebuffer_draw_textured_rectangles (framebuffer,
+                                             draw_pipeline,
+                                             &g_array_index (virtual_texture->
+                                                             rectangles,
+                                                             float, 0),
+                                             virtual_texture->rectangles->len /
+                                             8);
+
+  cogl_object_unref (draw_pipeline);
+}
@@ -0,0 +1,329 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#if !defined(__COGL_H_INSIDE__) && !defined(COGL_COMPILATION)
+#error "Only <cogl/cogl.h> can be included directly."
+#endif
+
+#ifndef __COGL_VIRTUAL_TEXTURE_H__
+#define __COGL_VIRTUAL_TEXTURE_H__
+
+#include <cogl/cogl-types.h>
+#include <cogl/cogl-context.h>
+#include <cogl/cogl-framebuffer.h>
+#include <cogl/cogl-pipeline.h>
+
+COGL_BEGIN_DECLS
+
+/**
+ * SECTION:cogl-virtual-texture
+ * @short_description: Functions for drawing images that are streamed
+ *                     in tiles on demand
+ *
+ * A #CoglVirtualTexture represents an image that is too large to keep
+ * in GPU memory all at once. The image is split into a pyramid of
+ * square tiles where each level of the pyramid is half the size of
+ * the one below it, in the same way as a mipmap. The pixels of a tile
+ * are only requested from the application when a draw actually needs
+ * them. The tiles that have been loaded are kept in a fixed-size cache
+ * texture and the least recently used ones are evicted when space is
+ * needed for new tiles.
+ *
+ * Each call to cogl_virtual_texture_draw() works out which level of
+ * the pyramid best matches the on-screen size of the rectangle and
+ * which tiles of that level the texture coordinates cover. Any of
+ * those tiles that aren't in the cache are loaded by calling the
+ * #CoglVirtualTextureLoader from a pool of worker threads. The draw
+ * doesn't wait for the loads. Instead the tiles that have finished
+ * loading are uploaded to the cache texture by a later draw, going
+ * through a #CoglPixelBuffer so that on drivers that support it the
+ * upload doesn't need to stall waiting for the data to be copied.
+ * Only a limited number of tiles are loaded at once so that a sudden
+ * change of view doesn't flood the cache. Until a tile has been
+ * uploaded the region it covers is drawn from the nearest coarser
+ * level of the pyramid that is in the cache. The single tile at the
+ * top of the pyramid is always loaded first and is never evicted so
+ * there is always something to draw. This is the only tile that a
+ * draw will wait for.
+ */
+
+/**
+ * CoglVirtualTexture:
+ *
+ * An opaque object representing a tiled image that is streamed into
+ * a cache texture on demand.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef struct _CoglVirtualTexture CoglVirtualTexture;
+
+/**
+ * CoglVirtualTextureLoader:
+ * @level: The level of the tile pyramid where 0 is the full
+ *   resolution image
+ * @tile_x: The horizontal index of the tile within the level
+ * @tile_y: The vertical index of the tile within the level
+ * @width: The width of the tile in pixels. This is the tile size
+ *   except for the tiles on the right edge of a level.
+ * @height: The height of the tile in pixels. This is the tile size
+ *   except for the tiles on the bottom edge of a level.
+ * @data: The location to write the pixels to in the format passed to
+ *   cogl_virtual_texture_new()
+ * @rowstride: The number of bytes between the start of each row in
+ *   @data
+ * @user_data: The private data passed to cogl_virtual_texture_new()
+ *
+ * The callback prototype used to fetch the pixels of a tile. The tile
+ * covers the pixels starting at (@tile_x × tile size, @tile_y × tile
+ * size) of the level. A level is half the size of the level below it
+ * rounded down but never smaller than one pixel.
+ *
+ * The callback is invoked from worker threads and several tiles may
+ * be loaded concurrently so it must be thread-safe and it must not
+ * call any Cogl functions.
+ *
+ * Return value: %TRUE if @data was filled in or %FALSE if the tile
+ *   isn't available yet. If %FALSE is returned the tile will be
+ *   requested again the next time it is drawn.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+typedef CoglBool (* CoglVirtualTextureLoader) (int level,
+                                               int tile_x,
+                                               int tile_y,
+                                               int width,
+                                               int height,
+                                               uint8_t *data,
+                                               int rowstride,
+                                               void *user_data);
+
+/**
+ * cogl_virtual_texture_new:
+ * @context: A #CoglContext
+ * @width: The width of the full resolution image in pixels
+ * @height: The height of the full resolution image in pixels
+ * @tile_size: The width and height of each tile in pixels
+ * @format: The #CoglPixelFormat of the data written by @loader
+ * @loader: (scope notified): A #CoglVirtualTextureLoader to fetch the
+ *   pixels of each tile
+ * @user_data: (closure): Private data to pass to @loader
+ *
+ * Creates a new #CoglVirtualTexture. No tiles are loaded and the
+ * cache texture isn't created until the texture is first drawn or
+ * cogl_virtual_texture_allocate() is called.
+ *
+ * Return value: (transfer full): A newly allocated #CoglVirtualTexture
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglVirtualTexture *
+cogl_virtual_texture_new (CoglContext *context,
+                          int width,
+                          int height,
+                          int tile_size,
+                          CoglPixelFormat format,
+                          CoglVirtualTextureLoader loader,
+                          void *user_data);
+
+/**
+ * cogl_virtual_texture_set_cache_size:
+ * @virtual_texture: A #CoglVirtualTexture
+ * @n_tiles: The number of tiles that can be resident at once
+ *
+ * Sets how many tiles the cache texture can hold. The default is 64.
+ * This can only be called before the texture is allocated.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_virtual_texture_set_cache_size (CoglVirtualTexture *virtual_texture,
+                                     int n_tiles);
+
+/**
+ * cogl_virtual_texture_get_cache_size:
+ * @virtual_texture: A #CoglVirtualTexture
+ *
+ * Return value: The number of tiles that can be resident at once.
+ * Since: 2.0
+ * Stability: Unstable
+ */
+int
+cogl_virtual_texture_get_cache_size (CoglVirtualTexture *virtual_texture);
+
+/**
+ * cogl_virtual_texture_set_max_loads_per_draw:
+ * @virtual_texture: A #CoglVirtualTexture
+ * @n_tiles: The maximum number of tiles to load at once
+ *
+ * Limits the number of tiles that can be loading at the same time.
+ * A call to cogl_virtual_texture_draw() doesn't start any more loads
+ * once this many are in flight. Tiles beyond the limit are drawn from
+ * a coarser level and are loaded by later draws. The default is 8.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_virtual_texture_set_max_loads_per_draw (CoglVirtualTexture *virtual_texture,
+                                             int n_tiles);
+
+/**
+ * cogl_virtual_texture_get_max_loads_per_draw:
+ * @virtual_texture: A #CoglVirtualTexture
+ *
+ * Return value: The maximum number of tiles that will be loaded at
+ *   once.
+ * Since: 2.0
+ * Stability: Unstable
+ */
+int
+cogl_virtual_texture_get_max_loads_per_draw (CoglVirtualTexture *virtual_texture);
+
+/**
+ * cogl_virtual_texture_get_n_levels:
+ * @virtual_texture: A #CoglVirtualTexture
+ *
+ * Return value: The number of levels in the tile pyramid. The last
+ *   level always fits in a single tile.
+ * Since: 2.0
+ * Stability: Unstable
+ */
+int
+cogl_virtual_texture_get_n_levels (CoglVirtualTexture *virtual_texture);
+
+/**
+ * cogl_virtual_texture_get_n_resident_tiles:
+ * @virtual_texture: A #CoglVirtualTexture
+ *
+ * Return value: The number of tiles that are currently in the cache.
+ * Since: 2.0
+ * Stability: Unstable
+ */
+int
+cogl_virtual_texture_get_n_resident_tiles (CoglVirtualTexture *virtual_texture);
+
+/**
+ * cogl_virtual_texture_allocate:
+ * @virtual_texture: A #CoglVirtualTexture
+ * @error: A #CoglError to return exceptional errors or %NULL
+ *
+ * Explicitly creates the cache texture and the staging buffer. This
+ * would otherwise be done lazily by the first draw. Calling this
+ * explicitly lets the application handle the case where the cache is
+ * too large for the GPU.
+ *
+ * Return value: %TRUE if the cache was allocated successfully and
+ *   %FALSE otherwise.
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglBool
+cogl_virtual_texture_allocate (CoglVirtualTexture *virtual_texture,
+                               CoglError **error);
+
+/**
+ * cogl_virtual_texture_wait_for_loads:
+ * @virtual_texture: A #CoglVirtualTexture
+ *
+ * Blocks until all of the tiles that are being loaded have finished
+ * and uploads them to the cache texture so that the next draw can
+ * use them. This can be used to get a complete image for the first
+ * frame after a change of view at the cost of a stall.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_virtual_texture_wait_for_loads (CoglVirtualTexture *virtual_texture);
+
+/**
+ * cogl_virtual_texture_draw:
+ * @virtual_texture: A #CoglVirtualTexture
+ * @framebuffer: The destination #CoglFramebuffer
+ * @pipeline: A #CoglPipeline to draw with
+ * @x_1: x coordinate upper left on screen.
+ * @y_1: y coordinate upper left on screen.
+ * @x_2: x coordinate lower right on screen.
+ * @y_2: y coordinate lower right on screen.
+ * @s_1: S texture coordinate of the top-left corner
+ * @t_1: T texture coordinate of the top-left corner
+ * @s_2: S texture coordinate of the bottom-right corner
+ * @t_2: T texture coordinate of the bottom-right corner
+ *
+ * Draws a rectangle textured with the given region of the virtual
+ * texture. The texture coordinates must be in the range [0,1]. The
+ * texture of the first layer of @pipeline is replaced with the cache
+ * texture but the rest of the pipeline state is used as is. The
+ * rectangle is split into one rectangle per tile and they are all
+ * drawn with a single call to
+ * cogl_framebuffer_draw_textured_rectangles().
+ *
+ * Any tiles of the chosen level that aren't resident start loading
+ * in the background, up to the limit set with
+ * cogl_virtual_texture_set_max_loads_per_draw(), and are drawn from
+ * a coarser level this time. Tiles that finished loading since the
+ * previous draw are uploaded before drawing.
+ *
+ * Since: 2.0
+ * Stability: Unstable
+ */
+void
+cogl_virtual_texture_draw (CoglVirtualTexture *virtual_texture,
+                           CoglFramebuffer *framebuffer,
+                           CoglPipeline *pipeline,
+                           float x_1,
+                           float y_1,
+                           float x_2,
+                           float y_2,
+                           float s_1,
+                           float t_1,
+                           float s_2,
+                           float t_2);
+
+/**
+ * cogl_is_virtual_texture:
+ * @object: A #CoglObject pointer
+ *
+ * Gets whether the given object references a #CoglVirtualTexture.
+ *
+ * Return value: %TRUE if the object references a #CoglVirtualTexture
+ *   and %FALSE otherwise.
+ * Since: 2.0
+ * Stability: Unstable
+ */
+CoglBool
+cogl_is_virtual_texture (void *object);
+
+COGL_END_DECLS
+
+#endif /* __COGL_VIRTUAL_TEXTURE_H__ */
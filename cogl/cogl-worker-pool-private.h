@@ -0,0 +1,132 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifndef __COGL_WORKER_POOL_PRIVATE_H
+#define __COGL_WORKER_POOL_PRIVATE_H
+
+#include <glib.h>
+
+/*
+ * CoglWorkerPool is a small pool of threads that Cogl can use to
+ * spread CPU-only work such as image encoding over multiple cores.
+ * None of the work run on the pool may touch the GL context.
+ *
+ * When Cogl is built without GLib support there are no threads
+ * available so the work is simply run synchronously in the calling
+ * thread.
+ */
+typedef struct _CoglWorkerPool CoglWorkerPool;
+typedef struct _CoglWorkerJob CoglWorkerJob;
+
+typedef void (* CoglWorkerFunc) (int index, void *user_data);
+
+CoglWorkerPool *
+_cogl_worker_pool_new (void);
+
+void
+_cogl_worker_pool_free (CoglWorkerPool *pool);
+
+/*
+ * _cogl_worker_pool_get_n_threads:
+ * @pool: A #CoglWorkerPool
+ *
+ * Returns: the number of threads that can run work concurrently,
+ *   including the calling thread. This is 1 if threads aren't
+ *   available.
+ */
+int
+_cogl_worker_pool_get_n_threads (CoglWorkerPool *pool);
+
+/*
+ * _cogl_worker_pool_run:
+ * @pool: A #CoglWorkerPool
+ * @n_items: The number of work items
+ * @func: A function to call once for each item
+ * @user_data: Private data to pass to @func
+ *
+ * Calls @func once for every index in the range [0, @n_items),
+ * potentially from several threads at the same time. The calling
+ * thread also takes part in the work and the function doesn't return
+ * until all of the items have been processed.
+ */
+void
+_cogl_worker_pool_run (CoglWorkerPool *pool,
+                       int n_items,
+                       CoglWorkerFunc func,
+                       void *user_data);
+
+/*
+ * _cogl_worker_pool_push:
+ * @pool: A #CoglWorkerPool
+ * @func: A function to call once with an index of 0
+ * @user_data: Private data to pass to @func
+ *
+ * Queues @func to be called from a background thread and returns
+ * without waiting for it. The jobs use their own threads so they
+ * don't hold up _cogl_worker_pool_run(). If threads aren't available
+ * @func is called before this returns.
+ *
+ * Returns: a #CoglWorkerJob which must be freed with
+ *   _cogl_worker_job_free()
+ */
+CoglWorkerJob *
+_cogl_worker_pool_push (CoglWorkerPool *pool,
+                        CoglWorkerFunc func,
+                        void *user_data);
+
+/*
+ * _cogl_worker_job_is_done:
+ * @job: A #CoglWorkerJob
+ *
+ * Returns: %TRUE if the function of @job has returned. Anything it
+ *   wrote can then be read from the calling thread.
+ */
+CoglBool
+_cogl_worker_job_is_done (CoglWorkerJob *job);
+
+/*
+ * _cogl_worker_job_wait:
+ * @job: A #CoglWorkerJob
+ *
+ * Blocks until the function of @job has returned.
+ */
+void
+_cogl_worker_job_wait (CoglWorkerJob *job);
+
+/*
+ * _cogl_worker_job_free:
+ * @job: A #CoglWorkerJob
+ *
+ * Waits for @job to finish if it hasn't already and frees it.
+ */
+void
+_cogl_worker_job_free (CoglWorkerJob *job);
+
+#endif /* __COGL_WORKER_POOL_PRIVATE_H */
@@ -0,0 +1,352 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-util.h"
+
+#include "cogl-worker-pool-private.h"
+
+#ifdef COGL_HAS_GLIB_SUPPORT
+
+/* Used when the number of processors can't be queried */
+#define COGL_WORKER_POOL_DEFAULT_THREADS 4
+
+struct _CoglWorkerPool
+{
+  GThreadPool *thread_pool;
+  int n_threads;
+
+  /* Threads for the jobs queued with _cogl_worker_pool_push(). These
+     are kept separate so that a batch never has to wait behind a
+     long running job */
+  GThreadPool *job_pool;
+};
+
+struct _CoglWorkerJob
+{
+  CoglWorkerFunc func;
+  void *user_data;
+
+  /* This is protected by the mutex */
+  CoglBool done;
+  GMutex mutex;
+  GCond cond;
+};
+
+typedef struct
+{
+  CoglWorkerFunc func;
+  void *user_data;
+  int n_items;
+
+  /* The next item that hasn't been claimed yet. This is accessed
+     atomically */
+  volatile int next_item;
+
+  /* The number of helper threads that haven't finished yet. This is
+     protected by the mutex */
+  int n_running;
+  GMutex mutex;
+  GCond cond;
+} CoglWorkerBatch;
+
+static void
+run_batch_items (CoglWorkerBatch *batch)
+{
+  while (TRUE)
+    {
+      int item = g_atomic_int_add (&batch->next_item, 1);
+
+      if (item >= batch->n_items)
+        break;
+
+      batch->func (item, batch->user_data);
+    }
+}
+
+static void
+worker_thread_cb (void *data,
+                  void *user_data)
+{
+  CoglWorkerBatch *batch = data;
+
+  run_batch_items (batch);
+
+  g_mutex_lock (&batch->mutex);
+  if (--batch->n_running == 0)
+    g_cond_signal (&batch->cond);
+  g_mutex_unlock (&batch->mutex);
+}
+
+static void
+job_thread_cb (void *data,
+               void *user_data)
+{
+  CoglWorkerJob *job = data;
+
+  job->func (0, job->user_data);
+
+  g_mutex_lock (&job->mutex);
+  job->done = TRUE;
+  g_cond_broadcast (&job->cond);
+  g_mutex_unlock (&job->mutex);
+}
+
+CoglWorkerPool *
+_cogl_worker_pool_new (void)
+{
+  CoglWorkerPool *pool = g_slice_new (CoglWorkerPool);
+
+#if GLIB_CHECK_VERSION (2, 36, 0)
+  pool->n_threads = g_get_num_processors ();
+#else
+  pool->n_threads = COGL_WORKER_POOL_DEFAULT_THREADS;
+#endif
+
+  /* The calling thread also runs work so the pool itself only needs
+     one less thread than the number of processors */
+  if (pool->n_threads > 1)
+    pool->thread_pool = g_thread_pool_new (worker_thread_cb,
+                                           NULL, /* user_data */
+                                           pool->n_threads - 1,
+                                           FALSE, /* not exclusive */
+                                           NULL /* error */);
+  else
+    pool->thread_pool = NULL;
+
+  if (pool->thread_pool == NULL)
+    pool->n_threads = 1;
+
+  /* The caller doesn't wait for jobs so they get a thread even on a
+     single processor */
+  pool->job_pool = g_thread_pool_new (job_thread_cb,
+                                      NULL, /* user_data */
+                                      pool->n_threads,
+                                      FALSE, /* not exclusive */
+                                      NULL /* error */);
+
+  return pool;
+}
+
+void
+_cogl_worker_pool_free (CoglWorkerPool *pool)
+{
+  if (pool->thread_pool)
+    g_thread_pool_free (pool->thread_pool,
+                        FALSE, /* don't drop queued work */
+                        TRUE /* wait */);
+  if (pool->job_pool)
+    g_thread_pool_free (pool->job_pool,
+                        FALSE, /* don't drop queued work */
+                        TRUE /* wait */);
+
+  g_slice_free (CoglWorkerPool, pool);
+}
+
+int
+_cogl_worker_pool_get_n_threads (CoglWorkerPool *pool)
+{
+  return pool->n_threads;
+}
+
+void
+_cogl_worker_pool_run (CoglWorkerPool *pool,
+                       int n_items,
+                       CoglWorkerFunc func,
+                       void *user_data)
+{
+  CoglWorkerBatch batch;
+  int n_helpers, i;
+
+  n_helpers = MIN (pool->n_threads, n_items) - 1;
+
+  /* Don't bother with the thread pool if there's no way to split up
+     the work */
+  if (n_helpers <= 0)
+    {
+      for (i = 0; i < n_items; i++)
+        func (i, user_data);
+      return;
+    }
+
+  batch.func = func;
+  batch.user_data = user_data;
+  batch.n_items = n_items;
+  batch.next_item = 0;
+  batch.n_running = n_helpers;
+  g_mutex_init (&batch.mutex);
+  g_cond_init (&batch.cond);
+
+  for (i = 0; i < n_helpers; i++)
+    g_thread_pool_push (pool->thread_pool, &batch, NULL);
+
+  run_batch_items (&batch);
+
+  /* The batch lives on our stack so we need to wait for all of the
+     helpers to stop touching it before returning, even if they
+     didn't end up running any items */
+  g_mutex_lock (&batch.mutex);
+  while (batch.n_running > 0)
+    g_cond_wait (&batch.cond, &batch.mutex);
+  g_mutex_unlock (&batch.mutex);
+
+  g_mutex_clear (&batch.mutex);
+  g_cond_clear (&batch.cond);
+}
+
+CoglWorkerJob *
+_cogl_worker_pool_push (CoglWorkerPool *pool,
+                        CoglWorkerFunc func,
+                        void *user_data)
+{
+  CoglWorkerJob *job = g_slice_new (CoglWorkerJob);
+
+  job->func = func;
+  job->user_data = user_data;
+  job->done = FALSE;
+  g_mutex_init (&job->mutex);
+  g_cond_init (&job->cond);
+
+  if (pool->job_pool)
+    g_thread_pool_push (pool->job_pool, job, NULL);
+  else
+    {
+      func (0, user_data);
+      job->done = TRUE;
+    }
+
+  return job;
+}
+
+CoglBool
+_cogl_worker_job_is_done (CoglWorkerJob *job)
+{
+  CoglBool done;
+
+  g_mutex_lock (&job->mutex);
+  done = job->done;
+  g_mutex_unlock (&job->mutex);
+
+  return done;
+}
+
+void
+_cogl_worker_job_wait (CoglWorkerJob *job)
+{
+  g_mutex_lock (&job->mutex);
+  while (!job->done)
+    g_cond_wait (&job->cond, &job->mutex);
+  g_mutex_unlock (&job->mutex);
+}
+
+void
+_cogl_worker_job_free (CoglWorkerJob *job)
+{
+  _cogl_worker_job_wait (job);
+
+  g_mutex_clear (&job->mutex);
+  g_cond_clear (&job->cond);
+
+  g_slice_free (CoglWorkerJob, job);
+}
+
+#else /* COGL_HAS_GLIB_SUPPORT */
+
+struct _CoglWorkerPool
+{
+  int dummy;
+};
+
+struct _CoglWorkerJob
+{
+  int dummy;
+};
+
+CoglWorkerPool *
+_cogl_worker_pool_new (void)
+{
+  return g_slice_new (CoglWorkerPool);
+}
+
+void
+_cogl_worker_pool_free (CoglWorkerPool *pool)
+{
+  g_slice_free (CoglWorkerPool, pool);
+}
+
+int
+_cogl_worker_pool_get_n_threads (CoglWorkerPool *pool)
+{
+  return 1;
+}
+
+void
+_cogl_worker_pool_run (CoglWorkerPool *pool,
+                       int n_items,
+                       CoglWorkerFunc func,
+                       void *user_data)
+{
+  int i;
+
+  for (i = 0; i < n_items; i++)
+    func (i, user_data);
+}
+
+CoglWorkerJob *
+_cogl_worker_pool_push (CoglWorkerPool *pool,
+                        CoglWorkerFunc func,
+                        void *user_data)
+{
+  func (0, user_data);
+
+  return g_slice_new (CoglWorkerJob);
+}
+
+CoglBool
+_cogl_worker_job_is_done (CoglWorkerJob *job)
+{
+  return TRUE;
+}
+
+void
+_cogl_worker_job_wait (CoglWorkerJob *job)
+{
+}
+
+void
+_cogl_worker_job_free (CoglWorkerJob *job)
+{
+  g_slice_free (CoglWorkerJob, job);
+}
+
+#endif /* COGL_HAS_GLIB_SUPPORT */
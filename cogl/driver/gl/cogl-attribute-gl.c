@@ -47,7 +47,9 @@
 #include "cogl-attribute-private.h"
 #include "cogl-attribute-gl-private.h"
 #include "cogl-pipeline-progend-glsl-private.h"
+#include "cogl-pipeline-state-private.h"
 #include "cogl-buffer-gl-private.h"
+#include "cogl-clip-stack-gl-private.h"
 
 typedef struct _ForeachChangedBitState
 {
@@ -134,6 +136,20 @@ toggle_custom_attribute_enabled_cb (int bit_num, void *user_data)
   return TRUE;
 }
 
+static CoglBool
+reset_attribute_divisor_cb (int bit_num, void *user_data)
+{
+  ForeachChangedBitState *state = user_data;
+  CoglContext *context = state->context;
+
+  /* Locations that still have a divisor were already updated when
+   * the attribute pointer was set */
+  if (!_cogl_bitmask_get (state->new_bits, bit_num))
+    GE( context, glVertexAttribDivisor (bit_num, 0) );
+
+  return TRUE;
+}
+
 static void
 foreach_changed_bit_and_save (CoglContext *context,
                               CoglBitmask *current_bits,
@@ -180,6 +196,15 @@ setup_generic_buffered_attribute (CoglContext *context,
                                       base + attribute->d.buffered.offset) );
   _cogl_bitmask_set (&context->enable_custom_attributes_tmp,
                      attrib_location, TRUE);
+
+  if (attribute->d.buffered.instance_divisor != 0)
+    {
+      GE( context,
+          glVertexAttribDivisor (attrib_location,
+                                 attribute->d.buffered.instance_divisor) );
+      _cogl_bitmask_set (&context->instanced_attributes_tmp,
+                         attrib_location, TRUE);
+    }
 }
 
 static void
@@ -389,6 +414,16 @@ apply_attribute_enable_updates (CoglContext *context,
                                 &context->enable_custom_attributes_tmp,
                                 toggle_custom_attribute_enabled_cb,
                                 &changed_bits_state);
+
+  if (cogl_has_feature (context, COGL_FEATURE_ID_INSTANCED_DRAWING))
+    {
+      changed_bits_state.new_bits = &context->instanced_attributes_tmp;
+      foreach_changed_bit_and_save (context,
+                                    &context->instanced_attributes,
+                                    &context->instanced_attributes_tmp,
+                                    reset_attribute_divisor_cb,
+                                    &changed_bits_state);
+    }
 }
 
 void
@@ -403,6 +438,7 @@ _cogl_gl_flush_attributes_state (CoglFramebuffer *framebuffer,
   int i;
   CoglBool with_color_attrib = FALSE;
   CoglBool unknown_color_alpha = FALSE;
+  CoglBool builtin_instanced_attrib = FALSE;
   CoglPipeline *copy = NULL;
 
   /* Iterate the attributes to see if we have a color attribute which
@@ -410,18 +446,45 @@ _cogl_gl_flush_attributes_state (CoglFramebuffer *framebuffer,
    *
    * We need to do this before flushing the pipeline. */
   for (i = 0; i < n_attributes; i++)
-    switch (attributes[i]->name_state->name_id)
-      {
-      case COGL_ATTRIBUTE_NAME_ID_COLOR_ARRAY:
-        if ((flags & COGL_DRAW_COLOR_ATTRIBUTE_IS_OPAQUE) == 0 &&
-            _cogl_attribute_get_n_components (attributes[i]) == 4)
-          unknown_color_alpha = TRUE;
-        with_color_attrib = TRUE;
-        break;
+    {
+      switch (attributes[i]->name_state->name_id)
+        {
+        case COGL_ATTRIBUTE_NAME_ID_COLOR_ARRAY:
+          if ((flags & COGL_DRAW_COLOR_ATTRIBUTE_IS_OPAQUE) == 0 &&
+              _cogl_attribute_get_n_components (attributes[i]) == 4)
+            unknown_color_alpha = TRUE;
+          with_color_attrib = TRUE;
+          break;
 
-      default:
-        break;
-      }
+        default:
+          break;
+        }
+
+      if (attributes[i]->is_buffered &&
+          attributes[i]->d.buffered.instance_divisor != 0 &&
+          attributes[i]->name_state->name_id !=
+          COGL_ATTRIBUTE_NAME_ID_CUSTOM_ARRAY)
+        builtin_instanced_attrib = TRUE;
+    }
+
+  /* If the clip is implemented in the fragment shader then we need to
+   * use a derived pipeline with a snippet */
+  pipeline = _cogl_clip_stack_gl_get_shader_clip_pipeline (ctx, pipeline);
+
+  /* The builtin attributes of the fixed function pipeline can't have
+   * a divisor so if any are per-instance then we force the pipeline
+   * to use GLSL by adding an empty vertex snippet */
+  if (G_UNLIKELY (builtin_instanced_attrib) &&
+      !_cogl_pipeline_has_vertex_snippets (pipeline))
+    {
+      if (ctx->instanced_attributes_snippet == NULL)
+        ctx->instanced_attributes_snippet =
+          cogl_snippet_new (COGL_SNIPPET_HOOK_VERTEX, NULL, NULL);
+
+      copy = cogl_pipeline_copy (pipeline);
+      pipeline = copy;
+      cogl_pipeline_add_snippet (pipeline, ctx->instanced_attributes_snippet);
+    }
 
   if (G_UNLIKELY (layers_state->options.flags))
     {
@@ -476,6 +539,7 @@ _cogl_gl_flush_attributes_state (CoglFramebuffer *framebuffer,
   _cogl_bitmask_clear_all (&ctx->enable_builtin_attributes_tmp);
   _cogl_bitmask_clear_all (&ctx->enable_texcoord_attributes_tmp);
   _cogl_bitmask_clear_all (&ctx->enable_custom_attributes_tmp);
+  _cogl_bitmask_clear_all (&ctx->instanced_attributes_tmp);
 
   /* Bind the attribute pointers. We need to do this after the
    * pipeline is flushed because when using GLSL that is the only
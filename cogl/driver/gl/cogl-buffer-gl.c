@@ -391,6 +391,8 @@ _cogl_buffer_gl_set_data (CoglBuffer *buffer,
 
   if (_cogl_gl_util_catch_out_of_memory (ctx, error))
     status = FALSE;
+  else
+    ctx->frame_stats.n_bytes_uploaded += size;
 
   _cogl_buffer_gl_unbind (buffer);
 
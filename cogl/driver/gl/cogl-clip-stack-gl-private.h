@@ -37,9 +37,24 @@
 #include "cogl-types.h"
 #include "cogl-framebuffer.h"
 #include "cogl-clip-stack.h"
+#include "cogl-pipeline.h"
 
 void
 _cogl_clip_stack_gl_flush (CoglClipStack *stack,
                            CoglFramebuffer *framebuffer);
 
+/*
+ * _cogl_clip_stack_gl_get_shader_clip_pipeline:
+ * @ctx: A #CoglContext
+ * @pipeline: The pipeline that is about to be flushed
+ *
+ * If the last flushed clip stack is implemented in the fragment
+ * shader then this returns a derived pipeline of @pipeline with a
+ * snippet to perform the clipping. Otherwise @pipeline is returned.
+ * The derived pipeline is owned by @pipeline.
+ */
+CoglPipeline *
+_cogl_clip_stack_gl_get_shader_clip_pipeline (CoglContext *ctx,
+                                              CoglPipeline *pipeline);
+
 #endif /* _COGL_CLIP_STACK_GL_PRIVATE_H_ */
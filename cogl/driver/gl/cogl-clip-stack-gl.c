@@ -42,6 +42,13 @@
 #include "cogl-pipeline-opengl-private.h"
 #include "cogl-clip-stack-gl-private.h"
 #include "cogl-primitive-private.h"
+#include "cogl-pipeline-state-private.h"
+#include "cogl-snippet.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <test-fixtures/test-unit.h>
 
 #ifndef GL_CLIP_PLANE0
 #define GL_CLIP_PLANE0 0x3000
@@ -421,6 +428,224 @@ disable_clip_planes (CoglContext *ctx)
   GE( ctx, glDisable (GL_CLIP_PLANE0) );
 }
 
+/* Returns whether flushing the stack will need to draw anything into
+   the stencil buffer. This needs to make the same decisions as the
+   loop in _cogl_clip_stack_gl_flush() */
+static CoglBool
+clip_stack_needs_stencil (CoglClipStack *stack,
+                          CoglBool has_clip_planes)
+{
+  CoglClipStack *entry;
+
+  for (entry = stack; entry; entry = entry->parent)
+    {
+      switch (entry->type)
+        {
+        case COGL_CLIP_STACK_PRIMITIVE:
+          return TRUE;
+        case COGL_CLIP_STACK_RECT:
+          if (!((CoglClipStackRect *) entry)->can_be_scissor)
+            {
+              if (!has_clip_planes)
+                return TRUE;
+              has_clip_planes = FALSE;
+            }
+          break;
+        case COGL_CLIP_STACK_WINDOW_RECT:
+          break;
+        }
+    }
+
+  return FALSE;
+}
+
+/* Checks whether the stencil buffer of the framebuffer already
+   contains the clip for a stack with the same contents as @stack. The
+   projection and viewport are also compared because they affect where
+   the clip entries end up in the stencil buffer */
+static CoglBool
+can_reuse_stencil_clip (CoglFramebuffer *framebuffer,
+                        CoglClipStack *stack,
+                        unsigned int hash)
+{
+  CoglMatrixStack *projection_stack =
+    _cogl_framebuffer_get_projection_stack (framebuffer);
+
+  if (framebuffer->stencil_clip_stack == NULL ||
+      framebuffer->stencil_clip_hash != hash ||
+      framebuffer->stencil_clip_viewport[0] != framebuffer->viewport_x ||
+      framebuffer->stencil_clip_viewport[1] != framebuffer->viewport_y ||
+      framebuffer->stencil_clip_viewport[2] != framebuffer->viewport_width ||
+      framebuffer->stencil_clip_viewport[3] != framebuffer->viewport_height)
+    return FALSE;
+
+  return (cogl_matrix_entry_equal (framebuffer->stencil_clip_projection,
+                                   projection_stack->last_entry) &&
+          _cogl_clip_stack_equal (framebuffer->stencil_clip_stack, stack));
+}
+
+static void
+remember_stencil_clip (CoglFramebuffer *framebuffer,
+                       CoglClipStack *stack,
+                       unsigned int hash)
+{
+  CoglMatrixStack *projection_stack =
+    _cogl_framebuffer_get_projection_stack (framebuffer);
+
+  _cogl_framebuffer_forget_stencil_clip (framebuffer);
+
+  framebuffer->stencil_clip_stack = _cogl_clip_stack_ref (stack);
+  framebuffer->stencil_clip_hash = hash;
+  framebuffer->stencil_clip_projection =
+    cogl_matrix_entry_ref (projection_stack->last_entry);
+  framebuffer->stencil_clip_viewport[0] = framebuffer->viewport_x;
+  framebuffer->stencil_clip_viewport[1] = framebuffer->viewport_y;
+  framebuffer->stencil_clip_viewport[2] = framebuffer->viewport_width;
+  framebuffer->stencil_clip_viewport[3] = framebuffer->viewport_height;
+}
+
+/* Calculates the plane equations for the four edges of the
+   rectangle in GL window coordinates so that the dot product of a
+   plane with (x, y, 1) is the distance of the fragment at (x, y) from
+   the edge and is negative when the fragment is outside. Returns
+   FALSE if any corner of the rectangle is behind the viewer in which
+   case the projected rectangle isn't a convex quad */
+static CoglBool
+get_shader_clip_planes (CoglFramebuffer *framebuffer,
+                        const CoglMatrix *projection,
+                        CoglClipStackRect *rect,
+                        float *planes)
+{
+  CoglMatrix modelview, modelview_projection;
+  float corners[4][2];
+  float area = 0.0f;
+  int i;
+
+  cogl_matrix_entry_get (rect->matrix_entry, &modelview);
+  cogl_matrix_multiply (&modelview_projection, projection, &modelview);
+
+  corners[0][0] = rect->x0; corners[0][1] = rect->y0;
+  corners[1][0] = rect->x1; corners[1][1] = rect->y0;
+  corners[2][0] = rect->x1; corners[2][1] = rect->y1;
+  corners[3][0] = rect->x0; corners[3][1] = rect->y1;
+
+  for (i = 0; i < 4; i++)
+    {
+      float z = 0.0f, w = 1.0f;
+
+      cogl_matrix_transform_point (&modelview_projection,
+                                   &corners[i][0], &corners[i][1],
+                                   &z, &w);
+
+      if (w < 1e-5f)
+        return FALSE;
+
+      /* Convert to window coordinates the same way as the scissor
+         bounds of the entry. Offscreen framebuffers are rendered
+         upside down so they don't need to be flipped */
+      corners[i][0] = ((corners[i][0] / w + 1.0f) *
+                       framebuffer->viewport_width / 2.0f +
+                       framebuffer->viewport_x);
+      corners[i][1] = ((1.0f - corners[i][1] / w) *
+                       framebuffer->viewport_height / 2.0f +
+                       framebuffer->viewport_y);
+
+      if (!cogl_is_offscreen (framebuffer))
+        corners[i][1] = cogl_framebuffer_get_height (framebuffer) -
+          corners[i][1];
+    }
+
+  for (i = 0; i < 4; i++)
+    {
+      const float *a = corners[i], *b = corners[(i + 1) % 4];
+      area += a[0] * b[1] - b[0] * a[1];
+    }
+
+  for (i = 0; i < 4; i++)
+    {
+      const float *a = corners[i], *b = corners[(i + 1) % 4];
+      float nx = a[1] - b[1];
+      float ny = b[0] - a[0];
+      float scale = sqrtf (nx * nx + ny * ny);
+
+      if (fabsf (area) < 1e-6f || scale < 1e-6f)
+        {
+          /* The rectangle has no area so everything is clipped */
+          planes[i * 3 + 0] = 0.0f;
+          planes[i * 3 + 1] = 0.0f;
+          planes[i * 3 + 2] = -1.0f;
+          continue;
+        }
+
+      /* Make the normal point inside regardless of the winding */
+      if (area < 0.0f)
+        scale = -scale;
+
+      planes[i * 3 + 0] = nx / scale;
+      planes[i * 3 + 1] = ny / scale;
+      planes[i * 3 + 2] = -(nx * a[0] + ny * a[1]) / scale;
+    }
+
+  return TRUE;
+}
+
+/* Tries to describe the clip entries that can't be implemented with
+   the scissor as planes that will be tested in the fragment shader.
+   This avoids having to touch the stencil buffer at all but it is
+   only possible if GLSL is available and all of the entries are a
+   small number of rectangles */
+static CoglBool
+setup_shader_clip (CoglFramebuffer *framebuffer,
+                   CoglClipStack *stack)
+{
+  CoglContext *ctx = framebuffer->context;
+  CoglMatrixStack *projection_stack =
+    _cogl_framebuffer_get_projection_stack (framebuffer);
+  CoglMatrix projection;
+  CoglClipStack *entry;
+  int n_rects = 0;
+
+  if (!cogl_has_feature (ctx, COGL_FEATURE_ID_GLSL) ||
+      G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_GLSL) ||
+                  COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SHADER_CLIP)))
+    return FALSE;
+
+  cogl_matrix_entry_get (projection_stack->last_entry, &projection);
+
+  for (entry = stack; entry; entry = entry->parent)
+    {
+      switch (entry->type)
+        {
+        case COGL_CLIP_STACK_PRIMITIVE:
+          return FALSE;
+        case COGL_CLIP_STACK_RECT:
+          {
+            CoglClipStackRect *rect = (CoglClipStackRect *) entry;
+
+            if (rect->can_be_scissor)
+              break;
+
+            if (n_rects >= COGL_MAX_SHADER_CLIP_RECTS ||
+                !get_shader_clip_planes (framebuffer,
+                                         &projection,
+                                         rect,
+                                         ctx->shader_clip_planes +
+                                         n_rects * 4 * 3))
+              return FALSE;
+
+            n_rects++;
+          }
+          break;
+        case COGL_CLIP_STACK_WINDOW_RECT:
+          break;
+        }
+    }
+
+  ctx->n_shader_clip_rects = n_rects;
+
+  return TRUE;
+}
+
 void
 _cogl_clip_stack_gl_flush (CoglClipStack *stack,
                            CoglFramebuffer *framebuffer)
@@ -429,6 +654,8 @@ _cogl_clip_stack_gl_flush (CoglClipStack *stack,
   int has_clip_planes;
   CoglBool using_clip_planes = FALSE;
   CoglBool using_stencil_buffer = FALSE;
+  CoglBool reuse_stencil_buffer = FALSE;
+  unsigned int stencil_hash = 0;
   int scissor_x0;
   int scissor_y0;
   int scissor_x1;
@@ -453,6 +680,7 @@ _cogl_clip_stack_gl_flush (CoglClipStack *stack,
 
   ctx->current_clip_stack_valid = TRUE;
   ctx->current_clip_stack = _cogl_clip_stack_ref (stack);
+  ctx->n_shader_clip_rects = 0;
 
   has_clip_planes =
     _cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_FOUR_CLIP_PLANES);
@@ -539,6 +767,28 @@ _cogl_clip_stack_gl_flush (CoglClipStack *stack,
                       scissor_x1 - scissor_x0,
                       scissor_y1 - scissor_y0));
 
+  if (clip_stack_needs_stencil (stack, has_clip_planes) &&
+      setup_shader_clip (framebuffer, stack))
+    {
+      COGL_NOTE (CLIPPING, "Clipping to %i rectangles in the fragment shader",
+                 ctx->n_shader_clip_rects);
+      return;
+    }
+
+  /* If the stack needs the stencil buffer then check whether the same
+     clip is already in there. This is common when a clip stack is
+     rebuilt every frame or when the clip alternates with a clip that
+     only needs the scissor */
+  if (clip_stack_needs_stencil (stack, has_clip_planes))
+    {
+      stencil_hash = _cogl_clip_stack_hash (stack);
+      reuse_stencil_buffer =
+        can_reuse_stencil_clip (framebuffer, stack, stencil_hash);
+
+      if (!reuse_stencil_buffer)
+        _cogl_framebuffer_forget_stencil_clip (framebuffer);
+    }
+
   /* Add all of the entries. This will end up adding them in the
      reverse order that they were specified but as all of the clips
      are intersecting it should work out the same regardless of the
@@ -552,6 +802,9 @@ _cogl_clip_stack_gl_flush (CoglClipStack *stack,
               CoglClipStackPrimitive *primitive_entry =
                 (CoglClipStackPrimitive *) entry;
 
+              if (reuse_stencil_buffer)
+                break;
+
               COGL_NOTE (CLIPPING, "Adding stencil clip for primitive");
 
               add_stencil_clip_primitive (framebuffer,
@@ -592,7 +845,7 @@ _cogl_clip_stack_gl_flush (CoglClipStack *stack,
                       /* We can't use clip planes a second time */
                       has_clip_planes = FALSE;
                     }
-                  else
+                  else if (!reuse_stencil_buffer)
                     {
                       COGL_NOTE (CLIPPING, "Adding stencil clip for rectangle");
 
@@ -616,8 +869,269 @@ _cogl_clip_stack_gl_flush (CoglClipStack *stack,
         }
     }
 
+  if (reuse_stencil_buffer)
+    {
+      COGL_NOTE (CLIPPING, "Reusing the stencil clip");
+
+      GE( ctx, glEnable (GL_STENCIL_TEST) );
+      GE( ctx, glStencilFunc (GL_EQUAL, 0x1, 0x1) );
+      GE( ctx, glStencilOp (GL_KEEP, GL_KEEP, GL_KEEP) );
+    }
+  else if (using_stencil_buffer)
+    remember_stencil_clip (framebuffer, stack, stencil_hash);
+
   /* Enabling clip planes is delayed to now so that they won't affect
      setting up the stencil buffer */
   if (using_clip_planes)
     enable_clip_planes (ctx);
 }
+
+/* Derived pipelines with the clip snippet are cached on the original
+   pipeline for each number of rectangles so that the program can be
+   reused. They are weak copies so they will be destroyed whenever the
+   original pipeline is modified */
+typedef struct
+{
+  CoglPipeline *pipelines[COGL_MAX_SHADER_CLIP_RECTS];
+  /* The planes that were last set as the uniform on each pipeline */
+  float planes[COGL_MAX_SHADER_CLIP_RECTS][COGL_MAX_SHADER_CLIP_RECTS * 4 * 3];
+} CoglShaderClipCache;
+
+static CoglUserDataKey shader_clip_cache_key;
+
+static void
+destroy_shader_clip_cache_cb (void *user_data)
+{
+  CoglShaderClipCache *cache = user_data;
+  int i;
+
+  /* The weak pipelines are destroyed here rather than in
+     shader_clip_pipeline_destroyed_cb because the user data is freed
+     before the weak children of the original pipeline */
+  for (i = 0; i < COGL_MAX_SHADER_CLIP_RECTS; i++)
+    if (cache->pipelines[i])
+      cogl_object_unref (cache->pipelines[i]);
+
+  g_slice_free (CoglShaderClipCache, cache);
+}
+
+static void
+shader_clip_pipeline_destroyed_cb (CoglPipeline *weak_pipeline,
+                                   void *user_data)
+{
+  CoglShaderClipCache *cache = user_data;
+  int i;
+
+  for (i = 0; i < COGL_MAX_SHADER_CLIP_RECTS; i++)
+    if (cache->pipelines[i] == weak_pipeline)
+      {
+        cache->pipelines[i] = NULL;
+        cogl_object_unref (weak_pipeline);
+        break;
+      }
+}
+
+static CoglSnippet *
+get_shader_clip_snippet (CoglContext *ctx,
+                         int n_rects)
+{
+  CoglSnippet **snippet = ctx->shader_clip_snippets + n_rects - 1;
+
+  if (*snippet == NULL)
+    {
+      /* The window coordinates can easily be bigger than mediump can
+         represent exactly on GLES2 so the planes and the comparison
+         use highp where the fragment shader supports it */
+      char *declarations =
+        g_strdup_printf ("#if defined(GL_ES) && "
+                         "defined(GL_FRAGMENT_PRECISION_HIGH)\n"
+                         "#define _COGL_CLIP_PRECISION highp\n"
+                         "#else\n"
+                         "#define _COGL_CLIP_PRECISION\n"
+                         "#endif\n"
+                         "uniform _COGL_CLIP_PRECISION vec3 "
+                         "_cogl_clip_planes[%i];\n",
+                         n_rects * 4);
+      char *pre =
+        g_strdup_printf ("_COGL_CLIP_PRECISION vec3 _cogl_clip_coord =\n"
+                         "  vec3 (gl_FragCoord.xy, 1.0);\n"
+                         "for (int i = 0; i < %i; i++)\n"
+                         "  if (dot (_cogl_clip_planes[i],\n"
+                         "           _cogl_clip_coord) < 0.0)\n"
+                         "    discard;\n",
+                         n_rects * 4);
+
+      *snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_FRAGMENT,
+                                   declarations,
+                                   NULL);
+      cogl_snippet_set_pre (*snippet, pre);
+
+      g_free (declarations);
+      g_free (pre);
+    }
+
+  return *snippet;
+}
+
+CoglPipeline *
+_cogl_clip_stack_gl_get_shader_clip_pipeline (CoglContext *ctx,
+                                              CoglPipeline *pipeline)
+{
+  int n_rects = ctx->n_shader_clip_rects;
+  int n_floats = n_rects * 4 * 3;
+  CoglShaderClipCache *cache;
+  CoglPipeline **clip_pipeline;
+  float *planes;
+
+  if (n_rects == 0)
+    return pipeline;
+
+  cache = cogl_object_get_user_data (COGL_OBJECT (pipeline),
+                                     &shader_clip_cache_key);
+
+  if (G_UNLIKELY (cache == NULL))
+    {
+      cache = g_slice_new0 (CoglShaderClipCache);
+      cogl_object_set_user_data (COGL_OBJECT (pipeline),
+                                 &shader_clip_cache_key,
+                                 cache,
+                                 destroy_shader_clip_cache_cb);
+    }
+
+  clip_pipeline = cache->pipelines + n_rects - 1;
+  planes = cache->planes[n_rects - 1];
+
+  if (*clip_pipeline == NULL)
+    {
+      *clip_pipeline =
+        _cogl_pipeline_weak_copy (pipeline,
+                                  shader_clip_pipeline_destroyed_cb,
+                                  cache);
+      cogl_pipeline_add_snippet (*clip_pipeline,
+                                 get_shader_clip_snippet (ctx, n_rects));
+    }
+  else if (!memcmp (planes, ctx->shader_clip_planes,
+                    n_floats * sizeof (float)))
+    return *clip_pipeline;
+
+  if (ctx->shader_clip_uniform_location == -1)
+    ctx->shader_clip_uniform_location =
+      cogl_pipeline_get_uniform_location (*clip_pipeline,
+                                          "_cogl_clip_planes");
+
+  cogl_pipeline_set_uniform_float (*clip_pipeline,
+                                   ctx->shader_clip_uniform_location,
+                                   3, /* n_components */
+                                   n_rects * 4, /* count */
+                                   ctx->shader_clip_planes);
+  memcpy (planes, ctx->shader_clip_planes, n_floats * sizeof (float));
+
+  return *clip_pipeline;
+}
+
+static CoglBool
+shader_clip_planes_contain (const float *planes,
+                            float x,
+                            float y)
+{
+  int i;
+
+  for (i = 0; i < 4; i++)
+    if (planes[i * 3] * x + planes[i * 3 + 1] * y + planes[i * 3 + 2] < 0.0f)
+      return FALSE;
+
+  return TRUE;
+}
+
+UNIT_TEST (check_shader_clip_planes,
+           0 /* no requirements */,
+           0 /* no known failures */)
+{
+  int fb_width = cogl_framebuffer_get_width (test_fb);
+  int fb_height = cogl_framebuffer_get_height (test_fb);
+  CoglMatrixStack *projection_stack;
+  CoglMatrix projection;
+  CoglClipStackRect *rect;
+  float planes[4 * 3];
+  float y_center;
+  int i;
+
+  cogl_framebuffer_orthographic (test_fb, 0, 0, fb_width, fb_height, -1, 100);
+  cogl_framebuffer_push_matrix (test_fb);
+  cogl_framebuffer_translate (test_fb, 100, 100, 0);
+  cogl_framebuffer_rotate (test_fb, 45, 0, 0, 1);
+  cogl_framebuffer_push_rectangle_clip (test_fb, -20, -20, 20, 20);
+
+  rect = (CoglClipStackRect *) test_fb->clip_stack;
+  g_assert_cmpint (test_fb->clip_stack->type, ==, COGL_CLIP_STACK_RECT);
+  g_assert (!rect->can_be_scissor);
+
+  projection_stack = _cogl_framebuffer_get_projection_stack (test_fb);
+  cogl_matrix_entry_get (projection_stack->last_entry, &projection);
+  g_assert (get_shader_clip_planes (test_fb, &projection, rect, planes));
+
+  /* The planes are in GL window coordinates which are flipped for
+     onscreen framebuffers */
+  y_center = cogl_is_offscreen (test_fb) ? 100.0f : fb_height - 100.0f;
+
+  /* The planes are normalized so the center of the clip should be
+     the half size of the rectangle away from each edge */
+  for (i = 0; i < 4; i++)
+    g_assert_cmpfloat (fabsf (planes[i * 3] * 100.0f +
+                              planes[i * 3 + 1] * y_center +
+                              planes[i * 3 + 2] - 20.0f), <, 0.01f);
+
+  /* The corners of the rotated rectangle are on the axes */
+  g_assert (shader_clip_planes_contain (planes, 127.0f, y_center));
+  g_assert (shader_clip_planes_contain (planes, 100.0f, y_center - 27.0f));
+  g_assert (!shader_clip_planes_contain (planes, 130.0f, y_center));
+  /* ...and the edges are on the diagonals */
+  g_assert (!shader_clip_planes_contain (planes, 115.0f, y_center + 15.0f));
+  g_assert (!shader_clip_planes_contain (planes, 85.0f, y_center - 15.0f));
+
+  cogl_framebuffer_pop_clip (test_fb);
+  cogl_framebuffer_pop_matrix (test_fb);
+}
+
+UNIT_TEST (check_shader_clip_pipeline_cache,
+           0 /* no requirements */,
+           0 /* no known failures */)
+{
+  CoglPipeline *pipeline = cogl_pipeline_new (test_ctx);
+  CoglPipeline *clip_pipeline;
+  int old_n_rects = test_ctx->n_shader_clip_rects;
+
+  test_ctx->n_shader_clip_rects = 0;
+  g_assert (_cogl_clip_stack_gl_get_shader_clip_pipeline (test_ctx,
+                                                          pipeline) ==
+            pipeline);
+
+  memset (test_ctx->shader_clip_planes, 0,
+          sizeof (test_ctx->shader_clip_planes));
+  test_ctx->n_shader_clip_rects = 2;
+
+  clip_pipeline =
+    _cogl_clip_stack_gl_get_shader_clip_pipeline (test_ctx, pipeline);
+  g_assert (clip_pipeline != pipeline);
+  g_assert (_cogl_pipeline_has_fragment_snippets (clip_pipeline));
+
+  /* The derived pipeline should be reused while the original pipeline
+     stays the same, even if the planes change */
+  test_ctx->shader_clip_planes[0] = 1.0f;
+  g_assert (_cogl_clip_stack_gl_get_shader_clip_pipeline (test_ctx,
+                                                          pipeline) ==
+            clip_pipeline);
+
+  /* Modifying the original pipeline should destroy the derived
+     pipeline */
+  cogl_pipeline_set_color4ub (pipeline, 255, 0, 0, 255);
+  clip_pipeline =
+    _cogl_clip_stack_gl_get_shader_clip_pipeline (test_ctx, pipeline);
+  g_assert (clip_pipeline != pipeline);
+  g_assert (_cogl_pipeline_has_fragment_snippets (clip_pipeline));
+
+  test_ctx->n_shader_clip_rects = old_n_rects;
+
+  /* Freeing the pipeline should also free the derived pipeline */
+  cogl_object_unref (pipeline);
+}
@@ -74,6 +74,7 @@ _cogl_framebuffer_gl_draw_attributes (CoglFramebuffer *framebuffer,
                                       CoglVerticesMode mode,
                                       int first_vertex,
                                       int n_vertices,
+                                      int n_instances,
                                       CoglAttribute **attributes,
                                       int n_attributes,
                                       CoglDrawFlags flags);
@@ -84,11 +85,24 @@ _cogl_framebuffer_gl_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                               CoglVerticesMode mode,
                                               int first_vertex,
                                               int n_vertices,
+                                              int n_instances,
                                               CoglIndices *indices,
                                               CoglAttribute **attributes,
                                               int n_attributes,
                                               CoglDrawFlags flags);
 
+void
+_cogl_framebuffer_gl_multi_draw_attributes (CoglFramebuffer *framebuffer,
+                                            CoglPipeline *pipeline,
+                                            CoglVerticesMode mode,
+                                            const int *first_vertices,
+                                            const int *n_vertices,
+                                            int n_draws,
+                                            CoglIndices *indices,
+                                            CoglAttribute **attributes,
+                                            int n_attributes,
+                                            CoglDrawFlags flags);
+
 CoglBool
 _cogl_framebuffer_gl_read_pixels_into_bitmap (CoglFramebuffer *framebuffer,
                                               int x,
@@ -1160,6 +1160,7 @@ _cogl_framebuffer_gl_draw_attributes (CoglFramebuffer *framebuffer,
                                       CoglVerticesMode mode,
                                       int first_vertex,
                                       int n_vertices,
+                                      int n_instances,
                                       CoglAttribute **attributes,
                                       int n_attributes,
                                       CoglDrawFlags flags)
@@ -1167,8 +1168,17 @@ _cogl_framebuffer_gl_draw_attributes (CoglFramebuffer *framebuffer,
   _cogl_flush_attributes_state (framebuffer, pipeline, flags,
                                 attributes, n_attributes);
 
-  GE (framebuffer->context,
-      glDrawArrays ((GLenum)mode, first_vertex, n_vertices));
+  if (n_instances == 1)
+    GE (framebuffer->context,
+        glDrawArrays ((GLenum)mode, first_vertex, n_vertices));
+  else
+    GE (framebuffer->context,
+        glDrawArraysInstanced ((GLenum)mode,
+                               first_vertex,
+                               n_vertices,
+                               n_instances));
+
+  framebuffer->context->frame_stats.n_draw_calls++;
 }
 
 static size_t
@@ -1186,12 +1196,28 @@ sizeof_index_type (CoglIndicesType type)
   g_return_val_if_reached (0);
 }
 
+static GLenum
+indices_type_to_gl (CoglIndicesType type)
+{
+  switch (type)
+    {
+    case COGL_INDICES_TYPE_UNSIGNED_BYTE:
+      return GL_UNSIGNED_BYTE;
+    case COGL_INDICES_TYPE_UNSIGNED_SHORT:
+      return GL_UNSIGNED_SHORT;
+    case COGL_INDICES_TYPE_UNSIGNED_INT:
+      return GL_UNSIGNED_INT;
+    }
+  g_return_val_if_reached (0);
+}
+
 void
 _cogl_framebuffer_gl_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                               CoglPipeline *pipeline,
                                               CoglVerticesMode mode,
                                               int first_vertex,
                                               int n_vertices,
+                                              int n_instances,
                                               CoglIndices *indices,
                                               CoglAttribute **attributes,
                                               int n_attributes,
@@ -1201,7 +1227,7 @@ _cogl_framebuffer_gl_draw_indexed_attributes (CoglFramebuffer *framebuffer,
   uint8_t *base;
   size_t buffer_offset;
   size_t index_size;
-  GLenum indices_gl_type = 0;
+  GLenum indices_gl_type;
 
   _cogl_flush_attributes_state (framebuffer, pipeline, flags,
                                 attributes, n_attributes);
@@ -1217,27 +1243,94 @@ _cogl_framebuffer_gl_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                COGL_BUFFER_BIND_TARGET_INDEX_BUFFER, NULL);
   buffer_offset = cogl_indices_get_offset (indices);
   index_size = sizeof_index_type (cogl_indices_get_type (indices));
+  indices_gl_type = indices_type_to_gl (cogl_indices_get_type (indices));
+
+  if (n_instances == 1)
+    GE (framebuffer->context,
+        glDrawElements ((GLenum)mode,
+                        n_vertices,
+                        indices_gl_type,
+                        base + buffer_offset + index_size * first_vertex));
+  else
+    GE (framebuffer->context,
+        glDrawElementsInstanced ((GLenum)mode,
+                                 n_vertices,
+                                 indices_gl_type,
+                                 base + buffer_offset +
+                                 index_size * first_vertex,
+                                 n_instances));
+
+  framebuffer->context->frame_stats.n_draw_calls++;
+
+  _cogl_buffer_gl_unbind (buffer);
+}
+
+void
+_cogl_framebuffer_gl_multi_draw_attributes (CoglFramebuffer *framebuffer,
+                                            CoglPipeline *pipeline,
+                                            CoglVerticesMode mode,
+                                            const int *first_vertices,
+                                            const int *n_vertices,
+                                            int n_draws,
+                                            CoglIndices *indices,
+                                            CoglAttribute **attributes,
+                                            int n_attributes,
+                                            CoglDrawFlags flags)
+{
+  CoglContext *ctx = framebuffer->context;
+  int i;
+
+  _cogl_flush_attributes_state (framebuffer, pipeline, flags,
+                                attributes, n_attributes);
 
-  switch (cogl_indices_get_type (indices))
+  /* Without the multi-draw functions we still save flushing the
+   * pipeline and attribute state for each draw */
+  if (indices == NULL)
     {
-    case COGL_INDICES_TYPE_UNSIGNED_BYTE:
-      indices_gl_type = GL_UNSIGNED_BYTE;
-      break;
-    case COGL_INDICES_TYPE_UNSIGNED_SHORT:
-      indices_gl_type = GL_UNSIGNED_SHORT;
-      break;
-    case COGL_INDICES_TYPE_UNSIGNED_INT:
-      indices_gl_type = GL_UNSIGNED_INT;
-      break;
+      if (ctx->glMultiDrawArrays)
+        GE (ctx, glMultiDrawArrays ((GLenum)mode,
+                                    first_vertices,
+                                    n_vertices,
+                                    n_draws));
+      else
+        for (i = 0; i < n_draws; i++)
+          GE (ctx, glDrawArrays ((GLenum)mode,
+                                 first_vertices[i],
+                                 n_vertices[i]));
     }
+  else
+    {
+      CoglBuffer *buffer = COGL_BUFFER (cogl_indices_get_buffer (indices));
+      CoglIndicesType type = cogl_indices_get_type (indices);
+      GLenum indices_gl_type = indices_type_to_gl (type);
+      size_t index_size = sizeof_index_type (type);
+      const GLvoid **offsets = g_alloca (sizeof (GLvoid *) * n_draws);
+      uint8_t *base;
+
+      base = _cogl_buffer_gl_bind (buffer,
+                                   COGL_BUFFER_BIND_TARGET_INDEX_BUFFER, NULL);
+      base += cogl_indices_get_offset (indices);
+
+      for (i = 0; i < n_draws; i++)
+        offsets[i] = base + index_size * first_vertices[i];
+
+      if (ctx->glMultiDrawElements)
+        GE (ctx, glMultiDrawElements ((GLenum)mode,
+                                      n_vertices,
+                                      indices_gl_type,
+                                      offsets,
+                                      n_draws));
+      else
+        for (i = 0; i < n_draws; i++)
+          GE (ctx, glDrawElements ((GLenum)mode,
+                                   n_vertices[i],
+                                   indices_gl_type,
+                                   offsets[i]));
 
-  GE (framebuffer->context,
-      glDrawElements ((GLenum)mode,
-                      n_vertices,
-                      indices_gl_type,
-                      base + buffer_offset + index_size * first_vertex));
+      _cogl_buffer_gl_unbind (buffer);
+    }
 
-  _cogl_buffer_gl_unbind (buffer);
+  ctx->frame_stats.n_draw_calls++;
 }
 
 static CoglBool
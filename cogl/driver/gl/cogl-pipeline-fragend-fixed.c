@@ -207,6 +207,11 @@ _cogl_pipeline_fragend_fixed_add_layer (CoglPipeline *pipeline,
         case COGL_TEXTURE_TYPE_RECTANGLE:
           gl_target = GL_TEXTURE_RECTANGLE_ARB;
           break;
+
+        case COGL_TEXTURE_TYPE_2D_ARRAY:
+          /* The fixed progends refuse pipelines with tiled textures
+             because the tile lookup needs a shader */
+          g_return_val_if_reached (FALSE);
         }
 
       _cogl_set_active_texture_unit (unit_index);
@@ -249,6 +249,15 @@ add_layer_declaration_cb (CoglPipelineLayer *layer,
                           target_string,
                           layer->index);
 
+  /* Tiled textures need the layout of the tiles to find the layer
+     containing each texel. These are updated by the GLSL progend */
+  if (texture_type == COGL_TEXTURE_TYPE_2D_ARRAY)
+    g_string_append_printf (shader_state->header,
+                            "uniform vec4 _cogl_tiles%i;\n"
+                            "uniform vec4 _cogl_tile_scale%i;\n",
+                            layer->index,
+                            layer->index);
+
   return TRUE;
 }
 
@@ -393,6 +402,40 @@ add_constant_lookup (CoglPipelineShaderState *shader_state,
                           layer->index, swizzle);
 }
 
+/* Each layer of the array texture contains one tile of the image
+ * with a one texel border. The normalized coordinates are first
+ * scaled so that each tile is one unit in size which makes the
+ * integer part select the tile and the fractional part the position
+ * within it */
+static void
+add_tiled_texture_lookup (CoglPipelineShaderState *shader_state,
+                          CoglPipelineLayer *layer)
+{
+  g_string_append_printf (shader_state->header,
+                          "vec4\n"
+                          "_cogl_tiled_texture_lookup%i (sampler2DArray tex,\n"
+                          "                              vec2 coords)\n"
+                          "{\n"
+                          "  vec2 pos = clamp (coords, 0.0, 1.0) * "
+                          "_cogl_tiles%i.xy;\n"
+                          "  vec2 tile = min (floor (pos), "
+                          "_cogl_tiles%i.zw - 1.0);\n"
+                          "  vec2 tile_coords = ((pos - tile) * "
+                          "_cogl_tile_scale%i.xy +\n"
+                          "                      _cogl_tile_scale%i.zw);\n"
+                          "  return texture2DArray "
+                          "(tex, vec3 (tile_coords,\n"
+                          "                                  "
+                          "tile.y * _cogl_tiles%i.z + tile.x));\n"
+                          "}\n",
+                          layer->index,
+                          layer->index,
+                          layer->index,
+                          layer->index,
+                          layer->index,
+                          layer->index);
+}
+
 static void
 ensure_texture_lookup_generated (CoglPipelineShaderState *shader_state,
                                  CoglPipeline *pipeline,
@@ -442,6 +485,9 @@ ensure_texture_lookup_generated (CoglPipelineShaderState *shader_state,
      to be replaced */
   if (!has_replace_hook (layer, COGL_SNIPPET_HOOK_TEXTURE_LOOKUP))
     {
+      if (texture_type == COGL_TEXTURE_TYPE_2D_ARRAY)
+        add_tiled_texture_lookup (shader_state, layer);
+
       g_string_append_printf (shader_state->header,
                               "vec4\n"
                               "cogl_real_texture_lookup%i (sampler%s tex,\n"
@@ -454,6 +500,11 @@ ensure_texture_lookup_generated (CoglPipelineShaderState *shader_state,
       if (G_UNLIKELY (COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_TEXTURING)))
         g_string_append (shader_state->header,
                          "vec4 (1.0, 1.0, 1.0, 1.0);\n");
+      else if (texture_type == COGL_TEXTURE_TYPE_2D_ARRAY)
+        g_string_append_printf (shader_state->header,
+                                "_cogl_tiled_texture_lookup%i (tex, "
+                                "coords.st);\n",
+                                layer->index);
       else
         g_string_append_printf (shader_state->header,
                                 "texture%s (tex, coords.%s);\n",
@@ -999,7 +1050,7 @@ _cogl_pipeline_fragend_glsl_end (CoglPipeline *pipeline,
                            "Increments each time a new GLSL "
                            "fragment shader is compiled",
                            0 /* no application private data */);
-      COGL_COUNTER_INC (_cogl_uprof_context, fragend_glsl_compile_counter);
+      COGL_COUNTER_INC (fragend_glsl_compile_counter);
 
       /* We only need to generate code to calculate the fragment value
          for the last layer. If the value of this layer depends on any
@@ -458,7 +458,7 @@ flush_depth_state (CoglContext *ctx,
 }
 
 UNIT_TEST (check_gl_blend_enable,
-           0 /* no requirements */,
+           TEST_REQUIREMENT_GPU,
            0 /* no failure cases */)
 {
   CoglPipeline *pipeline = cogl_pipeline_new (test_ctx);
@@ -820,6 +820,7 @@ flush_layers_common_gl_state_cb (CoglPipelineLayer *layer, void *user_data)
         switch (_cogl_pipeline_layer_get_texture_type (layer))
           {
           case COGL_TEXTURE_TYPE_2D:
+          case COGL_TEXTURE_TYPE_2D_ARRAY:
             texture = COGL_TEXTURE (ctx->default_gl_texture_2d_tex);
             break;
           case COGL_TEXTURE_TYPE_3D:
@@ -1207,7 +1208,7 @@ _cogl_pipeline_flush_gl_state (CoglContext *ctx,
                      "The time spent flushing material state",
                      0 /* no application private data */);
 
-  COGL_TIMER_START (_cogl_uprof_context, pipeline_flush_timer);
+  COGL_TIMER_START (pipeline_flush_timer);
 
   /* Bail out asap if we've been asked to re-flush the already current
    * pipeline and we can see the pipeline hasn't changed */
@@ -1218,6 +1219,8 @@ _cogl_pipeline_flush_gl_state (CoglContext *ctx,
     goto done;
   else
     {
+      ctx->frame_stats.n_state_changes++;
+
       /* Update derived state (currently just the 'real_blend_enable'
        * state) and determine a mask of state that differs between the
        * current pipeline and the one we are flushing.
@@ -1457,6 +1460,6 @@ done:
       unit1->dirty_gl_texture = FALSE;
     }
 
-  COGL_TIMER_STOP (_cogl_uprof_context, pipeline_flush_timer);
+  COGL_TIMER_STOP (pipeline_flush_timer);
 }
 
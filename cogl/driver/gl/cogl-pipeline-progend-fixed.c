@@ -65,6 +65,10 @@ _cogl_pipeline_progend_fixed_start (CoglPipeline *pipeline)
   if (_cogl_pipeline_has_fragment_snippets (pipeline))
     return FALSE;
 
+  /* Tiled textures need the tile lookup in the GLSL fragend */
+  if (_cogl_pipeline_has_tiled_textures (pipeline))
+    return FALSE;
+
   /* The fixed progend can't handle the per-vertex point size
    * attribute */
   if (cogl_pipeline_get_per_vertex_point_size (pipeline))
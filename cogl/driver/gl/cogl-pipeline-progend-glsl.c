@@ -55,6 +55,14 @@
 #include "cogl-attribute-private.h"
 #include "cogl-framebuffer-private.h"
 #include "cogl-pipeline-progend-glsl-private.h"
+#include "cogl-texture-tiled-private.h"
+
+#ifndef GL_UNIFORM_BUFFER
+#define GL_UNIFORM_BUFFER 0x8A11
+#endif
+#ifndef GL_INVALID_INDEX
+#define GL_INVALID_INDEX 0xFFFFFFFFu
+#endif
 
 /* These are used to generalise updating some uniforms that are
    required when building for drivers missing some fixed function
@@ -94,11 +102,45 @@ static BuiltinUniformData builtin_uniforms[] =
 
 const CoglPipelineProgend _cogl_pipeline_glsl_progend;
 
+/* When uniform buffers are available the builtin matrices are stored
+ * in a uniform block that is shared between all of the programs so
+ * that they only need to be uploaded when they change instead of
+ * every time a different program is used. The layout of this struct
+ * must match the _cogl_matrices block declared in
+ * cogl-glsl-shader-boilerplate.h. With the std140 layout there is no
+ * padding between the matrices */
+typedef struct
+{
+  float modelview[16];
+  float modelview_projection[16];
+  float projection[16];
+} CoglMatrixUniformBlock;
+
+/* There are two copies of the block, each bound to the binding point
+ * with the same index. Programs that flip the geometry with the
+ * _cogl_flip_vector uniform use the first copy which always has the
+ * unflipped projection. The other programs use the second copy where
+ * the flip is included in the projection matrix when rendering to an
+ * offscreen framebuffer */
+#define MATRIX_BLOCK_UNFLIPPED 0
+#define MATRIX_BLOCK_FLIPPED 1
+
 typedef struct _UnitState
 {
   unsigned int dirty_combine_constant:1;
+  unsigned int tile_layout_valid:1;
 
   GLint combine_constant_uniform;
+
+  /* The uniforms describing the layout of a tiled texture or -1 if
+     the layer isn't tiled */
+  GLint tiles_uniform;
+  GLint tile_scale_uniform;
+  /* The last values uploaded to the two uniforms above. Any texture
+     of the same type can be set on the layer without changing the
+     program so these are checked every time the pipeline is
+     flushed */
+  float tile_layout[8];
 } UnitState;
 
 typedef struct
@@ -114,6 +156,10 @@ typedef struct
   GLint projection_uniform;
   GLint mvp_uniform;
 
+  /* The copy of the shared matrix block used by the program or -1 if
+     the matrices are plain uniforms */
+  int matrix_block;
+
   CoglMatrixEntryCache projection_cache;
   CoglMatrixEntryCache modelview_cache;
 
@@ -240,6 +286,7 @@ program_state_new (int n_layers,
   program_state->uniform_locations = NULL;
   program_state->attribute_locations = NULL;
   program_state->cache_entry = cache_entry;
+  program_state->matrix_block = -1;
   _cogl_matrix_entry_cache_init (&program_state->modelview_cache);
   _cogl_matrix_entry_cache_init (&program_state->projection_cache);
 
@@ -322,6 +369,7 @@ link_program (GLint gl_program)
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
   GE( ctx, glLinkProgram (gl_program) );
+  ctx->frame_stats.n_program_links++;
 
   GE( ctx, glGetProgramiv (gl_program, GL_LINK_STATUS, &link_status) );
 
@@ -392,6 +440,24 @@ get_uniform_cb (CoglPipeline *pipeline,
 
   unit_state->combine_constant_uniform = uniform_location;
 
+  g_string_set_size (ctx->codegen_source_buffer, 0);
+  g_string_append_printf (ctx->codegen_source_buffer,
+                          "_cogl_tiles%i", layer_index);
+
+  GE_RET( unit_state->tiles_uniform,
+          ctx, glGetUniformLocation (state->gl_program,
+                                     ctx->codegen_source_buffer->str) );
+
+  g_string_set_size (ctx->codegen_source_buffer, 0);
+  g_string_append_printf (ctx->codegen_source_buffer,
+                          "_cogl_tile_scale%i", layer_index);
+
+  GE_RET( unit_state->tile_scale_uniform,
+          ctx, glGetUniformLocation (state->gl_program,
+                                     ctx->codegen_source_buffer->str) );
+
+  unit_state->tile_layout_valid = FALSE;
+
   state->unit++;
 
   return TRUE;
@@ -420,6 +486,31 @@ update_constants_cb (CoglPipeline *pipeline,
       unit_state->dirty_combine_constant = FALSE;
     }
 
+  if (unit_state->tiles_uniform != -1 ||
+      unit_state->tile_scale_uniform != -1)
+    {
+      CoglTexture *texture = cogl_pipeline_get_layer_texture (pipeline,
+                                                              layer_index);
+      float layout[8];
+
+      if (texture &&
+          _cogl_texture_tiled_get_layout (texture, layout, layout + 4) &&
+          (state->update_all ||
+           !unit_state->tile_layout_valid ||
+           memcmp (layout, unit_state->tile_layout, sizeof (layout))))
+        {
+          if (unit_state->tiles_uniform != -1)
+            GE (ctx, glUniform4fv (unit_state->tiles_uniform,
+                                   1, layout));
+          if (unit_state->tile_scale_uniform != -1)
+            GE (ctx, glUniform4fv (unit_state->tile_scale_uniform,
+                                   1, layout + 4));
+
+          memcpy (unit_state->tile_layout, layout, sizeof (layout));
+          unit_state->tile_layout_valid = TRUE;
+        }
+    }
+
   return TRUE;
 }
 
@@ -760,6 +851,28 @@ _cogl_pipeline_progend_glsl_end (CoglPipeline *pipeline,
       GE_RET( program_state->mvp_uniform, ctx,
               glGetUniformLocation (gl_program,
                                     "cogl_modelview_projection_matrix") );
+
+      program_state->matrix_block = -1;
+
+      if (_cogl_has_private_feature (ctx,
+                                     COGL_PRIVATE_FEATURE_UNIFORM_BUFFERS))
+        {
+          GLuint block_index;
+
+          GE_RET( block_index, ctx,
+                  glGetUniformBlockIndex (gl_program, "_cogl_matrices") );
+
+          if (block_index != GL_INVALID_INDEX)
+            {
+              program_state->matrix_block =
+                (program_state->flip_uniform == -1 ?
+                 MATRIX_BLOCK_FLIPPED :
+                 MATRIX_BLOCK_UNFLIPPED);
+              GE( ctx, glUniformBlockBinding (gl_program,
+                                              block_index,
+                                              program_state->matrix_block) );
+            }
+        }
     }
 
   if (program_changed ||
@@ -840,6 +953,76 @@ _cogl_pipeline_progend_glsl_layer_pre_change_notify (
     }
 }
 
+static void
+flush_matrix_block (CoglContext *ctx,
+                    int block,
+                    CoglMatrixEntry *projection_entry,
+                    CoglMatrixEntry *modelview_entry,
+                    CoglBool needs_flip)
+{
+  CoglMatrixUniformBlock data;
+  CoglMatrix projection, modelview, combined;
+  CoglBool flip = needs_flip && block == MATRIX_BLOCK_FLIPPED;
+  CoglBool projection_changed;
+  CoglBool modelview_changed;
+
+  projection_changed =
+    _cogl_matrix_entry_cache_maybe_update (&ctx->matrix_block_projection[block],
+                                           projection_entry,
+                                           flip);
+  modelview_changed =
+    _cogl_matrix_entry_cache_maybe_update (&ctx->matrix_block_modelview[block],
+                                           modelview_entry,
+                                           /* never flip modelview */
+                                           FALSE);
+
+  if (!projection_changed && !modelview_changed)
+    return;
+
+  if (ctx->matrix_uniform_buffers[block] == 0)
+    {
+      GE( ctx, glGenBuffers (1, &ctx->matrix_uniform_buffers[block]) );
+      GE( ctx, glBindBufferBase (GL_UNIFORM_BUFFER,
+                                 block,
+                                 ctx->matrix_uniform_buffers[block]) );
+    }
+  else
+    GE( ctx, glBindBuffer (GL_UNIFORM_BUFFER,
+                           ctx->matrix_uniform_buffers[block]) );
+
+  cogl_matrix_entry_get (modelview_entry, &modelview);
+
+  if (flip)
+    {
+      CoglMatrix tmp_matrix;
+      cogl_matrix_entry_get (projection_entry, &tmp_matrix);
+      cogl_matrix_multiply (&projection, &ctx->y_flip_matrix, &tmp_matrix);
+    }
+  else
+    cogl_matrix_entry_get (projection_entry, &projection);
+
+  cogl_matrix_multiply (&combined, &projection, &modelview);
+
+  /* The block is small enough that it's simpler to always upload all
+   * of it */
+  memcpy (data.modelview, cogl_matrix_get_array (&modelview),
+          sizeof (data.modelview));
+  memcpy (data.modelview_projection, cogl_matrix_get_array (&combined),
+          sizeof (data.modelview_projection));
+  memcpy (data.projection, cogl_matrix_get_array (&projection),
+          sizeof (data.projection));
+
+  /* The draws that used the previous matrices are probably still
+   * queued on the GPU so instead of modifying the buffer in place,
+   * which could make the driver wait for them, the whole storage is
+   * respecified. That orphans the old storage so the driver can keep
+   * it around until those draws are done */
+  GE( ctx, glBufferData (GL_UNIFORM_BUFFER,
+                         sizeof (data),
+                         &data,
+                         GL_STREAM_DRAW) );
+}
+
 static void
 _cogl_pipeline_progend_glsl_pre_paint (CoglPipeline *pipeline,
                                        CoglFramebuffer *framebuffer)
@@ -869,6 +1052,16 @@ _cogl_pipeline_progend_glsl_pre_paint (CoglPipeline *pipeline,
 
   needs_flip = cogl_is_offscreen (ctx->current_draw_buffer);
 
+  if (program_state->matrix_block != -1)
+    {
+      flush_matrix_block (ctx,
+                          program_state->matrix_block,
+                          projection_entry,
+                          modelview_entry,
+                          needs_flip);
+      goto flush_flip_uniform;
+    }
+
   projection_changed =
     _cogl_matrix_entry_cache_maybe_update (&program_state->projection_cache,
                                            projection_entry,
@@ -951,6 +1144,7 @@ _cogl_pipeline_progend_glsl_pre_paint (CoglPipeline *pipeline,
         }
     }
 
+ flush_flip_uniform:
   if (program_state->flip_uniform != -1
       && program_state->flushed_flip_state != needs_flip)
     {
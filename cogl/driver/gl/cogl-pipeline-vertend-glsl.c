@@ -411,7 +411,7 @@ _cogl_pipeline_vertend_glsl_end (CoglPipeline *pipeline,
                            "Increments each time a new GLSL "
                            "vertex shader is compiled",
                            0 /* no application private data */);
-      COGL_COUNTER_INC (_cogl_uprof_context, vertend_glsl_compile_counter);
+      COGL_COUNTER_INC (vertend_glsl_compile_counter);
 
       g_string_append (shader_state->header,
                        "void\n"
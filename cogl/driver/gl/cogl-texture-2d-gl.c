@@ -45,6 +45,8 @@
 #include "cogl-pipeline-opengl-private.h"
 #include "cogl-error-private.h"
 #include "cogl-util-gl-private.h"
+#include "cogl-mipmap-private.h"
+#include "cogl-bitmap-private.h"
 
 void
 _cogl_texture_2d_gl_free (CoglTexture2D *tex_2d)
@@ -172,17 +174,106 @@ allocate_with_size (CoglTexture2D *tex_2d,
 }
 
 static CoglBool
-allocate_from_bitmap (CoglTexture2D *tex_2d,
-                      CoglTextureLoader *loader,
-                      CoglError **error)
+upload_compressed_image (CoglTexture2D *tex_2d,
+                         CoglCompressedImage *image,
+                         CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_2d);
+  CoglContext *ctx = tex->context;
+  GLenum gl_intformat = _cogl_compressed_format_to_gl (image->format);
+  CoglPixelFormat internal_format;
+  int n_levels = image->n_levels;
+  GLenum gl_error;
+  GLuint gl_texture;
+  int level;
+
+  /* This is the format that the texture would be read back as */
+  if (_cogl_compressed_format_has_alpha (image->format))
+    internal_format = (image->premultiplied ?
+                       COGL_PIXEL_FORMAT_RGBA_8888_PRE :
+                       COGL_PIXEL_FORMAT_RGBA_8888);
+  else
+    internal_format = COGL_PIXEL_FORMAT_RGB_888;
+
+  if (!_cogl_texture_2d_gl_can_create (ctx,
+                                       image->width,
+                                       image->height,
+                                       internal_format))
+    {
+      _cogl_set_error (error, COGL_TEXTURE_ERROR,
+                       COGL_TEXTURE_ERROR_SIZE,
+                       "Failed to create texture 2d due to size/format"
+                       " constraints");
+      return FALSE;
+    }
+
+  gl_texture = ctx->texture_driver->gen (ctx, GL_TEXTURE_2D, internal_format);
+
+  _cogl_bind_gl_texture_transient (GL_TEXTURE_2D, gl_texture, FALSE);
+
+  /* Clear any GL errors */
+  while ((gl_error = ctx->glGetError ()) != GL_NO_ERROR)
+    ;
+
+  for (level = 0; level < n_levels; level++)
+    {
+      int level_width, level_height;
+
+      _cogl_compressed_image_get_level_size (image,
+                                             level,
+                                             &level_width,
+                                             &level_height);
+
+      ctx->glCompressedTexImage2D (GL_TEXTURE_2D,
+                                   level,
+                                   gl_intformat,
+                                   level_width,
+                                   level_height,
+                                   0,
+                                   image->level_sizes[level],
+                                   image->data + image->level_offsets[level]);
+
+      ctx->frame_stats.n_bytes_uploaded += image->level_sizes[level];
+    }
+
+  if (_cogl_gl_util_catch_out_of_memory (ctx, error))
+    {
+      GE( ctx, glDeleteTextures (1, &gl_texture) );
+      return FALSE;
+    }
+
+  tex_2d->gl_texture = gl_texture;
+  tex_2d->gl_internal_format = gl_intformat;
+  tex_2d->internal_format = internal_format;
+  tex_2d->is_compressed = TRUE;
+  tex_2d->compressed_format = image->format;
+
+  /* GL can't generate mipmaps for compressed textures so we only use
+   * the levels that are stored in the image */
+  _cogl_texture_2d_set_auto_mipmap (tex, FALSE);
+  tex_2d->mipmaps_dirty = FALSE;
+
+  _cogl_texture_set_allocated (tex,
+                               internal_format,
+                               image->width,
+                               image->height);
+
+  _cogl_texture_gl_maybe_update_max_level (tex, n_levels - 1);
+
+  return TRUE;
+}
+
+static CoglBool
+upload_bitmap (CoglTexture2D *tex_2d,
+               CoglBitmap *bmp,
+               CoglBool can_convert_in_place,
+               CoglError **error)
 {
   CoglTexture *tex = COGL_TEXTURE (tex_2d);
-  CoglBitmap *bmp = loader->src.bitmap.bitmap;
   CoglContext *ctx = _cogl_bitmap_get_context (bmp);
   CoglPixelFormat internal_format;
   int width = cogl_bitmap_get_width (bmp);
   int height = cogl_bitmap_get_height (bmp);
-  CoglBool can_convert_in_place = loader->src.bitmap.can_convert_in_place;
   CoglBitmap *upload_bmp;
   GLenum gl_intformat;
   GLenum gl_format;
@@ -203,6 +294,37 @@ allocate_from_bitmap (CoglTexture2D *tex_2d,
       return FALSE;
     }
 
+  if (tex->compressed &&
+      (tex->components == COGL_TEXTURE_COMPONENTS_RGB ||
+       tex->components == COGL_TEXTURE_COMPONENTS_RGBA))
+    {
+      CoglCompressedFormat compressed_format;
+
+      if (_cogl_compressed_format_choose_for_encoding
+          (ctx,
+           (internal_format & COGL_A_BIT) != 0,
+           &compressed_format))
+        {
+          CoglCompressedImage *image;
+          CoglBool ret;
+
+          image = _cogl_compressed_image_new_from_bitmap
+            (bmp,
+             compressed_format,
+             (internal_format & COGL_PREMULT_BIT) != 0,
+             TRUE, /* with mipmaps */
+             error);
+          if (image == NULL)
+            return FALSE;
+
+          ret = upload_compressed_image (tex_2d, image, error);
+
+          _cogl_compressed_image_free (image);
+
+          return ret;
+        }
+    }
+
   upload_bmp = _cogl_bitmap_convert_for_upload (bmp,
                                                 internal_format,
                                                 can_convert_in_place,
@@ -277,6 +399,47 @@ allocate_from_bitmap (CoglTexture2D *tex_2d,
   return TRUE;
 }
 
+static CoglBool
+allocate_from_bitmap (CoglTexture2D *tex_2d,
+                      CoglTextureLoader *loader,
+                      CoglError **error)
+{
+  return upload_bitmap (tex_2d,
+                        loader->src.bitmap.bitmap,
+                        loader->src.bitmap.can_convert_in_place,
+                        error);
+}
+
+static CoglBool
+allocate_from_compressed_image (CoglTexture2D *tex_2d,
+                                CoglTextureLoader *loader,
+                                CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_2d);
+  CoglContext *ctx = tex->context;
+  CoglCompressedImage *image = loader->src.compressed.image;
+  CoglBitmap *bmp;
+  CoglBool ret;
+
+  if (_cogl_compressed_format_is_supported (ctx, image->format))
+    return upload_compressed_image (tex_2d, image, error);
+
+  /* Otherwise fall back to decoding the image on the CPU and
+   * uploading it uncompressed */
+  bmp = _cogl_compressed_image_decode (ctx, image, error);
+  if (bmp == NULL)
+    return FALSE;
+
+  ret = upload_bitmap (tex_2d,
+                       bmp,
+                       TRUE, /* can convert in place */
+                       error);
+
+  cogl_object_unref (bmp);
+
+  return ret;
+}
+
 #if defined (COGL_HAS_EGL_SUPPORT) && defined (EGL_KHR_image_base)
 static CoglBool
 allocate_from_egl_image (CoglTexture2D *tex_2d,
@@ -468,6 +631,8 @@ _cogl_texture_2d_gl_allocate (CoglTexture *tex,
 #endif
     case COGL_TEXTURE_SOURCE_TYPE_GL_FOREIGN:
       return allocate_from_gl_foreign (tex_2d, loader, error);
+    case COGL_TEXTURE_SOURCE_TYPE_COMPRESSED:
+      return allocate_from_compressed_image (tex_2d, loader, error);
     }
 
   g_return_val_if_reached (FALSE);
@@ -602,18 +767,97 @@ _cogl_texture_2d_gl_get_gl_handle (CoglTexture2D *tex_2d)
     return tex_2d->gl_texture;
 }
 
+/* Reads back the base level and builds the other levels with the
+   CPU mipmap builder. Like glGenerateMipmap this just averages the
+   stored values so the premultiplied status of the data doesn't
+   matter */
+static CoglBool
+generate_mipmap_on_cpu (CoglTexture2D *tex_2d)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_2d);
+  CoglContext *ctx = tex->context;
+  CoglPixelFormat internal_format = _cogl_texture_get_format (tex);
+  CoglPixelFormat format;
+  CoglMipmapLevel *levels;
+  CoglError *error = NULL;
+  int rowstride = tex->width * 4;
+  int n_levels;
+  uint8_t *data;
+  int i;
+
+  /* GLES can't read back textures without an FBO */
+  if (ctx->driver_vtable->texture_2d_get_data == NULL ||
+      tex_2d->is_compressed ||
+      (internal_format & COGL_DEPTH_BIT))
+    return FALSE;
+
+  format = COGL_PIXEL_FORMAT_RGBA_8888 | (internal_format & COGL_PREMULT_BIT);
+
+  data = g_malloc (rowstride * tex->height);
+
+  _cogl_texture_2d_gl_get_data (tex_2d, format, rowstride, data);
+
+  levels = _cogl_mipmap_build (_cogl_context_get_worker_pool (ctx),
+                               data,
+                               tex->width, tex->height,
+                               rowstride,
+                               COGL_MIPMAP_FILTER_BOX,
+                               COGL_MIPMAP_FLAG_NONE,
+                               &n_levels);
+
+  g_free (data);
+
+  /* This is called while painting so the levels are uploaded
+     directly instead of going through cogl_texture_set_region which
+     could flush the journal */
+  for (i = 0; i < n_levels; i++)
+    {
+      const CoglMipmapLevel *level = levels + i;
+      CoglBitmap *bitmap = cogl_bitmap_new_for_data (ctx,
+                                                     level->width,
+                                                     level->height,
+                                                     format,
+                                                     level->rowstride,
+                                                     level->data);
+
+      if (!_cogl_texture_2d_gl_copy_from_bitmap (tex_2d,
+                                                 0, 0, /* src_x/y */
+                                                 level->width,
+                                                 level->height,
+                                                 bitmap,
+                                                 0, 0, /* dst_x/y */
+                                                 i + 1, /* level */
+                                                 &error))
+        {
+          /* There's no way to report the error while painting so the
+             remaining levels are just left undefined like they would
+             be if glGenerateMipmap failed */
+          cogl_error_free (error);
+          cogl_object_unref (bitmap);
+          break;
+        }
+
+      cogl_object_unref (bitmap);
+    }
+
+  _cogl_mipmap_free_levels (levels, n_levels);
+
+  return TRUE;
+}
+
 void
 _cogl_texture_2d_gl_generate_mipmap (CoglTexture2D *tex_2d)
 {
   CoglContext *ctx = COGL_TEXTURE (tex_2d)->context;
 
   /* glGenerateMipmap is defined in the FBO extension. If it's not
-     available we'll fallback to temporarily enabling
+     available we'll build the levels on the CPU if the texture can
+     be read back. Otherwise we'll fallback to temporarily enabling
      GL_GENERATE_MIPMAP and reuploading the first pixel */
   if (cogl_has_feature (ctx, COGL_FEATURE_ID_OFFSCREEN))
     _cogl_texture_gl_generate_mipmaps (COGL_TEXTURE (tex_2d));
 #if defined(HAVE_COGL_GLES) || defined(HAVE_COGL_GL)
-  else
+  else if (!generate_mipmap_on_cpu (tex_2d))
     {
       _cogl_bind_gl_texture_transient (GL_TEXTURE_2D,
                                        tex_2d->gl_texture,
@@ -630,6 +874,9 @@ _cogl_texture_2d_gl_generate_mipmap (CoglTexture2D *tex_2d)
                                 GL_GENERATE_MIPMAP,
                                 GL_FALSE) );
     }
+#else
+  else
+    generate_mipmap_on_cpu (tex_2d);
 #endif
 }
 
@@ -41,6 +41,7 @@
 #include "cogl-texture-3d-private.h"
 #include "cogl-util.h"
 #include "cogl-pipeline-opengl-private.h"
+#include "cogl-texture-residency-private.h"
 
 static inline int
 calculate_alignment (int rowstride)
@@ -129,6 +130,8 @@ _cogl_texture_gl_maybe_update_max_level (CoglTexture *texture,
 
       GE( ctx, glTexParameteri (gl_target,
                                 GL_TEXTURE_MAX_LEVEL, texture->max_level));
+
+      _cogl_texture_residency_update (texture);
     }
 #endif /* HAVE_COGL_GL */
 }
@@ -139,6 +139,11 @@ _cogl_gl_util_get_texture_target_string (CoglTextureType texture_type,
       target_string = "2DRect";
       tex_coord_swizzle = "st";
       break;
+
+    case COGL_TEXTURE_TYPE_2D_ARRAY:
+      target_string = "2DArray";
+      tex_coord_swizzle = "stp";
+      break;
     }
 
   if (target_string_out)
@@ -594,12 +594,59 @@ _cogl_driver_update_features (CoglContext *ctx,
   if (ctx->glFenceSync)
     COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_FENCE, TRUE);
 
+  if (_cogl_check_extension ("GL_EXT_texture_compression_s3tc", gl_extensions))
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_TEXTURE_COMPRESSION_S3TC, TRUE);
+
+  if (COGL_CHECK_GL_VERSION (gl_major, gl_minor, 4, 3) ||
+      _cogl_check_extension ("GL_ARB_ES3_compatibility", gl_extensions))
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_TEXTURE_COMPRESSION_ETC2, TRUE);
+
+  if (COGL_CHECK_GL_VERSION (gl_major, gl_minor, 4, 2) ||
+      _cogl_check_extension ("GL_ARB_texture_compression_bptc", gl_extensions))
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_TEXTURE_COMPRESSION_BPTC, TRUE);
+
   if (COGL_CHECK_GL_VERSION (gl_major, gl_minor, 3, 0) ||
       _cogl_check_extension ("GL_ARB_texture_rg", gl_extensions))
     COGL_FLAGS_SET (ctx->features,
                     COGL_FEATURE_ID_TEXTURE_RG,
                     TRUE);
 
+  /* The extension is checked for explicitly even if the GL version
+   * includes the functions because the shaders need it to access
+   * gl_InstanceIDARB from the version of GLSL that Cogl uses */
+  if (ctx->glDrawArraysInstanced &&
+      ctx->glVertexAttribDivisor &&
+      COGL_FLAGS_GET (ctx->features, COGL_FEATURE_ID_GLSL) &&
+      _cogl_check_extension ("GL_ARB_draw_instanced", gl_extensions))
+    COGL_FLAGS_SET (ctx->features,
+                    COGL_FEATURE_ID_INSTANCED_DRAWING,
+                    TRUE);
+
+  /* As above the extension is needed for the layout qualifier on the
+   * uniform block containing the builtin matrices */
+  if (ctx->glGetUniformBlockIndex &&
+      COGL_FLAGS_GET (ctx->features, COGL_FEATURE_ID_GLSL) &&
+      _cogl_check_extension ("GL_ARB_uniform_buffer_object", gl_extensions))
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_UNIFORM_BUFFERS,
+                    TRUE);
+
+  /* Tiled textures are stored in an array texture and need the
+   * extension for the sampler2DArray type in GLSL. glGenerateMipmap
+   * is also required because there is no other way to generate the
+   * mipmaps of the layers */
+  if (ctx->glTexImage3D &&
+      ctx->glGenerateMipmap &&
+      COGL_FLAGS_GET (ctx->features, COGL_FEATURE_ID_GLSL) &&
+      COGL_FLAGS_GET (ctx->features, COGL_FEATURE_ID_TEXTURE_NPOT) &&
+      _cogl_check_extension ("GL_EXT_texture_array", gl_extensions))
+    COGL_FLAGS_SET (ctx->features,
+                    COGL_FEATURE_ID_TEXTURE_TILED,
+                    TRUE);
+
   /* Cache features */
   for (i = 0; i < G_N_ELEMENTS (private_features); i++)
     ctx->private_features[i] |= private_features[i];
@@ -635,6 +682,7 @@ _cogl_driver_gl =
     _cogl_framebuffer_gl_discard_buffers,
     _cogl_framebuffer_gl_draw_attributes,
     _cogl_framebuffer_gl_draw_indexed_attributes,
+    _cogl_framebuffer_gl_multi_draw_attributes,
     _cogl_framebuffer_gl_read_pixels_into_bitmap,
     _cogl_texture_2d_gl_free,
     _cogl_texture_2d_gl_can_create,
@@ -281,6 +281,9 @@ texture_type_to_arbfp_string (CoglTextureType texture_type)
       return "3D";
     case COGL_TEXTURE_TYPE_RECTANGLE:
       return "RECT";
+    case COGL_TEXTURE_TYPE_2D_ARRAY:
+      /* The ARBfp progend never handles tiled textures */
+      break;
     }
 
   g_warn_if_reached ();
@@ -834,7 +837,7 @@ _cogl_pipeline_fragend_arbfp_end (CoglPipeline *pipeline,
                            "program is compiled",
                            0 /* no application private data */);
 
-      COGL_COUNTER_INC (_cogl_uprof_context, fragend_arbfp_compile_counter);
+      COGL_COUNTER_INC (fragend_arbfp_compile_counter);
 
       g_string_append (shader_state->source,
                        "MOV result.color,output;\n");
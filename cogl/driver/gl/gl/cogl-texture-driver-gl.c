@@ -57,6 +57,12 @@
 #ifndef GL_TEXTURE_SWIZZLE_RGBA
 #define GL_TEXTURE_SWIZZLE_RGBA 0x8E46
 #endif
+#ifndef GL_TEXTURE_2D_ARRAY
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#endif
+#ifndef GL_PROXY_TEXTURE_2D_ARRAY
+#define GL_PROXY_TEXTURE_2D_ARRAY 0x8C1B
+#endif
 
 static GLuint
 _cogl_texture_driver_gen (CoglContext *ctx,
@@ -73,6 +79,7 @@ _cogl_texture_driver_gen (CoglContext *ctx,
     {
     case GL_TEXTURE_2D:
     case GL_TEXTURE_3D:
+    case GL_TEXTURE_2D_ARRAY:
       /* In case automatic mipmap generation gets disabled for this
        * texture but a minification filter depending on mipmap
        * interpolation is selected then we initialize the max mipmap
@@ -294,6 +301,8 @@ _cogl_texture_driver_upload_subregion_to_gl (CoglContext *ctx,
 
   if (_cogl_gl_util_catch_out_of_memory (ctx, error))
     status = FALSE;
+  else
+    ctx->frame_stats.n_bytes_uploaded += (uint64_t) width * height * bpp;
 
   _cogl_bitmap_gl_unbind (source_bmp);
 
@@ -354,6 +363,10 @@ _cogl_texture_driver_upload_to_gl (CoglContext *ctx,
 
   if (_cogl_gl_util_catch_out_of_memory (ctx, error))
     status = FALSE;
+  else
+    ctx->frame_stats.n_bytes_uploaded +=
+      ((uint64_t) cogl_bitmap_get_width (source_bmp) *
+       cogl_bitmap_get_height (source_bmp) * bpp);
 
   _cogl_bitmap_gl_unbind (source_bmp);
 
@@ -409,6 +422,9 @@ _cogl_texture_driver_upload_to_gl_3d (CoglContext *ctx,
 
   if (_cogl_gl_util_catch_out_of_memory (ctx, error))
     status = FALSE;
+  else
+    ctx->frame_stats.n_bytes_uploaded +=
+      (uint64_t) cogl_bitmap_get_width (source_bmp) * height * depth * bpp;
 
   _cogl_bitmap_gl_unbind (source_bmp);
 
@@ -444,6 +460,8 @@ _cogl_texture_driver_size_supported_3d (CoglContext *ctx,
 
   if (gl_target == GL_TEXTURE_3D)
     proxy_target = GL_PROXY_TEXTURE_3D;
+  else if (gl_target == GL_TEXTURE_2D_ARRAY)
+    proxy_target = GL_PROXY_TEXTURE_2D_ARRAY;
   else
     /* Unknown target, assume it's not supported */
     return FALSE;
@@ -399,6 +399,29 @@ _cogl_driver_update_features (CoglContext *context,
                     COGL_FEATURE_ID_TEXTURE_RG,
                     TRUE);
 
+  /* GLSL ES 1.00 can only access the instance ID through the
+   * extension even with GLES 3 */
+  if (context->glDrawArraysInstanced &&
+      context->glVertexAttribDivisor &&
+      COGL_FLAGS_GET (context->features, COGL_FEATURE_ID_GLSL) &&
+      _cogl_check_extension ("GL_EXT_draw_instanced", gl_extensions))
+    COGL_FLAGS_SET (context->features,
+                    COGL_FEATURE_ID_INSTANCED_DRAWING,
+                    TRUE);
+
+  if (_cogl_check_extension ("GL_EXT_texture_compression_s3tc", gl_extensions))
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_TEXTURE_COMPRESSION_S3TC, TRUE);
+
+  /* ETC2 is a required format in GLES 3 */
+  if (COGL_CHECK_GL_VERSION (gl_major, gl_minor, 3, 0))
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_TEXTURE_COMPRESSION_ETC2, TRUE);
+
+  if (_cogl_check_extension ("GL_EXT_texture_compression_bptc", gl_extensions))
+    COGL_FLAGS_SET (private_features,
+                    COGL_PRIVATE_FEATURE_TEXTURE_COMPRESSION_BPTC, TRUE);
+
   /* Cache features */
   for (i = 0; i < G_N_ELEMENTS (private_features); i++)
     context->private_features[i] |= private_features[i];
@@ -423,6 +446,7 @@ _cogl_driver_gles =
     _cogl_framebuffer_gl_discard_buffers,
     _cogl_framebuffer_gl_draw_attributes,
     _cogl_framebuffer_gl_draw_indexed_attributes,
+    _cogl_framebuffer_gl_multi_draw_attributes,
     _cogl_framebuffer_gl_read_pixels_into_bitmap,
     _cogl_texture_2d_gl_free,
     _cogl_texture_2d_gl_can_create,
@@ -321,6 +321,8 @@ _cogl_texture_driver_upload_subregion_to_gl (CoglContext *ctx,
 
   if (_cogl_gl_util_catch_out_of_memory (ctx, error))
     status = FALSE;
+  else
+    ctx->frame_stats.n_bytes_uploaded += (uint64_t) width * height * bpp;
 
   _cogl_bitmap_gl_unbind (slice_bmp);
 
@@ -391,6 +393,9 @@ _cogl_texture_driver_upload_to_gl (CoglContext *ctx,
 
   if (_cogl_gl_util_catch_out_of_memory (ctx, error))
     status = FALSE;
+  else
+    ctx->frame_stats.n_bytes_uploaded +=
+      (uint64_t) bmp_width * bmp_height * bpp;
 
   _cogl_bitmap_gl_unbind (bmp);
 
@@ -509,6 +514,9 @@ _cogl_texture_driver_upload_to_gl_3d (CoglContext *ctx,
               return FALSE;
             }
 
+          ctx->frame_stats.n_bytes_uploaded +=
+            (uint64_t) bmp_width * height * bpp;
+
           _cogl_bitmap_gl_unbind (bmp);
         }
 
@@ -543,6 +551,9 @@ _cogl_texture_driver_upload_to_gl_3d (CoglContext *ctx,
           return FALSE;
         }
 
+      ctx->frame_stats.n_bytes_uploaded +=
+        (uint64_t) bmp_width * height * depth * bpp;
+
       _cogl_bitmap_gl_unbind (source_bmp);
     }
 
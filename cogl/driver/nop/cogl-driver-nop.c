@@ -44,6 +44,27 @@
 #include "cogl-attribute-nop-private.h"
 #include "cogl-clip-stack-nop-private.h"
 
+static CoglPixelFormat
+_cogl_driver_pixel_format_to_gl (CoglContext *context,
+                                 CoglPixelFormat format,
+                                 GLenum *out_glintformat,
+                                 GLenum *out_glformat,
+                                 GLenum *out_gltype)
+{
+  /* There are no GL enums to map to but the front end still uses the
+   * returned format to decide how bitmaps need to be converted
+   * before being uploaded so we claim every format is supported
+   * as-is */
+  if (out_glintformat != NULL)
+    *out_glintformat = 0;
+  if (out_glformat != NULL)
+    *out_glformat = 0;
+  if (out_gltype != NULL)
+    *out_gltype = 0;
+
+  return format;
+}
+
 static CoglBool
 _cogl_driver_update_features (CoglContext *ctx,
                               CoglError **error)
@@ -59,7 +80,7 @@ const CoglDriverVtable
 _cogl_driver_nop =
   {
     NULL, /* pixel_format_from_gl_internal */
-    NULL, /* pixel_format_to_gl */
+    _cogl_driver_pixel_format_to_gl,
     _cogl_driver_update_features,
     _cogl_offscreen_nop_allocate,
     _cogl_offscreen_nop_free,
@@ -70,6 +91,7 @@ _cogl_driver_nop =
     _cogl_framebuffer_nop_discard_buffers,
     _cogl_framebuffer_nop_draw_attributes,
     _cogl_framebuffer_nop_draw_indexed_attributes,
+    _cogl_framebuffer_nop_multi_draw_attributes,
     _cogl_framebuffer_nop_read_pixels_into_bitmap,
     _cogl_texture_2d_nop_free,
     _cogl_texture_2d_nop_can_create,
@@ -90,6 +90,7 @@ _cogl_framebuffer_nop_draw_attributes (CoglFramebuffer *framebuffer,
                                        CoglVerticesMode mode,
                                        int first_vertex,
                                        int n_vertices,
+                                       int n_instances,
                                        CoglAttribute **attributes,
                                        int n_attributes,
                                        CoglDrawFlags flags)
@@ -102,6 +103,7 @@ _cogl_framebuffer_nop_draw_indexed_attributes (CoglFramebuffer *framebuffer,
                                                CoglVerticesMode mode,
                                                int first_vertex,
                                                int n_vertices,
+                                               int n_instances,
                                                CoglIndices *indices,
                                                CoglAttribute **attributes,
                                                int n_attributes,
@@ -109,6 +111,20 @@ _cogl_framebuffer_nop_draw_indexed_attributes (CoglFramebuffer *framebuffer,
 {
 }
 
+void
+_cogl_framebuffer_nop_multi_draw_attributes (CoglFramebuffer *framebuffer,
+                                             CoglPipeline *pipeline,
+                                             CoglVerticesMode mode,
+                                             const int *first_vertices,
+                                             const int *n_vertices,
+                                             int n_draws,
+                                             CoglIndices *indices,
+                                             CoglAttribute **attributes,
+                                             int n_attributes,
+                                             CoglDrawFlags flags)
+{
+}
+
 CoglBool
 _cogl_framebuffer_nop_read_pixels_into_bitmap (CoglFramebuffer *framebuffer,
                                                int x,
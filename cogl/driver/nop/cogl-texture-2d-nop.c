@@ -41,6 +41,7 @@
 #include "cogl-private.h"
 #include "cogl-texture-2d-nop-private.h"
 #include "cogl-texture-2d-private.h"
+#include "cogl-bitmap-private.h"
 #include "cogl-error-private.h"
 
 void
@@ -62,11 +63,68 @@ _cogl_texture_2d_nop_init (CoglTexture2D *tex_2d)
 {
 }
 
+static CoglBool
+allocate_from_bitmap (CoglTexture2D *tex_2d,
+                      CoglTextureLoader *loader,
+                      CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_2d);
+  CoglBitmap *bmp = loader->src.bitmap.bitmap;
+  CoglPixelFormat internal_format;
+  CoglBitmap *upload_bmp;
+
+  internal_format =
+    _cogl_texture_determine_internal_format (tex, cogl_bitmap_get_format (bmp));
+
+  /* Nothing is uploaded but the bitmap is still converted the same
+   * way as for the GL drivers so that the CPU side cost of creating a
+   * texture is representative when profiling with this driver */
+  upload_bmp =
+    _cogl_bitmap_convert_for_upload (bmp,
+                                     internal_format,
+                                     loader->src.bitmap.can_convert_in_place,
+                                     error);
+  if (upload_bmp == NULL)
+    return FALSE;
+
+  cogl_object_unref (upload_bmp);
+
+  tex_2d->internal_format = internal_format;
+
+  _cogl_texture_set_allocated (tex,
+                               internal_format,
+                               cogl_bitmap_get_width (bmp),
+                               cogl_bitmap_get_height (bmp));
+
+  return TRUE;
+}
+
 CoglBool
 _cogl_texture_2d_nop_allocate (CoglTexture *tex,
                                CoglError **error)
 {
-  return TRUE;
+  CoglTexture2D *tex_2d = COGL_TEXTURE_2D (tex);
+  CoglTextureLoader *loader = tex->loader;
+  CoglPixelFormat internal_format;
+
+  _COGL_RETURN_VAL_IF_FAIL (loader, FALSE);
+
+  switch (loader->src_type)
+    {
+    case COGL_TEXTURE_SOURCE_TYPE_SIZED:
+      internal_format =
+        _cogl_texture_determine_internal_format (tex, COGL_PIXEL_FORMAT_ANY);
+      tex_2d->internal_format = internal_format;
+      _cogl_texture_set_allocated (tex,
+                                   internal_format,
+                                   loader->src.sized.width,
+                                   loader->src.sized.height);
+      return TRUE;
+    case COGL_TEXTURE_SOURCE_TYPE_BITMAP:
+      return allocate_from_bitmap (tex_2d, loader, error);
+    default:
+      return TRUE;
+    }
 }
 
 void
@@ -0,0 +1,85 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-types.h"
+#include "cogl-framebuffer.h"
+#include "cogl-attribute.h"
+#include "cogl-attribute-private.h"
+#include "cogl-attribute-sw-private.h"
+#include "cogl-pipeline-sw-private.h"
+#include "cogl-framebuffer-sw-private.h"
+
+void
+_cogl_sw_flush_attributes_state (CoglFramebuffer *framebuffer,
+                                 CoglPipeline *pipeline,
+                                 CoglFlushLayerState *layers_state,
+                                 CoglDrawFlags flags,
+                                 CoglAttribute **attributes,
+                                 int n_attributes)
+{
+  CoglFramebufferSw *sw_framebuffer = _cogl_framebuffer_sw_get (framebuffer);
+  CoglBool with_color_attrib = FALSE;
+  CoglBool unknown_color_alpha = FALSE;
+  CoglPipeline *copy = NULL;
+  int i;
+
+  if (sw_framebuffer == NULL)
+    return;
+
+  /* Iterate the attributes to see if we have a color attribute which
+   * may affect our decision to enable blending or not */
+  for (i = 0; i < n_attributes; i++)
+    if (attributes[i]->name_state->name_id ==
+        COGL_ATTRIBUTE_NAME_ID_COLOR_ARRAY)
+      {
+        if ((flags & COGL_DRAW_COLOR_ATTRIBUTE_IS_OPAQUE) == 0 &&
+            _cogl_attribute_get_n_components (attributes[i]) == 4)
+          unknown_color_alpha = TRUE;
+        with_color_attrib = TRUE;
+      }
+
+  if (G_UNLIKELY (layers_state->options.flags))
+    {
+      copy = cogl_pipeline_copy (pipeline);
+      pipeline = copy;
+      _cogl_pipeline_apply_overrides (pipeline, &layers_state->options);
+    }
+
+  _cogl_pipeline_sw_flush_state (pipeline,
+                                 framebuffer,
+                                 with_color_attrib,
+                                 unknown_color_alpha,
+                                 &sw_framebuffer->state);
+
+  if (copy)
+    cogl_object_unref (copy);
+}
@@ -0,0 +1,208 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-clip-stack.h"
+#include "cogl-clip-stack-sw-private.h"
+#include "cogl-framebuffer-sw-private.h"
+#include "cogl-framebuffer-private.h"
+#include "cogl-matrix-stack-private.h"
+
+#include <string.h>
+
+static void
+add_rectangle_coverage (CoglContext *ctx,
+                        CoglFramebuffer *framebuffer,
+                        CoglClipStackRect *rect,
+                        const CoglSwTarget *target,
+                        uint8_t *coverage)
+{
+  CoglMatrix modelview, projection, mvp;
+  CoglSwVertex vertices[4];
+  float corners[4][2] = {
+    { rect->x0, rect->y0 },
+    { rect->x1, rect->y0 },
+    { rect->x1, rect->y1 },
+    { rect->x0, rect->y1 }
+  };
+  int i;
+
+  cogl_matrix_entry_get (rect->matrix_entry, &modelview);
+  cogl_matrix_entry_get (_cogl_framebuffer_get_projection_entry (framebuffer),
+                         &projection);
+  cogl_matrix_multiply (&mvp, &projection, &modelview);
+
+  for (i = 0; i < 4; i++)
+    {
+      float *p = vertices[i].position;
+
+      p[0] = corners[i][0];
+      p[1] = corners[i][1];
+      p[2] = 0.0f;
+      p[3] = 1.0f;
+
+      cogl_matrix_transform_point (&mvp, p, p + 1, p + 2, p + 3);
+    }
+
+  _cogl_rasterizer_sw_fill_coverage (ctx,
+                                     target,
+                                     COGL_VERTICES_MODE_TRIANGLE_FAN,
+                                     vertices,
+                                     NULL, /* indices */
+                                     4,
+                                     coverage,
+                                     target->color.width,
+                                     FALSE /* don't invert */);
+}
+
+void
+_cogl_clip_stack_sw_flush (CoglClipStack *stack,
+                           CoglFramebuffer *framebuffer)
+{
+  CoglContext *ctx = framebuffer->context;
+  CoglFramebufferSw *sw_framebuffer = _cogl_framebuffer_sw_get (framebuffer);
+  CoglSwTarget target;
+  CoglClipStack *entry;
+  CoglBool needs_mask = FALSE;
+  int width, height, size;
+  int x0, y0, x1, y1;
+  int y;
+
+  if (sw_framebuffer == NULL)
+    return;
+
+  width = sw_framebuffer->color.width;
+  height = sw_framebuffer->color.height;
+
+  /* The clip mask only needs to be regenerated if the stack, the
+   * viewport or the size of the framebuffer has changed since it was
+   * last flushed */
+  if (sw_framebuffer->clip_valid &&
+      sw_framebuffer->clip_stack == stack &&
+      sw_framebuffer->clip_viewport_age == framebuffer->viewport_age &&
+      sw_framebuffer->clip_width == width &&
+      sw_framebuffer->clip_height == height)
+    return;
+
+  if (sw_framebuffer->clip_valid)
+    _cogl_clip_stack_unref (sw_framebuffer->clip_stack);
+
+  sw_framebuffer->clip_valid = FALSE;
+  sw_framebuffer->use_clip_mask = FALSE;
+
+  _cogl_clip_stack_get_bounds (stack, &x0, &y0, &x1, &y1);
+
+  x0 = CLAMP (x0, 0, width);
+  y0 = CLAMP (y0, 0, height);
+  x1 = CLAMP (x1, x0, width);
+  y1 = CLAMP (y1, y0, height);
+
+  sw_framebuffer->scissor_x0 = x0;
+  sw_framebuffer->scissor_y0 = y0;
+  sw_framebuffer->scissor_x1 = x1;
+  sw_framebuffer->scissor_y1 = y1;
+
+  for (entry = stack; entry; entry = entry->parent)
+    if (entry->type == COGL_CLIP_STACK_PRIMITIVE ||
+        (entry->type == COGL_CLIP_STACK_RECT &&
+         !((CoglClipStackRect *) entry)->can_be_scissor))
+      needs_mask = TRUE;
+
+  sw_framebuffer->clip_stack = _cogl_clip_stack_ref (stack);
+  sw_framebuffer->clip_viewport_age = framebuffer->viewport_age;
+  sw_framebuffer->clip_width = width;
+  sw_framebuffer->clip_height = height;
+  sw_framebuffer->clip_valid = TRUE;
+
+  if (!needs_mask || x0 >= x1 || y0 >= y1)
+    return;
+
+  size = width * height;
+  if (sw_framebuffer->clip_mask_size < size)
+    {
+      g_free (sw_framebuffer->clip_mask);
+      g_free (sw_framebuffer->clip_scratch);
+      sw_framebuffer->clip_mask = g_malloc (size);
+      sw_framebuffer->clip_scratch = g_malloc (size);
+      sw_framebuffer->clip_mask_size = size;
+    }
+
+  /* Everything inside the scissor starts off visible and each entry
+   * that needs the mask is then intersected with it in the same way
+   * that the GL driver combines the entries in the stencil buffer */
+  for (y = y0; y < y1; y++)
+    memset (sw_framebuffer->clip_mask + y * width + x0, 0xff, x1 - x0);
+
+  _cogl_framebuffer_sw_init_target (framebuffer, sw_framebuffer, &target);
+
+  for (entry = stack; entry; entry = entry->parent)
+    {
+      uint8_t *mask = sw_framebuffer->clip_mask;
+      uint8_t *scratch = sw_framebuffer->clip_scratch;
+      int x;
+
+      if (entry->type == COGL_CLIP_STACK_PRIMITIVE)
+        {
+          CoglClipStackPrimitive *primitive_entry =
+            (CoglClipStackPrimitive *) entry;
+
+          for (y = y0; y < y1; y++)
+            memset (scratch + y * width + x0, 0, x1 - x0);
+
+          _cogl_framebuffer_sw_fill_coverage (framebuffer,
+                                              primitive_entry->matrix_entry,
+                                              primitive_entry->primitive,
+                                              &target,
+                                              scratch,
+                                              TRUE /* invert */);
+        }
+      else if (entry->type == COGL_CLIP_STACK_RECT &&
+               !((CoglClipStackRect *) entry)->can_be_scissor)
+        {
+          for (y = y0; y < y1; y++)
+            memset (scratch + y * width + x0, 0, x1 - x0);
+
+          add_rectangle_coverage (ctx,
+                                  framebuffer,
+                                  (CoglClipStackRect *) entry,
+                                  &target,
+                                  scratch);
+        }
+      else
+        continue;
+
+      for (y = y0; y < y1; y++)
+        for (x = x0; x < x1; x++)
+          mask[y * width + x] &= scratch[y * width + x];
+    }
+
+  sw_framebuffer->use_clip_mask = TRUE;
+}
@@ -0,0 +1,125 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "cogl-private.h"
+#include "cogl-context-private.h"
+#include "cogl-feature-private.h"
+#include "cogl-renderer-private.h"
+#include "cogl-error-private.h"
+#include "cogl-framebuffer-sw-private.h"
+#include "cogl-texture-2d-sw-private.h"
+#include "cogl-attribute-sw-private.h"
+#include "cogl-clip-stack-sw-private.h"
+
+static CoglPixelFormat
+_cogl_driver_pixel_format_to_gl (CoglContext *context,
+                                 CoglPixelFormat format,
+                                 GLenum *out_glintformat,
+                                 GLenum *out_glformat,
+                                 GLenum *out_gltype)
+{
+  /* The rasterizer only works with 8 bits per component RGBA so
+   * every format is converted to that before being uploaded. The
+   * premultiplied state is kept so that blending behaves the same
+   * as it would with GL. */
+  if (out_glintformat != NULL)
+    *out_glintformat = 0;
+  if (out_glformat != NULL)
+    *out_glformat = 0;
+  if (out_gltype != NULL)
+    *out_gltype = 0;
+
+  if ((format & COGL_A_BIT) && (format & COGL_PREMULT_BIT))
+    return COGL_PIXEL_FORMAT_RGBA_8888_PRE;
+  else
+    return COGL_PIXEL_FORMAT_RGBA_8888;
+}
+
+static CoglBool
+_cogl_driver_update_features (CoglContext *ctx,
+                              CoglError **error)
+{
+  memset (ctx->private_features, 0, sizeof (ctx->private_features));
+
+  COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_OFFSCREEN, TRUE);
+  COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_TEXTURE_NPOT, TRUE);
+  COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_TEXTURE_NPOT_BASIC, TRUE);
+  COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_TEXTURE_NPOT_REPEAT, TRUE);
+  COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_MIRRORED_REPEAT, TRUE);
+  COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_UNSIGNED_INT_INDICES, TRUE);
+  COGL_FLAGS_SET (ctx->features, COGL_FEATURE_ID_INSTANCED_DRAWING, TRUE);
+
+  /* Alpha-only textures are expanded to RGBA when they are uploaded
+   * so they don't need any special treatment in the front end */
+  COGL_FLAGS_SET (ctx->private_features,
+                  COGL_PRIVATE_FEATURE_ALPHA_TEXTURES, TRUE);
+  COGL_FLAGS_SET (ctx->private_features,
+                  COGL_PRIVATE_FEATURE_BLEND_CONSTANT, TRUE);
+  /* Only the base level is ever sampled so the number of levels is
+   * effectively always limited */
+  COGL_FLAGS_SET (ctx->private_features,
+                  COGL_PRIVATE_FEATURE_TEXTURE_MAX_LEVEL, TRUE);
+
+  return TRUE;
+}
+
+const CoglDriverVtable
+_cogl_driver_sw =
+  {
+    NULL, /* pixel_format_from_gl_internal */
+    _cogl_driver_pixel_format_to_gl,
+    _cogl_driver_update_features,
+    _cogl_offscreen_sw_allocate,
+    _cogl_offscreen_sw_free,
+    _cogl_framebuffer_sw_flush_state,
+    _cogl_framebuffer_sw_clear,
+    _cogl_framebuffer_sw_query_bits,
+    _cogl_framebuffer_sw_finish,
+    _cogl_framebuffer_sw_discard_buffers,
+    _cogl_framebuffer_sw_draw_attributes,
+    _cogl_framebuffer_sw_draw_indexed_attributes,
+    _cogl_framebuffer_sw_multi_draw_attributes,
+    _cogl_framebuffer_sw_read_pixels_into_bitmap,
+    _cogl_texture_2d_sw_free,
+    _cogl_texture_2d_sw_can_create,
+    _cogl_texture_2d_sw_init,
+    _cogl_texture_2d_sw_allocate,
+    _cogl_texture_2d_sw_copy_from_framebuffer,
+    _cogl_texture_2d_sw_get_gl_handle,
+    _cogl_texture_2d_sw_generate_mipmap,
+    _cogl_texture_2d_sw_copy_from_bitmap,
+    _cogl_texture_2d_sw_get_data,
+    _cogl_sw_flush_attributes_state,
+    _cogl_clip_stack_sw_flush,
+  };
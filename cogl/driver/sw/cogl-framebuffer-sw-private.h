@@ -0,0 +1,176 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COGL_FRAMEBUFFER_SW_PRIVATE_H_
+#define _COGL_FRAMEBUFFER_SW_PRIVATE_H_
+
+#include "cogl-types.h"
+#include "cogl-context-private.h"
+#include "cogl-clip-stack.h"
+#include "cogl-rasterizer-sw-private.h"
+
+typedef struct _CoglFramebufferSw
+{
+  /* The pixels that are rendered to. For offscreen framebuffers this
+   * points into the image of the texture, otherwise it points to
+   * onscreen_data */
+  CoglSwImage color;
+  uint8_t *onscreen_data;
+
+  /* The clip state last flushed with _cogl_clip_stack_sw_flush() */
+  CoglBool clip_valid;
+  CoglClipStack *clip_stack;
+  int clip_viewport_age;
+  int clip_width;
+  int clip_height;
+  int scissor_x0;
+  int scissor_y0;
+  int scissor_x1;
+  int scissor_y1;
+  /* This is only used if the clip stack contains an entry that can't
+   * be described by the scissor alone */
+  CoglBool use_clip_mask;
+  uint8_t *clip_mask;
+  uint8_t *clip_scratch;
+  int clip_mask_size;
+
+  /* The pipeline state last flushed with
+   * _cogl_sw_flush_attributes_state() */
+  CoglSwState state;
+} CoglFramebufferSw;
+
+/*
+ * _cogl_framebuffer_sw_get:
+ * @framebuffer: A #CoglFramebuffer
+ *
+ * Gets the software driver state of @framebuffer, creating it or
+ * resizing the storage of an onscreen framebuffer as needed.
+ *
+ * Return value: The state or %NULL if the framebuffer has no storage
+ */
+CoglFramebufferSw *
+_cogl_framebuffer_sw_get (CoglFramebuffer *framebuffer);
+
+CoglSwImage *
+_cogl_framebuffer_sw_get_color_image (CoglFramebuffer *framebuffer);
+
+void
+_cogl_framebuffer_sw_init_target (CoglFramebuffer *framebuffer,
+                                  CoglFramebufferSw *sw_framebuffer,
+                                  CoglSwTarget *target);
+
+/*
+ * _cogl_framebuffer_sw_fill_coverage:
+ *
+ * Rasterizes the silhouette of @primitive transformed by
+ * @modelview_entry and the projection of @framebuffer into
+ * @coverage. This is used to clip to primitives.
+ */
+void
+_cogl_framebuffer_sw_fill_coverage (CoglFramebuffer *framebuffer,
+                                    CoglMatrixEntry *modelview_entry,
+                                    CoglPrimitive *primitive,
+                                    const CoglSwTarget *target,
+                                    uint8_t *coverage,
+                                    CoglBool invert);
+
+CoglBool
+_cogl_offscreen_sw_allocate (CoglOffscreen *offscreen,
+                             CoglError **error);
+
+void
+_cogl_offscreen_sw_free (CoglOffscreen *offscreen);
+
+void
+_cogl_framebuffer_sw_flush_state (CoglFramebuffer *draw_buffer,
+                                  CoglFramebuffer *read_buffer,
+                                  CoglFramebufferState state);
+
+void
+_cogl_framebuffer_sw_clear (CoglFramebuffer *framebuffer,
+                            unsigned long buffers,
+                            float red,
+                            float green,
+                            float blue,
+                            float alpha);
+
+void
+_cogl_framebuffer_sw_query_bits (CoglFramebuffer *framebuffer,
+                                 CoglFramebufferBits *bits);
+
+void
+_cogl_framebuffer_sw_finish (CoglFramebuffer *framebuffer);
+
+void
+_cogl_framebuffer_sw_discard_buffers (CoglFramebuffer *framebuffer,
+                                      unsigned long buffers);
+
+void
+_cogl_framebuffer_sw_draw_attributes (CoglFramebuffer *framebuffer,
+                                      CoglPipeline *pipeline,
+                                      CoglVerticesMode mode,
+                                      int first_vertex,
+                                      int n_vertices,
+                                      int n_instances,
+                                      CoglAttribute **attributes,
+                                      int n_attributes,
+                                      CoglDrawFlags flags);
+
+void
+_cogl_framebuffer_sw_draw_indexed_attributes (CoglFramebuffer *framebuffer,
+                                              CoglPipeline *pipeline,
+                                              CoglVerticesMode mode,
+                                              int first_vertex,
+                                              int n_vertices,
+                                              int n_instances,
+                                              CoglIndices *indices,
+                                              CoglAttribute **attributes,
+                                              int n_attributes,
+                                              CoglDrawFlags flags);
+
+void
+_cogl_framebuffer_sw_multi_draw_attributes (CoglFramebuffer *framebuffer,
+                                            CoglPipeline *pipeline,
+                                            CoglVerticesMode mode,
+                                            const int *first_vertices,
+                                            const int *n_vertices,
+                                            int n_draws,
+                                            CoglIndices *indices,
+                                            CoglAttribute **attributes,
+                                            int n_attributes,
+                                            CoglDrawFlags flags);
+
+CoglBool
+_cogl_framebuffer_sw_read_pixels_into_bitmap (CoglFramebuffer *framebuffer,
+                                              int x,
+                                              int y,
+                                              CoglReadPixelsFlags source,
+                                              CoglBitmap *bitmap,
+                                              CoglError **error);
+
+#endif /* _COGL_FRAMEBUFFER_SW_PRIVATE_H_ */
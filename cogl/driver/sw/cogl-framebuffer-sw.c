@@ -0,0 +1,838 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-framebuffer-sw-private.h"
+#include "cogl-texture-2d-sw-private.h"
+#include "cogl-framebuffer-private.h"
+#include "cogl-offscreen.h"
+#include "cogl-attribute-private.h"
+#include "cogl-buffer-private.h"
+#include "cogl-indices-private.h"
+#include "cogl-primitive-private.h"
+#include "cogl-bitmap-private.h"
+#include "cogl-clip-stack.h"
+#include "cogl-error-private.h"
+#include "cogl-profile.h"
+#include "cogl-private.h"
+
+#include <glib.h>
+#include <string.h>
+
+static CoglUserDataKey framebuffer_sw_key;
+
+static void
+destroy_framebuffer_sw (void *user_data,
+                        void *instance)
+{
+  CoglFramebufferSw *sw_framebuffer = user_data;
+
+  if (sw_framebuffer->clip_valid)
+    _cogl_clip_stack_unref (sw_framebuffer->clip_stack);
+
+  g_free (sw_framebuffer->onscreen_data);
+  g_free (sw_framebuffer->clip_mask);
+  g_free (sw_framebuffer->clip_scratch);
+
+  g_slice_free (CoglFramebufferSw, sw_framebuffer);
+}
+
+static CoglFramebufferSw *
+get_framebuffer_sw (CoglFramebuffer *framebuffer)
+{
+  CoglFramebufferSw *sw_framebuffer =
+    cogl_object_get_user_data (COGL_OBJECT (framebuffer),
+                               &framebuffer_sw_key);
+
+  if (sw_framebuffer == NULL)
+    {
+      sw_framebuffer = g_slice_new0 (CoglFramebufferSw);
+
+      _cogl_object_set_user_data (COGL_OBJECT (framebuffer),
+                                  &framebuffer_sw_key,
+                                  sw_framebuffer,
+                                  destroy_framebuffer_sw);
+    }
+
+  return sw_framebuffer;
+}
+
+CoglFramebufferSw *
+_cogl_framebuffer_sw_get (CoglFramebuffer *framebuffer)
+{
+  CoglContext *ctx = framebuffer->context;
+  CoglFramebufferSw *sw_framebuffer;
+
+  /* Lazily ensure the framebuffer has been allocated */
+  if (G_UNLIKELY (!framebuffer->allocated) &&
+      !cogl_framebuffer_allocate (framebuffer, NULL))
+    return NULL;
+
+  sw_framebuffer = get_framebuffer_sw (framebuffer);
+
+  if (framebuffer->type == COGL_FRAMEBUFFER_TYPE_ONSCREEN &&
+      (sw_framebuffer->onscreen_data == NULL ||
+       sw_framebuffer->color.width != framebuffer->width ||
+       sw_framebuffer->color.height != framebuffer->height))
+    {
+      CoglSwImage *color = &sw_framebuffer->color;
+
+      if (framebuffer->width <= 0 || framebuffer->height <= 0)
+        return NULL;
+
+      /* The onscreen storage is lazily (re)allocated whenever the
+       * size of the window changes */
+      g_free (sw_framebuffer->onscreen_data);
+
+      color->width = framebuffer->width;
+      color->height = framebuffer->height;
+      color->rowstride = framebuffer->width * 4;
+      color->format =
+        ctx->driver_vtable->pixel_format_to_gl (ctx,
+                                                framebuffer->internal_format,
+                                                NULL, NULL, NULL);
+      sw_framebuffer->onscreen_data =
+        g_malloc0 (color->rowstride * color->height);
+      color->data = sw_framebuffer->onscreen_data;
+    }
+
+  if (sw_framebuffer->color.data == NULL)
+    return NULL;
+
+  return sw_framebuffer;
+}
+
+CoglSwImage *
+_cogl_framebuffer_sw_get_color_image (CoglFramebuffer *framebuffer)
+{
+  CoglFramebufferSw *sw_framebuffer = _cogl_framebuffer_sw_get (framebuffer);
+
+  return sw_framebuffer ? &sw_framebuffer->color : NULL;
+}
+
+void
+_cogl_framebuffer_sw_init_target (CoglFramebuffer *framebuffer,
+                                  CoglFramebufferSw *sw_framebuffer,
+                                  CoglSwTarget *target)
+{
+  target->color = sw_framebuffer->color;
+
+  target->scissor_x0 = 0;
+  target->scissor_y0 = 0;
+  target->scissor_x1 = sw_framebuffer->color.width;
+  target->scissor_y1 = sw_framebuffer->color.height;
+  target->clip_mask = NULL;
+  target->clip_mask_rowstride = sw_framebuffer->color.width;
+
+  if (sw_framebuffer->clip_valid)
+    {
+      target->scissor_x0 = MAX (target->scissor_x0,
+                                sw_framebuffer->scissor_x0);
+      target->scissor_y0 = MAX (target->scissor_y0,
+                                sw_framebuffer->scissor_y0);
+      target->scissor_x1 = MIN (target->scissor_x1,
+                                sw_framebuffer->scissor_x1);
+      target->scissor_y1 = MIN (target->scissor_y1,
+                                sw_framebuffer->scissor_y1);
+
+      if (sw_framebuffer->use_clip_mask)
+        target->clip_mask = sw_framebuffer->clip_mask;
+    }
+
+  target->viewport[0] = framebuffer->viewport_x;
+  target->viewport[1] = framebuffer->viewport_y;
+  target->viewport[2] = framebuffer->viewport_width;
+  target->viewport[3] = framebuffer->viewport_height;
+}
+
+CoglBool
+_cogl_offscreen_sw_allocate (CoglOffscreen *offscreen,
+                             CoglError **error)
+{
+  CoglFramebuffer *framebuffer = COGL_FRAMEBUFFER (offscreen);
+  CoglFramebufferSw *sw_framebuffer;
+  CoglSwImage *image;
+  int x_offset, y_offset;
+
+  image = _cogl_texture_sw_get_image (offscreen->texture,
+                                      &x_offset, &y_offset);
+
+  if (image == NULL || offscreen->texture_level != 0)
+    {
+      _cogl_set_error (error, COGL_FRAMEBUFFER_ERROR,
+                       COGL_FRAMEBUFFER_ERROR_ALLOCATE,
+                       "The software driver can only render to the base "
+                       "level of a 2D texture");
+      return FALSE;
+    }
+
+  sw_framebuffer = get_framebuffer_sw (framebuffer);
+
+  sw_framebuffer->color = *image;
+  sw_framebuffer->color.data = (image->data +
+                                y_offset * image->rowstride +
+                                x_offset * 4);
+  sw_framebuffer->color.width = MIN (framebuffer->width,
+                                     image->width - x_offset);
+  sw_framebuffer->color.height = MIN (framebuffer->height,
+                                      image->height - y_offset);
+
+  return TRUE;
+}
+
+void
+_cogl_offscreen_sw_free (CoglOffscreen *offscreen)
+{
+  /* The state is attached as user data so it will be freed along with
+   * the framebuffer */
+}
+
+void
+_cogl_framebuffer_sw_flush_state (CoglFramebuffer *draw_buffer,
+                                  CoglFramebuffer *read_buffer,
+                                  CoglFramebufferState state)
+{
+  CoglContext *ctx = draw_buffer->context;
+
+  /* There is nothing to bind but the front end uses the current draw
+   * buffer to track which state needs flushing */
+  ctx->current_draw_buffer = draw_buffer;
+  ctx->current_read_buffer = read_buffer;
+
+  if (state & COGL_FRAMEBUFFER_STATE_MODELVIEW)
+    _cogl_context_set_current_modelview_entry
+      (ctx, _cogl_framebuffer_get_modelview_entry (draw_buffer));
+
+  if (state & COGL_FRAMEBUFFER_STATE_PROJECTION)
+    _cogl_context_set_current_projection_entry
+      (ctx, _cogl_framebuffer_get_projection_entry (draw_buffer));
+
+  if (state & COGL_FRAMEBUFFER_STATE_CLIP)
+    _cogl_clip_stack_flush (_cogl_framebuffer_get_clip_stack (draw_buffer),
+                            draw_buffer);
+
+  ctx->current_draw_buffer_state_flushed |= state;
+  ctx->current_draw_buffer_changes &= ~state;
+}
+
+void
+_cogl_framebuffer_sw_clear (CoglFramebuffer *framebuffer,
+                            unsigned long buffers,
+                            float red,
+                            float green,
+                            float blue,
+                            float alpha)
+{
+  CoglFramebufferSw *sw_framebuffer;
+  CoglSwTarget target;
+  float color[4];
+
+  /* There is only a color buffer */
+  if (!(buffers & COGL_BUFFER_BIT_COLOR))
+    return;
+
+  sw_framebuffer = _cogl_framebuffer_sw_get (framebuffer);
+  if (sw_framebuffer == NULL)
+    return;
+
+  color[0] = red;
+  color[1] = green;
+  color[2] = blue;
+  color[3] = alpha;
+
+  /* Like glClear, clearing is only affected by the scissor and not
+   * by the stencil clip */
+  _cogl_framebuffer_sw_init_target (framebuffer, sw_framebuffer, &target);
+
+  _cogl_rasterizer_sw_clear (framebuffer->context,
+                             &target,
+                             color,
+                             framebuffer->color_mask);
+}
+
+void
+_cogl_framebuffer_sw_query_bits (CoglFramebuffer *framebuffer,
+                                 CoglFramebufferBits *bits)
+{
+  memset (bits, 0, sizeof (CoglFramebufferBits));
+
+  bits->red = 8;
+  bits->green = 8;
+  bits->blue = 8;
+  bits->alpha = 8;
+}
+
+void
+_cogl_framebuffer_sw_finish (CoglFramebuffer *framebuffer)
+{
+  /* All drawing is finished by the time the draw functions return */
+}
+
+void
+_cogl_framebuffer_sw_discard_buffers (CoglFramebuffer *framebuffer,
+                                      unsigned long buffers)
+{
+}
+
+static float
+read_component (const uint8_t *data,
+                CoglAttributeType type,
+                CoglBool normalized,
+                int component)
+{
+  switch (type)
+    {
+    case COGL_ATTRIBUTE_TYPE_BYTE:
+      {
+        int8_t value = ((const int8_t *) data)[component];
+        return normalized ? MAX (value / 127.0f, -1.0f) : value;
+      }
+    case COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE:
+      {
+        uint8_t value = data[component];
+        return normalized ? value / 255.0f : value;
+      }
+    case COGL_ATTRIBUTE_TYPE_SHORT:
+      {
+        int16_t value;
+        memcpy (&value, data + component * 2, 2);
+        return normalized ? MAX (value / 32767.0f, -1.0f) : value;
+      }
+    case COGL_ATTRIBUTE_TYPE_UNSIGNED_SHORT:
+      {
+        uint16_t value;
+        memcpy (&value, data + component * 2, 2);
+        return normalized ? value / 65535.0f : value;
+      }
+    default:
+      {
+        float value;
+        memcpy (&value, data + component * 4, 4);
+        return value;
+      }
+    }
+}
+
+static void
+read_attribute (CoglAttribute *attribute,
+                int first_vertex,
+                int n_vertices,
+                int instance,
+                CoglSwVertex *vertices,
+                size_t member_offset,
+                int max_components)
+{
+  int n_components = _cogl_attribute_get_n_components (attribute);
+  int i, j;
+
+  n_components = MIN (n_components, max_components);
+
+  if (attribute->is_buffered)
+    {
+      CoglBuffer *buffer =
+        COGL_BUFFER (attribute->d.buffered.attribute_buffer);
+      size_t stride = attribute->d.buffered.stride;
+      int divisor = attribute->d.buffered.instance_divisor;
+      CoglAttributeType type = attribute->d.buffered.type;
+      const uint8_t *data;
+      size_t step = stride;
+
+      /* The software driver doesn't advertise VBOs so the buffers
+       * are always in malloc'd memory */
+      if (buffer->data == NULL)
+        return;
+
+      /* A per-instance attribute has the same value for every vertex
+       * of the instance */
+      if (divisor > 0)
+        {
+          first_vertex = instance / divisor;
+          step = 0;
+        }
+
+      data = (buffer->data + attribute->d.buffered.offset +
+              stride * first_vertex);
+
+      for (i = 0; i < n_vertices; i++, data += step)
+        {
+          float *out = (float *) ((uint8_t *) (vertices + i) + member_offset);
+
+          if (type == COGL_ATTRIBUTE_TYPE_FLOAT)
+            memcpy (out, data, n_components * sizeof (float));
+          else
+            for (j = 0; j < n_components; j++)
+              out[j] = read_component (data, type,
+                                       attribute->normalized, j);
+        }
+    }
+  else
+    {
+      const CoglBoxedValue *boxed = &attribute->d.constant.boxed;
+
+      for (i = 0; i < n_vertices; i++)
+        {
+          float *out = (float *) ((uint8_t *) (vertices + i) + member_offset);
+
+          memcpy (out, boxed->v.float_value, n_components * sizeof (float));
+        }
+    }
+}
+
+static void
+fetch_vertices (CoglContext *ctx,
+                CoglMatrixEntry *modelview_entry,
+                CoglMatrixEntry *projection_entry,
+                const CoglSwState *state,
+                CoglAttribute **attributes,
+                int n_attributes,
+                int first_vertex,
+                int n_vertices,
+                int instance,
+                CoglSwVertex *vertices)
+{
+  CoglMatrix modelview, projection, mvp;
+  int i, j;
+
+  for (i = 0; i < n_vertices; i++)
+    {
+      CoglSwVertex *vertex = vertices + i;
+
+      vertex->position[0] = 0.0f;
+      vertex->position[1] = 0.0f;
+      vertex->position[2] = 0.0f;
+      vertex->position[3] = 1.0f;
+
+      if (state)
+        {
+          memcpy (vertex->varyings + COGL_SW_COLOR_VARYING,
+                  state->color,
+                  sizeof (state->color));
+          for (j = 0; j < state->n_layers; j++)
+            {
+              vertex->varyings[COGL_SW_TEX_COORD_VARYING (j)] = 0.0f;
+              vertex->varyings[COGL_SW_TEX_COORD_VARYING (j) + 1] = 0.0f;
+            }
+        }
+    }
+
+  for (i = 0; i < n_attributes; i++)
+    {
+      CoglAttribute *attribute = attributes[i];
+
+      switch (attribute->name_state->name_id)
+        {
+        case COGL_ATTRIBUTE_NAME_ID_POSITION_ARRAY:
+          read_attribute (attribute, first_vertex, n_vertices, instance,
+                          vertices,
+                          G_STRUCT_OFFSET (CoglSwVertex, position), 4);
+          break;
+
+        case COGL_ATTRIBUTE_NAME_ID_COLOR_ARRAY:
+          if (state == NULL)
+            break;
+          if (_cogl_attribute_get_n_components (attribute) < 4)
+            for (j = 0; j < n_vertices; j++)
+              vertices[j].varyings[COGL_SW_COLOR_VARYING + 3] = 1.0f;
+          read_attribute (attribute, first_vertex, n_vertices, instance,
+                          vertices,
+                          G_STRUCT_OFFSET (CoglSwVertex, varyings), 4);
+          break;
+
+        case COGL_ATTRIBUTE_NAME_ID_TEXTURE_COORD_ARRAY:
+          if (state == NULL)
+            break;
+          for (j = 0; j < state->n_layers; j++)
+            if (state->layers[j].index == attribute->name_state->layer_number)
+              {
+                size_t offset =
+                  G_STRUCT_OFFSET (CoglSwVertex, varyings) +
+                  COGL_SW_TEX_COORD_VARYING (j) * sizeof (float);
+
+                read_attribute (attribute, first_vertex, n_vertices,
+                                instance, vertices, offset, 2);
+                break;
+              }
+          break;
+
+        default:
+          /* Normals, point sizes and custom attributes are only
+           * useful with shaders which this driver doesn't support */
+          break;
+        }
+    }
+
+  cogl_matrix_entry_get (modelview_entry, &modelview);
+  cogl_matrix_entry_get (projection_entry, &projection);
+  cogl_matrix_multiply (&mvp, &projection, &modelview);
+
+  for (i = 0; i < n_vertices; i++)
+    {
+      float *p = vertices[i].position;
+      float x = p[0], y = p[1], z = p[2], w = p[3];
+
+      p[0] = mvp.xx * x + mvp.xy * y + mvp.xz * z + mvp.xw * w;
+      p[1] = mvp.yx * x + mvp.yy * y + mvp.yz * z + mvp.yw * w;
+      p[2] = mvp.zx * x + mvp.zy * y + mvp.zz * z + mvp.zw * w;
+      p[3] = mvp.wx * x + mvp.wy * y + mvp.wz * z + mvp.ww * w;
+    }
+}
+
+/* Reads the indices for a draw call and rebases them so that they
+ * index into an array of only the vertices that are used. Returns
+ * the index array which must be freed with g_free() */
+static int *
+read_indices (CoglIndices *indices,
+              int first_vertex,
+              int n_vertices,
+              int *min_index_out,
+              int *max_index_out)
+{
+  CoglBuffer *buffer = COGL_BUFFER (cogl_indices_get_buffer (indices));
+  const uint8_t *data;
+  int *result;
+  int min_index = G_MAXINT32, max_index = 0;
+  int i;
+
+  if (buffer->data == NULL)
+    return NULL;
+
+  data = buffer->data + cogl_indices_get_offset (indices);
+  result = g_new (int, n_vertices);
+
+  for (i = 0; i < n_vertices; i++)
+    {
+      int index;
+
+      switch (cogl_indices_get_type (indices))
+        {
+        case COGL_INDICES_TYPE_UNSIGNED_BYTE:
+          index = data[first_vertex + i];
+          break;
+        case COGL_INDICES_TYPE_UNSIGNED_SHORT:
+          index = ((const uint16_t *) data)[first_vertex + i];
+          break;
+        default:
+          index = ((const uint32_t *) data)[first_vertex + i];
+          break;
+        }
+
+      result[i] = index;
+      min_index = MIN (min_index, index);
+      max_index = MAX (max_index, index);
+    }
+
+  for (i = 0; i < n_vertices; i++)
+    result[i] -= min_index;
+
+  *min_index_out = min_index;
+  *max_index_out = max_index;
+
+  return result;
+}
+
+static CoglSwVertex *
+prepare_vertices (CoglContext *ctx,
+                  CoglMatrixEntry *modelview_entry,
+                  CoglMatrixEntry *projection_entry,
+                  const CoglSwState *state,
+                  int first_vertex,
+                  int n_vertices,
+                  int instance,
+                  CoglIndices *indices,
+                  CoglAttribute **attributes,
+                  int n_attributes,
+                  int **indices_out)
+{
+  CoglSwVertex *vertices;
+  int n_fetched = n_vertices;
+
+  *indices_out = NULL;
+
+  if (indices)
+    {
+      int min_index, max_index;
+
+      *indices_out = read_indices (indices, first_vertex, n_vertices,
+                                   &min_index, &max_index);
+      if (*indices_out == NULL)
+        return NULL;
+
+      first_vertex = min_index;
+      n_fetched = max_index - min_index + 1;
+    }
+
+  vertices = g_new (CoglSwVertex, n_fetched);
+
+  fetch_vertices (ctx,
+                  modelview_entry,
+                  projection_entry,
+                  state,
+                  attributes, n_attributes,
+                  first_vertex, n_fetched,
+                  instance,
+                  vertices);
+
+  return vertices;
+}
+
+static void
+draw_attributes (CoglFramebuffer *framebuffer,
+                 CoglVerticesMode mode,
+                 int first_vertex,
+                 int n_vertices,
+                 int n_instances,
+                 CoglIndices *indices,
+                 CoglAttribute **attributes,
+                 int n_attributes)
+{
+  CoglContext *ctx = framebuffer->context;
+  CoglFramebufferSw *sw_framebuffer;
+  CoglSwVertex *vertices;
+  CoglSwTarget target;
+  int *vertex_indices;
+  int instance;
+
+  COGL_STATIC_TIMER (sw_draw_timer,
+                     "Mainloop", /* parent */
+                     "Software rasterizer",
+                     "Time spent rasterizing with the software driver",
+                     0 /* no application private data */);
+
+  if (n_vertices <= 0)
+    return;
+
+  sw_framebuffer = _cogl_framebuffer_sw_get (framebuffer);
+  if (sw_framebuffer == NULL)
+    return;
+
+  COGL_TIMER_START (sw_draw_timer);
+
+  _cogl_framebuffer_sw_init_target (framebuffer, sw_framebuffer, &target);
+
+  /* Instancing is emulated by drawing each instance separately. Only
+   * the per-instance attributes differ between the iterations */
+  for (instance = 0; instance < n_instances; instance++)
+    {
+      vertices = prepare_vertices (ctx,
+                                   ctx->current_modelview_entry,
+                                   ctx->current_projection_entry,
+                                   &sw_framebuffer->state,
+                                   first_vertex, n_vertices,
+                                   instance,
+                                   indices,
+                                   attributes, n_attributes,
+                                   &vertex_indices);
+
+      if (vertices == NULL)
+        break;
+
+      _cogl_rasterizer_sw_draw (ctx,
+                                &target,
+                                &sw_framebuffer->state,
+                                mode,
+                                vertices,
+                                vertex_indices,
+                                n_vertices);
+
+      g_free (vertices);
+      g_free (vertex_indices);
+    }
+
+  ctx->frame_stats.n_draw_calls++;
+
+  COGL_TIMER_STOP (sw_draw_timer);
+}
+
+void
+_cogl_framebuffer_sw_draw_attributes (CoglFramebuffer *framebuffer,
+                                      CoglPipeline *pipeline,
+                                      CoglVerticesMode mode,
+                                      int first_vertex,
+                                      int n_vertices,
+                                      int n_instances,
+                                      CoglAttribute **attributes,
+                                      int n_attributes,
+                                      CoglDrawFlags flags)
+{
+  _cogl_flush_attributes_state (framebuffer, pipeline, flags,
+                                attributes, n_attributes);
+
+  draw_attributes (framebuffer,
+                   mode,
+                   first_vertex, n_vertices,
+                   n_instances,
+                   NULL, /* indices */
+                   attributes, n_attributes);
+}
+
+void
+_cogl_framebuffer_sw_draw_indexed_attributes (CoglFramebuffer *framebuffer,
+                                              CoglPipeline *pipeline,
+                                              CoglVerticesMode mode,
+                                              int first_vertex,
+                                              int n_vertices,
+                                              int n_instances,
+                                              CoglIndices *indices,
+                                              CoglAttribute **attributes,
+                                              int n_attributes,
+                                              CoglDrawFlags flags)
+{
+  _cogl_flush_attributes_state (framebuffer, pipeline, flags,
+                                attributes, n_attributes);
+
+  draw_attributes (framebuffer,
+                   mode,
+                   first_vertex, n_vertices,
+                   n_instances,
+                   indices,
+                   attributes, n_attributes);
+}
+
+void
+_cogl_framebuffer_sw_multi_draw_attributes (CoglFramebuffer *framebuffer,
+                                            CoglPipeline *pipeline,
+                                            CoglVerticesMode mode,
+                                            const int *first_vertices,
+                                            const int *n_vertices,
+                                            int n_draws,
+                                            CoglIndices *indices,
+                                            CoglAttribute **attributes,
+                                            int n_attributes,
+                                            CoglDrawFlags flags)
+{
+  int i;
+
+  _cogl_flush_attributes_state (framebuffer, pipeline, flags,
+                                attributes, n_attributes);
+
+  for (i = 0; i < n_draws; i++)
+    draw_attributes (framebuffer,
+                     mode,
+                     first_vertices[i], n_vertices[i],
+                     1, /* n_instances */
+                     indices,
+                     attributes, n_attributes);
+}
+
+void
+_cogl_framebuffer_sw_fill_coverage (CoglFramebuffer *framebuffer,
+                                    CoglMatrixEntry *modelview_entry,
+                                    CoglPrimitive *primitive,
+                                    const CoglSwTarget *target,
+                                    uint8_t *coverage,
+                                    CoglBool invert)
+{
+  CoglContext *ctx = framebuffer->context;
+  CoglSwVertex *vertices;
+  int *vertex_indices;
+
+  vertices = prepare_vertices (ctx,
+                               modelview_entry,
+                               _cogl_framebuffer_get_projection_entry
+                               (framebuffer),
+                               NULL, /* only the positions are needed */
+                               primitive->first_vertex,
+                               primitive->n_vertices,
+                               0, /* instance */
+                               primitive->indices,
+                               primitive->attributes,
+                               primitive->n_attributes,
+                               &vertex_indices);
+
+  if (vertices == NULL)
+    return;
+
+  _cogl_rasterizer_sw_fill_coverage (ctx,
+                                     target,
+                                     primitive->mode,
+                                     vertices,
+                                     vertex_indices,
+                                     primitive->n_vertices,
+                                     coverage,
+                                     target->color.width,
+                                     invert);
+
+  g_free (vertices);
+  g_free (vertex_indices);
+}
+
+CoglBool
+_cogl_framebuffer_sw_read_pixels_into_bitmap (CoglFramebuffer *framebuffer,
+                                              int x,
+                                              int y,
+                                              CoglReadPixelsFlags source,
+                                              CoglBitmap *bitmap,
+                                              CoglError **error)
+{
+  CoglContext *ctx = framebuffer->context;
+  CoglFramebufferSw *sw_framebuffer = _cogl_framebuffer_sw_get (framebuffer);
+  int width = cogl_bitmap_get_width (bitmap);
+  int height = cogl_bitmap_get_height (bitmap);
+  CoglPixelFormat src_format;
+  CoglSwImage *color;
+  CoglBitmap *src_bmp;
+  CoglBool status;
+
+  if (sw_framebuffer == NULL ||
+      x < 0 || y < 0 ||
+      x + width > sw_framebuffer->color.width ||
+      y + height > sw_framebuffer->color.height)
+    {
+      _cogl_set_error (error, COGL_SYSTEM_ERROR,
+                       COGL_SYSTEM_ERROR_UNSUPPORTED,
+                       "Can't read pixels outside of the framebuffer");
+      return FALSE;
+    }
+
+  color = &sw_framebuffer->color;
+
+  /* The premultiplied state of the data is determined by the internal
+   * format of the framebuffer rather than the storage. This can differ
+   * when reading back atlas textures which are stored in a shared
+   * texture that isn't marked as premultiplied */
+  src_format = color->format;
+  if (COGL_PIXEL_FORMAT_CAN_HAVE_PREMULT (src_format))
+    src_format = ((src_format & ~COGL_PREMULT_BIT) |
+                  (framebuffer->internal_format & COGL_PREMULT_BIT));
+
+  src_bmp = cogl_bitmap_new_for_data (ctx,
+                                      width, height,
+                                      src_format,
+                                      color->rowstride,
+                                      color->data +
+                                      y * color->rowstride + x * 4);
+
+  status = _cogl_bitmap_convert_into_bitmap (src_bmp, bitmap, error);
+
+  cogl_object_unref (src_bmp);
+
+  return status;
+}
@@ -0,0 +1,55 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COGL_PIPELINE_SW_PRIVATE_H_
+#define _COGL_PIPELINE_SW_PRIVATE_H_
+
+#include "cogl-types.h"
+#include "cogl-pipeline-private.h"
+#include "cogl-rasterizer-sw-private.h"
+
+/*
+ * _cogl_pipeline_sw_flush_state:
+ * @pipeline: The #CoglPipeline being drawn with
+ * @framebuffer: The #CoglFramebuffer being drawn to
+ * @with_color_attrib: Whether the vertices have a color attribute
+ * @unknown_color_alpha: Whether the color attribute may have
+ *   non-opaque alpha values
+ * @state: The state to fill in
+ *
+ * Translates the fixed function state of @pipeline into the state
+ * used by the software rasterizer.
+ */
+void
+_cogl_pipeline_sw_flush_state (CoglPipeline *pipeline,
+                               CoglFramebuffer *framebuffer,
+                               CoglBool with_color_attrib,
+                               CoglBool unknown_color_alpha,
+                               CoglSwState *state);
+
+#endif /* _COGL_PIPELINE_SW_PRIVATE_H_ */
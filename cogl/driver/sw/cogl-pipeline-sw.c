@@ -0,0 +1,295 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-pipeline-sw-private.h"
+#include "cogl-texture-2d-sw-private.h"
+#include "cogl-pipeline-layer-private.h"
+#include "cogl-framebuffer-private.h"
+
+#include <string.h>
+
+typedef struct
+{
+  CoglSwState *state;
+  CoglPipelineLayer *layers[COGL_SW_MAX_LAYERS];
+} FlushLayerState;
+
+static CoglSwWrap
+translate_wrap_mode (CoglPipelineWrapMode wrap_mode)
+{
+  switch (wrap_mode)
+    {
+    case COGL_PIPELINE_WRAP_MODE_REPEAT:
+      return COGL_SW_WRAP_REPEAT;
+    case COGL_PIPELINE_WRAP_MODE_MIRRORED_REPEAT:
+      return COGL_SW_WRAP_MIRRORED_REPEAT;
+    default:
+      /* The automatic wrap mode is treated as clamp to edge like the
+       * GL driver does for drawing primitives */
+      return COGL_SW_WRAP_CLAMP;
+    }
+}
+
+static CoglBool
+is_linear_filter (CoglPipelineFilter filter)
+{
+  /* Mipmaps aren't stored so the mipmap filters fall back to
+   * sampling from the base level */
+  return (filter == COGL_PIPELINE_FILTER_LINEAR ||
+          filter == COGL_PIPELINE_FILTER_LINEAR_MIPMAP_NEAREST ||
+          filter == COGL_PIPELINE_FILTER_LINEAR_MIPMAP_LINEAR);
+}
+
+static int
+translate_source (FlushLayerState *flush_state,
+                  CoglPipelineCombineSource source)
+{
+  int layer_num, i;
+
+  switch (source)
+    {
+    case COGL_PIPELINE_COMBINE_SOURCE_TEXTURE:
+      return COGL_SW_SOURCE_TEXTURE;
+    case COGL_PIPELINE_COMBINE_SOURCE_CONSTANT:
+      return COGL_SW_SOURCE_CONSTANT;
+    case COGL_PIPELINE_COMBINE_SOURCE_PRIMARY_COLOR:
+      return COGL_SW_SOURCE_PRIMARY_COLOR;
+    case COGL_PIPELINE_COMBINE_SOURCE_PREVIOUS:
+      return COGL_SW_SOURCE_PREVIOUS;
+    default:
+      break;
+    }
+
+  /* The other sources refer to the texture of a layer by its index
+   * whereas the rasterizer refers to layers by their position */
+  layer_num = source - COGL_PIPELINE_COMBINE_SOURCE_TEXTURE0;
+
+  for (i = 0; i < flush_state->state->n_layers; i++)
+    if (flush_state->layers[i]->index == layer_num)
+      return COGL_SW_SOURCE_LAYER0 + i;
+
+  return COGL_SW_SOURCE_TEXTURE;
+}
+
+static void
+translate_combine (FlushLayerState *flush_state,
+                   CoglPipelineCombineFunc func,
+                   const CoglPipelineCombineSource *src,
+                   const CoglPipelineCombineOp *op,
+                   CoglSwCombine *combine)
+{
+  int i;
+
+  combine->func = func;
+  combine->n_args = _cogl_get_n_args_for_combine_func (func);
+
+  for (i = 0; i < combine->n_args; i++)
+    {
+      combine->src[i] = translate_source (flush_state, src[i]);
+      combine->op[i] = op[i];
+    }
+}
+
+static CoglBool
+is_default_modulate (const CoglSwCombine *combine,
+                     int op)
+{
+  return (combine->func == COGL_PIPELINE_COMBINE_FUNC_MODULATE &&
+          combine->src[0] == COGL_SW_SOURCE_PREVIOUS &&
+          combine->op[0] == op &&
+          combine->src[1] == COGL_SW_SOURCE_TEXTURE &&
+          combine->op[1] == op);
+}
+
+static CoglBool
+collect_layer_cb (CoglPipelineLayer *layer,
+                  void *user_data)
+{
+  FlushLayerState *flush_state = user_data;
+  CoglSwState *state = flush_state->state;
+
+  if (state->n_layers >= COGL_SW_MAX_LAYERS)
+    {
+      static CoglBool warning_seen = FALSE;
+
+      if (!warning_seen)
+        {
+          g_warning ("The software driver only supports %i layers",
+                     COGL_SW_MAX_LAYERS);
+          warning_seen = TRUE;
+        }
+
+      return FALSE;
+    }
+
+  flush_state->layers[state->n_layers++] = layer;
+
+  return TRUE;
+}
+
+static void
+flush_layer (FlushLayerState *flush_state,
+             int layer_pos)
+{
+  CoglPipelineLayer *layer = flush_state->layers[layer_pos];
+  CoglSwLayer *sw_layer = flush_state->state->layers + layer_pos;
+  CoglPipelineLayer *combine_authority =
+    _cogl_pipeline_layer_get_authority (layer,
+                                        COGL_PIPELINE_LAYER_STATE_COMBINE);
+  CoglPipelineLayerBigState *combine_state = combine_authority->big_state;
+  CoglPipelineLayer *constant_authority =
+    _cogl_pipeline_layer_get_authority
+    (layer, COGL_PIPELINE_LAYER_STATE_COMBINE_CONSTANT);
+  CoglTexture *texture = _cogl_pipeline_layer_get_texture (layer);
+  int x_offset, y_offset;
+
+  sw_layer->index = layer->index;
+
+  /* The journal has already transformed the texture coordinates of
+   * meta textures into the space of the backing texture so the offset
+   * doesn't need to be applied here */
+  sw_layer->image = (texture ?
+                     _cogl_texture_sw_get_image (texture,
+                                                 &x_offset, &y_offset) :
+                     NULL);
+
+  sw_layer->min_linear =
+    is_linear_filter (_cogl_pipeline_layer_get_min_filter (layer));
+  sw_layer->mag_linear =
+    is_linear_filter (_cogl_pipeline_layer_get_mag_filter (layer));
+  sw_layer->wrap_s =
+    translate_wrap_mode (_cogl_pipeline_layer_get_wrap_mode_s (layer));
+  sw_layer->wrap_t =
+    translate_wrap_mode (_cogl_pipeline_layer_get_wrap_mode_t (layer));
+
+  translate_combine (flush_state,
+                     combine_state->texture_combine_rgb_func,
+                     combine_state->texture_combine_rgb_src,
+                     combine_state->texture_combine_rgb_op,
+                     &sw_layer->rgb);
+  translate_combine (flush_state,
+                     combine_state->texture_combine_alpha_func,
+                     combine_state->texture_combine_alpha_src,
+                     combine_state->texture_combine_alpha_op,
+                     &sw_layer->alpha);
+
+  memcpy (sw_layer->constant,
+          constant_authority->big_state->texture_combine_constant,
+          sizeof (sw_layer->constant));
+
+  sw_layer->modulate =
+    (is_default_modulate (&sw_layer->rgb,
+                          COGL_PIPELINE_COMBINE_OP_SRC_COLOR) &&
+     is_default_modulate (&sw_layer->alpha,
+                          COGL_PIPELINE_COMBINE_OP_SRC_ALPHA));
+}
+
+static void
+flush_blend_state (CoglPipeline *pipeline,
+                   CoglSwState *state)
+{
+  CoglPipeline *authority =
+    _cogl_pipeline_get_authority (pipeline, COGL_PIPELINE_STATE_BLEND);
+  CoglPipelineBlendState *blend_state =
+    &authority->big_state->blend_state;
+
+  state->blend_src_factor_rgb = blend_state->blend_src_factor_rgb;
+  state->blend_dst_factor_rgb = blend_state->blend_dst_factor_rgb;
+
+#if defined(HAVE_COGL_GLES2) || defined(HAVE_COGL_GL)
+  state->blend_equation_rgb = blend_state->blend_equation_rgb;
+  state->blend_equation_alpha = blend_state->blend_equation_alpha;
+  state->blend_src_factor_alpha = blend_state->blend_src_factor_alpha;
+  state->blend_dst_factor_alpha = blend_state->blend_dst_factor_alpha;
+  state->blend_constant[0] =
+    cogl_color_get_red_float (&blend_state->blend_constant);
+  state->blend_constant[1] =
+    cogl_color_get_green_float (&blend_state->blend_constant);
+  state->blend_constant[2] =
+    cogl_color_get_blue_float (&blend_state->blend_constant);
+  state->blend_constant[3] =
+    cogl_color_get_alpha_float (&blend_state->blend_constant);
+#else
+  state->blend_equation_rgb = GL_FUNC_ADD;
+  state->blend_equation_alpha = GL_FUNC_ADD;
+  state->blend_src_factor_alpha = blend_state->blend_src_factor_rgb;
+  state->blend_dst_factor_alpha = blend_state->blend_dst_factor_rgb;
+  memset (state->blend_constant, 0, sizeof (state->blend_constant));
+#endif
+}
+
+void
+_cogl_pipeline_sw_flush_state (CoglPipeline *pipeline,
+                               CoglFramebuffer *framebuffer,
+                               CoglBool with_color_attrib,
+                               CoglBool unknown_color_alpha,
+                               CoglSwState *state)
+{
+  FlushLayerState flush_state;
+  CoglColor color;
+  int i;
+
+  flush_state.state = state;
+  state->n_layers = 0;
+
+  /* The layers are collected first so that combine sources that refer
+   * to other layers can be resolved */
+  _cogl_pipeline_foreach_layer_internal (pipeline,
+                                         collect_layer_cb,
+                                         &flush_state);
+
+  for (i = 0; i < state->n_layers; i++)
+    flush_layer (&flush_state, i);
+
+  cogl_pipeline_get_color (pipeline, &color);
+  state->color[0] = cogl_color_get_red_float (&color);
+  state->color[1] = cogl_color_get_green_float (&color);
+  state->color[2] = cogl_color_get_blue_float (&color);
+  state->color[3] = cogl_color_get_alpha_float (&color);
+
+  state->flat_color = !with_color_attrib;
+
+  _cogl_pipeline_update_real_blend_enable (pipeline, unknown_color_alpha);
+  state->blend_enabled = pipeline->real_blend_enable;
+  flush_blend_state (pipeline, state);
+
+  state->alpha_func = cogl_pipeline_get_alpha_test_function (pipeline);
+  state->alpha_reference = cogl_pipeline_get_alpha_test_reference (pipeline);
+
+  state->color_mask = (cogl_pipeline_get_color_mask (pipeline) &
+                       framebuffer->color_mask);
+
+  state->cull_face_mode = cogl_pipeline_get_cull_face_mode (pipeline);
+  state->front_winding = cogl_pipeline_get_front_face_winding (pipeline);
+
+  state->point_size = cogl_pipeline_get_point_size (pipeline);
+}
@@ -0,0 +1,213 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COGL_RASTERIZER_SW_PRIVATE_H_
+#define _COGL_RASTERIZER_SW_PRIVATE_H_
+
+#include "cogl-types.h"
+#include "cogl-context-private.h"
+#include "cogl-pipeline.h"
+#include "cogl-pipeline-state.h"
+
+/* The software driver only supports as many layers as the journal
+ * can batch together */
+#define COGL_SW_MAX_LAYERS 8
+
+/* Each vertex carries an RGBA color followed by an s,t pair for each
+ * layer */
+#define COGL_SW_COLOR_VARYING 0
+#define COGL_SW_TEX_COORD_VARYING(layer) (4 + (layer) * 2)
+#define COGL_SW_MAX_VARYINGS COGL_SW_TEX_COORD_VARYING (COGL_SW_MAX_LAYERS)
+
+/* All images that the software driver renders to or samples from are
+ * stored as 8 bits per component RGBA with the first row at the top
+ * of the image. The premultiplied state follows the format of the
+ * texture or framebuffer. */
+typedef struct _CoglSwImage
+{
+  int width;
+  int height;
+  int rowstride;
+  CoglPixelFormat format;
+  uint8_t *data;
+} CoglSwImage;
+
+typedef enum
+{
+  COGL_SW_WRAP_CLAMP,
+  COGL_SW_WRAP_REPEAT,
+  COGL_SW_WRAP_MIRRORED_REPEAT
+} CoglSwWrap;
+
+typedef enum
+{
+  COGL_SW_SOURCE_TEXTURE,
+  COGL_SW_SOURCE_CONSTANT,
+  COGL_SW_SOURCE_PRIMARY_COLOR,
+  COGL_SW_SOURCE_PREVIOUS,
+  /* The texture of another layer. The layer is given by subtracting
+   * this value from the source */
+  COGL_SW_SOURCE_LAYER0
+} CoglSwSource;
+
+typedef struct _CoglSwCombine
+{
+  /* One of the CoglPipelineCombineFunc values */
+  int func;
+  int n_args;
+  int src[3];
+  /* One of the CoglPipelineCombineOp values */
+  int op[3];
+} CoglSwCombine;
+
+typedef struct _CoglSwLayer
+{
+  /* The index of the layer in the pipeline. This is used to match
+   * up the texture coordinate attributes */
+  int index;
+
+  /* NULL if the layer has no usable texture in which case it samples
+   * as opaque white */
+  const CoglSwImage *image;
+  CoglBool min_linear;
+  CoglBool mag_linear;
+  CoglSwWrap wrap_s;
+  CoglSwWrap wrap_t;
+
+  CoglSwCombine rgb;
+  CoglSwCombine alpha;
+  float constant[4];
+
+  /* TRUE if the layer uses the standard MODULATE (PREVIOUS, TEXTURE)
+   * combine for both rgb and alpha */
+  CoglBool modulate;
+} CoglSwLayer;
+
+/* The fixed function state derived from a CoglPipeline that the
+ * rasterizer needs to shade fragments. It doesn't reference the
+ * pipeline itself so that it can be safely read from the worker
+ * threads. */
+typedef struct _CoglSwState
+{
+  int n_layers;
+  CoglSwLayer layers[COGL_SW_MAX_LAYERS];
+
+  /* The color of the pipeline which is used when there is no color
+   * attribute */
+  float color[4];
+
+  /* TRUE if every vertex has the same color so the color doesn't need
+   * to be interpolated */
+  CoglBool flat_color;
+
+  CoglBool blend_enabled;
+  unsigned int blend_equation_rgb;
+  unsigned int blend_equation_alpha;
+  unsigned int blend_src_factor_rgb;
+  unsigned int blend_dst_factor_rgb;
+  unsigned int blend_src_factor_alpha;
+  unsigned int blend_dst_factor_alpha;
+  float blend_constant[4];
+
+  CoglPipelineAlphaFunc alpha_func;
+  float alpha_reference;
+
+  CoglColorMask color_mask;
+
+  CoglPipelineCullFaceMode cull_face_mode;
+  CoglWinding front_winding;
+
+  float point_size;
+} CoglSwState;
+
+/* A vertex in clip space with its varyings */
+typedef struct _CoglSwVertex
+{
+  float position[4];
+  float varyings[COGL_SW_MAX_VARYINGS];
+} CoglSwVertex;
+
+typedef struct _CoglSwTarget
+{
+  /* The color buffer. This may be a region of a larger image when
+   * rendering to a sub-texture. */
+  CoglSwImage color;
+
+  /* An optional mask with one byte per pixel of the color buffer
+   * where zero means the pixel is clipped */
+  const uint8_t *clip_mask;
+  int clip_mask_rowstride;
+
+  /* The region of the buffer that can be written to */
+  int scissor_x0;
+  int scissor_y0;
+  int scissor_x1;
+  int scissor_y1;
+
+  /* x, y, width, height */
+  float viewport[4];
+} CoglSwTarget;
+
+void
+_cogl_rasterizer_sw_draw (CoglContext *ctx,
+                          const CoglSwTarget *target,
+                          const CoglSwState *state,
+                          CoglVerticesMode mode,
+                          const CoglSwVertex *vertices,
+                          const int *indices,
+                          int n_vertices);
+
+/*
+ * _cogl_rasterizer_sw_fill_coverage:
+ * @coverage: A buffer with one byte per pixel of the target
+ * @invert: Whether to invert the coverage of each pixel hit
+ *
+ * Rasterizes the triangles described by the vertices into a coverage
+ * mask instead of the color buffer. If @invert is %FALSE then every
+ * pixel hit is set to 0xff. Otherwise it is inverted so that
+ * overlapping triangles cancel each other out in the same way that
+ * the GL driver uses the stencil buffer to clip to a path.
+ */
+void
+_cogl_rasterizer_sw_fill_coverage (CoglContext *ctx,
+                                   const CoglSwTarget *target,
+                                   CoglVerticesMode mode,
+                                   const CoglSwVertex *vertices,
+                                   const int *indices,
+                                   int n_vertices,
+                                   uint8_t *coverage,
+                                   int coverage_rowstride,
+                                   CoglBool invert);
+
+void
+_cogl_rasterizer_sw_clear (CoglContext *ctx,
+                           const CoglSwTarget *target,
+                           const float *color,
+                           CoglColorMask color_mask);
+
+#endif /* _COGL_RASTERIZER_SW_PRIVATE_H_ */
@@ -0,0 +1,1607 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "cogl-rasterizer-sw-private.h"
+#include "cogl-worker-pool-private.h"
+#include "cogl-pipeline-layer-private.h"
+#include "cogl-util.h"
+
+#include <glib.h>
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+/* The framebuffer is split into square tiles that are shaded
+ * independently by the worker threads. Tiles never share pixels so
+ * the triangles within each tile can be processed in submission
+ * order without any locking. */
+#define TILE_SIZE 64
+
+/* Draws that cover fewer pixels than this are rasterized directly in
+ * the calling thread because waking up the worker pool would cost
+ * more than it saves */
+#define MIN_PARALLEL_AREA (TILE_SIZE * TILE_SIZE * 4)
+
+/* Window coordinates are snapped to 1/256th of a pixel before the
+ * edge functions are calculated */
+#define SUBPIXEL_SCALE 256.0f
+
+/* Primitives are clipped to a band around the viewport this many
+ * times its size so that the window coordinates stay small enough
+ * not to lose sub-pixel precision */
+#define GUARD_BAND 4.0f
+
+#define N_CLIP_PLANES 6
+#define MAX_CLIPPED_VERTICES (3 + N_CLIP_PLANES)
+
+typedef struct
+{
+  float x, y;
+  float inv_w;
+  float varyings[COGL_SW_MAX_VARYINGS];
+} WindowVertex;
+
+typedef struct
+{
+  /* Edge functions in the form a * x + b * y + c which are positive
+   * inside the triangle */
+  float a[3], b[3], c[3];
+  CoglBool top_left[3];
+
+  /* Bounding box clamped to the scissor. x1 and y1 are exclusive */
+  int x0, y0, x1, y1;
+
+  /* If the triangle needs perspective correct interpolation then the
+   * varying planes are of the varyings divided by w and w_plane
+   * interpolates 1/w */
+  CoglBool perspective;
+  float w_plane[3];
+  float planes[COGL_SW_MAX_VARYINGS][3];
+
+  /* Whether to use linear filtering for each layer, chosen by
+   * whether the triangle magnifies or minifies the texture */
+  CoglBool linear[COGL_SW_MAX_LAYERS];
+} Triangle;
+
+typedef enum
+{
+  SPAN_FUNC_GENERIC,
+  SPAN_FUNC_SOLID,
+  SPAN_FUNC_SOLID_OVER,
+  SPAN_FUNC_MODULATE,
+  SPAN_FUNC_COVERAGE
+} SpanFunc;
+
+typedef struct
+{
+  const CoglSwTarget *target;
+  const CoglSwState *state;
+  int n_varyings;
+  SpanFunc span_func;
+  CoglBool blend_over;
+  uint8_t flat_color[4];
+
+  GArray *triangles;
+  CoglBool cull_triangles;
+
+  /* Union of the bounding boxes of all of the triangles */
+  int x0, y0, x1, y1;
+  int64_t area;
+
+  int n_tiles_x;
+
+  /* The triangles binned into the tiles that they touch. The indices
+   * of the triangles for tile i are in tile_triangles from
+   * tile_offsets[i] to tile_offsets[i + 1] in drawing order */
+  int *tile_offsets;
+  int *tile_triangles;
+
+  uint8_t *coverage;
+  int coverage_rowstride;
+  CoglBool invert;
+} DrawState;
+
+static inline uint8_t
+float_to_byte (float value)
+{
+  if (value <= 0.0f)
+    return 0;
+  else if (value >= 1.0f)
+    return 255;
+  else
+    return (uint8_t) (value * 255.0f + 0.5f);
+}
+
+/* Calculates x * y / 255 rounded to the nearest integer for values in
+ * the range [0,255] */
+static inline unsigned int
+mul_un8 (unsigned int x, unsigned int y)
+{
+  unsigned int t = x * y + 128;
+
+  return (t + (t >> 8)) >> 8;
+}
+
+static inline float
+evaluate_plane (const float *plane, float x, float y)
+{
+  return plane[0] * x + plane[1] * y + plane[2];
+}
+
+static void
+calculate_plane (float *plane,
+                 const WindowVertex *v0,
+                 const WindowVertex *v1,
+                 const WindowVertex *v2,
+                 float f0,
+                 float f1,
+                 float f2,
+                 float inv_area)
+{
+  float dx1 = v1->x - v0->x, dy1 = v1->y - v0->y;
+  float dx2 = v2->x - v0->x, dy2 = v2->y - v0->y;
+  float df1 = f1 - f0, df2 = f2 - f0;
+
+  plane[0] = (df1 * dy2 - df2 * dy1) * inv_area;
+  plane[1] = (df2 * dx1 - df1 * dx2) * inv_area;
+  plane[2] = f0 - plane[0] * v0->x - plane[1] * v0->y;
+}
+
+static void
+setup_triangle (DrawState *ds,
+                const WindowVertex *v0,
+                const WindowVertex *v1,
+                const WindowVertex *v2,
+                CoglBool cull)
+{
+  const CoglSwTarget *target = ds->target;
+  const CoglSwState *state = ds->state;
+  const WindowVertex *v[3];
+  Triangle tri;
+  float area, inv_area;
+  float min_x, min_y, max_x, max_y;
+  int i;
+
+  area = ((v1->x - v0->x) * (v2->y - v0->y) -
+          (v2->x - v0->x) * (v1->y - v0->y));
+
+  if (area == 0.0f || !isfinite (area))
+    return;
+
+  if (cull && state &&
+      state->cull_face_mode != COGL_PIPELINE_CULL_FACE_MODE_NONE)
+    {
+      /* Window coordinates are flipped compared to normalized device
+       * coordinates so a positive area here means the triangle is
+       * wound clockwise as far as GL would be concerned */
+      CoglBool ccw = area < 0.0f;
+      CoglBool front =
+        ccw == (state->front_winding == COGL_WINDING_COUNTER_CLOCKWISE);
+
+      switch (state->cull_face_mode)
+        {
+        case COGL_PIPELINE_CULL_FACE_MODE_FRONT:
+          if (front)
+            return;
+          break;
+        case COGL_PIPELINE_CULL_FACE_MODE_BACK:
+          if (!front)
+            return;
+          break;
+        case COGL_PIPELINE_CULL_FACE_MODE_BOTH:
+          return;
+        default:
+          break;
+        }
+    }
+
+  /* Make sure the triangle is always wound the same way so that the
+   * edge functions are positive inside */
+  v[0] = v0;
+  if (area > 0.0f)
+    {
+      v[1] = v1;
+      v[2] = v2;
+    }
+  else
+    {
+      v[1] = v2;
+      v[2] = v1;
+      area = -area;
+    }
+
+  min_x = MIN (MIN (v[0]->x, v[1]->x), v[2]->x);
+  min_y = MIN (MIN (v[0]->y, v[1]->y), v[2]->y);
+  max_x = MAX (MAX (v[0]->x, v[1]->x), v[2]->x);
+  max_y = MAX (MAX (v[0]->y, v[1]->y), v[2]->y);
+
+  tri.x0 = MAX ((int) floorf (min_x), target->scissor_x0);
+  tri.y0 = MAX ((int) floorf (min_y), target->scissor_y0);
+  tri.x1 = MIN ((int) ceilf (max_x) + 1, target->scissor_x1);
+  tri.y1 = MIN ((int) ceilf (max_y) + 1, target->scissor_y1);
+
+  if (tri.x0 >= tri.x1 || tri.y0 >= tri.y1)
+    return;
+
+  for (i = 0; i < 3; i++)
+    {
+      const WindowVertex *a = v[i];
+      const WindowVertex *b = v[(i + 1) % 3];
+
+      /* NB: these are calculated so that the edge shared by two
+       * triangles will have exactly negated coefficients in both
+       * regardless of the order of the vertices. Together with the
+       * top-left rule this means that every pixel along the edge is
+       * covered by exactly one of the triangles */
+      tri.a[i] = a->y - b->y;
+      tri.b[i] = b->x - a->x;
+      tri.c[i] = a->x * b->y - b->x * a->y;
+      tri.top_left[i] = (tri.a[i] > 0.0f ||
+                         (tri.a[i] == 0.0f && tri.b[i] > 0.0f));
+    }
+
+  inv_area = 1.0f / area;
+
+  tri.perspective = (v[0]->inv_w != v[1]->inv_w ||
+                     v[0]->inv_w != v[2]->inv_w);
+
+  if (tri.perspective)
+    {
+      calculate_plane (tri.w_plane, v[0], v[1], v[2],
+                       v[0]->inv_w, v[1]->inv_w, v[2]->inv_w,
+                       inv_area);
+
+      for (i = 0; i < ds->n_varyings; i++)
+        calculate_plane (tri.planes[i], v[0], v[1], v[2],
+                         v[0]->varyings[i] * v[0]->inv_w,
+                         v[1]->varyings[i] * v[1]->inv_w,
+                         v[2]->varyings[i] * v[2]->inv_w,
+                         inv_area);
+    }
+  else
+    {
+      for (i = 0; i < ds->n_varyings; i++)
+        calculate_plane (tri.planes[i], v[0], v[1], v[2],
+                         v[0]->varyings[i],
+                         v[1]->varyings[i],
+                         v[2]->varyings[i],
+                         inv_area);
+    }
+
+  if (state)
+    {
+      float w = 1.0f;
+
+      /* Pick between the minification and magnification filter
+       * using the texel to pixel ratio at the centre of the
+       * triangle */
+      if (tri.perspective)
+        w = 1.0f / evaluate_plane (tri.w_plane,
+                                   (v[0]->x + v[1]->x + v[2]->x) / 3.0f,
+                                   (v[0]->y + v[1]->y + v[2]->y) / 3.0f);
+
+      for (i = 0; i < state->n_layers; i++)
+        {
+          const CoglSwLayer *layer = state->layers + i;
+          const float *s_plane =
+            tri.planes[COGL_SW_TEX_COORD_VARYING (i)];
+          const float *t_plane =
+            tri.planes[COGL_SW_TEX_COORD_VARYING (i) + 1];
+          float dsdx, dsdy, dtdx, dtdy, rho_x, rho_y;
+
+          if (layer->image == NULL ||
+              layer->min_linear == layer->mag_linear)
+            {
+              tri.linear[i] = layer->mag_linear;
+              continue;
+            }
+
+          dsdx = s_plane[0] * w * layer->image->width;
+          dsdy = s_plane[1] * w * layer->image->width;
+          dtdx = t_plane[0] * w * layer->image->height;
+          dtdy = t_plane[1] * w * layer->image->height;
+
+          rho_x = dsdx * dsdx + dtdx * dtdx;
+          rho_y = dsdy * dsdy + dtdy * dtdy;
+
+          tri.linear[i] = (MAX (rho_x, rho_y) > 1.0f ?
+                           layer->min_linear :
+                           layer->mag_linear);
+        }
+    }
+
+  ds->x0 = MIN (ds->x0, tri.x0);
+  ds->y0 = MIN (ds->y0, tri.y0);
+  ds->x1 = MAX (ds->x1, tri.x1);
+  ds->y1 = MAX (ds->y1, tri.y1);
+  ds->area += (int64_t) (tri.x1 - tri.x0) * (tri.y1 - tri.y0);
+
+  g_array_append_val (ds->triangles, tri);
+}
+
+static void
+to_window (DrawState *ds,
+           const CoglSwVertex *vertex,
+           WindowVertex *out)
+{
+  const float *viewport = ds->target->viewport;
+  float inv_w = 1.0f / vertex->position[3];
+  float x, y;
+
+  x = viewport[0] + (vertex->position[0] * inv_w + 1.0f) * 0.5f * viewport[2];
+  y = viewport[1] + (1.0f - vertex->position[1] * inv_w) * 0.5f * viewport[3];
+
+  out->x = floorf (x * SUBPIXEL_SCALE + 0.5f) / SUBPIXEL_SCALE;
+  out->y = floorf (y * SUBPIXEL_SCALE + 0.5f) / SUBPIXEL_SCALE;
+  out->inv_w = inv_w;
+  memcpy (out->varyings, vertex->varyings, sizeof (float) * ds->n_varyings);
+}
+
+static inline float
+clip_distance (const CoglSwVertex *vertex, int plane)
+{
+  const float *p = vertex->position;
+
+  switch (plane)
+    {
+    case 0: return p[3] + p[2];
+    case 1: return p[3] - p[2];
+    case 2: return GUARD_BAND * p[3] + p[0];
+    case 3: return GUARD_BAND * p[3] - p[0];
+    case 4: return GUARD_BAND * p[3] + p[1];
+    default: return GUARD_BAND * p[3] - p[1];
+    }
+}
+
+static void
+interpolate_vertex (DrawState *ds,
+                    const CoglSwVertex *inside,
+                    const CoglSwVertex *outside,
+                    float t,
+                    CoglSwVertex *out)
+{
+  int i;
+
+  for (i = 0; i < 4; i++)
+    out->position[i] = (inside->position[i] +
+                        (outside->position[i] - inside->position[i]) * t);
+  for (i = 0; i < ds->n_varyings; i++)
+    out->varyings[i] = (inside->varyings[i] +
+                        (outside->varyings[i] - inside->varyings[i]) * t);
+}
+
+static void
+draw_triangle (DrawState *ds,
+               const CoglSwVertex *v0,
+               const CoglSwVertex *v1,
+               const CoglSwVertex *v2)
+{
+  CoglSwVertex buffers[2][MAX_CLIPPED_VERTICES];
+  const CoglSwVertex *polygon[2][MAX_CLIPPED_VERTICES];
+  WindowVertex window[MAX_CLIPPED_VERTICES];
+  unsigned int outside_mask = 0;
+  int n_vertices = 3;
+  int plane, i, cur = 0;
+
+  for (plane = 0; plane < N_CLIP_PLANES; plane++)
+    if (clip_distance (v0, plane) < 0.0f ||
+        clip_distance (v1, plane) < 0.0f ||
+        clip_distance (v2, plane) < 0.0f)
+      outside_mask |= 1 << plane;
+
+  polygon[0][0] = v0;
+  polygon[0][1] = v1;
+  polygon[0][2] = v2;
+
+  /* Sutherland-Hodgman clipping against each plane that the triangle
+   * crosses. The intersections are always calculated from the inside
+   * vertex towards the outside one so that an edge shared with
+   * another triangle is split at exactly the same point. */
+  for (plane = 0; plane < N_CLIP_PLANES; plane++)
+    {
+      const CoglSwVertex **in = polygon[cur];
+      const CoglSwVertex **out = polygon[!cur];
+      CoglSwVertex *storage = buffers[!cur];
+      int n_out = 0;
+
+      if (!(outside_mask & (1 << plane)))
+        continue;
+
+      for (i = 0; i < n_vertices; i++)
+        {
+          const CoglSwVertex *a = in[i];
+          const CoglSwVertex *b = in[(i + 1) % n_vertices];
+          float da = clip_distance (a, plane);
+          float db = clip_distance (b, plane);
+
+          if (da >= 0.0f)
+            out[n_out++] = a;
+
+          if ((da >= 0.0f) != (db >= 0.0f))
+            {
+              CoglSwVertex *v = storage + n_out;
+
+              if (da >= 0.0f)
+                interpolate_vertex (ds, a, b, da / (da - db), v);
+              else
+                interpolate_vertex (ds, b, a, db / (db - da), v);
+
+              out[n_out++] = v;
+            }
+        }
+
+      n_vertices = n_out;
+      cur = !cur;
+
+      if (n_vertices < 3)
+        return;
+    }
+
+  for (i = 0; i < n_vertices; i++)
+    to_window (ds, polygon[cur][i], window + i);
+
+  for (i = 2; i < n_vertices; i++)
+    setup_triangle (ds, window, window + i - 1, window + i,
+                    ds->cull_triangles);
+}
+
+static CoglBool
+vertex_inside (const CoglSwVertex *vertex)
+{
+  int plane;
+
+  for (plane = 0; plane < N_CLIP_PLANES; plane++)
+    if (clip_distance (vertex, plane) < 0.0f)
+      return FALSE;
+
+  return vertex->position[3] > 0.0f;
+}
+
+static void
+draw_quad (DrawState *ds,
+           const WindowVertex *a,
+           const WindowVertex *b,
+           float nx,
+           float ny)
+{
+  WindowVertex corners[4];
+
+  corners[0] = *a;
+  corners[0].x += nx;
+  corners[0].y += ny;
+  corners[1] = *a;
+  corners[1].x -= nx;
+  corners[1].y -= ny;
+  corners[2] = *b;
+  corners[2].x -= nx;
+  corners[2].y -= ny;
+  corners[3] = *b;
+  corners[3].x += nx;
+  corners[3].y += ny;
+
+  setup_triangle (ds, corners, corners + 1, corners + 2, FALSE);
+  setup_triangle (ds, corners, corners + 2, corners + 3, FALSE);
+}
+
+static void
+draw_point (DrawState *ds,
+            const CoglSwVertex *vertex)
+{
+  WindowVertex center, a, b;
+  float half_size = 0.5f;
+
+  if (!vertex_inside (vertex))
+    return;
+
+  if (ds->state && ds->state->point_size > 1.0f)
+    half_size = ds->state->point_size * 0.5f;
+
+  to_window (ds, vertex, &center);
+  /* Points are flat so there's nothing to interpolate */
+  center.inv_w = 1.0f;
+
+  a = center;
+  a.x -= half_size;
+  b = center;
+  b.x += half_size;
+
+  draw_quad (ds, &a, &b, 0.0f, half_size);
+}
+
+static void
+draw_line (DrawState *ds,
+           const CoglSwVertex *v0,
+           const CoglSwVertex *v1)
+{
+  CoglSwVertex clipped[2];
+  WindowVertex a, b;
+  float t0 = 0.0f, t1 = 1.0f;
+  float dx, dy, len;
+  int plane;
+
+  for (plane = 0; plane < N_CLIP_PLANES; plane++)
+    {
+      float d0 = clip_distance (v0, plane);
+      float d1 = clip_distance (v1, plane);
+
+      if (d0 < 0.0f && d1 < 0.0f)
+        return;
+      else if (d0 < 0.0f)
+        t0 = MAX (t0, d0 / (d0 - d1));
+      else if (d1 < 0.0f)
+        t1 = MIN (t1, d0 / (d0 - d1));
+    }
+
+  if (t0 >= t1)
+    return;
+
+  interpolate_vertex (ds, v0, v1, t0, clipped);
+  interpolate_vertex (ds, v0, v1, t1, clipped + 1);
+
+  to_window (ds, clipped, &a);
+  to_window (ds, clipped + 1, &b);
+
+  dx = b.x - a.x;
+  dy = b.y - a.y;
+  len = sqrtf (dx * dx + dy * dy);
+
+  if (len == 0.0f)
+    return;
+
+  /* Lines are drawn as one pixel wide quads */
+  draw_quad (ds, &a, &b, -dy * 0.5f / len, dx * 0.5f / len);
+}
+
+static void
+assemble_primitives (DrawState *ds,
+                     CoglVerticesMode mode,
+                     const CoglSwVertex *vertices,
+                     const int *indices,
+                     int n_vertices)
+{
+  int i;
+
+#define VERTEX(i) (vertices + (indices ? indices[i] : (i)))
+
+  switch (mode)
+    {
+    case COGL_VERTICES_MODE_POINTS:
+      for (i = 0; i < n_vertices; i++)
+        draw_point (ds, VERTEX (i));
+      break;
+
+    case COGL_VERTICES_MODE_LINES:
+      for (i = 0; i + 1 < n_vertices; i += 2)
+        draw_line (ds, VERTEX (i), VERTEX (i + 1));
+      break;
+
+    case COGL_VERTICES_MODE_LINE_STRIP:
+    case COGL_VERTICES_MODE_LINE_LOOP:
+      for (i = 0; i + 1 < n_vertices; i++)
+        draw_line (ds, VERTEX (i), VERTEX (i + 1));
+      if (mode == COGL_VERTICES_MODE_LINE_LOOP && n_vertices > 2)
+        draw_line (ds, VERTEX (n_vertices - 1), VERTEX (0));
+      break;
+
+    case COGL_VERTICES_MODE_TRIANGLES:
+      for (i = 0; i + 2 < n_vertices; i += 3)
+        draw_triangle (ds, VERTEX (i), VERTEX (i + 1), VERTEX (i + 2));
+      break;
+
+    case COGL_VERTICES_MODE_TRIANGLE_STRIP:
+      for (i = 0; i + 2 < n_vertices; i++)
+        {
+          if (i & 1)
+            draw_triangle (ds, VERTEX (i + 1), VERTEX (i), VERTEX (i + 2));
+          else
+            draw_triangle (ds, VERTEX (i), VERTEX (i + 1), VERTEX (i + 2));
+        }
+      break;
+
+    case COGL_VERTICES_MODE_TRIANGLE_FAN:
+      for (i = 1; i + 1 < n_vertices; i++)
+        draw_triangle (ds, VERTEX (0), VERTEX (i), VERTEX (i + 1));
+      break;
+    }
+
+#undef VERTEX
+}
+
+static inline int
+wrap_coord (int coord, int size, CoglSwWrap wrap)
+{
+  switch (wrap)
+    {
+    case COGL_SW_WRAP_REPEAT:
+      coord %= size;
+      return coord < 0 ? coord + size : coord;
+
+    case COGL_SW_WRAP_MIRRORED_REPEAT:
+      coord %= size * 2;
+      if (coord < 0)
+        coord += size * 2;
+      return coord >= size ? size * 2 - 1 - coord : coord;
+
+    default:
+      return CLAMP (coord, 0, size - 1);
+    }
+}
+
+static inline void
+sample_layer (const CoglSwLayer *layer,
+              CoglBool linear,
+              float s,
+              float t,
+              uint8_t *out)
+{
+  const CoglSwImage *image = layer->image;
+
+  if (image == NULL)
+    {
+      out[0] = out[1] = out[2] = out[3] = 255;
+      return;
+    }
+
+  if (!isfinite (s) || !isfinite (t))
+    s = t = 0.0f;
+
+  if (linear)
+    {
+      float u = s * image->width - 0.5f;
+      float v = t * image->height - 0.5f;
+      float fu = floorf (u), fv = floorf (v);
+      int x0 = wrap_coord ((int) fu, image->width, layer->wrap_s);
+      int x1 = wrap_coord ((int) fu + 1, image->width, layer->wrap_s);
+      int y0 = wrap_coord ((int) fv, image->height, layer->wrap_t);
+      int y1 = wrap_coord ((int) fv + 1, image->height, layer->wrap_t);
+      unsigned int wx = (unsigned int) ((u - fu) * 256.0f);
+      unsigned int wy = (unsigned int) ((v - fv) * 256.0f);
+      unsigned int w00 = (256 - wx) * (256 - wy);
+      unsigned int w10 = wx * (256 - wy);
+      unsigned int w01 = (256 - wx) * wy;
+      unsigned int w11 = wx * wy;
+      const uint8_t *row0 = image->data + y0 * image->rowstride;
+      const uint8_t *row1 = image->data + y1 * image->rowstride;
+      const uint8_t *p00 = row0 + x0 * 4, *p10 = row0 + x1 * 4;
+      const uint8_t *p01 = row1 + x0 * 4, *p11 = row1 + x1 * 4;
+      int i;
+
+      for (i = 0; i < 4; i++)
+        out[i] = (p00[i] * w00 + p10[i] * w10 +
+                  p01[i] * w01 + p11[i] * w11 + 32768) >> 16;
+    }
+  else
+    {
+      int x = wrap_coord ((int) floorf (s * image->width),
+                          image->width, layer->wrap_s);
+      int y = wrap_coord ((int) floorf (t * image->height),
+                          image->height, layer->wrap_t);
+
+      memcpy (out, image->data + y * image->rowstride + x * 4, 4);
+    }
+}
+
+static inline const float *
+get_combine_source (int source,
+                    const float *texture,
+                    const float (*textures)[4],
+                    const float *constant,
+                    const float *primary,
+                    const float *previous)
+{
+  switch (source)
+    {
+    case COGL_SW_SOURCE_TEXTURE:
+      return texture;
+    case COGL_SW_SOURCE_CONSTANT:
+      return constant;
+    case COGL_SW_SOURCE_PRIMARY_COLOR:
+      return primary;
+    case COGL_SW_SOURCE_PREVIOUS:
+      return previous;
+    default:
+      return textures[source - COGL_SW_SOURCE_LAYER0];
+    }
+}
+
+static inline float
+clamp_unit (float value)
+{
+  return CLAMP (value, 0.0f, 1.0f);
+}
+
+static void
+combine_rgb (const CoglSwCombine *combine,
+             const float **sources,
+             float *out)
+{
+  float args[3][3];
+  int i, j;
+
+  for (i = 0; i < combine->n_args; i++)
+    {
+      const float *src = sources[i];
+
+      for (j = 0; j < 3; j++)
+        switch (combine->op[i])
+          {
+          case COGL_PIPELINE_COMBINE_OP_ONE_MINUS_SRC_COLOR:
+            args[i][j] = 1.0f - src[j];
+            break;
+          case COGL_PIPELINE_COMBINE_OP_SRC_ALPHA:
+            args[i][j] = src[3];
+            break;
+          case COGL_PIPELINE_COMBINE_OP_ONE_MINUS_SRC_ALPHA:
+            args[i][j] = 1.0f - src[3];
+            break;
+          default:
+            args[i][j] = src[j];
+            break;
+          }
+    }
+
+  switch (combine->func)
+    {
+    case COGL_PIPELINE_COMBINE_FUNC_REPLACE:
+      for (j = 0; j < 3; j++)
+        out[j] = args[0][j];
+      break;
+    case COGL_PIPELINE_COMBINE_FUNC_ADD:
+      for (j = 0; j < 3; j++)
+        out[j] = clamp_unit (args[0][j] + args[1][j]);
+      break;
+    case COGL_PIPELINE_COMBINE_FUNC_ADD_SIGNED:
+      for (j = 0; j < 3; j++)
+        out[j] = clamp_unit (args[0][j] + args[1][j] - 0.5f);
+      break;
+    case COGL_PIPELINE_COMBINE_FUNC_SUBTRACT:
+      for (j = 0; j < 3; j++)
+        out[j] = clamp_unit (args[0][j] - args[1][j]);
+      break;
+    case COGL_PIPELINE_COMBINE_FUNC_INTERPOLATE:
+      for (j = 0; j < 3; j++)
+        out[j] = (args[0][j] * args[2][j] +
+                  args[1][j] * (1.0f - args[2][j]));
+      break;
+    case COGL_PIPELINE_COMBINE_FUNC_DOT3_RGB:
+    case COGL_PIPELINE_COMBINE_FUNC_DOT3_RGBA:
+      {
+        float dot = 0.0f;
+
+        for (j = 0; j < 3; j++)
+          dot += (args[0][j] - 0.5f) * (args[1][j] - 0.5f);
+        out[0] = out[1] = out[2] = clamp_unit (dot * 4.0f);
+      }
+      break;
+    default: /* MODULATE */
+      for (j = 0; j < 3; j++)
+        out[j] = args[0][j] * args[1][j];
+      break;
+    }
+}
+
+static float
+combine_alpha (const CoglSwCombine *combine,
+               const float **sources)
+{
+  float args[3];
+  int i;
+
+  for (i = 0; i < combine->n_args; i++)
+    {
+      if (combine->op[i] == COGL_PIPELINE_COMBINE_OP_ONE_MINUS_SRC_COLOR ||
+          combine->op[i] == COGL_PIPELINE_COMBINE_OP_ONE_MINUS_SRC_ALPHA)
+        args[i] = 1.0f - sources[i][3];
+      else
+        args[i] = sources[i][3];
+    }
+
+  switch (combine->func)
+    {
+    case COGL_PIPELINE_COMBINE_FUNC_REPLACE:
+      return args[0];
+    case COGL_PIPELINE_COMBINE_FUNC_ADD:
+      return clamp_unit (args[0] + args[1]);
+    case COGL_PIPELINE_COMBINE_FUNC_ADD_SIGNED:
+      return clamp_unit (args[0] + args[1] - 0.5f);
+    case COGL_PIPELINE_COMBINE_FUNC_SUBTRACT:
+      return clamp_unit (args[0] - args[1]);
+    case COGL_PIPELINE_COMBINE_FUNC_INTERPOLATE:
+      return args[0] * args[2] + args[1] * (1.0f - args[2]);
+    default: /* MODULATE */
+      return args[0] * args[1];
+    }
+}
+
+static CoglBool
+alpha_test (const CoglSwState *state,
+            float alpha)
+{
+  float ref = state->alpha_reference;
+
+  switch (state->alpha_func)
+    {
+    case COGL_PIPELINE_ALPHA_FUNC_NEVER:
+      return FALSE;
+    case COGL_PIPELINE_ALPHA_FUNC_LESS:
+      return alpha < ref;
+    case COGL_PIPELINE_ALPHA_FUNC_EQUAL:
+      return alpha == ref;
+    case COGL_PIPELINE_ALPHA_FUNC_LEQUAL:
+      return alpha <= ref;
+    case COGL_PIPELINE_ALPHA_FUNC_GREATER:
+      return alpha > ref;
+    case COGL_PIPELINE_ALPHA_FUNC_NOTEQUAL:
+      return alpha != ref;
+    case COGL_PIPELINE_ALPHA_FUNC_GEQUAL:
+      return alpha >= ref;
+    default:
+      return TRUE;
+    }
+}
+
+static inline float
+blend_factor (unsigned int factor,
+              int channel,
+              const float *src,
+              const float *dst,
+              const float *constant)
+{
+  switch (factor)
+    {
+    case GL_ZERO:
+      return 0.0f;
+    case GL_SRC_COLOR:
+      return src[channel];
+    case GL_ONE_MINUS_SRC_COLOR:
+      return 1.0f - src[channel];
+    case GL_SRC_ALPHA:
+      return src[3];
+    case GL_ONE_MINUS_SRC_ALPHA:
+      return 1.0f - src[3];
+    case GL_DST_COLOR:
+      return dst[channel];
+    case GL_ONE_MINUS_DST_COLOR:
+      return 1.0f - dst[channel];
+    case GL_DST_ALPHA:
+      return dst[3];
+    case GL_ONE_MINUS_DST_ALPHA:
+      return 1.0f - dst[3];
+    case GL_SRC_ALPHA_SATURATE:
+      return channel == 3 ? 1.0f : MIN (src[3], 1.0f - dst[3]);
+    case GL_CONSTANT_COLOR:
+      return constant[channel];
+    case GL_ONE_MINUS_CONSTANT_COLOR:
+      return 1.0f - constant[channel];
+    case GL_CONSTANT_ALPHA:
+      return constant[3];
+    case GL_ONE_MINUS_CONSTANT_ALPHA:
+      return 1.0f - constant[3];
+    default: /* GL_ONE */
+      return 1.0f;
+    }
+}
+
+static void
+blend (const CoglSwState *state,
+       const float *src,
+       uint8_t *pixel,
+       float *out)
+{
+  float dst[4];
+  int i;
+
+  for (i = 0; i < 4; i++)
+    dst[i] = pixel[i] * (1.0f / 255.0f);
+
+  for (i = 0; i < 4; i++)
+    {
+      unsigned int src_factor, dst_factor, equation;
+      float s, d;
+
+      if (i < 3)
+        {
+          src_factor = state->blend_src_factor_rgb;
+          dst_factor = state->blend_dst_factor_rgb;
+          equation = state->blend_equation_rgb;
+        }
+      else
+        {
+          src_factor = state->blend_src_factor_alpha;
+          dst_factor = state->blend_dst_factor_alpha;
+          equation = state->blend_equation_alpha;
+        }
+
+      s = src[i] * blend_factor (src_factor, i, src, dst,
+                                 state->blend_constant);
+      d = dst[i] * blend_factor (dst_factor, i, src, dst,
+                                 state->blend_constant);
+
+      switch (equation)
+        {
+        case GL_FUNC_SUBTRACT:
+          out[i] = s - d;
+          break;
+        case GL_FUNC_REVERSE_SUBTRACT:
+          out[i] = d - s;
+          break;
+        default:
+          out[i] = s + d;
+          break;
+        }
+    }
+}
+
+static void
+span_generic (DrawState *ds,
+              const Triangle *tri,
+              int y,
+              int x0,
+              int x1,
+              uint8_t *row,
+              const uint8_t *mask)
+{
+  const CoglSwState *state = ds->state;
+  float varyings[COGL_SW_MAX_VARYINGS];
+  float row_base[COGL_SW_MAX_VARYINGS];
+  float w_row_base = 0.0f;
+  float yc = y + 0.5f;
+  int n_varyings = ds->n_varyings;
+  int x, i;
+
+  for (i = 0; i < n_varyings; i++)
+    row_base[i] = tri->planes[i][1] * yc + tri->planes[i][2];
+  if (tri->perspective)
+    w_row_base = tri->w_plane[1] * yc + tri->w_plane[2];
+
+  for (x = x0; x < x1; x++)
+    {
+      float xc = x + 0.5f;
+      float textures[COGL_SW_MAX_LAYERS][4];
+      float previous[4], result[4];
+      const float *primary;
+      uint8_t *pixel = row + x * 4;
+
+      if (mask && !mask[x])
+        continue;
+
+      if (tri->perspective)
+        {
+          float w = 1.0f / (tri->w_plane[0] * xc + w_row_base);
+
+          for (i = 0; i < n_varyings; i++)
+            varyings[i] = (tri->planes[i][0] * xc + row_base[i]) * w;
+        }
+      else
+        {
+          for (i = 0; i < n_varyings; i++)
+            varyings[i] = tri->planes[i][0] * xc + row_base[i];
+        }
+
+      primary = varyings + COGL_SW_COLOR_VARYING;
+      memcpy (previous, primary, sizeof (previous));
+
+      for (i = 0; i < state->n_layers; i++)
+        {
+          const float *tex_coord = varyings + COGL_SW_TEX_COORD_VARYING (i);
+          uint8_t texel[4];
+          int j;
+
+          sample_layer (state->layers + i, tri->linear[i],
+                        tex_coord[0], tex_coord[1], texel);
+          for (j = 0; j < 4; j++)
+            textures[i][j] = texel[j] * (1.0f / 255.0f);
+        }
+
+      for (i = 0; i < state->n_layers; i++)
+        {
+          const CoglSwLayer *layer = state->layers + i;
+          const float *sources[3];
+          float combined[4];
+          int j;
+
+          if (layer->modulate)
+            {
+              for (j = 0; j < 4; j++)
+                previous[j] *= textures[i][j];
+              continue;
+            }
+
+          for (j = 0; j < layer->rgb.n_args; j++)
+            sources[j] = get_combine_source (layer->rgb.src[j],
+                                             textures[i],
+                                             (const float (*)[4]) textures,
+                                             layer->constant,
+                                             primary,
+                                             previous);
+          combine_rgb (&layer->rgb, sources, combined);
+
+          if (layer->rgb.func == COGL_PIPELINE_COMBINE_FUNC_DOT3_RGBA)
+            combined[3] = combined[0];
+          else
+            {
+              for (j = 0; j < layer->alpha.n_args; j++)
+                sources[j] = get_combine_source (layer->alpha.src[j],
+                                                 textures[i],
+                                                 (const float (*)[4]) textures,
+                                                 layer->constant,
+                                                 primary,
+                                                 previous);
+              combined[3] = combine_alpha (&layer->alpha, sources);
+            }
+
+          memcpy (previous, combined, sizeof (previous));
+        }
+
+      if (!alpha_test (state, previous[3]))
+        continue;
+
+      if (state->blend_enabled)
+        blend (state, previous, pixel, result);
+      else
+        memcpy (result, previous, sizeof (result));
+
+      if (state->color_mask == COGL_COLOR_MASK_ALL)
+        {
+          for (i = 0; i < 4; i++)
+            pixel[i] = float_to_byte (result[i]);
+        }
+      else
+        {
+          for (i = 0; i < 4; i++)
+            if (state->color_mask & (1 << i))
+              pixel[i] = float_to_byte (result[i]);
+        }
+    }
+}
+
+static void
+span_solid (DrawState *ds,
+            const Triangle *tri,
+            int y,
+            int x0,
+            int x1,
+            uint8_t *row,
+            const uint8_t *mask)
+{
+  uint32_t color;
+  uint32_t *pixels = (uint32_t *) row;
+  int x;
+
+  memcpy (&color, ds->flat_color, sizeof (color));
+
+  if (mask)
+    {
+      for (x = x0; x < x1; x++)
+        if (mask[x])
+          pixels[x] = color;
+    }
+  else
+    {
+      for (x = x0; x < x1; x++)
+        pixels[x] = color;
+    }
+}
+
+static inline void
+blend_over (uint8_t *dst,
+            const uint8_t *src)
+{
+  unsigned int inv_alpha = 255 - src[3];
+  int i;
+
+  /* The source isn't necessarily premultiplied so the result has to
+   * be clamped in the same way that GL does */
+  for (i = 0; i < 4; i++)
+    dst[i] = MIN (src[i] + mul_un8 (dst[i], inv_alpha), 255);
+}
+
+static void
+span_solid_over (DrawState *ds,
+                 const Triangle *tri,
+                 int y,
+                 int x0,
+                 int x1,
+                 uint8_t *row,
+                 const uint8_t *mask)
+{
+  int x;
+
+  for (x = x0; x < x1; x++)
+    if (mask == NULL || mask[x])
+      blend_over (row + x * 4, ds->flat_color);
+}
+
+static void
+span_modulate (DrawState *ds,
+               const Triangle *tri,
+               int y,
+               int x0,
+               int x1,
+               uint8_t *row,
+               const uint8_t *mask)
+{
+  const CoglSwLayer *layer = ds->state->layers;
+  const int s_index = COGL_SW_TEX_COORD_VARYING (0);
+  const int t_index = s_index + 1;
+  CoglBool flat_color = ds->state->flat_color;
+  CoglBool linear = tri->linear[0];
+  float yc = y + 0.5f;
+  float s_base = tri->planes[s_index][1] * yc + tri->planes[s_index][2];
+  float t_base = tri->planes[t_index][1] * yc + tri->planes[t_index][2];
+  float color_base[4];
+  float w_base = 0.0f;
+  int x, i;
+
+  for (i = 0; i < 4; i++)
+    color_base[i] = tri->planes[i][1] * yc + tri->planes[i][2];
+  if (tri->perspective)
+    w_base = tri->w_plane[1] * yc + tri->w_plane[2];
+
+  for (x = x0; x < x1; x++)
+    {
+      float xc = x + 0.5f;
+      float w = 1.0f;
+      uint8_t texel[4], color[4];
+
+      if (mask && !mask[x])
+        continue;
+
+      if (tri->perspective)
+        w = 1.0f / (tri->w_plane[0] * xc + w_base);
+
+      sample_layer (layer, linear,
+                    (tri->planes[s_index][0] * xc + s_base) * w,
+                    (tri->planes[t_index][0] * xc + t_base) * w,
+                    texel);
+
+      if (flat_color)
+        memcpy (color, ds->flat_color, 4);
+      else
+        for (i = 0; i < 4; i++)
+          color[i] = float_to_byte ((tri->planes[i][0] * xc +
+                                     color_base[i]) * w);
+
+      for (i = 0; i < 4; i++)
+        texel[i] = mul_un8 (texel[i], color[i]);
+
+      if (ds->blend_over)
+        blend_over (row + x * 4, texel);
+      else
+        memcpy (row + x * 4, texel, 4);
+    }
+}
+
+static void
+span_coverage (DrawState *ds,
+               const Triangle *tri,
+               int y,
+               int x0,
+               int x1,
+               uint8_t *row,
+               const uint8_t *mask)
+{
+  uint8_t *coverage = ds->coverage + y * ds->coverage_rowstride;
+  int x;
+
+  if (ds->invert)
+    for (x = x0; x < x1; x++)
+      coverage[x] ^= 0xff;
+  else
+    memset (coverage + x0, 0xff, x1 - x0);
+}
+
+static void
+rasterize_triangle (DrawState *ds,
+                    const Triangle *tri,
+                    int x0,
+                    int y0,
+                    int x1,
+                    int y1)
+{
+  const CoglSwTarget *target = ds->target;
+  int y;
+
+  x0 = MAX (x0, tri->x0);
+  y0 = MAX (y0, tri->y0);
+  x1 = MIN (x1, tri->x1);
+  y1 = MIN (y1, tri->y1);
+
+  for (y = y0; y < y1; y++)
+    {
+      float yc = y + 0.5f;
+      float span_x0 = x0, span_x1 = x1 - 1;
+      int e;
+
+      /* Find the range of pixel centres within all three edges on
+       * this row */
+      for (e = 0; e < 3; e++)
+        {
+          float a = tri->a[e];
+          float v = tri->b[e] * yc + tri->c[e];
+
+          if (a == 0.0f)
+            {
+              if (v < 0.0f || (v == 0.0f && !tri->top_left[e]))
+                break;
+            }
+          else
+            {
+              float t = -v / a - 0.5f;
+
+              if (a > 0.0f)
+                {
+                  float start = tri->top_left[e] ? ceilf (t) : floorf (t) + 1;
+
+                  span_x0 = MAX (span_x0, start);
+                }
+              else
+                {
+                  float end = tri->top_left[e] ? floorf (t) : ceilf (t) - 1;
+
+                  span_x1 = MIN (span_x1, end);
+                }
+            }
+        }
+
+      if (e < 3 || span_x0 > span_x1)
+        continue;
+
+      {
+        uint8_t *row = target->color.data + y * target->color.rowstride;
+        const uint8_t *mask = NULL;
+        int sx0 = (int) span_x0, sx1 = (int) span_x1 + 1;
+
+        if (target->clip_mask && ds->span_func != SPAN_FUNC_COVERAGE)
+          mask = target->clip_mask + y * target->clip_mask_rowstride;
+
+        switch (ds->span_func)
+          {
+          case SPAN_FUNC_SOLID:
+            span_solid (ds, tri, y, sx0, sx1, row, mask);
+            break;
+          case SPAN_FUNC_SOLID_OVER:
+            span_solid_over (ds, tri, y, sx0, sx1, row, mask);
+            break;
+          case SPAN_FUNC_MODULATE:
+            span_modulate (ds, tri, y, sx0, sx1, row, mask);
+            break;
+          case SPAN_FUNC_COVERAGE:
+            span_coverage (ds, tri, y, sx0, sx1, row, mask);
+            break;
+          default:
+            span_generic (ds, tri, y, sx0, sx1, row, mask);
+            break;
+          }
+      }
+    }
+}
+
+static void
+rasterize_region (DrawState *ds,
+                  int x0,
+                  int y0,
+                  int x1,
+                  int y1)
+{
+  const Triangle *triangles = (const Triangle *) ds->triangles->data;
+  int i;
+
+  for (i = 0; i < ds->triangles->len; i++)
+    {
+      const Triangle *tri = triangles + i;
+
+      if (tri->x0 < x1 && tri->x1 > x0 && tri->y0 < y1 && tri->y1 > y0)
+        rasterize_triangle (ds, tri, x0, y0, x1, y1);
+    }
+}
+
+static void
+rasterize_tile_cb (int index,
+                   void *user_data)
+{
+  DrawState *ds = user_data;
+  const Triangle *triangles = (const Triangle *) ds->triangles->data;
+  int x0 = ds->x0 + (index % ds->n_tiles_x) * TILE_SIZE;
+  int y0 = ds->y0 + (index / ds->n_tiles_x) * TILE_SIZE;
+  int x1 = MIN (x0 + TILE_SIZE, ds->x1);
+  int y1 = MIN (y0 + TILE_SIZE, ds->y1);
+  int i;
+
+  for (i = ds->tile_offsets[index]; i < ds->tile_offsets[index + 1]; i++)
+    rasterize_triangle (ds,
+                        triangles + ds->tile_triangles[i],
+                        x0, y0,
+                        x1, y1);
+}
+
+static void
+get_triangle_tiles (const DrawState *ds,
+                    const Triangle *tri,
+                    int *tile_x0,
+                    int *tile_y0,
+                    int *tile_x1,
+                    int *tile_y1)
+{
+  /* The bounding box of the triangle is always within the union of
+   * the bounding boxes so the tiles don't need to be clamped */
+  *tile_x0 = (tri->x0 - ds->x0) / TILE_SIZE;
+  *tile_y0 = (tri->y0 - ds->y0) / TILE_SIZE;
+  *tile_x1 = (tri->x1 - 1 - ds->x0) / TILE_SIZE + 1;
+  *tile_y1 = (tri->y1 - 1 - ds->y0) / TILE_SIZE + 1;
+}
+
+/* Sorts the triangles into a list for each tile so that each tile
+ * only has to look at the triangles that touch it */
+static void
+bin_triangles (DrawState *ds,
+               int n_tiles)
+{
+  const Triangle *triangles = (const Triangle *) ds->triangles->data;
+  int *counts;
+  int i, tx, ty;
+
+  ds->tile_offsets = g_new0 (int, n_tiles + 1);
+  counts = ds->tile_offsets + 1;
+
+  for (i = 0; i < ds->triangles->len; i++)
+    {
+      int tile_x0, tile_y0, tile_x1, tile_y1;
+
+      get_triangle_tiles (ds, triangles + i,
+                          &tile_x0, &tile_y0,
+                          &tile_x1, &tile_y1);
+
+      for (ty = tile_y0; ty < tile_y1; ty++)
+        for (tx = tile_x0; tx < tile_x1; tx++)
+          counts[ty * ds->n_tiles_x + tx]++;
+    }
+
+  /* Convert the counts to the start offset of the next tile's list */
+  for (i = 1; i <= n_tiles; i++)
+    ds->tile_offsets[i] += ds->tile_offsets[i - 1];
+
+  ds->tile_triangles = g_new (int, ds->tile_offsets[n_tiles]);
+
+  /* Shift the offsets up by one so that counts holds the start of
+   * each list and can be used as a write position. Filling the lists
+   * in drawing order then moves each entry of counts to the end of
+   * its list which puts the offsets back where they belong */
+  for (i = n_tiles; i > 0; i--)
+    ds->tile_offsets[i] = ds->tile_offsets[i - 1];
+
+  for (i = 0; i < ds->triangles->len; i++)
+    {
+      int tile_x0, tile_y0, tile_x1, tile_y1;
+
+      get_triangle_tiles (ds, triangles + i,
+                          &tile_x0, &tile_y0,
+                          &tile_x1, &tile_y1);
+
+      for (ty = tile_y0; ty < tile_y1; ty++)
+        for (tx = tile_x0; tx < tile_x1; tx++)
+          ds->tile_triangles[counts[ty * ds->n_tiles_x + tx]++] = i;
+    }
+}
+
+static void
+rasterize (CoglContext *ctx,
+           DrawState *ds)
+{
+  CoglWorkerPool *pool;
+  int n_tiles_y;
+
+  if (ds->triangles->len == 0)
+    return;
+
+  if (ds->area < MIN_PARALLEL_AREA)
+    {
+      rasterize_region (ds, ds->x0, ds->y0, ds->x1, ds->y1);
+      return;
+    }
+
+  pool = _cogl_context_get_worker_pool (ctx);
+
+  if (_cogl_worker_pool_get_n_threads (pool) < 2)
+    {
+      rasterize_region (ds, ds->x0, ds->y0, ds->x1, ds->y1);
+      return;
+    }
+
+  ds->n_tiles_x = (ds->x1 - ds->x0 + TILE_SIZE - 1) / TILE_SIZE;
+  n_tiles_y = (ds->y1 - ds->y0 + TILE_SIZE - 1) / TILE_SIZE;
+
+  bin_triangles (ds, ds->n_tiles_x * n_tiles_y);
+
+  _cogl_worker_pool_run (pool,
+                         ds->n_tiles_x * n_tiles_y,
+                         rasterize_tile_cb,
+                         ds);
+
+  g_free (ds->tile_triangles);
+  g_free (ds->tile_offsets);
+}
+
+static void
+init_draw_state (DrawState *ds,
+                 const CoglSwTarget *target)
+{
+  memset (ds, 0, sizeof (DrawState));
+
+  ds->target = target;
+  ds->x0 = INT_MAX;
+  ds->y0 = INT_MAX;
+  ds->x1 = INT_MIN;
+  ds->y1 = INT_MIN;
+  ds->triangles = g_array_new (FALSE, FALSE, sizeof (Triangle));
+}
+
+static CoglBool
+is_blend_over (const CoglSwState *state)
+{
+  return (state->blend_equation_rgb == GL_FUNC_ADD &&
+          state->blend_equation_alpha == GL_FUNC_ADD &&
+          state->blend_src_factor_rgb == GL_ONE &&
+          state->blend_src_factor_alpha == GL_ONE &&
+          state->blend_dst_factor_rgb == GL_ONE_MINUS_SRC_ALPHA &&
+          state->blend_dst_factor_alpha == GL_ONE_MINUS_SRC_ALPHA);
+}
+
+static SpanFunc
+choose_span_func (DrawState *ds)
+{
+  const CoglSwState *state = ds->state;
+
+  ds->blend_over = state->blend_enabled && is_blend_over (state);
+
+  if (state->alpha_func != COGL_PIPELINE_ALPHA_FUNC_ALWAYS ||
+      state->color_mask != COGL_COLOR_MASK_ALL ||
+      (state->blend_enabled && !ds->blend_over))
+    return SPAN_FUNC_GENERIC;
+
+  if (state->n_layers == 0 && state->flat_color)
+    return ds->blend_over ? SPAN_FUNC_SOLID_OVER : SPAN_FUNC_SOLID;
+
+  if (state->n_layers == 1 && state->layers[0].modulate)
+    return SPAN_FUNC_MODULATE;
+
+  return SPAN_FUNC_GENERIC;
+}
+
+void
+_cogl_rasterizer_sw_draw (CoglContext *ctx,
+                          const CoglSwTarget *target,
+                          const CoglSwState *state,
+                          CoglVerticesMode mode,
+                          const CoglSwVertex *vertices,
+                          const int *indices,
+                          int n_vertices)
+{
+  DrawState ds;
+  int i;
+
+  if (n_vertices <= 0 ||
+      target->scissor_x0 >= target->scissor_x1 ||
+      target->scissor_y0 >= target->scissor_y1)
+    return;
+
+  init_draw_state (&ds, target);
+
+  ds.state = state;
+  ds.n_varyings = COGL_SW_TEX_COORD_VARYING (state->n_layers);
+  ds.cull_triangles = TRUE;
+  ds.span_func = choose_span_func (&ds);
+
+  for (i = 0; i < 4; i++)
+    {
+      const CoglSwVertex *first = vertices + (indices ? indices[0] : 0);
+
+      ds.flat_color[i] =
+        float_to_byte (first->varyings[COGL_SW_COLOR_VARYING + i]);
+    }
+
+  assemble_primitives (&ds, mode, vertices, indices, n_vertices);
+
+  rasterize (ctx, &ds);
+
+  g_array_free (ds.triangles, TRUE);
+}
+
+void
+_cogl_rasterizer_sw_fill_coverage (CoglContext *ctx,
+                                   const CoglSwTarget *target,
+                                   CoglVerticesMode mode,
+                                   const CoglSwVertex *vertices,
+                                   const int *indices,
+                                   int n_vertices,
+                                   uint8_t *coverage,
+                                   int coverage_rowstride,
+                                   CoglBool invert)
+{
+  DrawState ds;
+
+  if (n_vertices <= 0 ||
+      target->scissor_x0 >= target->scissor_x1 ||
+      target->scissor_y0 >= target->scissor_y1)
+    return;
+
+  init_draw_state (&ds, target);
+
+  ds.span_func = SPAN_FUNC_COVERAGE;
+  ds.coverage = coverage;
+  ds.coverage_rowstride = coverage_rowstride;
+  ds.invert = invert;
+
+  assemble_primitives (&ds, mode, vertices, indices, n_vertices);
+
+  /* The coverage is built up with an XOR when inverting so the
+   * triangles have to be processed in order within each pixel which
+   * the tiling already guarantees */
+  rasterize (ctx, &ds);
+
+  g_array_free (ds.triangles, TRUE);
+}
+
+void
+_cogl_rasterizer_sw_clear (CoglContext *ctx,
+                           const CoglSwTarget *target,
+                           const float *color,
+                           CoglColorMask color_mask)
+{
+  uint8_t bytes[4];
+  uint32_t packed;
+  int x, y, i;
+
+  for (i = 0; i < 4; i++)
+    bytes[i] = float_to_byte (color[i]);
+  memcpy (&packed, bytes, sizeof (packed));
+
+  for (y = target->scissor_y0; y < target->scissor_y1; y++)
+    {
+      uint8_t *row = target->color.data + y * target->color.rowstride;
+
+      if (color_mask == COGL_COLOR_MASK_ALL)
+        {
+          uint32_t *pixels = (uint32_t *) row;
+
+          for (x = target->scissor_x0; x < target->scissor_x1; x++)
+            pixels[x] = packed;
+        }
+      else
+        {
+          for (x = target->scissor_x0; x < target->scissor_x1; x++)
+            for (i = 0; i < 4; i++)
+              if (color_mask & (1 << i))
+                row[x * 4 + i] = bytes[i];
+        }
+    }
+}
@@ -0,0 +1,108 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _COGL_TEXTURE_2D_SW_PRIVATE_H_
+#define _COGL_TEXTURE_2D_SW_PRIVATE_H_
+
+#include "cogl-types.h"
+#include "cogl-context-private.h"
+#include "cogl-texture.h"
+#include "cogl-rasterizer-sw-private.h"
+
+void
+_cogl_texture_2d_sw_free (CoglTexture2D *tex_2d);
+
+CoglBool
+_cogl_texture_2d_sw_can_create (CoglContext *ctx,
+                                int width,
+                                int height,
+                                CoglPixelFormat internal_format);
+
+void
+_cogl_texture_2d_sw_init (CoglTexture2D *tex_2d);
+
+CoglBool
+_cogl_texture_2d_sw_allocate (CoglTexture *tex,
+                              CoglError **error);
+
+void
+_cogl_texture_2d_sw_copy_from_framebuffer (CoglTexture2D *tex_2d,
+                                           int src_x,
+                                           int src_y,
+                                           int width,
+                                           int height,
+                                           CoglFramebuffer *src_fb,
+                                           int dst_x,
+                                           int dst_y,
+                                           int level);
+
+unsigned int
+_cogl_texture_2d_sw_get_gl_handle (CoglTexture2D *tex_2d);
+
+void
+_cogl_texture_2d_sw_generate_mipmap (CoglTexture2D *tex_2d);
+
+CoglBool
+_cogl_texture_2d_sw_copy_from_bitmap (CoglTexture2D *tex_2d,
+                                      int src_x,
+                                      int src_y,
+                                      int width,
+                                      int height,
+                                      CoglBitmap *bitmap,
+                                      int dst_x,
+                                      int dst_y,
+                                      int level,
+                                      CoglError **error);
+
+void
+_cogl_texture_2d_sw_get_data (CoglTexture2D *tex_2d,
+                              CoglPixelFormat format,
+                              int rowstride,
+                              uint8_t *data);
+
+/*
+ * _cogl_texture_sw_get_image:
+ * @texture: A #CoglTexture
+ * @x_offset: Return location for the x offset of @texture within
+ *   the image
+ * @y_offset: Return location for the y offset of @texture within
+ *   the image
+ *
+ * Finds the pixel storage backing @texture. Atlas textures,
+ * sub-textures and sliced textures with a single slice are resolved
+ * to the #CoglTexture2D that they are drawn with.
+ *
+ * Return value: The image or %NULL if the texture isn't backed by a
+ *   single #CoglTexture2D.
+ */
+CoglSwImage *
+_cogl_texture_sw_get_image (CoglTexture *texture,
+                            int *x_offset,
+                            int *y_offset);
+
+#endif /* _COGL_TEXTURE_2D_SW_PRIVATE_H_ */
@@ -0,0 +1,446 @@
+/*
+ * Cogl
+ *
+ * A Low-Level GPU Graphics and Utilities API
+ *
+ * Copyright (C) 2014 Intel Corporation.
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without
+ * restriction, including without limitation the rights to use, copy,
+ * modify, merge, publish, distribute, sublicense, and/or sell copies
+ * of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+
+#include "cogl-private.h"
+#include "cogl-texture-2d-sw-private.h"
+#include "cogl-framebuffer-sw-private.h"
+#include "cogl-texture-2d-private.h"
+#include "cogl-texture-2d-sliced-private.h"
+#include "cogl-atlas-texture-private.h"
+#include "cogl-sub-texture-private.h"
+#include "cogl-sub-texture.h"
+#include "cogl-bitmap-private.h"
+#include "cogl-error-private.h"
+
+/* Limit the size of textures to the same size that most GPUs
+ * support so that applications see similar slicing behaviour */
+#define MAX_TEXTURE_SIZE 8192
+
+typedef struct
+{
+  CoglSwImage image;
+
+  /* The journal compares the GL handles of textures to decide whether
+   * two pipelines can be batched together so each texture needs a
+   * unique number to stand in for the handle */
+  unsigned int handle;
+} CoglTexture2DSw;
+
+static CoglUserDataKey texture_sw_key;
+
+static void
+destroy_texture_sw (void *user_data,
+                    void *instance)
+{
+  CoglTexture2DSw *tex_sw = user_data;
+
+  g_free (tex_sw->image.data);
+  g_slice_free (CoglTexture2DSw, tex_sw);
+}
+
+static CoglTexture2DSw *
+get_texture_sw (CoglTexture2D *tex_2d)
+{
+  return cogl_object_get_user_data (COGL_OBJECT (tex_2d), &texture_sw_key);
+}
+
+static CoglSwImage *
+get_image (CoglTexture2D *tex_2d)
+{
+  CoglTexture2DSw *tex_sw = get_texture_sw (tex_2d);
+
+  return tex_sw ? &tex_sw->image : NULL;
+}
+
+CoglSwImage *
+_cogl_texture_sw_get_image (CoglTexture *texture,
+                            int *x_offset,
+                            int *y_offset)
+{
+  *x_offset = 0;
+  *y_offset = 0;
+
+  while (texture)
+    {
+      if (cogl_is_texture_2d (texture))
+        return get_image (COGL_TEXTURE_2D (texture));
+      else if (cogl_is_atlas_texture (texture))
+        texture = COGL_ATLAS_TEXTURE (texture)->sub_texture;
+      else if (cogl_is_sub_texture (texture))
+        {
+          CoglSubTexture *sub_tex = COGL_SUB_TEXTURE (texture);
+
+          *x_offset += sub_tex->sub_x;
+          *y_offset += sub_tex->sub_y;
+          texture = sub_tex->full_texture;
+        }
+      else if (cogl_is_texture_2d_sliced (texture))
+        {
+          CoglTexture2DSliced *tex_2ds = COGL_TEXTURE_2D_SLICED (texture);
+
+          if (tex_2ds->slice_textures == NULL ||
+              tex_2ds->slice_textures->len != 1)
+            return NULL;
+
+          texture = COGL_TEXTURE (g_array_index (tex_2ds->slice_textures,
+                                                 CoglTexture2D *,
+                                                 0));
+        }
+      else
+        return NULL;
+    }
+
+  return NULL;
+}
+
+void
+_cogl_texture_2d_sw_free (CoglTexture2D *tex_2d)
+{
+  /* The image is attached as user data so it will be freed along
+   * with the texture */
+}
+
+CoglBool
+_cogl_texture_2d_sw_can_create (CoglContext *ctx,
+                                int width,
+                                int height,
+                                CoglPixelFormat internal_format)
+{
+  /* There is no depth buffer so depth textures can't be used */
+  if (internal_format & COGL_DEPTH_BIT)
+    return FALSE;
+
+  return (width > 0 && width <= MAX_TEXTURE_SIZE &&
+          height > 0 && height <= MAX_TEXTURE_SIZE);
+}
+
+void
+_cogl_texture_2d_sw_init (CoglTexture2D *tex_2d)
+{
+}
+
+static CoglSwImage *
+create_image (CoglTexture2D *tex_2d,
+              int width,
+              int height,
+              CoglPixelFormat internal_format,
+              CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_2d);
+  CoglContext *ctx = tex->context;
+  static unsigned int next_handle = 1;
+  CoglTexture2DSw *tex_sw;
+  CoglSwImage *image;
+
+  if (!_cogl_texture_2d_sw_can_create (ctx, width, height, internal_format))
+    {
+      _cogl_set_error (error, COGL_TEXTURE_ERROR,
+                       COGL_TEXTURE_ERROR_SIZE,
+                       "Failed to create texture 2d due to size/format"
+                       " constraints");
+      return NULL;
+    }
+
+  tex_sw = g_slice_new (CoglTexture2DSw);
+  tex_sw->handle = next_handle++;
+
+  image = &tex_sw->image;
+  image->width = width;
+  image->height = height;
+  image->rowstride = width * 4;
+  image->format =
+    ctx->driver_vtable->pixel_format_to_gl (ctx, internal_format,
+                                            NULL, NULL, NULL);
+  image->data = g_malloc0 (image->rowstride * height);
+
+  _cogl_object_set_user_data (COGL_OBJECT (tex_2d),
+                              &texture_sw_key,
+                              tex_sw,
+                              destroy_texture_sw);
+
+  return image;
+}
+
+static void
+copy_rows (CoglSwImage *image,
+           int dst_x,
+           int dst_y,
+           const uint8_t *src,
+           int src_rowstride,
+           int width,
+           int height)
+{
+  uint8_t *dst = image->data + dst_y * image->rowstride + dst_x * 4;
+  int y;
+
+  for (y = 0; y < height; y++)
+    memcpy (dst + y * image->rowstride, src + y * src_rowstride, width * 4);
+}
+
+static CoglBool
+upload_bitmap (CoglSwImage *image,
+               CoglBitmap *upload_bmp,
+               int src_x,
+               int src_y,
+               int width,
+               int height,
+               int dst_x,
+               int dst_y,
+               CoglError **error)
+{
+  int rowstride = cogl_bitmap_get_rowstride (upload_bmp);
+  uint8_t *data;
+
+  data = _cogl_bitmap_map (upload_bmp, COGL_BUFFER_ACCESS_READ, 0, error);
+  if (data == NULL)
+    return FALSE;
+
+  copy_rows (image, dst_x, dst_y,
+             data + src_y * rowstride + src_x * 4, rowstride,
+             width, height);
+
+  _cogl_bitmap_unmap (upload_bmp);
+
+  return TRUE;
+}
+
+static CoglBool
+allocate_from_bitmap (CoglTexture2D *tex_2d,
+                      CoglTextureLoader *loader,
+                      CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_2d);
+  CoglBitmap *bmp = loader->src.bitmap.bitmap;
+  int width = cogl_bitmap_get_width (bmp);
+  int height = cogl_bitmap_get_height (bmp);
+  CoglPixelFormat internal_format;
+  CoglBitmap *upload_bmp;
+  CoglSwImage *image;
+  CoglBool status;
+
+  internal_format =
+    _cogl_texture_determine_internal_format (tex, cogl_bitmap_get_format (bmp));
+
+  image = create_image (tex_2d, width, height, internal_format, error);
+  if (image == NULL)
+    return FALSE;
+
+  upload_bmp =
+    _cogl_bitmap_convert_for_upload (bmp,
+                                     internal_format,
+                                     loader->src.bitmap.can_convert_in_place,
+                                     error);
+  if (upload_bmp == NULL)
+    return FALSE;
+
+  status = upload_bitmap (image, upload_bmp,
+                          0, 0, width, height,
+                          0, 0,
+                          error);
+
+  cogl_object_unref (upload_bmp);
+
+  if (!status)
+    return FALSE;
+
+  tex_2d->internal_format = internal_format;
+
+  _cogl_texture_set_allocated (tex, internal_format, width, height);
+
+  return TRUE;
+}
+
+CoglBool
+_cogl_texture_2d_sw_allocate (CoglTexture *tex,
+                              CoglError **error)
+{
+  CoglTexture2D *tex_2d = COGL_TEXTURE_2D (tex);
+  CoglTextureLoader *loader = tex->loader;
+  CoglPixelFormat internal_format;
+
+  _COGL_RETURN_VAL_IF_FAIL (loader, FALSE);
+
+  switch (loader->src_type)
+    {
+    case COGL_TEXTURE_SOURCE_TYPE_SIZED:
+      internal_format =
+        _cogl_texture_determine_internal_format (tex, COGL_PIXEL_FORMAT_ANY);
+      if (!create_image (tex_2d,
+                         loader->src.sized.width,
+                         loader->src.sized.height,
+                         internal_format,
+                         error))
+        return FALSE;
+      tex_2d->internal_format = internal_format;
+      _cogl_texture_set_allocated (tex,
+                                   internal_format,
+                                   loader->src.sized.width,
+                                   loader->src.sized.height);
+      return TRUE;
+    case COGL_TEXTURE_SOURCE_TYPE_BITMAP:
+      return allocate_from_bitmap (tex_2d, loader, error);
+    default:
+      _cogl_set_error (error, COGL_TEXTURE_ERROR,
+                       COGL_TEXTURE_ERROR_TYPE,
+                       "The software driver can only create textures "
+                       "from bitmaps or sizes");
+      return FALSE;
+    }
+}
+
+void
+_cogl_texture_2d_sw_copy_from_framebuffer (CoglTexture2D *tex_2d,
+                                           int src_x,
+                                           int src_y,
+                                           int width,
+                                           int height,
+                                           CoglFramebuffer *src_fb,
+                                           int dst_x,
+                                           int dst_y,
+                                           int level)
+{
+  CoglSwImage *image = get_image (tex_2d);
+  CoglSwImage *src_image;
+
+  if (image == NULL || level != 0)
+    return;
+
+  src_image = _cogl_framebuffer_sw_get_color_image (src_fb);
+  if (src_image == NULL)
+    return;
+
+  copy_rows (image, dst_x, dst_y,
+             src_image->data + src_y * src_image->rowstride + src_x * 4,
+             src_image->rowstride,
+             width, height);
+}
+
+unsigned int
+_cogl_texture_2d_sw_get_gl_handle (CoglTexture2D *tex_2d)
+{
+  CoglTexture2DSw *tex_sw = get_texture_sw (tex_2d);
+
+  return tex_sw ? tex_sw->handle : 0;
+}
+
+void
+_cogl_texture_2d_sw_generate_mipmap (CoglTexture2D *tex_2d)
+{
+  /* Only the base level is ever sampled */
+}
+
+CoglBool
+_cogl_texture_2d_sw_copy_from_bitmap (CoglTexture2D *tex_2d,
+                                      int src_x,
+                                      int src_y,
+                                      int width,
+                                      int height,
+                                      CoglBitmap *bmp,
+                                      int dst_x,
+                                      int dst_y,
+                                      int level,
+                                      CoglError **error)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_2d);
+  CoglSwImage *image = get_image (tex_2d);
+  CoglBitmap *upload_bmp;
+  CoglBool status;
+
+  /* Only the base level is sampled so there is no need to store the
+   * other levels */
+  if (image == NULL || level != 0)
+    return TRUE;
+
+  upload_bmp =
+    _cogl_bitmap_convert_for_upload (bmp,
+                                     _cogl_texture_get_format (tex),
+                                     FALSE, /* can't convert in place */
+                                     error);
+  if (upload_bmp == NULL)
+    return FALSE;
+
+  status = upload_bitmap (image, upload_bmp,
+                          src_x, src_y, width, height,
+                          dst_x, dst_y,
+                          error);
+
+  cogl_object_unref (upload_bmp);
+
+  return status;
+}
+
+void
+_cogl_texture_2d_sw_get_data (CoglTexture2D *tex_2d,
+                              CoglPixelFormat format,
+                              int rowstride,
+                              uint8_t *data)
+{
+  CoglContext *ctx = COGL_TEXTURE (tex_2d)->context;
+  CoglSwImage *image = get_image (tex_2d);
+  CoglPixelFormat src_format;
+  CoglBitmap *src_bmp, *dst_bmp;
+  CoglError *ignore_error = NULL;
+
+  if (image == NULL)
+    return;
+
+  /* Like glGetTexImage this only converts the layout of the data. The
+   * front end takes care of any premultiplication that is needed based
+   * on the format of the texture. This matters for the atlas which
+   * stores premultiplied data in a texture that isn't marked as
+   * premultiplied. */
+  src_format = image->format;
+  if (COGL_PIXEL_FORMAT_CAN_HAVE_PREMULT (format))
+    src_format = ((src_format & ~COGL_PREMULT_BIT) |
+                  (format & COGL_PREMULT_BIT));
+
+  src_bmp = cogl_bitmap_new_for_data (ctx,
+                                      image->width,
+                                      image->height,
+                                      src_format,
+                                      image->rowstride,
+                                      image->data);
+  dst_bmp = cogl_bitmap_new_for_data (ctx,
+                                      image->width,
+                                      image->height,
+                                      format,
+                                      rowstride,
+                                      data);
+
+  if (!_cogl_bitmap_convert_into_bitmap (src_bmp, dst_bmp, &ignore_error))
+    cogl_error_free (ignore_error);
+
+  cogl_object_unref (dst_bmp);
+  cogl_object_unref (src_bmp);
+}
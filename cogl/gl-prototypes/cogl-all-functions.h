@@ -326,3 +326,62 @@ COGL_EXT_BEGIN (draw_buffers, 2, 0,
 COGL_EXT_FUNCTION (void, glDrawBuffers,
                    (GLsizei n, const GLenum *bufs))
 COGL_EXT_END ()
+
+COGL_EXT_BEGIN (draw_instanced, 3, 1,
+                COGL_EXT_IN_GLES3,
+                "ARB\0EXT\0",
+                "draw_instanced\0")
+COGL_EXT_FUNCTION (void, glDrawArraysInstanced,
+                   (GLenum mode,
+                    GLint first,
+                    GLsizei count,
+                    GLsizei instancecount))
+COGL_EXT_FUNCTION (void, glDrawElementsInstanced,
+                   (GLenum mode,
+                    GLsizei count,
+                    GLenum type,
+                    const GLvoid *indices,
+                    GLsizei instancecount))
+COGL_EXT_END ()
+
+COGL_EXT_BEGIN (instanced_arrays, 3, 3,
+                COGL_EXT_IN_GLES3,
+                "ARB\0EXT\0",
+                "instanced_arrays\0")
+COGL_EXT_FUNCTION (void, glVertexAttribDivisor,
+                   (GLuint index, GLuint divisor))
+COGL_EXT_END ()
+
+COGL_EXT_BEGIN (multi_draw_arrays, 1, 4,
+                0, /* not in either GLES */
+                "EXT\0",
+                "multi_draw_arrays\0")
+COGL_EXT_FUNCTION (void, glMultiDrawArrays,
+                   (GLenum mode,
+                    const GLint *first,
+                    const GLsizei *count,
+                    GLsizei drawcount))
+COGL_EXT_FUNCTION (void, glMultiDrawElements,
+                   (GLenum mode,
+                    const GLsizei *count,
+                    GLenum type,
+                    const GLvoid **indices,
+                    GLsizei drawcount))
+COGL_EXT_END ()
+
+COGL_EXT_BEGIN (uniform_buffer_object, 3, 1,
+                0, /* not in GLES2 */
+                "ARB:\0",
+                "uniform_buffer_object\0")
+COGL_EXT_FUNCTION (GLuint, glGetUniformBlockIndex,
+                   (GLuint program,
+                    const GLchar *uniformBlockName))
+COGL_EXT_FUNCTION (void, glUniformBlockBinding,
+                   (GLuint program,
+                    GLuint uniformBlockIndex,
+                    GLuint uniformBlockBinding))
+COGL_EXT_FUNCTION (void, glBindBufferBase,
+                   (GLenum target,
+                    GLuint index,
+                    GLuint buffer))
+COGL_EXT_END ()
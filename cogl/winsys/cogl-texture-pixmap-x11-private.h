@@ -55,6 +55,21 @@ struct _CoglDamageRectangle
   unsigned int y2;
 };
 
+/* The damage is tracked as a short list of disjoint-ish rectangles so
+ * that a couple of small updates in opposite corners of a large
+ * pixmap don't end up fetching everything in between. Once the list
+ * is full any further rectangles get merged into the rectangle that
+ * grows the least. */
+#define COGL_TEXTURE_PIXMAP_X11_MAX_DAMAGE_RECTS 8
+
+typedef struct _CoglDamageRegion CoglDamageRegion;
+
+struct _CoglDamageRegion
+{
+  int n_rects;
+  CoglDamageRectangle rects[COGL_TEXTURE_PIXMAP_X11_MAX_DAMAGE_RECTS];
+};
+
 /* For stereo, there are a pair of textures, but we want to share most
  * other state (the GLXPixmap, visual, etc.) The way we do this is that
  * the left-eye texture has all the state (there is in fact, no internal
@@ -89,7 +104,7 @@ struct _CoglTexturePixmapX11
   Damage damage;
   CoglTexturePixmapX11ReportLevel damage_report_level;
   CoglBool damage_owned;
-  CoglDamageRectangle damage_rect;
+  CoglDamageRegion damage_region;
 
   void *winsys;
 
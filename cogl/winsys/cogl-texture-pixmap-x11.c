@@ -68,6 +68,8 @@
 #include <string.h>
 #include <math.h>
 
+#include <test-fixtures/test-unit.h>
+
 static void _cogl_texture_pixmap_x11_free (CoglTexturePixmapX11 *tex_pixmap);
 
 COGL_TEXTURE_DEFINE (TexturePixmapX11, texture_pixmap_x11);
@@ -80,43 +82,198 @@ cogl_texture_pixmap_x11_error_domain (void)
   return g_quark_from_static_string ("cogl-texture-pixmap-error-quark");
 }
 
+/* Every separate damage rectangle costs a round trip to the X server
+   and a separate texture upload so two rectangles are merged whenever
+   the bounding box of both would only cover this many more pixels
+   than the two rectangles do individually */
+#define COGL_DAMAGE_MERGE_THRESHOLD (64 * 64)
+
+static unsigned int
+cogl_damage_rectangle_get_area (const CoglDamageRectangle *rect)
+{
+  return (rect->x2 - rect->x1) * (rect->y2 - rect->y1);
+}
+
 static void
-cogl_damage_rectangle_union (CoglDamageRectangle *damage_rect,
-                             int x,
-                             int y,
-                             int width,
-                             int height)
+cogl_damage_rectangle_union (const CoglDamageRectangle *a,
+                             const CoglDamageRectangle *b,
+                             CoglDamageRectangle *result)
 {
-  /* If the damage region is empty then we'll just copy the new
-     rectangle directly */
-  if (damage_rect->x1 == damage_rect->x2 ||
-      damage_rect->y1 == damage_rect->y2)
+  result->x1 = MIN (a->x1, b->x1);
+  result->y1 = MIN (a->y1, b->y1);
+  result->x2 = MAX (a->x2, b->x2);
+  result->y2 = MAX (a->y2, b->y2);
+}
+
+static void
+cogl_damage_region_remove_rectangle (CoglDamageRegion *region,
+                                     int index)
+{
+  /* The order of the rectangles doesn't matter so we can just move
+     the last one into the gap */
+  region->rects[index] = region->rects[--region->n_rects];
+}
+
+static void
+cogl_damage_region_add_rectangle (CoglDamageRegion *region,
+                                  const CoglDamageRectangle *new_rect)
+{
+  CoglDamageRectangle rect = *new_rect;
+  int i = 0;
+
+  /* Merge the new rectangle with any existing rectangle that it
+     contains, is contained by or is close enough to that fetching
+     the gap in between is cheaper than doing a separate update.
+     Growing the rectangle can bring it close to one that we've
+     already skipped so we restart the search after each merge */
+  while (i < region->n_rects)
     {
-      damage_rect->x1 = x;
-      damage_rect->y1 = y;
-      damage_rect->x2 = x + width;
-      damage_rect->y2 = y + height;
+      CoglDamageRectangle merged;
+      unsigned int separate_area;
+
+      cogl_damage_rectangle_union (&region->rects[i], &rect, &merged);
+      separate_area = (cogl_damage_rectangle_get_area (&region->rects[i]) +
+                       cogl_damage_rectangle_get_area (&rect));
+
+      if (cogl_damage_rectangle_get_area (&merged) <=
+          separate_area + COGL_DAMAGE_MERGE_THRESHOLD)
+        {
+          rect = merged;
+          cogl_damage_region_remove_rectangle (region, i);
+          i = 0;
+        }
+      else
+        i++;
     }
-  else
+
+  if (region->n_rects >= COGL_TEXTURE_PIXMAP_X11_MAX_DAMAGE_RECTS)
     {
-      if (damage_rect->x1 > x)
-        damage_rect->x1 = x;
-      if (damage_rect->y1 > y)
-        damage_rect->y1 = y;
-      if (damage_rect->x2 < x + width)
-        damage_rect->x2 = x + width;
-      if (damage_rect->y2 < y + height)
-        damage_rect->y2 = y + height;
+      unsigned int best_growth = 0;
+      int best_rect = -1;
+
+      /* There's no more room so we'll merge the new rectangle into
+         whichever existing rectangle grows the least */
+      for (i = 0; i < region->n_rects; i++)
+        {
+          CoglDamageRectangle merged;
+          unsigned int growth;
+
+          cogl_damage_rectangle_union (&region->rects[i], &rect, &merged);
+          growth = (cogl_damage_rectangle_get_area (&merged) -
+                    cogl_damage_rectangle_get_area (&region->rects[i]));
+
+          if (best_rect == -1 || growth < best_growth)
+            {
+              best_growth = growth;
+              best_rect = i;
+            }
+        }
+
+      cogl_damage_rectangle_union (&region->rects[best_rect], &rect, &rect);
+      cogl_damage_region_remove_rectangle (region, best_rect);
+
+      /* The grown rectangle may now overlap other rectangles so it
+         needs to go through the merging again. There is now a free
+         slot so this won't recurse any further */
+      cogl_damage_region_add_rectangle (region, &rect);
     }
+  else
+    region->rects[region->n_rects++] = rect;
+}
+
+static void
+cogl_damage_region_add (CoglDamageRegion *region,
+                        int x,
+                        int y,
+                        int width,
+                        int height)
+{
+  CoglDamageRectangle rect;
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  rect.x1 = x;
+  rect.y1 = y;
+  rect.x2 = x + width;
+  rect.y2 = y + height;
+
+  cogl_damage_region_add_rectangle (region, &rect);
+}
+
+static void
+cogl_damage_region_clear (CoglDamageRegion *region)
+{
+  region->n_rects = 0;
+}
+
+static CoglBool
+cogl_damage_region_is_whole (const CoglDamageRegion *region,
+                             unsigned int width,
+                             unsigned int height)
+{
+  /* Any rectangle that is added after the whole texture is damaged
+     will get merged into it so there can only be one rectangle */
+  return (region->n_rects == 1 &&
+          region->rects[0].x1 == 0 && region->rects[0].y1 == 0 &&
+          region->rects[0].x2 == width && region->rects[0].y2 == height);
 }
 
 static CoglBool
-cogl_damage_rectangle_is_whole (const CoglDamageRectangle *damage_rect,
-                                unsigned int width,
-                                unsigned int height)
+cogl_damage_region_covers (const CoglDamageRegion *region,
+                           int x,
+                           int y,
+                           int width,
+                           int height)
+{
+  int i;
+
+  for (i = 0; i < region->n_rects; i++)
+    if (region->rects[i].x1 <= x && region->rects[i].y1 <= y &&
+        region->rects[i].x2 >= x + width && region->rects[i].y2 >= y + height)
+      return TRUE;
+
+  return FALSE;
+}
+
+UNIT_TEST (check_damage_region_merging,
+           0 /* no requirements */,
+           0 /* no failure cases */)
 {
-  return (damage_rect->x1 == 0 && damage_rect->y1 == 0
-          && damage_rect->x2 == width && damage_rect->y2 == height);
+  CoglDamageRegion region;
+  int i;
+
+  cogl_damage_region_clear (&region);
+
+  /* Two small rectangles in opposite corners shouldn't be merged */
+  cogl_damage_region_add (&region, 0, 0, 16, 16);
+  cogl_damage_region_add (&region, 3824, 2144, 16, 16);
+  g_assert_cmpint (region.n_rects, ==, 2);
+
+  /* An adjacent rectangle should get merged */
+  cogl_damage_region_add (&region, 16, 0, 16, 16);
+  g_assert_cmpint (region.n_rects, ==, 2);
+  g_assert (cogl_damage_region_covers (&region, 0, 0, 32, 16));
+
+  /* Empty rectangles are ignored */
+  cogl_damage_region_add (&region, 100, 100, 0, 16);
+  g_assert_cmpint (region.n_rects, ==, 2);
+
+  /* Damaging everything should leave a single rectangle */
+  cogl_damage_region_add (&region, 0, 0, 3840, 2160);
+  g_assert (cogl_damage_region_is_whole (&region, 3840, 2160));
+  cogl_damage_region_add (&region, 1000, 1000, 10, 10);
+  g_assert (cogl_damage_region_is_whole (&region, 3840, 2160));
+
+  /* Running out of space shouldn't lose any damage */
+  cogl_damage_region_clear (&region);
+  for (i = 0; i < 32; i++)
+    cogl_damage_region_add (&region, i * 120, (i & 1) * 2000, 8, 8);
+  g_assert_cmpint (region.n_rects, <=,
+                   COGL_TEXTURE_PIXMAP_X11_MAX_DAMAGE_RECTS);
+  for (i = 0; i < 32; i++)
+    g_assert (cogl_damage_region_covers (&region,
+                                         i * 120, (i & 1) * 2000, 8, 8));
 }
 
 static const CoglWinsysVtable *
@@ -175,9 +332,9 @@ process_damage_event (CoglTexturePixmapX11 *tex_pixmap,
   /* If the damage already covers the whole rectangle then we don't
      need to request the bounding box of the region because we're
      going to update the whole texture anyway. */
-  if (cogl_damage_rectangle_is_whole (&tex_pixmap->damage_rect,
-                                      tex->width,
-                                      tex->height))
+  if (cogl_damage_region_is_whole (&tex_pixmap->damage_region,
+                                   tex->width,
+                                   tex->height))
     {
       if (handle_mode != DO_NOTHING)
         XDamageSubtract (display, tex_pixmap->damage, None, None);
@@ -188,9 +345,10 @@ process_damage_event (CoglTexturePixmapX11 *tex_pixmap,
       int r_count;
       XRectangle r_bounds;
       XRectangle *r_damage;
+      int i;
 
       /* We need to extract the damage region so we can get the
-         bounding box */
+         rectangles that were changed */
 
       parts = XFixesCreateRegion (display, 0, 0);
       XDamageSubtract (display, tex_pixmap->damage, None, parts);
@@ -198,13 +356,22 @@ process_damage_event (CoglTexturePixmapX11 *tex_pixmap,
                                              parts,
                                              &r_count,
                                              &r_bounds);
-      cogl_damage_rectangle_union (&tex_pixmap->damage_rect,
-                                   r_bounds.x,
-                                   r_bounds.y,
-                                   r_bounds.width,
-                                   r_bounds.height);
       if (r_damage)
-        XFree (r_damage);
+        {
+          for (i = 0; i < r_count; i++)
+            cogl_damage_region_add (&tex_pixmap->damage_region,
+                                    r_damage[i].x,
+                                    r_damage[i].y,
+                                    r_damage[i].width,
+                                    r_damage[i].height);
+          XFree (r_damage);
+        }
+      else
+        cogl_damage_region_add (&tex_pixmap->damage_region,
+                                r_bounds.x,
+                                r_bounds.y,
+                                r_bounds.width,
+                                r_bounds.height);
 
       XFixesDestroyRegion (display, parts);
     }
@@ -215,11 +382,11 @@ process_damage_event (CoglTexturePixmapX11 *tex_pixmap,
            don't care what the region actually was */
         XDamageSubtract (display, tex_pixmap->damage, None, None);
 
-      cogl_damage_rectangle_union (&tex_pixmap->damage_rect,
-                                   damage_event->area.x,
-                                   damage_event->area.y,
-                                   damage_event->area.width,
-                                   damage_event->area.height);
+      cogl_damage_region_add (&tex_pixmap->damage_region,
+                              damage_event->area.x,
+                              damage_event->area.y,
+                              damage_event->area.width,
+                              damage_event->area.height);
     }
 
   if (tex_pixmap->winsys)
@@ -365,10 +532,10 @@ _cogl_texture_pixmap_x11_new (CoglContext *ctxt,
     }
 
   /* Assume the entire pixmap is damaged to begin with */
-  tex_pixmap->damage_rect.x1 = 0;
-  tex_pixmap->damage_rect.x2 = pixmap_width;
-  tex_pixmap->damage_rect.y1 = 0;
-  tex_pixmap->damage_rect.y2 = pixmap_height;
+  cogl_damage_region_clear (&tex_pixmap->damage_region);
+  cogl_damage_region_add (&tex_pixmap->damage_region,
+                          0, 0,
+                          pixmap_width, pixmap_height);
 
   winsys = _cogl_texture_pixmap_x11_get_winsys (tex_pixmap);
   if (winsys->texture_pixmap_x11_create)
@@ -542,8 +709,8 @@ cogl_texture_pixmap_x11_update_area (CoglTexturePixmapX11 *tex_pixmap,
       winsys->texture_pixmap_x11_damage_notify (tex_pixmap);
     }
 
-  cogl_damage_rectangle_union (&tex_pixmap->damage_rect,
-                               x, y, width, height);
+  cogl_damage_region_add (&tex_pixmap->damage_region,
+                          x, y, width, height);
 }
 
 CoglBool
@@ -621,11 +788,12 @@ create_fallback_texture (CoglContext *ctx,
 }
 
 static void
-_cogl_texture_pixmap_x11_update_image_texture (CoglTexturePixmapX11 *tex_pixmap)
+_cogl_texture_pixmap_x11_update_image_rectangle (CoglTexturePixmapX11 *tex_pixmap,
+                                                 Display *display,
+                                                 const CoglDamageRectangle *rect,
+                                                 CoglBool already_fetched)
 {
-  CoglTexture *tex = COGL_TEXTURE (tex_pixmap);
-  Display *display;
-  Visual *visual;
+  Visual *visual = tex_pixmap->visual;
   CoglPixelFormat image_format;
   XImage *image;
   int src_x, src_y;
@@ -634,20 +802,99 @@ _cogl_texture_pixmap_x11_update_image_texture (CoglTexturePixmapX11 *tex_pixmap)
   int offset;
   CoglError *ignore = NULL;
 
+  x = rect->x1;
+  y = rect->y1;
+  width = rect->x2 - x;
+  height = rect->y2 - y;
+
+  if (tex_pixmap->shm_info.shmid != -1)
+    {
+      COGL_NOTE (TEXTURE_PIXMAP, "Updating %p using XShmGetImage",
+                 tex_pixmap);
+
+      /* Create a temporary image using the beginning of the
+         shared memory segment and the right size for the region
+         we want to update. We need to reallocate the XImage every
+         time because there is no XShmGetSubImage. */
+      image = XShmCreateImage (display,
+                               tex_pixmap->visual,
+                               tex_pixmap->depth,
+                               ZPixmap,
+                               NULL,
+                               &tex_pixmap->shm_info,
+                               width,
+                               height);
+      image->data = tex_pixmap->shm_info.shmaddr;
+      src_x = 0;
+      src_y = 0;
+
+      XShmGetImage (display, tex_pixmap->pixmap, image, x, y, AllPlanes);
+    }
+  else
+    {
+      image = tex_pixmap->image;
+      src_x = x;
+      src_y = y;
+
+      /* If the image was only just created then it already contains
+         the contents of the entire pixmap */
+      if (!already_fetched)
+        {
+          COGL_NOTE (TEXTURE_PIXMAP, "Updating %p using XGetSubImage",
+                     tex_pixmap);
+
+          XGetSubImage (display,
+                        tex_pixmap->pixmap,
+                        x, y, width, height,
+                        AllPlanes, ZPixmap,
+                        image,
+                        x, y);
+        }
+    }
+
+  image_format =
+    _cogl_util_pixel_format_from_masks (visual->red_mask,
+                                        visual->green_mask,
+                                        visual->blue_mask,
+                                        image->depth,
+                                        image->bits_per_pixel,
+                                        image->byte_order == LSBFirst);
+
+  bpp = _cogl_pixel_format_get_bytes_per_pixel (image_format);
+  offset = image->bytes_per_line * src_y + bpp * src_x;
+
+  cogl_texture_set_region (tex_pixmap->tex,
+                           width,
+                           height,
+                           image_format,
+                           image->bytes_per_line,
+                           ((const uint8_t *) image->data) + offset,
+                           x, y,
+                           0, /* level */
+                           &ignore);
+
+  /* If we have a shared memory segment then the XImage would be a
+     temporary one with no data allocated so we can just XFree it */
+  if (tex_pixmap->shm_info.shmid != -1)
+    XFree (image);
+}
+
+static void
+_cogl_texture_pixmap_x11_update_image_texture (CoglTexturePixmapX11 *tex_pixmap)
+{
+  CoglTexture *tex = COGL_TEXTURE (tex_pixmap);
+  Display *display;
+  CoglBool already_fetched = FALSE;
+  int i;
+
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
   display = cogl_xlib_renderer_get_display (ctx->display->renderer);
-  visual = tex_pixmap->visual;
 
   /* If the damage region is empty then there's nothing to do */
-  if (tex_pixmap->damage_rect.x2 == tex_pixmap->damage_rect.x1)
+  if (tex_pixmap->damage_region.n_rects == 0)
     return;
 
-  x = tex_pixmap->damage_rect.x1;
-  y = tex_pixmap->damage_rect.y1;
-  width = tex_pixmap->damage_rect.x2 - x;
-  height = tex_pixmap->damage_rect.y2 - y;
-
   /* We lazily create the texture the first time it is needed in case
      this texture can be entirely handled using the GLX texture
      instead */
@@ -688,77 +935,20 @@ _cogl_texture_pixmap_x11_update_image_texture (CoglTexturePixmapX11 *tex_pixmap)
                                          0, 0,
                                          tex->width, tex->height,
                                          AllPlanes, ZPixmap);
-          image = tex_pixmap->image;
-          src_x = x;
-          src_y = y;
+          already_fetched = TRUE;
         }
-      else
-        {
-          COGL_NOTE (TEXTURE_PIXMAP, "Updating %p using XShmGetImage",
-                     tex_pixmap);
-
-          /* Create a temporary image using the beginning of the
-             shared memory segment and the right size for the region
-             we want to update. We need to reallocate the XImage every
-             time because there is no XShmGetSubImage. */
-          image = XShmCreateImage (display,
-                                   tex_pixmap->visual,
-                                   tex_pixmap->depth,
-                                   ZPixmap,
-                                   NULL,
-                                   &tex_pixmap->shm_info,
-                                   width,
-                                   height);
-          image->data = tex_pixmap->shm_info.shmaddr;
-          src_x = 0;
-          src_y = 0;
-
-          XShmGetImage (display, tex_pixmap->pixmap, image, x, y, AllPlanes);
-        }
-    }
-  else
-    {
-      COGL_NOTE (TEXTURE_PIXMAP, "Updating %p using XGetSubImage", tex_pixmap);
-
-      image = tex_pixmap->image;
-      src_x = x;
-      src_y = y;
-
-      XGetSubImage (display,
-                    tex_pixmap->pixmap,
-                    x, y, width, height,
-                    AllPlanes, ZPixmap,
-                    image,
-                    x, y);
     }
 
-  image_format =
-    _cogl_util_pixel_format_from_masks (visual->red_mask,
-                                        visual->green_mask,
-                                        visual->blue_mask,
-                                        image->depth,
-                                        image->bits_per_pixel,
-                                        image->byte_order == LSBFirst);
-
-  bpp = _cogl_pixel_format_get_bytes_per_pixel (image_format);
-  offset = image->bytes_per_line * src_y + bpp * src_x;
-
-  cogl_texture_set_region (tex_pixmap->tex,
-                           width,
-                           height,
-                           image_format,
-                           image->bytes_per_line,
-                           ((const uint8_t *) image->data) + offset,
-                           x, y,
-                           0, /* level */
-                           &ignore);
-
-  /* If we have a shared memory segment then the XImage would be a
-     temporary one with no data allocated so we can just XFree it */
-  if (tex_pixmap->shm_info.shmid != -1)
-    XFree (image);
+  /* Each damaged rectangle is fetched and uploaded separately so
+     that only the pixels that actually changed are transferred */
+  for (i = 0; i < tex_pixmap->damage_region.n_rects; i++)
+    _cogl_texture_pixmap_x11_update_image_rectangle
+      (tex_pixmap,
+       display,
+       &tex_pixmap->damage_region.rects[i],
+       already_fetched);
 
-  memset (&tex_pixmap->damage_rect, 0, sizeof (CoglDamageRectangle));
+  cogl_damage_region_clear (&tex_pixmap->damage_region);
 }
 
 static void
@@ -1169,5 +1359,7 @@ cogl_texture_pixmap_x11_vtable =
     _cogl_texture_pixmap_x11_get_gl_format,
     _cogl_texture_pixmap_x11_get_type,
     NULL, /* is_foreign */
-    NULL /* set_auto_mipmap */
+    NULL, /* set_auto_mipmap */
+    NULL, /* get_gpu_bytes */
+    NULL /* discard_storage */
   };
@@ -54,6 +54,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 
 
 #ifndef EGL_KHR_create_context
@@ -917,41 +918,107 @@ _cogl_winsys_restore_context (CoglContext *ctx)
 }
 
 #if defined(EGL_KHR_fence_sync) || defined(EGL_KHR_reusable_sync)
+typedef struct _CoglFenceEGL
+{
+  EGLSyncKHR sync;
+  /* File descriptor exported from a native fence or -1 */
+  int fd;
+} CoglFenceEGL;
+
 static void *
 _cogl_winsys_fence_add (CoglContext *context)
 {
   CoglRendererEGL *renderer = context->display->renderer->winsys;
-  void *ret;
+  CoglFenceEGL *fence;
+  EGLSyncKHR sync = EGL_NO_SYNC_KHR;
 
-  if (renderer->pf_eglCreateSync)
-    ret = renderer->pf_eglCreateSync (renderer->edpy,
-                                      EGL_SYNC_FENCE_KHR,
-                                      NULL);
-  else
-    ret = NULL;
+  if (!renderer->pf_eglCreateSync)
+    return NULL;
 
-  return ret;
+#ifdef EGL_ANDROID_native_fence_sync
+  /* A native fence can be exported as a file descriptor so that the
+   * main loop can sleep until it is signaled instead of polling */
+  if (renderer->private_features & COGL_EGL_WINSYS_FEATURE_NATIVE_FENCE_SYNC)
+    {
+      static const EGLint attribs[] = {
+        EGL_SYNC_NATIVE_FENCE_FD_ANDROID, EGL_NO_NATIVE_FENCE_FD_ANDROID,
+        EGL_NONE
+      };
+
+      sync = renderer->pf_eglCreateSync (renderer->edpy,
+                                         EGL_SYNC_NATIVE_FENCE_ANDROID,
+                                         attribs);
+    }
+#endif
+
+  if (sync == EGL_NO_SYNC_KHR)
+    sync = renderer->pf_eglCreateSync (renderer->edpy,
+                                       EGL_SYNC_FENCE_KHR,
+                                       NULL);
+
+  if (sync == EGL_NO_SYNC_KHR)
+    return NULL;
+
+  fence = g_slice_new (CoglFenceEGL);
+  fence->sync = sync;
+  fence->fd = -1;
+
+  return fence;
 }
 
 static CoglBool
 _cogl_winsys_fence_is_complete (CoglContext *context, void *fence)
 {
   CoglRendererEGL *renderer = context->display->renderer->winsys;
+  CoglFenceEGL *egl_fence = fence;
   EGLint ret;
 
   ret = renderer->pf_eglClientWaitSync (renderer->edpy,
-                                        fence,
+                                        egl_fence->sync,
                                         EGL_SYNC_FLUSH_COMMANDS_BIT_KHR,
                                         0);
   return (ret == EGL_CONDITION_SATISFIED_KHR);
 }
 
+static int
+_cogl_winsys_fence_get_fd (CoglContext *context, void *fence)
+{
+#ifdef EGL_ANDROID_native_fence_sync
+  CoglRendererEGL *renderer = context->display->renderer->winsys;
+  CoglFenceEGL *egl_fence = fence;
+
+  if (egl_fence->fd == -1 &&
+      (renderer->private_features & COGL_EGL_WINSYS_FEATURE_NATIVE_FENCE_SYNC))
+    {
+      EGLint fd;
+
+      /* The native fence only gets a file descriptor once the
+       * commands preceding it have been flushed */
+      context->glFlush ();
+
+      fd = renderer->pf_eglDupNativeFenceFD (renderer->edpy, egl_fence->sync);
+      if (fd != EGL_NO_NATIVE_FENCE_FD_ANDROID)
+        egl_fence->fd = fd;
+    }
+
+  return egl_fence->fd;
+#else
+  return -1;
+#endif
+}
+
 static void
 _cogl_winsys_fence_destroy (CoglContext *context, void *fence)
 {
   CoglRendererEGL *renderer = context->display->renderer->winsys;
+  CoglFenceEGL *egl_fence = fence;
+
+  if (egl_fence->fd != -1)
+    close (egl_fence->fd);
+
+  renderer->pf_eglDestroySync (renderer->edpy, egl_fence->sync);
 
-  renderer->pf_eglDestroySync (renderer->edpy, fence);
+  g_slice_free (CoglFenceEGL, egl_fence);
 }
 #endif
 
@@ -993,6 +1060,7 @@ static CoglWinsysVtable _cogl_winsys_vtable =
 #if defined(EGL_KHR_fence_sync) || defined(EGL_KHR_reusable_sync)
     .fence_add = _cogl_winsys_fence_add,
     .fence_is_complete = _cogl_winsys_fence_is_complete,
+    .fence_get_fd = _cogl_winsys_fence_get_fd,
     .fence_destroy = _cogl_winsys_fence_destroy,
 #endif
   };
@@ -200,6 +200,12 @@ typedef struct _CoglWinsysVtable
   CoglBool
   (*fence_is_complete) (CoglContext *ctx, void *fence);
 
+  /* Optionally returns a file descriptor that becomes readable once
+   * the fence is signaled or -1. The winsys keeps ownership of the fd
+   * and closes it when the fence is destroyed. */
+  int
+  (*fence_get_fd) (CoglContext *ctx, void *fence);
+
   void
   (*fence_destroy) (CoglContext *ctx, void *fence);
 
@@ -1,5 +1,6 @@
 #include <config.h>
 
+#include <stdio.h>
 #include <stdlib.h>
 
 #include "test-unit.h"
@@ -90,6 +91,32 @@ check_flags (TestFlags flags,
       return FALSE;
     }
 
+  if (flags & TEST_REQUIREMENT_INSTANCED_DRAWING &&
+      !cogl_has_feature (test_ctx, COGL_FEATURE_ID_INSTANCED_DRAWING))
+    {
+      return FALSE;
+    }
+
+  if (flags & TEST_REQUIREMENT_TEXTURE_TILED &&
+      !cogl_has_feature (test_ctx, COGL_FEATURE_ID_TEXTURE_TILED))
+    {
+      return FALSE;
+    }
+
+  /* The nop and software drivers don't have any GL state to check */
+  if (flags & TEST_REQUIREMENT_GPU &&
+      (cogl_renderer_get_driver (renderer) == COGL_DRIVER_NOP ||
+       cogl_renderer_get_driver (renderer) == COGL_DRIVER_SW))
+    {
+      return FALSE;
+    }
+
+  if (flags & TEST_REQUIREMENT_DEPTH_BUFFER &&
+      cogl_framebuffer_get_depth_bits (test_fb) == 0)
+    {
+      return FALSE;
+    }
+
   if (flags & TEST_KNOWN_FAILURE)
     {
       return FALSE;
@@ -171,9 +198,6 @@ test_utils_init (TestFlags requirement_flags,
   display = cogl_context_get_display (test_ctx);
   renderer = cogl_display_get_renderer (display);
 
-  missing_requirement = !check_flags (requirement_flags, renderer);
-  known_failure = !check_flags (known_failure_flags, renderer);
-
   if (is_boolean_env_set ("COGL_TEST_ONSCREEN"))
     {
       onscreen = cogl_onscreen_new (test_ctx, 640, 480);
@@ -194,6 +218,10 @@ test_utils_init (TestFlags requirement_flags,
   if (onscreen)
     cogl_onscreen_show (onscreen);
 
+  /* This needs the allocated framebuffer to check the depth bits */
+  missing_requirement = !check_flags (requirement_flags, renderer);
+  known_failure = !check_flags (known_failure_flags, renderer);
+
   cogl_framebuffer_clear4f (test_fb,
                             COGL_BUFFER_BIT_COLOR |
                             COGL_BUFFER_BIT_DEPTH |
@@ -204,6 +232,10 @@ test_utils_init (TestFlags requirement_flags,
     g_print ("WARNING: Missing required feature[s] for this test\n");
   else if (known_failure)
     g_print ("WARNING: Test is known to fail\n");
+
+  /* Make sure the warning reaches the log that run-tests.sh checks
+   * even if the test aborts before stdout would be flushed */
+  fflush (stdout);
 }
 
 void
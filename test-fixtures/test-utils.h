@@ -42,7 +42,11 @@ typedef enum _TestFlags
   TEST_REQUIREMENT_GLSL = 1<<9,
   TEST_REQUIREMENT_OFFSCREEN = 1<<10,
   TEST_REQUIREMENT_FENCE = 1<<11,
-  TEST_REQUIREMENT_PER_VERTEX_POINT_SIZE = 1<<12
+  TEST_REQUIREMENT_PER_VERTEX_POINT_SIZE = 1<<12,
+  TEST_REQUIREMENT_INSTANCED_DRAWING = 1<<13,
+  TEST_REQUIREMENT_TEXTURE_TILED = 1<<14,
+  TEST_REQUIREMENT_GPU = 1<<15,
+  TEST_REQUIREMENT_DEPTH_BUFFER = 1<<16
 } TestFlags;
 
  /**
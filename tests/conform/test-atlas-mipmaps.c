@@ -0,0 +1,162 @@
+#include <cogl/cogl.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test-utils.h"
+
+#define IMAGE_SIZE 16
+
+typedef enum
+{
+  TEST_IMAGE_RED,
+  TEST_IMAGE_STRIPES
+} TestImage;
+
+typedef struct
+{
+  CoglTexture *textures[2];
+} TestState;
+
+static char *
+write_image (TestImage image)
+{
+  char *basename = g_strdup_printf ("cogl-test-atlas-mipmaps-%i.pam", image);
+  char *filename = g_build_filename (g_get_tmp_dir (), basename, NULL);
+  FILE *file;
+  int x, y;
+
+  file = fopen (filename, "wb");
+  g_assert (file != NULL);
+
+  fprintf (file,
+           "P7\nWIDTH %i\nHEIGHT %i\nDEPTH 4\nMAXVAL 255\n"
+           "TUPLTYPE RGB_ALPHA\nENDHDR\n",
+           IMAGE_SIZE, IMAGE_SIZE);
+
+  for (y = 0; y < IMAGE_SIZE; y++)
+    for (x = 0; x < IMAGE_SIZE; x++)
+      {
+        if (image == TEST_IMAGE_RED)
+          fwrite ("\xff\x00\x00\xff", 1, 4, file);
+        /* Alternate black and white columns so that any 2×2 box
+           averages to grey */
+        else if ((x & 1))
+          fwrite ("\xff\xff\xff\xff", 1, 4, file);
+        else
+          fwrite ("\x00\x00\x00\xff", 1, 4, file);
+      }
+
+  fclose (file);
+  g_free (basename);
+
+  return filename;
+}
+
+static void
+loaded_cb (CoglTexture *texture,
+           const char *filename,
+           const CoglError *error,
+           void *user_data)
+{
+  TestState *state = user_data;
+  TestImage image;
+
+  g_assert (error == NULL);
+  g_assert (texture != NULL);
+
+  /* Both images will share a mipmapped atlas if the driver can limit
+     the number of levels of a texture. Otherwise they each get a
+     texture of their own and the results should be the same */
+  image = strstr (filename, "mipmaps-0") ? TEST_IMAGE_RED : TEST_IMAGE_STRIPES;
+
+  state->textures[image] = cogl_object_ref (texture);
+}
+
+static void
+draw_minified (CoglTexture *texture,
+               int x,
+               int y,
+               int size)
+{
+  CoglPipeline *pipeline = cogl_pipeline_new (test_ctx);
+
+  cogl_pipeline_set_layer_texture (pipeline, 0, texture);
+  cogl_pipeline_set_layer_filters (pipeline,
+                                   0,
+                                   COGL_PIPELINE_FILTER_NEAREST_MIPMAP_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+
+  cogl_framebuffer_draw_rectangle (test_fb,
+                                   pipeline,
+                                   x, y,
+                                   x + size, y + size);
+
+  cogl_object_unref (pipeline);
+}
+
+void
+test_atlas_mipmaps (void)
+{
+  CoglTextureBatch *batch = cogl_texture_batch_new (test_ctx);
+  char *filenames[2];
+  TestState state;
+  int size, x, i;
+
+  for (i = 0; i < 2; i++)
+    {
+      filenames[i] = write_image (i);
+      cogl_texture_batch_add_file (batch,
+                                   filenames[i],
+                                   COGL_TEXTURE_BATCH_FLAG_ATLAS |
+                                   COGL_TEXTURE_BATCH_FLAG_MIPMAP,
+                                   loaded_cb,
+                                   &state);
+    }
+
+  cogl_texture_batch_load (batch);
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 1, 1);
+
+  /* Draw each image at 8, 4, 2 and 1 pixels so that levels 1 to 4
+     are sampled */
+  for (size = IMAGE_SIZE / 2, x = 0; size >= 1; x += size, size /= 2)
+    {
+      draw_minified (state.textures[TEST_IMAGE_RED], x, 0, size);
+      draw_minified (state.textures[TEST_IMAGE_STRIPES], x, IMAGE_SIZE, size);
+    }
+
+  for (size = IMAGE_SIZE / 2, x = 0; size >= 1; x += size, size /= 2)
+    {
+      /* The red image is right next to the stripes in the atlas so
+         this will fail if the levels aren't clamped to the edges of
+         each image */
+      test_utils_check_region (test_fb, x, 0, size, size, 0xff0000ff);
+
+      /* The inside of the stripes should be the box-filtered grey.
+         The edge texels of each level are mixed with the repeated
+         border so they are skipped */
+      if (size > 2)
+        test_utils_check_region (test_fb,
+                                 x + 1, IMAGE_SIZE + 1,
+                                 size - 2, size - 2,
+                                 0x808080ff);
+    }
+
+  for (i = 0; i < 2; i++)
+    {
+      cogl_object_unref (state.textures[i]);
+      remove (filenames[i]);
+      g_free (filenames[i]);
+    }
+
+  cogl_object_unref (batch);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
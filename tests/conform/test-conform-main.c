@@ -59,8 +59,9 @@ main (int argc, char **argv)
 #ifdef COGL_HAS_COGL_PATH_SUPPORT
   ADD_TEST (test_path, 0, 0);
   ADD_TEST (test_path_clip, 0, 0);
+  ADD_TEST (test_path_stroke, 0, 0);
 #endif
-  ADD_TEST (test_depth_test, 0, 0);
+  ADD_TEST (test_depth_test, TEST_REQUIREMENT_DEPTH_BUFFER, 0);
   ADD_TEST (test_color_mask, 0, 0);
   ADD_TEST (test_backface_culling, 0, 0);
   ADD_TEST (test_layer_remove, 0, 0);
@@ -76,6 +77,8 @@ main (int argc, char **argv)
   ADD_TEST (test_pixel_buffer_sub_region, 0, 0);
   UNPORTED_TEST (test_texture_rectangle);
   ADD_TEST (test_texture_3d, TEST_REQUIREMENT_TEXTURE_3D, 0);
+  ADD_TEST (test_texture_tiled, TEST_REQUIREMENT_TEXTURE_TILED, 0);
+  ADD_TEST (test_virtual_texture, 0, 0);
   ADD_TEST (test_wrap_modes, 0, 0);
   UNPORTED_TEST (test_texture_pixmap_x11);
   ADD_TEST (test_texture_get_set_data, 0, 0);
@@ -83,6 +86,7 @@ main (int argc, char **argv)
    * the maximum texture level. */
   ADD_TEST (test_texture_mipmap_get_set, TEST_REQUIREMENT_GL, 0);
   ADD_TEST (test_atlas_migration, 0, 0);
+  ADD_TEST (test_atlas_mipmaps, TEST_REQUIREMENT_GPU, 0);
   ADD_TEST (test_read_texture_formats, 0, 0);
   ADD_TEST (test_write_texture_formats, 0, 0);
   ADD_TEST (test_alpha_textures, 0, 0);
@@ -100,6 +104,7 @@ main (int argc, char **argv)
   ADD_TEST (test_pipeline_uniforms, TEST_REQUIREMENT_GLSL, 0);
   ADD_TEST (test_snippets, TEST_REQUIREMENT_GLSL, 0);
   ADD_TEST (test_custom_attributes, TEST_REQUIREMENT_GLSL, 0);
+  ADD_TEST (test_texture_shader_repeat, TEST_REQUIREMENT_GLSL, 0);
 
   ADD_TEST (test_offscreen, 0, 0);
   ADD_TEST (test_framebuffer_get_bits,
@@ -130,11 +135,20 @@ main (int argc, char **argv)
   ADD_TEST (test_map_buffer_range, TEST_REQUIREMENT_MAP_WRITE, 0);
 
   ADD_TEST (test_primitive_and_journal, 0, 0);
+  ADD_TEST (test_primitive_clip, 0, 0);
+  ADD_TEST (test_shader_clip, 0, 0);
+  ADD_TEST (test_primitive_batch, 0, 0);
+  ADD_TEST (test_primitive_instanced,
+            TEST_REQUIREMENT_INSTANCED_DRAWING, 0);
+  ADD_TEST (test_static_batch, 0, 0);
 
   ADD_TEST (test_copy_replace_texture, 0, 0);
 
   ADD_TEST (test_pipeline_cache_unrefs_texture, 0, 0);
   ADD_TEST (test_pipeline_shader_state, TEST_REQUIREMENT_GLSL, 0);
+  ADD_TEST (test_glsl_framebuffer_switch,
+            TEST_REQUIREMENT_GLSL | TEST_REQUIREMENT_OFFSCREEN,
+            0);
 
   UNPORTED_TEST (test_viewport);
 
@@ -153,6 +167,10 @@ main (int argc, char **argv)
 
   ADD_TEST (test_texture_rg, TEST_REQUIREMENT_TEXTURE_RG, 0);
 
+  ADD_TEST (test_texture_batch, 0, 0);
+
+  ADD_TEST (test_texture_residency, 0, 0);
+
   g_printerr ("Unknown test name \"%s\"\n", argv[1]);
 
   return 1;
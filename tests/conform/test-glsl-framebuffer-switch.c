@@ -0,0 +1,127 @@
+#include <cogl/cogl.h>
+
+#include "test-utils.h"
+
+/* This draws with the same GLSL pipeline to test_fb and to an
+ * offscreen framebuffer in turn, moving the modelview between each
+ * draw. The builtin matrices have to be reuploaded for every draw
+ * and the offscreen draws need the flipped projection. test_fb is an
+ * onscreen framebuffer when the test is run with COGL_TEST_ONSCREEN
+ * set. */
+
+#define SQUARE_SIZE 16
+#define N_SQUARES 4
+#define OFFSCREEN_WIDTH (SQUARE_SIZE * N_SQUARES)
+#define OFFSCREEN_HEIGHT (SQUARE_SIZE * 2)
+
+static void
+set_orthographic (CoglFramebuffer *framebuffer)
+{
+  cogl_framebuffer_orthographic (framebuffer,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (framebuffer),
+                                 cogl_framebuffer_get_height (framebuffer),
+                                 -1,
+                                 100);
+}
+
+static void
+draw_square (CoglFramebuffer *framebuffer,
+             CoglPipeline *pipeline,
+             CoglPrimitive *prim,
+             int square_num)
+{
+  /* The primitive isn't drawn through the journal so the modelview
+     isn't baked into the vertices */
+  cogl_framebuffer_push_matrix (framebuffer);
+  cogl_framebuffer_translate (framebuffer,
+                              square_num * SQUARE_SIZE, 0.0f, 0.0f);
+  cogl_primitive_draw (prim, framebuffer, pipeline);
+  cogl_framebuffer_pop_matrix (framebuffer);
+}
+
+static void
+check_squares (CoglFramebuffer *framebuffer)
+{
+  int i;
+
+  for (i = 0; i < N_SQUARES; i++)
+    {
+      /* The squares should be in the top row. If the projection had
+         the wrong flip they would end up in the bottom row */
+      test_utils_check_pixel (framebuffer,
+                              i * SQUARE_SIZE + SQUARE_SIZE / 2,
+                              SQUARE_SIZE / 2,
+                              0xff0000ff);
+      test_utils_check_pixel (framebuffer,
+                              i * SQUARE_SIZE + SQUARE_SIZE / 2,
+                              SQUARE_SIZE + SQUARE_SIZE / 2,
+                              0x000000ff);
+    }
+}
+
+void
+test_glsl_framebuffer_switch (void)
+{
+  static const CoglVertexP2 verts[] =
+    {
+      { 0, 0 },
+      { 0, SQUARE_SIZE },
+      { SQUARE_SIZE, 0 },
+      { SQUARE_SIZE, SQUARE_SIZE }
+    };
+  CoglTexture2D *tex;
+  CoglFramebuffer *offscreen;
+  CoglPipeline *pipeline;
+  CoglSnippet *snippet;
+  CoglPrimitive *prim;
+  int i;
+
+  tex = cogl_texture_2d_new_with_size (test_ctx,
+                                       OFFSCREEN_WIDTH,
+                                       OFFSCREEN_HEIGHT);
+  offscreen = cogl_offscreen_new_with_texture (tex);
+
+  set_orthographic (test_fb);
+  set_orthographic (offscreen);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+  cogl_framebuffer_clear4f (offscreen, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 255, 0, 0, 255);
+
+  /* Make sure the pipeline uses the builtin matrices from GLSL */
+  snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_VERTEX,
+                              NULL, /* declarations */
+                              NULL /* post */);
+  cogl_snippet_set_replace (snippet,
+                            "cogl_position_out = "
+                            "cogl_modelview_projection_matrix * "
+                            "cogl_position_in;\n"
+                            "cogl_color_out = cogl_color_in;\n");
+  cogl_pipeline_add_snippet (pipeline, snippet);
+  cogl_object_unref (snippet);
+
+  prim = cogl_primitive_new_p2 (test_ctx,
+                                COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                G_N_ELEMENTS (verts),
+                                verts);
+
+  for (i = 0; i < N_SQUARES; i++)
+    {
+      draw_square (test_fb, pipeline, prim, i);
+      draw_square (offscreen, pipeline, prim, i);
+    }
+
+  check_squares (test_fb);
+  check_squares (offscreen);
+
+  cogl_object_unref (prim);
+  cogl_object_unref (pipeline);
+  cogl_object_unref (offscreen);
+  cogl_object_unref (tex);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
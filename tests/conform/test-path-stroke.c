@@ -0,0 +1,98 @@
+#include <cogl/cogl.h>
+#include <cogl-path/cogl-path.h>
+
+#include <string.h>
+
+#include "test-utils.h"
+
+/* Each case draws an L-shaped open line going right and then down.
+ * The corner is at (80, 20) and the line is 10 units wide */
+static void
+stroke_corner (CoglPipeline *pipeline,
+               float x_offset,
+               CoglPathLineJoin line_join,
+               CoglPathLineCap line_cap)
+{
+  CoglPath *path = cogl_path_new (test_ctx);
+
+  cogl_path_set_stroke_width (path, 10);
+  cogl_path_set_line_join (path, line_join);
+  cogl_path_set_line_cap (path, line_cap);
+
+  cogl_path_move_to (path, x_offset + 20, 20);
+  cogl_path_line_to (path, x_offset + 80, 20);
+  cogl_path_line_to (path, x_offset + 80, 80);
+  cogl_path_stroke (path, test_fb, pipeline);
+
+  cogl_object_unref (path);
+}
+
+static void
+check_corner (float x_offset,
+              uint32_t start_color,
+              uint32_t corner_color)
+{
+  /* Middle of the horizontal line and just outside of it */
+  test_utils_check_pixel (test_fb, x_offset + 50, 20, 0x0000ffff);
+  test_utils_check_pixel (test_fb, x_offset + 50, 27, 0x000000ff);
+  /* The cap at the start of the line */
+  test_utils_check_pixel (test_fb, x_offset + 17, 20, start_color);
+  test_utils_check_pixel (test_fb, x_offset + 12, 20, 0x000000ff);
+  /* The outside of the corner */
+  test_utils_check_pixel (test_fb, x_offset + 84, 15, corner_color);
+  test_utils_check_pixel (test_fb, x_offset + 82, 18, 0x0000ffff);
+  /* The middle of the vertical line */
+  test_utils_check_pixel (test_fb, x_offset + 80, 50, 0x0000ffff);
+}
+
+void
+test_path_stroke (void)
+{
+  CoglPipeline *pipeline;
+  CoglPath *path;
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 0, 0, 255, 255);
+
+  stroke_corner (pipeline, 0,
+                 COGL_PATH_LINE_JOIN_MITER, COGL_PATH_LINE_CAP_BUTT);
+  stroke_corner (pipeline, 100,
+                 COGL_PATH_LINE_JOIN_BEVEL, COGL_PATH_LINE_CAP_SQUARE);
+  stroke_corner (pipeline, 200,
+                 COGL_PATH_LINE_JOIN_ROUND, COGL_PATH_LINE_CAP_ROUND);
+
+  /* A closed rectangle should have its first corner joined */
+  path = cogl_path_new (test_ctx);
+  cogl_path_set_stroke_width (path, 4);
+  cogl_path_rectangle (path, 320, 20, 380, 80);
+  cogl_path_stroke (path, test_fb, pipeline);
+  cogl_object_unref (path);
+
+  check_corner (0, 0x000000ff, 0x0000ffff);
+  check_corner (100, 0x0000ffff, 0x000000ff);
+  check_corner (200, 0x0000ffff, 0x000000ff);
+
+  /* The round cap */
+  test_utils_check_pixel (test_fb, 217, 17, 0x0000ffff);
+  test_utils_check_pixel (test_fb, 215, 15, 0x000000ff);
+
+  test_utils_check_pixel (test_fb, 350, 20, 0x0000ffff);
+  test_utils_check_pixel (test_fb, 350, 50, 0x000000ff);
+  test_utils_check_pixel (test_fb, 318, 18, 0x0000ffff);
+  test_utils_check_pixel (test_fb, 381, 81, 0x0000ffff);
+  test_utils_check_pixel (test_fb, 323, 23, 0x000000ff);
+
+  cogl_object_unref (pipeline);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
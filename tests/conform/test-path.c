@@ -2,6 +2,7 @@
 #include <cogl-path/cogl-path.h>
 
 #include <string.h>
+#include <math.h>
 
 #include "test-utils.h"
 
@@ -12,12 +13,18 @@
 
 typedef struct _TestState
 {
-  int dummy;
+  CoglPathFillStrategy fill_strategy;
 } TestState;
 
 static void
-draw_path_at (CoglPath *path, CoglPipeline *pipeline, int x, int y)
+draw_path_at (TestState *state,
+              CoglPath *path,
+              CoglPipeline *pipeline,
+              int x,
+              int y)
 {
+  cogl_path_set_fill_strategy (path, state->fill_strategy);
+
   cogl_framebuffer_push_matrix (test_fb);
   cogl_framebuffer_translate (test_fb, x * BLOCK_SIZE, y * BLOCK_SIZE, 0.0f);
 
@@ -64,11 +71,29 @@ check_block (int block_x, int block_y, int block_mask)
       }
 }
 
+static void
+add_circle (CoglPath *path)
+{
+  /* Distance of the control points from the ends of each curve to
+     approximate a quarter of a circle */
+  float k = BLOCK_SIZE / 2 * 0.5523f;
+  float c = BLOCK_SIZE / 2;
+
+  cogl_path_move_to (path, c, 0);
+  cogl_path_curve_to (path, c + k, 0, BLOCK_SIZE, c - k, BLOCK_SIZE, c);
+  cogl_path_curve_to (path, BLOCK_SIZE, c + k, c + k, BLOCK_SIZE,
+                      c, BLOCK_SIZE);
+  cogl_path_curve_to (path, c - k, BLOCK_SIZE, 0, c + k, 0, c);
+  cogl_path_curve_to (path, 0, c - k, c - k, 0, c, 0);
+  cogl_path_close (path);
+}
+
 static void
 paint (TestState *state)
 {
   CoglPath *path_a, *path_b, *path_c;
   CoglPipeline *white = cogl_pipeline_new (test_ctx);
+  int i;
 
   cogl_pipeline_set_color4f (white, 1, 1, 1, 1);
 
@@ -81,19 +106,19 @@ paint (TestState *state)
   cogl_path_rectangle (path_a,
                        BLOCK_SIZE / 2, BLOCK_SIZE / 2,
                        BLOCK_SIZE * 3 / 4, BLOCK_SIZE);
-  draw_path_at (path_a, white, 0, 0);
+  draw_path_at (state, path_a, white, 0, 0);
 
   /* Create another path filling the whole block */
   path_b = cogl_path_new (test_ctx);
   cogl_path_rectangle (path_b, 0, 0, BLOCK_SIZE, BLOCK_SIZE);
-  draw_path_at (path_b, white, 1, 0);
+  draw_path_at (state, path_b, white, 1, 0);
 
   /* Draw the first path again */
-  draw_path_at (path_a, white, 2, 0);
+  draw_path_at (state, path_a, white, 2, 0);
 
   /* Draw a copy of path a */
   path_c = cogl_path_copy (path_a);
-  draw_path_at (path_c, white, 3, 0);
+  draw_path_at (state, path_c, white, 3, 0);
 
   /* Add another rectangle to path a. We'll use line_to's instead of
      cogl_rectangle so that we don't create another sub-path because
@@ -102,10 +127,10 @@ paint (TestState *state)
   cogl_path_line_to (path_a, 0, 0);
   cogl_path_line_to (path_a, BLOCK_SIZE / 2, 0);
   cogl_path_line_to (path_a, BLOCK_SIZE / 2, BLOCK_SIZE / 2);
-  draw_path_at (path_a, white, 4, 0);
+  draw_path_at (state, path_a, white, 4, 0);
 
   /* Draw the copy again. It should not have changed */
-  draw_path_at (path_c, white, 5, 0);
+  draw_path_at (state, path_c, white, 5, 0);
 
   /* Add another rectangle to path c. It will be added in two halves,
      one as an extension of the previous path and the other as a new
@@ -116,10 +141,10 @@ paint (TestState *state)
   cogl_path_line_to (path_c, BLOCK_SIZE / 2, BLOCK_SIZE / 2);
   cogl_path_rectangle (path_c,
                        BLOCK_SIZE * 3 / 4, 0, BLOCK_SIZE, BLOCK_SIZE / 2);
-  draw_path_at (path_c, white, 6, 0);
+  draw_path_at (state, path_c, white, 6, 0);
 
   /* Draw the original path again. It should not have changed */
-  draw_path_at (path_a, white, 7, 0);
+  draw_path_at (state, path_a, white, 7, 0);
 
   cogl_object_unref (path_a);
   cogl_object_unref (path_b);
@@ -133,7 +158,7 @@ paint (TestState *state)
   cogl_path_line_to (path_a, BLOCK_SIZE / 2, BLOCK_SIZE / 2);
   cogl_path_line_to (path_a, BLOCK_SIZE / 2, 0);
   cogl_path_close (path_a);
-  draw_path_at (path_a, white, 8, 0);
+  draw_path_at (state, path_a, white, 8, 0);
   cogl_object_unref (path_a);
 
   /* Draw two sub paths. Where the paths intersect it should be
@@ -142,7 +167,7 @@ paint (TestState *state)
   cogl_path_rectangle (path_a, 0, 0, BLOCK_SIZE, BLOCK_SIZE);
   cogl_path_rectangle (path_a,
                        BLOCK_SIZE / 2, BLOCK_SIZE / 2, BLOCK_SIZE, BLOCK_SIZE);
-  draw_path_at (path_a, white, 9, 0);
+  draw_path_at (state, path_a, white, 9, 0);
   cogl_object_unref (path_a);
 
   /* Draw a clockwise outer path */
@@ -165,13 +190,79 @@ paint (TestState *state)
   cogl_path_line_to (path_a, BLOCK_SIZE, 0);
   cogl_path_close (path_a);
   /* Retain the path for the next test */
-  draw_path_at (path_a, white, 10, 0);
+  draw_path_at (state, path_a, white, 10, 0);
 
   /* Draw the same path again with the other fill rule */
   cogl_path_set_fill_rule (path_a, COGL_PATH_FILL_RULE_NON_ZERO);
-  draw_path_at (path_a, white, 11, 0);
+  draw_path_at (state, path_a, white, 11, 0);
+
+  cogl_object_unref (path_a);
+
+  /* Draw a pentagram as a single contour covering two blocks. Every
+     turn is in the same direction but it must not be filled as if it
+     was convex because the middle has a winding number of two */
+  path_a = cogl_path_new (test_ctx);
+  for (i = 0; i < 5; i++)
+    {
+      float angle = G_PI * (i * 4 / 5.0f - 0.5f);
+      float x = BLOCK_SIZE + cosf (angle) * BLOCK_SIZE;
+      float y = BLOCK_SIZE + sinf (angle) * BLOCK_SIZE;
+
+      if (i == 0)
+        cogl_path_move_to (path_a, x, y);
+      else
+        cogl_path_line_to (path_a, x, y);
+    }
+  cogl_path_close (path_a);
+  draw_path_at (state, path_a, white, 12, 0);
+
+  /* The same path with the non-zero rule should have the middle
+     filled */
+  cogl_path_set_fill_rule (path_a, COGL_PATH_FILL_RULE_NON_ZERO);
+  draw_path_at (state, path_a, white, 14, 0);
 
   cogl_object_unref (path_a);
+
+  /* Draw a convex path with collinear nodes after an empty sub path.
+     This can be filled without the tesselator */
+  path_a = cogl_path_new (test_ctx);
+  cogl_path_move_to (path_a, BLOCK_SIZE / 2, BLOCK_SIZE / 2);
+  cogl_path_move_to (path_a, 0, 0);
+  cogl_path_line_to (path_a, BLOCK_SIZE / 2, 0);
+  cogl_path_line_to (path_a, BLOCK_SIZE, 0);
+  cogl_path_line_to (path_a, BLOCK_SIZE, BLOCK_SIZE);
+  cogl_path_line_to (path_a, BLOCK_SIZE / 2, BLOCK_SIZE);
+  cogl_path_line_to (path_a, 0, BLOCK_SIZE);
+  cogl_path_close (path_a);
+  draw_path_at (state, path_a, white, 16, 0);
+
+  /* Adding an L-shaped sub path to the convex path means it has to go
+     back through the tesselator. The overlap should be inverted */
+  cogl_path_move_to (path_a, 0, 0);
+  cogl_path_line_to (path_a, BLOCK_SIZE / 2, 0);
+  cogl_path_line_to (path_a, BLOCK_SIZE / 2, BLOCK_SIZE / 2);
+  cogl_path_line_to (path_a, BLOCK_SIZE, BLOCK_SIZE / 2);
+  cogl_path_line_to (path_a, BLOCK_SIZE, BLOCK_SIZE);
+  cogl_path_line_to (path_a, 0, BLOCK_SIZE);
+  cogl_path_close (path_a);
+  draw_path_at (state, path_a, white, 17, 0);
+
+  cogl_object_unref (path_a);
+
+  /* Draw a circle made of four curves with the default tolerance */
+  path_a = cogl_path_new (test_ctx);
+  add_circle (path_a);
+  draw_path_at (state, path_a, white, 18, 0);
+  cogl_object_unref (path_a);
+
+  /* With a very large tolerance each curve should become a single
+     line so the circle is drawn as a diamond */
+  path_a = cogl_path_new (test_ctx);
+  cogl_path_set_tolerance (path_a, 100.0f);
+  g_assert_cmpfloat (cogl_path_get_tolerance (path_a), ==, 100.0f);
+  add_circle (path_a);
+  draw_path_at (state, path_a, white, 19, 0);
+  cogl_object_unref (path_a);
 }
 
 static void
@@ -189,6 +280,29 @@ validate_result ()
   check_block (9, 0, 0x7 /* all but bottom right */);
   check_block (10, 0, 0xc /* bottom two */);
   check_block (11, 0, 0xd /* all but top right */);
+  /* The top point and the middle of the pentagrams */
+  test_utils_check_pixel (test_fb, 12 * BLOCK_SIZE + BLOCK_SIZE, 6,
+                          0xffffffff);
+  test_utils_check_pixel (test_fb, 12 * BLOCK_SIZE + BLOCK_SIZE, BLOCK_SIZE,
+                          0x000000ff);
+  test_utils_check_pixel (test_fb, 14 * BLOCK_SIZE + BLOCK_SIZE, 6,
+                          0xffffffff);
+  test_utils_check_pixel (test_fb, 14 * BLOCK_SIZE + BLOCK_SIZE, BLOCK_SIZE,
+                          0xffffffff);
+  check_block (16, 0, 0xf /* all of them */);
+  check_block (17, 0, 0x2 /* top right */);
+  /* The middle of each circle should be filled. A point just inside
+     the circle near the corner of the block should only be filled
+     when the curves are flattened smoothly */
+  test_utils_check_pixel (test_fb,
+                          18 * BLOCK_SIZE + BLOCK_SIZE / 2, BLOCK_SIZE / 2,
+                          0xffffffff);
+  test_utils_check_pixel (test_fb, 18 * BLOCK_SIZE + 3, 3, 0xffffffff);
+  test_utils_check_pixel (test_fb, 18 * BLOCK_SIZE, 0, 0x000000ff);
+  test_utils_check_pixel (test_fb,
+                          19 * BLOCK_SIZE + BLOCK_SIZE / 2, BLOCK_SIZE / 2,
+                          0xffffffff);
+  test_utils_check_pixel (test_fb, 19 * BLOCK_SIZE + 3, 3, 0x000000ff);
 }
 
 void
@@ -203,6 +317,15 @@ test_path (void)
                                  -1,
                                  100);
 
+  state.fill_strategy = COGL_PATH_FILL_STRATEGY_AUTOMATIC;
+  paint (&state);
+  validate_result ();
+
+  /* Draw everything again using the stencil buffer instead of the
+     tesselator. The paths using the non-zero rule will still be
+     tesselated */
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+  state.fill_strategy = COGL_PATH_FILL_STRATEGY_STENCIL;
   paint (&state);
   validate_result ();
 
@@ -65,6 +65,10 @@ make_texture (uint32_t color,
   else if (flags & TEXTURE_FLAG_SET_UNPREMULTIPLIED)
     cogl_texture_set_premultiplied (tex_2d, FALSE);
 
+  /* The bitmap only references tex_data so the texture has to be
+   * allocated before it is freed */
+  cogl_texture_allocate (tex_2d, NULL);
+
   cogl_object_unref (bmp);
   g_free (tex_data);
 
@@ -0,0 +1,297 @@
+#include <cogl/cogl.h>
+
+#include "test-utils.h"
+
+/* cogl_primitive_draw() batches consecutive primitives that share the
+ * same state in the journal. This verifies that the batched
+ * primitives are drawn in the right order and with the state they had
+ * when they were drawn. It also checks batching primitives that use
+ * an atlas texture because drawing a primitive with one migrates the
+ * texture out of the atlas, which flushes the journals. */
+
+#define RECT_SIZE 10
+
+typedef struct
+{
+  float x, y;
+} Vertex;
+
+static void
+make_quad (Vertex *verts, float x, float y)
+{
+  /* Two triangles */
+  verts[0].x = x; verts[0].y = y;
+  verts[1].x = x; verts[1].y = y + RECT_SIZE;
+  verts[2].x = x + RECT_SIZE; verts[2].y = y;
+  verts[3].x = x + RECT_SIZE; verts[3].y = y;
+  verts[4].x = x; verts[4].y = y + RECT_SIZE;
+  verts[5].x = x + RECT_SIZE; verts[5].y = y + RECT_SIZE;
+}
+
+static CoglAttribute *
+make_attribute (CoglAttributeBuffer *buffer)
+{
+  return cogl_attribute_new (buffer,
+                             "cogl_position_in",
+                             sizeof (Vertex),
+                             0, /* offset */
+                             2, /* n_components */
+                             COGL_ATTRIBUTE_TYPE_FLOAT);
+}
+
+static CoglPrimitive *
+make_primitive (CoglAttributeBuffer *buffer,
+                int first_vertex)
+{
+  CoglAttribute *attribute = make_attribute (buffer);
+  CoglPrimitive *prim;
+
+  /* Each primitive gets its own attribute so that the batching has to
+   * compare them */
+  prim = cogl_primitive_new (COGL_VERTICES_MODE_TRIANGLES,
+                             6, /* n_vertices */
+                             attribute,
+                             NULL);
+  cogl_primitive_set_first_vertex (prim, first_vertex);
+
+  cogl_object_unref (attribute);
+
+  return prim;
+}
+
+static void
+test_shared_buffer (void)
+{
+  Vertex verts[6 * 3];
+  CoglAttributeBuffer *buffer;
+  CoglPrimitive *prims[3];
+  CoglPipeline *pipeline, *blue_pipeline;
+  int i;
+
+  for (i = 0; i < 3; i++)
+    make_quad (verts + i * 6, i * RECT_SIZE, 0);
+
+  buffer = cogl_attribute_buffer_new (test_ctx, sizeof (verts), verts);
+  for (i = 0; i < 3; i++)
+    prims[i] = make_primitive (buffer, i * 6);
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 255, 0, 0, 255);
+  blue_pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (blue_pipeline, 0, 0, 255, 255);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  /* Draw the first and the last quad with a rectangle in between
+   * that covers the middle quad and half of the last quad */
+  cogl_primitive_draw (prims[0], test_fb, pipeline);
+  cogl_primitive_draw (prims[1], test_fb, pipeline);
+  cogl_framebuffer_draw_rectangle (test_fb,
+                                   blue_pipeline,
+                                   RECT_SIZE, 0,
+                                   RECT_SIZE * 5 / 2, RECT_SIZE);
+  cogl_primitive_draw (prims[2], test_fb, pipeline);
+
+  /* Modifying the pipeline color must not affect primitives that
+   * were already drawn */
+  cogl_primitive_draw (prims[0], test_fb, pipeline);
+  cogl_pipeline_set_color4ub (pipeline, 0, 255, 0, 255);
+  cogl_primitive_draw (prims[1], test_fb, pipeline);
+
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2,
+                          0xff0000ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 3 / 2, RECT_SIZE / 2,
+                          0x00ff00ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 5 / 2 + 2, RECT_SIZE / 2,
+                          0xff0000ff);
+
+  /* Modifying the buffer must not affect primitives that were already
+   * drawn */
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+  cogl_primitive_draw (prims[0], test_fb, pipeline);
+  make_quad (verts, 0, RECT_SIZE);
+  cogl_buffer_set_data (buffer, 0,
+                        verts, sizeof (Vertex) * 6,
+                        NULL);
+  cogl_primitive_draw (prims[0], test_fb, pipeline);
+  cogl_primitive_draw (prims[1], test_fb, pipeline);
+
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2,
+                          0x00ff00ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE * 3 / 2,
+                          0x00ff00ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 3 / 2, RECT_SIZE / 2,
+                          0x00ff00ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 5 / 2, RECT_SIZE / 2,
+                          0x000000ff);
+
+  for (i = 0; i < 3; i++)
+    cogl_object_unref (prims[i]);
+  cogl_object_unref (buffer);
+  cogl_object_unref (blue_pipeline);
+  cogl_object_unref (pipeline);
+}
+
+static void
+test_indexed (void)
+{
+  static const uint16_t indices_data[] =
+    {
+      0, 1, 2, 2, 1, 3,
+      4, 5, 6, 6, 5, 7
+    };
+  static const Vertex verts[] =
+    {
+      { 0, 0 },
+      { 0, RECT_SIZE },
+      { RECT_SIZE, 0 },
+      { RECT_SIZE, RECT_SIZE },
+      { RECT_SIZE * 2, 0 },
+      { RECT_SIZE * 2, RECT_SIZE },
+      { RECT_SIZE * 3, 0 },
+      { RECT_SIZE * 3, RECT_SIZE }
+    };
+  CoglAttributeBuffer *buffer;
+  CoglAttribute *attribute;
+  CoglIndices *indices[2];
+  CoglPrimitive *prims[2];
+  CoglPipeline *pipeline;
+  int i;
+
+  buffer = cogl_attribute_buffer_new (test_ctx, sizeof (verts), verts);
+  attribute = make_attribute (buffer);
+
+  indices[0] = cogl_indices_new (test_ctx,
+                                 COGL_INDICES_TYPE_UNSIGNED_SHORT,
+                                 indices_data,
+                                 G_N_ELEMENTS (indices_data));
+  /* The second indices share the buffer of the first with an offset
+   * to the second quad */
+  indices[1] = cogl_indices_new_for_buffer (COGL_INDICES_TYPE_UNSIGNED_SHORT,
+                                            cogl_indices_get_buffer
+                                            (indices[0]),
+                                            6 * sizeof (uint16_t));
+
+  for (i = 0; i < 2; i++)
+    {
+      prims[i] = cogl_primitive_new (COGL_VERTICES_MODE_TRIANGLES,
+                                     6, /* n_vertices */
+                                     attribute,
+                                     NULL);
+      cogl_primitive_set_indices (prims[i], indices[i], 6);
+    }
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 0, 0, 255, 255);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  cogl_primitive_draw (prims[1], test_fb, pipeline);
+  cogl_primitive_draw (prims[0], test_fb, pipeline);
+
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2,
+                          0x0000ffff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 3 / 2, RECT_SIZE / 2,
+                          0x000000ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 5 / 2, RECT_SIZE / 2,
+                          0x0000ffff);
+
+  for (i = 0; i < 2; i++)
+    {
+      cogl_object_unref (prims[i]);
+      cogl_object_unref (indices[i]);
+    }
+  cogl_object_unref (attribute);
+  cogl_object_unref (buffer);
+  cogl_object_unref (pipeline);
+}
+
+static CoglPrimitive *
+make_textured_primitive (float x, float y)
+{
+  CoglVertexP2T2 verts[] =
+    {
+      { x, y, 0, 0 },
+      { x, y + RECT_SIZE, 0, 1 },
+      { x + RECT_SIZE, y, 1, 0 },
+      { x + RECT_SIZE, y, 1, 0 },
+      { x, y + RECT_SIZE, 0, 1 },
+      { x + RECT_SIZE, y + RECT_SIZE, 1, 1 }
+    };
+
+  return cogl_primitive_new_p2t2 (test_ctx,
+                                  COGL_VERTICES_MODE_TRIANGLES,
+                                  G_N_ELEMENTS (verts),
+                                  verts);
+}
+
+static void
+test_atlas_texture (void)
+{
+  uint8_t tex_data[RECT_SIZE * RECT_SIZE * 4];
+  CoglAtlasTexture *atlas_tex;
+  CoglPrimitive *prims[2];
+  CoglPipeline *pipeline;
+  CoglError *error = NULL;
+  int i;
+
+  for (i = 0; i < RECT_SIZE * RECT_SIZE; i++)
+    {
+      tex_data[i * 4 + 0] = 0xff;
+      tex_data[i * 4 + 1] = 0x00;
+      tex_data[i * 4 + 2] = 0xff;
+      tex_data[i * 4 + 3] = 0xff;
+    }
+
+  atlas_tex = cogl_atlas_texture_new_from_data (test_ctx,
+                                                RECT_SIZE, RECT_SIZE,
+                                                COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                                RECT_SIZE * 4,
+                                                tex_data,
+                                                &error);
+  g_assert (atlas_tex);
+
+  for (i = 0; i < 2; i++)
+    prims[i] = make_textured_primitive (i * RECT_SIZE, 0);
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_layer_texture (pipeline, 0, atlas_tex);
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  for (i = 0; i < 2; i++)
+    cogl_primitive_draw (prims[i], test_fb, pipeline);
+
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2,
+                          0xff00ffff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 3 / 2, RECT_SIZE / 2,
+                          0xff00ffff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 5 / 2, RECT_SIZE / 2,
+                          0x000000ff);
+
+  for (i = 0; i < 2; i++)
+    cogl_object_unref (prims[i]);
+  cogl_object_unref (pipeline);
+  cogl_object_unref (atlas_tex);
+}
+
+void
+test_primitive_batch (void)
+{
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  test_shared_buffer ();
+  test_indexed ();
+  test_atlas_texture ();
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
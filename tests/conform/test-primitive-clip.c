@@ -0,0 +1,355 @@
+#include <cogl/cogl.h>
+
+#include "test-utils.h"
+
+/* cogl_primitive_draw() logs primitives that describe a rectangle in
+ * the journal when they are drawn with a clip that can't be done with
+ * the scissor. This verifies that the results are the same as drawing
+ * the primitive directly. It also checks that the stencil buffer isn't
+ * reused for a primitive clip when the primitive has been modified or
+ * when the frame has ended. */
+
+#define CLIP_SIZE 20.0f
+#define RECT_SIZE 50.0f
+
+static void
+check_local_pixel (float x,
+                   float y,
+                   uint32_t expected_pixel)
+{
+  CoglMatrix modelview;
+  float z = 0.0f, w = 1.0f;
+
+  /* Transform the point from the rotated coordinate space to window
+   * coordinates */
+  cogl_framebuffer_get_modelview_matrix (test_fb, &modelview);
+  cogl_matrix_transform_point (&modelview, &x, &y, &z, &w);
+
+  test_utils_check_pixel (test_fb, x, y, expected_pixel);
+}
+
+static void
+setup_clip (void)
+{
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  /* Rotate the clip so that it can't be implemented with the
+   * scissor */
+  cogl_framebuffer_push_matrix (test_fb);
+  cogl_framebuffer_translate (test_fb, 100, 100, 0);
+  cogl_framebuffer_rotate (test_fb, 45, 0, 0, 1);
+
+  cogl_framebuffer_push_rectangle_clip (test_fb,
+                                        -CLIP_SIZE, -CLIP_SIZE,
+                                        CLIP_SIZE, CLIP_SIZE);
+}
+
+static void
+teardown_clip (void)
+{
+  cogl_framebuffer_pop_clip (test_fb);
+  cogl_framebuffer_pop_matrix (test_fb);
+}
+
+static void
+test_untextured (void)
+{
+  static const CoglVertexP2 verts[] =
+    {
+      { -RECT_SIZE, -RECT_SIZE },
+      { -RECT_SIZE, RECT_SIZE },
+      { RECT_SIZE, -RECT_SIZE },
+      { RECT_SIZE, RECT_SIZE }
+    };
+  CoglPrimitive *prim;
+  CoglPipeline *pipeline;
+
+  prim = cogl_primitive_new_p2 (test_ctx,
+                                COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                G_N_ELEMENTS (verts),
+                                verts);
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 255, 0, 0, 255);
+
+  setup_clip ();
+  cogl_primitive_draw (prim, test_fb, pipeline);
+
+  /* Inside the clip */
+  check_local_pixel (0, 0, 0xff0000ff);
+  check_local_pixel (-15, 15, 0xff0000ff);
+  /* Inside the primitive but outside of the clip */
+  check_local_pixel (-30, 0, 0x000000ff);
+  check_local_pixel (0, 40, 0x000000ff);
+
+  teardown_clip ();
+
+  cogl_object_unref (pipeline);
+  cogl_object_unref (prim);
+}
+
+static void
+test_textured (void)
+{
+  static const uint8_t tex_data[] =
+    {
+      0xff, 0x00, 0x00, 0xff, 0x00, 0xff, 0x00, 0xff,
+      0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+    };
+  /* A triangle fan with the texture flipped horizontally */
+  static const CoglVertexP2T2 verts[] =
+    {
+      { -RECT_SIZE, -RECT_SIZE, 1.0f, 0.0f },
+      { -RECT_SIZE, RECT_SIZE, 1.0f, 1.0f },
+      { RECT_SIZE, RECT_SIZE, 0.0f, 1.0f },
+      { RECT_SIZE, -RECT_SIZE, 0.0f, 0.0f }
+    };
+  CoglPrimitive *prim;
+  CoglPipeline *pipeline;
+  CoglTexture2D *tex;
+
+  tex = cogl_texture_2d_new_from_data (test_ctx,
+                                       2, 2, /* width/height */
+                                       COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                       8, /* rowstride */
+                                       tex_data,
+                                       NULL);
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_layer_texture (pipeline, 0, tex);
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+
+  prim = cogl_primitive_new_p2t2 (test_ctx,
+                                  COGL_VERTICES_MODE_TRIANGLE_FAN,
+                                  G_N_ELEMENTS (verts),
+                                  verts);
+
+  setup_clip ();
+  cogl_primitive_draw (prim, test_fb, pipeline);
+
+  check_local_pixel (-10, -10, 0x00ff00ff);
+  check_local_pixel (10, -10, 0xff0000ff);
+  check_local_pixel (-10, 10, 0xffffffff);
+  check_local_pixel (10, 10, 0x0000ffff);
+  check_local_pixel (30, 0, 0x000000ff);
+
+  teardown_clip ();
+
+  cogl_object_unref (prim);
+  cogl_object_unref (pipeline);
+  cogl_object_unref (tex);
+}
+
+static CoglBool
+get_buffer_cb (CoglPrimitive *prim,
+               CoglAttribute *attribute,
+               void *user_data)
+{
+  CoglAttributeBuffer **buffer = user_data;
+
+  *buffer = cogl_attribute_get_buffer (attribute);
+
+  return FALSE; /* stop iterating */
+}
+
+static void
+test_modified_vertices (void)
+{
+  CoglVertexP2 verts[] =
+    {
+      { -RECT_SIZE, -RECT_SIZE },
+      { -RECT_SIZE, RECT_SIZE },
+      { RECT_SIZE, -RECT_SIZE },
+      { RECT_SIZE, RECT_SIZE }
+    };
+  CoglAttributeBuffer *buffer = NULL;
+  CoglPrimitive *prim;
+  CoglPipeline *pipeline;
+
+  prim = cogl_primitive_new_p2 (test_ctx,
+                                COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                G_N_ELEMENTS (verts),
+                                verts);
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 0, 255, 0, 255);
+
+  /* Shrink the rectangle to only cover the right half of the clip
+   * after the primitive has been created */
+  verts[0].x = verts[1].x = 0.0f;
+  cogl_primitive_foreach_attribute (prim, get_buffer_cb, &buffer);
+  cogl_buffer_set_data (buffer, 0, verts, sizeof (verts), NULL);
+
+  setup_clip ();
+  cogl_primitive_draw (prim, test_fb, pipeline);
+
+  check_local_pixel (10, 0, 0x00ff00ff);
+  check_local_pixel (-10, 0, 0x000000ff);
+
+  teardown_clip ();
+
+  cogl_object_unref (pipeline);
+  cogl_object_unref (prim);
+}
+
+static void
+draw_with_primitive_clip (CoglPrimitive *clip_prim,
+                          CoglPipeline *pipeline)
+{
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  /* The bounds are the same each time so that only the vertices
+   * differ between the clip stacks */
+  cogl_framebuffer_push_primitive_clip (test_fb,
+                                        clip_prim,
+                                        0, 0,
+                                        RECT_SIZE * 2, RECT_SIZE);
+  cogl_framebuffer_draw_rectangle (test_fb,
+                                   pipeline,
+                                   0, 0,
+                                   RECT_SIZE * 2, RECT_SIZE);
+  cogl_framebuffer_pop_clip (test_fb);
+}
+
+static void
+test_modified_clip_primitive (void)
+{
+  CoglVertexP2 verts[] =
+    {
+      { 0, 0 },
+      { 0, RECT_SIZE },
+      { RECT_SIZE, 0 },
+      { RECT_SIZE, RECT_SIZE }
+    };
+  CoglAttributeBuffer *buffer = NULL;
+  CoglPrimitive *prim;
+  CoglPipeline *pipeline;
+
+  prim = cogl_primitive_new_p2 (test_ctx,
+                                COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                G_N_ELEMENTS (verts),
+                                verts);
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 0, 0, 255, 255);
+
+  /* Clip to the left half */
+  draw_with_primitive_clip (prim, pipeline);
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2, 0x0000ffff);
+  test_utils_check_pixel (test_fb,
+                          RECT_SIZE * 3 / 2, RECT_SIZE / 2,
+                          0x000000ff);
+
+  /* Move the same primitive to the right half. The stencil buffer
+   * from the previous clip must not be reused */
+  verts[0].x = verts[1].x = RECT_SIZE;
+  verts[2].x = verts[3].x = RECT_SIZE * 2;
+  cogl_primitive_foreach_attribute (prim, get_buffer_cb, &buffer);
+  cogl_buffer_set_data (buffer, 0, verts, sizeof (verts), NULL);
+
+  draw_with_primitive_clip (prim, pipeline);
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2, 0x000000ff);
+  test_utils_check_pixel (test_fb,
+                          RECT_SIZE * 3 / 2, RECT_SIZE / 2,
+                          0x0000ffff);
+
+  /* Changing the number of vertices also changes the clip */
+  cogl_primitive_set_n_vertices (prim, 3);
+
+  draw_with_primitive_clip (prim, pipeline);
+  test_utils_check_pixel (test_fb,
+                          RECT_SIZE + 5, 5,
+                          0x0000ffff);
+  test_utils_check_pixel (test_fb,
+                          RECT_SIZE * 2 - 5, RECT_SIZE - 5,
+                          0x000000ff);
+
+  cogl_object_unref (pipeline);
+  cogl_object_unref (prim);
+}
+
+static void
+draw_frame_with_rotated_clip (CoglPrimitive *clip_prim,
+                              CoglPipeline *pipeline)
+{
+  /* Only the color buffer is cleared so the stencil buffer is left
+   * in whatever state the end of the previous frame left it */
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  cogl_framebuffer_push_matrix (test_fb);
+  cogl_framebuffer_translate (test_fb, 100, 100, 0);
+  cogl_framebuffer_rotate (test_fb, 45, 0, 0, 1);
+
+  cogl_framebuffer_push_primitive_clip (test_fb,
+                                        clip_prim,
+                                        -CLIP_SIZE, -CLIP_SIZE,
+                                        CLIP_SIZE, CLIP_SIZE);
+  cogl_framebuffer_draw_rectangle (test_fb,
+                                   pipeline,
+                                   -RECT_SIZE, -RECT_SIZE,
+                                   RECT_SIZE, RECT_SIZE);
+
+  check_local_pixel (0, 0, 0x00ffffff);
+  check_local_pixel (-15, 15, 0x00ffffff);
+  check_local_pixel (-30, 0, 0x000000ff);
+  check_local_pixel (0, 40, 0x000000ff);
+
+  cogl_framebuffer_pop_clip (test_fb);
+  cogl_framebuffer_pop_matrix (test_fb);
+}
+
+static void
+test_clip_across_frames (void)
+{
+  static const CoglVertexP2 verts[] =
+    {
+      { -CLIP_SIZE, -CLIP_SIZE },
+      { -CLIP_SIZE, CLIP_SIZE },
+      { CLIP_SIZE, -CLIP_SIZE },
+      { CLIP_SIZE, CLIP_SIZE }
+    };
+  CoglPrimitive *prim;
+  CoglPipeline *pipeline;
+
+  prim = cogl_primitive_new_p2 (test_ctx,
+                                COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                G_N_ELEMENTS (verts),
+                                verts);
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 0, 255, 255, 255);
+
+  draw_frame_with_rotated_clip (prim, pipeline);
+
+  /* The stencil buffer is undefined after ending the frame so the
+   * same clip in the next frame has to be drawn into it again */
+  if (cogl_is_onscreen (test_fb))
+    cogl_onscreen_swap_buffers (COGL_ONSCREEN (test_fb));
+  else
+    cogl_framebuffer_discard_buffers (test_fb,
+                                      COGL_BUFFER_BIT_COLOR |
+                                      COGL_BUFFER_BIT_DEPTH |
+                                      COGL_BUFFER_BIT_STENCIL);
+
+  draw_frame_with_rotated_clip (prim, pipeline);
+
+  cogl_object_unref (pipeline);
+  cogl_object_unref (prim);
+}
+
+void
+test_primitive_clip (void)
+{
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  test_untextured ();
+  test_textured ();
+  test_modified_vertices ();
+  test_modified_clip_primitive ();
+  test_clip_across_frames ();
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,179 @@
+#include <cogl/cogl.h>
+
+#include "test-utils.h"
+
+/* Draws a primitive multiple times with cogl_primitive_draw_instanced
+ * and verifies that per-instance attributes advance once per
+ * instance (or once per divisor instances). */
+
+#define RECT_SIZE 10
+
+static CoglPrimitive *
+create_primitive (float x,
+                  const void *colors,
+                  int n_colors,
+                  int divisor)
+{
+  const CoglVertexP2 verts[] =
+    {
+      { x, 0 },
+      { x, RECT_SIZE },
+      { x + RECT_SIZE, 0 },
+      { x + RECT_SIZE, RECT_SIZE }
+    };
+  CoglAttributeBuffer *position_buffer;
+  CoglAttributeBuffer *color_buffer;
+  CoglAttribute *attributes[2];
+  CoglPrimitive *prim;
+
+  position_buffer = cogl_attribute_buffer_new (test_ctx,
+                                               sizeof (verts),
+                                               verts);
+  attributes[0] = cogl_attribute_new (position_buffer,
+                                      "cogl_position_in",
+                                      sizeof (CoglVertexP2),
+                                      0, /* offset */
+                                      2, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_FLOAT);
+
+  color_buffer = cogl_attribute_buffer_new (test_ctx,
+                                            n_colors * 4,
+                                            colors);
+  attributes[1] = cogl_attribute_new (color_buffer,
+                                      "cogl_color_in",
+                                      4, /* stride */
+                                      0, /* offset */
+                                      4, /* n_components */
+                                      COGL_ATTRIBUTE_TYPE_UNSIGNED_BYTE);
+  cogl_attribute_set_instance_divisor (attributes[1], divisor);
+  g_assert_cmpint (cogl_attribute_get_instance_divisor (attributes[1]),
+                   ==,
+                   divisor);
+
+  prim = cogl_primitive_new_with_attributes (COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                             G_N_ELEMENTS (verts),
+                                             attributes,
+                                             G_N_ELEMENTS (attributes));
+
+  cogl_object_unref (attributes[0]);
+  cogl_object_unref (attributes[1]);
+  cogl_object_unref (position_buffer);
+  cogl_object_unref (color_buffer);
+
+  return prim;
+}
+
+static void
+test_per_instance_colors (void)
+{
+  static const uint8_t rgb_colors[] =
+    {
+      0xff, 0x00, 0x00, 0x00,
+      0x00, 0xff, 0x00, 0x00,
+      0x00, 0x00, 0xff, 0x00
+    };
+  static const uint8_t divided_colors[] =
+    {
+      0x20, 0x00, 0x00, 0x00,
+      0x00, 0x40, 0x00, 0x00
+    };
+  CoglPipeline *pipeline;
+  CoglPrimitive *prim;
+
+  /* Add all of the instances together so that the result shows
+   * which colors were used */
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_blend (pipeline,
+                           "RGBA = ADD (SRC_COLOR, DST_COLOR)",
+                           NULL);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  /* Each instance uses the next color */
+  prim = create_primitive (0, rgb_colors, 3, 1 /* divisor */);
+  cogl_primitive_draw_instanced (prim, test_fb, pipeline, 3);
+  cogl_object_unref (prim);
+
+  /* Each color is used for two instances */
+  prim = create_primitive (RECT_SIZE, divided_colors, 2, 2 /* divisor */);
+  cogl_primitive_draw_instanced (prim, test_fb, pipeline, 4);
+  cogl_object_unref (prim);
+
+  /* Drawing a single instance should only use the first color */
+  prim = create_primitive (RECT_SIZE * 2, rgb_colors, 3, 1 /* divisor */);
+  cogl_primitive_draw_instanced (prim, test_fb, pipeline, 1);
+  cogl_object_unref (prim);
+
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2,
+                          0xffffffff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 3 / 2, RECT_SIZE / 2,
+                          0x408000ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 5 / 2, RECT_SIZE / 2,
+                          0xff0000ff);
+
+  cogl_object_unref (pipeline);
+}
+
+static void
+test_instance_id (void)
+{
+  static const uint8_t colors[] =
+    {
+      0xff, 0x00, 0x00, 0xff,
+      0x00, 0xff, 0x00, 0xff,
+      0x00, 0x00, 0xff, 0xff
+    };
+  CoglPipeline *pipeline;
+  CoglPrimitive *prim;
+  CoglSnippet *snippet;
+
+  /* Move each instance along using the builtin instance index */
+  pipeline = cogl_pipeline_new (test_ctx);
+  snippet = cogl_snippet_new (COGL_SNIPPET_HOOK_VERTEX_TRANSFORM,
+                              NULL,
+                              NULL);
+  cogl_snippet_set_pre (snippet,
+                        "vec4 position = cogl_position_in;\n"
+                        "position.x += float (cogl_instance_id * 10);\n");
+  cogl_snippet_set_replace (snippet,
+                            "cogl_position_out = "
+                            "cogl_modelview_projection_matrix * position;\n");
+  cogl_pipeline_add_snippet (pipeline, snippet);
+  cogl_object_unref (snippet);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  prim = create_primitive (0, colors, 3, 1 /* divisor */);
+  cogl_primitive_draw_instanced (prim, test_fb, pipeline, 3);
+  cogl_object_unref (prim);
+
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2,
+                          0xff0000ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 3 / 2, RECT_SIZE / 2,
+                          0x00ff00ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 5 / 2, RECT_SIZE / 2,
+                          0x0000ffff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 7 / 2, RECT_SIZE / 2,
+                          0x000000ff);
+
+  cogl_object_unref (pipeline);
+}
+
+void
+test_primitive_instanced (void)
+{
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  test_per_instance_colors ();
+
+  if (cogl_has_feature (test_ctx, COGL_FEATURE_ID_GLSL))
+    test_instance_id ();
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
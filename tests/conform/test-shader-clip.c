@@ -0,0 +1,169 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cogl/cogl.h>
+/* The debug flags aren't public API but they are exported for
+ * cogl-pango so we can use them to switch between the two ways of
+ * clipping */
+#define __COGL_H_INSIDE__
+#include "cogl/cogl-debug.h"
+#undef __COGL_H_INSIDE__
+
+#include <string.h>
+
+#include "test-utils.h"
+
+/* Rectangles that can't be described by the scissor are clipped in
+ * the fragment shader when GLSL is available. This draws a primitive
+ * that isn't a rectangle through 1 to 4 rotated clips and checks that
+ * the result is the same as with the disable-shader-clip debug option
+ * which falls back to the stencil buffer or the clip planes. */
+
+#define CENTER_X 64
+#define CENTER_Y 64
+#define REGION_SIZE 128
+
+/* The planes are tested at the center of each fragment like the
+ * rasterizer does but the results can still differ by rounding for
+ * fragments that lie right on an edge so a few of those are
+ * allowed */
+#define MAX_DIFFERENT_PIXELS 16
+
+static const struct
+{
+  float x, y;
+  float angle;
+  float size;
+} clips[] =
+  {
+    { 0, 0, 30, 50 },
+    { 5, -3, 65, 45 },
+    { -4, 6, 10, 48 },
+    { 2, 2, 80, 40 }
+  };
+
+static void
+draw_clipped (int n_clips,
+              uint8_t *pixels)
+{
+  /* A hexagon that is bigger than all of the clips */
+  static const CoglVertexP2 verts[] =
+    {
+      { 0, 0 },
+      { 60, 0 },
+      { 30, 52 },
+      { -30, 52 },
+      { -60, 0 },
+      { -30, -52 },
+      { 30, -52 },
+      { 60, 0 }
+    };
+  CoglPrimitive *prim;
+  CoglPipeline *pipeline;
+  int i;
+
+  prim = cogl_primitive_new_p2 (test_ctx,
+                                COGL_VERTICES_MODE_TRIANGLE_FAN,
+                                G_N_ELEMENTS (verts),
+                                verts);
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 255, 0, 0, 255);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+
+  cogl_framebuffer_push_matrix (test_fb);
+  cogl_framebuffer_translate (test_fb, CENTER_X, CENTER_Y, 0);
+
+  for (i = 0; i < n_clips; i++)
+    {
+      cogl_framebuffer_push_matrix (test_fb);
+      cogl_framebuffer_translate (test_fb, clips[i].x, clips[i].y, 0);
+      cogl_framebuffer_rotate (test_fb, clips[i].angle, 0, 0, 1);
+      cogl_framebuffer_push_rectangle_clip (test_fb,
+                                            -clips[i].size / 2,
+                                            -clips[i].size / 2,
+                                            clips[i].size / 2,
+                                            clips[i].size / 2);
+      cogl_framebuffer_pop_matrix (test_fb);
+    }
+
+  cogl_primitive_draw (prim, test_fb, pipeline);
+
+  for (i = 0; i < n_clips; i++)
+    cogl_framebuffer_pop_clip (test_fb);
+
+  cogl_framebuffer_pop_matrix (test_fb);
+
+  cogl_framebuffer_read_pixels (test_fb,
+                                0, 0,
+                                REGION_SIZE, REGION_SIZE,
+                                COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                pixels);
+
+  cogl_object_unref (pipeline);
+  cogl_object_unref (prim);
+}
+
+static void
+check_clip (int n_clips)
+{
+  uint8_t *shader_pixels = g_malloc (REGION_SIZE * REGION_SIZE * 4);
+  uint8_t *fallback_pixels = g_malloc (REGION_SIZE * REGION_SIZE * 4);
+  CoglBool was_disabled =
+    COGL_DEBUG_ENABLED (COGL_DEBUG_DISABLE_SHADER_CLIP);
+  int n_different = 0;
+  int i;
+
+  COGL_DEBUG_CLEAR_FLAG (COGL_DEBUG_DISABLE_SHADER_CLIP);
+  draw_clipped (n_clips, shader_pixels);
+
+  COGL_DEBUG_SET_FLAG (COGL_DEBUG_DISABLE_SHADER_CLIP);
+  draw_clipped (n_clips, fallback_pixels);
+
+  if (!was_disabled)
+    COGL_DEBUG_CLEAR_FLAG (COGL_DEBUG_DISABLE_SHADER_CLIP);
+
+  /* The center is inside all of the clips and the corners of the
+     hexagon are outside all of them */
+  test_utils_compare_pixel (shader_pixels +
+                            (CENTER_Y * REGION_SIZE + CENTER_X) * 4,
+                            0xff0000ff);
+  test_utils_compare_pixel (shader_pixels +
+                            (CENTER_Y * REGION_SIZE + CENTER_X + 55) * 4,
+                            0x000000ff);
+  test_utils_compare_pixel (shader_pixels +
+                            ((CENTER_Y - 45) * REGION_SIZE + CENTER_X) * 4,
+                            0x000000ff);
+
+  for (i = 0; i < REGION_SIZE * REGION_SIZE; i++)
+    if (memcmp (shader_pixels + i * 4, fallback_pixels + i * 4, 4))
+      n_different++;
+
+  if (cogl_test_verbose ())
+    g_print ("%i clips: %i different pixels\n", n_clips, n_different);
+
+  g_assert_cmpint (n_different, <=, MAX_DIFFERENT_PIXELS);
+
+  g_free (shader_pixels);
+  g_free (fallback_pixels);
+}
+
+void
+test_shader_clip (void)
+{
+  int n_clips;
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  for (n_clips = 1; n_clips <= (int) G_N_ELEMENTS (clips); n_clips++)
+    check_clip (n_clips);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
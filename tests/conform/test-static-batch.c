@@ -0,0 +1,110 @@
+#include <cogl/cogl.h>
+
+#include "test-utils.h"
+
+#define RECT_SIZE 10
+
+static void
+clear_and_draw (CoglStaticBatch *batch)
+{
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+  cogl_static_batch_draw (batch, test_fb);
+}
+
+void
+test_static_batch (void)
+{
+  CoglStaticBatch *batch;
+  CoglPipeline *pipeline, *blend_pipeline;
+  CoglMatrix transform;
+  int rect;
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  batch = cogl_static_batch_new (test_ctx);
+  g_assert (cogl_is_static_batch (batch));
+
+  /* Drawing an empty batch should do nothing */
+  clear_and_draw (batch);
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2, 0x000000ff);
+
+  /* The first two rectangles only differ by the color so they should
+   * end up in the same run but still keep their own colors */
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (pipeline, 255, 0, 0, 255);
+  rect = cogl_static_batch_add_rectangle (batch,
+                                          pipeline,
+                                          0, 0, RECT_SIZE, RECT_SIZE);
+  g_assert_cmpint (rect, ==, 0);
+  cogl_pipeline_set_color4ub (pipeline, 0, 255, 0, 255);
+  rect = cogl_static_batch_add_rectangle (batch,
+                                          pipeline,
+                                          RECT_SIZE, 0,
+                                          RECT_SIZE * 2, RECT_SIZE);
+  g_assert_cmpint (rect, ==, 1);
+
+  /* This needs a separate run */
+  blend_pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_color4ub (blend_pipeline, 0, 0, 0x40, 255);
+  cogl_pipeline_set_blend (blend_pipeline,
+                           "RGBA = ADD (SRC_COLOR, DST_COLOR)",
+                           NULL);
+  rect = cogl_static_batch_add_rectangle (batch,
+                                          blend_pipeline,
+                                          RECT_SIZE * 2, 0,
+                                          RECT_SIZE * 3, RECT_SIZE);
+  g_assert_cmpint (rect, ==, 2);
+  g_assert_cmpint (cogl_static_batch_get_n_rectangles (batch), ==, 3);
+
+  /* Modifying the pipelines after adding the rectangles shouldn't
+   * affect the batch */
+  cogl_pipeline_set_color4ub (pipeline, 255, 255, 255, 255);
+  cogl_pipeline_set_blend (blend_pipeline,
+                           "RGBA = ADD (SRC_COLOR * (0), DST_COLOR)",
+                           NULL);
+
+  clear_and_draw (batch);
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2, 0xff0000ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 3 / 2, RECT_SIZE / 2,
+                          0x00ff00ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 5 / 2, RECT_SIZE / 2,
+                          0x000040ff);
+
+  /* Move the first rectangle down after it has been uploaded */
+  cogl_matrix_init_translation (&transform, 0, RECT_SIZE, 0);
+  cogl_static_batch_set_transform (batch, 0, &transform);
+
+  clear_and_draw (batch);
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE / 2, 0x000000ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE * 3 / 2,
+                          0xff0000ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 3 / 2, RECT_SIZE / 2,
+                          0x00ff00ff);
+
+  /* Adding another rectangle after the batch has been drawn should
+   * keep the existing transforms */
+  cogl_static_batch_add_rectangle (batch,
+                                   pipeline,
+                                   RECT_SIZE * 3, 0,
+                                   RECT_SIZE * 4, RECT_SIZE);
+
+  clear_and_draw (batch);
+  test_utils_check_pixel (test_fb, RECT_SIZE / 2, RECT_SIZE * 3 / 2,
+                          0xff0000ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 5 / 2, RECT_SIZE / 2,
+                          0x000040ff);
+  test_utils_check_pixel (test_fb, RECT_SIZE * 7 / 2, RECT_SIZE / 2,
+                          0xffffffff);
+
+  cogl_object_unref (blend_pipeline);
+  cogl_object_unref (pipeline);
+  cogl_object_unref (batch);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
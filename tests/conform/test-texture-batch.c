@@ -0,0 +1,187 @@
+#include <cogl/cogl.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "test-utils.h"
+
+typedef struct
+{
+  int size;
+  CoglTextureBatchFlags flags;
+  uint8_t red, green, blue, alpha;
+} TestImage;
+
+static const TestImage
+test_images[] =
+  {
+    { 4, COGL_TEXTURE_BATCH_FLAG_ATLAS, 0xff, 0x00, 0x00, 0xff },
+    { 16, COGL_TEXTURE_BATCH_FLAG_NONE, 0x00, 0xff, 0x00, 0x80 },
+    { 8, COGL_TEXTURE_BATCH_FLAG_ATLAS, 0x00, 0x00, 0xff, 0x40 },
+    /* sRGB mipmapped images shouldn't go in the atlas even if asked
+       to */
+    { 32, (COGL_TEXTURE_BATCH_FLAG_ATLAS |
+           COGL_TEXTURE_BATCH_FLAG_MIPMAP |
+           COGL_TEXTURE_BATCH_FLAG_SRGB), 0xff, 0x80, 0x00, 0xc0 },
+    /* Other mipmapped images can go in a mipmapped atlas */
+    { 24, (COGL_TEXTURE_BATCH_FLAG_ATLAS |
+           COGL_TEXTURE_BATCH_FLAG_MIPMAP), 0x80, 0x00, 0xff, 0xff },
+  };
+
+typedef struct
+{
+  int n_loaded;
+  int last_size;
+  CoglBool got_error;
+} TestState;
+
+static char *
+write_image (const TestImage *image)
+{
+  char *basename = g_strdup_printf ("cogl-test-texture-batch-%i.pam",
+                                    image->size);
+  char *filename = g_build_filename (g_get_tmp_dir (), basename, NULL);
+  FILE *file;
+  int i;
+
+  file = fopen (filename, "wb");
+  g_assert (file != NULL);
+
+  fprintf (file,
+           "P7\nWIDTH %i\nHEIGHT %i\nDEPTH 4\nMAXVAL 255\n"
+           "TUPLTYPE RGB_ALPHA\nENDHDR\n",
+           image->size, image->size);
+
+  for (i = 0; i < image->size * image->size; i++)
+    {
+      fputc (image->red, file);
+      fputc (image->green, file);
+      fputc (image->blue, file);
+      fputc (image->alpha, file);
+    }
+
+  fclose (file);
+  g_free (basename);
+
+  return filename;
+}
+
+static void
+check_texture (CoglTexture *texture,
+               const TestImage *image)
+{
+  int size = image->size;
+  uint8_t *data = g_malloc (size * size * 4);
+  int i;
+
+  cogl_texture_get_data (texture,
+                         COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                         size * 4,
+                         data);
+
+  for (i = 0; i < size * size; i++)
+    {
+      /* The data should have been premultiplied while loading */
+      g_assert_cmpint (ABS (data[i * 4 + 0] -
+                            image->red * image->alpha / 255), <=, 1);
+      g_assert_cmpint (ABS (data[i * 4 + 1] -
+                            image->green * image->alpha / 255), <=, 1);
+      g_assert_cmpint (ABS (data[i * 4 + 2] -
+                            image->blue * image->alpha / 255), <=, 1);
+      g_assert_cmpint (data[i * 4 + 3], ==, image->alpha);
+    }
+
+  g_free (data);
+}
+
+static void
+loaded_cb (CoglTexture *texture,
+           const char *filename,
+           const CoglError *error,
+           void *user_data)
+{
+  TestState *state = user_data;
+  const TestImage *image = NULL;
+  int i;
+
+  if (texture == NULL)
+    {
+      g_assert (error != NULL);
+      g_assert (strstr (filename, "does-not-exist") != NULL);
+      /* The failed file has no size so it should come last */
+      g_assert_cmpint (state->n_loaded, ==, G_N_ELEMENTS (test_images));
+      state->got_error = TRUE;
+      return;
+    }
+
+  g_assert (error == NULL);
+
+  for (i = 0; i < G_N_ELEMENTS (test_images); i++)
+    if (test_images[i].size == cogl_texture_get_width (texture))
+      image = test_images + i;
+
+  g_assert (image != NULL);
+  g_assert_cmpint (cogl_texture_get_height (texture), ==, image->size);
+
+  /* The textures should be created from the largest to the smallest */
+  g_assert_cmpint (image->size, <, state->last_size);
+  state->last_size = image->size;
+
+  check_texture (texture, image);
+
+  if ((image->flags & COGL_TEXTURE_BATCH_FLAG_SRGB))
+    g_assert (cogl_is_texture_2d (texture));
+
+  state->n_loaded++;
+}
+
+void
+test_texture_batch (void)
+{
+  CoglTextureBatch *batch = cogl_texture_batch_new (test_ctx);
+  char *filenames[G_N_ELEMENTS (test_images)];
+  TestState state;
+  int i;
+
+  state.n_loaded = 0;
+  state.last_size = G_MAXINT32;
+  state.got_error = FALSE;
+
+  for (i = 0; i < G_N_ELEMENTS (test_images); i++)
+    {
+      filenames[i] = write_image (test_images + i);
+      cogl_texture_batch_add_file (batch,
+                                   filenames[i],
+                                   test_images[i].flags,
+                                   loaded_cb,
+                                   &state);
+    }
+
+  cogl_texture_batch_add_file (batch,
+                               "/does-not-exist/image.png",
+                               COGL_TEXTURE_BATCH_FLAG_NONE,
+                               loaded_cb,
+                               &state);
+
+  g_assert_cmpint (cogl_texture_batch_get_n_files (batch),
+                   ==,
+                   G_N_ELEMENTS (test_images) + 1);
+
+  cogl_texture_batch_load (batch);
+
+  g_assert_cmpint (state.n_loaded, ==, G_N_ELEMENTS (test_images));
+  g_assert (state.got_error);
+
+  /* The batch should be empty again after loading */
+  g_assert_cmpint (cogl_texture_batch_get_n_files (batch), ==, 0);
+
+  for (i = 0; i < G_N_ELEMENTS (test_images); i++)
+    {
+      remove (filenames[i]);
+      g_free (filenames[i]);
+    }
+
+  cogl_object_unref (batch);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
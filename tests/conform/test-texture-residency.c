@@ -0,0 +1,141 @@
+#include <cogl/cogl.h>
+
+#include "test-utils.h"
+
+/* This sets a texture memory budget and checks that purgeable
+ * textures are only evicted at the end of a frame and that they are
+ * transparently recreated when they are drawn again. The textures are
+ * drawn with primitives so that they are validated as part of a
+ * journal flush. */
+
+#define TEX_SIZE 16
+#define TEX_BYTES (TEX_SIZE * TEX_SIZE * 4)
+
+/* The bitmaps are kept by the purgeable textures so that they can be
+   recreated so the data needs to outlive the textures */
+static uint8_t texture_data[2][TEX_BYTES];
+
+static CoglTexture *
+create_purgeable_texture (int index,
+                          uint32_t color)
+{
+  uint8_t *data = texture_data[index];
+  CoglBitmap *bitmap;
+  CoglTexture *tex;
+  int i;
+
+  for (i = 0; i < TEX_SIZE * TEX_SIZE; i++)
+    {
+      data[i * 4 + 0] = color >> 24;
+      data[i * 4 + 1] = color >> 16;
+      data[i * 4 + 2] = color >> 8;
+      data[i * 4 + 3] = color;
+    }
+
+  bitmap = cogl_bitmap_new_for_data (test_ctx,
+                                     TEX_SIZE, TEX_SIZE,
+                                     COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                     TEX_SIZE * 4,
+                                     data);
+  tex = cogl_texture_2d_new_from_bitmap (bitmap);
+  cogl_object_unref (bitmap);
+
+  cogl_texture_set_purgeable (tex, TRUE);
+
+  return tex;
+}
+
+static void
+draw_texture (CoglTexture *tex,
+              int x)
+{
+  CoglVertexP2T2 verts[] =
+    {
+      { x, 0, 0, 0 },
+      { x, TEX_SIZE, 0, 1 },
+      { x + TEX_SIZE, 0, 1, 0 },
+      { x + TEX_SIZE, TEX_SIZE, 1, 1 }
+    };
+  CoglPipeline *pipeline = cogl_pipeline_new (test_ctx);
+  CoglPrimitive *prim;
+
+  cogl_pipeline_set_layer_texture (pipeline, 0, tex);
+
+  prim = cogl_primitive_new_p2t2 (test_ctx,
+                                  COGL_VERTICES_MODE_TRIANGLE_STRIP,
+                                  G_N_ELEMENTS (verts),
+                                  verts);
+  cogl_primitive_draw (prim, test_fb, pipeline);
+
+  cogl_object_unref (prim);
+  cogl_object_unref (pipeline);
+}
+
+void
+test_texture_residency (void)
+{
+  CoglTexture *tex_a, *tex_b;
+  size_t budget;
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  tex_a = create_purgeable_texture (0, 0xff0000ff);
+  draw_texture (tex_a, 0);
+  test_utils_check_pixel (test_fb, TEX_SIZE / 2, TEX_SIZE / 2, 0xff0000ff);
+
+  /* End the frame that used the first texture. test_fb may be
+   * offscreen so the frame is ended explicitly instead of swapping */
+  cogl_context_end_frame (test_ctx);
+
+  /* Leave room for half of another texture */
+  budget = cogl_context_get_texture_memory_usage (test_ctx) + TEX_BYTES / 2;
+  cogl_context_set_texture_memory_budget (test_ctx, budget);
+
+  /* Drawing a new texture twice in the same journal takes us over the
+   * budget. Nothing should be evicted until the end of the frame */
+  tex_b = create_purgeable_texture (1, 0x00ff00ff);
+  draw_texture (tex_b, 0);
+  draw_texture (tex_b, TEX_SIZE);
+  test_utils_check_pixel (test_fb, TEX_SIZE / 2, TEX_SIZE / 2, 0x00ff00ff);
+  test_utils_check_pixel (test_fb,
+                          TEX_SIZE * 3 / 2, TEX_SIZE / 2,
+                          0x00ff00ff);
+  g_assert_cmpuint (cogl_context_get_texture_memory_usage (test_ctx),
+                    >,
+                    budget);
+
+  /* Finishing the framebuffer doesn't end the frame */
+  cogl_framebuffer_finish (test_fb);
+  g_assert_cmpuint (cogl_context_get_texture_memory_usage (test_ctx),
+                    >,
+                    budget);
+
+  /* The first texture is idle so it gets evicted */
+  cogl_context_end_frame (test_ctx);
+  g_assert_cmpuint (cogl_context_get_texture_memory_usage (test_ctx),
+                    <=,
+                    budget);
+
+  /* Drawing it again should recreate it from the original data */
+  draw_texture (tex_a, 0);
+  test_utils_check_pixel (test_fb, TEX_SIZE / 2, TEX_SIZE / 2, 0xff0000ff);
+
+  /* And now the second texture is the idle one */
+  cogl_context_end_frame (test_ctx);
+  g_assert_cmpuint (cogl_context_get_texture_memory_usage (test_ctx),
+                    <=,
+                    budget);
+
+  cogl_context_set_texture_memory_budget (test_ctx, 0);
+
+  cogl_object_unref (tex_a);
+  cogl_object_unref (tex_b);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,144 @@
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-utils.h"
+
+/* Sub textures can't be repeated by the GPU. When GLSL is available
+ * the repeating is emulated in the fragment shader which means a
+ * sub texture can also be repeated on a layer other than the first
+ * one. This draws a rectangle with a repeated sub texture on the
+ * second layer and checks that the texels wrap around. The shader
+ * can't be used with a mipmap filter because fract() breaks the
+ * derivatives at the seams so that case should still be drawn
+ * correctly by splitting up the quad. */
+
+#define RECT_SIZE 8
+
+static const uint32_t
+source_colors[] =
+  {
+    0xff0000ff, /* red */
+    0x00ff00ff, /* green */
+    0x0000ffff, /* blue */
+    0xffffffff  /* white */
+  };
+
+static CoglTexture *
+create_sub_texture (void)
+{
+  uint32_t data[G_N_ELEMENTS (source_colors)];
+  CoglTexture2D *full_texture;
+  CoglSubTexture *sub_texture;
+  int i;
+
+  for (i = 0; i < G_N_ELEMENTS (source_colors); i++)
+    data[i] = GUINT32_TO_BE (source_colors[i]);
+
+  full_texture = cogl_texture_2d_new_from_data (test_ctx,
+                                                G_N_ELEMENTS (data), 1,
+                                                COGL_PIXEL_FORMAT_RGBA_8888,
+                                                sizeof (data),
+                                                (uint8_t *) data,
+                                                NULL);
+
+  /* Just the green and blue texels */
+  sub_texture = cogl_sub_texture_new (test_ctx,
+                                      full_texture,
+                                      1, 0, /* x, y */
+                                      2, 1 /* width, height */);
+
+  cogl_object_unref (full_texture);
+
+  return sub_texture;
+}
+
+static void
+check_repeated_texels (void)
+{
+  int i;
+
+  /* Each texel of the sub texture covers two pixels and it should
+     be repeated twice */
+  for (i = 0; i < 2; i++)
+    {
+      test_utils_check_pixel (test_fb,
+                              i * RECT_SIZE / 2, RECT_SIZE / 2,
+                              0x00ff00ff);
+      test_utils_check_pixel (test_fb,
+                              i * RECT_SIZE / 2 + RECT_SIZE / 2 - 1,
+                              RECT_SIZE / 2,
+                              0x0000ffff);
+    }
+}
+
+static void
+test_mipmap_filter (CoglTexture *sub_texture)
+{
+  CoglPipeline *pipeline = cogl_pipeline_new (test_ctx);
+
+  cogl_pipeline_set_layer_texture (pipeline, 0, sub_texture);
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST_MIPMAP_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+  cogl_framebuffer_draw_textured_rectangle (test_fb,
+                                            pipeline,
+                                            0, 0,
+                                            RECT_SIZE, RECT_SIZE,
+                                            0.0f, 0.0f, 2.0f, 1.0f);
+
+  check_repeated_texels ();
+
+  cogl_object_unref (pipeline);
+}
+
+void
+test_texture_shader_repeat (void)
+{
+  /* The first layer doesn't need repeating. The second layer
+     repeats the sub texture twice horizontally */
+  static const float tex_coords[] =
+    {
+      0.0f, 0.0f, 1.0f, 1.0f,
+      0.0f, 0.0f, 2.0f, 1.0f
+    };
+  CoglPipeline *pipeline;
+  CoglTexture *sub_texture;
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  sub_texture = create_sub_texture ();
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_layer_combine (pipeline, 0,
+                                   "RGBA = REPLACE (PRIMARY)",
+                                   NULL);
+  cogl_pipeline_set_layer_texture (pipeline, 1, sub_texture);
+  cogl_pipeline_set_layer_filters (pipeline, 1,
+                                   COGL_PIPELINE_FILTER_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+  cogl_framebuffer_draw_multitextured_rectangle (test_fb,
+                                                 pipeline,
+                                                 0, 0,
+                                                 RECT_SIZE, RECT_SIZE,
+                                                 tex_coords,
+                                                 G_N_ELEMENTS (tex_coords));
+
+  check_repeated_texels ();
+
+  cogl_object_unref (pipeline);
+
+  test_mipmap_filter (sub_texture);
+  cogl_object_unref (sub_texture);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
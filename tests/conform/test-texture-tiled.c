@@ -0,0 +1,170 @@
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-utils.h"
+
+/* This creates a tiled texture with a small maximum tile size so that
+ * it gets split into several tiles. It then draws it and checks that
+ * each pixel comes from the right tile. The size isn't a multiple of
+ * the tile size so the last column and row of tiles are only
+ * partially used. */
+
+#define TEX_WIDTH 11
+#define TEX_HEIGHT 7
+/* Including the border this gives each tile 2x2 pixels of the image */
+#define MAX_TILE_SIZE 4
+#define N_TILES_X ((TEX_WIDTH + 1) / 2)
+#define N_TILES_Y ((TEX_HEIGHT + 1) / 2)
+
+/* The number of times each pixel has been replaced */
+static int generations[TEX_WIDTH * TEX_HEIGHT];
+
+static uint32_t
+get_pixel_color (int x, int y, int generation)
+{
+  return (((x * 25) << 24) |
+          ((y * 40) << 16) |
+          ((generation * 100) << 8) |
+          0xff);
+}
+
+static void
+fill_data (uint8_t *data,
+           int x, int y,
+           int width, int height,
+           int generation)
+{
+  int bx, by;
+
+  for (by = 0; by < height; by++)
+    for (bx = 0; bx < width; bx++)
+      {
+        uint32_t color = get_pixel_color (x + bx, y + by, generation);
+        uint8_t *p = data + (by * width + bx) * 4;
+
+        p[0] = color >> 24;
+        p[1] = color >> 16;
+        p[2] = color >> 8;
+        p[3] = color;
+      }
+}
+
+static void
+draw_and_check (CoglPipeline *pipeline)
+{
+  int x, y;
+
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+  cogl_framebuffer_draw_rectangle (test_fb,
+                                   pipeline,
+                                   0, 0,
+                                   TEX_WIDTH, TEX_HEIGHT);
+
+  for (y = 0; y < TEX_HEIGHT; y++)
+    for (x = 0; x < TEX_WIDTH; x++)
+      test_utils_check_pixel (test_fb,
+                              x, y,
+                              get_pixel_color (x, y,
+                                               generations[y * TEX_WIDTH +
+                                                           x]));
+}
+
+static void
+update_region (CoglTextureTiled *tex_tiled,
+               int update_x, int update_y,
+               int update_width, int update_height)
+{
+  uint8_t data[TEX_WIDTH * TEX_HEIGHT * 4];
+  CoglBitmap *bitmap;
+  CoglError *error = NULL;
+  int x, y;
+
+  for (y = update_y; y < update_y + update_height; y++)
+    for (x = update_x; x < update_x + update_width; x++)
+      generations[y * TEX_WIDTH + x]++;
+
+  /* The regions that the test updates don't overlap so all of the
+     pixels in a region have the same generation */
+  fill_data (data,
+             update_x, update_y,
+             update_width, update_height,
+             generations[update_y * TEX_WIDTH + update_x]);
+  bitmap = cogl_bitmap_new_for_data (test_ctx,
+                                     update_width, update_height,
+                                     COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                     update_width * 4,
+                                     data);
+  if (!cogl_texture_set_region_from_bitmap (tex_tiled,
+                                            0, 0, /* src_x/y */
+                                            update_width, update_height,
+                                            bitmap,
+                                            update_x, update_y,
+                                            0, /* level */
+                                            &error))
+    g_error ("Failed to set region: %s", error->message);
+  cogl_object_unref (bitmap);
+}
+
+void
+test_texture_tiled (void)
+{
+  uint8_t data[TEX_WIDTH * TEX_HEIGHT * 4];
+  CoglTextureTiled *tex_tiled;
+  CoglBitmap *bitmap;
+  CoglPipeline *pipeline;
+  CoglError *error = NULL;
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  memset (generations, 0, sizeof (generations));
+  fill_data (data, 0, 0, TEX_WIDTH, TEX_HEIGHT, 0);
+
+  bitmap = cogl_bitmap_new_for_data (test_ctx,
+                                     TEX_WIDTH, TEX_HEIGHT,
+                                     COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                     TEX_WIDTH * 4,
+                                     data);
+  tex_tiled = cogl_texture_tiled_new_from_bitmap (bitmap);
+  cogl_object_unref (bitmap);
+
+  cogl_texture_tiled_set_max_tile_size (tex_tiled, MAX_TILE_SIZE);
+
+  if (!cogl_texture_allocate (tex_tiled, &error))
+    g_error ("Failed to allocate tiled texture: %s", error->message);
+
+  g_assert (cogl_is_texture_tiled (tex_tiled));
+  g_assert_cmpint (cogl_texture_tiled_get_n_tiles (tex_tiled),
+                   ==,
+                   N_TILES_X * N_TILES_Y);
+  g_assert (!cogl_texture_is_sliced (tex_tiled));
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_layer_texture (pipeline, 0, tex_tiled);
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+
+  draw_and_check (pipeline);
+
+  /* Replace a region that spans the corners of four tiles. The
+     borders of the neighbouring tiles need updating as well but that
+     won't show up with nearest filtering */
+  update_region (tex_tiled, 3, 1, 4, 3);
+  draw_and_check (pipeline);
+
+  /* Replace a region that covers the partially used tiles in the
+     bottom-right corner */
+  update_region (tex_tiled, 8, 4, 3, 3);
+  draw_and_check (pipeline);
+
+  cogl_object_unref (pipeline);
+  cogl_object_unref (tex_tiled);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
@@ -0,0 +1,300 @@
+#include <cogl/cogl.h>
+#include <string.h>
+
+#include "test-utils.h"
+
+/* This uses a virtual texture with a synthetic loader that fills each
+ * tile with a colour that identifies it. It checks that the tiles
+ * are streamed in a few at a time, that missing tiles are drawn from
+ * the top of the pyramid until a later draw picks them up, that tiles
+ * that aren't ready are retried and that the least recently used
+ * tiles are evicted. */
+
+#define TEX_SIZE 16
+#define TILE_SIZE 4
+#define N_TILES (TEX_SIZE / TILE_SIZE)
+#define TOP_LEVEL 2
+
+typedef struct
+{
+  int n_loads;
+  CoglBool last_tile_ready;
+} TestState;
+
+static uint32_t
+get_tile_color (int level, int tile_x, int tile_y)
+{
+  return (((level + 1) * 0x40) << 24) |
+    ((tile_x * 0x40) << 16) |
+    ((tile_y * 0x40) << 8) |
+    0xff;
+}
+
+static CoglBool
+load_tile (int level,
+           int tile_x,
+           int tile_y,
+           int width,
+           int height,
+           uint8_t *data,
+           int rowstride,
+           void *user_data)
+{
+  TestState *state = user_data;
+  uint32_t color = get_tile_color (level, tile_x, tile_y);
+  int x, y;
+
+  g_atomic_int_inc (&state->n_loads);
+
+  if (level == 0 &&
+      tile_x == N_TILES - 1 &&
+      tile_y == N_TILES - 1 &&
+      !g_atomic_int_get (&state->last_tile_ready))
+    return FALSE;
+
+  for (y = 0; y < height; y++)
+    for (x = 0; x < width; x++)
+      {
+        uint8_t *p = data + y * rowstride + x * 4;
+
+        p[0] = color >> 24;
+        p[1] = color >> 16;
+        p[2] = color >> 8;
+        p[3] = color;
+      }
+
+  return TRUE;
+}
+
+static void
+draw (CoglVirtualTexture *virtual_texture,
+      CoglPipeline *pipeline,
+      int size,
+      float s_1, float t_1,
+      float s_2, float t_2)
+{
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+  cogl_virtual_texture_draw (virtual_texture,
+                             test_fb,
+                             pipeline,
+                             0, 0, size, size,
+                             s_1, t_1, s_2, t_2);
+}
+
+static void
+check_tile (int level,
+            int tile_x, int tile_y,
+            CoglBool resident)
+{
+  /* The level is always picked so that one texel covers one pixel */
+  test_utils_check_pixel (test_fb,
+                          tile_x * TILE_SIZE + TILE_SIZE / 2,
+                          tile_y * TILE_SIZE + TILE_SIZE / 2,
+                          resident ?
+                          get_tile_color (level, tile_x, tile_y) :
+                          get_tile_color (TOP_LEVEL, 0, 0));
+}
+
+static void
+draw_and_wait (CoglVirtualTexture *virtual_texture,
+               CoglPipeline *pipeline,
+               int size,
+               float s_1, float t_1,
+               float s_2, float t_2)
+{
+  draw (virtual_texture, pipeline, size, s_1, t_1, s_2, t_2);
+  cogl_virtual_texture_wait_for_loads (virtual_texture);
+}
+
+static void
+test_streaming (CoglPipeline *pipeline)
+{
+  TestState state = { 0, FALSE };
+  CoglVirtualTexture *virtual_texture;
+  int tile_x, tile_y;
+  int i;
+
+  virtual_texture = cogl_virtual_texture_new (test_ctx,
+                                              TEX_SIZE, TEX_SIZE,
+                                              TILE_SIZE,
+                                              COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                              load_tile,
+                                              &state);
+  cogl_virtual_texture_set_max_loads_per_draw (virtual_texture, 4);
+
+  g_assert (cogl_is_virtual_texture (virtual_texture));
+  g_assert_cmpint (cogl_virtual_texture_get_n_levels (virtual_texture),
+                   ==,
+                   TOP_LEVEL + 1);
+
+  /* The first draw waits for the top of the pyramid because there is
+     nothing else to draw from. The first four tiles are only started
+     so everything is drawn from the top */
+  draw (virtual_texture, pipeline, TEX_SIZE, 0.0f, 0.0f, 1.0f, 1.0f);
+
+  for (tile_y = 0; tile_y < N_TILES; tile_y++)
+    for (tile_x = 0; tile_x < N_TILES; tile_x++)
+      check_tile (0, tile_x, tile_y, FALSE);
+
+  cogl_virtual_texture_wait_for_loads (virtual_texture);
+
+  g_assert_cmpint (state.n_loads, ==, 5);
+  g_assert_cmpint (cogl_virtual_texture_get_n_resident_tiles (virtual_texture),
+                   ==,
+                   5);
+
+  /* The next draw uses them and starts the next four */
+  draw_and_wait (virtual_texture, pipeline,
+                 TEX_SIZE, 0.0f, 0.0f, 1.0f, 1.0f);
+
+  g_assert_cmpint (state.n_loads, ==, 9);
+
+  for (tile_y = 0; tile_y < N_TILES; tile_y++)
+    for (tile_x = 0; tile_x < N_TILES; tile_x++)
+      check_tile (0, tile_x, tile_y, tile_y == 0);
+
+  /* Two more draws load all but the last tile because the loader
+     reports that it isn't ready yet. It is tried again by every
+     draw */
+  for (i = 0; i < 2; i++)
+    draw_and_wait (virtual_texture, pipeline,
+                   TEX_SIZE, 0.0f, 0.0f, 1.0f, 1.0f);
+
+  g_assert_cmpint (state.n_loads, ==, 17);
+  g_assert_cmpint (cogl_virtual_texture_get_n_resident_tiles (virtual_texture),
+                   ==,
+                   16);
+
+  draw_and_wait (virtual_texture, pipeline,
+                 TEX_SIZE, 0.0f, 0.0f, 1.0f, 1.0f);
+
+  g_assert_cmpint (state.n_loads, ==, 18);
+  g_assert_cmpint (cogl_virtual_texture_get_n_resident_tiles (virtual_texture),
+                   ==,
+                   16);
+
+  for (tile_y = 0; tile_y < N_TILES; tile_y++)
+    for (tile_x = 0; tile_x < N_TILES; tile_x++)
+      check_tile (0, tile_x, tile_y,
+                  tile_x != N_TILES - 1 || tile_y != N_TILES - 1);
+
+  /* Once it is ready the retry succeeds */
+  state.last_tile_ready = TRUE;
+  draw_and_wait (virtual_texture, pipeline,
+                 TEX_SIZE, 0.0f, 0.0f, 1.0f, 1.0f);
+  draw (virtual_texture, pipeline, TEX_SIZE, 0.0f, 0.0f, 1.0f, 1.0f);
+
+  g_assert_cmpint (state.n_loads, ==, 19);
+
+  for (tile_y = 0; tile_y < N_TILES; tile_y++)
+    for (tile_x = 0; tile_x < N_TILES; tile_x++)
+      check_tile (0, tile_x, tile_y, TRUE);
+
+  /* Drawing at half the size should use the next level */
+  draw_and_wait (virtual_texture, pipeline,
+                 TEX_SIZE / 2, 0.0f, 0.0f, 1.0f, 1.0f);
+  draw (virtual_texture, pipeline, TEX_SIZE / 2, 0.0f, 0.0f, 1.0f, 1.0f);
+
+  g_assert_cmpint (state.n_loads, ==, 23);
+  g_assert_cmpint (cogl_virtual_texture_get_n_resident_tiles (virtual_texture),
+                   ==,
+                   21);
+
+  for (tile_y = 0; tile_y < N_TILES / 2; tile_y++)
+    for (tile_x = 0; tile_x < N_TILES / 2; tile_x++)
+      check_tile (1, tile_x, tile_y, TRUE);
+
+  cogl_object_unref (virtual_texture);
+}
+
+static void
+test_eviction (CoglPipeline *pipeline)
+{
+  TestState state = { 0, TRUE };
+  CoglVirtualTexture *virtual_texture;
+
+  virtual_texture = cogl_virtual_texture_new (test_ctx,
+                                              TEX_SIZE, TEX_SIZE,
+                                              TILE_SIZE,
+                                              COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                              load_tile,
+                                              &state);
+  cogl_virtual_texture_set_cache_size (virtual_texture, 3);
+  cogl_virtual_texture_set_max_loads_per_draw (virtual_texture, 4);
+
+  /* There is only room for the top and two other tiles. The tiles
+     that are drawn can't be evicted to make room for the third */
+  draw_and_wait (virtual_texture, pipeline,
+                 TEX_SIZE, 0.0f, 0.0f, 1.0f, 1.0f);
+  draw (virtual_texture, pipeline, TEX_SIZE, 0.0f, 0.0f, 1.0f, 1.0f);
+
+  g_assert_cmpint (state.n_loads, ==, 3);
+  g_assert_cmpint (cogl_virtual_texture_get_n_resident_tiles (virtual_texture),
+                   ==,
+                   3);
+  check_tile (0, 0, 0, TRUE);
+  check_tile (0, 1, 0, TRUE);
+  check_tile (0, 2, 0, FALSE);
+
+  /* Drawing the bottom-right quarter at full resolution should evict
+     the tiles from the previous draw but not the top */
+  draw_and_wait (virtual_texture, pipeline,
+                 TEX_SIZE / 2, 0.5f, 0.5f, 1.0f, 1.0f);
+  draw (virtual_texture, pipeline, TEX_SIZE / 2, 0.5f, 0.5f, 1.0f, 1.0f);
+
+  g_assert_cmpint (state.n_loads, ==, 5);
+  g_assert_cmpint (cogl_virtual_texture_get_n_resident_tiles (virtual_texture),
+                   ==,
+                   3);
+  test_utils_check_pixel (test_fb,
+                          TILE_SIZE / 2, TILE_SIZE / 2,
+                          get_tile_color (0, 2, 2));
+  test_utils_check_pixel (test_fb,
+                          TILE_SIZE + TILE_SIZE / 2, TILE_SIZE / 2,
+                          get_tile_color (0, 3, 2));
+  test_utils_check_pixel (test_fb,
+                          TILE_SIZE / 2, TILE_SIZE + TILE_SIZE / 2,
+                          get_tile_color (TOP_LEVEL, 0, 0));
+
+  /* Going back to the top-left quarter has to load the first tiles
+     again */
+  draw_and_wait (virtual_texture, pipeline,
+                 TEX_SIZE / 2, 0.0f, 0.0f, 0.5f, 0.5f);
+  draw (virtual_texture, pipeline, TEX_SIZE / 2, 0.0f, 0.0f, 0.5f, 0.5f);
+
+  g_assert_cmpint (state.n_loads, ==, 7);
+  g_assert_cmpint (cogl_virtual_texture_get_n_resident_tiles (virtual_texture),
+                   ==,
+                   3);
+  check_tile (0, 0, 0, TRUE);
+  check_tile (0, 1, 0, TRUE);
+  check_tile (0, 0, 1, FALSE);
+
+  cogl_object_unref (virtual_texture);
+}
+
+void
+test_virtual_texture (void)
+{
+  CoglPipeline *pipeline;
+
+  cogl_framebuffer_orthographic (test_fb,
+                                 0, 0,
+                                 cogl_framebuffer_get_width (test_fb),
+                                 cogl_framebuffer_get_height (test_fb),
+                                 -1,
+                                 100);
+
+  pipeline = cogl_pipeline_new (test_ctx);
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_NEAREST,
+                                   COGL_PIPELINE_FILTER_NEAREST);
+
+  test_streaming (pipeline);
+  test_eviction (pipeline);
+
+  cogl_object_unref (pipeline);
+
+  if (cogl_test_verbose ())
+    g_print ("OK\n");
+}
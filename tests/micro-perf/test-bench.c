@@ -0,0 +1,938 @@
+/*
+ * A headless benchmark suite for the CPU side of Cogl.
+ *
+ * This is intended to be run with the nop driver and the stub winsys
+ * so that the results only reflect the work done by Cogl itself and
+ * not the GPU or the GL driver. If COGL_DRIVER and COGL_RENDERER
+ * aren't set in the environment they default to "nop" and "stub".
+ *
+ * Each benchmark is run for a number of iterations and the median,
+ * 99th percentile and minimum time of an iteration are written to
+ * stdout as JSON so that results can easily be compared between
+ * runs. Any command line arguments are used as substrings to select
+ * which benchmarks to run.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cogl/cogl.h>
+#ifdef COGL_HAS_COGL_PATH_SUPPORT
+#include <cogl-path/cogl-path.h>
+#endif
+#ifdef HAVE_COGL_PANGO
+#include <cogl-pango/cogl-pango.h>
+#endif
+/* The atlas isn't public API but it is exported for cogl-pango so we
+ * can still use it to measure the rectangle packing. The pipeline
+ * hashing and comparison functions are only exported for this
+ * benchmark so they can be measured without going through the
+ * journal */
+#define __COGL_H_INSIDE__
+#include "cogl/cogl-atlas.h"
+#define COGL_COMPILATION
+#include "cogl/cogl-pipeline-private.h"
+#undef COGL_COMPILATION
+#undef __COGL_H_INSIDE__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <math.h>
+
+#define FRAMEBUFFER_WIDTH 800
+#define FRAMEBUFFER_HEIGHT 600
+
+#define N_ITERATIONS 200
+
+typedef struct _Data
+{
+  CoglContext *ctx;
+  CoglFramebuffer *fb;
+  CoglPipeline *pipeline;
+} Data;
+
+typedef int64_t (* BenchFunc) (Data *data);
+
+typedef struct _Bench
+{
+  const char *name;
+  BenchFunc func;
+} Bench;
+
+static int64_t
+get_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * (int64_t) 1000000000 + ts.tv_nsec;
+}
+
+static void
+draw_rectangles (Data *data, CoglPipeline *pipeline, int rect_size)
+{
+  int x, y;
+
+  for (y = 0; y < FRAMEBUFFER_HEIGHT; y += rect_size)
+    for (x = 0; x < FRAMEBUFFER_WIDTH; x += rect_size)
+      cogl_framebuffer_draw_rectangle (data->fb,
+                                       pipeline,
+                                       x, y,
+                                       x + rect_size, y + rect_size);
+}
+
+/* Time logging rectangles into the journal without flushing */
+static int64_t
+bench_journal_log (Data *data)
+{
+  int64_t start, end;
+
+  start = get_time ();
+  draw_rectangles (data, data->pipeline, 10);
+  end = get_time ();
+
+  cogl_framebuffer_finish (data->fb);
+
+  return end - start;
+}
+
+/* Time flushing a full journal */
+static int64_t
+bench_journal_flush (Data *data)
+{
+  int64_t start;
+
+  draw_rectangles (data, data->pipeline, 10);
+
+  start = get_time ();
+  cogl_framebuffer_finish (data->fb);
+
+  return get_time () - start;
+}
+
+/* Rectangles that each have a different modelview so the journal
+ * has to transform the vertices in software */
+static int64_t
+bench_journal_transformed (Data *data)
+{
+  int64_t start;
+  int i;
+
+  start = get_time ();
+
+  for (i = 0; i < 2000; i++)
+    {
+      cogl_framebuffer_push_matrix (data->fb);
+      cogl_framebuffer_translate (data->fb, i % FRAMEBUFFER_WIDTH, i / 4, 0);
+      cogl_framebuffer_rotate (data->fb, i, 0, 0, 1);
+      cogl_framebuffer_draw_rectangle (data->fb, data->pipeline,
+                                       -5, -5, 5, 5);
+      cogl_framebuffer_pop_matrix (data->fb);
+    }
+
+  cogl_framebuffer_finish (data->fb);
+
+  return get_time () - start;
+}
+
+static int64_t
+bench_pipeline_copy (Data *data)
+{
+  int64_t start;
+  int i;
+
+  start = get_time ();
+
+  for (i = 0; i < 1000; i++)
+    {
+      CoglPipeline *copy = cogl_pipeline_copy (data->pipeline);
+
+      cogl_pipeline_set_color4f (copy, i / 1000.0f, 0, 0, 1);
+      cogl_object_unref (copy);
+    }
+
+  return get_time () - start;
+}
+
+/* Every rectangle uses a separate but equivalent pipeline so the
+ * journal has to compare the pipelines to be able to batch them */
+static int64_t
+bench_pipeline_compare (Data *data)
+{
+  CoglPipeline *copies[64];
+  int64_t start, elapsed;
+  int i;
+
+  for (i = 0; i < 64; i++)
+    copies[i] = cogl_pipeline_copy (data->pipeline);
+
+  start = get_time ();
+
+  for (i = 0; i < 4800; i++)
+    {
+      int x = (i % 80) * 10;
+      int y = (i / 80) * 10;
+
+      cogl_framebuffer_draw_rectangle (data->fb, copies[i % 64],
+                                       x, y, x + 10, y + 10);
+    }
+
+  cogl_framebuffer_finish (data->fb);
+
+  elapsed = get_time () - start;
+
+  for (i = 0; i < 64; i++)
+    cogl_object_unref (copies[i]);
+
+  return elapsed;
+}
+
+/* Applications often set the same few blend strings on every frame
+ * so this measures setting them repeatedly on a pipeline */
+static int64_t
+bench_pipeline_set_blend (Data *data)
+{
+  static const char * const blend_strings[] =
+    {
+      "RGBA = ADD (SRC_COLOR, DST_COLOR * (1 - SRC_COLOR[A]))",
+      "RGBA = ADD (SRC_COLOR, DST_COLOR)",
+      "RGB = ADD (SRC_COLOR, DST_COLOR * (1 - SRC_COLOR[A])) "
+      "A = ADD (SRC_COLOR, DST_COLOR)"
+    };
+  static const char * const combine_strings[] =
+    {
+      "RGBA = MODULATE (PREVIOUS, TEXTURE)",
+      "RGBA = REPLACE (TEXTURE)",
+      "RGB = MODULATE (PREVIOUS, TEXTURE) A = REPLACE (PREVIOUS)"
+    };
+  int64_t start;
+  int i, j;
+
+  start = get_time ();
+
+  for (i = 0; i < 1000; i++)
+    {
+      CoglPipeline *copy = cogl_pipeline_copy (data->pipeline);
+
+      for (j = 0; j < 16; j++)
+        {
+          int n = (i + j / 4) % (int) G_N_ELEMENTS (blend_strings);
+
+          cogl_pipeline_set_blend (copy, blend_strings[n], NULL);
+          cogl_pipeline_set_layer_combine (copy, 0, combine_strings[n], NULL);
+        }
+
+      cogl_object_unref (copy);
+    }
+
+  return get_time () - start;
+}
+
+/* The state that the journal compares to decide whether two
+ * rectangles can be batched */
+#define JOURNAL_PIPELINE_STATE \
+  (COGL_PIPELINE_STATE_ALL & ~COGL_PIPELINE_STATE_COLOR)
+
+/* The state that the pipeline cache hashes to look up a program. Not
+ * all state can be hashed so this is used instead of the journal
+ * state for the hash benchmark */
+#define PROGRAM_PIPELINE_STATE \
+  (COGL_PIPELINE_STATE_LAYERS | \
+   COGL_PIPELINE_STATE_ALPHA_FUNC | \
+   COGL_PIPELINE_STATE_PER_VERTEX_POINT_SIZE | \
+   COGL_PIPELINE_STATE_VERTEX_SNIPPETS | \
+   COGL_PIPELINE_STATE_FRAGMENT_SNIPPETS)
+#define PROGRAM_LAYER_STATE \
+  (COGL_PIPELINE_LAYER_STATE_UNIT | \
+   COGL_PIPELINE_LAYER_STATE_TEXTURE_TYPE | \
+   COGL_PIPELINE_LAYER_STATE_COMBINE | \
+   COGL_PIPELINE_LAYER_STATE_VERTEX_SNIPPETS | \
+   COGL_PIPELINE_LAYER_STATE_FRAGMENT_SNIPPETS)
+
+#define N_KEY_PIPELINES 64
+
+/* The hash values are stored here so that the calls can't be
+ * optimized away */
+static volatile unsigned int hash_result;
+
+/* Creates pipelines with a typical amount of state that are all
+ * equivalent but are separate copies so that hashing or comparing
+ * them has to look up the authority of each state group */
+static void
+create_key_pipelines (Data *data, CoglPipeline **pipelines)
+{
+  int i;
+
+  for (i = 0; i < N_KEY_PIPELINES; i++)
+    {
+      CoglPipeline *pipeline = cogl_pipeline_copy (data->pipeline);
+
+      cogl_pipeline_set_blend (pipeline,
+                               "RGBA = ADD (SRC_COLOR, DST_COLOR)",
+                               NULL);
+      cogl_pipeline_set_layer_null_texture (pipeline,
+                                            0,
+                                            COGL_TEXTURE_TYPE_2D);
+      cogl_pipeline_set_layer_filters (pipeline,
+                                       0,
+                                       COGL_PIPELINE_FILTER_LINEAR,
+                                       COGL_PIPELINE_FILTER_LINEAR);
+      cogl_pipeline_set_layer_combine (pipeline,
+                                       1,
+                                       "RGBA = MODULATE (PREVIOUS, "
+                                       "PRIMARY)",
+                                       NULL);
+
+      pipelines[i] = pipeline;
+    }
+}
+
+static void
+free_key_pipelines (CoglPipeline **pipelines)
+{
+  int i;
+
+  for (i = 0; i < N_KEY_PIPELINES; i++)
+    cogl_object_unref (pipelines[i]);
+}
+
+/* Calls _cogl_pipeline_hash directly as the pipeline cache does
+ * for each new pipeline without any of the drawing overhead */
+static int64_t
+bench_pipeline_hash (Data *data)
+{
+  CoglPipeline *pipelines[N_KEY_PIPELINES];
+  int64_t start, elapsed;
+  int i;
+
+  create_key_pipelines (data, pipelines);
+
+  start = get_time ();
+
+  for (i = 0; i < 10000; i++)
+    hash_result = _cogl_pipeline_hash (pipelines[i % N_KEY_PIPELINES],
+                                       PROGRAM_PIPELINE_STATE,
+                                       PROGRAM_LAYER_STATE,
+                                       0);
+
+  elapsed = get_time () - start;
+
+  free_key_pipelines (pipelines);
+
+  return elapsed;
+}
+
+/* Calls _cogl_pipeline_equal directly on neighbouring pipelines as
+ * the journal does for each rectangle */
+static int64_t
+bench_pipeline_equal (Data *data)
+{
+  CoglPipeline *pipelines[N_KEY_PIPELINES];
+  int64_t start, elapsed;
+  int n_equal = 0;
+  int i;
+
+  create_key_pipelines (data, pipelines);
+
+  start = get_time ();
+
+  for (i = 0; i < 10000; i++)
+    n_equal += _cogl_pipeline_equal (pipelines[i % N_KEY_PIPELINES],
+                                     pipelines[(i + 1) % N_KEY_PIPELINES],
+                                     JOURNAL_PIPELINE_STATE,
+                                     COGL_PIPELINE_LAYER_STATE_ALL,
+                                     0);
+
+  elapsed = get_time () - start;
+
+  g_warn_if_fail (n_equal == 10000);
+
+  free_key_pipelines (pipelines);
+
+  return elapsed;
+}
+
+static int64_t
+bench_matrix_stack (Data *data)
+{
+  CoglMatrixStack *stack = cogl_matrix_stack_new (data->ctx);
+  CoglMatrix matrix;
+  int64_t start, elapsed;
+  int i;
+
+  start = get_time ();
+
+  for (i = 0; i < 1000; i++)
+    {
+      cogl_matrix_stack_push (stack);
+      cogl_matrix_stack_translate (stack, i, i * 2, 0);
+      cogl_matrix_stack_rotate (stack, i, 0, 0, 1);
+      cogl_matrix_stack_scale (stack, 2, 2, 1);
+      cogl_matrix_stack_get (stack, &matrix);
+      cogl_matrix_stack_pop (stack);
+    }
+
+  elapsed = get_time () - start;
+
+  cogl_object_unref (stack);
+
+  return elapsed;
+}
+
+/* Nested rectangle clips which the journal can apply to the
+ * rectangles on the CPU */
+static int64_t
+bench_clip_stack (Data *data)
+{
+  int64_t start;
+  int i, j;
+
+  start = get_time ();
+
+  for (i = 0; i < 100; i++)
+    {
+      for (j = 0; j < 4; j++)
+        cogl_framebuffer_push_rectangle_clip (data->fb,
+                                              j * 10 + i,
+                                              j * 10,
+                                              FRAMEBUFFER_WIDTH - j * 10,
+                                              FRAMEBUFFER_HEIGHT - j * 10);
+
+      for (j = 0; j < 20; j++)
+        cogl_framebuffer_draw_rectangle (data->fb, data->pipeline,
+                                         j * 40, j * 30,
+                                         j * 40 + 60, j * 30 + 60);
+
+      for (j = 0; j < 4; j++)
+        cogl_framebuffer_pop_clip (data->fb);
+    }
+
+  cogl_framebuffer_finish (data->fb);
+
+  return get_time () - start;
+}
+
+#ifdef COGL_HAS_COGL_PATH_SUPPORT
+/* A fresh path is created for every iteration because the
+ * tessellated primitive is cached on the path */
+static int64_t
+bench_path_tessellate (Data *data)
+{
+  CoglPath *path;
+  int64_t start, elapsed;
+  int i;
+
+  start = get_time ();
+
+  path = cogl_path_new (data->ctx);
+
+  cogl_path_move_to (path, 400, 100);
+  for (i = 1; i < 64; i++)
+    {
+      float angle = i * G_PI * 2 * 5 / 64;
+      float radius = (i & 1) ? 100 : 250;
+
+      cogl_path_line_to (path,
+                         400 + sinf (angle) * radius,
+                         300 - cosf (angle) * radius);
+    }
+  cogl_path_close (path);
+
+  cogl_path_ellipse (path, 200, 200, 80, 50);
+  cogl_path_round_rectangle (path, 500, 400, 700, 550, 20, 10);
+
+  cogl_path_fill (path, data->fb, data->pipeline);
+  cogl_framebuffer_finish (data->fb);
+
+  elapsed = get_time () - start;
+
+  cogl_object_unref (path);
+
+  return elapsed;
+}
+
+/* Something closer to real SVG content: a long wobbly coastline
+ * outline like a map would have plus a row of glyph-like shapes made
+ * from cubic curves with holes cut out of them. This creates a lot of
+ * vertices and self-intersections so it mostly measures the time
+ * spent inside the tesselator */
+static int64_t
+fill_svg_path (Data *data, CoglPathFillStrategy strategy)
+{
+  CoglPath *path;
+  int64_t start, elapsed;
+  int i;
+
+  start = get_time ();
+
+  path = cogl_path_new (data->ctx);
+  cogl_path_set_fill_strategy (path, strategy);
+
+  cogl_path_move_to (path, 400, 50);
+  for (i = 1; i < 1000; i++)
+    {
+      float angle = i * G_PI * 2 / 1000;
+      float radius = 220 + sinf (angle * 37) * 20 + sinf (angle * 113) * 8;
+
+      cogl_path_line_to (path,
+                         400 + sinf (angle) * radius * 1.5f,
+                         300 - cosf (angle) * radius);
+    }
+  cogl_path_close (path);
+
+  for (i = 0; i < 16; i++)
+    {
+      float x = 40 + i * 45, y = 500;
+
+      /* Outer contour of an 'o'-like glyph */
+      cogl_path_move_to (path, x + 20, y);
+      cogl_path_curve_to (path, x + 35, y, x + 40, y + 15, x + 40, y + 30);
+      cogl_path_curve_to (path, x + 40, y + 45, x + 35, y + 60, x + 20, y + 60);
+      cogl_path_curve_to (path, x + 5, y + 60, x, y + 45, x, y + 30);
+      cogl_path_curve_to (path, x, y + 15, x + 5, y, x + 20, y);
+      cogl_path_close (path);
+
+      /* Counter in the opposite direction */
+      cogl_path_move_to (path, x + 20, y + 10);
+      cogl_path_curve_to (path, x + 12, y + 10, x + 10, y + 20, x + 10, y + 30);
+      cogl_path_curve_to (path, x + 10, y + 40, x + 12, y + 50, x + 20, y + 50);
+      cogl_path_curve_to (path, x + 28, y + 50, x + 30, y + 40, x + 30, y + 30);
+      cogl_path_curve_to (path, x + 30, y + 20, x + 28, y + 10, x + 20, y + 10);
+      cogl_path_close (path);
+    }
+
+  cogl_path_fill (path, data->fb, data->pipeline);
+  cogl_framebuffer_finish (data->fb);
+
+  elapsed = get_time () - start;
+
+  cogl_object_unref (path);
+
+  return elapsed;
+}
+
+static int64_t
+bench_path_tessellate_svg (Data *data)
+{
+  return fill_svg_path (data, COGL_PATH_FILL_STRATEGY_TESSELATE);
+}
+
+/* The same path filled with the stencil buffer instead of the
+ * tesselator as a map that changes every frame would do */
+static int64_t
+bench_path_stencil_svg (Data *data)
+{
+  return fill_svg_path (data, COGL_PATH_FILL_STRATEGY_STENCIL);
+}
+
+/* Strokes a wobbly outline and a grid of polylines with a width, as
+ * for the roads and borders of a map. Each iteration uses a new path
+ * so this includes building the stroke geometry */
+static int64_t
+bench_path_stroke_wide (Data *data)
+{
+  CoglPath *path;
+  int64_t start, elapsed;
+  int i, j;
+
+  start = get_time ();
+
+  path = cogl_path_new (data->ctx);
+  cogl_path_set_stroke_width (path, 3);
+  cogl_path_set_line_join (path, COGL_PATH_LINE_JOIN_ROUND);
+  cogl_path_set_line_cap (path, COGL_PATH_LINE_CAP_ROUND);
+
+  cogl_path_move_to (path, 400, 50);
+  for (i = 1; i < 1000; i++)
+    {
+      float angle = i * G_PI * 2 / 1000;
+      float radius = 220 + sinf (angle * 37) * 20 + sinf (angle * 113) * 8;
+
+      cogl_path_line_to (path,
+                         400 + sinf (angle) * radius * 1.5f,
+                         300 - cosf (angle) * radius);
+    }
+  cogl_path_close (path);
+
+  for (i = 0; i < 20; i++)
+    {
+      cogl_path_move_to (path, 20, 20 + i * 28);
+      for (j = 1; j < 40; j++)
+        cogl_path_line_to (path, 20 + j * 19, 20 + i * 28 + (j & 1) * 10);
+    }
+
+  cogl_path_stroke (path, data->fb, data->pipeline);
+  cogl_framebuffer_finish (data->fb);
+
+  elapsed = get_time () - start;
+
+  cogl_object_unref (path);
+
+  return elapsed;
+}
+
+/* A typical UI made of lots of buttons and panels with rounded
+ * corners. Each one is a separate convex path so this measures the
+ * per-path cost of building the fill */
+static int64_t
+bench_path_round_rects (Data *data)
+{
+  int64_t start, elapsed;
+  int x, y;
+
+  start = get_time ();
+
+  for (y = 0; y < 12; y++)
+    for (x = 0; x < 10; x++)
+      {
+        CoglPath *path = cogl_path_new (data->ctx);
+
+        cogl_path_round_rectangle (path,
+                                   x * 80 + 4, y * 50 + 4,
+                                   x * 80 + 76, y * 50 + 46,
+                                   8 + (x + y) % 4 * 2, /* radius */
+                                   10 /* arc step */);
+        cogl_path_fill (path, data->fb, data->pipeline);
+
+        cogl_object_unref (path);
+      }
+
+  cogl_framebuffer_finish (data->fb);
+
+  elapsed = get_time () - start;
+
+  return elapsed;
+}
+
+/* Builds paths made of large curves, as found in icons and glyph
+ * outlines, without drawing them. This measures the cost of
+ * flattening the curves into nodes */
+static int64_t
+bench_path_flatten (Data *data)
+{
+  int64_t start, elapsed;
+  int i, j;
+
+  start = get_time ();
+
+  for (i = 0; i < 100; i++)
+    {
+      CoglPath *path = cogl_path_new (data->ctx);
+
+      cogl_path_move_to (path, 0, FRAMEBUFFER_HEIGHT / 2);
+
+      for (j = 0; j < 100; j++)
+        {
+          float x = j * FRAMEBUFFER_WIDTH / 100.0f;
+          float w = FRAMEBUFFER_WIDTH / 100.0f;
+
+          cogl_path_curve_to (path,
+                              x + w / 3, (j + i) % 7 * 100,
+                              x + w * 2 / 3, FRAMEBUFFER_HEIGHT -
+                              (j + i) % 5 * 120,
+                              x + w, FRAMEBUFFER_HEIGHT / 2);
+        }
+
+      cogl_object_unref (path);
+    }
+
+  elapsed = get_time () - start;
+
+  return elapsed;
+}
+#endif /* COGL_HAS_COGL_PATH_SUPPORT */
+
+/* Creating a premultiplied texture from unpremultiplied BGRA data
+ * needs a format and premultiplication conversion on the CPU */
+static int64_t
+bench_bitmap_convert (Data *data)
+{
+  static uint8_t *pixels = NULL;
+  CoglBitmap *bitmap;
+  CoglTexture *tex;
+  int64_t start, elapsed;
+
+  if (pixels == NULL)
+    {
+      int i;
+
+      pixels = g_malloc (512 * 512 * 4);
+      for (i = 0; i < 512 * 512 * 4; i++)
+        pixels[i] = i * 7;
+    }
+
+  bitmap = cogl_bitmap_new_for_data (data->ctx,
+                                     512, 512,
+                                     COGL_PIXEL_FORMAT_BGRA_8888,
+                                     512 * 4,
+                                     pixels);
+
+  start = get_time ();
+
+  tex = cogl_texture_2d_new_from_bitmap (bitmap);
+  cogl_texture_set_premultiplied (tex, TRUE);
+  cogl_texture_allocate (tex, NULL);
+
+  elapsed = get_time () - start;
+
+  cogl_object_unref (tex);
+  cogl_object_unref (bitmap);
+
+  return elapsed;
+}
+
+static void
+atlas_update_position_cb (void *user_data,
+                          CoglTexture *new_texture,
+                          const CoglRectangleMapEntry *rect)
+{
+}
+
+/* Packing glyph sized rectangles of varying sizes into an atlas
+ * including the reorganizations as it grows */
+static int64_t
+bench_atlas_pack (Data *data)
+{
+  CoglAtlas *atlas;
+  int64_t start;
+  int i;
+
+  start = get_time ();
+
+  atlas = _cogl_atlas_new (COGL_PIXEL_FORMAT_A_8,
+                           COGL_ATLAS_DISABLE_MIGRATION,
+                           atlas_update_position_cb);
+
+  for (i = 0; i < 1000; i++)
+    _cogl_atlas_reserve_space (atlas,
+                               8 + (i * 13) % 24,
+                               10 + (i * 7) % 20,
+                               GINT_TO_POINTER (i + 1));
+
+  cogl_object_unref (atlas);
+
+  return get_time () - start;
+}
+
+#ifdef HAVE_COGL_PANGO
+static PangoLayout *
+create_layout (PangoContext *pango_context)
+{
+  PangoLayout *layout = pango_layout_new (pango_context);
+
+  pango_layout_set_width (layout, (FRAMEBUFFER_WIDTH - 20) * PANGO_SCALE);
+  pango_layout_set_text (layout,
+                         "The quick brown fox jumps over the lazy dog. "
+                         "Pack my box with five dozen liquor jugs. "
+                         "Sphinx of black quartz, judge my vow. "
+                         "0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~",
+                         -1);
+
+  return layout;
+}
+
+static PangoContext *
+get_pango_context (Data *data)
+{
+  static PangoContext *pango_context = NULL;
+
+  if (pango_context == NULL)
+    {
+      PangoFontMap *font_map = cogl_pango_font_map_new (data->ctx);
+      PangoFontDescription *desc = pango_font_description_new ();
+
+      pango_context = pango_font_map_create_context (font_map);
+
+      pango_font_description_set_family (desc, "Sans");
+      pango_font_description_set_size (desc, 12 * PANGO_SCALE);
+      pango_context_set_font_description (pango_context, desc);
+      pango_font_description_free (desc);
+    }
+
+  return pango_context;
+}
+
+/* Building the display list for a new layout. The glyphs are already
+ * in the glyph cache after the first iteration */
+static int64_t
+bench_pango_build (Data *data)
+{
+  PangoLayout *layout = create_layout (get_pango_context (data));
+  CoglColor color;
+  int64_t start, elapsed;
+
+  cogl_color_init_from_4ub (&color, 0, 0, 0, 255);
+
+  start = get_time ();
+
+  cogl_pango_show_layout (data->fb, layout, 10, 10, &color);
+  cogl_framebuffer_finish (data->fb);
+
+  elapsed = get_time () - start;
+
+  g_object_unref (layout);
+
+  return elapsed;
+}
+
+/* Replaying the cached display list of a layout */
+static int64_t
+bench_pango_show (Data *data)
+{
+  static PangoLayout *layout = NULL;
+  CoglColor color;
+  int64_t start;
+  int i;
+
+  if (layout == NULL)
+    layout = create_layout (get_pango_context (data));
+
+  cogl_color_init_from_4ub (&color, 0, 0, 0, 255);
+
+  start = get_time ();
+
+  for (i = 0; i < 10; i++)
+    cogl_pango_show_layout (data->fb, layout, 10, 10 + i * 50, &color);
+  cogl_framebuffer_finish (data->fb);
+
+  return get_time () - start;
+}
+#endif /* HAVE_COGL_PANGO */
+
+static const Bench benchmarks[] =
+  {
+    { "journal-log", bench_journal_log },
+    { "journal-flush", bench_journal_flush },
+    { "journal-transformed", bench_journal_transformed },
+    { "pipeline-copy", bench_pipeline_copy },
+    { "pipeline-compare", bench_pipeline_compare },
+    { "pipeline-set-blend", bench_pipeline_set_blend },
+    { "pipeline-hash", bench_pipeline_hash },
+    { "pipeline-equal", bench_pipeline_equal },
+    { "matrix-stack", bench_matrix_stack },
+    { "clip-stack", bench_clip_stack },
+#ifdef COGL_HAS_COGL_PATH_SUPPORT
+    { "path-tessellate", bench_path_tessellate },
+    { "path-tessellate-svg", bench_path_tessellate_svg },
+    { "path-stencil-svg", bench_path_stencil_svg },
+    { "path-round-rects", bench_path_round_rects },
+    { "path-stroke-wide", bench_path_stroke_wide },
+    { "path-flatten", bench_path_flatten },
+#endif
+    { "bitmap-convert", bench_bitmap_convert },
+    { "atlas-pack", bench_atlas_pack },
+#ifdef HAVE_COGL_PANGO
+    { "pango-build", bench_pango_build },
+    { "pango-show", bench_pango_show },
+#endif
+  };
+
+static int
+compare_samples (const void *a, const void *b)
+{
+  int64_t sample_a = *(const int64_t *) a;
+  int64_t sample_b = *(const int64_t *) b;
+
+  return sample_a < sample_b ? -1 : sample_a > sample_b ? 1 : 0;
+}
+
+static CoglBool
+should_run (const Bench *bench, int argc, char **argv)
+{
+  int i;
+
+  if (argc < 2)
+    return TRUE;
+
+  for (i = 1; i < argc; i++)
+    if (strstr (bench->name, argv[i]))
+      return TRUE;
+
+  return FALSE;
+}
+
+int
+main (int argc, char **argv)
+{
+  Data data;
+  CoglOnscreen *onscreen;
+  CoglError *error = NULL;
+  int64_t samples[N_ITERATIONS];
+  CoglBool first = TRUE;
+  int i, j;
+
+  if (getenv ("COGL_DRIVER") == NULL)
+    setenv ("COGL_DRIVER", "nop", TRUE);
+  if (getenv ("COGL_RENDERER") == NULL)
+    setenv ("COGL_RENDERER", "stub", TRUE);
+
+  data.ctx = cogl_context_new (NULL, &error);
+  if (data.ctx == NULL)
+    {
+      fprintf (stderr, "Failed to create context: %s\n", error->message);
+      return 1;
+    }
+
+  onscreen = cogl_onscreen_new (data.ctx,
+                                FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT);
+  data.fb = onscreen;
+  if (!cogl_framebuffer_allocate (data.fb, &error))
+    {
+      fprintf (stderr, "Failed to allocate framebuffer: %s\n",
+               error->message);
+      return 1;
+    }
+
+  cogl_framebuffer_orthographic (data.fb,
+                                 0, 0,
+                                 FRAMEBUFFER_WIDTH, FRAMEBUFFER_HEIGHT,
+                                 -1, 100);
+
+  data.pipeline = cogl_pipeline_new (data.ctx);
+  cogl_pipeline_set_color4f (data.pipeline, 1, 0, 0, 1);
+
+  printf ("{\n  \"benchmarks\": [");
+
+  for (i = 0; i < (int) G_N_ELEMENTS (benchmarks); i++)
+    {
+      const Bench *bench = benchmarks + i;
+
+      if (!should_run (bench, argc, argv))
+        continue;
+
+      /* Warm up caches before taking any samples */
+      bench->func (&data);
+
+      for (j = 0; j < N_ITERATIONS; j++)
+        samples[j] = bench->func (&data);
+
+      qsort (samples, N_ITERATIONS, sizeof (int64_t), compare_samples);
+
+      printf ("%s\n    { \"name\": \"%s\", \"iterations\": %i, "
+              "\"median_ns\": %" G_GINT64_FORMAT ", "
+              "\"p99_ns\": %" G_GINT64_FORMAT ", "
+              "\"min_ns\": %" G_GINT64_FORMAT " }",
+              first ? "" : ",",
+              bench->name,
+              N_ITERATIONS,
+              (gint64) samples[N_ITERATIONS / 2],
+              (gint64) samples[N_ITERATIONS * 99 / 100],
+              (gint64) samples[0]);
+      fflush (stdout);
+
+      first = FALSE;
+    }
+
+  printf ("\n  ]\n}\n");
+
+  cogl_object_unref (data.pipeline);
+  cogl_object_unref (onscreen);
+  cogl_object_unref (data.ctx);
+
+  return 0;
+}
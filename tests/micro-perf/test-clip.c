@@ -0,0 +1,194 @@
+/*
+ * Compares the cost of clipping to rectangles that can't be described
+ * by the scissor using the stencil buffer and using the fragment
+ * shader. Note that with big GL the first rectangle can be clipped
+ * using clip planes instead of the stencil buffer in which case the
+ * fragment shader isn't used for a single clip either.
+ *
+ * Each frame pushes a set of rotated clip rectangles and draws a grid
+ * of small rectangles through them. The angle of the clip changes
+ * every frame so that the stencil buffer can't just be reused from
+ * the previous frame. The same scene is drawn with the
+ * disable-shader-clip debug option set and cleared and the average
+ * time of a frame is printed for both. The time includes waiting for
+ * the GPU to finish the frame.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <cogl/cogl.h>
+/* The debug flags aren't public API but they are exported for
+ * cogl-pango so we can use them to switch between the two ways of
+ * clipping */
+#define __COGL_H_INSIDE__
+#include "cogl/cogl-debug.h"
+#undef __COGL_H_INSIDE__
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#define FRAMEBUFFER_WIDTH 800
+#define FRAMEBUFFER_HEIGHT 600
+
+#define RECT_SIZE 10
+#define N_FRAMES 100
+
+typedef struct _Data
+{
+  CoglContext *ctx;
+  CoglFramebuffer *fb;
+  CoglPipeline *pipelines[3];
+} Data;
+
+static int64_t
+get_time (void)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  return ts.tv_sec * (int64_t) 1000000000 + ts.tv_nsec;
+}
+
+static void
+push_clips (Data *data, int n_clips, int frame)
+{
+  int i;
+
+  for (i = 0; i < n_clips; i++)
+    {
+      cogl_framebuffer_push_matrix (data->fb);
+      cogl_framebuffer_translate (data->fb,
+                                  FRAMEBUFFER_WIDTH / 2 + i * 40,
+                                  FRAMEBUFFER_HEIGHT / 2,
+                                  0);
+      cogl_framebuffer_rotate (data->fb, frame + i * 30, 0, 0, 1);
+      cogl_framebuffer_push_rectangle_clip (data->fb,
+                                            -FRAMEBUFFER_HEIGHT / 3,
+                                            -FRAMEBUFFER_HEIGHT / 3,
+                                            FRAMEBUFFER_HEIGHT / 3,
+                                            FRAMEBUFFER_HEIGHT / 3);
+      cogl_framebuffer_pop_matrix (data->fb);
+    }
+}
+
+static void
+paint (Data *data, int n_clips, int frame)
+{
+  int x, y;
+
+  cogl_framebuffer_clear4f (data->fb,
+                            COGL_BUFFER_BIT_COLOR | COGL_BUFFER_BIT_STENCIL,
+                            0, 0, 0, 1);
+
+  push_clips (data, n_clips, frame);
+
+  for (y = 0; y < FRAMEBUFFER_HEIGHT; y += RECT_SIZE)
+    for (x = 0; x < FRAMEBUFFER_WIDTH; x += RECT_SIZE)
+      {
+        CoglPipeline *pipeline =
+          data->pipelines[(x / RECT_SIZE + y / RECT_SIZE) %
+                          G_N_ELEMENTS (data->pipelines)];
+
+        cogl_framebuffer_draw_rectangle (data->fb,
+                                         pipeline,
+                                         x, y,
+                                         x + RECT_SIZE, y + RECT_SIZE);
+      }
+
+  for (x = 0; x < n_clips; x++)
+    cogl_framebuffer_pop_clip (data->fb);
+
+  cogl_framebuffer_finish (data->fb);
+}
+
+static double
+run (Data *data, int n_clips)
+{
+  int64_t start;
+  int frame;
+
+  /* Draw one frame first so that any programs are already compiled */
+  paint (data, n_clips, 0);
+
+  start = get_time ();
+
+  for (frame = 1; frame <= N_FRAMES; frame++)
+    paint (data, n_clips, frame);
+
+  return (get_time () - start) / (double) N_FRAMES / 1e6;
+}
+
+int
+main (int argc, char **argv)
+{
+  Data data;
+  CoglTexture *texture;
+  CoglError *error = NULL;
+  int n_clips;
+  int i;
+
+  data.ctx = cogl_context_new (NULL, &error);
+  if (data.ctx == NULL)
+    {
+      fprintf (stderr, "Failed to create context: %s\n", error->message);
+      return 1;
+    }
+
+  texture = cogl_texture_2d_new_with_size (data.ctx,
+                                           FRAMEBUFFER_WIDTH,
+                                           FRAMEBUFFER_HEIGHT);
+  data.fb = cogl_offscreen_new_with_texture (texture);
+  cogl_object_unref (texture);
+
+  if (!cogl_framebuffer_allocate (data.fb, &error))
+    {
+      fprintf (stderr, "Failed to allocate framebuffer: %s\n",
+               error->message);
+      return 1;
+    }
+
+  cogl_framebuffer_orthographic (data.fb,
+                                 0, 0,
+                                 FRAMEBUFFER_WIDTH,
+                                 FRAMEBUFFER_HEIGHT,
+                                 -1,
+                                 100);
+
+  for (i = 0; i < G_N_ELEMENTS (data.pipelines); i++)
+    {
+      data.pipelines[i] = cogl_pipeline_new (data.ctx);
+      cogl_pipeline_set_color4ub (data.pipelines[i],
+                                  i == 0 ? 255 : 0,
+                                  i == 1 ? 255 : 0,
+                                  i == 2 ? 255 : 0,
+                                  255);
+    }
+
+  for (n_clips = 1; n_clips <= 3; n_clips++)
+    {
+      double stencil_time, shader_time;
+
+      COGL_DEBUG_SET_FLAG (COGL_DEBUG_DISABLE_SHADER_CLIP);
+      stencil_time = run (&data, n_clips);
+
+      COGL_DEBUG_CLEAR_FLAG (COGL_DEBUG_DISABLE_SHADER_CLIP);
+      shader_time = run (&data, n_clips);
+
+      printf ("%i rotated clip%s: stencil = %.3f ms, shader = %.3f ms\n",
+              n_clips,
+              n_clips == 1 ? "" : "s",
+              stencil_time,
+              shader_time);
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (data.pipelines); i++)
+    cogl_object_unref (data.pipelines[i]);
+  cogl_object_unref (data.fb);
+  cogl_object_unref (data.ctx);
+
+  return 0;
+}
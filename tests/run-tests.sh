@@ -94,6 +94,9 @@ if test $HAVE_GLES2 -eq 1; then
   GLES2_FORMAT=" %6s %7s"
   printf "$GLES2_FORMAT" "ES2" "ES2-NPT"
 fi
+# The software driver is always built so it doesn't need a config check
+SW_FORMAT=" %6s"
+printf "$SW_FORMAT" "SW"
 
 echo ""
 echo ""
@@ -137,6 +140,12 @@ do
     run_test $test gles2_npot
   fi
 
+  export COGL_DRIVER=sw
+  export COGL_RENDERER=stub
+  export COGL_DEBUG=
+  run_test $test sw
+  unset COGL_RENDERER
+
   printf $TITLE_FORMAT "$test:"
   if test $HAVE_GL -eq 1; then
     printf "$GL_FORMAT" \
@@ -151,6 +160,7 @@ do
       "`get_status $gles2_result`" \
       "`get_status $gles2_npot_result`"
   fi
+  printf "$SW_FORMAT" "`get_status $sw_result`"
   echo ""
 done
 